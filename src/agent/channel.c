@@ -323,7 +323,8 @@ channel_read(struct channel *channel) {
   }
 
   /* get channelq */
-  rc = ofp_handler_get_channelq(&channelq);
+  rc = ofp_handler_get_channelq_by_dpid(channel_dpid_get_nolock(channel),
+                                        &channelq);
   if (rc != LAGOPUS_RESULT_OK) {
     goto done;
   }
@@ -67,6 +67,7 @@ void
 action_free(struct action *action) {
   if (action != NULL) {
     ed_prop_list_free(&action->ed_prop_list);
+    free(action->encap_template);
   }
   free(action);
 }
@@ -24,6 +24,8 @@ static pthread_once_t initialized = PTHREAD_ONCE_INIT;
 static lagopus_hashmap_t bridgeq_table = NULL;
 static struct ofp_bridgeq *bridgeqs[MAX_BRIDGES];
 static uint64_t n_bridgeqs = 0;
+/* bumped whenever bridgeqs is changed. */
+static uint64_t generation = 0;
 static lagopus_mutex_t lock = NULL;
 
 /* bridge queue entry. */
@@ -81,6 +83,7 @@ static inline void
 bridgeqs_clear(void) {
   memset(bridgeqs, 0, sizeof(bridgeqs));
   n_bridgeqs = 0;
+  generation++;
 }
 
 static void
@@ -462,6 +465,17 @@ ofp_bridgeq_mgr_bridge_lookup(uint64_t dpid,
   return ret;
 }
 
+uint64_t
+ofp_bridgeq_mgr_generation_get(void) {
+  uint64_t ret;
+
+  bridgeq_mgr_lock();
+  ret = generation;
+  bridgeq_mgr_unlock();
+
+  return ret;
+}
+
 lagopus_result_t
 ofp_bridgeq_mgr_bridgeqs_to_array(struct ofp_bridgeq *brqs[],
                                   uint64_t *count,
@@ -27,172 +27,256 @@
 #include "ofp_instruction.h"
 #include "ofp_tlv.h"
 
-static void
-s_ofp_flow_stats_list_elem_free(struct flow_stats_list *flow_stats_list) {
-  struct flow_stats *flow_stats;
-
-  while ((flow_stats = TAILQ_FIRST(flow_stats_list)) != NULL) {
-    TAILQ_REMOVE(flow_stats_list, flow_stats, entry);
-    ofp_match_list_elem_free(&flow_stats->match_list);
-    ofp_instruction_list_elem_free(&flow_stats->instruction_list);
-    free(flow_stats);
-  }
-}
-
+/* encode one flow_stats into entry_pbuf and append it to pbuf_list. */
 static lagopus_result_t
-s_flow_stats_list_encode(struct pbuf_list *pbuf_list,
-                         struct pbuf **pbuf,
-                         struct flow_stats_list *flow_stats_list) {
+s_flow_stats_encode(struct pbuf_list *pbuf_list,
+                    struct pbuf **pbuf,
+                    struct pbuf *entry_pbuf,
+                    struct ofp_flow_stats *ofp,
+                    struct match_list *match_list,
+                    struct instruction_list *instruction_list) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   uint16_t match_total_len = 0;
   uint16_t instruction_total_len = 0;
   uint16_t flow_stats_len;
   uint8_t *flow_stats_head = NULL;
-  struct flow_stats *flow_stats = NULL;
-  struct pbuf *entry_pbuf = NULL;
 
-  if (TAILQ_EMPTY(flow_stats_list) == false) {
-    /* encode flow_stats list */
-    TAILQ_FOREACH(flow_stats, flow_stats_list, entry) {
-      entry_pbuf = pbuf_alloc(OFP_PACKET_MAX_SIZE);
-      if (entry_pbuf == NULL) {
-        res = LAGOPUS_RESULT_NO_MEMORY;
-        goto done;
-      }
-      entry_pbuf->plen = OFP_PACKET_MAX_SIZE;
+  pbuf_reset(entry_pbuf);
+  entry_pbuf->plen = OFP_PACKET_MAX_SIZE;
 
-      /* encode flow_stats */
-      res = ofp_flow_stats_encode(entry_pbuf, &(flow_stats->ofp));
-      if (res == LAGOPUS_RESULT_OK) {
+  /* encode flow_stats */
+  res = ofp_flow_stats_encode(entry_pbuf, ofp);
+  if (res == LAGOPUS_RESULT_OK) {
 
-        /* flow_stats head pointer. */
-        flow_stats_head = pbuf_putp_get(entry_pbuf) - sizeof(struct ofp_flow_stats);
+    /* flow_stats head pointer. */
+    flow_stats_head = pbuf_putp_get(entry_pbuf) - sizeof(struct ofp_flow_stats);
 
-        /* encode match */
-        res = ofp_match_list_encode(entry_pbuf, &(flow_stats->match_list),
-                                    &match_total_len);
+    /* encode match */
+    res = ofp_match_list_encode(entry_pbuf, match_list, &match_total_len);
+    if (res == LAGOPUS_RESULT_OK) {
+      /* encode instruction */
+      res = ofp_instruction_list_encode(entry_pbuf, instruction_list,
+                                        &instruction_total_len);
+      if (res == LAGOPUS_RESULT_OK) {
+        /* Set flow_stats length (match total length +       */
+        /*                        instruction total length + */
+        /*                        size of ofp_flow_stats).   */
+        /* And check overflow.                               */
+        flow_stats_len = match_total_len;
+        res = ofp_tlv_length_sum(&flow_stats_len, instruction_total_len);
         if (res == LAGOPUS_RESULT_OK) {
-          /* encode instruction */
-          res = ofp_instruction_list_encode(entry_pbuf,
-                                            &(flow_stats->instruction_list),
-                                            &instruction_total_len);
+          res = ofp_tlv_length_sum(&flow_stats_len,
+                                   sizeof(struct ofp_flow_stats));
           if (res == LAGOPUS_RESULT_OK) {
-            /* Set flow_stats length (match total length +       */
-            /*                        instruction total length + */
-            /*                        size of ofp_flow_stats).   */
-            /* And check overflow.                               */
-            flow_stats_len = match_total_len;
-            res = ofp_tlv_length_sum(&flow_stats_len, instruction_total_len);
+            res = ofp_multipart_length_set(flow_stats_head,
+                                           flow_stats_len);
             if (res == LAGOPUS_RESULT_OK) {
-              res = ofp_tlv_length_sum(&flow_stats_len,
-                                       sizeof(struct ofp_flow_stats));
-              if (res == LAGOPUS_RESULT_OK) {
-                res = ofp_multipart_length_set(flow_stats_head,
-                                               flow_stats_len);
-                if (res == LAGOPUS_RESULT_OK) {
-                  res = ofp_multipart_append(pbuf_list, entry_pbuf, pbuf);
-                  if (res != LAGOPUS_RESULT_OK) {
-                    lagopus_msg_warning("FAILED (%s).\n",
-                                        lagopus_error_get_string(res));
-                  }
-                } else {
-                  lagopus_msg_warning("FAILED (%s).\n",
-                                      lagopus_error_get_string(res));
-                }
-              } else {
-                lagopus_msg_warning("over flow_stats length.\n");
+              res = ofp_multipart_append(pbuf_list, entry_pbuf, pbuf);
+              if (res != LAGOPUS_RESULT_OK) {
+                lagopus_msg_warning("FAILED (%s).\n",
+                                    lagopus_error_get_string(res));
               }
             } else {
-              lagopus_msg_warning("over flow_stats length.\n");
+              lagopus_msg_warning("FAILED (%s).\n",
+                                  lagopus_error_get_string(res));
             }
           } else {
-            lagopus_msg_warning("FAILED : ofp_instruction_list_encode (%s).\n",
-                                lagopus_error_get_string(res));
+            lagopus_msg_warning("over flow_stats length.\n");
           }
         } else {
-          lagopus_msg_warning("FAILED : ofp_match_list_encode (%s).\n",
-                              lagopus_error_get_string(res));
+          lagopus_msg_warning("over flow_stats length.\n");
         }
       } else {
-        lagopus_msg_warning("FAILED : ofp_flow_stats_encode (%s).\n",
+        lagopus_msg_warning("FAILED : ofp_instruction_list_encode (%s).\n",
                             lagopus_error_get_string(res));
       }
+    } else {
+      lagopus_msg_warning("FAILED : ofp_match_list_encode (%s).\n",
+                          lagopus_error_get_string(res));
+    }
+  } else {
+    lagopus_msg_warning("FAILED : ofp_flow_stats_encode (%s).\n",
+                        lagopus_error_get_string(res));
+  }
+
+  return res;
+}
+
+/* state of encoding flows straight from the flowdb. */
+struct flow_stats_encode_arg {
+  struct pbuf_list *pbuf_list;
+  struct pbuf *pbuf;
+  struct pbuf *entry_pbuf;
+};
+
+static lagopus_result_t
+s_flow_stats_encode_proc(struct ofp_flow_stats *ofp,
+                         struct match_list *match_list,
+                         struct instruction_list *instruction_list,
+                         void *arg) {
+  struct flow_stats_encode_arg *encode_arg = arg;
+
+  return s_flow_stats_encode(encode_arg->pbuf_list, &encode_arg->pbuf,
+                             encode_arg->entry_pbuf, ofp,
+                             match_list, instruction_list);
+}
+
+/* encode header of flow_stats reply. */
+static lagopus_result_t
+s_flow_stats_reply_header_encode(struct channel *channel,
+                                 struct pbuf_list **pbuf_list,
+                                 struct pbuf **pbuf,
+                                 struct ofp_header *xid_header) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  struct ofp_multipart_reply reply;
+
+  /* alloc */
+  *pbuf_list = pbuf_list_alloc();
+  if (*pbuf_list != NULL) {
+    *pbuf = pbuf_list_last_get(*pbuf_list);
+    if (*pbuf != NULL) {
+      /* set data. */
+      memset(&reply, 0, sizeof(reply));
+      ofp_header_set(&reply.header,
+                     channel_version_get(channel),
+                     OFPT_MULTIPART_REPLY,
+                     0, /* length set in ofp_header_length_set()  */
+                     xid_header->xid);
+      reply.type = OFPMP_FLOW;
 
-      pbuf_free(entry_pbuf);
-      entry_pbuf = NULL;
+      /* encode header, multipart reply */
+      pbuf_plen_set(*pbuf, pbuf_size_get(*pbuf));
+      res = ofp_multipart_reply_encode(*pbuf, &reply);
       if (res != LAGOPUS_RESULT_OK) {
-        break;
+        lagopus_msg_warning("FAILED : ofp_multipart_reply_encode (%s).\n",
+                            lagopus_error_get_string(res));
       }
+    } else {
+      /* pbuf_list_last_get returns NULL */
+      res = LAGOPUS_RESULT_NO_MEMORY;
     }
   } else {
-    /* flow_stats_list is empty. */
-    res = LAGOPUS_RESULT_OK;
+    /* pbuf_list_alloc returns NULL */
+    res = LAGOPUS_RESULT_NO_MEMORY;
   }
 
-done:
   return res;
 }
 
-/* createflow_stats reply. */
-STATIC lagopus_result_t
-ofp_flow_stats_reply_create(struct channel *channel,
-                            struct pbuf_list **pbuf_list,
-                            struct flow_stats_list *flow_stats_list,
-                            struct ofp_header *xid_header) {
+/* set length of the last flow_stats reply. */
+static lagopus_result_t
+s_flow_stats_reply_length_set(struct pbuf *pbuf) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   uint16_t length = 0;
-  struct pbuf *pbuf = NULL;
-  struct ofp_multipart_reply reply;
 
-  /* check params */
-  if (channel != NULL && pbuf_list != NULL &&
-      flow_stats_list != NULL && xid_header != NULL) {
-    /* alloc */
-    *pbuf_list = pbuf_list_alloc();
-    if (*pbuf_list != NULL) {
-      pbuf = pbuf_list_last_get(*pbuf_list);
-      if (pbuf != NULL) {
-        /* set data. */
-        memset(&reply, 0, sizeof(reply));
-        ofp_header_set(&reply.header,
-                       channel_version_get(channel),
-                       OFPT_MULTIPART_REPLY,
-                       0, /* length set in ofp_header_length_set()  */
-                       xid_header->xid);
-        reply.type = OFPMP_FLOW;
+  res = pbuf_length_get(pbuf, &length);
+  if (res == LAGOPUS_RESULT_OK) {
+    res = ofp_header_length_set(pbuf, length);
+    if (res == LAGOPUS_RESULT_OK) {
+      pbuf_plen_reset(pbuf);
+    } else {
+      lagopus_msg_warning("FAILED : ofp_header_length_set (%s).\n",
+                          lagopus_error_get_string(res));
+    }
+  } else {
+    lagopus_msg_warning("FAILED (%s).\n",
+                        lagopus_error_get_string(res));
+  }
 
-        /* encode header, multipart reply */
-        pbuf_plen_set(pbuf, pbuf_size_get(pbuf));
-        res = ofp_multipart_reply_encode(pbuf, &reply);
-        if (res == LAGOPUS_RESULT_OK) {
-          res = s_flow_stats_list_encode(*pbuf_list, &pbuf, flow_stats_list);
-          if (res == LAGOPUS_RESULT_OK) {
-            /* set packet length */
-            res = pbuf_length_get(pbuf, &length);
-            if (res == LAGOPUS_RESULT_OK) {
-              res = ofp_header_length_set(pbuf, length);
-              if (res == LAGOPUS_RESULT_OK) {
-                pbuf_plen_reset(pbuf);
-              } else {
-                lagopus_msg_warning("FAILED : ofp_header_length_set (%s).\n",
-                                    lagopus_error_get_string(res));
-              }
-            } else {
-              lagopus_msg_warning("FAILED (%s).\n",
-                                  lagopus_error_get_string(res));
-            }
+  return res;
+}
+
+/* send the replies encoded so far with OFPMPF_REPLY_MORE, */
+/* and continue in a new list.                             */
+static lagopus_result_t
+s_flow_stats_reply_flush(struct channel *channel,
+                         struct flow_stats_encode_arg *arg) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  struct pbuf_list *next_list;
+  struct pbuf *next_pbuf;
+  uint16_t length = 0;
+
+  /* nothing matched in this chunk. */
+  if (TAILQ_FIRST(&arg->pbuf_list->tailq) == arg->pbuf &&
+      pbuf_length_get(arg->pbuf, &length) == LAGOPUS_RESULT_OK &&
+      length <= sizeof(struct ofp_multipart_reply)) {
+    return LAGOPUS_RESULT_OK;
+  }
+
+  next_list = pbuf_list_alloc();
+  if (next_list == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  next_pbuf = pbuf_list_last_get(next_list);
+  if (next_pbuf == NULL) {
+    pbuf_list_free(next_list);
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  next_pbuf->plen = OFP_PACKET_MAX_SIZE;
+
+  /* set length and OFPMPF_REPLY_MORE of the last reply. */
+  res = ofp_header_mp_copy(next_pbuf, arg->pbuf);
+  if (res == LAGOPUS_RESULT_OK) {
+    res = channel_send_packet_list(channel, arg->pbuf_list);
+  }
+  if (res == LAGOPUS_RESULT_OK) {
+    pbuf_list_free(arg->pbuf_list);
+    arg->pbuf_list = next_list;
+    arg->pbuf = next_pbuf;
+  } else {
+    pbuf_list_free(next_list);
+  }
+
+  return res;
+}
+
+/* create flow_stats reply, walking the flowdb chunk by chunk. */
+/* replies of each chunk are sent before walking the next one, */
+/* the replies of the last chunk are left in pbuf_list.         */
+STATIC lagopus_result_t
+ofp_flow_stats_reply_create_by_cursor(struct channel *channel,
+                                      struct pbuf_list **pbuf_list,
+                                      struct ofp_flow_stats_request *request,
+                                      struct match_list *match_list,
+                                      struct ofp_header *xid_header,
+                                      struct ofp_error *error) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  struct flowdb_flow_stats_cursor cursor;
+  struct flow_stats_encode_arg arg;
+
+  /* check params */
+  if (channel != NULL && pbuf_list != NULL && request != NULL &&
+      match_list != NULL && xid_header != NULL && error != NULL) {
+    memset(&arg, 0, sizeof(arg));
+    res = s_flow_stats_reply_header_encode(channel, pbuf_list,
+                                           &arg.pbuf, xid_header);
+    if (res == LAGOPUS_RESULT_OK) {
+      arg.pbuf_list = *pbuf_list;
+      arg.entry_pbuf = pbuf_alloc(OFP_PACKET_MAX_SIZE);
+      if (arg.entry_pbuf != NULL) {
+        /* each call holds the flowdb lock for one chunk only. */
+        memset(&cursor, 0, sizeof(cursor));
+        while (res == LAGOPUS_RESULT_OK && cursor.done == false) {
+          res = ofp_flow_stats_iterate(channel_dpid_get(channel),
+                                       request, match_list, &cursor,
+                                       s_flow_stats_encode_proc, &arg,
+                                       error);
+          if (res == LAGOPUS_RESULT_OK && cursor.done == false) {
+            res = s_flow_stats_reply_flush(channel, &arg);
           }
+        }
+        *pbuf_list = arg.pbuf_list;
+        pbuf_free(arg.entry_pbuf);
+        if (res == LAGOPUS_RESULT_OK) {
+          /* set packet length */
+          res = s_flow_stats_reply_length_set(arg.pbuf);
         } else {
-          lagopus_msg_warning("FAILED : ofp_multipart_reply_encode (%s).\n",
+          lagopus_msg_warning("flow_stats decode error (%s)\n",
                               lagopus_error_get_string(res));
         }
       } else {
-        /* pbuf_list_last_get returns NULL */
         res = LAGOPUS_RESULT_NO_MEMORY;
       }
-    } else {
-      /* pbuf_list_alloc returns NULL */
-      res = LAGOPUS_RESULT_NO_MEMORY;
     }
   } else {
     /* params are NULL */
@@ -210,7 +294,6 @@ ofp_flow_stats_request_handle(struct channel *channel, struct pbuf *pbuf,
   struct pbuf_list *send_pbuf_list = NULL;
   struct ofp_flow_stats_request request;
   struct match_list match_list;
-  struct flow_stats_list flow_stats_list;
 
   /* check params */
   if (channel != NULL && pbuf != NULL &&
@@ -220,24 +303,17 @@ ofp_flow_stats_request_handle(struct channel *channel, struct pbuf *pbuf,
     if (res == LAGOPUS_RESULT_OK) {
       /* init. */
       TAILQ_INIT(&match_list);
-      TAILQ_INIT(&flow_stats_list);
 
       /* decode */
       if ((res = ofp_match_parse(channel, pbuf, &match_list, error))
           != LAGOPUS_RESULT_OK) {
         lagopus_msg_warning("match decode error (%s)\n",
                             lagopus_error_get_string(res));
-      } else if ((res = ofp_flow_stats_get(
-                          channel_dpid_get(channel),
-                          &request, &match_list, &flow_stats_list, error))
-                 != LAGOPUS_RESULT_OK) {
-        lagopus_msg_warning("flow_stats decode error (%s)\n",
-                            lagopus_error_get_string(res));
       } else {                  /* decode success */
         /* create flow_stats_reply. */
-        res = ofp_flow_stats_reply_create(channel, &send_pbuf_list,
-                                          &flow_stats_list,
-                                          xid_header);
+        res = ofp_flow_stats_reply_create_by_cursor(channel, &send_pbuf_list,
+                                                    &request, &match_list,
+                                                    xid_header, error);
         if (res == LAGOPUS_RESULT_OK) {
           /* send flow_stats reply */
           res = channel_send_packet_list(channel, send_pbuf_list);
@@ -253,7 +329,6 @@ ofp_flow_stats_request_handle(struct channel *channel, struct pbuf *pbuf,
       }
 
       ofp_match_list_elem_free(&match_list);
-      s_ofp_flow_stats_list_elem_free(&flow_stats_list);
     } else {
       lagopus_msg_warning("flow_stats_request decode error (%s)\n",
                           lagopus_error_get_string(res));
@@ -45,21 +45,27 @@ ofp_flow_stats_request_handle(struct channel *channel, struct pbuf *pbuf,
 
 #ifdef __UNIT_TESTING__
 /**
- * Create ofp_flow_stats_reply.
+ * Create ofp_flow_stats_reply by walking the flow database in chunks.
+ * The replies of each chunk but the last are sent to the channel
+ * with OFPMPF_REPLY_MORE, the rest are returned in \e pbuf_list.
  *
  *     @param[in]	channel	A pointer to \e channel structure.
  *     @param[out]	pbuf_list	A pointer to list of \e pbuf structures.
- *     @param[in]	flow_stats_list	A pointer to ist of \e flow_stats structures.
+ *     @param[in]	request	A pointer to \e ofp_flow_stats_request structure.
+ *     @param[in]	match_list	A pointer to list of match.
  *     @param[in]	xid_header	A pointer to \e ofp_header structure.
+ *     @param[out]	error	A pointer to \e ofp_error structure.
  *
  *     @retval	LAGOPUS_RESULT_OK	Succeeded.
  *     @retval	LAGOPUS_RESULT_ANY_FAILURES Failed.
  */
 lagopus_result_t
-ofp_flow_stats_reply_create(struct channel *channel,
-                            struct pbuf_list **pbuf_list,
-                            struct flow_stats_list *flow_stats_list,
-                            struct ofp_header *xid_header);
+ofp_flow_stats_reply_create_by_cursor(struct channel *channel,
+                                      struct pbuf_list **pbuf_list,
+                                      struct ofp_flow_stats_request *request,
+                                      struct match_list *match_list,
+                                      struct ofp_header *xid_header,
+                                      struct ofp_error *error);
 #endif /* __UNIT_TESTING__ */
 
 #endif /* __OFP_FLOW_HANDLER_H__ */
@@ -22,6 +22,7 @@
 #define __OFP_FLOW_MOD_HANDLER_H__
 
 #include "channel.h"
+#include "lagopus/flowdb.h"
 
 /**
  * ofp_flow_mod handler.
@@ -41,4 +42,26 @@ ofp_flow_mod_handle(struct channel *channel, struct pbuf *pbuf,
                     struct ofp_header *xid_header,
                     struct ofp_error *error);
 
+/**
+ * ofp_flow_mod handler, queue flow mod to the batch instead of
+ * applying it.
+ *
+ *     @param[in]	channel	A pointer to \e channel structure.
+ *     @param[in]	pbuf	A pointer to \e pbuf structure.
+ *     @param[in]	xid_header	A pointer to \e ofp_header structure in request.
+ *     @param[in]	batch	A pointer to batch of flow mods.
+ *     @param[out]	error	A pointer to \e ofp_error structure.
+ *     It is set when decoding fails, or later when the batch
+ *     is committed.
+ *
+ *     @retval	LAGOPUS_RESULT_OK	Succeeded.
+ *     @retval	LAGOPUS_RESULT_OFP_ERROR Failed, ofp_error.
+ *     @retval	LAGOPUS_RESULT_ANY_FAILURES Failed.
+ */
+lagopus_result_t
+ofp_flow_mod_batch_handle(struct channel *channel, struct pbuf *pbuf,
+                          struct ofp_header *xid_header,
+                          struct flowdb_batch *batch,
+                          struct ofp_error *error);
+
 #endif /* __OFP_FLOW_MOD_HANDLER_H__ */
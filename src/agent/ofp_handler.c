@@ -37,6 +37,14 @@
 
 #define CHANNELQ_SIZE 1000LL
 
+/* number of default polls (channelq). */
+#define DEFAULT_POLLS 1LL
+
+/* max OFPT_FLOW_MODs applied with a single lock of the flowdb. */
+#ifndef OFPH_FLOW_MOD_MAX_BATCHES
+#define OFPH_FLOW_MOD_MAX_BATCHES 64
+#endif /* OFPH_FLOW_MOD_MAX_BATCHES */
+
 #ifdef MUXER_MAX_SIZE
 #define MUXER_FAIRNESS(q_size)                                  \
   q_size = (q_size <= MUXER_MAX_SIZE) ? q_size : MUXER_MAX_SIZE
@@ -61,8 +69,13 @@ struct ofp_handler_record {
   lagopus_qmuxer_poll_t *m_polls; /* poll objects */
   volatile uint64_t m_n_polls;                  /* num of polls */
 
+  size_t m_index;                 /* index of s_workers */
+  uint64_t m_generation;          /* generation of m_bridgeqs */
+  struct ofp_bridgeq *m_bridgeqs[MAX_BRIDGES]; /* bridges of the thread */
+  uint64_t m_n_bridgeqs;          /* num of bridgeqs */
+
   enum ofp_handler_running_status  m_status;
-  lagopus_mutex_t m_status_lock;   /* lock of m_status */
+  lagopus_mutex_t m_status_lock;   /* lock of m_status (and processing) */
 };
 typedef struct ofp_handler_record *ofp_handler_t;
 
@@ -70,11 +83,15 @@ typedef struct ofp_handler_record *ofp_handler_t;
  * values
  */
 static ofp_handler_t s_ofp_handler = NULL;
+/* s_workers[0] is s_ofp_handler. */
+static ofp_handler_t s_workers[OFPH_MAX_WORKERS];
+static volatile uint16_t s_n_running_workers = 1;
 static pthread_once_t s_initialized = PTHREAD_ONCE_INIT;
 static volatile bool s_is_started = false;
 static volatile bool s_is_running = false;
 static volatile uint16_t channelq_size = CHANNELQ_SIZE;
 static volatile uint16_t channelq_max_batches = CHANNELQ_SIZE;
+static volatile uint16_t n_workers = OFPH_DEFAULT_WORKERS;
 
 /*
  * prototype
@@ -112,23 +129,34 @@ s_initialize_once(void);
 static inline lagopus_result_t
 s_recreate(void);
 static inline void
+s_channelq_destroy(ofp_handler_t thd);
+static inline void
 s_destroy_for_recreate(void);
 /* channel_free() wrapper for bbq */
 static void
 s_channel_freeup_proc(void **val);
+/* bridges of each threads */
+static inline size_t
+s_worker_index(uint64_t dpid);
+static inline lagopus_result_t
+s_bridgeqs_assign(ofp_handler_t thd);
+static inline void
+s_bridgeqs_release(ofp_handler_t thd);
 /* dequeue(or enqueue) each queues */
 static inline lagopus_result_t
-s_channelq_dequeue(channelq_t *q_ptr,
-                   lagopus_qmuxer_poll_t qpoll);
+s_channelq_dequeue(ofp_handler_t thd);
 static inline lagopus_result_t
-s_eventq_dequeue(struct ofp_bridge *ofp_bridge,
+s_eventq_dequeue(ofp_handler_t thd,
+                 struct ofp_bridge *ofp_bridge,
                  lagopus_qmuxer_poll_t qpoll);
 static inline lagopus_result_t
-s_dataq_dequeue(struct ofp_bridge *ofp_bridge,
+s_dataq_dequeue(ofp_handler_t thd,
+                struct ofp_bridge *ofp_bridge,
                 lagopus_qmuxer_poll_t qpoll);
 #ifdef OFPH_POLL_WRITING
 static inline lagopus_result_t
-s_event_dataq_enqueue(struct ofp_bridge *ofp_bridge,
+s_event_dataq_enqueue(ofp_handler_t thd,
+                      struct ofp_bridge *ofp_bridge,
                       lagopus_qmuxer_poll_t *poll_ptr);
 #endif  /* OFPH_POLL_WRITING */
 /* management m_shutdowned */
@@ -161,15 +189,21 @@ ofp_handler_initialize(void *arg,
 lagopus_result_t
 ofp_handler_start(void) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  uint16_t i;
   lagopus_msg_info("called.\n");
   if (s_validate_ofp_handler() == true) {
     if (s_get_status() != OFPH_RUNNING) {
       mbar();
       s_is_running = true;
+      s_n_running_workers = n_workers;
       s_set_status(OFPH_RUNNING);
       res = s_recreate();
       if (res == LAGOPUS_RESULT_OK) {
         res = lagopus_thread_start((lagopus_thread_t *)&s_ofp_handler, false);
+        for (i = 1; i < s_n_running_workers && res == LAGOPUS_RESULT_OK;
+             i++) {
+          res = lagopus_thread_start((lagopus_thread_t *)&s_workers[i], false);
+        }
         if (res != LAGOPUS_RESULT_OK) {
           lagopus_perror(res);
         }
@@ -229,9 +263,14 @@ ofp_handler_shutdown(shutdown_grace_level_t level) {
 lagopus_result_t
 ofp_handler_stop(void) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  uint16_t i;
   lagopus_msg_info("called.\n");
   if (s_validate_ofp_handler() == true
       && s_ofp_handler_is_canceled() == false) {
+    /* the others first, s_ofp_handler destroys their queues. */
+    for (i = 1; i < s_n_running_workers; i++) {
+      (void) lagopus_thread_cancel((lagopus_thread_t *)&s_workers[i]);
+    }
     res = lagopus_thread_cancel((lagopus_thread_t *)&s_ofp_handler);
   }
   return res;
@@ -239,9 +278,14 @@ ofp_handler_stop(void) {
 
 void
 ofp_handler_finalize(void) {
+  size_t i;
   lagopus_msg_info("called.\n");
   if (s_validate_ofp_handler() == true) {
+    for (i = 1; i < OFPH_MAX_WORKERS; i++) {
+      lagopus_thread_destroy((lagopus_thread_t *)&s_workers[i]);
+    }
     lagopus_thread_destroy((lagopus_thread_t *)&s_ofp_handler);
+    s_workers[0] = NULL;
   }
 }
 
@@ -276,6 +320,37 @@ ofp_handler_get_channelq(lagopus_bbq_t **retptr) {
   return res;
 }
 
+lagopus_result_t
+ofp_handler_get_channelq_by_dpid(uint64_t dpid,
+                                 lagopus_bbq_t **retptr) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  bool is_valid = false;
+
+  if (retptr != NULL) {
+    if (s_ofp_handler != NULL) {
+      res = lagopus_thread_is_valid((const lagopus_thread_t *)&s_ofp_handler,
+                                    &is_valid);
+      if (res == LAGOPUS_RESULT_OK) {
+        if (is_valid == true) {
+          *retptr = &(s_workers[s_worker_index(dpid)]->m_channelq);
+          res = LAGOPUS_RESULT_OK;
+        } else {
+          lagopus_msg_error("ofp-handler thread is invalid.\n");
+          res = LAGOPUS_RESULT_INVALID_OBJECT;
+        }
+      } else {
+        lagopus_perror(res);
+      }
+    } else {
+      lagopus_msg_error("ofp-handler thread is NULL.\n");
+      res = LAGOPUS_RESULT_INVALID_OBJECT;
+    }
+  } else {
+    res = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return res;
+}
+
 lagopus_result_t
 ofp_handler_dataq_data_put(uint64_t dpid,
                            struct eventq_data **data,
@@ -378,6 +453,23 @@ ofp_handler_channelq_max_batches_set(uint16_t val) {
   lagopus_msg_info("set channelq_max_batches: %"PRIu16".\n", val);
 }
 
+void
+ofp_handler_workers_set(uint16_t val) {
+  if (val == 0) {
+    val = 1;
+  } else if (val > OFPH_MAX_WORKERS) {
+    val = OFPH_MAX_WORKERS;
+  }
+  mbar();
+  n_workers = val;
+  lagopus_msg_info("set workers: %"PRIu16".\n", val);
+}
+
+uint16_t
+ofp_handler_workers_get(void) {
+  return n_workers;
+}
+
 uint16_t
 ofp_handler_channelq_size_get(void) {
   return channelq_size;
@@ -399,9 +491,18 @@ ofp_handler_channelq_stats_get(uint16_t *val) {
                                     &is_valid);
       if (res == LAGOPUS_RESULT_OK) {
         if (is_valid == true) {
-          res = lagopus_bbq_size(&(s_ofp_handler->m_channelq));
+          lagopus_result_t size = 0;
+          uint16_t i;
+
+          for (i = 0; i < s_n_running_workers; i++) {
+            res = lagopus_bbq_size(&(s_workers[i]->m_channelq));
+            if (res < LAGOPUS_RESULT_OK) {
+              break;
+            }
+            size += res;
+          }
           if (res >= LAGOPUS_RESULT_OK) {
-            *val = (uint16_t) res;
+            *val = (size <= UINT16_MAX) ? (uint16_t) size : UINT16_MAX;
             res = LAGOPUS_RESULT_OK;
           }
         } else {
@@ -425,16 +526,17 @@ ofp_handler_channelq_stats_get(uint16_t *val) {
 /*
  * private functions
  */
-/* initialize thread. it runs only once. */
-static void
-s_initialize_once(void) {
+/* allocate a thread serving bridges of the index. */
+static ofp_handler_t
+s_worker_create(size_t index) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   lagopus_qmuxer_poll_t *polls = NULL;
+  ofp_handler_t thd = NULL;
+  char name[32];
 
-  lagopus_msg_debug(10, "called.\n");
   /* allocate thread */
-  s_ofp_handler = (ofp_handler_t)malloc(sizeof(*s_ofp_handler));
-  if (s_ofp_handler == NULL) {
+  thd = (ofp_handler_t)malloc(sizeof(*thd));
+  if (thd == NULL) {
     lagopus_exit_fatal("ofp_handler_initialize:allocate ofp_handler");
   }
 
@@ -445,29 +547,58 @@ s_initialize_once(void) {
   }
 
   /* init lagopus_thread_t */
-  res = lagopus_thread_create((lagopus_thread_t *)&s_ofp_handler,
+  if (index == 0) {
+    snprintf(name, sizeof(name), "ofp_handler");
+  } else {
+    snprintf(name, sizeof(name), "ofp_handler%zu", index);
+  }
+  res = lagopus_thread_create((lagopus_thread_t *)&thd,
                               s_ofph_thread_main, s_ofph_thread_shutdown,
-                              s_ofph_thread_freeup, "ofp_handler", NULL);
+                              s_ofph_thread_freeup, name, NULL);
   if (res != LAGOPUS_RESULT_OK) {
     lagopus_exit_fatal("ofp_handler_initialize:lagopus_thread_crate (%s)",
                        lagopus_error_get_string(res));
   }
   /* set thread_free_when_destroy */
-  lagopus_thread_free_when_destroy((lagopus_thread_t *)&s_ofp_handler);
+  lagopus_thread_free_when_destroy((lagopus_thread_t *)&thd);
 
   /* create mutex */
-  res = lagopus_mutex_create(&(s_ofp_handler->m_status_lock));
+  res = lagopus_mutex_create(&(thd->m_status_lock));
   if (res != LAGOPUS_RESULT_OK) {
     lagopus_exit_fatal("ofp_handler_initialize:lagopus_mutex_create (%s)",
                        lagopus_error_get_string(res));
   }
   /* Create the qmuxer. */
-  res = lagopus_qmuxer_create(&(s_ofp_handler->muxer));
+  res = lagopus_qmuxer_create(&(thd->muxer));
   if (res != LAGOPUS_RESULT_OK) {
     lagopus_exit_fatal("ofp_handler_initialize:lagopus_qmuxer_create (%s)",
                        lagopus_error_get_string(res));
   }
 
+  /* init other */
+  thd->m_channelq = NULL;
+  thd->m_polls = polls;
+  thd->m_n_polls = 0;
+  thd->m_index = index;
+  thd->m_generation = 0;
+  thd->m_n_bridgeqs = 0;
+  thd->m_status = OFPH_SHUTDOWNED;
+
+  return thd;
+}
+
+/* initialize thread. it runs only once. */
+static void
+s_initialize_once(void) {
+  size_t i;
+
+  lagopus_msg_debug(10, "called.\n");
+  /* allocate threads */
+  for (i = 0; i < OFPH_MAX_WORKERS; i++) {
+    s_workers[i] = s_worker_create(i);
+  }
+  s_ofp_handler = s_workers[0];
+
   /* Register queue put function. */
   dp_dataq_put_func_register(ofp_handler_dataq_data_put);
   dp_eventq_put_func_register(ofp_handler_eventq_data_put);
@@ -476,8 +607,6 @@ s_initialize_once(void) {
 
   /* init other */
   s_set_status(OFPH_SHUTDOWNED);
-  s_ofp_handler->m_polls = polls;
-  s_ofp_handler->m_n_polls = 0;
   lagopus_msg_debug(1, "created. (retptr: %p)\n", s_ofp_handler);
 
   return;
@@ -586,23 +715,22 @@ s_ofp_version_check(struct channel *channel,
           ofp_header_version_check(channel, header) == true);
 }
 
-/* process channel */
+/* check channel entry before processing it. */
 static inline lagopus_result_t
-s_process_channelq_entry(struct channelq_data *entry) {
-  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
-  struct channel *channel = NULL;
-  struct pbuf *pbuf = NULL;
-  struct pbuf *req_pbuf = NULL;
-  struct ofp_header header;
-  struct ofp_error error = {OFPET_BAD_REQUEST, OFPBRC_BAD_VERSION, {NULL}};
+s_check_channelq_entry(struct channelq_data *entry,
+                       struct ofp_header *header,
+                       struct ofp_error *error,
+                       struct pbuf **req_pbufp) {
+  struct channel *channel;
+  struct pbuf *pbuf;
+  struct pbuf *req_pbuf;
 
   lagopus_msg_debug(10, "get item. %p\n", entry);
   if (entry == NULL
       || entry->channel == NULL
       || entry->pbuf == NULL) {
     lagopus_msg_warning("received channelq_data is NULL\n");
-    res = LAGOPUS_RESULT_INVALID_ARGS;
-    goto done;
+    return LAGOPUS_RESULT_INVALID_ARGS;
   }
   channel = entry->channel;
   pbuf = entry->pbuf;
@@ -612,53 +740,68 @@ s_process_channelq_entry(struct channelq_data *entry) {
                                    OFP_ERROR_MAX_SIZE);
   if (req_pbuf == NULL) {
     lagopus_msg_warning("Can't allocate pbuf.\n");
-    res = LAGOPUS_RESULT_NO_MEMORY;
-    goto done;
+    return LAGOPUS_RESULT_NO_MEMORY;
   }
+  *req_pbufp = req_pbuf;
   if (pbuf_copy_with_length(req_pbuf, pbuf, OFP_ERROR_MAX_SIZE) !=
       LAGOPUS_RESULT_OK) {
     lagopus_msg_warning("Can't copy request pbuf.\n");
-    ofp_error_set(&error, OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
-    res = LAGOPUS_RESULT_OFP_ERROR;
-    goto done;
+    ofp_error_set(error, OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+    return LAGOPUS_RESULT_OFP_ERROR;
   }
-  error.req = req_pbuf;
+  error->req = req_pbuf;
 
-  if (ofp_header_decode_sneak(pbuf, &header) != LAGOPUS_RESULT_OK) {
+  if (ofp_header_decode_sneak(pbuf, header) != LAGOPUS_RESULT_OK) {
     lagopus_msg_warning("cannot decode header\n");
-    ofp_error_set(&error, OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
-    res = LAGOPUS_RESULT_OFP_ERROR;
-    goto done;
+    ofp_error_set(error, OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+    return LAGOPUS_RESULT_OFP_ERROR;
   }
 
   /* check packet length. */
-  if (pbuf_plen_equal_check(pbuf, (size_t) header.length) !=
+  if (pbuf_plen_equal_check(pbuf, (size_t) header->length) !=
       LAGOPUS_RESULT_OK) {
     lagopus_msg_warning("bad header length.\n");
-    ofp_error_set(&error, OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
-    res = LAGOPUS_RESULT_OFP_ERROR;
-    goto done;
+    ofp_error_set(error, OFPET_BAD_REQUEST, OFPBRC_BAD_LEN);
+    return LAGOPUS_RESULT_OFP_ERROR;
   }
 
   /* State loggin. */
   lagopus_msg_debug(1, "RECV: %s (xid=%u)\n",
-                    ofp_type_str(header.type), header.xid);
+                    ofp_type_str(header->type), header->xid);
 
   /* check ofp version in header. */
-  if (s_ofp_version_check(channel, &header) == false) {
-    res = LAGOPUS_RESULT_OFP_ERROR;
-    ofp_error_set(&error, OFPET_BAD_REQUEST, OFPBRC_BAD_VERSION);
-    goto done;
+  if (s_ofp_version_check(channel, header) == false) {
+    ofp_error_set(error, OFPET_BAD_REQUEST, OFPBRC_BAD_VERSION);
+    return LAGOPUS_RESULT_OFP_ERROR;
   }
 
   /* check role. */
-  if (ofp_role_check(channel, &header) == false) {
+  if (ofp_role_check(channel, header) == false) {
     lagopus_msg_warning("role is slave (%s).\n",
-                        ofp_type_str(header.type));
-    res = LAGOPUS_RESULT_OFP_ERROR;
-    ofp_error_set(&error, OFPET_BAD_REQUEST, OFPBRC_IS_SLAVE);
+                        ofp_type_str(header->type));
+    ofp_error_set(error, OFPET_BAD_REQUEST, OFPBRC_IS_SLAVE);
+    return LAGOPUS_RESULT_OFP_ERROR;
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/* process channel */
+static inline lagopus_result_t
+s_process_channelq_entry(struct channelq_data *entry) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  struct channel *channel = NULL;
+  struct pbuf *pbuf = NULL;
+  struct pbuf *req_pbuf = NULL;
+  struct ofp_header header;
+  struct ofp_error error = {OFPET_BAD_REQUEST, OFPBRC_BAD_VERSION, {NULL}};
+
+  res = s_check_channelq_entry(entry, &header, &error, &req_pbuf);
+  if (res != LAGOPUS_RESULT_OK) {
     goto done;
   }
+  channel = entry->channel;
+  pbuf = entry->pbuf;
 
   switch (header.type) {
     case OFPT_HELLO:
@@ -760,17 +903,96 @@ s_process_channelq_entry(struct channelq_data *entry) {
 
 done:
   if (res == LAGOPUS_RESULT_OFP_ERROR) {
-    res = ofp_error_msg_send(channel, &header, &error);
+    res = ofp_error_msg_send(entry->channel, &header, &error);
   }
 
   /* free request data in error. */
   if (req_pbuf != NULL) {
-    channel_pbuf_list_unget(channel, req_pbuf);
+    channel_pbuf_list_unget(entry->channel, req_pbuf);
   }
 
   return res;
 }
 
+/* is the entry OFPT_FLOW_MOD on the channel? */
+static inline bool
+s_is_flow_mod_channelq_entry(struct channelq_data *entry,
+                             struct channel *channel) {
+  struct ofp_header header;
+
+  return (entry != NULL && entry->channel != NULL && entry->pbuf != NULL &&
+          (channel == NULL || entry->channel == channel) &&
+          ofp_header_decode_sneak(entry->pbuf, &header) == LAGOPUS_RESULT_OK &&
+          header.type == OFPT_FLOW_MOD);
+}
+
+/* process consecutive OFPT_FLOW_MODs on the same channel as a batch. */
+static inline void
+s_process_channelq_flow_mods(struct channelq_data **entries, size_t n) {
+  lagopus_result_t res;
+  struct channel *channel = entries[0]->channel;
+  struct flowdb_batch *batch = NULL;
+  struct pbuf *req_pbuf[OFPH_FLOW_MOD_MAX_BATCHES];
+  struct ofp_header header[OFPH_FLOW_MOD_MAX_BATCHES];
+  struct ofp_error error[OFPH_FLOW_MOD_MAX_BATCHES];
+  bool queued[OFPH_FLOW_MOD_MAX_BATCHES];
+  size_t i, nqueued;
+
+  res = ofp_flow_mod_batch_begin(channel_dpid_get(channel), &batch);
+  if (res != LAGOPUS_RESULT_OK) {
+    for (i = 0; i < n; i++) {
+      s_process_channelq_entry(entries[i]);
+    }
+    return;
+  }
+
+  /* decode and queue. */
+  for (i = 0; i < n; i++) {
+    req_pbuf[i] = NULL;
+    queued[i] = false;
+    ofp_error_set(&error[i], OFPET_BAD_REQUEST, OFPBRC_BAD_VERSION);
+    error[i].req = NULL;
+    res = s_check_channelq_entry(entries[i], &header[i], &error[i],
+                                 &req_pbuf[i]);
+    if (res == LAGOPUS_RESULT_OK) {
+      res = ofp_flow_mod_batch_handle(channel, entries[i]->pbuf, &header[i],
+                                      batch, &error[i]);
+      if (res == LAGOPUS_RESULT_OK) {
+        queued[i] = true;
+        continue;
+      }
+    }
+    if (res == LAGOPUS_RESULT_OFP_ERROR) {
+      ofp_error_msg_send(channel, &header[i], &error[i]);
+    }
+  }
+
+  /* apply all with a single lock of the flowdb. */
+  if (flowdb_flow_batch_count(batch) > 0) {
+    (void) flowdb_flow_batch_commit(batch, false);
+    nqueued = 0;
+    for (i = 0; i < n; i++) {
+      if (queued[i] == false) {
+        continue;
+      }
+      res = flowdb_flow_batch_result_get(batch, nqueued++);
+      if (res == LAGOPUS_RESULT_OFP_ERROR) {
+        lagopus_msg_warning("OFP ERROR (%s).\n",
+                            lagopus_error_get_string(res));
+        ofp_error_msg_send(channel, &header[i], &error[i]);
+      }
+    }
+  }
+  flowdb_flow_batch_free(batch);
+
+  /* free request data in error. */
+  for (i = 0; i < n; i++) {
+    if (req_pbuf[i] != NULL) {
+      channel_pbuf_list_unget(channel, req_pbuf[i]);
+    }
+  }
+}
+
 /* process eventq. */
 static inline lagopus_result_t
 s_process_eventq_entry(struct ofp_bridge *ofp_bridge,
@@ -839,9 +1061,73 @@ done:
   return res;
 }
 
+/* thread serving the bridge. */
+static inline size_t
+s_worker_index(uint64_t dpid) {
+  uint16_t n = s_n_running_workers;
+
+  return (n > 1) ? (size_t) (dpid % n) : 0;
+}
+
+/* release bridgeqs and polls of the thread. */
+static inline void
+s_bridgeqs_release(ofp_handler_t thd) {
+  if (thd->m_polls != NULL) {
+    ofp_bridgeq_mgr_poll_reset(&thd->m_polls[DEFAULT_POLLS],
+                               MAX_POLLS - DEFAULT_POLLS);
+  }
+  if (thd->m_n_polls > DEFAULT_POLLS) {
+    thd->m_n_polls = DEFAULT_POLLS;
+  }
+  ofp_bridgeq_mgr_bridgeqs_free(thd->m_bridgeqs, thd->m_n_bridgeqs);
+  thd->m_n_bridgeqs = 0;
+}
+
+/* get bridgeqs and polls of the bridges assigned to the thread. */
+static inline lagopus_result_t
+s_bridgeqs_assign(ofp_handler_t thd) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  struct ofp_bridgeq *bridgeqs[MAX_BRIDGES];
+  struct ofp_bridge *bridge;
+  uint64_t n_bridgeqs = 0;
+  uint64_t generation;
+  uint64_t i;
+
+  /* get generation first, changes after this are caught next time. */
+  generation = ofp_bridgeq_mgr_generation_get();
+  s_bridgeqs_release(thd);
+
+  /* get bridgeq array. */
+  res = ofp_bridgeq_mgr_bridgeqs_to_array(bridgeqs, &n_bridgeqs,
+                                          MAX_BRIDGES);
+  if (res != LAGOPUS_RESULT_OK) {
+    goto done;
+  }
+  for (i = 0; i < n_bridgeqs; i++) {
+    bridge = ofp_bridgeq_mgr_bridge_get(bridgeqs[i]);
+    if (bridge != NULL && s_worker_index(bridge->dpid) == thd->m_index) {
+      thd->m_bridgeqs[thd->m_n_bridgeqs++] = bridgeqs[i];
+    } else {
+      ofp_bridgeq_mgr_bridgeq_free(bridgeqs[i]);
+    }
+  }
+
+  /* get polls.*/
+  res = ofp_bridgeq_mgr_polls_get(thd->m_polls,
+                                  thd->m_bridgeqs,
+                                  (uint64_t *) &thd->m_n_polls,
+                                  thd->m_n_bridgeqs);
+  if (res == LAGOPUS_RESULT_OK) {
+    thd->m_generation = generation;
+  }
+
+done:
+  return res;
+}
+
 /* read each queues. */
 static lagopus_result_t
-s_dequeue(struct ofp_bridgeq *brqs) {
+s_dequeue(ofp_handler_t thd, struct ofp_bridgeq *brqs) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   struct ofp_bridge *bridge;
   lagopus_qmuxer_poll_t qpoll;
@@ -849,20 +1135,20 @@ s_dequeue(struct ofp_bridgeq *brqs) {
   if (brqs != NULL) {
     bridge = ofp_bridgeq_mgr_bridge_get(brqs);
     qpoll = ofp_bridgeq_mgr_eventq_poll_get(brqs);
-    res = s_eventq_dequeue(bridge, qpoll);
+    res = s_eventq_dequeue(thd, bridge, qpoll);
     if (res != LAGOPUS_RESULT_OK) {
       lagopus_perror(res);
       goto done;
     }
     qpoll = ofp_bridgeq_mgr_dataq_poll_get(brqs);
-    res = s_dataq_dequeue(bridge, qpoll);
+    res = s_dataq_dequeue(thd, bridge, qpoll);
     if (res != LAGOPUS_RESULT_OK) {
       lagopus_perror(res);
       goto done;
     }
 #ifdef OFPH_POLL_WRITING
     poll = ofp_bridgeq_mgr_event_dataq_poll_get(brqs);
-    res = s_event_dataq_enqueue(bridge, qpoll);
+    res = s_event_dataq_enqueue(thd, bridge, qpoll);
     if (res != LAGOPUS_RESULT_OK) {
       lagopus_perror(res);
       goto done;
@@ -883,17 +1169,13 @@ static lagopus_result_t
 s_ofph_thread_main(const lagopus_thread_t *selfptr,
                    void *arg) {
   uint64_t i;
-  ofp_handler_t thd;
+  ofp_handler_t thd = NULL;
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   lagopus_bbq_t bbq = NULL;
   int n_need_watch = 0;
   int n_valid_polls = 0;
   global_state_t gstate;
   shutdown_grace_level_t level;
-  uint64_t n_bridgeqs = 0;
-  /* number of default polls. */
-  uint64_t n_polls = 0;
-  struct ofp_bridgeq *bridgeqs[MAX_BRIDGES];
   (void)arg;
 
   if (selfptr == NULL || *selfptr == NULL) {
@@ -918,6 +1200,12 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
   lagopus_msg_debug(10, "now GLOBAL_STATE_STARTED, start main-loop.\n");
 
   s_is_started = true;
+  /* get polls, rebuilt only when bridges are changed. */
+  res = s_bridgeqs_assign(thd);
+  if (res != LAGOPUS_RESULT_OK) {
+    lagopus_perror(res);
+    goto done;
+  }
   /* main loop. */
   while (s_is_running == true) {
     n_need_watch = 0;
@@ -927,23 +1215,12 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
       goto done;
     }
 
-    /* get bridgeq array. */
-    res = ofp_bridgeq_mgr_bridgeqs_to_array(bridgeqs, &n_bridgeqs,
-                                            MAX_BRIDGES);
-    if (res != LAGOPUS_RESULT_OK) {
-      lagopus_perror(res);
-      goto done;
-    }
-
-    /* get polls.*/
-    n_polls = thd->m_n_polls;
-    res = ofp_bridgeq_mgr_polls_get(thd->m_polls,
-                                    bridgeqs,
-                                    (uint64_t *) &thd->m_n_polls,
-                                    n_bridgeqs);
-    if (res != LAGOPUS_RESULT_OK) {
-      lagopus_perror(res);
-      goto free_bridgeqs;
+    if (ofp_bridgeq_mgr_generation_get() != thd->m_generation) {
+      res = s_bridgeqs_assign(thd);
+      if (res != LAGOPUS_RESULT_OK) {
+        lagopus_perror(res);
+        goto done;
+      }
     }
 
     for (i = 0; i < thd->m_n_polls; i++) {
@@ -953,7 +1230,7 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
       if (res != LAGOPUS_RESULT_OK) {
         lagopus_perror(res);
         s_set_status(OFPH_SHUTDOWN_RIGHT_NOW);
-        goto free_bridgeqs;
+        goto done;
       }
       if (bbq != NULL && ofp_handler_validate_bbq(&bbq) == true) {
         n_valid_polls++;
@@ -963,7 +1240,7 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
       if (res != LAGOPUS_RESULT_OK) {
         lagopus_perror(res);
         s_set_status(OFPH_SHUTDOWN_RIGHT_NOW);
-        goto free_bridgeqs;
+        goto done;
       }
       n_need_watch++;
     }
@@ -971,7 +1248,7 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
       lagopus_msg_error("there are no valid queues.\n");
       s_set_status(OFPH_SHUTDOWN_RIGHT_NOW);
       res = LAGOPUS_RESULT_INVALID_OBJECT;
-      goto free_bridgeqs;
+      goto done;
     }
     /* Wait for an event. */
     res = lagopus_qmuxer_poll(&(thd->muxer),
@@ -979,25 +1256,23 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
                               (size_t)n_need_watch, MUXER_TIMEOUT);
     if (s_get_status() == OFPH_SHUTDOWN_RIGHT_NOW) {
       res = LAGOPUS_RESULT_NOT_OPERATIONAL;
-      goto free_bridgeqs;
+      goto done;
     }
     if (res > 0) {
       /* read channelq */
-      res = s_channelq_dequeue(&(thd->m_channelq), thd->m_polls[0]);
+      res = s_channelq_dequeue(thd);
       if (res != LAGOPUS_RESULT_OK) {
         lagopus_perror(res);
         /* Not exit. */
         res = LAGOPUS_RESULT_OK;
       }
       /* read eventq, dataq, event_dataq */
-      if (thd->m_n_polls > 1) {
-        for (i = 0; i < n_bridgeqs; i++) {
-          res = s_dequeue(bridgeqs[i]);
-          if (res != LAGOPUS_RESULT_OK) {
-            lagopus_perror(res);
-            /* Not exit. */
-            res = LAGOPUS_RESULT_OK;
-          }
+      for (i = 0; i < thd->m_n_bridgeqs; i++) {
+        res = s_dequeue(thd, thd->m_bridgeqs[i]);
+        if (res != LAGOPUS_RESULT_OK) {
+          lagopus_perror(res);
+          /* Not exit. */
+          res = LAGOPUS_RESULT_OK;
         }
       }
     } else if (res == LAGOPUS_RESULT_TIMEDOUT) {
@@ -1009,13 +1284,6 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
       s_set_status(OFPH_SHUTDOWN_RIGHT_NOW);
     }
 
-  free_bridgeqs:
-    /* free bridgeqs. */
-    ofp_bridgeq_mgr_poll_reset(&thd->m_polls[n_polls],
-                               MAX_POLLS - n_polls);
-    thd->m_n_polls = n_polls;
-    ofp_bridgeq_mgr_bridgeqs_free(bridgeqs, n_bridgeqs);
-
     if (res != LAGOPUS_RESULT_OK) {
       break;
     }
@@ -1023,6 +1291,15 @@ s_ofph_thread_main(const lagopus_thread_t *selfptr,
 
 done:
   lagopus_msg_debug(10, "ofp_handler breaks main-loop.\n");
+  if (thd != NULL && thd == s_ofp_handler) {
+    /* the others must break main-loop before s_ofp_handler. */
+    mbar();
+    s_is_running = false;
+    for (i = 1; i < s_n_running_workers; i++) {
+      (void) lagopus_thread_wait((lagopus_thread_t *)&s_workers[i],
+                                 SHUTDOWN_TIMEOUT);
+    }
+  }
   return res;
 }
 
@@ -1040,10 +1317,13 @@ s_ofph_thread_shutdown(const lagopus_thread_t *selfptr,
       lagopus_bbq_cancel_janitor(&(thd->m_channelq));
       lagopus_qmuxer_cancel_janitor(&(thd->muxer));
     }
-    /* shutdown all queues, bridges, hashmaps */
+    s_bridgeqs_release(thd);
     lagopus_bbq_shutdown(&(thd->m_channelq), true);
-    s_destroy_for_recreate();
-    s_set_status(OFPH_SHUTDOWNED);
+    if (thd == s_ofp_handler) {
+      /* shutdown all queues, bridges, hashmaps */
+      s_destroy_for_recreate();
+      s_set_status(OFPH_SHUTDOWNED);
+    }
   }
   if (is_canceled == true && s_is_started == false) {
     global_state_cancel_janitor();
@@ -1055,11 +1335,13 @@ s_ofph_thread_shutdown(const lagopus_thread_t *selfptr,
 static void
 s_ofph_thread_freeup(const lagopus_thread_t *selfptr,
                      void *arg) {
+  ofp_handler_t thd = (ofp_handler_t)*selfptr;
   (void)arg;
   lagopus_msg_debug(10, "called. %p\n", selfptr);
-  if (s_validate_ofp_handler() == true) {
-    ofp_handler_t thd = (ofp_handler_t)*selfptr;
-
+  if (thd != s_ofp_handler || s_validate_ofp_handler() == true) {
+    if (thd != s_ofp_handler) {
+      s_channelq_destroy(thd);
+    }
     free(thd->m_polls);
     thd->m_polls = NULL;
     lagopus_qmuxer_destroy(&(thd->muxer));
@@ -1068,7 +1350,9 @@ s_ofph_thread_freeup(const lagopus_thread_t *selfptr,
     thd->m_status_lock = NULL;
   }
 
-  ofp_bridgeq_mgr_destroy();
+  if (thd == s_ofp_handler) {
+    ofp_bridgeq_mgr_destroy();
+  }
   lagopus_msg_debug(10, "ok.\n");
 }
 
@@ -1082,14 +1366,15 @@ s_channel_freeup_proc(void **val) {
 
 /* read channelq */
 static inline lagopus_result_t
-s_channelq_dequeue(channelq_t *q_ptr,
-                   lagopus_qmuxer_poll_t qpoll) {
+s_channelq_dequeue(ofp_handler_t thd) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  channelq_t *q_ptr = &(thd->m_channelq);
+  lagopus_qmuxer_poll_t qpoll = thd->m_polls[0];
   struct channelq_data **gets = NULL;
   lagopus_result_t q_size = lagopus_bbq_size(q_ptr);
   uint16_t max_batches = channelq_max_batches;
   size_t get_num;
-  size_t i;
+  size_t i, j, k;
 
   lagopus_msg_debug(10,
                     "called. q_size: %lu, max_batches: %"PRIu16"\n",
@@ -1114,13 +1399,28 @@ s_channelq_dequeue(channelq_t *q_ptr,
         res = LAGOPUS_RESULT_OK;
       }
 
-      for (i = 0; i < get_num; i++) {
-        lagopus_mutex_enter_critical(&(s_ofp_handler->m_status_lock), &cstate);
+      for (i = 0; i < get_num; i = j) {
+        /* consecutive OFPT_FLOW_MODs on the same channel. */
+        j = i + 1;
+        if (s_is_flow_mod_channelq_entry(gets[i], NULL) == true) {
+          while (j < get_num && j - i < OFPH_FLOW_MOD_MAX_BATCHES &&
+                 s_is_flow_mod_channelq_entry(gets[j],
+                                              gets[i]->channel) == true) {
+            j++;
+          }
+        }
+        lagopus_mutex_enter_critical(&(thd->m_status_lock), &cstate);
         {
-          s_process_channelq_entry(gets[i]);
-          channelq_data_destroy(gets[i]);
+          if (j - i > 1) {
+            s_process_channelq_flow_mods(&gets[i], j - i);
+          } else {
+            s_process_channelq_entry(gets[i]);
+          }
+          for (k = i; k < j; k++) {
+            channelq_data_destroy(gets[k]);
+          }
         }
-        lagopus_mutex_leave_critical(&(s_ofp_handler->m_status_lock), cstate);
+        lagopus_mutex_leave_critical(&(thd->m_status_lock), cstate);
       }
     } else {
       res = LAGOPUS_RESULT_NO_MEMORY;
@@ -1137,7 +1437,8 @@ done:
 
 /* read eventq */
 static inline lagopus_result_t
-s_eventq_dequeue(struct ofp_bridge *ofp_bridge,
+s_eventq_dequeue(ofp_handler_t thd,
+                 struct ofp_bridge *ofp_bridge,
                  lagopus_qmuxer_poll_t qpoll) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   struct eventq_data **gets = NULL;
@@ -1177,7 +1478,7 @@ s_eventq_dequeue(struct ofp_bridge *ofp_bridge,
       }
 
       for (i = 0; i < get_num; i++) {
-        lagopus_mutex_enter_critical(&(s_ofp_handler->m_status_lock), &cstate);
+        lagopus_mutex_enter_critical(&(thd->m_status_lock), &cstate);
         {
           res = s_process_eventq_entry(ofp_bridge, gets[i]);
           if (gets[i] != NULL && gets[i]->free != NULL) {
@@ -1186,7 +1487,7 @@ s_eventq_dequeue(struct ofp_bridge *ofp_bridge,
             free(gets[i]);
           }
         }
-        lagopus_mutex_leave_critical(&(s_ofp_handler->m_status_lock), cstate);
+        lagopus_mutex_leave_critical(&(thd->m_status_lock), cstate);
       }
     } else {
       res = LAGOPUS_RESULT_NO_MEMORY;
@@ -1202,7 +1503,8 @@ done:
 
 /* read dataq */
 static inline lagopus_result_t
-s_dataq_dequeue(struct ofp_bridge *ofp_bridge,
+s_dataq_dequeue(ofp_handler_t thd,
+                struct ofp_bridge *ofp_bridge,
                 lagopus_qmuxer_poll_t qpoll) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
   struct eventq_data **gets = NULL;
@@ -1242,7 +1544,7 @@ s_dataq_dequeue(struct ofp_bridge *ofp_bridge,
       }
 
       for (i = 0; i < get_num; i++) {
-        lagopus_mutex_enter_critical(&(s_ofp_handler->m_status_lock), &cstate);
+        lagopus_mutex_enter_critical(&(thd->m_status_lock), &cstate);
         {
           res = s_process_dataq_entry(ofp_bridge, gets[i]);
           if (gets[i] != NULL && gets[i]->free != NULL) {
@@ -1251,7 +1553,7 @@ s_dataq_dequeue(struct ofp_bridge *ofp_bridge,
             free(gets[i]);
           }
         }
-        lagopus_mutex_leave_critical(&(s_ofp_handler->m_status_lock), cstate);
+        lagopus_mutex_leave_critical(&(thd->m_status_lock), cstate);
       }
     } else {
       res = LAGOPUS_RESULT_NO_MEMORY;
@@ -1268,7 +1570,8 @@ done:
 /* write event_dataq */
 #ifdef OFPH_POLL_WRITING
 static inline lagopus_result_t
-s_event_dataq_enqueue(struct ofp_bridge *ofp_bridge,
+s_event_dataq_enqueue(ofp_handler_t thd,
+                      struct ofp_bridge *ofp_bridge,
                       lagopus_qmuxer_poll_t qpoll) {
   int i;
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
@@ -1281,7 +1584,7 @@ s_event_dataq_enqueue(struct ofp_bridge *ofp_bridge,
     int cstate;
     MUXER_FAIRNESS(q_size);
     for (i = 0; i < q_size; i++) {
-      lagopus_mutex_enter_critical(&(s_ofp_handler->m_status_lock), &cstate);
+      lagopus_mutex_enter_critical(&(thd->m_status_lock), &cstate);
       {
         struct edq_buffer_entry *qe
           = STAILQ_FIRST(&(ofp_bridge->edq_buffer));
@@ -1301,7 +1604,7 @@ s_event_dataq_enqueue(struct ofp_bridge *ofp_bridge,
           free(qe);
         }
       }
-      lagopus_mutex_leave_critical(&(s_ofp_handler->m_status_lock), cstate);
+      lagopus_mutex_leave_critical(&(thd->m_status_lock), cstate);
     }
     res = LAGOPUS_RESULT_OK;
   } else if (q_size == 0) {
@@ -1312,14 +1615,30 @@ done:
 }
 #endif  /* OFPH_POLL_WRITING */
 
+static inline void
+s_channelq_destroy(ofp_handler_t thd) {
+  if (thd->m_channelq != NULL) {
+    lagopus_bbq_destroy(&(thd->m_channelq), true);
+    thd->m_channelq = NULL;
+  }
+  if (thd->m_polls != NULL && thd->m_polls[0] != NULL) {
+    lagopus_qmuxer_poll_destroy(&(thd->m_polls[0]));
+    thd->m_polls[0] = NULL;
+  }
+  thd->m_n_polls = 0;
+}
+
 static inline void
 s_destroy_for_recreate(void) {
+  size_t i;
+
   if (s_validate_ofp_handler() == true) {
-    lagopus_bbq_destroy(&(s_ofp_handler->m_channelq), true);
-    s_ofp_handler->m_channelq = NULL;
-    lagopus_qmuxer_poll_destroy(&(s_ofp_handler->m_polls[0]));
-    s_ofp_handler->m_polls[0] = NULL;
-    s_ofp_handler->m_n_polls = 0;
+    for (i = 0; i < OFPH_MAX_WORKERS; i++) {
+      /* NULL if destroyed in ofp_handler_finalize(). */
+      if (s_workers[i] != NULL) {
+        s_channelq_destroy(s_workers[i]);
+      }
+    }
   }
   /* clear bridgeq hashmap */
   (void) ofp_bridgeq_mgr_clear();
@@ -1328,24 +1647,29 @@ s_destroy_for_recreate(void) {
 static inline lagopus_result_t
 s_recreate(void) {
   lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  ofp_handler_t thd;
+  uint16_t i;
 
   if (s_validate_ofp_handler() == true) {
-    /* Create channelq */
-    res = lagopus_bbq_create(&(s_ofp_handler->m_channelq), struct channel *,
-                             channelq_size, s_channel_freeup_proc);
-    if (res != LAGOPUS_RESULT_OK) {
-      lagopus_perror(res);
-      goto done;
-    }
-    /* Create poll objects for channel queue. */
-    res = lagopus_qmuxer_poll_create(&(s_ofp_handler->m_polls[0]),
-                                     s_ofp_handler->m_channelq,
-                                     LAGOPUS_QMUXER_POLL_READABLE);
-    if (res != LAGOPUS_RESULT_OK) {
-      lagopus_perror(res);
-      goto done;
+    for (i = 0; i < s_n_running_workers; i++) {
+      thd = s_workers[i];
+      /* Create channelq */
+      res = lagopus_bbq_create(&(thd->m_channelq), struct channel *,
+                               channelq_size, s_channel_freeup_proc);
+      if (res != LAGOPUS_RESULT_OK) {
+        lagopus_perror(res);
+        goto done;
+      }
+      /* Create poll objects for channel queue. */
+      res = lagopus_qmuxer_poll_create(&(thd->m_polls[0]),
+                                       thd->m_channelq,
+                                       LAGOPUS_QMUXER_POLL_READABLE);
+      if (res != LAGOPUS_RESULT_OK) {
+        lagopus_perror(res);
+        goto done;
+      }
+      thd->m_n_polls++;
     }
-    s_ofp_handler->m_n_polls++;
   } else {
     res = LAGOPUS_RESULT_INVALID_ARGS;
   }
@@ -164,12 +164,17 @@ datastore_bridge_queue_info_t s_queue_info = {1000LL, 1000LL, 1000LL,
 
 struct channel *
 create_data_channel(void) {
+  return create_data_channel_with_dpid(0xabc);
+}
+
+struct channel *
+create_data_channel_with_dpid(uint64_t dpid) {
   static uint8_t cnt;
   char buf[256];
   struct channel *channel;
   lagopus_session_t session;
   lagopus_ip_address_t *addr = NULL;
-  uint64_t dpid = 0xabc;
+  uint64_t bridge_dpid = 0xabc;
 
   if (s_is_init == false) {
     s_is_init = true;
@@ -196,7 +201,7 @@ create_data_channel(void) {
 
     /* bridge. */
     ofp_bridgeq_mgr_initialize(NULL);
-    s_bridge_info.dpid = dpid;
+    s_bridge_info.dpid = bridge_dpid;
     s_bridge_info.fail_mode = DATASTORE_BRIDGE_FAIL_MODE_SECURE;
     s_bridge_info.max_buffered_packets = UINT32_MAX;
     s_bridge_info.max_ports = UINT16_MAX;
@@ -214,7 +219,7 @@ create_data_channel(void) {
                       dp_bridge_port_set(bridge_name, port_name, 0));
     TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
                       ofp_bridgeq_mgr_bridge_register(
-                        dpid,
+                        bridge_dpid,
                         bridge_name,
                         &s_bridge_info,
                         &s_queue_info));
@@ -170,6 +170,9 @@ data_create(ofp_data_create_proc_t create_proc,
 struct channel *
 create_data_channel(void);
 
+struct channel *
+create_data_channel_with_dpid(uint64_t dpid);
+
 void
 destroy_data_channel(struct channel *channel);
 
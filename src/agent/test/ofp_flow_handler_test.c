@@ -21,6 +21,7 @@
 #include "../ofp_match.h"
 #include "../ofp_instruction.h"
 #include "../channel_mgr.h"
+#include "lagopus/dp_apis.h"
 
 void
 setUp(void) {
@@ -39,31 +40,6 @@ ofp_multipart_request_handle_wrap(struct channel *channel,
   return ofp_multipart_request_handle(channel, pbuf, xid_header, error);
 }
 
-static struct flow_stats *
-s_flow_stats_alloc(void) {
-  struct flow_stats *flow_stats;
-
-  flow_stats = calloc(1, sizeof(struct flow_stats));
-  if (flow_stats != NULL) {
-    TAILQ_INIT(&flow_stats->match_list);
-    TAILQ_INIT(&flow_stats->instruction_list);
-  }
-
-  return flow_stats;
-}
-
-static struct flow_stats_list s_flow_stats_list;
-
-static lagopus_result_t
-s_ofp_flow_reply_create_wrap(struct channel *channel,
-                             struct pbuf_list **pbuf_list,
-                             struct ofp_header *xid_header) {
-  return ofp_flow_stats_reply_create(channel, pbuf_list,
-                                     &s_flow_stats_list,
-                                     xid_header);
-}
-
-
 void
 test_prologue(void) {
   lagopus_result_t r;
@@ -519,160 +495,102 @@ test_ofp_flow_handle_null(void) {
   pbuf_free(pbuf);
 }
 
-void
-test_ofp_flow_reply_create_01(void) {
-  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
-  struct flow_stats *flow_stats = NULL;
-  struct instruction *instruction = NULL;
-  struct match *match = NULL;
-  const char *require[1] = {
-    "04 13 00 58 00 00 00 10 00 01 00 00 00 00 00 00 "
-    "00 48 01 00 00 00 00 02 00 00 00 03 00 04 00 05 "
-    "00 06 00 07 00 00 00 00 00 00 00 00 00 00 00 08 "
-    "00 00 00 00 00 00 00 09 00 00 00 00 00 00 00 0a "
-    "00 01 00 10 00 00 01 08 00 00 00 00 00 00 00 00 "
-    "00 01 00 08 00 00 00 00"
-  };
-
-  TAILQ_INIT(&s_flow_stats_list);
-  if ((flow_stats = s_flow_stats_alloc()) != NULL) {
-    /* flow_stats = 48, match = 16, instruction = 8, sum = 72 */
-    flow_stats->ofp.length = 48 + 16 + 8;
-    flow_stats->ofp.table_id = 0x01;
-    flow_stats->ofp.duration_sec = 0x02;
-    flow_stats->ofp.duration_nsec = 0x03;
-    flow_stats->ofp.priority = 0x04;
-    flow_stats->ofp.idle_timeout = 0x05;
-    flow_stats->ofp.hard_timeout = 0x06;
-    flow_stats->ofp.flags = 0x07;
-    flow_stats->ofp.cookie = 0x08;
-    flow_stats->ofp.packet_count = 0x09;
-    flow_stats->ofp.byte_count = 0x0a;
-    if ((match = match_alloc(8)) != NULL) {
-      match->oxm_class = 0x00;
-      match->oxm_field = 0x01;
-      match->oxm_length = 0x08;
-      TAILQ_INSERT_TAIL(&(flow_stats->match_list), match, entry);
-    }
-    if ((instruction = instruction_alloc()) != NULL) {
-      instruction->ofpit_goto_table.type = OFPIT_GOTO_TABLE;
-      instruction->ofpit_goto_table.len = 0x08; /* action_list empty */
-      instruction->ofpit_goto_table.table_id = 0x00;
-      TAILQ_INSERT_TAIL(&(flow_stats->instruction_list), instruction, entry);
-    }
-    TAILQ_INSERT_TAIL(&s_flow_stats_list, flow_stats, entry);
-  } else {
-    TEST_FAIL_MESSAGE("allocation error.");
-  }
+#define CURSOR_NFLOWS 2500
 
-  /* port 0 */
-  ret = check_pbuf_list_packet_create(s_ofp_flow_reply_create_wrap, require, 1);
-  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, ret, "create port 0 error.");
+/* replies written to the channel. */
+static uint8_t s_written[CURSOR_NFLOWS * 128];
+static size_t s_written_len;
 
-  /* free */
-  while ((flow_stats = TAILQ_FIRST(&s_flow_stats_list)) != NULL) {
-    TAILQ_REMOVE(&s_flow_stats_list, flow_stats, entry);
-    ofp_match_list_elem_free(&flow_stats->match_list);
-    ofp_instruction_list_elem_free(&flow_stats->instruction_list);
-    free(flow_stats);
+static ssize_t
+s_write_capture(lagopus_session_t s, void *buf, size_t n) {
+  (void) s;
+  if (s_written_len + n <= sizeof(s_written)) {
+    memcpy(s_written + s_written_len, buf, n);
+    s_written_len += n;
   }
+  return (ssize_t) n;
 }
 
 void
-test_ofp_flow_reply_create_02(void) {
+test_ofp_flow_reply_create_by_cursor(void) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
-  struct flow_stats *flow_stats = NULL;
-  struct match *match = NULL;
-  const char *header_data[2] = {
-    "04 13 ff b8 00 00 00 10 00 01 00 01 00 00 00 00 ",
-    "04 13 00 58 00 00 00 10 00 01 00 00 00 00 00 00 "
-  };
-  const char *body_data[2] = {
-    "00 48 01 00 00 00 00 02 00 00 00 03 00 04 00 05 "
-    "00 06 00 07 00 00 00 00 00 00 00 00 00 00 00 08 "
-    "00 00 00 00 00 00 00 09 00 00 00 00 00 00 00 0a "
-    "00 01 00 18 00 00 01 10 00 00 00 00 00 00 00 00 "
-    "00 00 00 00 00 00 00 00",
-    "00 48 01 00 00 00 00 02 00 00 00 03 00 04 00 05 "
-    "00 06 00 07 00 00 00 00 00 00 00 00 00 00 00 08 "
-    "00 00 00 00 00 00 00 09 00 00 00 00 00 00 00 0a "
-    "00 01 00 18 00 00 01 10 00 00 00 00 00 00 00 00 "
-    "00 00 00 00 00 00 00 00"
-  };
-  size_t nums[2] = {909, 1};
-  int i;
-
-  /* data */
-  TAILQ_INIT(&s_flow_stats_list);
-  for (i = 0; i < 910; i++) {
-    if ((flow_stats = s_flow_stats_alloc()) != NULL) {
-      /* flow_stats = 48, match = 24, sum = 72 */
-      flow_stats->ofp.length = 0;
-      flow_stats->ofp.table_id = 0x01;
-      flow_stats->ofp.duration_sec = 0x02;
-      flow_stats->ofp.duration_nsec = 0x03;
-      flow_stats->ofp.priority = 0x04;
-      flow_stats->ofp.idle_timeout = 0x05;
-      flow_stats->ofp.hard_timeout = 0x06;
-      flow_stats->ofp.flags = 0x07;
-      flow_stats->ofp.cookie = 0x08;
-      flow_stats->ofp.packet_count = 0x09;
-      flow_stats->ofp.byte_count = 0x0a;
-      if ((match = match_alloc(16)) != NULL) {
-        match->oxm_class = 0x00;
-        match->oxm_field = 0x01;
-        match->oxm_length = 0x10;
-        TAILQ_INSERT_TAIL(&(flow_stats->match_list), match, entry);
-      }
-      TAILQ_INSERT_TAIL(&s_flow_stats_list, flow_stats, entry);
-    } else {
-      TEST_FAIL_MESSAGE("allocation error.");
-    }
+  struct channel *channel = create_data_channel();
+  struct channel *unknown;
+  struct bridge *bridge = dp_bridge_lookup_by_dpid(channel_dpid_get(channel));
+  struct pbuf_list *pbuf_list = NULL;
+  struct ofp_flow_mod flow_mod;
+  struct ofp_flow_stats_request request;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_header xid_header;
+  struct ofp_error error;
+  uint16_t length, flags;
+  uint8_t *msg, *p;
+  int nflow = 0, nmsg = 0, i;
+
+  TEST_ASSERT_NOT_NULL(bridge);
+  TAILQ_INIT(&match_list);
+  TAILQ_INIT(&instruction_list);
+
+  /* empty match, one flow per priority. */
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.table_id = 1;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+  for (i = 0; i < CURSOR_NFLOWS; i++) {
+    flow_mod.priority = (uint16_t)i;
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      flowdb_flow_add(bridge, &flow_mod, &match_list,
+                                      &instruction_list, &error));
   }
 
-  ret = check_pbuf_list_across_packet_create(s_ofp_flow_reply_create_wrap,
-        header_data, body_data, nums, 2);
-  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, ret, "create port 0 error.");
-
-  /* free */
-  while ((flow_stats = TAILQ_FIRST(&s_flow_stats_list)) != NULL) {
-    TAILQ_REMOVE(&s_flow_stats_list, flow_stats, entry);
-    ofp_match_list_elem_free(&flow_stats->match_list);
-    ofp_instruction_list_elem_free(&flow_stats->instruction_list);
-    free(flow_stats);
+  memset(&request, 0, sizeof(request));
+  request.table_id = OFPTT_ALL;
+  xid_header.xid = 0x10;
+  s_written_len = 0;
+  session_write_set(channel_session_get(channel), s_write_capture);
+  ret = ofp_flow_stats_reply_create_by_cursor(channel, &pbuf_list, &request,
+                                              &match_list, &xid_header,
+                                              &error);
+  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, ret, "create error.");
+
+  /* replies of the earlier chunks were already sent. */
+  TEST_ASSERT_TRUE(s_written_len > 0);
+  TEST_ASSERT_FALSE(TAILQ_EMPTY(&pbuf_list->tailq));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    channel_send_packet_list(channel, pbuf_list));
+  pbuf_list_free(pbuf_list);
+
+  /* walk the replies, only the last one has no REPLY_MORE flag. */
+  for (msg = s_written; msg < s_written + s_written_len; msg += length) {
+    length = (uint16_t)((msg[2] << 8) | msg[3]);
+    flags = (uint16_t)((msg[10] << 8) | msg[11]);
+    TEST_ASSERT_TRUE(msg + length <= s_written + s_written_len);
+    TEST_ASSERT_EQUAL(msg + length < s_written + s_written_len ?
+                      OFPMPF_REPLY_MORE : 0, flags);
+    for (p = msg + sizeof(struct ofp_multipart_reply);
+         p < msg + length; p += (p[0] << 8) | p[1]) {
+      TEST_ASSERT_EQUAL(1, p[2]);
+      nflow++;
+    }
+    nmsg++;
   }
-}
-
-void
-test_ofp_flow_reply_create_null(void) {
-  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
-  struct channel *channel = channel_alloc_ip4addr("127.0.0.1", "1000", 0x01);
-  struct pbuf_list *pbuf_list = NULL;
-  struct flow_stats_list flow_stats_list;
-  struct ofp_header ofp_header;
-
-  ret = ofp_flow_stats_reply_create(NULL, &pbuf_list,
-                                    &flow_stats_list,
-                                    &ofp_header);
-  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_INVALID_ARGS, ret,
-                            "NULL-check error. (channel)");
-
-  ret = ofp_flow_stats_reply_create(channel, NULL,
-                                    &flow_stats_list,
-                                    &ofp_header);
-  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_INVALID_ARGS, ret,
-                            "NULL-check error. (pbuf)");
-
-  ret = ofp_flow_stats_reply_create(channel, &pbuf_list,
-                                    NULL, &ofp_header);
-  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_INVALID_ARGS, ret,
-                            "NULL-check error. (flow_stats_list)");
-
-  ret = ofp_flow_stats_reply_create(channel, &pbuf_list,
-                                    &flow_stats_list, NULL);
-  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_INVALID_ARGS, ret,
-                            "NULL-check error. (ofp_header)");
-  channel_free(channel);
+  TEST_ASSERT_EQUAL(CURSOR_NFLOWS, nflow);
+  TEST_ASSERT_TRUE(nmsg > 1);
+
+  /* bridge not found. */
+  unknown = create_data_channel_with_dpid(0xdead);
+  ret = ofp_flow_stats_reply_create_by_cursor(unknown, &pbuf_list, &request,
+                                              &match_list, &xid_header,
+                                              &error);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_NOT_FOUND, ret);
+  pbuf_list_free(pbuf_list);
+
+  /* cleanup. */
+  flow_mod.table_id = OFPTT_ALL;
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    flowdb_flow_delete(bridge, &flow_mod, &match_list,
+                                       &error));
 }
 
 void
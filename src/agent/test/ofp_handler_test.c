@@ -20,6 +20,7 @@
 #include "lagopus/ofp_bridge.h"
 #include "lagopus/eventq_data.h"
 #include "lagopus/ofp_bridgeq_mgr.h"
+#include "lagopus/dp_apis.h"
 #include "handler_test_utils.h"
 #include "../channel_mgr.h"
 
@@ -585,6 +586,126 @@ test_ofp_handler_event_dataq_data_get(void) {
   free(ret_data);
 }
 
+#define STRESS_WORKERS 4
+#define STRESS_BRIDGES 8
+#define STRESS_MSGS 500
+#define STRESS_TIMEOUT 10LL * 1000LL * 1000LL * 1000LL
+
+void
+test_put_channelq_multi_bridges(void) {
+  lagopus_result_t res = LAGOPUS_RESULT_ANY_FAILURES;
+  struct ofp_bridge *ofpb[STRESS_BRIDGES];
+  struct channel *channel[STRESS_BRIDGES];
+  lagopus_bbq_t *channelq[STRESS_BRIDGES];
+  struct channelq_data *cdata = NULL;
+  struct eventq_data *edata[STRESS_MSGS];
+  datastore_bridge_info_t info = {0};
+  char name[STRESS_BRIDGES][32];
+  static lagopus_chrono_t put_time[STRESS_BRIDGES][STRESS_MSGS];
+  lagopus_chrono_t now, start, sum[STRESS_BRIDGES], max[STRESS_BRIDGES];
+  size_t nrecv[STRESS_BRIDGES];
+  size_t i, j, n, get_num, total = 0;
+  uint64_t dpid;
+
+  /* restart with multiple threads. */
+  ofp_handler_shutdown(SHUTDOWN_GRACEFULLY);
+  res = lagopus_thread_wait((lagopus_thread_t *) th,
+                            SHUTDOWN_TIMEOUT);
+  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, res, "wait error");
+  ofp_handler_workers_set(STRESS_WORKERS);
+  TEST_ASSERT_EQUAL(STRESS_WORKERS, ofp_handler_workers_get());
+  res = ofp_handler_start();
+  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, res, "start error");
+
+  /* create channels and bridges. */
+  for (i = 0; i < STRESS_BRIDGES; i++) {
+    dpid = 0x100 + i;
+    channel[i] = create_data_channel_with_dpid(dpid);
+    TEST_ASSERT_NOT_NULL_MESSAGE(channel[i], "channel alloc error");
+    info.dpid = dpid;
+    info.fail_mode = DATASTORE_BRIDGE_FAIL_MODE_SECURE;
+    info.max_buffered_packets = UINT32_MAX;
+    info.max_ports = UINT16_MAX;
+    info.max_tables = UINT8_MAX;
+    info.max_flows = UINT32_MAX;
+    snprintf(name[i], sizeof(name[i]), "stress_bridge%zu", i);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, dp_bridge_create(name[i], &info));
+    ofpb[i] = s_register_bridge(dpid, LAGOPUS_RESULT_OK);
+    TEST_ASSERT_NOT_NULL_MESSAGE(ofpb[i], "ofp_bridge null");
+    res = ofp_handler_get_channelq_by_dpid(dpid, &channelq[i]);
+    TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, res, "get channelq error");
+    nrecv[i] = 0;
+    sum[i] = 0;
+    max[i] = 0;
+  }
+  /* bridges are spread over the threads. */
+  TEST_ASSERT_TRUE(channelq[0] != channelq[1]);
+  TEST_ASSERT_TRUE(channelq[0] == channelq[STRESS_WORKERS]);
+
+  /* put PACKET_OUTs to all bridges, and wait for event_dataq. */
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(start);
+  for (n = 0; total < STRESS_BRIDGES * STRESS_MSGS; n++) {
+    for (i = 0; i < STRESS_BRIDGES && n < STRESS_MSGS; i++) {
+      cdata = (struct channelq_data *)malloc(sizeof(*cdata));
+      TEST_ASSERT_NOT_NULL_MESSAGE(cdata, "cdata alloc error");
+      cdata->channel = channel[i];
+      channel_refs_get(channel[i]);
+      create_packet(
+        "04 0d 00 3c 00 00 00 10 "
+        "ff ff ff ff 00 00 00 0e 00 20 00 00 00 00 00 00 "
+        "00 00 00 10 00 00 00 0d 00 01 00 00 00 00 00 00 "
+        "00 00 00 10 00 00 01 0d 00 02 00 00 00 00 00 00 "
+        "68 6f 67 65",
+        &cdata->pbuf);
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(put_time[i][n]);
+      res = lagopus_bbq_put(channelq[i], &cdata, struct channelq_data *,
+                            PUT_TIMEOUT);
+      TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, res, "channelq put error");
+    }
+    for (i = 0; i < STRESS_BRIDGES; i++) {
+      get_num = 0;
+      res = lagopus_bbq_get_n(&ofpb[i]->event_dataq, edata,
+                              STRESS_MSGS - nrecv[i], 0LL,
+                              struct eventq_data *, 0LL, &get_num);
+      TEST_ASSERT_TRUE(res >= LAGOPUS_RESULT_OK);
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(now);
+      for (j = 0; j < get_num; j++) {
+        lagopus_chrono_t latency = now - put_time[i][nrecv[i]++];
+        sum[i] += latency;
+        if (latency > max[i]) {
+          max[i] = latency;
+        }
+        ofp_packet_out_free(edata[j]);
+        total++;
+      }
+    }
+    if (n >= STRESS_MSGS) {
+      usleep(100);
+    }
+    WHAT_TIME_IS_IT_NOW_IN_NSEC(now);
+    if (now - start > STRESS_TIMEOUT) {
+      TEST_FAIL_MESSAGE("TIME OUT.");
+    }
+  }
+
+  for (i = 0; i < STRESS_BRIDGES; i++) {
+    printf("bridge %#"PRIx64": %d msgs, latency avg %.1f usec, "
+           "max %.1f usec\n",
+           ofpb[i]->dpid, STRESS_MSGS,
+           (double) sum[i] / STRESS_MSGS / 1000.0,
+           (double) max[i] / 1000.0);
+    TEST_ASSERT_EQUAL(STRESS_MSGS, nrecv[i]);
+    s_unregister_bridge(ofpb[i]->dpid, LAGOPUS_RESULT_OK);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, dp_bridge_destroy(name[i]));
+  }
+
+  ofp_handler_shutdown(SHUTDOWN_GRACEFULLY);
+  res = lagopus_thread_wait((lagopus_thread_t *) th,
+                            SHUTDOWN_TIMEOUT);
+  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, res, "wait error");
+  ofp_handler_workers_set(1);
+}
+
 void
 test_finalize_ofph(void) {
   /* this test must be executed last. */
@@ -19,6 +19,7 @@
 #include "agent.h"
 
 #include "lagopus/datastore.h"
+#include "lagopus/ofp_handler.h"
 
 
 
@@ -84,6 +85,7 @@ static const char *s_pidfile;
 static const char *s_configfile;
 
 static uint16_t s_debug_level = 0;
+static bool s_log_async = false;
 
 
 struct option s_longopts[] = {
@@ -93,6 +95,9 @@ struct option s_longopts[] = {
   { "logfile", required_argument,  NULL, 'l' },
   { "pidfile", required_argument,  NULL, 'p' },
   { "config",  required_argument,  NULL, 'C' },
+  { "ofp-handler-workers", required_argument, NULL, 'W' },
+  { "log-async", no_argument,      NULL, 'A' },
+  { NULL,      0,                  NULL, 0 },
 };
 
 
@@ -108,7 +113,10 @@ usage(FILE *fd, int exit_status) {
 -l, --logfile filename   Specify a log/trace file path (default: syslog)\n\
 -p, --pidfile filename   Specify a pid file path (default: /var/run/%s.pid)\n\
 -C, --config filename    Speficy a config file path (default: lagopus.dsl)\n\
-\n", s_progname, s_progname);
+--ofp-handler-workers n  Number of OpenFlow message handler threads,\n\
+                         1 to %d (default: %d)\n\
+--log-async              Emit the log asynchronously from a writer thread\n\
+\n", s_progname, s_progname, OFPH_MAX_WORKERS, OFPH_DEFAULT_WORKERS);
     lagopus_module_usage_all(fd);
   }
   exit(exit_status);
@@ -161,6 +169,22 @@ parse_args(int argc, const char *const argv[]) {
         s_configfile = optarg;
         break;
       }
+      case 'W': {
+        uint16_t workers;
+
+        if (lagopus_str_parse_uint16(optarg, &workers) != LAGOPUS_RESULT_OK ||
+            workers == 0 || workers > OFPH_MAX_WORKERS) {
+          fprintf(stderr, "invalid number of ofp_handler workers: %s\n",
+                  optarg);
+          usage(stderr, 1);
+        }
+        ofp_handler_workers_set(workers);
+        break;
+      }
+      case 'A': {
+        s_log_async = true;
+        break;
+      }
       default: {
         usage(stderr, 1);
         break;
@@ -170,6 +194,23 @@ parse_args(int argc, const char *const argv[]) {
 }
 
 
+
+/*
+ * Called in the (daemonized) process running the modules, so that the
+ * writer thread of the asynchronous logger is not lost by the fork().
+ */
+static lagopus_result_t
+s_pre_startup(int argc, const char *const argv[]) {
+  (void)argc;
+  (void)argv;
+
+  if (s_log_async == true) {
+    return lagopus_log_set_async(true);
+  }
+  return LAGOPUS_RESULT_OK;
+}
+
+
 
 
 
@@ -227,10 +268,10 @@ main(int argc, const char *const argv[]) {
   (void)lagopus_signal(SIGQUIT, s_term_handler, NULL);
 
   if (s_debug_level == 0) {
-    r = lagopus_mainloop_with_callout(argc, argv, NULL, NULL,
+    r = lagopus_mainloop_with_callout(argc, argv, s_pre_startup, NULL,
                                       true, true, false);
   } else {
-    r = lagopus_mainloop_with_callout(argc, argv, NULL, NULL,
+    r = lagopus_mainloop_with_callout(argc, argv, s_pre_startup, NULL,
                                       false, false, false);
   }
 
@@ -110,10 +110,20 @@ static const char usage[] =
   "           intel64  Intel_hash64                                               \n"
   "           murmur3  MurmurHash3 (32bit)                                        \n"
 #endif /* __SSE4_2__ */
-  "    --fifoness MODE: Select FIFOness mode, MODE is one of none, port, or flow  \n"
+  "    --fifoness MODE: Select FIFOness mode, MODE is one of none, port, flow,    \n"
+  "                     or rss                                                    \n"
   "           flow : FIFOness per each flow (default.)                            \n"
+  "           rss  : FIFOness per each L3/L4 flow, by RSS or 5-tuple hash.        \n"
   "           port : FIFOness per each port.                                      \n"
   "           none : FIFOness is disabled.                                        \n"
+  "    --rebalance : Move flow buckets off the worker whose rings are filled,     \n"
+  "           with --fifoness flow or rss                                         \n"
+  "    --idle \"A, B, C, D\" : Adaptive polling of idle lcores, A, B and C are    \n"
+  "           numbers of empty iterations before each step (0 is disabled)        \n"
+  "           A = Poll with rte_pause                                             \n"
+  "           B = Poll with sleep of D usec                                       \n"
+  "           C = Wait for RX interrupt (sleep if not supported)                  \n"
+  "           D = Sleep time in usec                                              \n"
   "    --rsz \"A, B, C, D\" : Ring sizes                                          \n"
   "           A = Size (in number of buffer descriptors) of each of the NIC RX    \n"
   "               rings read by the I/O RX lcores (default value is %u)           \n"
@@ -613,12 +623,62 @@ parse_arg_fifoness(const char *arg) {
     app.fifoness = FIFONESS_PORT;
   } else if (!strcmp(arg, "flow")) {
     app.fifoness = FIFONESS_FLOW;
+  } else if (!strcmp(arg, "rss")) {
+    app.fifoness = FIFONESS_RSS;
   } else {
     return -1;
   }
   return 0;
 }
 
+#ifndef APP_ARG_IDLE_CHARS
+#define APP_ARG_IDLE_CHARS 63
+#endif
+
+static int
+parse_arg_idle(const char *arg) {
+  uint32_t prev, i;
+  uint32_t *thresh[3];
+
+  if (strnlen(arg, APP_ARG_IDLE_CHARS + 1) == APP_ARG_IDLE_CHARS + 1) {
+    return -1;
+  }
+
+  if (str_to_unsigned_vals(arg, APP_ARG_IDLE_CHARS, ',', 4,
+                           &app.idle_pause,
+                           &app.idle_sleep,
+                           &app.idle_intr,
+                           &app.idle_sleep_us) != 4) {
+    return -2;
+  }
+
+  /* enabled thresholds must be in order of the steps. */
+  thresh[0] = &app.idle_pause;
+  thresh[1] = &app.idle_sleep;
+  thresh[2] = &app.idle_intr;
+  prev = 0;
+  app.idle_first = 0;
+  for (i = 0; i < 3; i++) {
+    if (*thresh[i] == 0) {
+      continue;
+    }
+    if (*thresh[i] < prev) {
+      return -3;
+    }
+    prev = *thresh[i];
+    if (app.idle_first == 0) {
+      app.idle_first = prev;
+    }
+  }
+
+  if ((app.idle_sleep != 0 || app.idle_intr != 0) &&
+      app.idle_sleep_us == 0) {
+    return -4;
+  }
+
+  return 0;
+}
+
 #ifndef APP_ARG_NUMERICAL_SIZE_CHARS
 #define APP_ARG_NUMERICAL_SIZE_CHARS 15
 #endif
@@ -678,6 +738,8 @@ app_parse_args(int argc, const char *argv[]) {
     {"hashtype", 1, 0, 0},
 #endif /* __SSE4_2__ */
     {"fifoness", 1, 0, 0},
+    {"idle", 1, 0, 0},
+    {"rebalance", 0, 0, 0},
     {"show-core-config", 0, 0, 0},
     {NULL, 0, 0, 0}
   };
@@ -791,6 +853,16 @@ app_parse_args(int argc, const char *argv[]) {
             return -1;
           }
         }
+        if (!strcmp(lgopts[option_index].name, "idle")) {
+          ret = parse_arg_idle(optarg);
+          if (ret) {
+            printf("Incorrect value for --idle argument (%d)\n", ret);
+            return -1;
+          }
+        }
+        if (!strcmp(lgopts[option_index].name, "rebalance")) {
+          app.rebalance = 1;
+        }
         if (!strcmp(lgopts[option_index].name, "show-core-config")) {
           show_core_assign = true;
         }
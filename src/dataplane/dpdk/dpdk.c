@@ -166,6 +166,7 @@ app_lcore_main_loop(void *arg) {
 void
 dp_dpdk_init(void) {
   dpdk_assign_worker_ids();
+  app_init_worker_table();
   dpdk_init_mbuf_pools();
 
   printf("Initialization completed.\n");
@@ -244,6 +245,7 @@ dp_dpdk_thread_loop(__UNUSED const lagopus_thread_t *selfptr,
     if (rte_atomic32_read(&dpdk_stop) != 0) {
       break;
     }
+    app_rebalance_workers();
     sleep(1);
   }
   /* 'stop' is requested */
@@ -108,6 +108,14 @@
 #define APP_STATS                    10000000
 #endif
 
+/* Buckets of flow hash, mapped to worker by indirection table */
+#ifndef APP_WORKER_BUCKETS
+#define APP_WORKER_BUCKETS 256
+#endif
+#if (APP_WORKER_BUCKETS < 256)
+#error "APP_WORKER_BUCKETS is too small"
+#endif
+
 
 /* Mempools */
 #ifndef APP_DEFAULT_MBUF_SIZE
@@ -257,6 +265,16 @@
 #define FIFONESS_FLOW 0 /* default */
 #define FIFONESS_PORT 1
 #define FIFONESS_NONE 2
+#define FIFONESS_RSS  3
+
+/* adaptive polling states of the main loops. */
+enum app_idle_state {
+  APP_IDLE_POLL = 0,    /* busy polling. */
+  APP_IDLE_PAUSE,       /* polling with rte_pause. */
+  APP_IDLE_SLEEP,       /* polling with short sleep. */
+  APP_IDLE_INTR,        /* waiting RX interrupt. */
+  APP_IDLE_NSTATES
+};
 
 #define NIC_RX_QUEUE_UNCONFIGURED 0
 #define NIC_RX_QUEUE_ENABLED      1
@@ -299,11 +317,20 @@ struct app_lcore_params_io {
     struct app_mbuf_array mbuf_out[APP_MAX_WORKER_LCORES];
     uint8_t mbuf_out_flush[APP_MAX_WORKER_LCORES];
 
+    /* Bucket in migration, packets are held until it is switched */
+    struct app_mbuf_array mbuf_hold;
+    int32_t hold_bucket;
+    uint32_t hold_mark[APP_MAX_WORKER_LCORES];
+    volatile uint32_t hold_gen;
+
     /* Stats */
     uint32_t nic_queues_count[APP_MAX_NIC_RX_QUEUES_PER_IO_LCORE];
     uint32_t nic_queues_iters[APP_MAX_NIC_RX_QUEUES_PER_IO_LCORE];
     uint32_t rings_count[APP_MAX_WORKER_LCORES];
     uint32_t rings_iters[APP_MAX_WORKER_LCORES];
+    uint64_t rings_drops[APP_MAX_WORKER_LCORES];
+    uint64_t hold_drops;
+    uint32_t bucket_count[APP_WORKER_BUCKETS];
   } rx;
 
   /* I/O TX */
@@ -342,11 +369,30 @@ struct app_lcore_params_worker {
   struct app_mbuf_array mbuf_out[APP_MAX_NIC_PORTS];
   uint8_t mbuf_out_flush[APP_MAX_NIC_PORTS];
 
+  /* Drain request from rebalancer */
+  volatile uint32_t drain_req;
+  volatile uint32_t drain_ack;
+  uint32_t drain_mark[APP_MAX_NIC_PORTS];
+
   /* Stats */
   uint32_t rings_in_count[APP_MAX_IO_LCORES];
   uint32_t rings_in_iters[APP_MAX_IO_LCORES];
   uint32_t rings_out_count[APP_MAX_NIC_PORTS];
   uint32_t rings_out_iters[APP_MAX_NIC_PORTS];
+  uint64_t processed;
+};
+
+struct app_lcore_idle {
+  uint32_t n_empty;                 /* consecutive empty iterations */
+  enum app_idle_state state;
+  uint64_t since;                   /* TSC of the last state change */
+  bool intr_unsupported;
+  /* registered to epoll, indexed as io.rx.nic_queues */
+  uint8_t intr_queues[APP_MAX_NIC_RX_QUEUES_PER_IO_LCORE];
+
+  /* Stats */
+  uint64_t cycles[APP_IDLE_NSTATES];
+  uint64_t count[APP_IDLE_NSTATES];
 };
 
 struct app_lcore_params {
@@ -354,6 +400,7 @@ struct app_lcore_params {
     struct app_lcore_params_io io;
     struct app_lcore_params_worker worker;
   };
+  struct app_lcore_idle idle;
   enum app_lcore_type type;
   struct rte_mempool *pool;
   unsigned socket_id;
@@ -399,6 +446,19 @@ struct app_params {
 
   /* fifoness */
   uint8_t fifoness;
+
+  /* adaptive polling, thresholds in empty iterations (0 is disabled) */
+  uint32_t idle_pause;
+  uint32_t idle_sleep;
+  uint32_t idle_intr;
+  uint32_t idle_sleep_us;
+  uint32_t idle_first;      /* smallest threshold */
+
+  /* worker rebalancing */
+  uint8_t rebalance;
+  uint8_t worker_table[APP_WORKER_BUCKETS];
+  volatile int32_t hold_bucket;
+  volatile uint32_t hold_gen;
 } __rte_cache_aligned;
 
 extern struct app_params app;
@@ -437,6 +497,39 @@ dpdk_rx_burst(struct interface *ifp, void *mbufs[], size_t nb) {
                                             mbufs, nb);
 }
 
+void app_lcore_idle_init(struct app_lcore_params *lp);
+void app_lcore_idle_wakeup(struct app_lcore_params *lp);
+bool app_lcore_idle(struct app_lcore_params *lp);
+void app_lcore_idle_fini(struct app_lcore_params *lp);
+
+/**
+ * Count empty iteration of the main loop.
+ *
+ * @param[in]	lp	lcore parameter.
+ * @param[in]	n	Number of packets processed in this iteration.
+ *
+ * @retval	true	Loop is idle, flush buffers and call app_lcore_idle().
+ * @retval	false	Continue busy polling.
+ */
+static inline bool
+app_lcore_idle_check(struct app_lcore_params *lp, uint32_t n) {
+  struct app_lcore_idle *idle = &lp->idle;
+
+  if (likely(n != 0)) {
+    if (unlikely(idle->n_empty != 0)) {
+      app_lcore_idle_wakeup(lp);
+    }
+    return false;
+  }
+  if (likely(app.idle_first == 0)) {
+    return false;
+  }
+  if (idle->n_empty < UINT32_MAX) {
+    idle->n_empty++;
+  }
+  return (idle->n_empty >= app.idle_first);
+}
+
 int app_parse_args(int argc, const char *argv[]);
 void dp_dpdk_init(void);
 
@@ -446,8 +539,10 @@ void dpdk_init_mbuf_pools(void);
 void app_lcore_io_flush(struct app_lcore_params_io *lp,
                         uint32_t n_workers,
                         void *arg);
-void app_lcore_io(struct app_lcore_params_io *lp, uint32_t n_workers);
+uint32_t app_lcore_io(struct app_lcore_params_io *lp, uint32_t n_workers);
 void app_lcore_main_loop_io(void *arg);
+void app_init_worker_table(void);
+void app_rebalance_workers(void);
 void app_lcore_main_loop_worker(void *arg);
 void app_lcore_main_loop_io_worker(void *arg);
 int app_lcore_main_loop(void *arg);
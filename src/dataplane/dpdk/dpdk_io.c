@@ -58,6 +58,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/queue.h>
 #include <netinet/in.h>
@@ -87,6 +88,7 @@
 #include <rte_debug.h>
 #include <rte_ethdev.h>
 #include <rte_ring.h>
+#include <rte_pause.h>
 #include <rte_mempool.h>
 #include <rte_pci.h>
 #ifdef __SSE4_2__
@@ -126,6 +128,24 @@
 
 #define DP_UPDATE_COUNT		     (200 * 10000)
 
+#ifndef APP_REBALANCE_FILL
+#define APP_REBALANCE_FILL           50 /* % of ring capacity */
+#endif
+
+#ifndef APP_REBALANCE_MAX_MOVES
+#define APP_REBALANCE_MAX_MOVES      8
+#endif
+
+#ifndef APP_REBALANCE_DRAIN_TIMEOUT
+#define APP_REBALANCE_DRAIN_TIMEOUT  100 /* ms */
+#endif
+
+#define APP_REBALANCE_POLL_US        10
+
+#ifndef APP_IDLE_INTR_TIMEOUT
+#define APP_IDLE_INTR_TIMEOUT        10 /* ms */
+#endif
+
 #define APP_IO_RX_DROP_ALL_PACKETS   0
 #define APP_IO_TX_DROP_ALL_PACKETS   0
 
@@ -181,7 +201,7 @@ static struct rte_eth_conf port_conf = {
   .rx_adv_conf = {
     .rss_conf = {
       .rss_key = NULL,
-      .rss_hf = ETH_RSS_IPV4 | ETH_RSS_IPV6,
+      .rss_hf = ETH_RSS_IP | ETH_RSS_TCP | ETH_RSS_UDP,
     },
   },
   .txmode = {
@@ -274,30 +294,57 @@ app_lcore_io_rx_buffer_to_send (
       struct rte_mbuf *m = lp->rx.mbuf_out[worker].array[k];
       rte_pktmbuf_free(m);
     }
+    lp->rx.rings_drops[worker] += bsz - (uint32_t)ret;
   }
 
   lp->rx.mbuf_out[worker].n_mbufs = 0;
 }
 
-static inline void
+/**
+ * Select worker of the flow hash by indirection table.
+ * Packets of the bucket in migration are held and UINT32_MAX is returned.
+ */
+static inline uint32_t
+app_lcore_io_rx_worker(struct app_lcore_params_io *lp,
+                       uint32_t hash,
+                       struct rte_mbuf *mbuf) {
+  uint32_t bucket;
+
+  bucket = hash % APP_WORKER_BUCKETS;
+  lp->rx.bucket_count[bucket]++;
+  if (unlikely((int32_t)bucket == lp->rx.hold_bucket)) {
+    if (likely(lp->rx.mbuf_hold.n_mbufs < APP_MBUF_ARRAY_SIZE)) {
+      lp->rx.mbuf_hold.array[lp->rx.mbuf_hold.n_mbufs++] = mbuf;
+    } else {
+      rte_pktmbuf_free(mbuf);
+      lp->rx.hold_drops++;
+    }
+    return UINT32_MAX;
+  }
+  return app.worker_table[bucket];
+}
+
+static inline uint32_t
 app_lcore_io_rx(struct app_lcore_params_io *lpio,
                 uint32_t n_workers,
                 uint32_t bsz_rd,
                 uint32_t bsz_wr) {
   struct app_lcore_params *lp;
   OS_MBUF **mbufs;
-  uint8_t wkid, portid;
+  uint8_t portid;
   uint32_t fifoness;
-  uint32_t i, j;
+  uint32_t i, j, n_rx, wkid;
 
   fifoness = app.fifoness;
   mbufs = lpio->rx.mbuf_in.array;
   lp = (struct app_lcore_params *)lpio;
+  n_rx = 0;
   if (lp->type == e_APP_LCORE_IO_WORKER) {
     for (i = 0; i < lpio->rx.nifs; i++) {
       uint32_t n_mbufs;
 
       n_mbufs = dpdk_rx_burst(lpio->rx.ifp[i], mbufs, bsz_rd);
+      n_rx += n_mbufs;
       if (n_mbufs != 0) {
         dp_bulk_match_and_action(mbufs, n_mbufs, lp->worker.cache);
       }
@@ -308,11 +355,22 @@ app_lcore_io_rx(struct app_lcore_params_io *lpio,
 
       portid = lpio->rx.ifp[i]->info.eth.port_number;
       n_mbufs = dpdk_rx_burst(lpio->rx.ifp[i], mbufs, bsz_rd);
+      n_rx += n_mbufs;
       for (j = 0; j < n_mbufs; j++) {
         switch (fifoness) {
           case FIFONESS_FLOW:
-            wkid = CityHash64WithSeed(OS_MTOD(mbufs[j], void *),
-                                      sizeof(ETHER_HDR) + 2, portid) % n_workers;
+            wkid = app_lcore_io_rx_worker(
+                     lpio,
+                     (uint32_t)CityHash64WithSeed(OS_MTOD(mbufs[j], void *),
+                                                  sizeof(ETHER_HDR) + 2,
+                                                  portid),
+                     mbufs[j]);
+            break;
+          case FIFONESS_RSS:
+            wkid = app_lcore_io_rx_worker(
+                     lpio,
+                     lagopus_packet_flow_hash(mbufs[j], portid),
+                     mbufs[j]);
             break;
           case FIFONESS_PORT:
             wkid = portid % n_workers;
@@ -322,10 +380,50 @@ app_lcore_io_rx(struct app_lcore_params_io *lpio,
             wkid = j % n_workers;
             break;
         }
+        if (unlikely(wkid == UINT32_MAX)) {
+          continue;
+        }
         app_lcore_io_rx_buffer_to_send(lpio, wkid, mbufs[j], bsz_wr);
       }
     }
   }
+  return n_rx;
+}
+
+/**
+ * Follow the bucket migration requested by rebalancer.
+ * Held packets are released to the (new) worker of the bucket, and
+ * then the ring positions are recorded for new bucket to hold, so that
+ * rebalancer waits for the workers consume the packets sent before.
+ * Called after all pending mbufs are flushed.
+ */
+static void
+app_lcore_io_rx_hold_update(struct app_lcore_params_io *lp,
+                            uint32_t n_workers) {
+  uint32_t gen, worker, n_mbufs, ret, k;
+
+  gen = app.hold_gen;
+  rte_smp_rmb();
+  n_mbufs = lp->rx.mbuf_hold.n_mbufs;
+  if (lp->rx.hold_bucket >= 0 && n_mbufs != 0) {
+    worker = app.worker_table[lp->rx.hold_bucket];
+    ret = rte_ring_sp_enqueue_burst(lp->rx.rings[worker],
+                                    (void **) lp->rx.mbuf_hold.array,
+                                    n_mbufs, NULL);
+    for (k = ret; k < n_mbufs; k++) {
+      rte_pktmbuf_free(lp->rx.mbuf_hold.array[k]);
+    }
+    lp->rx.hold_drops += n_mbufs - ret;
+    lp->rx.mbuf_hold.n_mbufs = 0;
+  }
+  lp->rx.hold_bucket = app.hold_bucket;
+  for (worker = 0; worker < n_workers; worker++) {
+    if (lp->rx.rings[worker] != NULL) {
+      lp->rx.hold_mark[worker] = lp->rx.rings[worker]->prod.tail;
+    }
+  }
+  rte_smp_wmb();
+  lp->rx.hold_gen = gen;
 }
 
 /**
@@ -353,22 +451,28 @@ app_lcore_io_rx_flush(struct app_lcore_params_io *lp, uint32_t n_workers) {
         struct rte_mbuf *pkt_to_free = lp->rx.mbuf_out[worker].array[k];
         rte_pktmbuf_free(pkt_to_free);
       }
+      lp->rx.rings_drops[worker] += n_mbufs - ret;
     }
     lp->rx.mbuf_out[worker].n_mbufs = 0;
     lp->rx.mbuf_out_flush[worker] = 0;
   }
+  if (unlikely(lp->rx.hold_gen != app.hold_gen)) {
+    app_lcore_io_rx_hold_update(lp, n_workers);
+  }
 }
 
 /**
  * Dequeue mbufs from output queue and send to ethernet port.
  * This function is called from I/O (Output) thread.
  */
-static inline void
+static inline uint32_t
 app_lcore_io_tx(struct app_lcore_params_io *lp,
                 uint32_t n_workers,
                 uint32_t bsz_rd,
                 uint32_t bsz_wr) {
-  uint32_t worker;
+  uint32_t worker, n_tx;
+
+  n_tx = 0;
 
   for (worker = 0; worker < n_workers; worker ++) {
     uint32_t i;
@@ -392,6 +496,7 @@ app_lcore_io_tx(struct app_lcore_params_io *lp,
         continue;
       }
 
+      n_tx += (uint32_t)ret;
       n_mbufs += (uint32_t)ret;
 
       if (unlikely(n_mbufs < bsz_wr)) {
@@ -441,6 +546,7 @@ app_lcore_io_tx(struct app_lcore_params_io *lp,
       lp->tx.mbuf_out_flush[port] = 0;
     }
   }
+  return n_tx;
 }
 
 static inline void
@@ -497,30 +603,181 @@ app_lcore_io_flush(struct app_lcore_params_io *lp,
   app_lcore_io_tx_flush(lp, arg);
 }
 
-void
+uint32_t
 app_lcore_io(struct app_lcore_params_io *lp, uint32_t n_workers) {
   uint32_t bsz_rx_rd = app.burst_size_io_rx_read;
   uint32_t bsz_rx_wr = app.burst_size_io_rx_write;
   uint32_t bsz_tx_rd = app.burst_size_io_tx_read;
   uint32_t bsz_tx_wr = app.burst_size_io_tx_write;
+  uint32_t n;
+
+  n = app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr);
+  n += app_lcore_io_tx(lp, n_workers, bsz_tx_rd, bsz_tx_wr);
+  return n;
+}
+
+static inline void
+app_lcore_idle_enter(struct app_lcore_idle *idle, enum app_idle_state state) {
+  uint64_t now;
+
+  now = rte_rdtsc();
+  idle->cycles[idle->state] += now - idle->since;
+  idle->count[state]++;
+  idle->since = now;
+  idle->state = state;
+}
+
+/**
+ * Arm RX interrupt of all NIC RX queues of the lcore and wait.
+ * Interrupt vectors are registered to per-thread epoll at first time.
+ */
+static int
+app_lcore_idle_wait_intr(struct app_lcore_params *lp) {
+  struct app_lcore_params_io *lpio = &lp->io;
+  struct app_lcore_idle *idle = &lp->idle;
+  struct rte_epoll_event ev[APP_MAX_NIC_RX_QUEUES_PER_IO_LCORE];
+  uint32_t armed[APP_MAX_NIC_RX_QUEUES_PER_IO_LCORE];
+  uint8_t portid, queue;
+  uint32_t i, n;
+
+  for (i = 0; i < lpio->rx.n_nic_queues; i++) {
+    if (lpio->rx.nic_queues[i].enabled == 0 || idle->intr_queues[i] != 0) {
+      continue;
+    }
+    portid = lpio->rx.nic_queues[i].port;
+    queue = lpio->rx.nic_queues[i].queue;
+    if (rte_eth_dev_rx_intr_ctl_q(portid, queue, RTE_EPOLL_PER_THREAD,
+                                  RTE_INTR_EVENT_ADD,
+                                  (void *)(uintptr_t)((portid << 8) |
+                                                      queue)) != 0) {
+      lagopus_msg_warning("lcore %u: RX interrupt is not supported "
+                          "by port %u queue %u, use sleep instead\n",
+                          rte_lcore_id(), portid, queue);
+      idle->intr_unsupported = true;
+      return -1;
+    }
+    idle->intr_queues[i] = 1;
+  }
+  n = 0;
+  for (i = 0; i < lpio->rx.n_nic_queues; i++) {
+    if (lpio->rx.nic_queues[i].enabled == 0) {
+      continue;
+    }
+    rte_eth_dev_rx_intr_enable(lpio->rx.nic_queues[i].port,
+                               lpio->rx.nic_queues[i].queue);
+    armed[n++] = i;
+  }
+  if (n == 0) {
+    return -1;
+  }
+  (void)rte_epoll_wait(RTE_EPOLL_PER_THREAD, ev, (int)n,
+                       APP_IDLE_INTR_TIMEOUT);
+  for (i = 0; i < n; i++) {
+    rte_eth_dev_rx_intr_disable(lpio->rx.nic_queues[armed[i]].port,
+                                lpio->rx.nic_queues[armed[i]].queue);
+  }
+  return 0;
+}
+
+void
+app_lcore_idle_init(struct app_lcore_params *lp) {
+  memset(&lp->idle, 0, sizeof(lp->idle));
+  lp->idle.state = APP_IDLE_POLL;
+  lp->idle.since = rte_rdtsc();
+}
+
+void
+app_lcore_idle_wakeup(struct app_lcore_params *lp) {
+  lp->idle.n_empty = 0;
+  if (lp->idle.state != APP_IDLE_POLL) {
+    app_lcore_idle_enter(&lp->idle, APP_IDLE_POLL);
+  }
+}
+
+/**
+ * Back off according to the number of consecutive empty iterations,
+ * rte_pause, then short sleep, and then wait for RX interrupt.
+ * Lcore without NIC RX queue sleeps instead of waiting interrupt.
+ * Returns true if the lcore slept or waited for interrupt, the caller
+ * checks stop request and flowdb update then.
+ */
+bool
+app_lcore_idle(struct app_lcore_params *lp) {
+  struct app_lcore_idle *idle = &lp->idle;
+  enum app_idle_state state;
+  uint32_t n_empty = idle->n_empty;
+
+  if (app.idle_intr != 0 && n_empty >= app.idle_intr) {
+    if (idle->intr_unsupported == false &&
+        lp->type != e_APP_LCORE_WORKER && lp->io.rx.nifs > 0) {
+      state = APP_IDLE_INTR;
+    } else {
+      state = APP_IDLE_SLEEP;
+    }
+  } else if (app.idle_sleep != 0 && n_empty >= app.idle_sleep) {
+    state = APP_IDLE_SLEEP;
+  } else {
+    state = APP_IDLE_PAUSE;
+  }
+  if (state != idle->state) {
+    app_lcore_idle_enter(idle, state);
+  }
+  switch (state) {
+    case APP_IDLE_INTR:
+      if (app_lcore_idle_wait_intr(lp) == 0) {
+        return true;
+      }
+      app_lcore_idle_enter(idle, APP_IDLE_SLEEP);
+      /* FALLTHROUGH */
+    case APP_IDLE_SLEEP:
+      usleep(app.idle_sleep_us);
+      return true;
+    case APP_IDLE_PAUSE:
+    default:
+      rte_pause();
+      return false;
+  }
+}
+
+void
+app_lcore_idle_fini(struct app_lcore_params *lp) {
+  struct app_lcore_idle *idle = &lp->idle;
+  uint64_t hz = rte_get_tsc_hz() / 1000;
 
-  app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr);
-  app_lcore_io_tx(lp, n_workers, bsz_tx_rd, bsz_tx_wr);
+  if (app.idle_first == 0) {
+    return;
+  }
+  app_lcore_idle_enter(idle, APP_IDLE_POLL);
+  lagopus_msg_info("lcore %u: idle poll %" PRIu64 "ms, "
+                   "pause %" PRIu64 "ms(%" PRIu64 "), "
+                   "sleep %" PRIu64 "ms(%" PRIu64 "), "
+                   "intr %" PRIu64 "ms(%" PRIu64 ")\n",
+                   rte_lcore_id(),
+                   idle->cycles[APP_IDLE_POLL] / hz,
+                   idle->cycles[APP_IDLE_PAUSE] / hz,
+                   idle->count[APP_IDLE_PAUSE],
+                   idle->cycles[APP_IDLE_SLEEP] / hz,
+                   idle->count[APP_IDLE_SLEEP],
+                   idle->cycles[APP_IDLE_INTR] / hz,
+                   idle->count[APP_IDLE_INTR]);
 }
 
 void
 app_lcore_main_loop_io(void *arg) {
   uint32_t lcore = rte_lcore_id();
-  struct app_lcore_params_io *lp = &app.lcore_params[lcore].io;
+  struct app_lcore_params *lcp = &app.lcore_params[lcore];
+  struct app_lcore_params_io *lp = &lcp->io;
   uint32_t n_workers = app_get_lcores_worker();
   uint32_t flush_count = 0;
   uint32_t update_count = 0;
+  uint32_t n;
 
   uint32_t bsz_rx_rd = app.burst_size_io_rx_read;
   uint32_t bsz_rx_wr = app.burst_size_io_rx_write;
   uint32_t bsz_tx_rd = app.burst_size_io_tx_read;
   uint32_t bsz_tx_wr = app.burst_size_io_tx_write;
 
+  app_lcore_idle_init(lcp);
   if (lp->rx.n_nic_queues > 0 && lp->tx.n_nic_ports == 0) {
     /* receive loop */
     for (;;) {
@@ -534,7 +791,14 @@ app_lcore_main_loop_io(void *arg) {
         }
         update_count = 0;
       }
-      app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr);
+      n = app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr);
+      if (unlikely(app_lcore_idle_check(lcp, n))) {
+        app_lcore_io_rx_flush(lp, n_workers);
+        if (app_lcore_idle(lcp) == true &&
+            rte_atomic32_read(&dpdk_stop) != 0) {
+          break;
+        }
+      }
       flush_count++;
       update_count++;
     }
@@ -551,7 +815,14 @@ app_lcore_main_loop_io(void *arg) {
         }
         update_count = 0;
       }
-      app_lcore_io_tx(lp, n_workers, bsz_tx_rd, bsz_tx_wr);
+      n = app_lcore_io_tx(lp, n_workers, bsz_tx_rd, bsz_tx_wr);
+      if (unlikely(app_lcore_idle_check(lcp, n))) {
+        app_lcore_io_tx_flush(lp, arg);
+        if (app_lcore_idle(lcp) == true &&
+            rte_atomic32_read(&dpdk_stop) != 0) {
+          break;
+        }
+      }
       flush_count++;
       update_count++;
     }
@@ -568,18 +839,310 @@ app_lcore_main_loop_io(void *arg) {
         }
         update_count = 0;
       }
-      app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr);
-      app_lcore_io_tx(lp, n_workers, bsz_tx_rd, bsz_tx_wr);
+      n = app_lcore_io_rx(lp, n_workers, bsz_rx_rd, bsz_rx_wr);
+      n += app_lcore_io_tx(lp, n_workers, bsz_tx_rd, bsz_tx_wr);
+      if (unlikely(app_lcore_idle_check(lcp, n))) {
+        app_lcore_io_rx_flush(lp, n_workers);
+        app_lcore_io_tx_flush(lp, arg);
+        if (app_lcore_idle(lcp) == true &&
+            rte_atomic32_read(&dpdk_stop) != 0) {
+          break;
+        }
+      }
       flush_count++;
       update_count++;
     }
   }
+  app_lcore_idle_fini(lcp);
   /* cleanup */
   if (likely(lp->tx.n_nic_ports > 0)) {
     app_lcore_io_tx_cleanup(lp);
   }
 }
 
+/**
+ * Initialize indirection table from flow hash bucket to worker.
+ */
+void
+app_init_worker_table(void) {
+  uint32_t n_workers = app_get_lcores_worker();
+  uint32_t bucket, lcore;
+
+  for (bucket = 0; bucket < APP_WORKER_BUCKETS; bucket++) {
+    app.worker_table[bucket] =
+      (uint8_t)(n_workers != 0 ? bucket % n_workers : 0);
+  }
+  app.hold_bucket = -1;
+  for (lcore = 0; lcore < APP_MAX_LCORES; lcore++) {
+    app.lcore_params[lcore].io.rx.hold_bucket = -1;
+  }
+}
+
+static inline bool
+app_ring_consumed(struct rte_ring *ring, uint32_t mark) {
+  return (ring == NULL || (int32_t)(ring->cons.tail - mark) >= 0);
+}
+
+static inline bool
+app_rebalance_timeout(uint64_t deadline) {
+  if (rte_get_timer_cycles() > deadline) {
+    return true;
+  }
+  usleep(APP_REBALANCE_POLL_US);
+  return false;
+}
+
+static struct app_lcore_params_worker *
+app_worker_by_id(uint32_t worker) {
+  uint32_t lcore;
+
+  for (lcore = 0; lcore < APP_MAX_LCORES; lcore++) {
+    if (app.lcore_params[lcore].type == e_APP_LCORE_WORKER &&
+        app.lcore_params[lcore].worker.worker_id == worker) {
+      return &app.lcore_params[lcore].worker;
+    }
+  }
+  return NULL;
+}
+
+static inline bool
+app_rebalance_io_lcore(uint32_t lcore, uint32_t n_workers) {
+  struct app_lcore_params_io *lp = &app.lcore_params[lcore].io;
+
+  return (app.lcore_params[lcore].type == e_APP_LCORE_IO &&
+          lp->rx.n_nic_queues > 0 && lp->rx.n_rings >= n_workers);
+}
+
+/**
+ * Wait for all I/O lcores receiving packets follow the hold generation.
+ */
+static bool
+app_rebalance_wait_io(uint32_t n_workers, uint64_t deadline) {
+  uint32_t lcore;
+
+  for (lcore = 0; lcore < APP_MAX_LCORES; lcore++) {
+    if (!app_rebalance_io_lcore(lcore, n_workers)) {
+      continue;
+    }
+    while (app.lcore_params[lcore].io.rx.hold_gen != app.hold_gen) {
+      if (app_rebalance_timeout(deadline)) {
+        return false;
+      }
+    }
+  }
+  rte_smp_rmb();
+  return true;
+}
+
+/**
+ * Move the bucket to another worker keeping packet order.
+ * I/O lcores hold packets of the bucket, and packets already sent to
+ * the old worker are drained from its input rings, its output buffers
+ * and its output rings before the bucket is switched to new worker.
+ */
+static bool
+app_rebalance_migrate(uint32_t bucket, uint32_t to, uint32_t n_workers) {
+  struct app_lcore_params_worker *lw;
+  uint64_t deadline;
+  uint32_t from, lcore, port, req;
+  bool ok;
+
+  from = app.worker_table[bucket];
+  lw = app_worker_by_id(from);
+  if (lw == NULL || from == to) {
+    return false;
+  }
+  deadline = rte_get_timer_cycles() +
+             rte_get_timer_hz() * APP_REBALANCE_DRAIN_TIMEOUT / 1000;
+
+  /* hold the bucket at I/O lcores. */
+  app.hold_bucket = (int32_t)bucket;
+  rte_smp_wmb();
+  app.hold_gen++;
+  ok = app_rebalance_wait_io(n_workers, deadline);
+
+  /* drain input rings of old worker. */
+  for (lcore = 0; ok && lcore < APP_MAX_LCORES; lcore++) {
+    struct app_lcore_params_io *lp = &app.lcore_params[lcore].io;
+
+    if (!app_rebalance_io_lcore(lcore, n_workers)) {
+      continue;
+    }
+    while (!app_ring_consumed(lp->rx.rings[from], lp->rx.hold_mark[from])) {
+      if (app_rebalance_timeout(deadline)) {
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  /* drain output buffers and rings of old worker. */
+  if (ok) {
+    req = lw->drain_req + 1;
+    lw->drain_req = req;
+    while (lw->drain_ack != req) {
+      if (app_rebalance_timeout(deadline)) {
+        ok = false;
+        break;
+      }
+    }
+    rte_smp_rmb();
+  }
+  for (port = 0; ok && port < APP_MAX_NIC_PORTS; port++) {
+    while (!app_ring_consumed(lw->rings_out[port], lw->drain_mark[port])) {
+      if (app_rebalance_timeout(deadline)) {
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  /* switch, and release held packets. */
+  if (ok) {
+    app.worker_table[bucket] = (uint8_t)to;
+  }
+  app.hold_bucket = -1;
+  rte_smp_wmb();
+  app.hold_gen++;
+  deadline = rte_get_timer_cycles() +
+             rte_get_timer_hz() * APP_REBALANCE_DRAIN_TIMEOUT / 1000;
+  (void)app_rebalance_wait_io(n_workers, deadline);
+
+  return ok;
+}
+
+static uint32_t
+app_rebalance_fill(uint32_t worker, uint32_t n_workers) {
+  uint32_t lcore, count;
+
+  count = 0;
+  for (lcore = 0; lcore < APP_MAX_LCORES; lcore++) {
+    if (!app_rebalance_io_lcore(lcore, n_workers)) {
+      continue;
+    }
+    count += rte_ring_count(app.lcore_params[lcore].io.rx.rings[worker]);
+  }
+  return count;
+}
+
+static uint64_t
+app_rebalance_drops(uint32_t worker, uint32_t n_workers) {
+  uint32_t lcore;
+  uint64_t drops;
+
+  drops = 0;
+  for (lcore = 0; lcore < APP_MAX_LCORES; lcore++) {
+    if (!app_rebalance_io_lcore(lcore, n_workers)) {
+      continue;
+    }
+    drops += app.lcore_params[lcore].io.rx.rings_drops[worker];
+    drops += app.lcore_params[lcore].io.rx.hold_drops;
+  }
+  return drops;
+}
+
+/**
+ * Move the coldest buckets off the overloaded worker.
+ * Called periodically, load of workers and buckets is the number of
+ * packets since the last call.
+ */
+void
+app_rebalance_workers(void) {
+  static uint64_t last_processed[APP_MAX_WORKER_LCORES];
+  static uint32_t last_bucket[APP_WORKER_BUCKETS];
+  uint64_t load[APP_MAX_WORKER_LCORES];
+  uint32_t fill[APP_MAX_WORKER_LCORES];
+  uint32_t bload[APP_WORKER_BUCKETS];
+  uint32_t n_workers, n_io, capacity;
+  uint32_t worker, hot, cold, bucket, lcore, moved, moves, i;
+  uint64_t gap, drops;
+
+  n_workers = app_get_lcores_worker();
+  if (app.rebalance == 0 || n_workers < 2 ||
+      (app.fifoness != FIFONESS_FLOW && app.fifoness != FIFONESS_RSS)) {
+    return;
+  }
+  n_io = 0;
+  memset(bload, 0, sizeof(bload));
+  for (lcore = 0; lcore < APP_MAX_LCORES; lcore++) {
+    if (app.lcore_params[lcore].type == e_APP_LCORE_IO_WORKER) {
+      return;
+    }
+    if (!app_rebalance_io_lcore(lcore, n_workers)) {
+      continue;
+    }
+    for (bucket = 0; bucket < APP_WORKER_BUCKETS; bucket++) {
+      bload[bucket] += app.lcore_params[lcore].io.rx.bucket_count[bucket];
+    }
+    n_io++;
+  }
+  for (bucket = 0; bucket < APP_WORKER_BUCKETS; bucket++) {
+    uint32_t count = bload[bucket];
+
+    bload[bucket] = count - last_bucket[bucket];
+    last_bucket[bucket] = count;
+  }
+  hot = cold = 0;
+  for (worker = 0; worker < n_workers; worker++) {
+    struct app_lcore_params_worker *lw = app_worker_by_id(worker);
+
+    if (lw == NULL) {
+      return;
+    }
+    load[worker] = lw->processed - last_processed[worker];
+    last_processed[worker] = lw->processed;
+    fill[worker] = app_rebalance_fill(worker, n_workers);
+    if (fill[worker] > fill[hot]) {
+      hot = worker;
+    }
+    if (fill[worker] < fill[cold] ||
+        (fill[worker] == fill[cold] && load[worker] < load[cold])) {
+      cold = worker;
+    }
+  }
+  capacity = n_io * app.ring_rx_size;
+  if (hot == cold || capacity == 0 ||
+      (uint64_t)fill[hot] * 100 < (uint64_t)capacity * APP_REBALANCE_FILL) {
+    return;
+  }
+
+  /* move coldest buckets first, until half of the load gap is moved. */
+  gap = load[hot] > load[cold] ? (load[hot] - load[cold]) / 2 : 0;
+  drops = app_rebalance_drops(hot, n_workers);
+  moved = moves = 0;
+  while (moves < APP_REBALANCE_MAX_MOVES && moved < gap) {
+    uint32_t min = UINT32_MAX;
+
+    bucket = APP_WORKER_BUCKETS;
+    for (i = 0; i < APP_WORKER_BUCKETS; i++) {
+      if (app.worker_table[i] == hot && bload[i] != 0 && bload[i] < min) {
+        min = bload[i];
+        bucket = i;
+      }
+    }
+    if (bucket == APP_WORKER_BUCKETS) {
+      break;
+    }
+    bload[bucket] = 0;
+    if (!app_rebalance_migrate(bucket, cold, n_workers)) {
+      lagopus_msg_warning("rebalance: bucket %u drain timed out\n", bucket);
+      break;
+    }
+    moved += min;
+    moves++;
+  }
+  if (moves != 0) {
+    lagopus_msg_info("rebalance: %u buckets (%u pkts) worker %u -> %u, "
+                     "ring fill %u/%u -> %u/%u, drops %" PRIu64
+                     " -> %" PRIu64 "\n",
+                     moves, moved, hot, cold,
+                     fill[hot], fill[cold],
+                     app_rebalance_fill(hot, n_workers),
+                     app_rebalance_fill(cold, n_workers),
+                     drops, app_rebalance_drops(hot, n_workers));
+  }
+}
+
 void
 dpdk_init_mbuf_pools(void) {
   unsigned socket, lcore;
@@ -821,6 +1384,15 @@ dpdk_configure_interface(struct interface *ifp) {
 
   rte_eth_dev_info_get(portid, &ifp->devinfo);
 
+  /* let NIC calculate RSS hash to dispatch packets to workers. */
+  if (app.fifoness == FIFONESS_RSS) {
+    port_conf.rxmode.mq_mode = ETH_MQ_RX_RSS;
+  }
+  /* RX interrupt to wait for packets in idle. */
+  if (app.idle_intr != 0) {
+    port_conf.intr_conf.rxq = 1;
+  }
+
   /* Init port */
   printf("Initializing NIC port %u ...\n", (unsigned) portid);
   if (!rte_eth_dev_is_valid_port(portid)) {
@@ -1157,6 +1729,15 @@ dpdk_get_hwaddr(uint8_t portid, uint8_t *hw_addr) {
   return LAGOPUS_RESULT_OK;
 }
 
+lagopus_result_t
+dpdk_get_link_status(uint8_t portid, bool *link_up) {
+  struct rte_eth_link link;
+
+  rte_eth_link_get_nowait(portid, &link);
+  *link_up = (link.link_status != 0);
+  return LAGOPUS_RESULT_OK;
+}
+
 lagopus_result_t
 dpdk_get_stats(uint8_t portid, datastore_interface_stats_t *stats) {
   struct rte_eth_stats rte_stats;
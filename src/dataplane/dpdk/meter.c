@@ -145,6 +145,7 @@ lagopus_meter_packet(struct lagopus_packet *pkt, struct meter *meter,
   enum rte_meter_color color;
   struct lagopus_band_list *list;
   struct lagopus_band *lband, *color_band;
+  uint64_t tsc;
 
   DPRINT("metering packet\n");
   if ((meter->flags & OFPMF_STATS) != 0) {
@@ -153,10 +154,11 @@ lagopus_meter_packet(struct lagopus_packet *pkt, struct meter *meter,
   }
   list = meter->driverdata;
   color_band = NULL;
+  tsc = dp_clock_tsc();
   if ((meter->flags & OFPMF_PKTPS) == 0) {
     TAILQ_FOREACH(lband, list, next) {
       color = rte_meter_srtcm_color_blind_check(&lband->kbps_meter,
-                                                rte_rdtsc(),
+                                                tsc,
                                                 OS_M_PKTLEN(PKT2MBUF(pkt)));
       if (color_band == NULL && color == e_RTE_METER_RED) {
         color_band = lband;
@@ -165,7 +167,7 @@ lagopus_meter_packet(struct lagopus_packet *pkt, struct meter *meter,
   } else {
     TAILQ_FOREACH(lband, list, next) {
       color = rte_meter_srtcm_color_blind_check(&lband->pps_meter,
-              rte_rdtsc(),
+              tsc,
               1);
       if (color_band == NULL && color == e_RTE_METER_RED) {
         color_band = lband;
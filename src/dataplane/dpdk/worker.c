@@ -111,6 +111,7 @@
 #include "packet.h"
 #include "csum.h"
 #include "lock.h"
+#include "bonding.h"
 #include "dpdk/dpdk.h"
 
 #ifndef APP_LCORE_WORKER_FLUSH
@@ -147,6 +148,7 @@ dp_bulk_match_and_action(OS_MBUF *mbufs[], size_t n_mbufs,
 
   APP_WORKER_PREFETCH1(rte_pktmbuf_mtod(mbufs[0], unsigned char *));
   APP_WORKER_PREFETCH0(mbufs[1]);
+  dp_clock_update();
   flowdb_rdlock(NULL);
 
   for (i = 0; i < n_mbufs; i++) {
@@ -166,6 +168,16 @@ dp_bulk_match_and_action(OS_MBUF *mbufs[], size_t n_mbufs,
 #else
       ifp = dpdk_interface_lookup(m->port);
 #endif /* RTE_MBUF_HAS_PKT */
+      if (unlikely(ifp != NULL && ifp->master != NULL)) {
+        /* slave receives packets as the bond port. */
+        if (bonding_slave_input(ifp, rte_pktmbuf_mtod(m, uint8_t *),
+                                rte_pktmbuf_data_len(m)) == true) {
+          rte_pktmbuf_free(m);
+          mbufs[i] = NULL;
+          continue;
+        }
+        ifp = ifp->master;
+      }
       if (ifp == NULL ||
           ifp->port == NULL ||
           ifp->port->bridge == NULL ||
@@ -215,11 +227,12 @@ dp_bulk_match_and_action(OS_MBUF *mbufs[], size_t n_mbufs,
       if (unlikely(m == NULL)) {
         continue;
       }
-      if (likely(i < n_mbufs - 1)) {
+      /* consumed(LACPDU) or forwarded packets leave NULL holes. */
+      if (likely(i < n_mbufs - 1) && mbufs[i + 1] != NULL) {
         APP_WORKER_PREFETCH1(rte_pktmbuf_mtod(mbufs[i + 1],
                                               unsigned char *));
       }
-      if (likely(i < n_mbufs - 2)) {
+      if (likely(i < n_mbufs - 2) && mbufs[i + 2] != NULL) {
         APP_WORKER_PREFETCH0(mbufs[i + 2]);
       }
       pkt = MBUF2PKT(m);
@@ -230,13 +243,14 @@ dp_bulk_match_and_action(OS_MBUF *mbufs[], size_t n_mbufs,
     flowdb_rdunlock(NULL);
 }
 
-static inline void
+static inline uint32_t
 app_lcore_worker(struct app_lcore_params_worker *lp,
                  uint32_t bsz_rd,
                  struct worker_arg *arg) {
   static const uint8_t eth_bcast[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
-  uint32_t i;
+  uint32_t i, n;
 
+  n = 0;
 
   for (i = 0; i < lp->n_rings_in; i ++) {
     struct rte_ring *ring_in = lp->rings_in[i];
@@ -251,8 +265,11 @@ app_lcore_worker(struct app_lcore_params_worker *lp,
 #endif /* HYBRID && PIPELINER */
       continue;
     }
+    n += (uint32_t)ret;
+    lp->processed += (uint32_t)ret;
     dp_bulk_match_and_action(lp->mbuf_in.array, ret, lp->cache);
   }
+  return n;
 }
 
 /**
@@ -289,21 +306,35 @@ app_lcore_worker_flush(struct app_lcore_params_worker *lp) {
     lp->mbuf_out[portid].n_mbufs = 0;
     lp->mbuf_out_flush[portid] = 0;
   }
+
+  /* all packets before drain request are flushed, tell output position. */
+  if (unlikely(lp->drain_ack != lp->drain_req)) {
+    for (portid = 0; portid < APP_MAX_NIC_PORTS; portid ++) {
+      if (lp->rings_out[portid] != NULL) {
+        lp->drain_mark[portid] = lp->rings_out[portid]->prod.tail;
+      }
+    }
+    rte_smp_wmb();
+    lp->drain_ack = lp->drain_req;
+  }
 }
 
 void
 app_lcore_main_loop_worker(void *arg) {
   uint32_t lcore = rte_lcore_id();
-  struct app_lcore_params_worker *lp = &app.lcore_params[lcore].worker;
+  struct app_lcore_params *lcp = &app.lcore_params[lcore];
+  struct app_lcore_params_worker *lp = &lcp->worker;
   uint32_t bsz_rd = app.burst_size_worker_read;
   struct worker_arg warg;
   uint64_t i;
+  uint32_t n;
 
   if (!app.no_cache) {
     lp->cache = init_flowcache(app.kvs_type);
   }
   i = 0;
   warg.pkt = NULL;
+  app_lcore_idle_init(lcp);
   for (;;) {
     if (APP_LCORE_WORKER_FLUSH &&
         (unlikely(i == APP_LCORE_WORKER_FLUSH))) {
@@ -311,12 +342,23 @@ app_lcore_main_loop_worker(void *arg) {
         break;
       }
       flowdb_check_update(NULL);
+      bonding_lacp_tx_flush();
       app_lcore_worker_flush(lp);
       i = 0;
     }
-    app_lcore_worker(lp, bsz_rd, &warg);
+    n = app_lcore_worker(lp, bsz_rd, &warg);
+    if (unlikely(app_lcore_idle_check(lcp, n))) {
+      app_lcore_worker_flush(lp);
+      if (app_lcore_idle(lcp) == true) {
+        if (rte_atomic32_read(&dpdk_stop) != 0) {
+          break;
+        }
+        flowdb_check_update(NULL);
+      }
+    }
     i++;
   }
+  app_lcore_idle_fini(lcp);
 }
 
 /*
@@ -325,18 +367,21 @@ app_lcore_main_loop_worker(void *arg) {
 void
 app_lcore_main_loop_io_worker(void *arg) {
   uint32_t lcore = rte_lcore_id();
-  struct app_lcore_params_io *lp_io = &app.lcore_params[lcore].io;
-  struct app_lcore_params_worker *lp = &app.lcore_params[lcore].worker;
+  struct app_lcore_params *lcp = &app.lcore_params[lcore];
+  struct app_lcore_params_io *lp_io = &lcp->io;
+  struct app_lcore_params_worker *lp = &lcp->worker;
   uint32_t n_workers = app_get_lcores_worker();
   uint32_t bsz_rd = app.burst_size_worker_read;
   struct worker_arg warg;
   uint64_t i;
+  uint32_t n;
 
   if (!app.no_cache) {
     lp->cache = init_flowcache(app.kvs_type);
   }
   i = 0;
   warg.pkt = NULL;
+  app_lcore_idle_init(lcp);
   for (;;) {
     if (APP_LCORE_WORKER_FLUSH &&
         (unlikely(i == APP_LCORE_WORKER_FLUSH))) {
@@ -345,13 +390,25 @@ app_lcore_main_loop_io_worker(void *arg) {
       }
       app_lcore_io_flush(lp_io, n_workers, arg);
       flowdb_check_update(NULL);
+      bonding_lacp_tx_flush();
       app_lcore_worker_flush(lp);
       i = 0;
     }
-    app_lcore_io(lp_io, n_workers);
-    app_lcore_worker(lp, bsz_rd, &warg);
+    n = app_lcore_io(lp_io, n_workers);
+    n += app_lcore_worker(lp, bsz_rd, &warg);
+    if (unlikely(app_lcore_idle_check(lcp, n))) {
+      app_lcore_io_flush(lp_io, n_workers, arg);
+      app_lcore_worker_flush(lp);
+      if (app_lcore_idle(lcp) == true) {
+        if (rte_atomic32_read(&dpdk_stop) != 0) {
+          break;
+        }
+        flowdb_check_update(NULL);
+      }
+    }
     i++;
   }
+  app_lcore_idle_fini(lcp);
 }
 
 void
@@ -13,3 +13,608 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
+/**
+ *      @file   bonding.c
+ *      @brief  Link aggregation (static and IEEE 802.3ad LACP).
+ *
+ * Output to the bond is distributed by the slave array in struct
+ * bonding_tx, which is read by workers without lock.  LACP state
+ * machines are run by dp_timer and by received LACPDUs, and the array
+ * is rebuilt into the other buffer and switched atomically when the
+ * set of distributing slaves is changed.
+ *
+ * TX buffers of DPDK ports are owned by workers, so LACPDUs to DPDK
+ * slaves are queued by dp_timer and sent by a worker.
+ */
+
+#include "lagopus_config.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+
+#include "lagopus_apis.h"
+#include "lagopus/flowdb.h"
+#include "lagopus/interface.h"
+#include "lagopus/dataplane.h"
+#include "pktbuf.h"
+#include "packet.h"
+#include "dp_timer.h"
+#include "bonding.h"
+
+#define LACP_TLV_ACTOR          1
+#define LACP_TLV_PARTNER        2
+#define LACP_TLV_COLLECTOR      3
+#define LACP_TLV_INFO_LEN       20
+#define LACP_TLV_COLLECTOR_LEN  16
+
+#define LACP_SYSTEM_PRIORITY    0xffff
+#define LACP_PORT_PRIORITY      0xff
+#define LACP_KEY                1
+
+#ifndef BONDING_LACP_TXQ_MAX
+#define BONDING_LACP_TXQ_MAX    64
+#endif /* BONDING_LACP_TXQ_MAX */
+
+static const uint8_t lacp_slow_protocols_addr[ETHER_ADDR_LEN] = {
+  0x01, 0x80, 0xc2, 0x00, 0x00, 0x02
+};
+
+static pthread_once_t bonding_once = PTHREAD_ONCE_INIT;
+/* protects LACP state of all bonds and their timer entries. */
+static lagopus_mutex_t bonding_lock = NULL;
+
+/* LACPDUs waiting for a worker, protected by bonding_lock. */
+static struct {
+  struct lagopus_packet *pkt;
+  struct interface *ifp;
+} lacp_txq[BONDING_LACP_TXQ_MAX];
+static uint32_t lacp_ntxq = 0;
+
+static void
+bonding_once_proc(void) {
+  if (lagopus_mutex_create(&bonding_lock) != LAGOPUS_RESULT_OK) {
+    lagopus_exit_fatal("lagopus_mutex_create");
+  }
+}
+
+static inline time_t
+bonding_now(void) {
+  return get_current_time().tv_sec;
+}
+
+static inline bool
+bonding_same_system(const struct bonding_lacp_info *a,
+                    const struct bonding_lacp_info *b) {
+  return (a->system_priority == b->system_priority &&
+          memcmp(a->system, b->system, ETHER_ADDR_LEN) == 0 &&
+          a->key == b->key);
+}
+
+static inline bool
+bonding_same_port(const struct bonding_lacp_info *a,
+                  const struct bonding_lacp_info *b) {
+  return (bonding_same_system(a, b) == true &&
+          a->port_priority == b->port_priority &&
+          a->port == b->port);
+}
+
+static struct bonding_slave *
+bonding_slave_find(struct bonding *bond, struct interface *ifp) {
+  uint32_t i;
+
+  for (i = 0; i < bond->nslaves; i++) {
+    if (bond->slaves[i].ifp == ifp) {
+      return &bond->slaves[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Initialize actor information from the bond.
+ */
+static void
+bonding_actor_init(struct bonding *bond, struct bonding_slave *slave,
+                   uint16_t port) {
+  struct bonding_lacp_info *actor = &slave->actor;
+
+  actor->system_priority = htons(LACP_SYSTEM_PRIORITY);
+  memcpy(actor->system, bond->ifp->hw_addr, ETHER_ADDR_LEN);
+  actor->key = htons(bond->key);
+  actor->port_priority = htons(LACP_PORT_PRIORITY);
+  actor->port = htons(port);
+  actor->state = LACP_STATE_ACTIVITY | LACP_STATE_AGGREGATION;
+  if (bond->lacp_fast == true) {
+    actor->state |= LACP_STATE_TIMEOUT;
+  }
+}
+
+static inline bool
+bonding_slave_active(const struct bonding *bond,
+                     const struct bonding_slave *slave) {
+  if (slave->link_up == false) {
+    return false;
+  }
+  if (bond->mode == DP_BONDING_MODE_BALANCE_XOR) {
+    return true;
+  }
+  return (slave->mux_state == BONDING_MUX_COLLECTING_DISTRIBUTING &&
+          (slave->partner.state & LACP_STATE_COLLECTING) != 0);
+}
+
+/**
+ * Rebuild the slave array into the inactive buffer and switch to it.
+ * @param[in] bond Bond.
+ * @param[in] force Rebuild even if active slaves are not changed.
+ */
+static void
+bonding_tx_rebuild(struct bonding *bond, bool force) {
+  struct interface *active[BONDING_MAX_SLAVES];
+  struct bonding_tx *tx;
+  uint32_t i, n;
+
+  n = 0;
+  for (i = 0; i < bond->nslaves; i++) {
+    if (bonding_slave_active(bond, &bond->slaves[i]) == true) {
+      active[n++] = bond->slaves[i].ifp;
+    }
+  }
+  tx = bond->tx;
+  if (force == false && tx->n == n &&
+      memcmp(tx->slave, active, n * sizeof(active[0])) == 0) {
+    return;
+  }
+  tx = (tx == &bond->txbuf[0]) ? &bond->txbuf[1] : &bond->txbuf[0];
+  for (i = 0; i < BONDING_MAX_SLAVES; i++) {
+    tx->slave[i] = (n != 0) ? active[i % n] : NULL;
+  }
+  tx->n = n;
+  __atomic_store_n(&bond->tx, tx, __ATOMIC_RELEASE);
+  lagopus_msg_info("bond %s: %u of %u slaves active\n",
+                   bond->ifp->name != NULL ? bond->ifp->name : "",
+                   n, bond->nslaves);
+}
+
+/**
+ * Selection logic.  Slaves with the same partner system and key as
+ * the aggregator are attached, the aggregator follows the partner of
+ * the first current slave if no slave is attached.
+ */
+static void
+bonding_lacp_select(struct bonding *bond) {
+  static const struct bonding_lacp_info none;
+  struct bonding_slave *slave;
+  bool attached;
+  uint32_t i;
+
+  attached = false;
+  for (i = 0; i < bond->nslaves; i++) {
+    slave = &bond->slaves[i];
+    if (slave->rx_state == BONDING_RX_CURRENT &&
+        bonding_same_system(&slave->partner, &bond->aggregator) == true) {
+      attached = true;
+      break;
+    }
+  }
+  if (attached == false) {
+    bond->aggregator = none;
+  }
+  for (i = 0; i < bond->nslaves; i++) {
+    slave = &bond->slaves[i];
+    slave->selected = false;
+    if (slave->rx_state != BONDING_RX_CURRENT ||
+        (slave->partner.state & LACP_STATE_AGGREGATION) == 0) {
+      continue;
+    }
+    if (bonding_same_system(&bond->aggregator, &none) == true) {
+      bond->aggregator = slave->partner;
+    }
+    slave->selected = bonding_same_system(&slave->partner,
+                                          &bond->aggregator);
+  }
+}
+
+/**
+ * Mux machine.
+ */
+static void
+bonding_lacp_mux(struct bonding_slave *slave) {
+  uint8_t state;
+
+  state = slave->actor.state &
+          (uint8_t)~(LACP_STATE_SYNC |
+                     LACP_STATE_COLLECTING |
+                     LACP_STATE_DISTRIBUTING);
+  if (slave->selected == false) {
+    slave->mux_state = BONDING_MUX_DETACHED;
+  } else if ((slave->partner.state & LACP_STATE_SYNC) == 0) {
+    slave->mux_state = BONDING_MUX_ATTACHED;
+    state |= LACP_STATE_SYNC;
+  } else {
+    slave->mux_state = BONDING_MUX_COLLECTING_DISTRIBUTING;
+    state |= LACP_STATE_SYNC | LACP_STATE_COLLECTING | LACP_STATE_DISTRIBUTING;
+  }
+  if (state != slave->actor.state) {
+    slave->actor.state = state;
+    slave->ntt = true;
+  }
+}
+
+static void
+bonding_update(struct bonding *bond, bool force) {
+  uint32_t i;
+
+  if (bond->mode == DP_BONDING_MODE_8023AD) {
+    bonding_lacp_select(bond);
+    for (i = 0; i < bond->nslaves; i++) {
+      bonding_lacp_mux(&bond->slaves[i]);
+    }
+  }
+  bonding_tx_rebuild(bond, force);
+}
+
+/**
+ * Partner information is expired, wait short timeout before defaulted.
+ */
+static void
+bonding_lacp_expire(struct bonding_slave *slave, time_t now) {
+  slave->rx_state = BONDING_RX_EXPIRED;
+  slave->partner.state &= (uint8_t)~LACP_STATE_SYNC;
+  slave->partner.state |= LACP_STATE_TIMEOUT;
+  slave->actor.state |= LACP_STATE_EXPIRED;
+  slave->current_while = now + BONDING_SHORT_TIMEOUT;
+  slave->ntt = true;
+}
+
+/**
+ * Drop queued LACPDUs of the slave.
+ */
+static void
+bonding_lacp_txq_purge(struct interface *ifp) {
+  uint32_t i, n;
+
+  n = 0;
+  for (i = 0; i < lacp_ntxq; i++) {
+    if (lacp_txq[i].ifp == ifp) {
+      lagopus_packet_free(lacp_txq[i].pkt);
+    } else {
+      lacp_txq[n++] = lacp_txq[i];
+    }
+  }
+  __atomic_store_n(&lacp_ntxq, n, __ATOMIC_RELAXED);
+}
+
+static bool
+bonding_lacp_send(struct bonding_slave *slave) {
+  struct lagopus_packet *pkt;
+  struct bonding_lacpdu *pdu;
+
+  pkt = alloc_lagopus_packet();
+  if (pkt == NULL) {
+    return false;
+  }
+  pdu = (struct bonding_lacpdu *)OS_M_APPEND(PKT2MBUF(pkt), sizeof(*pdu));
+  memset(pdu, 0, sizeof(*pdu));
+  memcpy(pdu->dst, lacp_slow_protocols_addr, ETHER_ADDR_LEN);
+  memcpy(pdu->src, slave->ifp->hw_addr, ETHER_ADDR_LEN);
+  pdu->ether_type = htons(LACP_ETHERTYPE);
+  pdu->subtype = LACP_SUBTYPE;
+  pdu->version = LACP_VERSION;
+  pdu->actor_type = LACP_TLV_ACTOR;
+  pdu->actor_len = LACP_TLV_INFO_LEN;
+  pdu->actor = slave->actor;
+  pdu->partner_type = LACP_TLV_PARTNER;
+  pdu->partner_len = LACP_TLV_INFO_LEN;
+  pdu->partner = slave->partner;
+  pdu->collector_type = LACP_TLV_COLLECTOR;
+  pdu->collector_len = LACP_TLV_COLLECTOR_LEN;
+  pkt->flags = 0;
+  pkt->ether_type = LACP_ETHERTYPE;
+  switch (slave->ifp->info.type) {
+#ifdef HAVE_DPDK
+    case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_PHY:
+    case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_VDEV:
+      if (lacp_ntxq == BONDING_LACP_TXQ_MAX) {
+        lagopus_packet_free(pkt);
+        return false;
+      }
+      lacp_txq[lacp_ntxq].pkt = pkt;
+      lacp_txq[lacp_ntxq].ifp = slave->ifp;
+      __atomic_store_n(&lacp_ntxq, lacp_ntxq + 1, __ATOMIC_RELAXED);
+      return true;
+#endif /* HAVE_DPDK */
+    default:
+      (void)lagopus_send_packet_physical(pkt, slave->ifp);
+      return true;
+  }
+}
+
+void
+bonding_lacp_tx_flush(void) {
+  uint32_t i;
+
+  if (__atomic_load_n(&lacp_ntxq, __ATOMIC_RELAXED) == 0) {
+    return;
+  }
+  /* never block the worker, try again at next flush. */
+  if (lagopus_mutex_trylock(&bonding_lock) != LAGOPUS_RESULT_OK) {
+    return;
+  }
+  for (i = 0; i < lacp_ntxq; i++) {
+    (void)lagopus_send_packet_physical(lacp_txq[i].pkt, lacp_txq[i].ifp);
+  }
+  __atomic_store_n(&lacp_ntxq, 0, __ATOMIC_RELAXED);
+  lagopus_mutex_unlock(&bonding_lock);
+}
+
+void
+bonding_lacp_tick(struct bonding *bond, time_t now) {
+  struct bonding_slave *slave;
+  bool link_up;
+  uint32_t i;
+
+  for (i = 0; i < bond->nslaves; i++) {
+    slave = &bond->slaves[i];
+    if (dp_interface_link_status_get_internal(slave->ifp,
+                                              &link_up) != LAGOPUS_RESULT_OK) {
+      link_up = false;
+    }
+    slave->link_up = link_up;
+    if (link_up == false) {
+      slave->rx_state = BONDING_RX_DISABLED;
+      slave->partner.state &= (uint8_t)~LACP_STATE_SYNC;
+      continue;
+    }
+    switch (slave->rx_state) {
+      case BONDING_RX_DISABLED:
+        bonding_lacp_expire(slave, now);
+        break;
+      case BONDING_RX_CURRENT:
+        if (now >= slave->current_while) {
+          bonding_lacp_expire(slave, now);
+        }
+        break;
+      case BONDING_RX_EXPIRED:
+        if (now >= slave->current_while) {
+          slave->rx_state = BONDING_RX_DEFAULTED;
+          memset(&slave->partner, 0, sizeof(slave->partner));
+          slave->actor.state &= (uint8_t)~LACP_STATE_EXPIRED;
+          slave->actor.state |= LACP_STATE_DEFAULTED;
+        }
+        break;
+      case BONDING_RX_DEFAULTED:
+      default:
+        break;
+    }
+  }
+  bonding_update(bond, false);
+
+  if (bond->mode != DP_BONDING_MODE_8023AD) {
+    return;
+  }
+  for (i = 0; i < bond->nslaves; i++) {
+    slave = &bond->slaves[i];
+    if (slave->link_up == false) {
+      continue;
+    }
+    if ((slave->ntt == true || now >= slave->periodic) &&
+        bonding_lacp_send(slave) == true) {
+      slave->ntt = false;
+      slave->periodic = now +
+                        ((slave->partner.state & LACP_STATE_TIMEOUT) != 0 ?
+                         BONDING_FAST_PERIODIC : BONDING_SLOW_PERIODIC);
+    }
+  }
+}
+
+bool
+bonding_slave_input(struct interface *slave, const uint8_t *frame,
+                    size_t len) {
+  const struct bonding_lacpdu *pdu;
+  struct bonding *bond;
+  struct bonding_slave *s;
+
+  pdu = (const struct bonding_lacpdu *)frame;
+  if (len < offsetof(struct bonding_lacpdu, subtype) + 1 ||
+      pdu->ether_type != htons(LACP_ETHERTYPE)) {
+    return false;
+  }
+  if (len < offsetof(struct bonding_lacpdu, collector_type) ||
+      pdu->subtype != LACP_SUBTYPE ||
+      pdu->actor_type != LACP_TLV_ACTOR ||
+      pdu->partner_type != LACP_TLV_PARTNER) {
+    /* marker protocol or broken LACPDU, drop. */
+    return true;
+  }
+
+  /*
+   * never block the worker.  A dropped LACPDU is harmless, the partner
+   * sends one every periodic time and the timeout is three of them.
+   */
+  if (lagopus_mutex_trylock(&bonding_lock) != LAGOPUS_RESULT_OK) {
+    return true;
+  }
+  if (slave->master == NULL ||
+      (bond = slave->master->bond) == NULL ||
+      bond->mode != DP_BONDING_MODE_8023AD ||
+      (s = bonding_slave_find(bond, slave)) == NULL) {
+    goto out;
+  }
+  /* record partner information. */
+  s->partner = pdu->actor;
+  if (bonding_same_port(&pdu->partner, &s->actor) == false) {
+    /* partner does not know us yet. */
+    s->partner.state &= (uint8_t)~LACP_STATE_SYNC;
+  }
+  if (memcmp(&pdu->partner, &s->actor, sizeof(s->actor)) != 0) {
+    s->ntt = true;
+  }
+  s->rx_state = BONDING_RX_CURRENT;
+  s->actor.state &= (uint8_t)~(LACP_STATE_EXPIRED | LACP_STATE_DEFAULTED);
+  s->current_while = bonding_now() +
+                     ((s->actor.state & LACP_STATE_TIMEOUT) != 0 ?
+                      BONDING_SHORT_TIMEOUT : BONDING_LONG_TIMEOUT);
+  bonding_update(bond, false);
+out:
+  lagopus_mutex_unlock(&bonding_lock);
+  return true;
+}
+
+static void
+bonding_timer_expire(struct dp_timer *dp_timer) {
+  struct bonding *bond;
+  time_t now;
+  int i;
+
+  now = bonding_now();
+  lagopus_mutex_lock(&bonding_lock);
+  for (i = 0; i < dp_timer->nentries; i++) {
+    bond = dp_timer->timer_entry[i];
+    if (bond == NULL) {
+      continue;
+    }
+    bonding_lacp_tick(bond, now);
+    /* timer reset */
+    add_bonding_timer(bond);
+  }
+  lagopus_mutex_unlock(&bonding_lock);
+}
+
+lagopus_result_t
+add_bonding_timer(struct bonding *bond) {
+  bond->timer = add_dp_timer(BONDING_TIMER, BONDING_INTERVAL,
+                             bonding_timer_expire, bond);
+  if (bond->timer == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  return LAGOPUS_RESULT_OK;
+}
+
+struct bonding *
+bonding_alloc(struct interface *ifp,
+              enum dp_bonding_mode mode,
+              enum dp_bonding_xmit_hash xmit_hash) {
+  struct bonding *bond;
+
+  (void)pthread_once(&bonding_once, bonding_once_proc);
+  bond = calloc(1, sizeof(struct bonding));
+  if (bond == NULL) {
+    return NULL;
+  }
+  bond->ifp = ifp;
+  bond->mode = mode;
+  bond->xmit_hash = xmit_hash;
+  bond->key = LACP_KEY;
+  bond->tx = &bond->txbuf[0];
+  lagopus_mutex_lock(&bonding_lock);
+  if (add_bonding_timer(bond) != LAGOPUS_RESULT_OK) {
+    lagopus_mutex_unlock(&bonding_lock);
+    free(bond);
+    return NULL;
+  }
+  lagopus_mutex_unlock(&bonding_lock);
+  ifp->bond = bond;
+  return bond;
+}
+
+void
+bonding_free(struct bonding *bond) {
+  uint32_t i;
+
+  lagopus_mutex_lock(&bonding_lock);
+  if (bond->timer != NULL) {
+    *bond->timer = NULL;
+  }
+  for (i = 0; i < bond->nslaves; i++) {
+    bonding_lacp_txq_purge(bond->slaves[i].ifp);
+  }
+  lagopus_mutex_unlock(&bonding_lock);
+  for (i = 0; i < bond->nslaves; i++) {
+    bond->slaves[i].ifp->master = NULL;
+  }
+  bond->ifp->bond = NULL;
+  free(bond);
+}
+
+lagopus_result_t
+bonding_slave_add(struct bonding *bond, struct interface *slave) {
+  struct bonding_slave *s;
+  uint16_t port;
+  uint32_t i;
+
+  if (slave == bond->ifp || slave->bond != NULL ||
+      slave->master != NULL || slave->port != NULL) {
+    return LAGOPUS_RESULT_BUSY;
+  }
+  if (bond->nslaves >= BONDING_MAX_SLAVES) {
+    return LAGOPUS_RESULT_TOO_MANY_OBJECTS;
+  }
+  lagopus_mutex_lock(&bonding_lock);
+  if (bond->nslaves == 0) {
+    /* bond and LACP system use address of the first slave. */
+    memcpy(bond->ifp->hw_addr, slave->hw_addr, ETHER_ADDR_LEN);
+  }
+  /* smallest unused port number. */
+  for (port = 1; ; port++) {
+    for (i = 0; i < bond->nslaves; i++) {
+      if (bond->slaves[i].actor.port == htons(port)) {
+        break;
+      }
+    }
+    if (i == bond->nslaves) {
+      break;
+    }
+  }
+  s = &bond->slaves[bond->nslaves++];
+  memset(s, 0, sizeof(*s));
+  s->ifp = slave;
+  s->rx_state = BONDING_RX_DISABLED;
+  s->mux_state = BONDING_MUX_DETACHED;
+  bonding_actor_init(bond, s, port);
+  slave->master = bond->ifp;
+  (void)dp_interface_link_status_get_internal(slave, &s->link_up);
+  bonding_update(bond, false);
+  lagopus_mutex_unlock(&bonding_lock);
+  return LAGOPUS_RESULT_OK;
+}
+
+lagopus_result_t
+bonding_slave_delete(struct bonding *bond, struct interface *slave) {
+  struct bonding_slave *s;
+
+  lagopus_mutex_lock(&bonding_lock);
+  s = bonding_slave_find(bond, slave);
+  if (s == NULL) {
+    lagopus_mutex_unlock(&bonding_lock);
+    return LAGOPUS_RESULT_NOT_FOUND;
+  }
+  *s = bond->slaves[--bond->nslaves];
+  slave->master = NULL;
+  bonding_lacp_txq_purge(slave);
+  /* rebuild both buffers not to refer the deleted slave. */
+  bonding_update(bond, true);
+  bonding_tx_rebuild(bond, true);
+  lagopus_mutex_unlock(&bonding_lock);
+  return LAGOPUS_RESULT_OK;
+}
+
+void
+bonding_lacp_rate_set(struct bonding *bond, bool fast) {
+  uint32_t i;
+
+  lagopus_mutex_lock(&bonding_lock);
+  bond->lacp_fast = fast;
+  for (i = 0; i < bond->nslaves; i++) {
+    if (fast == true) {
+      bond->slaves[i].actor.state |= LACP_STATE_TIMEOUT;
+    } else {
+      bond->slaves[i].actor.state &= (uint8_t)~LACP_STATE_TIMEOUT;
+    }
+    bond->slaves[i].ntt = true;
+  }
+  lagopus_mutex_unlock(&bonding_lock);
+}
@@ -14,7 +14,211 @@
  * limitations under the License.
  */
 
+/**
+ *      @file   bonding.h
+ *      @brief  Link aggregation (static and IEEE 802.3ad LACP).
+ */
+
 #ifndef SRC_DATAPLANE_MGR_BONDING_H_
 #define SRC_DATAPLANE_MGR_BONDING_H_
 
-#endif /* SRC_DPMGR_BONDING_H_ */
+#include <time.h>
+
+#include "lagopus_apis.h"
+#include "lagopus/dp_apis.h"
+#include "lagopus/interface.h"
+
+#ifndef BONDING_MAX_SLAVES
+#define BONDING_MAX_SLAVES      16      /**< max slaves per bond. */
+#endif /* BONDING_MAX_SLAVES */
+
+#define BONDING_INTERVAL        1       /**< state machine tick(sec). */
+#define BONDING_FAST_PERIODIC   1       /**< LACPDU interval(fast, sec). */
+#define BONDING_SLOW_PERIODIC   30      /**< LACPDU interval(slow, sec). */
+#define BONDING_SHORT_TIMEOUT   3       /**< partner timeout(fast, sec). */
+#define BONDING_LONG_TIMEOUT    90      /**< partner timeout(slow, sec). */
+
+#define LACP_ETHERTYPE          0x8809  /**< slow protocols. */
+#define LACP_SUBTYPE            1
+#define LACP_VERSION            1
+
+/* LACP actor/partner state bits. */
+#define LACP_STATE_ACTIVITY     0x01
+#define LACP_STATE_TIMEOUT      0x02    /**< short timeout. */
+#define LACP_STATE_AGGREGATION  0x04
+#define LACP_STATE_SYNC         0x08
+#define LACP_STATE_COLLECTING   0x10
+#define LACP_STATE_DISTRIBUTING 0x20
+#define LACP_STATE_DEFAULTED    0x40
+#define LACP_STATE_EXPIRED      0x80
+
+/**
+ * Actor or partner information in LACPDU, in network byte order.
+ */
+struct bonding_lacp_info {
+  uint16_t system_priority;
+  uint8_t system[ETHER_ADDR_LEN];
+  uint16_t key;
+  uint16_t port_priority;
+  uint16_t port;
+  uint8_t state;
+} __attribute__((__packed__));
+
+/**
+ * LACPDU including ethernet header.
+ */
+struct bonding_lacpdu {
+  uint8_t dst[ETHER_ADDR_LEN];
+  uint8_t src[ETHER_ADDR_LEN];
+  uint16_t ether_type;
+  uint8_t subtype;
+  uint8_t version;
+  uint8_t actor_type;
+  uint8_t actor_len;
+  struct bonding_lacp_info actor;
+  uint8_t actor_reserved[3];
+  uint8_t partner_type;
+  uint8_t partner_len;
+  struct bonding_lacp_info partner;
+  uint8_t partner_reserved[3];
+  uint8_t collector_type;
+  uint8_t collector_len;
+  uint16_t collector_max_delay;
+  uint8_t collector_reserved[12];
+  uint8_t terminator_type;
+  uint8_t terminator_len;
+  uint8_t terminator_reserved[50];
+} __attribute__((__packed__));
+
+/**
+ * LACP receive machine state.
+ */
+enum bonding_rx_state {
+  BONDING_RX_DISABLED,          /**< link down. */
+  BONDING_RX_EXPIRED,           /**< partner information is expiring. */
+  BONDING_RX_DEFAULTED,         /**< no partner. */
+  BONDING_RX_CURRENT,           /**< partner information is up to date. */
+};
+
+/**
+ * LACP mux machine state.
+ */
+enum bonding_mux_state {
+  BONDING_MUX_DETACHED,
+  BONDING_MUX_ATTACHED,
+  BONDING_MUX_COLLECTING_DISTRIBUTING,
+};
+
+/**
+ * Slave of the bond.
+ */
+struct bonding_slave {
+  struct interface *ifp;
+  bool link_up;
+  bool selected;                        /**< attached to the aggregator. */
+  bool ntt;                             /**< need to transmit LACPDU. */
+  enum bonding_rx_state rx_state;
+  enum bonding_mux_state mux_state;
+  struct bonding_lacp_info actor;
+  struct bonding_lacp_info partner;
+  time_t current_while;                 /**< partner information expiry. */
+  time_t periodic;                      /**< next periodic LACPDU. */
+};
+
+/**
+ * Transmit slave array.
+ * Every entry is filled by repeating the n active slaves, so that
+ * the slave is chosen by a single index even if n is read from a
+ * buffer being rebuilt.
+ */
+struct bonding_tx {
+  uint32_t n;
+  struct interface *slave[BONDING_MAX_SLAVES];
+};
+
+/**
+ * Bond, attached to the interface of the bond port.
+ */
+struct bonding {
+  struct interface *ifp;                /**< bond interface. */
+  enum dp_bonding_mode mode;
+  enum dp_bonding_xmit_hash xmit_hash;
+  bool lacp_fast;                       /**< request fast LACPDU rate. */
+  uint16_t key;                         /**< actor key of the aggregator. */
+  struct bonding_lacp_info aggregator;  /**< partner of the aggregator. */
+  uint32_t nslaves;
+  struct bonding_slave slaves[BONDING_MAX_SLAVES];
+  struct bonding_tx *tx;                /**< active slave array. */
+  struct bonding_tx txbuf[2];           /**< double buffer of tx. */
+  void **timer;                         /**< dp_timer entry. */
+};
+
+/**
+ * Select slave interface to transmit packet.
+ * Lock-free, the array is replaced atomically by failover.
+ * @param[in] bond Bond.
+ * @param[in] hash Hash of the packet.
+ * @retval slave interface or NULL if no slave is active.
+ */
+static inline struct interface *
+bonding_tx_slave(struct bonding *bond, uint32_t hash) {
+  const struct bonding_tx *tx;
+  uint32_t n;
+
+  tx = __atomic_load_n(&bond->tx, __ATOMIC_ACQUIRE);
+  n = __atomic_load_n(&tx->n, __ATOMIC_RELAXED);
+  if (n == 0) {
+    return NULL;
+  }
+  return __atomic_load_n(&tx->slave[hash % n], __ATOMIC_RELAXED);
+}
+
+struct bonding *
+bonding_alloc(struct interface *ifp,
+              enum dp_bonding_mode mode,
+              enum dp_bonding_xmit_hash xmit_hash);
+
+void
+bonding_free(struct bonding *bond);
+
+lagopus_result_t
+bonding_slave_add(struct bonding *bond, struct interface *slave);
+
+lagopus_result_t
+bonding_slave_delete(struct bonding *bond, struct interface *slave);
+
+void
+bonding_lacp_rate_set(struct bonding *bond, bool fast);
+
+/**
+ * Run state machines of all slaves.
+ * Called from dp_timer every BONDING_INTERVAL seconds.
+ * @param[in] bond Bond.
+ * @param[in] now Current time.
+ */
+void
+bonding_lacp_tick(struct bonding *bond, time_t now);
+
+/**
+ * Send LACPDUs queued for DPDK slaves.
+ * Called by workers, LACPDUs are sent through the TX buffer of the
+ * calling worker.
+ */
+void
+bonding_lacp_tx_flush(void);
+
+/**
+ * Receive slow protocol frame from slave interface.
+ * Called by workers, it never blocks.  A LACPDU received while the
+ * LACP state is locked is dropped.
+ * @param[in] slave Slave interface.
+ * @param[in] frame Received frame.
+ * @param[in] len Length of the frame.
+ * @retval true frame is slow protocol and consumed, caller frees it.
+ * @retval false frame is not slow protocol.
+ */
+bool
+bonding_slave_input(struct interface *slave, const uint8_t *frame,
+                    size_t len);
+
+#endif /* SRC_DATAPLANE_MGR_BONDING_H_ */
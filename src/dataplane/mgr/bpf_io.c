@@ -393,6 +393,20 @@ rawsock_get_stats(struct interface *ifp, datastore_interface_stats_t *stats) {
   return LAGOPUS_RESULT_OK;
 }
 
+lagopus_result_t
+rawsock_get_link_status(struct interface *ifp, bool *link_up) {
+  struct ifreq ifreq;
+
+  snprintf(ifreq.ifr_name, sizeof(ifreq.ifr_name),
+           "%s", ifp->info.eth_rawsock.device);
+  if (ioctl(pollfd[ifp->info.eth_rawsock.port_number].fd, SIOCGIFFLAGS, &ifreq) != 0) {
+    lagopus_msg_warning("%s\n", strerror(errno));
+    return LAGOPUS_RESULT_ANY_FAILURES;
+  }
+  *link_up = (ifreq.ifr_flags & (IFF_UP|IFF_RUNNING)) == (IFF_UP|IFF_RUNNING);
+  return LAGOPUS_RESULT_OK;
+}
+
 lagopus_result_t
 rawsock_clear_stats(struct interface *ifp) {
   (void) ifp;
@@ -461,6 +475,7 @@ dp_bpf_thread_loop(__UNUSED const lagopus_thread_t *selfptr, void *arg) {
     if (poll(pollfd, (nfds_t)portidx, 100) < 0) {
       err(errno, "poll");
     }
+    dp_clock_update();
     for (i = 0; i < portidx; i++) {
 #ifndef HAVE_DPDK
       if (clear_cache == true && flowcache != NULL) {
@@ -569,6 +584,7 @@ dp_rawsock_thread_init(int argc,
   }
   lagopus_meter_init();
   lagopus_register_action_hook = lagopus_set_action_function;
+  lagopus_register_action_list_hook = lagopus_set_action_list_function;
   lagopus_register_instruction_hook = lagopus_set_instruction_function;
   flowinfo_init();
 
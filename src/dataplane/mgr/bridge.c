@@ -333,6 +333,17 @@ bridge_mactable_max_entries_set(struct bridge *bridge, uint16_t max_entries) {
   return LAGOPUS_RESULT_OK;
 }
 
+/**
+ * Set max entries per VLAN of the mac table.
+ */
+lagopus_result_t
+bridge_mactable_vlan_max_entries_set(struct bridge *bridge,
+                                     uint32_t max_entries) {
+  mactable_vlan_max_entries_set(&bridge->mactable, max_entries);
+
+  return LAGOPUS_RESULT_OK;
+}
+
 /**
  * Update entry in the mac table.
  */
@@ -380,30 +391,6 @@ mac_addr_to_str(uint64_t mac, char *macstr) {
           str[5], str[4], str[3], str[2], str[1], str[0]);
 }
 
-static bool
-get_macentry(void *key, void *val, lagopus_hashentry_t he, void *arg) {
-  bool result = false;
-  char macstr[18];
-  struct mactable_args *ma = (struct mactable_args *)arg;
-  struct macentry *entries = (struct macentry *)ma->entries;
-  struct macentry *entry = (struct macentry *)val;
-  (void) he;
-  (void) key;
-
-  if (entry != NULL && (val != NULL || ma->no < ma->num)) {
-    entries[ma->no].inteth = entry->inteth;
-    entries[ma->no].portid = entry->portid;
-    entries[ma->no].update_time = entry->update_time;
-    entries[ma->no].address_type = entry->address_type;
-    ma->no++;
-    result = true;
-  } else {
-    result = false;
-  }
-
-  return result;
-}
-
 lagopus_result_t
 bridge_mactable_entries_get(struct bridge *bridge,
                             struct macentry *entries,
@@ -412,15 +399,8 @@ bridge_mactable_entries_get(struct bridge *bridge,
   char macstr[18]; //debug
 
   lagopus_result_t result;
-  struct mactable_args ma;
-  struct mactable *mactable = &bridge->mactable;
-  lagopus_hashmap_t *hashmap;
-  hashmap = &mactable->hashmap[__sync_add_and_fetch(&mactable->read_table, 0)];
 
-  ma.entries = entries;
-  ma.num = num;
-  ma.no = 0;
-  result = lagopus_hashmap_iterate(hashmap, get_macentry, &ma);
+  result = mactable_entries_get(&bridge->mactable, entries, num);
 
   if (result == LAGOPUS_RESULT_OK) {
   } else {
@@ -443,11 +423,7 @@ bridge_mactable_entries_get(struct bridge *bridge,
 
 unsigned int
 bridge_mactable_num_entries_get(struct bridge *bridge) {
-  struct mactable *mactable = &bridge->mactable;
-  lagopus_hashmap_t *hashmap;
-  hashmap = &mactable->hashmap[__sync_add_and_fetch(&mactable->read_table, 0)];
-
-  return (unsigned int)lagopus_hashmap_size(hashmap);
+  return mactable_num_entries_get(&bridge->mactable);
 }
 
 lagopus_result_t
@@ -461,6 +437,19 @@ bridge_mactable_max_entries_get(struct bridge *bridge, uint32_t *max_entries) {
   *max_entries = mactable_max_entries_get(&bridge->mactable);
   return LAGOPUS_RESULT_OK;
 }
+
+lagopus_result_t
+bridge_mactable_vlan_max_entries_get(struct bridge *bridge,
+                                     uint32_t *max_entries) {
+  *max_entries = mactable_vlan_max_entries_get(&bridge->mactable);
+  return LAGOPUS_RESULT_OK;
+}
+
+lagopus_result_t
+bridge_mactable_moves_get(struct bridge *bridge, uint64_t *moves) {
+  *moves = mactable_moves_get(&bridge->mactable);
+  return LAGOPUS_RESULT_OK;
+}
 #endif /* HYBRID */
 
 /**
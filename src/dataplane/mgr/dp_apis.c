@@ -34,11 +34,13 @@
 #endif /* HYBRID */
 
 #include "lock.h"
+#include "bonding.h"
 
 struct dp_bridge_iter {
   struct flowdb *flowdb;
   int table_id;
-  int flow_idx;
+  int32_t priority;     /* priority of the last visited flow. */
+  uint64_t seq;         /* seq of the last visited flow, 0 if none. */
 };
 
 static lagopus_hashmap_t interface_hashmap;
@@ -422,6 +424,129 @@ dp_interface_stats_clear(const char *name) {
   return dp_interface_stats_clear_internal(ifp);
 }
 
+/*
+ * bonding API
+ */
+
+lagopus_result_t
+dp_bonding_create(const char *name,
+                  enum dp_bonding_mode mode,
+                  enum dp_bonding_xmit_hash xmit_hash) {
+  struct interface *ifp;
+  lagopus_result_t rv;
+
+  flowdb_wrlock(NULL);
+  rv = lagopus_hashmap_find(&interface_hashmap, (void *)name, (void **)&ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  if (ifp->bond != NULL) {
+    rv = LAGOPUS_RESULT_ALREADY_EXISTS;
+    goto out;
+  }
+  if (ifp->master != NULL ||
+      ifp->info.type != DATASTORE_INTERFACE_TYPE_UNKNOWN) {
+    rv = LAGOPUS_RESULT_BUSY;
+    goto out;
+  }
+  if (bonding_alloc(ifp, mode, xmit_hash) == NULL) {
+    rv = LAGOPUS_RESULT_NO_MEMORY;
+  }
+out:
+  flowdb_wrunlock(NULL);
+  return rv;
+}
+
+lagopus_result_t
+dp_bonding_destroy(const char *name) {
+  struct interface *ifp;
+  lagopus_result_t rv;
+
+  flowdb_wrlock(NULL);
+  rv = lagopus_hashmap_find(&interface_hashmap, (void *)name, (void **)&ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  if (ifp->bond == NULL) {
+    rv = LAGOPUS_RESULT_INVALID_OBJECT;
+    goto out;
+  }
+  bonding_free(ifp->bond);
+out:
+  flowdb_wrunlock(NULL);
+  return rv;
+}
+
+lagopus_result_t
+dp_bonding_slave_add(const char *name, const char *slave) {
+  struct interface *ifp, *slave_ifp;
+  lagopus_result_t rv;
+
+  flowdb_wrlock(NULL);
+  rv = lagopus_hashmap_find(&interface_hashmap, (void *)name, (void **)&ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  rv = lagopus_hashmap_find(&interface_hashmap,
+                            (void *)slave, (void **)&slave_ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  if (ifp->bond == NULL) {
+    rv = LAGOPUS_RESULT_INVALID_OBJECT;
+    goto out;
+  }
+  rv = bonding_slave_add(ifp->bond, slave_ifp);
+out:
+  flowdb_wrunlock(NULL);
+  return rv;
+}
+
+lagopus_result_t
+dp_bonding_slave_delete(const char *name, const char *slave) {
+  struct interface *ifp, *slave_ifp;
+  lagopus_result_t rv;
+
+  flowdb_wrlock(NULL);
+  rv = lagopus_hashmap_find(&interface_hashmap, (void *)name, (void **)&ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  rv = lagopus_hashmap_find(&interface_hashmap,
+                            (void *)slave, (void **)&slave_ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  if (ifp->bond == NULL) {
+    rv = LAGOPUS_RESULT_INVALID_OBJECT;
+    goto out;
+  }
+  rv = bonding_slave_delete(ifp->bond, slave_ifp);
+out:
+  flowdb_wrunlock(NULL);
+  return rv;
+}
+
+lagopus_result_t
+dp_bonding_lacp_rate_set(const char *name, bool fast) {
+  struct interface *ifp;
+  lagopus_result_t rv;
+
+  flowdb_wrlock(NULL);
+  rv = lagopus_hashmap_find(&interface_hashmap, (void *)name, (void **)&ifp);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+  if (ifp->bond == NULL) {
+    rv = LAGOPUS_RESULT_INVALID_OBJECT;
+    goto out;
+  }
+  bonding_lacp_rate_set(ifp->bond, fast);
+out:
+  flowdb_wrunlock(NULL);
+  return rv;
+}
+
 /*
  * port API
  */
@@ -740,6 +865,8 @@ dp_bridge_create(const char *name,
   bridge->l2_bridge = info->l2_bridge;
   bridge_mactable_ageing_time_set(bridge, info->mactable_ageing_time);
   bridge_mactable_max_entries_set(bridge, info->mactable_max_entries);
+  bridge_mactable_vlan_max_entries_set(bridge,
+                                       info->mactable_vlan_max_entries);
 #endif /* HYBRID */
 
   /* other parameter is just ignored. */
@@ -947,6 +1074,37 @@ out:
   return rv;
 }
 
+lagopus_result_t
+dp_bridge_mactable_vlan_max_entries_get(const char *name,
+                                        uint32_t *max_entries) {
+  struct bridge *bridge;
+  lagopus_result_t rv;
+
+  bridge = dp_bridge_lookup(name);
+  if (bridge != NULL) {
+    rv = bridge_mactable_vlan_max_entries_get(bridge, max_entries);
+  } else {
+    rv = LAGOPUS_RESULT_NOT_FOUND;
+  }
+
+  return rv;
+}
+
+lagopus_result_t
+dp_bridge_mactable_moves_get(const char *name, uint64_t *moves) {
+  struct bridge *bridge;
+  lagopus_result_t rv;
+
+  bridge = dp_bridge_lookup(name);
+  if (bridge != NULL) {
+    rv = bridge_mactable_moves_get(bridge, moves);
+  } else {
+    rv = LAGOPUS_RESULT_NOT_FOUND;
+  }
+
+  return rv;
+}
+
 #endif /* HYBRID */
 
 lagopus_result_t
@@ -1135,7 +1293,8 @@ dp_bridge_flow_iter_create(const char *name, uint8_t table_id,
   }
   iter->flowdb = bridge->flowdb;
   iter->table_id = table_id;
-  iter->flow_idx = 0;
+  iter->priority = 0;
+  iter->seq = 0;
 
   *iterp = iter;
   return LAGOPUS_RESULT_OK;
@@ -1145,18 +1304,63 @@ lagopus_result_t
 dp_bridge_flow_iter_get(dp_bridge_iter_t iter, struct flow **flowp) {
   struct table *table;
   struct flow_list *flow_list;
+  struct flow *flow;
+  int i;
 
   table = table_lookup(iter->flowdb, iter->table_id);
   if (table != NULL) {
     flow_list = table->flow_list;
-    if (iter->flow_idx < flow_list->nflow) {
-      *flowp = flow_list->flows[iter->flow_idx++];
+    i = flow_list_resume_position(flow_list, iter->priority, iter->seq);
+    if (i < flow_list->nflow) {
+      flow = flow_list->flows[i];
+      iter->priority = flow->priority;
+      iter->seq = flow->seq;
+      *flowp = flow;
       return LAGOPUS_RESULT_OK;
     }
   }
   return LAGOPUS_RESULT_EOF;
 }
 
+lagopus_result_t
+dp_bridge_flow_iter_walk(dp_bridge_iter_t iter,
+                         dp_bridge_flow_proc_t proc, void *arg) {
+  struct table *table;
+  struct flow_list *flow_list;
+  struct flow *flow;
+  lagopus_result_t rv;
+  int i, n;
+
+  if (iter == NULL || proc == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  rv = LAGOPUS_RESULT_EOF;
+
+  flowdb_rdlock(iter->flowdb);
+  table = table_lookup(iter->flowdb, (uint8_t)iter->table_id);
+  if (table != NULL) {
+    flow_list = table->flow_list;
+    i = flow_list_resume_position(flow_list, iter->priority, iter->seq);
+    for (n = 0; i < flow_list->nflow; i++, n++) {
+      if (n == DP_BRIDGE_FLOW_ITER_CHUNK) {
+        rv = LAGOPUS_RESULT_OK;
+        break;
+      }
+      flow = flow_list->flows[i];
+      rv = proc(flow, arg);
+      if (rv != LAGOPUS_RESULT_OK) {
+        break;
+      }
+      iter->priority = flow->priority;
+      iter->seq = flow->seq;
+      rv = LAGOPUS_RESULT_EOF;
+    }
+  }
+  flowdb_rdunlock(iter->flowdb);
+
+  return rv;
+}
+
 void
 dp_bridge_flow_iter_destroy(dp_bridge_iter_t iter) {
   free(iter);
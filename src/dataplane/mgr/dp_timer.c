@@ -44,11 +44,45 @@ static lagopus_thread_t timer_thread = NULL;
 static bool timer_run = false;
 static lagopus_mutex_t timer_lock = NULL;
 
+__thread struct dp_clock dp_clock;
+uint64_t dp_clock_hz = 0;
+uint64_t dp_clock_mult = 0;
+
+#define DP_CLOCK_CALIBRATE_NSEC (10 * 1000 * 1000)
+
+void
+dp_clock_calibrate(void) {
+  struct timespec ts0, ts1, req;
+  uint64_t tsc0, tsc1, nsec;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts0);
+  tsc0 = dp_clock_cycles();
+  req.tv_sec = 0;
+  req.tv_nsec = DP_CLOCK_CALIBRATE_NSEC;
+  (void)nanosleep(&req, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &ts1);
+  tsc1 = dp_clock_cycles();
+
+  nsec = (uint64_t)(ts1.tv_sec - ts0.tv_sec) * 1000000000 +
+         (uint64_t)ts1.tv_nsec - (uint64_t)ts0.tv_nsec;
+  if (nsec == 0 || tsc1 <= tsc0) {
+    /* no usable counter, dp_clock_update() reads the clock every time. */
+    dp_clock_hz = 0;
+    dp_clock_mult = 0;
+    return;
+  }
+  dp_clock_hz = (tsc1 - tsc0) * 1000000000 / nsec;
+  dp_clock_mult = (nsec << 32) / (tsc1 - tsc0);
+}
+
 
 void
 init_dp_timer(void) {
   TAILQ_INIT(&dp_timer_list);
   (void)get_current_time();
+  if (dp_clock_hz == 0) {
+    dp_clock_calibrate();
+  }
 }
 
 static struct dp_timer *
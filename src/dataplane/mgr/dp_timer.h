@@ -23,6 +23,7 @@ enum {
   UPDATER_TIMER,
   LINK_TIMER,
   THTABLE_TIMER,
+  BONDING_TIMER,
 };
 
 #define MAX_TIMEOUT_ENTRIES 256
@@ -49,6 +50,7 @@ struct flow;
 struct flow_list;
 struct interface;
 struct bridge;
+struct bonding;
 
 lagopus_result_t
 add_flow_timer(struct flow *flow);
@@ -60,5 +62,7 @@ lagopus_result_t
 add_updater_timer(struct bridge *bridge, time_t timeout);
 lagopus_result_t
 add_thtable_timer(struct flow_list *flow_list, time_t timeout);
+lagopus_result_t
+add_bonding_timer(struct bonding *bond);
 
 #endif /* SRC_DATAPLANE_MGR_DP_TIMER_H_ */
@@ -0,0 +1,1513 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ *      @file   fib.c
+ *      @brief  Forwarding Information Base(DIR-24-8) for IPv4 and IPv6.
+ *
+ * Prefixes up to /24 are expanded into tbl24, which is indexed by the
+ * upper 24 bits of the destination address. Longer prefixes allocate
+ * a tbl8 group of 256 entries, and the tbl24 entry points to it.
+ * tbl24 is allocated by chunks of 65536 entries when a route is written
+ * to them, a missing chunk means all entries are invalid.
+ * Every entry holds the prefix length that installed it, so that
+ * the tables are updated in place: a route only overwrites entries of
+ * the same or shorter prefixes, and a deleted route is replaced with
+ * the longest covering one.
+ *
+ * The result of the lookup is an index of the adjacency array.
+ * Adjacency has the rewrite information (mac addresses and the output
+ * port), and it's shared by the routes via same nexthop.
+ * ARP entries are installed as host(/32) rules to their adjacencies.
+ * Adjacencies with the same nexthop mac address are linked, and only
+ * the ones marked dirty by ARP or mactable changes are resolved.
+ *
+ * IPv6 uses the same entry format and tbl8 pool: tbl16 is indexed by
+ * the upper 16 bits, and each following byte of the address indexes
+ * a chain of tbl8 groups, up to 14 levels for /128.
+ * IPv6 rules and neighbors are keyed by their strings, neighbors with
+ * the i/f index since link-local addresses are scoped.
+ * Neighbors(NDP) are installed as host(/128) rules except link-local.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/rtnetlink.h>
+
+#include "lagopus_apis.h"
+#include "lagopus/port.h"
+#include "lagopus/bridge.h"
+#include "lagopus/fib.h"
+
+#define RULE_KEY(prefix, depth) \
+  ((void *)(((uint64_t)((depth) + 1) << 32) | (uint64_t)(prefix)))
+#define RULE_VALUE(index, flags) \
+  ((void *)(uintptr_t)((index) | (flags) | RULE_MARK))
+#define RULE_INDEX(value) ((uint32_t)(uintptr_t)(value) & FIB_ENTRY_INDEX_MASK)
+#define RULE_MARK 0x80000000U  /**< value of hashmap never be NULL. */
+#define RULE_HOST 0x40000000U  /**< rule installed by arp entry. */
+
+#define ADJ_KEY(addr) ((void *)(((uint64_t)1 << 32) | (uint64_t)(addr)))
+#define IFMAC_MARK 0x1000000000000ULL
+#define ADJ_MAC_MARK 0x1000000000000ULL
+
+#define FIB_TBL8_MAX_GROUPS (FIB_TBL8_MAX_CHUNKS * FIB_TBL8_CHUNK_GROUPS)
+#define FIB6_LEVELS 15                   /**< tbl16 and 14 levels of tbl8. */
+#define FIB6_KEY_LEN (INET6_ADDRSTRLEN + 16)
+
+static inline uint32_t
+depth_mask(int depth) {
+  return (depth == 0) ? 0 : 0xffffffffU << (32 - depth);
+}
+
+static inline uint32_t
+make_entry(int depth, uint32_t index) {
+  return FIB_ENTRY_VALID |
+      ((uint32_t)depth << FIB_ENTRY_DEPTH_SHIFT) | index;
+}
+
+static inline int
+entry_depth(uint32_t entry) {
+  return (int)((entry & FIB_ENTRY_DEPTH_MASK) >> FIB_ENTRY_DEPTH_SHIFT);
+}
+
+static inline void
+entry_store(uint32_t *entryp, uint32_t entry) {
+  __atomic_store_n(entryp, entry, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t *
+tbl24_entry(struct fib_table *fib, uint32_t i) {
+  uint32_t *chunk = fib->tbl24[i / FIB_TBL24_CHUNK_NUM];
+
+  return (chunk == NULL) ? NULL : &chunk[i % FIB_TBL24_CHUNK_NUM];
+}
+
+/**
+ * Allocate tbl24 chunks covering entries from start to end(exclusive).
+ */
+static lagopus_result_t
+tbl24_alloc(struct fib_table *fib, uint32_t start, uint32_t end) {
+  uint32_t c, *chunk;
+
+  for (c = start / FIB_TBL24_CHUNK_NUM;
+       c <= (end - 1) / FIB_TBL24_CHUNK_NUM; c++) {
+    if (fib->tbl24[c] != NULL) {
+      continue;
+    }
+    chunk = calloc(FIB_TBL24_CHUNK_NUM, sizeof(uint32_t));
+    if (chunk == NULL) {
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
+    /* publish the chunk after it was cleared. */
+    __atomic_store_n(&fib->tbl24[c], chunk, __ATOMIC_RELEASE);
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+static inline uint32_t *
+tbl8_group(struct fib_table *fib, uint32_t group) {
+  return &fib->tbl8[group / FIB_TBL8_CHUNK_GROUPS]
+         [(group % FIB_TBL8_CHUNK_GROUPS) * FIB_TBL8_GROUP_NUM];
+}
+
+/**
+ * Allocate tbl8 group, the pool is grown by chunks.
+ */
+static lagopus_result_t
+tbl8_alloc(struct fib_table *fib, uint32_t *group) {
+  uint32_t chunk, i;
+
+  if (fib->tbl8_nfree == 0) {
+    if (fib->tbl8_ngroups == FIB_TBL8_MAX_GROUPS) {
+      lagopus_msg_warning("no more tbl8 groups.\n");
+      return LAGOPUS_RESULT_OUT_OF_RANGE;
+    }
+    chunk = fib->tbl8_ngroups / FIB_TBL8_CHUNK_GROUPS;
+    fib->tbl8[chunk] = calloc(FIB_TBL8_CHUNK_GROUPS * FIB_TBL8_GROUP_NUM,
+                              sizeof(uint32_t));
+    if (fib->tbl8[chunk] == NULL) {
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
+    for (i = FIB_TBL8_CHUNK_GROUPS; i > 0; i--) {
+      fib->tbl8_free[fib->tbl8_nfree++] = fib->tbl8_ngroups + i - 1;
+    }
+    fib->tbl8_ngroups += FIB_TBL8_CHUNK_GROUPS;
+  }
+  *group = fib->tbl8_free[--fib->tbl8_nfree];
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Collapse tbl8 group into tbl24 entry if all entries are same.
+ * The group is released by fib_reclaim(), workers may still read it.
+ */
+static void
+tbl8_collapse(struct fib_table *fib, uint32_t tbl24_index) {
+  uint32_t *entryp = tbl24_entry(fib, tbl24_index);
+  uint32_t entry = *entryp;
+  uint32_t group_index, *group;
+  int i;
+
+  if ((entry & FIB_ENTRY_EXT) == 0) {
+    return;
+  }
+  group_index = entry & FIB_ENTRY_INDEX_MASK;
+  group = tbl8_group(fib, group_index);
+  if ((group[0] & FIB_ENTRY_VALID) != 0 && entry_depth(group[0]) > 24) {
+    return;
+  }
+  for (i = 1; i < FIB_TBL8_GROUP_NUM; i++) {
+    if (group[i] != group[0]) {
+      return;
+    }
+  }
+  entry_store(entryp, group[0]);
+  fib->tbl8_pending[fib->tbl8_npending++] = group_index;
+}
+
+/**
+ * Write entry to the range covered by prefix/depth.
+ * Entries installed by longer prefixes are kept.
+ */
+static lagopus_result_t
+tbl_install(struct fib_table *fib, uint32_t prefix, int depth,
+            uint32_t index) {
+  uint32_t entry = make_entry(depth, index);
+  uint32_t i, j, start, end, e, group_index, *group, *entryp;
+  lagopus_result_t rv;
+
+  if (depth <= 24) {
+    start = prefix >> 8;
+    end = start + (1U << (24 - depth));
+    rv = tbl24_alloc(fib, start, end);
+    if (rv != LAGOPUS_RESULT_OK) {
+      return rv;
+    }
+    for (i = start; i < end; i++) {
+      entryp = tbl24_entry(fib, i);
+      e = *entryp;
+      if ((e & FIB_ENTRY_EXT) != 0) {
+        group = tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK);
+        for (j = 0; j < FIB_TBL8_GROUP_NUM; j++) {
+          if ((group[j] & FIB_ENTRY_VALID) == 0 ||
+              entry_depth(group[j]) <= depth) {
+            entry_store(&group[j], entry);
+          }
+        }
+      } else if ((e & FIB_ENTRY_VALID) == 0 || entry_depth(e) <= depth) {
+        entry_store(entryp, entry);
+      }
+    }
+  } else {
+    i = prefix >> 8;
+    rv = tbl24_alloc(fib, i, i + 1);
+    if (rv != LAGOPUS_RESULT_OK) {
+      return rv;
+    }
+    entryp = tbl24_entry(fib, i);
+    e = *entryp;
+    if ((e & FIB_ENTRY_EXT) == 0) {
+      rv = tbl8_alloc(fib, &group_index);
+      if (rv != LAGOPUS_RESULT_OK) {
+        return rv;
+      }
+      group = tbl8_group(fib, group_index);
+      for (j = 0; j < FIB_TBL8_GROUP_NUM; j++) {
+        group[j] = e;
+      }
+      /* publish the group after it was filled. */
+      entry_store(entryp, FIB_ENTRY_VALID | FIB_ENTRY_EXT | group_index);
+    } else {
+      group = tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK);
+    }
+    start = prefix & 0xff;
+    end = start + (1U << (32 - depth));
+    for (j = start; j < end; j++) {
+      if ((group[j] & FIB_ENTRY_VALID) == 0 ||
+          entry_depth(group[j]) <= depth) {
+        entry_store(&group[j], entry);
+      }
+    }
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Replace entries installed by prefix/depth with the covering entry.
+ */
+static void
+tbl_uninstall(struct fib_table *fib, uint32_t prefix, int depth,
+              uint32_t repl) {
+  uint32_t i, j, start, end, e, *group, *entryp;
+
+  if (depth <= 24) {
+    start = prefix >> 8;
+    end = start + (1U << (24 - depth));
+    for (i = start; i < end; i++) {
+      entryp = tbl24_entry(fib, i);
+      if (entryp == NULL) {
+        /* skip the rest of missing chunk. */
+        i |= FIB_TBL24_CHUNK_NUM - 1;
+        continue;
+      }
+      e = *entryp;
+      if ((e & FIB_ENTRY_EXT) != 0) {
+        group = tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK);
+        for (j = 0; j < FIB_TBL8_GROUP_NUM; j++) {
+          if ((group[j] & FIB_ENTRY_VALID) != 0 &&
+              entry_depth(group[j]) == depth) {
+            entry_store(&group[j], repl);
+          }
+        }
+        tbl8_collapse(fib, i);
+      } else if ((e & FIB_ENTRY_VALID) != 0 && entry_depth(e) == depth) {
+        entry_store(entryp, repl);
+      }
+    }
+  } else {
+    i = prefix >> 8;
+    entryp = tbl24_entry(fib, i);
+    if (entryp == NULL || (*entryp & FIB_ENTRY_EXT) == 0) {
+      return;
+    }
+    e = *entryp;
+    group = tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK);
+    start = prefix & 0xff;
+    end = start + (1U << (32 - depth));
+    for (j = start; j < end; j++) {
+      if ((group[j] & FIB_ENTRY_VALID) != 0 &&
+          entry_depth(group[j]) == depth) {
+        entry_store(&group[j], repl);
+      }
+    }
+    tbl8_collapse(fib, i);
+  }
+}
+
+/**
+ * Find the entry of the longest rule covering prefix/depth.
+ */
+static uint32_t
+covering_entry(struct fib_table *fib, uint32_t prefix, int depth) {
+  void *value;
+  int d;
+
+  for (d = depth - 1; d >= 0; d--) {
+    if (lagopus_hashmap_find(&fib->rules,
+                             RULE_KEY(prefix & depth_mask(d), d),
+                             &value) == LAGOPUS_RESULT_OK) {
+      return make_entry(d, RULE_INDEX(value));
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Bits consumed by the IPv6 table of level(0: tbl16, 1-14: tbl8).
+ */
+static inline int
+level6_start(int level) {
+  return (level == 0) ? 0 : level * 8 + 8;
+}
+
+static inline int
+level6_end(int level) {
+  return level * 8 + 16;
+}
+
+static inline uint32_t
+level6_index(const uint8_t *a, int level) {
+  return (level == 0) ? ((uint32_t)a[0] << 8) | a[1] : a[level + 1];
+}
+
+static void
+mask6(struct in6_addr *dst, const struct in6_addr *src, int depth) {
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    if (depth >= 8) {
+      dst->s6_addr[i] = src->s6_addr[i];
+      depth -= 8;
+    } else {
+      dst->s6_addr[i] = src->s6_addr[i] & (uint8_t)(0xff00 >> depth);
+      depth = 0;
+    }
+  }
+}
+
+static void
+rule6_key(char *key, const struct in6_addr *prefix, int depth) {
+  char buf[INET6_ADDRSTRLEN];
+
+  inet_ntop(AF_INET6, prefix, buf, sizeof(buf));
+  snprintf(key, FIB6_KEY_LEN, "%s/%d", buf, depth);
+}
+
+static void
+adj6_key(char *key, const struct in6_addr *addr, int ifindex) {
+  char buf[INET6_ADDRSTRLEN];
+
+  inet_ntop(AF_INET6, addr, buf, sizeof(buf));
+  snprintf(key, FIB6_KEY_LEN, "%s%%%d", buf, ifindex);
+}
+
+/**
+ * Collapse tbl8 group of IPv6 into the parent entry if all entries
+ * are same, and not installed by the prefix longer than the parent.
+ */
+static void
+tbl6_collapse(struct fib_table *fib, uint32_t *slot, int level) {
+  uint32_t entry = *slot;
+  uint32_t group_index, *group;
+  int i;
+
+  if ((entry & FIB_ENTRY_EXT) == 0) {
+    return;
+  }
+  group_index = entry & FIB_ENTRY_INDEX_MASK;
+  group = tbl8_group(fib, group_index);
+  if ((group[0] & FIB_ENTRY_EXT) != 0 ||
+      ((group[0] & FIB_ENTRY_VALID) != 0 &&
+       entry_depth(group[0]) > level6_start(level))) {
+    return;
+  }
+  for (i = 1; i < FIB_TBL8_GROUP_NUM; i++) {
+    if (group[i] != group[0]) {
+      return;
+    }
+  }
+  entry_store(slot, group[0]);
+  fib->tbl8_pending[fib->tbl8_npending++] = group_index;
+}
+
+static void
+tbl6_fill(struct fib_table *fib, uint32_t *tbl, uint32_t start, uint32_t end,
+          int depth, uint32_t entry) {
+  uint32_t i, e;
+
+  for (i = start; i < end; i++) {
+    e = tbl[i];
+    if ((e & FIB_ENTRY_EXT) != 0) {
+      tbl6_fill(fib, tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK),
+                0, FIB_TBL8_GROUP_NUM, depth, entry);
+    } else if ((e & FIB_ENTRY_VALID) == 0 || entry_depth(e) <= depth) {
+      entry_store(&tbl[i], entry);
+    }
+  }
+}
+
+static void
+tbl6_unfill(struct fib_table *fib, uint32_t *tbl, uint32_t start,
+            uint32_t end, int depth, uint32_t repl, int level) {
+  uint32_t i, e;
+
+  for (i = start; i < end; i++) {
+    e = tbl[i];
+    if ((e & FIB_ENTRY_EXT) != 0) {
+      tbl6_unfill(fib, tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK),
+                  0, FIB_TBL8_GROUP_NUM, depth, repl, level + 1);
+      tbl6_collapse(fib, &tbl[i], level + 1);
+    } else if ((e & FIB_ENTRY_VALID) != 0 && entry_depth(e) == depth) {
+      entry_store(&tbl[i], repl);
+    }
+  }
+}
+
+/**
+ * Write entry to the range covered by IPv6 prefix/depth,
+ * tbl8 groups are chained until the level which contains the depth.
+ */
+static lagopus_result_t
+tbl6_install(struct fib_table *fib, const struct in6_addr *prefix, int depth,
+             uint32_t index) {
+  const uint8_t *a = prefix->s6_addr;
+  uint32_t *tbl = fib->tbl16;
+  uint32_t idx, e, j, group_index, *group;
+  int level;
+  lagopus_result_t rv;
+
+  for (level = 0; level < FIB6_LEVELS; level++) {
+    idx = level6_index(a, level);
+    if (depth <= level6_end(level)) {
+      tbl6_fill(fib, tbl, idx, idx + (1U << (level6_end(level) - depth)),
+                depth, make_entry(depth, index));
+      break;
+    }
+    e = tbl[idx];
+    if ((e & FIB_ENTRY_EXT) == 0) {
+      rv = tbl8_alloc(fib, &group_index);
+      if (rv != LAGOPUS_RESULT_OK) {
+        return rv;
+      }
+      group = tbl8_group(fib, group_index);
+      for (j = 0; j < FIB_TBL8_GROUP_NUM; j++) {
+        group[j] = e;
+      }
+      /* publish the group after it was filled. */
+      entry_store(&tbl[idx], FIB_ENTRY_VALID | FIB_ENTRY_EXT | group_index);
+    } else {
+      group = tbl8_group(fib, e & FIB_ENTRY_INDEX_MASK);
+    }
+    tbl = group;
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Replace entries installed by IPv6 prefix/depth with the covering entry,
+ * and collapse the groups on the way back to tbl16.
+ */
+static void
+tbl6_uninstall(struct fib_table *fib, const struct in6_addr *prefix,
+               int depth, uint32_t repl) {
+  const uint8_t *a = prefix->s6_addr;
+  uint32_t *tbl = fib->tbl16;
+  uint32_t *path[FIB6_LEVELS];
+  uint32_t idx;
+  int level;
+
+  for (level = 0; level < FIB6_LEVELS; level++) {
+    idx = level6_index(a, level);
+    if (depth <= level6_end(level)) {
+      tbl6_unfill(fib, tbl, idx, idx + (1U << (level6_end(level) - depth)),
+                  depth, repl, level);
+      break;
+    }
+    if ((tbl[idx] & FIB_ENTRY_EXT) == 0) {
+      return;
+    }
+    path[level + 1] = &tbl[idx];
+    tbl = tbl8_group(fib, tbl[idx] & FIB_ENTRY_INDEX_MASK);
+  }
+  for (; level > 0; level--) {
+    tbl6_collapse(fib, path[level], level);
+  }
+}
+
+/**
+ * Find the entry of the longest IPv6 rule covering prefix/depth.
+ */
+static uint32_t
+covering6_entry(struct fib_table *fib, const struct in6_addr *prefix,
+                int depth) {
+  struct in6_addr masked;
+  char key[FIB6_KEY_LEN];
+  void *value;
+  int d;
+
+  for (d = depth - 1; d >= 0; d--) {
+    mask6(&masked, prefix, d);
+    rule6_key(key, &masked, d);
+    if (lagopus_hashmap_find(&fib->rules6, key, &value) ==
+        LAGOPUS_RESULT_OK) {
+      return make_entry(d, RULE_INDEX(value));
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Write adjacency with seqlock, readers retry while version is odd.
+ */
+static void
+adjacency_write_begin(struct fib_adjacency *adj) {
+  __atomic_add_fetch(&adj->version, 1, __ATOMIC_ACQ_REL);
+}
+
+static void
+adjacency_write_end(struct fib_adjacency *adj) {
+  __atomic_add_fetch(&adj->version, 1, __ATOMIC_RELEASE);
+}
+
+static bool
+ifmac_get(struct fib_table *fib, int ifindex, uint8_t *mac) {
+  void *value;
+  uint64_t packed;
+  int i;
+
+  if (lagopus_hashmap_find(&fib->ifmac, (void *)(intptr_t)(ifindex + 1),
+                           &value) != LAGOPUS_RESULT_OK) {
+    return false;
+  }
+  packed = (uint64_t)(uintptr_t)value;
+  for (i = 0; i < UPDATER_ETH_LEN; i++) {
+    mac[i] = (uint8_t)(packed >> (8 * (UPDATER_ETH_LEN - 1 - i)));
+  }
+
+  return true;
+}
+
+static void
+ifmac_set(struct fib_table *fib, int ifindex, uint8_t *mac) {
+  void *value;
+  uint64_t packed = IFMAC_MARK;
+  int i;
+
+  for (i = 0; i < UPDATER_ETH_LEN; i++) {
+    packed |= (uint64_t)mac[i] << (8 * (UPDATER_ETH_LEN - 1 - i));
+  }
+  value = (void *)(uintptr_t)packed;
+  lagopus_hashmap_add(&fib->ifmac, (void *)(intptr_t)(ifindex + 1),
+                      &value, true);
+}
+
+static void *
+adjacency_mac_key(const uint8_t *mac) {
+  uint64_t packed = ADJ_MAC_MARK;
+  int i;
+
+  for (i = 0; i < UPDATER_ETH_LEN; i++) {
+    packed |= (uint64_t)mac[i] << (8 * (UPDATER_ETH_LEN - 1 - i));
+  }
+
+  return (void *)(uintptr_t)packed;
+}
+
+/**
+ * Link resolved adjacency to the chain of its dst_mac.
+ */
+static void
+adjacency_mac_link(struct fib_table *fib, uint32_t index) {
+  struct fib_adjacency *adj = &fib->adjacency[index];
+  void *key = adjacency_mac_key(adj->dst_mac);
+  void *value;
+
+  if (lagopus_hashmap_find(&fib->adjacency_mac, key,
+                           &value) == LAGOPUS_RESULT_OK) {
+    adj->mac_next = RULE_INDEX(value);
+  } else {
+    adj->mac_next = FIB_LOOKUP_MISS;
+  }
+  value = RULE_VALUE(index, 0);
+  lagopus_hashmap_add(&fib->adjacency_mac, key, &value, true);
+}
+
+/**
+ * Unlink resolved adjacency from the chain of its dst_mac.
+ */
+static void
+adjacency_mac_unlink(struct fib_table *fib, uint32_t index) {
+  struct fib_adjacency *adj = &fib->adjacency[index];
+  void *key = adjacency_mac_key(adj->dst_mac);
+  void *value;
+  uint32_t i;
+
+  if (lagopus_hashmap_find(&fib->adjacency_mac, key,
+                           &value) != LAGOPUS_RESULT_OK) {
+    return;
+  }
+  i = RULE_INDEX(value);
+  if (i == index) {
+    if (adj->mac_next == FIB_LOOKUP_MISS) {
+      lagopus_hashmap_delete(&fib->adjacency_mac, key, NULL, false);
+    } else {
+      value = RULE_VALUE(adj->mac_next, 0);
+      lagopus_hashmap_add(&fib->adjacency_mac, key, &value, true);
+    }
+    return;
+  }
+  while (fib->adjacency[i].mac_next != FIB_LOOKUP_MISS) {
+    if (fib->adjacency[i].mac_next == index) {
+      fib->adjacency[i].mac_next = adj->mac_next;
+      return;
+    }
+    i = fib->adjacency[i].mac_next;
+  }
+}
+
+/**
+ * Link adjacency to the dirty list, resolved by fib_adjacency_resolve().
+ */
+static void
+adjacency_mark(struct fib_table *fib, uint32_t index) {
+  struct fib_adjacency *adj = &fib->adjacency[index];
+
+  if (adj->dirty == true) {
+    return;
+  }
+  adj->dirty = true;
+  adj->dirty_next = fib->adjacency_dirty;
+  fib->adjacency_dirty = index;
+}
+
+static uint32_t
+adjacency_find(struct fib_table *fib, struct in_addr *nexthop) {
+  void *value;
+
+  if (lagopus_hashmap_find(&fib->adjacency_map,
+                           ADJ_KEY(nexthop->s_addr),
+                           &value) != LAGOPUS_RESULT_OK) {
+    return FIB_LOOKUP_MISS;
+  }
+
+  return RULE_INDEX(value);
+}
+
+/**
+ * Get adjacency of nexthop, create unresolved one if not exist.
+ */
+static lagopus_result_t
+adjacency_get(struct fib_table *fib, struct in_addr *nexthop, int ifindex,
+              uint32_t *indexp) {
+  struct fib_adjacency *adj;
+  uint32_t index;
+  void *value;
+  lagopus_result_t rv;
+
+  index = adjacency_find(fib, nexthop);
+  if (index != FIB_LOOKUP_MISS) {
+    *indexp = index;
+    return LAGOPUS_RESULT_OK;
+  }
+  if (fib->adjacency_nfree == 0) {
+    lagopus_msg_warning("no more adjacencies.\n");
+    return LAGOPUS_RESULT_OUT_OF_RANGE;
+  }
+  index = fib->adjacency_free[--fib->adjacency_nfree];
+  value = RULE_VALUE(index, 0);
+  rv = lagopus_hashmap_add(&fib->adjacency_map,
+                           ADJ_KEY(nexthop->s_addr),
+                           &value, false);
+  if (rv != LAGOPUS_RESULT_OK) {
+    fib->adjacency_free[fib->adjacency_nfree++] = index;
+    return rv;
+  }
+
+  adj = &fib->adjacency[index];
+  adjacency_write_begin(adj);
+  adj->refcnt = 0;
+  adj->family = AF_INET;
+  adj->nexthop = *nexthop;
+  adj->ifindex = ifindex;
+  adj->output_port = OFPP_ALL;
+  adj->resolved = false;
+  memset(adj->dst_mac, 0, UPDATER_ETH_LEN);
+  if (ifmac_get(fib, ifindex, adj->src_mac) == false) {
+    memset(adj->src_mac, 0, UPDATER_ETH_LEN);
+  }
+  adjacency_write_end(adj);
+  *indexp = index;
+
+  return LAGOPUS_RESULT_OK;
+}
+
+static uint32_t
+adjacency6_find(struct fib_table *fib, struct in6_addr *nexthop,
+                int ifindex) {
+  char key[FIB6_KEY_LEN];
+  void *value;
+
+  adj6_key(key, nexthop, ifindex);
+  if (lagopus_hashmap_find(&fib->adjacency_map6, key,
+                           &value) != LAGOPUS_RESULT_OK) {
+    return FIB_LOOKUP_MISS;
+  }
+
+  return RULE_INDEX(value);
+}
+
+/**
+ * Get adjacency of IPv6 nexthop on the interface,
+ * create unresolved one if not exist.
+ */
+static lagopus_result_t
+adjacency6_get(struct fib_table *fib, struct in6_addr *nexthop, int ifindex,
+               uint32_t *indexp) {
+  struct fib_adjacency *adj;
+  char key[FIB6_KEY_LEN];
+  uint32_t index;
+  void *value;
+  lagopus_result_t rv;
+
+  index = adjacency6_find(fib, nexthop, ifindex);
+  if (index != FIB_LOOKUP_MISS) {
+    *indexp = index;
+    return LAGOPUS_RESULT_OK;
+  }
+  if (fib->adjacency_nfree == 0) {
+    lagopus_msg_warning("no more adjacencies.\n");
+    return LAGOPUS_RESULT_OUT_OF_RANGE;
+  }
+  index = fib->adjacency_free[--fib->adjacency_nfree];
+  value = RULE_VALUE(index, 0);
+  adj6_key(key, nexthop, ifindex);
+  rv = lagopus_hashmap_add(&fib->adjacency_map6, key, &value, false);
+  if (rv != LAGOPUS_RESULT_OK) {
+    fib->adjacency_free[fib->adjacency_nfree++] = index;
+    return rv;
+  }
+
+  adj = &fib->adjacency[index];
+  adjacency_write_begin(adj);
+  adj->refcnt = 0;
+  adj->family = AF_INET6;
+  adj->nexthop6 = *nexthop;
+  adj->ifindex = ifindex;
+  adj->output_port = OFPP_ALL;
+  adj->resolved = false;
+  memset(adj->dst_mac, 0, UPDATER_ETH_LEN);
+  if (ifmac_get(fib, ifindex, adj->src_mac) == false) {
+    memset(adj->src_mac, 0, UPDATER_ETH_LEN);
+  }
+  adjacency_write_end(adj);
+  *indexp = index;
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Release adjacency if no rule refers it and it's not resolved.
+ */
+static void
+adjacency_put(struct fib_table *fib, uint32_t index) {
+  struct fib_adjacency *adj = &fib->adjacency[index];
+
+  if (index == FIB_ADJACENCY_GLEAN ||
+      adj->refcnt != 0 || adj->resolved == true) {
+    return;
+  }
+  if (adj->family == AF_INET6) {
+    char key[FIB6_KEY_LEN];
+
+    adj6_key(key, &adj->nexthop6, adj->ifindex);
+    lagopus_hashmap_delete(&fib->adjacency_map6, key, NULL, false);
+  } else {
+    lagopus_hashmap_delete(&fib->adjacency_map,
+                           ADJ_KEY(adj->nexthop.s_addr),
+                           NULL, false);
+  }
+  fib->adjacency_pending[fib->adjacency_npending++] = index;
+}
+
+/**
+ * Add or replace the rule of prefix/depth.
+ */
+static lagopus_result_t
+rule_set(struct fib_table *fib, uint32_t prefix, int depth,
+         uint32_t index, uint32_t flags) {
+  void *value, *old;
+  bool replaced;
+  lagopus_result_t rv;
+
+  replaced = (lagopus_hashmap_find(&fib->rules, RULE_KEY(prefix, depth),
+                                   &old) == LAGOPUS_RESULT_OK);
+  rv = tbl_install(fib, prefix, depth, index);
+  if (rv != LAGOPUS_RESULT_OK) {
+    return rv;
+  }
+  value = RULE_VALUE(index, flags);
+  rv = lagopus_hashmap_add(&fib->rules, RULE_KEY(prefix, depth),
+                           &value, true);
+  if (rv != LAGOPUS_RESULT_OK) {
+    return rv;
+  }
+  fib->adjacency[index].refcnt++;
+  if (replaced == true) {
+    fib->adjacency[RULE_INDEX(old)].refcnt--;
+    adjacency_put(fib, RULE_INDEX(old));
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Delete the rule of prefix/depth.
+ */
+static void
+rule_delete(struct fib_table *fib, uint32_t prefix, int depth,
+            void *value) {
+  uint32_t index = RULE_INDEX(value);
+
+  lagopus_hashmap_delete(&fib->rules, RULE_KEY(prefix, depth), NULL, false);
+  tbl_uninstall(fib, prefix, depth, covering_entry(fib, prefix, depth));
+  fib->adjacency[index].refcnt--;
+  adjacency_put(fib, index);
+}
+
+/**
+ * Add or replace the IPv6 rule of prefix/depth.
+ */
+static lagopus_result_t
+rule6_set(struct fib_table *fib, struct in6_addr *prefix, int depth,
+          uint32_t index, uint32_t flags) {
+  char key[FIB6_KEY_LEN];
+  void *value, *old;
+  bool replaced;
+  lagopus_result_t rv;
+
+  rule6_key(key, prefix, depth);
+  replaced = (lagopus_hashmap_find(&fib->rules6, key,
+                                   &old) == LAGOPUS_RESULT_OK);
+  rv = tbl6_install(fib, prefix, depth, index);
+  if (rv != LAGOPUS_RESULT_OK) {
+    return rv;
+  }
+  value = RULE_VALUE(index, flags);
+  rv = lagopus_hashmap_add(&fib->rules6, key, &value, true);
+  if (rv != LAGOPUS_RESULT_OK) {
+    return rv;
+  }
+  fib->adjacency[index].refcnt++;
+  if (replaced == true) {
+    fib->adjacency[RULE_INDEX(old)].refcnt--;
+    adjacency_put(fib, RULE_INDEX(old));
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Delete the IPv6 rule of prefix/depth.
+ */
+static void
+rule6_delete(struct fib_table *fib, struct in6_addr *prefix, int depth,
+             void *value) {
+  char key[FIB6_KEY_LEN];
+  uint32_t index = RULE_INDEX(value);
+
+  rule6_key(key, prefix, depth);
+  lagopus_hashmap_delete(&fib->rules6, key, NULL, false);
+  tbl6_uninstall(fib, prefix, depth, covering6_entry(fib, prefix, depth));
+  fib->adjacency[index].refcnt--;
+  adjacency_put(fib, index);
+}
+
+static bool
+is_linklocal6(const struct in6_addr *addr) {
+  return addr->s6_addr[0] == 0xfe && (addr->s6_addr[1] & 0xc0) == 0x80;
+}
+
+struct ifaddr_arg {
+  struct fib_table *fib;
+  int ifindex;
+  uint8_t *mac;
+};
+
+static bool
+ifaddr_update_iterate(void *key, void *val,
+                      lagopus_hashentry_t he, void *arg) {
+  struct ifaddr_arg *ifaddr_arg = arg;
+  struct fib_adjacency *adj;
+  (void) key;
+  (void) he;
+
+  adj = &ifaddr_arg->fib->adjacency[RULE_INDEX(val)];
+  if (adj->ifindex == ifaddr_arg->ifindex) {
+    adjacency_write_begin(adj);
+    memcpy(adj->src_mac, ifaddr_arg->mac, UPDATER_ETH_LEN);
+    adjacency_write_end(adj);
+  }
+
+  return true;
+}
+
+static bool
+adjacency_mark_iterate(void *key, void *val,
+                       lagopus_hashentry_t he, void *arg) {
+  (void) key;
+  (void) he;
+
+  adjacency_mark(arg, RULE_INDEX(val));
+
+  return true;
+}
+
+static void
+adjacency_mac_changed(const uint8_t *ethaddr, void *arg) {
+  struct fib_table *fib = arg;
+  void *value;
+  uint32_t i;
+
+  if (lagopus_hashmap_find(&fib->adjacency_mac, adjacency_mac_key(ethaddr),
+                           &value) != LAGOPUS_RESULT_OK) {
+    return;
+  }
+  for (i = RULE_INDEX(value); i != FIB_LOOKUP_MISS;
+       i = fib->adjacency[i].mac_next) {
+    adjacency_mark(fib, i);
+  }
+}
+
+struct neighbor6_arg {
+  struct fib_table *fib;
+  struct in6_addr *addr;
+  uint32_t index;
+};
+
+static bool
+neighbor6_find_iterate(void *key, void *val,
+                       lagopus_hashentry_t he, void *arg) {
+  struct neighbor6_arg *neighbor6_arg = arg;
+  struct fib_adjacency *adj;
+  (void) key;
+  (void) he;
+
+  adj = &neighbor6_arg->fib->adjacency[RULE_INDEX(val)];
+  if (adj->resolved == true &&
+      memcmp(&adj->nexthop6, neighbor6_arg->addr,
+             sizeof(struct in6_addr)) == 0) {
+    neighbor6_arg->index = RULE_INDEX(val);
+    return false;
+  }
+
+  return true;
+}
+
+/*** public functions ***/
+/**
+ * Initialize fib.
+ */
+lagopus_result_t
+fib_init(struct fib_table *fib) {
+  uint32_t i;
+  lagopus_result_t rv;
+
+  memset(fib, 0, sizeof(*fib));
+  fib->tbl16 = calloc(FIB_TBL16_NUM, sizeof(uint32_t));
+  fib->tbl8_free = calloc(FIB_TBL8_MAX_GROUPS, sizeof(uint32_t));
+  fib->tbl8_pending = calloc(FIB_TBL8_MAX_GROUPS, sizeof(uint32_t));
+  fib->adjacency = calloc(FIB_ADJACENCY_MAX, sizeof(struct fib_adjacency));
+  fib->adjacency_free = calloc(FIB_ADJACENCY_MAX, sizeof(uint32_t));
+  fib->adjacency_pending = calloc(FIB_ADJACENCY_MAX, sizeof(uint32_t));
+  if (fib->tbl16 == NULL || fib->tbl8_free == NULL ||
+      fib->tbl8_pending == NULL || fib->adjacency == NULL ||
+      fib->adjacency_free == NULL || fib->adjacency_pending == NULL) {
+    fib_fini(fib);
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  if ((rv = lagopus_hashmap_create(&fib->rules,
+                                   LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                                   NULL)) != LAGOPUS_RESULT_OK ||
+      (rv = lagopus_hashmap_create(&fib->adjacency_map,
+                                   LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                                   NULL)) != LAGOPUS_RESULT_OK ||
+      (rv = lagopus_hashmap_create(&fib->ifmac,
+                                   LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                                   NULL)) != LAGOPUS_RESULT_OK ||
+      (rv = lagopus_hashmap_create(&fib->adjacency_mac,
+                                   LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                                   NULL)) != LAGOPUS_RESULT_OK ||
+      (rv = lagopus_hashmap_create(&fib->rules6,
+                                   LAGOPUS_HASHMAP_TYPE_STRING,
+                                   NULL)) != LAGOPUS_RESULT_OK ||
+      (rv = lagopus_hashmap_create(&fib->adjacency_map6,
+                                   LAGOPUS_HASHMAP_TYPE_STRING,
+                                   NULL)) != LAGOPUS_RESULT_OK) {
+    /* maps not created yet are NULL, fib_fini() skips them. */
+    fib_fini(fib);
+    return rv;
+  }
+
+  /* adjacency 0 is for connected routes, always sent to kernel. */
+  fib->adjacency[FIB_ADJACENCY_GLEAN].output_port = OFPP_ALL;
+  fib->adjacency_dirty = FIB_LOOKUP_MISS;
+  for (i = FIB_ADJACENCY_MAX - 1; i > FIB_ADJACENCY_GLEAN; i--) {
+    fib->adjacency_free[fib->adjacency_nfree++] = i;
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Finalize fib.
+ */
+void
+fib_fini(struct fib_table *fib) {
+  int i;
+
+  lagopus_hashmap_destroy(&fib->rules, true);
+  lagopus_hashmap_destroy(&fib->adjacency_map, true);
+  lagopus_hashmap_destroy(&fib->ifmac, true);
+  lagopus_hashmap_destroy(&fib->adjacency_mac, true);
+  lagopus_hashmap_destroy(&fib->rules6, true);
+  lagopus_hashmap_destroy(&fib->adjacency_map6, true);
+  for (i = 0; i < FIB_TBL8_MAX_CHUNKS; i++) {
+    free(fib->tbl8[i]);
+  }
+  for (i = 0; i < FIB_TBL24_CHUNKS; i++) {
+    free(fib->tbl24[i]);
+  }
+  free(fib->tbl16);
+  free(fib->tbl8_free);
+  free(fib->tbl8_pending);
+  free(fib->adjacency);
+  free(fib->adjacency_free);
+  free(fib->adjacency_pending);
+  memset(fib, 0, sizeof(*fib));
+}
+
+/**
+ * Add route to fib, an existing route of same prefix is replaced.
+ */
+lagopus_result_t
+fib_route_add(struct fib_table *fib, struct in_addr *dest, int prefixlen,
+              struct in_addr *gate, int ifindex, uint8_t scope, uint8_t *mac) {
+  uint32_t prefix, index = FIB_ADJACENCY_GLEAN;
+  lagopus_result_t rv;
+
+  if (fib == NULL || dest == NULL || prefixlen < 0 || prefixlen > 32) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  prefix = ntohl(dest->s_addr) & depth_mask(prefixlen);
+  if (mac != NULL) {
+    ifmac_set(fib, ifindex, mac);
+  }
+
+  /* connected route is resolved by the destination address itself. */
+  if (scope != RT_SCOPE_LINK && gate != NULL && gate->s_addr != 0) {
+    rv = adjacency_get(fib, gate, ifindex, &index);
+    if (rv != LAGOPUS_RESULT_OK) {
+      return rv;
+    }
+  }
+  rv = rule_set(fib, prefix, prefixlen, index, 0);
+  if (rv != LAGOPUS_RESULT_OK) {
+    adjacency_put(fib, index);
+  }
+
+  return rv;
+}
+
+/**
+ * Delete route from fib.
+ */
+lagopus_result_t
+fib_route_delete(struct fib_table *fib, struct in_addr *dest, int prefixlen) {
+  struct in_addr host;
+  uint32_t prefix, index;
+  void *value;
+
+  if (fib == NULL || dest == NULL || prefixlen < 0 || prefixlen > 32) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  prefix = ntohl(dest->s_addr) & depth_mask(prefixlen);
+  if (lagopus_hashmap_find(&fib->rules, RULE_KEY(prefix, prefixlen),
+                           &value) != LAGOPUS_RESULT_OK ||
+      ((uintptr_t)value & RULE_HOST) != 0) {
+    return LAGOPUS_RESULT_OK;
+  }
+  rule_delete(fib, prefix, prefixlen, value);
+
+  /* host route was hiding arp entry. */
+  if (prefixlen == 32) {
+    host.s_addr = htonl(prefix);
+    index = adjacency_find(fib, &host);
+    if (index != FIB_LOOKUP_MISS && fib->adjacency[index].resolved == true) {
+      return rule_set(fib, prefix, 32, index, RULE_HOST);
+    }
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Resolve adjacency of ip, and install it as host route.
+ */
+lagopus_result_t
+fib_arp_update(struct fib_table *fib, int ifindex,
+               struct in_addr *ip, uint8_t *mac) {
+  struct fib_adjacency *adj;
+  uint32_t index;
+  void *value;
+  lagopus_result_t rv;
+
+  if (fib == NULL || ip == NULL || mac == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  rv = adjacency_get(fib, ip, ifindex, &index);
+  if (rv != LAGOPUS_RESULT_OK) {
+    return rv;
+  }
+  adj = &fib->adjacency[index];
+  if (adj->resolved == true) {
+    adjacency_mac_unlink(fib, index);
+  }
+  adjacency_write_begin(adj);
+  adj->ifindex = ifindex;
+  adj->resolved = true;
+  memcpy(adj->dst_mac, mac, UPDATER_ETH_LEN);
+  ifmac_get(fib, ifindex, adj->src_mac);
+  adjacency_write_end(adj);
+  adjacency_mac_link(fib, index);
+  adjacency_mark(fib, index);
+
+  /* the route of same /32 prefix has priority. */
+  if (lagopus_hashmap_find(&fib->rules, RULE_KEY(ntohl(ip->s_addr), 32),
+                           &value) == LAGOPUS_RESULT_OK) {
+    return LAGOPUS_RESULT_OK;
+  }
+
+  return rule_set(fib, ntohl(ip->s_addr), 32, index, RULE_HOST);
+}
+
+/**
+ * Unresolve adjacency of ip, and remove its host route.
+ */
+lagopus_result_t
+fib_arp_delete(struct fib_table *fib, struct in_addr *ip) {
+  struct fib_adjacency *adj;
+  uint32_t index;
+  void *value;
+
+  if (fib == NULL || ip == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  index = adjacency_find(fib, ip);
+  if (index == FIB_LOOKUP_MISS) {
+    return LAGOPUS_RESULT_OK;
+  }
+  adj = &fib->adjacency[index];
+  if (adj->resolved == true) {
+    adjacency_mac_unlink(fib, index);
+  }
+  adjacency_write_begin(adj);
+  adj->resolved = false;
+  adj->output_port = OFPP_ALL;
+  memset(adj->dst_mac, 0, UPDATER_ETH_LEN);
+  adjacency_write_end(adj);
+
+  if (lagopus_hashmap_find(&fib->rules, RULE_KEY(ntohl(ip->s_addr), 32),
+                           &value) == LAGOPUS_RESULT_OK &&
+      ((uintptr_t)value & RULE_HOST) != 0) {
+    rule_delete(fib, ntohl(ip->s_addr), 32, value);
+  } else {
+    adjacency_put(fib, index);
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Add IPv6 route to fib, an existing route of same prefix is replaced.
+ */
+lagopus_result_t
+fib6_route_add(struct fib_table *fib, struct in6_addr *dest, int prefixlen,
+               struct in6_addr *gate, int ifindex, uint8_t *mac) {
+  struct in6_addr prefix;
+  uint32_t index = FIB_ADJACENCY_GLEAN;
+  lagopus_result_t rv;
+
+  if (fib == NULL || dest == NULL || prefixlen < 0 || prefixlen > 128) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  mask6(&prefix, dest, prefixlen);
+  if (mac != NULL) {
+    ifmac_set(fib, ifindex, mac);
+  }
+
+  /* connected route has no gateway. */
+  if (gate != NULL && IN6_IS_ADDR_UNSPECIFIED(gate) == 0) {
+    rv = adjacency6_get(fib, gate, ifindex, &index);
+    if (rv != LAGOPUS_RESULT_OK) {
+      return rv;
+    }
+  }
+  rv = rule6_set(fib, &prefix, prefixlen, index, 0);
+  if (rv != LAGOPUS_RESULT_OK) {
+    adjacency_put(fib, index);
+  }
+
+  return rv;
+}
+
+/**
+ * Delete IPv6 route from fib.
+ */
+lagopus_result_t
+fib6_route_delete(struct fib_table *fib, struct in6_addr *dest,
+                  int prefixlen) {
+  struct neighbor6_arg arg;
+  struct in6_addr prefix;
+  char key[FIB6_KEY_LEN];
+  void *value;
+
+  if (fib == NULL || dest == NULL || prefixlen < 0 || prefixlen > 128) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  mask6(&prefix, dest, prefixlen);
+  rule6_key(key, &prefix, prefixlen);
+  if (lagopus_hashmap_find(&fib->rules6, key,
+                           &value) != LAGOPUS_RESULT_OK ||
+      ((uintptr_t)value & RULE_HOST) != 0) {
+    return LAGOPUS_RESULT_OK;
+  }
+  rule6_delete(fib, &prefix, prefixlen, value);
+
+  /* host route was hiding neighbor entry. */
+  if (prefixlen == 128 && is_linklocal6(&prefix) == false) {
+    arg.fib = fib;
+    arg.addr = &prefix;
+    arg.index = FIB_LOOKUP_MISS;
+    lagopus_hashmap_iterate(&fib->adjacency_map6,
+                            neighbor6_find_iterate, &arg);
+    if (arg.index != FIB_LOOKUP_MISS) {
+      return rule6_set(fib, &prefix, 128, arg.index, RULE_HOST);
+    }
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Resolve IPv6 adjacency of ip, and install it as host route.
+ * Link-local neighbors are only used as nexthop.
+ */
+lagopus_result_t
+fib6_ndp_update(struct fib_table *fib, int ifindex,
+                struct in6_addr *ip, uint8_t *mac) {
+  struct fib_adjacency *adj;
+  char key[FIB6_KEY_LEN];
+  uint32_t index;
+  void *value;
+  lagopus_result_t rv;
+
+  if (fib == NULL || ip == NULL || mac == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  rv = adjacency6_get(fib, ip, ifindex, &index);
+  if (rv != LAGOPUS_RESULT_OK) {
+    return rv;
+  }
+  adj = &fib->adjacency[index];
+  if (adj->resolved == true) {
+    adjacency_mac_unlink(fib, index);
+  }
+  adjacency_write_begin(adj);
+  adj->resolved = true;
+  memcpy(adj->dst_mac, mac, UPDATER_ETH_LEN);
+  ifmac_get(fib, ifindex, adj->src_mac);
+  adjacency_write_end(adj);
+  adjacency_mac_link(fib, index);
+  adjacency_mark(fib, index);
+
+  if (is_linklocal6(ip) == true) {
+    return LAGOPUS_RESULT_OK;
+  }
+  /* the route of same /128 prefix has priority. */
+  rule6_key(key, ip, 128);
+  if (lagopus_hashmap_find(&fib->rules6, key, &value) == LAGOPUS_RESULT_OK &&
+      ((uintptr_t)value & RULE_HOST) == 0) {
+    return LAGOPUS_RESULT_OK;
+  }
+
+  return rule6_set(fib, ip, 128, index, RULE_HOST);
+}
+
+/**
+ * Unresolve IPv6 adjacency of ip, and remove its host route.
+ */
+lagopus_result_t
+fib6_ndp_delete(struct fib_table *fib, int ifindex, struct in6_addr *ip) {
+  struct fib_adjacency *adj;
+  char key[FIB6_KEY_LEN];
+  uint32_t index;
+  void *value;
+
+  if (fib == NULL || ip == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  index = adjacency6_find(fib, ip, ifindex);
+  if (index == FIB_LOOKUP_MISS) {
+    return LAGOPUS_RESULT_OK;
+  }
+  adj = &fib->adjacency[index];
+  if (adj->resolved == true) {
+    adjacency_mac_unlink(fib, index);
+  }
+  adjacency_write_begin(adj);
+  adj->resolved = false;
+  adj->output_port = OFPP_ALL;
+  memset(adj->dst_mac, 0, UPDATER_ETH_LEN);
+  adjacency_write_end(adj);
+
+  rule6_key(key, ip, 128);
+  if (lagopus_hashmap_find(&fib->rules6, key, &value) == LAGOPUS_RESULT_OK &&
+      ((uintptr_t)value & RULE_HOST) != 0 && RULE_INDEX(value) == index) {
+    rule6_delete(fib, ip, 128, value);
+  } else {
+    adjacency_put(fib, index);
+  }
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Update source mac address of adjacencies on the interface.
+ */
+void
+fib_ifaddr_update(struct fib_table *fib, int ifindex, uint8_t *mac) {
+  struct ifaddr_arg arg;
+
+  ifmac_set(fib, ifindex, mac);
+  arg.fib = fib;
+  arg.ifindex = ifindex;
+  arg.mac = mac;
+  lagopus_hashmap_iterate(&fib->adjacency_map, ifaddr_update_iterate, &arg);
+  lagopus_hashmap_iterate(&fib->adjacency_map6, ifaddr_update_iterate, &arg);
+}
+
+/**
+ * Lookup fib for burst of addresses(host byte order).
+ */
+void
+fib_lookup_bulk(const struct fib_table *fib, const uint32_t *addrs,
+                uint32_t *indexes, unsigned int n) {
+  const uint32_t *chunk;
+  uint32_t entry, group;
+  unsigned int i;
+
+  /* first pass: tbl24, prefetch tbl24 ahead. */
+  for (i = 0; i < n; i++) {
+    if (i + 4 < n) {
+      chunk = __atomic_load_n(&fib->tbl24[(addrs[i + 4] >> 8) /
+                                          FIB_TBL24_CHUNK_NUM],
+                              __ATOMIC_ACQUIRE);
+      if (chunk != NULL) {
+        __builtin_prefetch(&chunk[(addrs[i + 4] >> 8) %
+                                  FIB_TBL24_CHUNK_NUM]);
+      }
+    }
+    chunk = __atomic_load_n(&fib->tbl24[(addrs[i] >> 8) /
+                                        FIB_TBL24_CHUNK_NUM],
+                            __ATOMIC_ACQUIRE);
+    indexes[i] = (chunk == NULL) ? 0 :
+                 __atomic_load_n(&chunk[(addrs[i] >> 8) %
+                                        FIB_TBL24_CHUNK_NUM],
+                                 __ATOMIC_ACQUIRE);
+    if ((indexes[i] & FIB_ENTRY_EXT) != 0) {
+      group = indexes[i] & FIB_ENTRY_INDEX_MASK;
+      __builtin_prefetch(&fib->tbl8[group / FIB_TBL8_CHUNK_GROUPS]
+                         [(group % FIB_TBL8_CHUNK_GROUPS) *
+                          FIB_TBL8_GROUP_NUM + (addrs[i] & 0xff)]);
+    }
+  }
+
+  /* second pass: tbl8. */
+  for (i = 0; i < n; i++) {
+    entry = indexes[i];
+    if ((entry & FIB_ENTRY_EXT) != 0) {
+      group = entry & FIB_ENTRY_INDEX_MASK;
+      entry = __atomic_load_n(&fib->tbl8[group / FIB_TBL8_CHUNK_GROUPS]
+                              [(group % FIB_TBL8_CHUNK_GROUPS) *
+                               FIB_TBL8_GROUP_NUM + (addrs[i] & 0xff)],
+                              __ATOMIC_ACQUIRE);
+    }
+    indexes[i] = ((entry & FIB_ENTRY_VALID) == 0) ?
+                 FIB_LOOKUP_MISS : (entry & FIB_ENTRY_INDEX_MASK);
+  }
+}
+
+/**
+ * Lookup fib for burst of IPv6 addresses.
+ */
+void
+fib6_lookup_bulk(const struct fib_table *fib, const struct in6_addr *addrs,
+                 uint32_t *indexes, unsigned int n) {
+  unsigned int i;
+
+  /* prefetch tbl16 ahead, then walk the tbl8 chains. */
+  for (i = 0; i < n; i++) {
+    if (i + 4 < n) {
+      __builtin_prefetch(&fib->tbl16[(addrs[i + 4].s6_addr[0] << 8) |
+                                     addrs[i + 4].s6_addr[1]]);
+    }
+    indexes[i] = fib6_lookup(fib, &addrs[i]);
+  }
+}
+
+/**
+ * Get consistent copy of adjacency.
+ */
+void
+fib_adjacency_get(const struct fib_table *fib, uint32_t index,
+                  struct fib_adjacency *adj) {
+  const struct fib_adjacency *src = &fib->adjacency[index];
+  uint32_t version;
+
+  do {
+    version = __atomic_load_n(&src->version, __ATOMIC_ACQUIRE);
+    memcpy(adj, src, sizeof(*adj));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((version & 1) != 0 ||
+           version != __atomic_load_n(&src->version, __ATOMIC_RELAXED));
+}
+
+/**
+ * Resolve output ports of adjacencies by mactable.
+ * Only adjacencies marked by ARP/NDP or by mactable changes are resolved,
+ * all of them if mactable lost track of the changes.
+ */
+void
+fib_adjacency_resolve(struct fib_table *fib, struct mactable *mactable) {
+  struct fib_adjacency *adj;
+  uint32_t index, port;
+
+  if (mactable_changed_iterate(mactable, adjacency_mac_changed,
+                               fib) == false) {
+    lagopus_hashmap_iterate(&fib->adjacency_map,
+                            adjacency_mark_iterate, fib);
+    lagopus_hashmap_iterate(&fib->adjacency_map6,
+                            adjacency_mark_iterate, fib);
+  }
+  while (fib->adjacency_dirty != FIB_LOOKUP_MISS) {
+    index = fib->adjacency_dirty;
+    adj = &fib->adjacency[index];
+    fib->adjacency_dirty = adj->dirty_next;
+    adj->dirty = false;
+    port = OFPP_ALL;
+    if (adj->resolved == true) {
+      port = mactable_port_get(mactable, 0, adj->dst_mac);
+    }
+    if (adj->output_port != port) {
+      adjacency_write_begin(adj);
+      adj->output_port = port;
+      adjacency_write_end(adj);
+    }
+  }
+}
+
+/**
+ * Release tbl8 groups and adjacencies that were unlinked
+ * before the last table switching.
+ * Call only after all workers left the critical section.
+ */
+void
+fib_reclaim(struct fib_table *fib) {
+  uint32_t *group;
+
+  while (fib->tbl8_npending > 0) {
+    fib->tbl8_npending--;
+    group = tbl8_group(fib, fib->tbl8_pending[fib->tbl8_npending]);
+    memset(group, 0, FIB_TBL8_GROUP_NUM * sizeof(uint32_t));
+    fib->tbl8_free[fib->tbl8_nfree++] = fib->tbl8_pending[fib->tbl8_npending];
+  }
+  while (fib->adjacency_npending > 0) {
+    fib->adjacency_free[fib->adjacency_nfree++] =
+      fib->adjacency_pending[--fib->adjacency_npending];
+  }
+}
@@ -41,6 +41,8 @@
 #include "../agent/ofp_match.h"
 #include "../agent/openflow13packet.h"
 
+#include "../ofproto/City.h"
+
 #include "lock.h"
 
 #include "callback.h"
@@ -74,6 +76,34 @@ struct flowdb {
 #define GET_OXM_FIELD(ofpat) \
   ((((const struct ofp_action_set_field *)(ofpat))->field[2] >> 1) & 0x7f)
 
+/**
+ * Flow mod apply latency in nsec, see lagopus_histogram_find().
+ */
+static pthread_once_t flow_mod_hist_once = PTHREAD_ONCE_INIT;
+static lagopus_histogram_t flow_mod_hist = NULL;
+
+static void
+flow_mod_hist_init(void) {
+  (void)lagopus_histogram_create(&flow_mod_hist, "dp.flow_mod_apply");
+}
+
+static inline lagopus_chrono_t
+flow_mod_hist_start(void) {
+  lagopus_chrono_t now;
+
+  (void)pthread_once(&flow_mod_hist_once, flow_mod_hist_init);
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(now);
+  return now;
+}
+
+static inline void
+flow_mod_hist_end(lagopus_chrono_t start) {
+  lagopus_chrono_t now;
+
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(now);
+  (void)lagopus_histogram_record(&flow_mod_hist, (int64_t)(now - start));
+}
+
 static lagopus_result_t
 send_flow_removed(uint64_t dpid, struct flow *flow, uint8_t reason);
 
@@ -83,6 +113,15 @@ flow_del_from_meter(struct meter_table *meter_table, struct flow *flow);
 static void
 flow_del_from_group(struct group_table *group_table, struct flow *flow);
 
+static struct flow_index *
+flow_index_alloc(void);
+
+static void
+flow_index_free(struct flow_index *idx);
+
+static void
+flow_index_del(struct flow_index *idx, struct flow *flow);
+
 void
 match_list_entry_free(struct match_list *match_list) {
   struct match *match;
@@ -117,6 +156,7 @@ action_list_entry_free(struct action_list *action_list) {
     TAILQ_REMOVE(action_list, action, entry);
     if (action != NULL) {
       ed_prop_list_free(&action->ed_prop_list);
+      free(action->encap_template);
     }
     free(action);
   }
@@ -267,6 +307,13 @@ table_alloc(uint8_t table_id) {
   table->table_id = table_id;
   table->flow_list = calloc(1, sizeof(struct flow_list)
                             + sizeof(void *) * 65536);
+  table->flow_index = flow_index_alloc();
+  if (table->flow_list == NULL || table->flow_index == NULL) {
+    flow_index_free(table->flow_index);
+    free(table->flow_list);
+    free(table);
+    return NULL;
+  }
   table->flow_list->nbranch = 65536;
   return table;
 }
@@ -301,6 +348,7 @@ table_free(struct table *table) {
   for (i = 0; i < nflow; i++) {
     flow_free(flow_list->flows[i]);
   }
+  flow_index_free(table->flow_index);
   free(flow_list);
   free(table);
 }
@@ -767,6 +815,7 @@ flow_remove_with_reason_nolock(struct flow *flow,
         /* send OFPT_FLOW_REMOVED message */
         ret = send_flow_removed(bridge->dpid, flow, reason);
       }
+      flow_index_del(table->flow_index, flow);
       flow_free(flow);
       flow_list->nflow--;
       if (i < flow_list->nflow) {
@@ -804,57 +853,209 @@ match_compare(struct match_list *ml1, struct match_list *ml2) {
   return true;
 }
 
+/**
+ * @brief Index entry of the flow.
+ */
+struct flow_index_node {
+  struct flow *flow;                            /** Flow. */
+  uint64_t hash;                                /** Hash of the flow. */
+  struct flow_index_node *next;                 /** Next in hash chain. */
+};
+
+#ifndef FLOW_INDEX_INITIAL_BUCKETS
+#define FLOW_INDEX_INITIAL_BUCKETS 256
+#endif /* FLOW_INDEX_INITIAL_BUCKETS */
+
+/**
+ * @brief Index of the flows in the table.
+ * Identical flows are looked up by hash of priority and match list
+ * independent of the order of matches.
+ */
+struct flow_index {
+  size_t nflow;                                 /** Number of flows. */
+  size_t nbucket;                               /** Power of 2. */
+  struct flow_index_node **buckets;             /** Hash chains. */
+};
+
+/* Hash of the flow, the order of matches is ignored. */
+static uint64_t
+flow_index_hash(const struct flow *flow) {
+  const struct match *match;
+  uint64_t hash;
+
+  hash = 0;
+  TAILQ_FOREACH(match, &flow->match_list, entry) {
+    hash += CityHash64WithSeed((const char *)match->oxm_value,
+                               match->oxm_length,
+                               ((uint64_t)match->oxm_class << 16) |
+                               ((uint64_t)match->oxm_field << 8) |
+                               match->oxm_length);
+  }
+  return Hash128to64(hash, (uint64_t)(uint32_t)flow->priority);
+}
+
+/* true if two flows have the same priority and the same matches. */
 static bool
-flow_compare(struct flow *f1, struct flow *f2) {
-  struct match *m1;
-  struct match *m2;
+flow_identical(struct flow *f1, struct flow *f2) {
+  const struct match *match;
+  int n1, n2;
 
-  /* Priority compare. */
-  if (f1->priority != f2->priority) {
+  if (f1->priority != f2->priority || f1->field_bits != f2->field_bits) {
     return false;
   }
+  n1 = n2 = 0;
+  TAILQ_FOREACH(match, &f1->match_list, entry) {
+    n1++;
+  }
+  TAILQ_FOREACH(match, &f2->match_list, entry) {
+    n2++;
+  }
+  return (n1 == n2 && match_compare(&f1->match_list, &f2->match_list));
+}
 
-  /* Field bits compare. */
-  if (f1->field_bits != f2->field_bits) {
-    return false;
+static struct flow_index *
+flow_index_alloc(void) {
+  struct flow_index *idx;
+
+  idx = calloc(1, sizeof(struct flow_index));
+  if (idx == NULL) {
+    return NULL;
+  }
+  idx->nbucket = FLOW_INDEX_INITIAL_BUCKETS;
+  idx->buckets = calloc(idx->nbucket, sizeof(struct flow_index_node *));
+  if (idx->buckets == NULL) {
+    free(idx);
+    return NULL;
   }
+  return idx;
+}
 
-  m1 = TAILQ_FIRST(&f1->match_list);
-  m2 = TAILQ_FIRST(&f2->match_list);
+static void
+flow_index_free(struct flow_index *idx) {
+  struct flow_index_node *node;
+  size_t i;
 
-  while (m1 && m2) {
-    if (m1->oxm_class != m2->oxm_class ||
-        m1->oxm_field != m2->oxm_field ||
-        m1->oxm_length != m2->oxm_length ||
-        memcmp(m1->oxm_value, m2->oxm_value, m1->oxm_length) != 0) {
-      return false;
+  if (idx == NULL) {
+    return;
+  }
+  for (i = 0; i < idx->nbucket; i++) {
+    while ((node = idx->buckets[i]) != NULL) {
+      idx->buckets[i] = node->next;
+      free(node);
     }
+  }
+  free(idx->buckets);
+  free(idx);
+}
 
-    m1 = TAILQ_NEXT(m1, entry);
-    m2 = TAILQ_NEXT(m2, entry);
+/* Double the hash chains. */
+static void
+flow_index_grow(struct flow_index *idx) {
+  struct flow_index_node **buckets, *node;
+  size_t nbucket, i;
+
+  nbucket = idx->nbucket * 2;
+  buckets = calloc(nbucket, sizeof(struct flow_index_node *));
+  if (buckets == NULL) {
+    /* keep longer chains. */
+    return;
+  }
+  for (i = 0; i < idx->nbucket; i++) {
+    while ((node = idx->buckets[i]) != NULL) {
+      idx->buckets[i] = node->next;
+      node->next = buckets[node->hash & (nbucket - 1)];
+      buckets[node->hash & (nbucket - 1)] = node;
+    }
   }
+  free(idx->buckets);
+  idx->buckets = buckets;
+  idx->nbucket = nbucket;
+}
 
-  if (m1 != m2) {
-    return false;
+static lagopus_result_t
+flow_index_add(struct flow_index *idx, struct flow *flow) {
+  struct flow_index_node *node;
+  size_t i;
+
+  node = malloc(sizeof(struct flow_index_node));
+  if (node == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
   }
+  if (idx->nflow >= idx->nbucket) {
+    flow_index_grow(idx);
+  }
+  node->flow = flow;
+  node->hash = flow_index_hash(flow);
+  i = node->hash & (idx->nbucket - 1);
+  node->next = idx->buckets[i];
+  idx->buckets[i] = node;
+  idx->nflow++;
 
-  return true;
+  return LAGOPUS_RESULT_OK;
+}
+
+static void
+flow_index_del(struct flow_index *idx, struct flow *flow) {
+  struct flow_index_node **nodep, *node;
+
+  nodep = &idx->buckets[flow_index_hash(flow) & (idx->nbucket - 1)];
+  while ((node = *nodep) != NULL) {
+    if (node->flow == flow) {
+      break;
+    }
+    nodep = &node->next;
+  }
+  if (node == NULL) {
+    return;
+  }
+  *nodep = node->next;
+
+  free(node);
+  idx->nflow--;
 }
 
+/* Lookup the flow identical to the flow. */
 static struct flow *
-flow_exist_sub(struct flow *flow, struct flow_list *flow_list) {
-  int i;
-  bool same;
+flow_index_lookup(struct flow_index *idx, struct flow *flow) {
+  struct flow_index_node *node;
+  uint64_t hash;
 
-  for (i = 0; i < flow_list->nflow; i++) {
-    same = flow_compare(flow, flow_list->flows[i]);
-    if (same == true) {
-      return flow_list->flows[i];
+  hash = flow_index_hash(flow);
+  for (node = idx->buckets[hash & (idx->nbucket - 1)];
+       node != NULL; node = node->next) {
+    if (node->hash == hash && flow_identical(flow, node->flow) == true) {
+      return node->flow;
     }
   }
   return NULL;
 }
 
+/* Position of the flow in the list sorted by priority, or -1. */
+static int
+flow_list_position(struct flow_list *flow_list, struct flow *flow) {
+  int st, ed, off;
+
+  st = 0;
+  ed = flow_list->nflow;
+  while (st < ed) {
+    off = st + (ed - st) / 2;
+    if (flow_list->flows[off]->priority > flow->priority) {
+      st = off + 1;
+    } else {
+      ed = off;
+    }
+  }
+  for (; st < flow_list->nflow; st++) {
+    if (flow_list->flows[st] == flow) {
+      return st;
+    }
+    if (flow_list->flows[st]->priority != flow->priority) {
+      break;
+    }
+  }
+  return -1;
+}
+
 static struct action *
 flow_action_examination(struct flow *flow,
                         struct action_list *action_list) {
@@ -957,6 +1158,9 @@ flow_instruction_examination(struct flow *flow) {
       }
     }
     if (instruction->ofpit.type == OFPIT_APPLY_ACTIONS) {
+      if (lagopus_register_action_list_hook != NULL) {
+        lagopus_register_action_list_hook(&instruction->action_list);
+      }
       output = flow_action_examination(flow, &instruction->action_list);
     }
   }
@@ -1004,13 +1208,13 @@ out:
 }
 
 
-/* Flow add API. */
-lagopus_result_t
-flowdb_flow_add(struct bridge *bridge,
-                struct ofp_flow_mod *flow_mod,
-                struct match_list *match_list,
-                struct instruction_list *instruction_list,
-                struct ofp_error *error) {
+/* Flow add, the caller holds the write lock. */
+static lagopus_result_t
+flowdb_flow_add_nolock(struct bridge *bridge,
+                       struct ofp_flow_mod *flow_mod,
+                       struct match_list *match_list,
+                       struct instruction_list *instruction_list,
+                       struct ofp_error *error) {
   struct flowdb *flowdb;
   struct table *table;
   struct flow *flow;
@@ -1028,9 +1232,6 @@ flowdb_flow_add(struct bridge *bridge,
 
   flowdb = bridge->flowdb;
 
-  /* Write lock the flowdb. */
-  flowdb_wrlock(flowdb);
-
   /* Get table. */
   table = flowdb_get_table(flowdb, flow_mod->table_id);
   if (table == NULL) {
@@ -1063,12 +1264,8 @@ flowdb_flow_add(struct bridge *bridge,
     goto out;
   }
 
-  /* Overlapping flow check. */
-  if (lagopus_find_flow_hook != NULL) {
-    identical_flow = lagopus_find_flow_hook(flow, table);
-  } else {
-    identical_flow = flow_exist_sub(flow, table->flow_list);
-  }
+  /* Identical flow check. */
+  identical_flow = flow_index_lookup(table->flow_index, flow);
   if (identical_flow != NULL) {
     /* Check if overlapped entry exist.  see 6.4 Flow Table Modification
      * Messages. */
@@ -1124,8 +1321,16 @@ flowdb_flow_add(struct bridge *bridge,
     }
     /* Examine apply-action for dataplane. */
     flow_instruction_examination(flow);
+    ret = flow_index_add(table->flow_index, flow);
+    if (ret != LAGOPUS_RESULT_OK) {
+      flow_free(flow);
+      goto out;
+    }
+    flow->seq = ++table->flow_seq;
     ret = flow_add_sub(flow, table->flow_list);
     if (ret != LAGOPUS_RESULT_OK) {
+      flow_index_del(table->flow_index, flow);
+      flow_free(flow);
       goto out;
     }
     if (lagopus_add_flow_hook != NULL) {
@@ -1148,30 +1353,56 @@ flowdb_flow_add(struct bridge *bridge,
 #endif /* USE_MBTREE */
   }
 
-  /* Clear flow cache */
+out:
+  return ret;
+}
+
+/* Clear flow cache of the workers. */
+static void
+flowdb_flowcache_clear(void) {
 #ifdef HAVE_DPDK
   clear_worker_flowcache(false);
 #endif /* HAVE_DPDK */
   clear_rawsock_flowcache();
+}
+
+/* Flow add API. */
+lagopus_result_t
+flowdb_flow_add(struct bridge *bridge,
+                struct ofp_flow_mod *flow_mod,
+                struct match_list *match_list,
+                struct instruction_list *instruction_list,
+                struct ofp_error *error) {
+  lagopus_result_t ret;
+
+  /* Write lock the flowdb. */
+  flowdb_wrlock(bridge->flowdb);
+
+  ret = flowdb_flow_add_nolock(bridge, flow_mod,
+                               match_list, instruction_list, error);
+  if (ret == LAGOPUS_RESULT_OK) {
+    flowdb_flowcache_clear();
+  }
 
-out:
   /* Unlock the flowdb then return result. */
-  flowdb_wrunlock(flowdb);
+  flowdb_wrunlock(bridge->flowdb);
   return ret;
 }
 
 static lagopus_result_t
 flow_modify_sub(struct bridge *bridge,
                 struct ofp_flow_mod *flow_mod,
-                struct flow_list *flow_list,
+                struct table *table,
                 struct match_list *match_list,
                 struct instruction_list *instruction_list,
                 struct ofp_error *error,
                 int strict) {
-  struct flow *flow;
+  struct flow_list *flow_list;
+  struct flow *flow, *target;
   lagopus_result_t ret;
   int i;
 
+  flow_list = table->flow_list;
   ret = flow_alloc(flow_mod, match_list, instruction_list, &flow, error);
   if (flow == NULL) {
     goto out;
@@ -1193,30 +1424,28 @@ flow_modify_sub(struct bridge *bridge,
     /*
      * strict. modify identical flow specified by flow_mod.
      */
-    for (i = 0; i < flow_list->nflow; i++) {
-      if (flow_compare(flow, flow_list->flows[i]) == true) {
-        flow_del_from_meter(bridge->meter_table, flow_list->flows[i]);
-        flow_del_from_group(bridge->group_table, flow_list->flows[i]);
-        if ((flow_mod->flags & OFPFF_RESET_COUNTS) != 0) {
-          flow_list->flows[i]->packet_count = 0;
-          flow_list->flows[i]->byte_count = 0;
-        }
-        instruction_list_entry_free(&flow_list->flows[i]->instruction_list);
-        copy_instruction_list(&flow_list->flows[i]->instruction_list,
-                              &flow->instruction_list);
-        map_instruction_list_to_array(flow_list->flows[i]->instruction,
-                                      &flow_list->flows[i]->instruction_list,
-                                      error);
-        if (ret != LAGOPUS_RESULT_OK) {
-          goto out;
-        }
-        ret = flow_action_check(bridge, flow, error);
-        if (ret != LAGOPUS_RESULT_OK) {
-          goto out;
-        }
-        flow_instruction_examination(flow);
-        break;
+    target = flow_index_lookup(table->flow_index, flow);
+    if (target != NULL) {
+      flow_del_from_meter(bridge->meter_table, target);
+      flow_del_from_group(bridge->group_table, target);
+      if ((flow_mod->flags & OFPFF_RESET_COUNTS) != 0) {
+        target->packet_count = 0;
+        target->byte_count = 0;
+      }
+      instruction_list_entry_free(&target->instruction_list);
+      copy_instruction_list(&target->instruction_list,
+                            &flow->instruction_list);
+      map_instruction_list_to_array(target->instruction,
+                                    &target->instruction_list,
+                                    error);
+      if (ret != LAGOPUS_RESULT_OK) {
+        goto out;
+      }
+      ret = flow_action_check(bridge, flow, error);
+      if (ret != LAGOPUS_RESULT_OK) {
+        goto out;
       }
+      flow_instruction_examination(target);
     }
     flow_free(flow);
   } else {
@@ -1463,7 +1692,7 @@ flow_del_sub(struct bridge *bridge,
   struct group_table *group_table;
   struct meter_table *meter_table;
   struct instruction_list instruction_list;
-  struct flow *flow;
+  struct flow *flow, *target;
   lagopus_result_t ret;
   int i;
 
@@ -1484,25 +1713,25 @@ flow_del_sub(struct bridge *bridge,
     if (ret != LAGOPUS_RESULT_OK) {
       goto out;
     }
-    for (i = 0; i < flow_list->nflow; i++) {
-      if (flow_compare(flow, flow_list->flows[i]) == true) {
-        if (lagopus_del_flow_hook != NULL) {
-          lagopus_del_flow_hook(flow_list->flows[i], table);
-        }
-        flow_del_from_group(group_table, flow_list->flows[i]);
-        flow_del_from_meter(meter_table, flow_list->flows[i]);
-        if ((flow_list->flows[i]->flags & OFPFF_SEND_FLOW_REM) != 0) {
-          /* send OFPT_FLOW_REMOVED message */
-          ret = send_flow_removed(bridge->dpid, flow, OFPRR_DELETE);
-        }
-        flow_free(flow_list->flows[i]);
-        flow_list->nflow--;
-        if (i < flow_list->nflow) {
-          memmove(&flow_list->flows[i], &flow_list->flows[i + 1],
-                  sizeof(struct flow *) *
-                  (unsigned int)(flow_list->nflow - i));
-        }
-        break;
+    target = flow_index_lookup(table->flow_index, flow);
+    i = (target != NULL ? flow_list_position(flow_list, target) : -1);
+    if (i >= 0) {
+      if (lagopus_del_flow_hook != NULL) {
+        lagopus_del_flow_hook(target, table);
+      }
+      flow_del_from_group(group_table, target);
+      flow_del_from_meter(meter_table, target);
+      if ((target->flags & OFPFF_SEND_FLOW_REM) != 0) {
+        /* send OFPT_FLOW_REMOVED message */
+        ret = send_flow_removed(bridge->dpid, flow, OFPRR_DELETE);
+      }
+      flow_index_del(table->flow_index, target);
+      flow_free(target);
+      flow_list->nflow--;
+      if (i < flow_list->nflow) {
+        memmove(&flow_list->flows[i], &flow_list->flows[i + 1],
+                sizeof(struct flow *) *
+                (unsigned int)(flow_list->nflow - i));
       }
     }
     flow_free(flow);
@@ -1554,6 +1783,7 @@ flow_del_sub(struct bridge *bridge,
           ret = send_flow_removed(bridge->dpid, flow, OFPRR_DELETE);
         }
         flow_list->flows[i] = NULL;
+        flow_index_del(table->flow_index, flow);
         flow_free(flow);
 #ifdef USE_MBTREE
         if (flow_list->update_timer != NULL) {
@@ -1602,7 +1832,7 @@ table_flow_modify(struct bridge *bridge, struct table *table,
                   struct ofp_error *error,
                   int strict) {
   flow_modify_sub(bridge, flow_mod,
-                  table->flow_list,
+                  table,
                   match_list, instruction_list,
                   error, strict);
   return LAGOPUS_RESULT_OK;
@@ -1621,12 +1851,13 @@ table_flow_delete(struct bridge *bridge,
 }
 
 
-lagopus_result_t
-flowdb_flow_modify(struct bridge *bridge,
-                   struct ofp_flow_mod *flow_mod,
-                   struct match_list *match_list,
-                   struct instruction_list *instruction_list,
-                   struct ofp_error *error) {
+/* Flow modify, the caller holds the write lock. */
+static lagopus_result_t
+flowdb_flow_modify_nolock(struct bridge *bridge,
+                          struct ofp_flow_mod *flow_mod,
+                          struct match_list *match_list,
+                          struct instruction_list *instruction_list,
+                          struct ofp_error *error) {
   struct flow flow;
   struct table *table;
   lagopus_result_t result;
@@ -1654,9 +1885,6 @@ flowdb_flow_modify(struct bridge *bridge,
     return LAGOPUS_RESULT_OFP_ERROR;
   }
 
-  /* Write lock the flowdb. */
-  flowdb_wrlock(bridge->flowdb);
-
   /* Get table. */
   table = flowdb_get_table(bridge->flowdb, flow_mod->table_id);
   if (table == NULL) {
@@ -1664,32 +1892,43 @@ flowdb_flow_modify(struct bridge *bridge,
     error->code = OFPFMFC_BAD_TABLE_ID;
     lagopus_msg_info("flow modify: %d: table not found (%d:%d)\n",
                      flow_mod->table_id, error->type, error->code);
-    result = LAGOPUS_RESULT_OFP_ERROR;
-    goto out;
+    return LAGOPUS_RESULT_OFP_ERROR;
   }
 
   /* Modify table. */
-  result = table_flow_modify(bridge, table, &flow, flow_mod,
-                             match_list, instruction_list,
-                             error, strict);
+  return table_flow_modify(bridge, table, &flow, flow_mod,
+                           match_list, instruction_list,
+                           error, strict);
+}
 
-  /* Clear flow cache */
-#ifdef HAVE_DPDK
-  clear_worker_flowcache(false);
-#endif /* HAVE_DPDK */
-  clear_rawsock_flowcache();
+lagopus_result_t
+flowdb_flow_modify(struct bridge *bridge,
+                   struct ofp_flow_mod *flow_mod,
+                   struct match_list *match_list,
+                   struct instruction_list *instruction_list,
+                   struct ofp_error *error) {
+  lagopus_result_t result;
+
+  /* Write lock the flowdb. */
+  flowdb_wrlock(bridge->flowdb);
+
+  result = flowdb_flow_modify_nolock(bridge, flow_mod,
+                                     match_list, instruction_list, error);
+  if (result == LAGOPUS_RESULT_OK) {
+    flowdb_flowcache_clear();
+  }
 
   /* Unlock the flowdb and return result. */
-out:
   flowdb_wrunlock(bridge->flowdb);
   return result;
 }
 
-lagopus_result_t
-flowdb_flow_delete(struct bridge *bridge,
-                   struct ofp_flow_mod *flow_mod,
-                   struct match_list *match_list,
-                   struct ofp_error *error) {
+/* Flow delete, the caller holds the write lock. */
+static lagopus_result_t
+flowdb_flow_delete_nolock(struct bridge *bridge,
+                          struct ofp_flow_mod *flow_mod,
+                          struct match_list *match_list,
+                          struct ofp_error *error) {
   struct flowdb *flowdb;
   int i;
   struct flow flow;
@@ -1712,9 +1951,6 @@ flowdb_flow_delete(struct bridge *bridge,
 
   flowdb = bridge->flowdb;
 
-  /* Write lock the flowdb. */
-  flowdb_wrlock(flowdb);
-
   /* OFPTT_ALL means targeting all tables. */
   if (flow_mod->table_id == OFPTT_ALL) {
     for (i = 0; i < flowdb->table_size; i++) {
@@ -1734,26 +1970,321 @@ flowdb_flow_delete(struct bridge *bridge,
       error->code = OFPFMFC_BAD_TABLE_ID;
       lagopus_msg_info("flow delete: %d: table not found (%d:%d)\n",
                        flow_mod->table_id, error->type, error->code);
-      result = LAGOPUS_RESULT_OFP_ERROR;
-      goto out;
+      return LAGOPUS_RESULT_OFP_ERROR;
     }
     table_flow_delete(bridge,
                       table, &flow, flow_mod, match_list,
                       strict, error);
   }
 
-  /* Clear flow cache */
-#ifdef HAVE_DPDK
-  clear_worker_flowcache(false);
-#endif /* HAVE_DPDK */
-  clear_rawsock_flowcache();
+  return result;
+}
+
+lagopus_result_t
+flowdb_flow_delete(struct bridge *bridge,
+                   struct ofp_flow_mod *flow_mod,
+                   struct match_list *match_list,
+                   struct ofp_error *error) {
+  lagopus_result_t result;
+
+  /* Write lock the flowdb. */
+  flowdb_wrlock(bridge->flowdb);
+
+  result = flowdb_flow_delete_nolock(bridge, flow_mod, match_list, error);
+  if (result == LAGOPUS_RESULT_OK) {
+    flowdb_flowcache_clear();
+  }
 
   /* Unlock the flowdb and return result. */
-out:
-  flowdb_wrunlock(flowdb);
+  flowdb_wrunlock(bridge->flowdb);
   return result;
 }
 
+/**
+ * @brief Flow mod queued in the batch.
+ */
+struct flowdb_batch_entry {
+  struct ofp_flow_mod flow_mod;                 /** Flow mod. */
+  struct match_list match_list;                 /** Match list. */
+  struct instruction_list instruction_list;     /** Instruction list. */
+  struct ofp_error *error;                      /** Error of the caller. */
+  lagopus_result_t result;                      /** Result. */
+};
+
+/**
+ * @brief Batch of flow mods.
+ */
+struct flowdb_batch {
+  struct bridge *bridge;                        /** Target bridge. */
+  size_t nentry;                                /** Number of entries. */
+  size_t size;                                  /** Size of entries. */
+  struct flowdb_batch_entry **entries;          /** Entries in order. */
+};
+
+#ifndef FLOWDB_BATCH_INITIAL_SIZE
+#define FLOWDB_BATCH_INITIAL_SIZE 64
+#endif /* FLOWDB_BATCH_INITIAL_SIZE */
+
+/* Examine flow mod without the flowdb. */
+static lagopus_result_t
+flow_mod_validate(struct ofp_flow_mod *flow_mod,
+                  struct match_list *match_list,
+                  struct ofp_error *error) {
+  struct flow flow;
+  lagopus_result_t ret;
+
+  switch (flow_mod->command) {
+    case OFPFC_ADD:
+    case OFPFC_MODIFY:
+    case OFPFC_MODIFY_STRICT:
+      /* OFPIT_ALL is invalid for add and modify. */
+      if (flow_mod->table_id == OFPTT_ALL) {
+        error->type = OFPET_FLOW_MOD_FAILED;
+        error->code = OFPFMFC_BAD_TABLE_ID;
+        return LAGOPUS_RESULT_OFP_ERROR;
+      }
+      break;
+    case OFPFC_DELETE:
+    case OFPFC_DELETE_STRICT:
+      break;
+    default:
+      error->type = OFPET_FLOW_MOD_FAILED;
+      error->code = OFPFMFC_BAD_COMMAND;
+      return LAGOPUS_RESULT_OFP_ERROR;
+  }
+  flow.priority = flow_mod->priority;
+  flow.flags = flow_mod->flags;
+  ret = flow_pre_requisite_check(&flow, match_list, error);
+  if (ret == LAGOPUS_RESULT_OK && flow_mod->command == OFPFC_ADD) {
+    ret = flow_mask_check(match_list, error);
+  }
+  return ret;
+}
+
+/* Release lists which are not consumed by the flowdb. */
+static void
+flowdb_batch_entry_lists_free(struct flowdb_batch_entry *entry) {
+  match_list_entry_free(&entry->match_list);
+  instruction_list_entry_free(&entry->instruction_list);
+}
+
+lagopus_result_t
+flowdb_flow_batch_begin(struct bridge *bridge, struct flowdb_batch **batchp) {
+  struct flowdb_batch *batch;
+
+  if (bridge == NULL || batchp == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  batch = calloc(1, sizeof(struct flowdb_batch));
+  if (batch == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  batch->bridge = bridge;
+  *batchp = batch;
+
+  return LAGOPUS_RESULT_OK;
+}
+
+lagopus_result_t
+flowdb_flow_batch_add(struct flowdb_batch *batch,
+                      struct ofp_flow_mod *flow_mod,
+                      struct match_list *match_list,
+                      struct instruction_list *instruction_list,
+                      struct ofp_error *error) {
+  struct flowdb_batch_entry *entry;
+  struct flowdb_batch_entry **entries;
+  size_t size;
+
+  if (batch == NULL || flow_mod == NULL ||
+      match_list == NULL || error == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  if (batch->nentry == batch->size) {
+    size = (batch->size == 0 ? FLOWDB_BATCH_INITIAL_SIZE : batch->size * 2);
+    entries = realloc(batch->entries, size * sizeof(*entries));
+    if (entries == NULL) {
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
+    batch->entries = entries;
+    batch->size = size;
+  }
+  entry = malloc(sizeof(struct flowdb_batch_entry));
+  if (entry == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  entry->flow_mod = *flow_mod;
+  TAILQ_INIT(&entry->match_list);
+  TAILQ_CONCAT(&entry->match_list, match_list, entry);
+  TAILQ_INIT(&entry->instruction_list);
+  if (instruction_list != NULL) {
+    TAILQ_CONCAT(&entry->instruction_list, instruction_list, entry);
+  }
+  entry->error = error;
+  entry->result = LAGOPUS_RESULT_NOT_STARTED;
+  batch->entries[batch->nentry++] = entry;
+
+  return LAGOPUS_RESULT_OK;
+}
+
+lagopus_result_t
+flowdb_flow_batch_commit(struct flowdb_batch *batch, bool atomic) {
+  struct flowdb_batch_entry *entry;
+  struct bridge *bridge;
+  lagopus_result_t ret, result;
+  lagopus_chrono_t start;
+  bool applied;
+  size_t i;
+
+  if (batch == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  bridge = batch->bridge;
+  ret = LAGOPUS_RESULT_OK;
+
+  /* Examine all entries before taking the lock. */
+  for (i = 0; i < batch->nentry; i++) {
+    entry = batch->entries[i];
+    if (entry->result != LAGOPUS_RESULT_NOT_STARTED) {
+      continue;
+    }
+    result = flow_mod_validate(&entry->flow_mod,
+                               &entry->match_list, entry->error);
+    if (result != LAGOPUS_RESULT_OK) {
+      entry->result = result;
+      ret = result;
+    }
+  }
+  if (atomic == true && ret != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
+
+  /* Apply all entries in order with a single lock and cache flush. */
+  applied = false;
+  flowdb_wrlock(bridge->flowdb);
+  for (i = 0; i < batch->nentry; i++) {
+    entry = batch->entries[i];
+    if (entry->result != LAGOPUS_RESULT_NOT_STARTED) {
+      continue;
+    }
+    start = flow_mod_hist_start();
+    switch (entry->flow_mod.command) {
+      case OFPFC_ADD:
+        result = flowdb_flow_add_nolock(bridge, &entry->flow_mod,
+                                        &entry->match_list,
+                                        &entry->instruction_list,
+                                        entry->error);
+        break;
+      case OFPFC_MODIFY:
+      case OFPFC_MODIFY_STRICT:
+        result = flowdb_flow_modify_nolock(bridge, &entry->flow_mod,
+                                           &entry->match_list,
+                                           &entry->instruction_list,
+                                           entry->error);
+        break;
+      default:
+        result = flowdb_flow_delete_nolock(bridge, &entry->flow_mod,
+                                           &entry->match_list,
+                                           entry->error);
+        break;
+    }
+    flow_mod_hist_end(start);
+    entry->result = result;
+    applied = true;
+    if (result != LAGOPUS_RESULT_OK) {
+      ret = result;
+      if (atomic == true) {
+        break;
+      }
+    }
+  }
+  if (applied == true) {
+    flowdb_flowcache_clear();
+  }
+  flowdb_wrunlock(bridge->flowdb);
+
+out:
+  for (i = 0; i < batch->nentry; i++) {
+    flowdb_batch_entry_lists_free(batch->entries[i]);
+  }
+  return ret;
+}
+
+size_t
+flowdb_flow_batch_count(struct flowdb_batch *batch) {
+  return batch->nentry;
+}
+
+lagopus_result_t
+flowdb_flow_batch_result_get(struct flowdb_batch *batch, size_t n) {
+  if (batch == NULL || n >= batch->nentry) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return batch->entries[n]->result;
+}
+
+void
+flowdb_flow_batch_free(struct flowdb_batch *batch) {
+  size_t i;
+
+  if (batch == NULL) {
+    return;
+  }
+  for (i = 0; i < batch->nentry; i++) {
+    flowdb_batch_entry_lists_free(batch->entries[i]);
+    free(batch->entries[i]);
+  }
+  free(batch->entries);
+  free(batch);
+}
+
+static bool
+flow_stats_match(struct flow *flow,
+                 struct ofp_flow_stats_request *request,
+                 struct match_list *match_list) {
+  if (request->cookie_mask != 0) {
+    if ((flow->cookie & request->cookie_mask) !=
+        (request->cookie & request->cookie_mask)) {
+      return false;
+    }
+  }
+  return match_compare(&flow->match_list, match_list);
+}
+
+static void
+flow_stats_ofp_set(struct ofp_flow_stats *ofp,
+                   struct flow *flow,
+                   int table_id,
+                   const struct timespec *ts) {
+  ofp->table_id = (uint8_t)table_id;
+#define COPY_STATS(member) ofp->member = flow->member
+  COPY_STATS(idle_timeout);
+  COPY_STATS(hard_timeout);
+  ofp->priority = (uint16_t)flow->priority;
+  COPY_STATS(flags);
+  COPY_STATS(cookie);
+  if ((flow->flags & OFPFF_NO_PKT_COUNTS) == 0) {
+    COPY_STATS(packet_count);
+  } else {
+    ofp->packet_count =  0xffffffffffffffff;
+  }
+  if ((flow->flags & OFPFF_NO_BYT_COUNTS) == 0) {
+    COPY_STATS(byte_count);
+  } else {
+    ofp->byte_count = 0xffffffffffffffff;
+  }
+#undef COPY_STATS
+
+  ofp->duration_sec = (uint32_t)(ts->tv_sec - flow->create_time.tv_sec);
+  if (ts->tv_nsec < flow->create_time.tv_nsec) {
+    ofp->duration_sec--;
+    ofp->duration_nsec = 1 * 1000 * 1000 * 1000;
+  } else {
+    ofp->duration_nsec = 0;
+  }
+  ofp->duration_nsec += (uint32_t)ts->tv_nsec;
+  ofp->duration_nsec -= (uint32_t)flow->create_time.tv_nsec;
+}
+
 static lagopus_result_t
 table_flow_stats(struct table *table,
                  int table_id,
@@ -1772,48 +2303,14 @@ table_flow_stats(struct table *table,
   flow_list = table->flow_list;
   for (i = 0; i < flow_list->nflow; i++) {
     flow = flow_list->flows[i];
-    if (request->cookie_mask != 0) {
-      if ((flow->cookie & request->cookie_mask) !=
-          (request->cookie & request->cookie_mask)) {
-        continue;
-      }
-    }
-    if (match_compare(&flow->match_list, match_list) == true) {
+    if (flow_stats_match(flow, request, match_list) == true) {
       /* make flow stats. */
       flow_stats = calloc(1, sizeof(struct flow_stats));
       if (flow_stats == NULL) {
         goto out;
       }
-      flow_stats->ofp.table_id = (uint8_t)table_id;
-#define COPY_STATS(member) flow_stats->ofp.member = flow->member
-      COPY_STATS(idle_timeout);
-      COPY_STATS(hard_timeout);
-      flow_stats->ofp.priority = (uint16_t)flow->priority;
-      COPY_STATS(flags);
-      COPY_STATS(cookie);
-      if ((flow->flags & OFPFF_NO_PKT_COUNTS) == 0) {
-        COPY_STATS(packet_count);
-      } else {
-        flow_stats->ofp.packet_count =  0xffffffffffffffff;
-      }
-      if ((flow->flags & OFPFF_NO_BYT_COUNTS) == 0) {
-        COPY_STATS(byte_count);
-      } else {
-        flow_stats->ofp.byte_count = 0xffffffffffffffff;
-      }
-#undef COPY_STATS
-
       clock_gettime(CLOCK_MONOTONIC, &ts);
-      flow_stats->ofp.duration_sec =
-        (uint32_t)(ts.tv_sec - flow->create_time.tv_sec);
-      if (ts.tv_nsec < flow->create_time.tv_nsec) {
-        flow_stats->ofp.duration_sec--;
-        flow_stats->ofp.duration_nsec = 1 * 1000 * 1000 * 1000;
-      } else {
-        flow_stats->ofp.duration_nsec = 0;
-      }
-      flow_stats->ofp.duration_nsec += (uint32_t)ts.tv_nsec;
-      flow_stats->ofp.duration_nsec -= (uint32_t)flow->create_time.tv_nsec;
+      flow_stats_ofp_set(&flow_stats->ofp, flow, table_id, &ts);
 
       /* copy lists. */
       TAILQ_INIT(&flow_stats->match_list);
@@ -1909,6 +2406,107 @@ table_flow_counts(struct table *table,
   }
 }
 
+/*
+ * Flows are sorted by priority, and by seq within a priority since
+ * they are added to the end of the priority.
+ */
+int
+flow_list_resume_position(struct flow_list *flow_list,
+                          int32_t priority, uint64_t seq) {
+  struct flow *flow;
+  int st, ed, off;
+
+  if (seq == 0) {
+    return 0;
+  }
+  st = 0;
+  ed = flow_list->nflow;
+  while (st < ed) {
+    off = st + (ed - st) / 2;
+    flow = flow_list->flows[off];
+    if (flow->priority > priority ||
+        (flow->priority == priority && flow->seq <= seq)) {
+      st = off + 1;
+    } else {
+      ed = off;
+    }
+  }
+  return st;
+}
+
+lagopus_result_t
+flowdb_flow_stats_iterate(struct flowdb *flowdb,
+                          struct ofp_flow_stats_request *request,
+                          struct match_list *match_list,
+                          struct flowdb_flow_stats_cursor *cursor,
+                          flowdb_flow_stats_proc_t proc,
+                          void *arg,
+                          struct ofp_error *error) {
+  struct timespec ts;
+  struct ofp_flow_stats ofp;
+  struct flow_list *flow_list;
+  struct table *table;
+  struct flow *flow;
+  int budget, i;
+  lagopus_result_t rv;
+
+  (void) error;
+
+  if (flowdb == NULL || request == NULL || match_list == NULL ||
+      cursor == NULL || proc == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  if (cursor->done == true) {
+    return LAGOPUS_RESULT_OK;
+  }
+
+  rv = LAGOPUS_RESULT_OK;
+  budget = FLOWDB_FLOW_STATS_CHUNK;
+  if (request->table_id != OFPTT_ALL) {
+    cursor->table_id = request->table_id;
+  }
+  memset(&ofp, 0, sizeof(ofp));
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  /* Read lock the flowdb, missing tables are not created. */
+  flowdb_rdlock(flowdb);
+
+  while (cursor->table_id < flowdb->table_size) {
+    table = table_lookup(flowdb, (uint8_t)cursor->table_id);
+    if (table != NULL) {
+      flow_list = table->flow_list;
+      for (i = flow_list_resume_position(flow_list, cursor->priority,
+                                         cursor->seq);
+           i < flow_list->nflow; i++) {
+        if (budget-- == 0) {
+          goto out;
+        }
+        flow = flow_list->flows[i];
+        if (flow_stats_match(flow, request, match_list) == true) {
+          flow_stats_ofp_set(&ofp, flow, cursor->table_id, &ts);
+          rv = proc(&ofp, &flow->match_list, &flow->instruction_list, arg);
+          if (rv != LAGOPUS_RESULT_OK) {
+            goto out;
+          }
+        }
+        cursor->priority = flow->priority;
+        cursor->seq = flow->seq;
+      }
+    }
+    if (request->table_id != OFPTT_ALL) {
+      break;
+    }
+    cursor->table_id++;
+    cursor->priority = 0;
+    cursor->seq = 0;
+  }
+  cursor->done = true;
+
+out:
+  flowdb_rdunlock(flowdb);
+  return rv;
+}
+
 lagopus_result_t
 flowdb_aggregate_stats(struct flowdb *flowdb,
                        struct ofp_aggregate_stats_request *request,
@@ -2799,6 +3397,7 @@ ofp_flow_mod_check_add(uint64_t dpid,
                        struct instruction_list *instruction_list,
                        struct ofp_error *error) {
   struct bridge *bridge;
+  lagopus_chrono_t start;
   lagopus_result_t ret;
 
   bridge = dp_bridge_lookup_by_dpid(dpid);
@@ -2806,13 +3405,27 @@ ofp_flow_mod_check_add(uint64_t dpid,
     return LAGOPUS_RESULT_NOT_FOUND;
   }
 
+  start = flow_mod_hist_start();
   ret =  flowdb_flow_add(bridge,
                          flow_mod,
                          match_list, instruction_list,
                          error);
+  flow_mod_hist_end(start);
   return ret;
 }
 
+lagopus_result_t
+ofp_flow_mod_batch_begin(uint64_t dpid, struct flowdb_batch **batchp) {
+  struct bridge *bridge;
+
+  bridge = dp_bridge_lookup_by_dpid(dpid);
+  if (bridge == NULL) {
+    return LAGOPUS_RESULT_NOT_FOUND;
+  }
+
+  return flowdb_flow_batch_begin(bridge, batchp);
+}
+
 lagopus_result_t
 ofp_flow_mod_modify(uint64_t dpid,
                     struct ofp_flow_mod *flow_mod,
@@ -2820,6 +3433,7 @@ ofp_flow_mod_modify(uint64_t dpid,
                     struct instruction_list *instruction_list,
                     struct ofp_error *error) {
   struct bridge *bridge;
+  lagopus_chrono_t start;
   lagopus_result_t ret;
 
   bridge = dp_bridge_lookup_by_dpid(dpid);
@@ -2830,9 +3444,11 @@ ofp_flow_mod_modify(uint64_t dpid,
   switch (flow_mod->command) {
     case OFPFC_MODIFY:
     case OFPFC_MODIFY_STRICT:
+      start = flow_mod_hist_start();
       ret = flowdb_flow_modify(bridge, flow_mod,
                                match_list, instruction_list,
                                error);
+      flow_mod_hist_end(start);
       break;
     default:
       error->type = OFPET_FLOW_MOD_FAILED;
@@ -2851,6 +3467,7 @@ ofp_flow_mod_delete(uint64_t dpid,
                     struct match_list *match_list,
                     struct ofp_error *error) {
   struct bridge *bridge;
+  lagopus_chrono_t start;
   lagopus_result_t ret;
 
   bridge = dp_bridge_lookup_by_dpid(dpid);
@@ -2861,7 +3478,9 @@ ofp_flow_mod_delete(uint64_t dpid,
   switch (flow_mod->command) {
     case OFPFC_DELETE:
     case OFPFC_DELETE_STRICT:
+      start = flow_mod_hist_start();
       ret = flowdb_flow_delete(bridge, flow_mod, match_list, error);
+      flow_mod_hist_end(start);
       break;
     default:
       error->type = OFPET_FLOW_MOD_FAILED;
@@ -2894,6 +3513,25 @@ ofp_flow_stats_get(uint64_t dpid,
                            flow_stats_list, error);
 }
 
+lagopus_result_t
+ofp_flow_stats_iterate(uint64_t dpid,
+                       struct ofp_flow_stats_request *flow_stats_request,
+                       struct match_list *match_list,
+                       struct flowdb_flow_stats_cursor *cursor,
+                       flowdb_flow_stats_proc_t proc,
+                       void *arg,
+                       struct ofp_error *error) {
+  struct bridge *bridge;
+
+  bridge = dp_bridge_lookup_by_dpid(dpid);
+  if (bridge == NULL) {
+    return LAGOPUS_RESULT_NOT_FOUND;
+  }
+
+  return flowdb_flow_stats_iterate(bridge->flowdb, flow_stats_request,
+                                   match_list, cursor, proc, arg, error);
+}
+
 /*
  * table_stats (Agent/DP API)
  */
@@ -25,6 +25,7 @@
 #include "lagopus/interface.h"
 
 #include "lagopus/ofp_dp_apis.h" /* for port_stats */
+#include "bonding.h"
 #ifdef HAVE_DPDK
 #include "dpdk.h"
 #endif /* HAVE_DPDK */
@@ -81,6 +82,12 @@ dp_interface_free(struct interface *ifp) {
   if (ifp == NULL) {
     return LAGOPUS_RESULT_INVALID_ARGS;
   }
+  if (ifp->bond != NULL) {
+    bonding_free(ifp->bond);
+  }
+  if (ifp->master != NULL) {
+    bonding_slave_delete(ifp->master->bond, ifp);
+  }
   lagopus_hashmap_destroy(&ifp->queueid_hashmap, false);
   free(ifp);
   return LAGOPUS_RESULT_OK;
@@ -364,7 +371,7 @@ interface_l3_routing(struct lagopus_packet *pkt,
                      struct interface *ifp) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
   uint16_t ether_type;
-  int prefix;
+  uint8_t prefix;
 
   ether_type = lagopus_get_ethertype(pkt);
 
@@ -411,8 +418,41 @@ interface_l3_routing(struct lagopus_packet *pkt,
     }
 #endif
   } else if (ether_type == ETHERTYPE_IPV6) {
-    /* TODO: */
-    lagopus_packet_free(pkt);
+    struct in6_addr dst_addr6;
+
+    /* initialize l3 routing */
+    pkt->ifp = ifp;
+    pkt->send_kernel = false;
+
+    /* get dst ip address from input packet */
+    lagopus_get_ip(pkt, &dst_addr6, AF_INET6);
+
+    /*
+     * link-local and multicast(including ndp) are handled by kernel,
+     * self addresses are routed to kernel by their host routes.
+     */
+    if (IN6_IS_ADDR_LINKLOCAL(&dst_addr6) ||
+        IN6_IS_ADDR_MULTICAST(&dst_addr6)) {
+      return dp_interface_send_packet_kernel(pkt, ifp);
+    }
+
+#if defined HYBRID && defined PIPELINER
+    pkt->pipeline_context.pipeline_idx = L3_PIPELINE;
+    pipeline_process(pkt);
+#else
+    /* learning l2 info */
+    mactable_port_learning(pkt);
+
+    /* l3 routing */
+    rv = rib_lookup(pkt);
+
+    /* forwarding packet */
+    if (rv == LAGOPUS_RESULT_OK) {
+      send_packet(pkt);
+    } else if (rv == LAGOPUS_RESULT_NOT_FOUND) {
+      return LAGOPUS_RESULT_OK;
+    }
+#endif
   } else {
     /* nothing to do. */
     lagopus_msg_info("not support packets. ethertype = %d\n", ether_type);
@@ -453,6 +493,11 @@ dp_interface_send_packet_normal(struct lagopus_packet *pkt,
 
 lagopus_result_t
 dp_interface_hw_addr_get_internal(struct interface *ifp, uint8_t *hw_addr) {
+  if (ifp->bond != NULL) {
+    /* bond uses address of the first slave. */
+    memcpy(hw_addr, ifp->hw_addr, ETHER_ADDR_LEN);
+    return LAGOPUS_RESULT_OK;
+  }
   switch (ifp->info.type) {
     case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_PHY:
     case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_VDEV:
@@ -512,6 +557,35 @@ dp_interface_stats_get_internal(struct interface *ifp,
   return LAGOPUS_RESULT_INVALID_ARGS;
 }
 
+lagopus_result_t
+dp_interface_link_status_get_internal(struct interface *ifp, bool *link_up) {
+  switch (ifp->info.type) {
+    case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_PHY:
+    case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_VDEV:
+#ifdef HAVE_DPDK
+      return dpdk_get_link_status(ifp->info.eth.port_number, link_up);
+#else
+      break;
+#endif
+    case DATASTORE_INTERFACE_TYPE_ETHERNET_RAWSOCK:
+      return rawsock_get_link_status(ifp, link_up);
+
+    case DATASTORE_INTERFACE_TYPE_UNKNOWN:
+    case DATASTORE_INTERFACE_TYPE_GRE:
+    case DATASTORE_INTERFACE_TYPE_NVGRE:
+    case DATASTORE_INTERFACE_TYPE_VXLAN:
+    case DATASTORE_INTERFACE_TYPE_VHOST_USER:
+      /* no physical link. */
+      *link_up = true;
+      return LAGOPUS_RESULT_OK;
+
+    default:
+      break;
+  }
+
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
 lagopus_result_t
 dp_interface_stats_clear_internal(struct interface *ifp) {
   switch (ifp->info.type) {
@@ -37,6 +37,8 @@
 
 #define NR_MAX_ENTRIES 1024  /**< max number that can be registered
                                   in the bbq. */
+#define REFRESH_PORTID OFPP_ANY  /**< portid of the bbq entry that only
+                                      refreshes the update time. */
 
 /**
  * Struct mac entry args for get all entries from mactable.
@@ -86,17 +88,19 @@ get_local_data (struct mactable *mactable) {
  * Create mac entry.
  * mac entry is struct macentry object.
  * @param[in] inteth MAC address.
+ * @param[in] vid VLAN ID.
  * @param[in] portid In port number.
  * @param[in] address_type Type(static or dynamic) of mac address learning.
  */
 static struct macentry *
-macentry_alloc(uint64_t inteth, uint32_t portid,
+macentry_alloc(uint64_t inteth, uint16_t vid, uint32_t portid,
                uint16_t address_type) {
   struct macentry *entry;
 
   entry = calloc(1, sizeof(struct macentry));
   if (entry != NULL) {
     entry->inteth = inteth;
+    entry->vid = vid;
     entry->portid = portid;
     entry->address_type = address_type;
   }
@@ -134,9 +138,13 @@ copy_macentry(void *key, void *val, lagopus_hashentry_t he, void *arg) {
   struct macentry_args *ma = (struct macentry_args *)arg;
   struct macentry *entries = (struct macentry *)ma->entries;
   struct macentry *entry = (struct macentry *)val;
+  (void) key;
+  (void) he;
 
   if (val != NULL && ma->no < ma->num) {
     entries[ma->no].inteth = entry->inteth;
+    entries[ma->no].vid = entry->vid;
+    entries[ma->no].moves = entry->moves;
     entries[ma->no].portid = entry->portid;
     entries[ma->no].update_time = entry->update_time;
     entries[ma->no].address_type = entry->address_type;
@@ -151,17 +159,17 @@ copy_macentry(void *key, void *val, lagopus_hashentry_t he, void *arg) {
  * Add mac entry to bbq.
  * @param[in] mactable MAC address table.
  * @param[in] inteth MAC address
+ * @param[in] vid VLAN ID.
  * @param[in] portid In port number.
  * @param[in] address_type Setting address type.
- * @param[in] now Update time.
  */
 static inline lagopus_result_t
-add_entry_bbq(struct local_data *local, uint64_t inteth,
+add_entry_bbq(struct local_data *local, uint64_t inteth, uint16_t vid,
               uint32_t portid, uint16_t address_type) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
   struct macentry *entry;
 
-  entry = macentry_alloc(inteth, portid, address_type);
+  entry = macentry_alloc(inteth, vid, portid, address_type);
   if (entry) {
     lagopus_bbq_put(&local->bbq, &entry, struct macentry *, 0);
   } else {
@@ -171,107 +179,543 @@ add_entry_bbq(struct local_data *local, uint64_t inteth,
   return rv;
 }
 
-
 /**
- * Add mac entry to mactable for writing.
- * @param[in] mactable MAC address table.
- * @param[in] write_table MAC address table for writing.
- * @param[in] inteth MAC address
- * @param[in] portid In port number.
- * @param[in] address_type Setting address type.
- * @param[in] now Update time.
+ * Hash function for the lookup table.
+ * @param[in] key VLAN ID and MAC address.
  */
-static lagopus_result_t
-add_entry_write_table(struct mactable *mactable, lagopus_hashmap_t *write_table,
-                      uint64_t inteth, uint32_t portid, uint16_t address_type,
-                      struct timespec now) {
-  lagopus_result_t rv;
-  struct macentry *entry;
-  struct macentry *dentry;
-  struct macentry *find_entry;
+static inline uint64_t
+mac_hash(uint64_t key) {
+  /* finalizer of MurmurHash3. */
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
 
-  if (mactable == NULL || write_table == NULL) {
-    rv = LAGOPUS_RESULT_INVALID_ARGS;
-    goto out;
+/**
+ * Get two candidate buckets of the MAC address.
+ * @param[in] table Lookup table.
+ * @param[in] key VLAN ID and MAC address.
+ * @param[out] b Index of the candidate buckets.
+ */
+static inline void
+cuckoo_buckets(const struct mactable_cuckoo *table, uint64_t key,
+               uint32_t b[2]) {
+  uint64_t hash = mac_hash(key);
+
+  b[0] = (uint32_t)hash & table->mask;
+  b[1] = (uint32_t)(hash >> 32) & table->mask;
+  if (b[1] == b[0]) {
+    b[1] = (b[0] + 1) & table->mask;
   }
+}
 
-  /* allcate new entry. */
-  entry = macentry_alloc(inteth, portid, address_type);
-  if (entry == NULL) {
-    rv = LAGOPUS_RESULT_NO_MEMORY;
-    goto out;
+/**
+ * Allocate lookup table.
+ * @param[in] nentries Number of entries to be stored.
+ */
+static struct mactable_cuckoo *
+cuckoo_alloc(uint32_t nentries) {
+  struct mactable_cuckoo *table;
+  uint32_t nbuckets = 2;
+
+  /* keep load factor under 50% at max entries. */
+  while (nbuckets * MACTABLE_BUCKET_ENTRIES < nentries * 2 &&
+         nbuckets < (1U << 31)) {
+    nbuckets <<= 1;
+  }
+  table = calloc(1, sizeof(struct mactable_cuckoo) +
+                 sizeof(struct macbucket) * nbuckets);
+  if (table != NULL) {
+    table->mask = nbuckets - 1;
   }
-  entry->update_time = now;
-  dentry = entry;
 
-  /* if same key(inteth) entry was already registered,
-     update entry in hashmap_add(4th argument means allow overwrite). */
-  rv = lagopus_hashmap_find_no_lock(write_table,
-                                    (void *)inteth,
-                                    (void **)&find_entry);
-  if (rv == LAGOPUS_RESULT_NOT_FOUND) {
-    /* new entry */
-    if (entry->address_type == MACTABLE_SETTYPE_DYNAMIC) {
-      TAILQ_INSERT_TAIL(&mactable->macentry_list, entry, next);
+  return table;
+}
+
+/**
+ * Find mac entry in a bucket without lock.
+ * @param[in] bucket Bucket of the lookup table.
+ * @param[in] key VLAN ID and MAC address.
+ * @param[out] slot Copy of the found entry.
+ */
+static inline bool
+cuckoo_bucket_find(const struct macbucket *bucket, uint64_t key,
+                   struct macslot *slot) {
+  uint32_t version;
+  bool found;
+  int i;
+
+  for (;;) {
+    version = __atomic_load_n(&bucket->version, __ATOMIC_ACQUIRE);
+    if (unlikely((version & 1) != 0)) {
+      /* 'updater' is writing to this bucket. */
+      continue;
+    }
+    found = false;
+    for (i = 0; i < MACTABLE_BUCKET_ENTRIES; i++) {
+      if (bucket->slot[i].key == key) {
+        *slot = bucket->slot[i];
+        found = true;
+        break;
+      }
     }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&bucket->version, __ATOMIC_RELAXED) == version) {
+      return found;
+    }
+  }
+}
 
-    mactable->nentries++;
-  } else if (find_entry != NULL && rv == LAGOPUS_RESULT_OK) {
-    /* update entry */
-    if (find_entry->address_type == MACTABLE_SETTYPE_DYNAMIC) {
-      TAILQ_REMOVE(&mactable->macentry_list, find_entry, next);
-      TAILQ_INSERT_TAIL(&mactable->macentry_list, entry, next);
-    } else {
-      dentry->address_type = MACTABLE_SETTYPE_STATIC;
+/**
+ * Get output port and address type by mac address from the lookup table.
+ * This function is called by workers and takes no lock.
+ * @param[in] table Lookup table.
+ * @param[in] key VLAN ID and MAC address.
+ * @param[out] port Number of output port.
+ * @param[out] address_type Address type.
+ */
+static inline lagopus_result_t
+lookup(struct mactable_cuckoo *table, uint64_t key,
+       uint32_t *port, uint16_t *address_type) {
+  struct macslot slot;
+  uint32_t b[2];
+  uint32_t move_version;
+
+  if (table == NULL || port == NULL || address_type == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  cuckoo_buckets(table, key, b);
+  for (;;) {
+    move_version = __atomic_load_n(&table->move_version, __ATOMIC_ACQUIRE);
+    if (cuckoo_bucket_find(&table->bucket[b[0]], key, &slot) == true ||
+        cuckoo_bucket_find(&table->bucket[b[1]], key, &slot) == true) {
+      *port = slot.portid;
+      *address_type = slot.address_type;
+      return LAGOPUS_RESULT_OK;
+    }
+    /* entry may have been moved between buckets while looking up. */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if ((move_version & 1) == 0 &&
+        __atomic_load_n(&table->move_version, __ATOMIC_RELAXED) ==
+        move_version) {
+      return LAGOPUS_RESULT_NOT_FOUND;
     }
-  } else {
-    lagopus_msg_error("lagopus hashmap find failed\n");
-    goto out;
   }
+}
 
-  rv = lagopus_hashmap_add_no_lock(write_table, (void *)inteth,
-                                   (void **)&dentry, true);
+/**
+ * Start writing to a bucket('updater' only).
+ */
+static inline void
+cuckoo_write_begin(struct macbucket *bucket) {
+  __atomic_store_n(&bucket->version, bucket->version + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
 
-out:
-  return rv;
+/**
+ * End writing to a bucket('updater' only).
+ */
+static inline void
+cuckoo_write_end(struct macbucket *bucket) {
+  __atomic_store_n(&bucket->version, bucket->version + 1, __ATOMIC_RELEASE);
 }
 
 /**
- * Write entry to local cache.
- * @param[in] h Hashamap for local cache.
- * @param[in] inteth MAC address
+ * Find the slot of mac entry('updater' only).
+ * @param[in] table Lookup table.
+ * @param[in] key VLAN ID and MAC address.
+ * @param[out] bucket Bucket that has the entry.
+ * @retval >=0 Index of the slot in the bucket.
+ * @retval <0 Not found.
+ */
+static int
+cuckoo_slot_get(struct mactable_cuckoo *table, uint64_t key,
+                struct macbucket **bucket) {
+  uint32_t b[2];
+  int i, j;
+
+  cuckoo_buckets(table, key, b);
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < MACTABLE_BUCKET_ENTRIES; j++) {
+      if (table->bucket[b[i]].slot[j].key == key) {
+        *bucket = &table->bucket[b[i]];
+        return j;
+      }
+    }
+  }
+  return -1;
+}
+
+/**
+ * Write mac entry to a slot of the bucket('updater' only).
+ */
+static inline void
+cuckoo_slot_set(struct macbucket *bucket, int i, uint64_t key,
+                uint32_t portid, uint16_t address_type) {
+  cuckoo_write_begin(bucket);
+  bucket->slot[i].portid = portid;
+  bucket->slot[i].address_type = address_type;
+  bucket->slot[i].key = key;
+  cuckoo_write_end(bucket);
+}
+
+/**
+ * Insert mac entry to the lookup table('updater' only).
+ * If both candidate buckets are full, existing entries are moved
+ * to their alternative buckets.  The whole path is decided before
+ * any entry is moved, and the entries are moved from the tail of
+ * the path, so that every entry is always stored in one of buckets.
+ * @param[in] table Lookup table.
+ * @param[in] key VLAN ID and MAC address.
  * @param[in] portid Port number.
- * @param[in] address_type Type(static or dynamic) of mac address learning.
+ * @param[in] address_type Address type.
+ */
+static lagopus_result_t
+cuckoo_insert(struct mactable_cuckoo *table, uint64_t key,
+              uint32_t portid, uint16_t address_type) {
+  struct {
+    uint32_t bucket;
+    int slot;
+  } path[MACTABLE_CUCKOO_MAX_DEPTH];
+  struct macbucket *src;
+  uint32_t b[2], alt[2], bidx;
+  int depth, i, j, k, free_slot = -1;
+
+  cuckoo_buckets(table, key, b);
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < MACTABLE_BUCKET_ENTRIES; j++) {
+      if (table->bucket[b[i]].slot[j].key == 0) {
+        cuckoo_slot_set(&table->bucket[b[i]], j, key, portid, address_type);
+        return LAGOPUS_RESULT_OK;
+      }
+    }
+  }
+
+  /* search the path to an empty slot. */
+  bidx = b[key & 1];
+  for (depth = 0; depth < MACTABLE_CUCKOO_MAX_DEPTH; depth++) {
+    /* choose a victim that is not in the path yet. */
+    j = (int)(((key >> (depth % 48)) + (uint64_t)depth) %
+              MACTABLE_BUCKET_ENTRIES);
+    for (i = 0; i < MACTABLE_BUCKET_ENTRIES; i++) {
+      for (k = 0; k < depth; k++) {
+        if (path[k].bucket == bidx && path[k].slot == j) {
+          break;
+        }
+      }
+      if (k == depth) {
+        break;
+      }
+      j = (j + 1) % MACTABLE_BUCKET_ENTRIES;
+    }
+    if (i == MACTABLE_BUCKET_ENTRIES) {
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
+    path[depth].bucket = bidx;
+    path[depth].slot = j;
+
+    /* go to the alternative bucket of the victim. */
+    cuckoo_buckets(table, table->bucket[bidx].slot[j].key, alt);
+    bidx = (alt[0] == bidx) ? alt[1] : alt[0];
+    for (j = 0; j < MACTABLE_BUCKET_ENTRIES; j++) {
+      if (table->bucket[bidx].slot[j].key == 0) {
+        free_slot = j;
+        break;
+      }
+    }
+    if (free_slot >= 0) {
+      break;
+    }
+  }
+  if (free_slot < 0) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+
+  /* move entries, readers retry lookup if they missed during moving. */
+  __atomic_store_n(&table->move_version, table->move_version + 1,
+                   __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  for (k = depth; k >= 0; k--) {
+    src = &table->bucket[path[k].bucket];
+    cuckoo_slot_set(&table->bucket[bidx], free_slot,
+                    src->slot[path[k].slot].key,
+                    src->slot[path[k].slot].portid,
+                    src->slot[path[k].slot].address_type);
+    cuckoo_slot_set(src, path[k].slot, 0, 0, 0);
+    bidx = path[k].bucket;
+    free_slot = path[k].slot;
+  }
+  cuckoo_slot_set(&table->bucket[bidx], free_slot,
+                  key, portid, address_type);
+  __atomic_store_n(&table->move_version, table->move_version + 1,
+                   __ATOMIC_RELEASE);
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Remove mac entry from the lookup table('updater' only).
+ * @param[in] table Lookup table.
+ * @param[in] key VLAN ID and MAC address.
+ */
+static void
+cuckoo_delete(struct mactable_cuckoo *table, uint64_t key) {
+  struct macbucket *bucket;
+  int i;
+
+  i = cuckoo_slot_get(table, key, &bucket);
+  if (i >= 0) {
+    cuckoo_slot_set(bucket, i, 0, 0, 0);
+  }
+}
+
+/**
+ * Insert an entry to the new lookup table when growing.
+ */
+static bool
+rebuild_entry(void *key, void *val, lagopus_hashentry_t he, void *arg) {
+  struct mactable_cuckoo *table = (struct mactable_cuckoo *)arg;
+  struct macentry *entry = (struct macentry *)val;
+  (void) key;
+  (void) he;
+
+  return (cuckoo_insert(table, MACTABLE_KEY(entry->vid, entry->inteth),
+                        entry->portid,
+                        entry->address_type) == LAGOPUS_RESULT_OK);
+}
+
+/**
+ * Replace the lookup table with the larger one('updater' only).
+ * Old table is released by release_retired_tables() after all workers
+ * stop referring it.
+ * @param[in] mactable MAC address table.
  */
 static lagopus_result_t
-add_entry_local_cache(lagopus_hashmap_t *h, uint64_t inteth,
-                  uint32_t portid, uint16_t address_type) {
-  lagopus_result_t rv = LAGOPUS_RESULT_ANY_FAILURES;
+grow_table(struct mactable *mactable) {
+  struct mactable_cuckoo *table, *old = mactable->table;
+  lagopus_result_t rv;
+
+  table = cuckoo_alloc((old->mask + 1) * MACTABLE_BUCKET_ENTRIES);
+  if (table == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  rv = lagopus_hashmap_iterate_no_lock(&mactable->entries,
+                                       rebuild_entry, table);
+  if (rv != LAGOPUS_RESULT_OK) {
+    free(table);
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+
+  lagopus_msg_info("mactable grows to %u buckets.\n", table->mask + 1);
+  __atomic_store_n(&mactable->table, table, __ATOMIC_RELEASE);
+  old->retired = mactable->retired;
+  mactable->retired = old;
+
+  return LAGOPUS_RESULT_OK;
+}
+
+/**
+ * Free retired lookup tables if no worker refers them('updater' only).
+ * A worker may refer retired tables only while it is in a critical
+ * section('referring' is 1) started before the last generation update.
+ * @param[in] mactable MAC address table.
+ */
+static void
+release_retired_tables(struct mactable *mactable) {
+  struct mactable_cuckoo *table;
+  uint32_t generation;
+  int cnt;
+
+  if (mactable->retired == NULL) {
+    return;
+  }
+  generation = __sync_add_and_fetch(&mactable->generation, 0);
+  for (cnt = 0; cnt < UPDATER_LOCALDATA_MAX_NUM; cnt++) {
+    uint32_t referred =
+      __sync_add_and_fetch(&mactable->local[cnt].referred_generation, 0);
+    if (referred != generation) {
+      uint16_t referring =
+        __sync_add_and_fetch(&mactable->local[cnt].referring, 0);
+      if (referring != 0) {
+        /* try again at next update. */
+        return;
+      }
+    }
+  }
+  while ((table = mactable->retired) != NULL) {
+    mactable->retired = table->retired;
+    free(table);
+  }
+}
+
+/**
+ * Get index of the ageing bucket for the dynamic entry.
+ * The entry belongs to the bucket of the second it expires.
+ * @param[in] mactable MAC address table.
+ * @param[in] entry MAC address entry.
+ */
+static inline uint16_t
+age_bucket_index(struct mactable *mactable, struct macentry *entry) {
+  time_t expire = entry->update_time.tv_sec +
+                  (time_t)(mactable->age_time > 0 ? mactable->age_time : 1);
+  return (uint16_t)(expire % MACTABLE_AGE_BUCKETS);
+}
+
+/**
+ * Register dynamic entry to the ageing bucket('updater' only).
+ * @param[in] mactable MAC address table.
+ * @param[in] entry MAC address entry.
+ */
+static inline void
+age_bucket_insert(struct mactable *mactable, struct macentry *entry) {
+  entry->age_bucket = age_bucket_index(mactable, entry);
+  TAILQ_INSERT_TAIL(&mactable->age_bucket[entry->age_bucket], entry, next);
+}
+
+/**
+ * Rebuild ageing buckets when ageing time is changed('updater' only).
+ * @param[in] mactable MAC address table.
+ */
+static void
+age_bucket_rebuild(struct mactable *mactable) {
+  struct macentry_list list;
   struct macentry *entry;
+  int i;
 
-  entry = macentry_alloc(inteth, portid, address_type);
-  rv = lagopus_hashmap_add_no_lock(h, (void *)inteth, (void **)&entry, true);
+  TAILQ_INIT(&list);
+  for (i = 0; i < MACTABLE_AGE_BUCKETS; i++) {
+    TAILQ_CONCAT(&list, &mactable->age_bucket[i], next);
+  }
+  mactable->age_time = mactable->ageing_time;
+  while ((entry = TAILQ_FIRST(&list)) != NULL) {
+    TAILQ_REMOVE(&list, entry, next);
+    age_bucket_insert(mactable, entry);
+  }
+}
 
-  return rv;
+/**
+ * Record untagged address of which output port was changed('updater' only).
+ * @param[in] mactable MAC address table.
+ * @param[in] inteth MAC address
+ * @param[in] vid VLAN ID.
+ */
+static void
+changed_record(struct mactable *mactable, uint64_t inteth, uint16_t vid) {
+  if (vid != 0 || mactable->nchanged > MACTABLE_CHANGED_MAX) {
+    return;
+  }
+  if (mactable->nchanged < MACTABLE_CHANGED_MAX) {
+    mactable->changed[mactable->nchanged] = inteth;
+  }
+  mactable->nchanged++;
 }
 
 /**
- * Get output port and address type by mac address from mac address table
- * (local cache or reading mac address table).
- * @param[in] h Target hashmap(localcache or reading mactable).
- * @param[in] inteth MAC address.
- * @param[out] port Number of output port.
+ * Add or update mac entry('updater' only).
+ * Only the changed entry is written to the lookup table.
+ * Dynamic entry learned on other port is detected as MAC move.
+ * @param[in] mactable MAC address table.
+ * @param[in] inteth MAC address
+ * @param[in] vid VLAN ID.
+ * @param[in] portid In port number(REFRESH_PORTID: refresh update time only).
+ * @param[in] address_type Setting address type.
+ * @param[in] now Update time.
  */
-static inline lagopus_result_t
-lookup(lagopus_hashmap_t *h, uint64_t inteth,
-       uint32_t *port, uint16_t *address_type) {
-  lagopus_result_t rv = LAGOPUS_RESULT_ANY_FAILURES;
-  struct macentry *dentry;
+static lagopus_result_t
+update_entry(struct mactable *mactable, uint64_t inteth, uint16_t vid,
+             uint32_t portid, uint16_t address_type, struct timespec now) {
+  lagopus_result_t rv;
+  struct macentry *entry, *dentry;
+  struct macbucket *bucket;
+  uint64_t key;
+  int i;
 
-  rv = lagopus_hashmap_find_no_lock(h, (void *)inteth, (void **)&dentry);
-  if (rv == LAGOPUS_RESULT_OK) {
-    *port = dentry->portid;
-    *address_type = dentry->address_type;
+  if (mactable == NULL || inteth == 0 || vid >= MACTABLE_VLAN_MAX) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  key = MACTABLE_KEY(vid, inteth);
+
+  rv = lagopus_hashmap_find_no_lock(&mactable->entries,
+                                    (void *)key, (void **)&entry);
+  if (rv == LAGOPUS_RESULT_NOT_FOUND) {
+    if (portid == REFRESH_PORTID) {
+      /* aged out after referred. */
+      return LAGOPUS_RESULT_OK;
+    }
+    /* new entry */
+    if (mactable->nentries >= mactable->maxentries ||
+        (mactable->vlan_maxentries != 0 &&
+         mactable->vlan_nentries[vid] >= mactable->vlan_maxentries)) {
+      return LAGOPUS_RESULT_TOO_MANY_OBJECTS;
+    }
+    entry = macentry_alloc(inteth, vid, portid, address_type);
+    if (entry == NULL) {
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
+    entry->update_time = now;
+    rv = cuckoo_insert(mactable->table, key, portid, address_type);
+    if (rv == LAGOPUS_RESULT_NO_MEMORY) {
+      rv = grow_table(mactable);
+      if (rv == LAGOPUS_RESULT_OK) {
+        rv = cuckoo_insert(mactable->table, key, portid, address_type);
+      }
+    }
+    if (rv != LAGOPUS_RESULT_OK) {
+      macentry_free(entry);
+      return rv;
+    }
+    dentry = entry;
+    rv = lagopus_hashmap_add_no_lock(&mactable->entries, (void *)key,
+                                     (void **)&dentry, false);
+    if (rv != LAGOPUS_RESULT_OK) {
+      cuckoo_delete(mactable->table, key);
+      macentry_free(entry);
+      return rv;
+    }
+    if (address_type == MACTABLE_SETTYPE_DYNAMIC) {
+      age_bucket_insert(mactable, entry);
+    }
+    mactable->nentries++;
+    mactable->vlan_nentries[vid]++;
+    changed_record(mactable, inteth, vid);
+  } else if (rv == LAGOPUS_RESULT_OK) {
+    /* update entry */
+    entry->update_time = now;
+    if (portid == REFRESH_PORTID) {
+      /* ageing bucket is corrected lazily by age_out_entries(). */
+      return LAGOPUS_RESULT_OK;
+    }
+    if (entry->address_type == MACTABLE_SETTYPE_STATIC) {
+      if (address_type == MACTABLE_SETTYPE_DYNAMIC) {
+        /* static entry is not moved by learning. */
+        return LAGOPUS_RESULT_OK;
+      }
+    } else if (address_type == MACTABLE_SETTYPE_STATIC) {
+      TAILQ_REMOVE(&mactable->age_bucket[entry->age_bucket], entry, next);
+    } else if (entry->portid != portid) {
+      entry->moves++;
+      mactable->nmoves++;
+      lagopus_msg_info("mac move detected(vid %u): port %u -> %u.\n",
+                       vid, entry->portid, portid);
+    }
+    if (entry->portid != portid ||
+        entry->address_type != address_type) {
+      if (entry->portid != portid) {
+        changed_record(mactable, inteth, vid);
+      }
+      entry->portid = portid;
+      entry->address_type = address_type;
+      i = cuckoo_slot_get(mactable->table, key, &bucket);
+      if (i >= 0) {
+        cuckoo_slot_set(bucket, i, key, portid, entry->address_type);
+      }
+    }
+  } else {
+    lagopus_msg_error("lagopus hashmap find failed\n");
   }
 
   return rv;
@@ -282,12 +726,11 @@ lookup(lagopus_hashmap_t *h, uint64_t inteth,
  */
 static lagopus_result_t
 check_eth_history (struct local_data *local, uint64_t inteth, bool switched) {
-  lagopus_result_t rv;
   int i;
 
-  /* mactable were switched, clear history. */
+  /* mactable were updated, clear history. */
   if (unlikely(switched)) {
-    /* clear history to reset when mactables are switched. */
+    /* clear history to notify references again after each update. */
     for (i = 0; i < MACTABLE_HISTORY_MAX_NUM; i++) {
       local->eth_history[i] = 0;
     }
@@ -312,43 +755,42 @@ check_eth_history (struct local_data *local, uint64_t inteth, bool switched) {
 }
 
 /**
- * Reset referred flag, check and return result if switched.
+ * Update referred generation, check and return result if updated.
  * @param[in] mactable MAC address table.
  * @param[in] local Local data for each worker.
  */
 static bool
 check_referred(struct mactable *mactable, struct local_data *local) {
-  uint32_t referred = __sync_val_compare_and_swap(&local->referred_table,
-                                                  mactable->read_table^1,
-                                                  mactable->read_table);
-  if (referred == local->referred_table) {
+  uint32_t generation = __atomic_load_n(&mactable->generation,
+                                        __ATOMIC_ACQUIRE);
+  if (generation == local->referred_generation) {
     return false;
   } else {
+    __atomic_store_n(&local->referred_generation, generation,
+                     __ATOMIC_RELEASE);
     return true;
   }
 }
 
 /**
- * Learning mac address to mac address table(write to local cache or bbq).
+ * Learning mac address to mac address table(write to bbq).
  * When writing to the bbq, thinning the duplicate entry.
  * @param[in] mactable MAC address table.
  * @param[in] portid Target port no.
+ * @param[in] vid VLAN ID.
  * @param[in] ethaddr Target mac address.
  * @param[in] address_type Type(static or dynamic) of mac address learning.
  */
 static lagopus_result_t
 learn_port(struct mactable *mactable,
            uint32_t portid,
+           uint16_t vid,
            const uint8_t ethaddr[],
            uint16_t address_type) {
   uint64_t inteth = array_to_uint64(ethaddr);
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  lagopus_hashmap_t *h;
-  struct macentry *entry, *dentry;
   struct local_data *local;
-  int i;
   bool switched;
-  uint32_t read_table, referred;
 
   if (mactable == NULL) {
     rv = LAGOPUS_RESULT_INVALID_ARGS;
@@ -358,60 +800,43 @@ learn_port(struct mactable *mactable,
   /* get local data. */
   local = get_local_data(mactable);
 
-  /* check reference index. */
+  /* check generation of mactable. */
   switched = check_referred(mactable, local);
-  if (switched) {
-    /* clear local cache. */
-    lagopus_hashmap_clear(&local->localcache, true);
-  }
-
-  /* find entry, then write to cache if not found. */
-  rv = lagopus_hashmap_find_no_lock(&local->localcache,
-                                    (void *)inteth, (void **)&dentry);
-  if (rv == LAGOPUS_RESULT_NOT_FOUND) {
-    rv = add_entry_local_cache(&local->localcache, inteth,
-                               portid, address_type);
-    if (rv != LAGOPUS_RESULT_OK) {
-      /* failed lookup from local cache. */
-      lagopus_msg_warning("local cache operation failed(%d).\n", rv);
-      goto out;
-    }
-  }
 
   /* thinning out the entry to be added to the queue, *
    * to reduce the load on the 'updater'.             */
-  if (check_eth_history(local, inteth, switched) == LAGOPUS_RESULT_NOT_FOUND) {
-    /* 'updater' updates the update_time in macentry. *
-     * therefore, 'worker' add an entry to the bbq,   *
-     * to notify that there was reference.            */
-    rv = add_entry_bbq(local, inteth, portid, address_type);
+  if (check_eth_history(local, MACTABLE_KEY(vid, inteth),
+                        switched) == LAGOPUS_RESULT_NOT_FOUND) {
+    /* 'updater' adds the entry or updates the update_time *
+     * in macentry. therefore, 'worker' add an entry to    *
+     * the bbq, to notify that there was reference.        */
+    rv = add_entry_bbq(local, inteth, vid, portid, address_type);
   }
 
-out:
   return rv;
 }
 
 /**
- * Get output port by the mac address
- * in mac address table(local cache or reading mac address table).
+ * Get output port by the mac address in mac address table.
+ * Entries learned on other VLANs never match.
  * @param[in] mactable MAC address table.
+ * @param[in] vid VLAN ID.
  * @param[in] ethaddr MAC address.
  */
 static uint32_t
 lookup_port(struct mactable *mactable,
+            uint16_t vid,
             const uint8_t ethaddr[]) {
-  lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  lagopus_hashmap_t *h;
-  uint64_t inteth = array_to_uint64(ethaddr);
+  lagopus_result_t rv;
+  struct mactable_cuckoo *table;
+  uint64_t key = MACTABLE_KEY(vid, array_to_uint64(ethaddr));
   uint32_t port;
   uint16_t addr_type;
   struct local_data *local;
-  bool switched = false;
-  uint32_t read_table, referred;
+  bool switched;
 
   if (mactable == NULL) {
-    rv = LAGOPUS_RESULT_INVALID_ARGS;
-    return OFPP_ALL;
+    return OFPP_FLOOD;
   }
 
   /* get local data. */
@@ -422,40 +847,29 @@ lookup_port(struct mactable *mactable,
     Before performing the operation on mactable, it must be turned on(1).
     Then, after the operation ends, it must be turned off(0).
     Only worker's operation(learning and lookup) to change this flag.
+    'updater' does not free the lookup table replaced while any worker
+    refers it, see release_retired_tables().
    */
   __sync_add_and_fetch(&local->referring, 1);
 
-  /* check reference index. */
+  /* check generation of mactable. */
   switched = check_referred(mactable, local);
-  if (switched) {
-    /* clear local cache. */
-    lagopus_hashmap_clear(&local->localcache, true);
-  } else {
-    /* check local cache. */
-    rv = lookup(&local->localcache, inteth, &port, &addr_type);
-    if (rv == LAGOPUS_RESULT_OK) {
-      goto out;
-    }
-  }
 
-  /* lookup from read mactable */
-  read_table = __sync_add_and_fetch(&mactable->read_table, 0);
-  h = &mactable->hashmap[read_table];
-  rv = lookup(h, inteth, &port, &addr_type);
-  if (rv == LAGOPUS_RESULT_OK) {
-    /* write to local cache(no entry in local cache). */
-    add_entry_local_cache(&local->localcache, inteth, port, addr_type);
-  } else {
-    port = OFPP_ALL;
+  /* lookup without lock. */
+  table = __atomic_load_n(&mactable->table, __ATOMIC_ACQUIRE);
+  rv = lookup(table, key, &port, &addr_type);
+  if (rv != LAGOPUS_RESULT_OK) {
+    port = OFPP_FLOOD;
   }
 
-out:
-  if (port != OFPP_ALL &&
-      check_eth_history(local, inteth, switched) == LAGOPUS_RESULT_NOT_FOUND) {
+  if (port != OFPP_FLOOD &&
+      check_eth_history(local, key, switched) == LAGOPUS_RESULT_NOT_FOUND) {
     /* 'updater' updates the update_time in macentry. *
      * therefore, 'worker' add an entry to the bbq,   *
-     * to notify that there was reference.            */
-    rv = add_entry_bbq(local, inteth, port, addr_type);
+     * to notify that there was reference.            *
+     * port is not changed by the reference.          */
+    rv = add_entry_bbq(local, array_to_uint64(ethaddr), vid,
+                       REFRESH_PORTID, addr_type);
   }
 
   __sync_sub_and_fetch(&local->referring, 1);
@@ -468,41 +882,73 @@ out:
  * Utilizing the diffrence between the current time and update time
  * that the entry has.
  * Deletable entry(address_type is MACTABLE_SETTYPE_DYNAMIC) is registered
- * in the macentry_list.
+ * in the ageing bucket of the second it expires, and only the buckets of
+ * the seconds passed since the last call are scanned.  Entries referred
+ * again are moved to the bucket of the new expiry at that time.
  * @param[in] mactable MAC address table object.
+ * @param[in] now Current time.
  */
 static lagopus_result_t
-age_out_write_table(struct mactable *mactable, lagopus_hashmap_t *write_table) {
+age_out_entries(struct mactable *mactable, struct timespec now) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  struct macentry *entry;
-  struct timespec now = get_current_time();
+  struct macentry_list *head;
+  struct macentry *entry, *next;
+  uint64_t key;
+  uint16_t idx;
+  time_t sec;
+  int n;
 
-  /* check the update_time from the top of the macentry_list */
-  while ((entry = TAILQ_FIRST(&mactable->macentry_list)) != NULL) {
+  if (mactable == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  if (mactable->age_time != mactable->ageing_time) {
+    age_bucket_rebuild(mactable);
+  }
 
-    if (now.tv_sec - entry->update_time.tv_sec >= mactable->ageing_time) {
+  for (sec = mactable->age_scanned + 1, n = 0;
+       sec <= now.tv_sec && n < MACTABLE_AGE_BUCKETS;
+       sec++, n++) {
+    head = &mactable->age_bucket[sec % MACTABLE_AGE_BUCKETS];
+    for (entry = TAILQ_FIRST(head); entry != NULL; entry = next) {
+      next = TAILQ_NEXT(entry, next);
+
+      if (now.tv_sec - entry->update_time.tv_sec < mactable->age_time) {
+        /* referred again, move to the bucket of new expiry. */
+        idx = age_bucket_index(mactable, entry);
+        if (idx != entry->age_bucket) {
+          TAILQ_REMOVE(head, entry, next);
+          age_bucket_insert(mactable, entry);
+        }
+        continue;
+      }
       lagopus_msg_info("mactable_age_out: expired mac entry.\n");
 
       /* this entry is expired. */
-      /* remove mac entry from macentry_list. */
-      TAILQ_REMOVE(&mactable->macentry_list, entry, next);
+      /* remove mac entry from ageing bucket. */
+      TAILQ_REMOVE(head, entry, next);
+
+      /* remove mac entry from lookup table. */
+      key = MACTABLE_KEY(entry->vid, entry->inteth);
+      cuckoo_delete(mactable->table, key);
+      mactable->nentries--;
+      mactable->vlan_nentries[entry->vid]--;
+      changed_record(mactable, entry->inteth, entry->vid);
 
       /* remove mac entry from hashmap. */
-      rv = lagopus_hashmap_delete_no_lock(write_table,
-                                          (void *)entry->inteth,
+      rv = lagopus_hashmap_delete_no_lock(&mactable->entries,
+                                          (void *)key,
                                           (void **)&entry,
                                           true);
-      mactable->nentries--;
-
       if (rv != LAGOPUS_RESULT_OK) {
-        /* remove fialure from hashmap. */
-        break;
+        /* remove fialure from hashmap, retry at next time. */
+        return rv;
       }
-    } else {
-      /* nothing to do. */
-      break;
     }
   }
+  if (now.tv_sec > mactable->age_scanned) {
+    mactable->age_scanned = now.tv_sec;
+  }
 
   return rv;
 }
@@ -528,14 +974,19 @@ mactable_init(struct mactable *mactable) {
   mactable->ageing_time = 300;
 
   mactable->nentries = 0;
-  TAILQ_INIT(&mactable->macentry_list);
+  for (i = 0; i < MACTABLE_AGE_BUCKETS; i++) {
+    TAILQ_INIT(&mactable->age_bucket[i]);
+  }
+  mactable->age_scanned = get_current_time().tv_sec;
+  mactable->age_time = mactable->ageing_time;
+
+  mactable->vlan_maxentries = 0;
+  memset(mactable->vlan_nentries, 0, sizeof(mactable->vlan_nentries));
+  mactable->nmoves = 0;
+  mactable->nchanged = 0;
 
   for (i = 0; i < UPDATER_LOCALDATA_MAX_NUM; i++) {
     struct local_data *local = &mactable->local[i];
-    /* initialize localcache */
-    lagopus_hashmap_create(&local->localcache,
-                           LAGOPUS_HASHMAP_TYPE_ONE_WORD,
-                           macentry_free);
 
     /* create mac entry queue */
     rv = lagopus_bbq_create(&local->bbq, struct macentry *,
@@ -549,20 +1000,24 @@ mactable_init(struct mactable *mactable) {
       local->eth_history[j] = 0;
     }
     local->history_index = 0;
+    local->referred_generation = 0;
     __sync_lock_test_and_set(&local->referring, 0);
     __sync_lock_release(&local->referring);
   }
 
-  /* init read_tbl flag */
-  __sync_lock_test_and_set(&mactable->read_table, 0);
-  __sync_lock_release(&mactable->read_table);
+  /* init generation */
+  __sync_lock_test_and_set(&mactable->generation, 0);
+  __sync_lock_release(&mactable->generation);
 
-  /* create hashmap for mactable */
-  for (i = 0; i < 2; i++) {
-    rv = lagopus_hashmap_create(&mactable->hashmap[i],
-                                LAGOPUS_HASHMAP_TYPE_ONE_WORD,
-                                macentry_free);
+  /* create lookup table and entries for 'updater'. */
+  mactable->retired = NULL;
+  mactable->table = cuckoo_alloc(mactable->maxentries);
+  if (mactable->table == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
   }
+  rv = lagopus_hashmap_create(&mactable->entries,
+                              LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                              macentry_free);
 
   return rv;
 }
@@ -575,17 +1030,19 @@ mactable_init(struct mactable *mactable) {
 lagopus_result_t
 mactable_fini(struct mactable *mactable) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
+  struct mactable_cuckoo *table;
   int i;
 
-  /* destroy hashmap for mactable. */
-  for (i = 0; i < 2; i++) {
-    lagopus_hashmap_destroy(&mactable->hashmap[i], true);
+  /* destroy entries and lookup tables. */
+  lagopus_hashmap_destroy(&mactable->entries, true);
+  free(mactable->table);
+  mactable->table = NULL;
+  while ((table = mactable->retired) != NULL) {
+    mactable->retired = table->retired;
+    free(table);
   }
 
   for (i = 0; i < UPDATER_LOCALDATA_MAX_NUM; i++) {
-    /* destroy local cache. */
-    lagopus_hashmap_destroy(&mactable->local[i].localcache, true);
-
     /* destroy bbq. */
     lagopus_bbq_shutdown(&mactable->local[i].bbq, true);
     lagopus_bbq_destroy(&mactable->local[i].bbq, true);
@@ -599,177 +1056,73 @@ mactable_fini(struct mactable *mactable) {
 
 /**
  * Update mac address table by timer('updater').
- * Entry data are written to the writing mac table by only 'updater'.
- * They are merged read mac table and bbq.
+ * Entries queued in bbq by workers are applied to the lookup table
+ * one by one, so that the cost is proportional to the number of changes,
+ * not to the size of the table.
+ * Workers always refer the same lookup table without lock.
  * @param[in] mactable MAC address table object.
  */
 lagopus_result_t
 mactable_update(struct mactable *mactable) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  lagopus_hashmap_t *rh, *wh;
-  int i, j, cnt;
-  struct macentry_args ma;
-  struct macentry **ep = NULL;
-  bool is_empty = true;
-  unsigned int bbq_size = 0;
-  uint32_t read_table;
-  size_t get_num = 0, entry_num = 0, tmp_num = 0;
-
-  /*
-   * update mactable entry from new entries
-   * in queue and read table.
-   */
-  read_table = __sync_add_and_fetch(&mactable->read_table, 0);
-
-  /* check referred */
-  for (cnt = 0; cnt < UPDATER_LOCALDATA_MAX_NUM; cnt++) {
-    /*
-     * Here, let's describe how to manage double mactables.
-     *
-     * We have 2 types of threads.
-     * - Updater:
-     * The updater is a maintainer of mactables. All mac entries should be
-     * wrriten in one of mactables by the updater.
-     * Currently the updater has 2 mactables. It looks like double buffering.
-     * One of mactable is only for reading, and the another is for writing new
-     * mac entries. At some point, the updater replaces mactable, then all
-     * readers will refer latest mactables.
-     * - Worker:
-     * The worker refers one of mactable to process packets. The worker needs
-     * to check which mactable is currently valid before processing packets.
-     *
-     * The updater has a below value to specify which mactable is valid.
-     * - read_table:
-     * The index value of mactable that stores newest mac entries. This value
-     * is managed by the updater.
-     *
-     * Also, the worker has below values.
-     * - referred
-     * The index value of mactable that the worker is curretly referring.
-     * - referring:
-     * The status value indicates whether the worker is in a critical section,
-     * or not.
-     *  0: not in critical section.
-     *  1: in critical section.
-     *
-     * The updater should know correct timing to write new macentiries,
-     * and replace mactable. To know it, check below conditions.
-     * - 'referred' and 'read_table' have different values, and the workers is
-     *   in critical section.
-     * If one of the workers is in above condition, just give up writing and
-     * replacing. The next time the updater is invoked by timer, the updater
-     * will try same things.
-     *
-     * Here is more detaled description why the updater needs to check like
-     * above. If 'referred' and 'read_table' are different, obiously it means
-     * old table is still referred by the worker. Even if values are different,
-     * if worker 'is not' in a critical section, next time the worker will go
-     * in the critical section, reffered value will be updated to latest one.
-     * So the updater can start writing.
-     *
-     * Anyway, only the case that above condition is true in all the workers,
-     * the updater cannot start writing.
-     */
-    uint32_t referred =
-      __sync_add_and_fetch(&mactable->local[cnt].referred_table, 0);
-    if (referred != read_table) {
-      uint16_t referring =
-        __sync_add_and_fetch(&mactable->local[cnt].referring, 0);
-      if (referring == 1) {
-        return LAGOPUS_RESULT_OK;
-      }
-    }
-  }
+  struct macentry *ep[NR_MAX_ENTRIES];
+  struct timespec now;
+  size_t get_num, i;
+  unsigned int dropped = 0;
+  int cnt, cstate;
 
-  /* get tables */
-  wh = &mactable->hashmap[read_table^1];
-  rh = &mactable->hashmap[read_table];
-
-  /* clear write table. */
-  lagopus_hashmap_clear(wh, true);
-  while ((mactable->macentry_list).tqh_first != NULL) {
-    TAILQ_REMOVE(&mactable->macentry_list,
-                 mactable->macentry_list.tqh_first, next);
-    mactable->nentries = 0;
-  }
-
-  /* get entries from read table. */
-  ma.num = (unsigned int)lagopus_hashmap_size(rh);
-  ma.no = 0;
-  ma.entries = malloc(sizeof(struct macentry) * ma.num);
-  rv = lagopus_hashmap_iterate(rh, copy_macentry, &ma);
-
-  /* check entry num. */
-  entry_num = ma.num;
-  if (ma.num > mactable->maxentries) {
-    entry_num = mactable->maxentries;
-    lagopus_msg_warning("mactable is full, drop read table entries(%d)\n",
-                        ma.num - mactable->maxentries);
+  if (mactable == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
   }
 
-  /* write entries to write table. */
-  for (j = 0; j < entry_num; j++) {
-    add_entry_write_table(mactable, wh,
-                          ma.entries[j].inteth,
-                          ma.entries[j].portid,
-                          ma.entries[j].address_type,
-                          ma.entries[j].update_time);
-  }
+  now = get_current_time();
+  lagopus_rwlock_writer_enter_critical(&mactable->lock, &cstate);
 
-  /* get entries from queue. */
+  /* apply entries from queue. */
   for (cnt = 0; cnt < UPDATER_LOCALDATA_MAX_NUM; cnt++) {
     get_num = 0;
-    rv = lagopus_bbq_is_empty(&mactable->local[cnt].bbq, &is_empty);
-    if (rv != LAGOPUS_RESULT_OK) {
-      lagopus_msg_error("bbq_is_empty failed[%d].\n", (int)rv);
-      if (ma.entries) {
-        free(ma.entries);
-      }
-      return rv;
-    }
-    if (!is_empty) {
-      bbq_size = lagopus_bbq_size(&mactable->local[cnt].bbq);
-      ep = malloc(sizeof(struct macentry *) * bbq_size);
-      lagopus_bbq_get_n(&mactable->local[cnt].bbq, ep, bbq_size, 0,
-                        struct macentry *, 0, &get_num);
-    }
-
-    tmp_num = mactable->maxentries - entry_num;
-    entry_num = get_num;
-    if (get_num > tmp_num) {
-      entry_num = tmp_num;
-      lagopus_msg_warning("mactable is full, drop bbq entries(%d)\n",
-                          get_num - tmp_num);
+    rv = lagopus_bbq_get_n(&mactable->local[cnt].bbq, ep, NR_MAX_ENTRIES, 0,
+                           struct macentry *, 0, &get_num);
+    if (rv < 0 && rv != LAGOPUS_RESULT_TIMEDOUT) {
+      lagopus_msg_error("bbq_get_n failed[%d].\n", (int)rv);
+      goto out;
     }
-    /* write entries to write table */
-    for (i = 0; i < entry_num; i++) {
-      struct timespec now = get_current_time();
-      add_entry_write_table(mactable, wh,
-                            ep[i]->inteth, ep[i]->portid,
-                            ep[i]->address_type, now);
+    for (i = 0; i < get_num; i++) {
+      if (update_entry(mactable, ep[i]->inteth, ep[i]->vid, ep[i]->portid,
+                       ep[i]->address_type, now) ==
+          LAGOPUS_RESULT_TOO_MANY_OBJECTS) {
+        dropped++;
+      }
       free(ep[i]);
     }
   }
+  rv = LAGOPUS_RESULT_OK;
+  if (dropped != 0) {
+    lagopus_msg_warning("mactable is full, drop bbq entries(%u)\n", dropped);
+  }
 
   /* age out */
-  age_out_write_table(mactable, wh);
+  age_out_entries(mactable, now);
 
-  /* free temporary data. */
-  if (ma.entries) {
-    free(ma.entries);
-  }
-  if (ep) {
-    free(ep);
-  }
-
-  /*
-   * switch table (write table <-> read table).
-   */
-  __sync_val_compare_and_swap(&mactable->read_table, read_table, read_table^1);
+  /* notify workers to reset history, then release old tables. */
+  __sync_add_and_fetch(&mactable->generation, 1);
+  release_retired_tables(mactable);
 
+out:
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
   return rv;
 }
 
+/**
+ * Get VLAN ID of the packet.
+ * @param[in] pkt Packet data.
+ * @retval VLAN ID(0 if the packet is untagged).
+ */
+static inline uint16_t
+packet_vid(struct lagopus_packet *pkt) {
+  return OS_NTOHS(pkt->oob_data.vlan_tci) & (MACTABLE_VLAN_MAX - 1);
+}
+
 /**
  * Learning mac address and input port number when packet handling.
  * This function is called from l3 routing function in interface.c.
@@ -779,6 +1132,7 @@ void
 mactable_port_learning(struct lagopus_packet *pkt) {
   learn_port(&pkt->in_port->bridge->mactable,
              pkt->in_port->ofp_port.port_no,
+             packet_vid(pkt),
              pkt->eth->ether_shost,
              MACTABLE_SETTYPE_DYNAMIC);
 }
@@ -792,10 +1146,69 @@ void
 mactable_port_lookup(struct lagopus_packet *pkt) {
   uint32_t port;
   port = lookup_port(&pkt->in_port->bridge->mactable,
+                     packet_vid(pkt),
                      pkt->eth->ether_dhost);
   pkt->output_port = port;
 }
 
+/**
+ * Get output port of the mac address without refreshing the entry.
+ * Called by 'updater' to resolve output ports of FIB adjacencies.
+ * @param[in] mactable MAC address table object.
+ * @param[in] vid VLAN ID.
+ * @param[in] ethaddr MAC address.
+ */
+uint32_t
+mactable_port_get(struct mactable *mactable,
+                  uint16_t vid,
+                  const uint8_t ethaddr[]) {
+  uint32_t port;
+  uint16_t addr_type;
+
+  if (mactable == NULL ||
+      lookup(mactable->table, MACTABLE_KEY(vid, array_to_uint64(ethaddr)),
+             &port, &addr_type) != LAGOPUS_RESULT_OK) {
+    return OFPP_ALL;
+  }
+
+  return port;
+}
+
+/**
+ * Call proc for untagged mac addresses whose output port was changed
+ * since the last call, and forget them('updater' only).
+ * @param[in] mactable MAC address table object.
+ * @param[in] proc Function called with the mac address.
+ * @param[in] arg Argument of proc.
+ */
+bool
+mactable_changed_iterate(struct mactable *mactable,
+                         void (*proc)(const uint8_t *ethaddr, void *arg),
+                         void *arg) {
+  uint8_t ethaddr[UPDATER_ETH_LEN];
+  uint32_t i;
+  int j, cstate;
+  bool complete;
+
+  if (mactable == NULL) {
+    return true;
+  }
+  lagopus_rwlock_writer_enter_critical(&mactable->lock, &cstate);
+  complete = (mactable->nchanged <= MACTABLE_CHANGED_MAX);
+  if (complete == true) {
+    for (i = 0; i < mactable->nchanged; i++) {
+      for (j = 0; j < UPDATER_ETH_LEN; j++) {
+        ethaddr[j] = (uint8_t)(mactable->changed[i] >> (8 * j));
+      }
+      proc(ethaddr, arg);
+    }
+  }
+  mactable->nchanged = 0;
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
+
+  return complete;
+}
+
 /**
  * Delete all mac entries from mac address table by a request from datastore.
  * @param[in] mactable MAC address table object.
@@ -827,10 +1240,53 @@ mactable_entry_update(struct mactable *mactable,
                       uint32_t portid) {
   struct local_data *local;
   local = get_local_data(mactable);
-  return add_entry_bbq(local, array_to_uint64(ethaddr),
+  return add_entry_bbq(local, array_to_uint64(ethaddr), 0,
                        portid, MACTABLE_SETTYPE_STATIC);
 }
 
+/**
+ * Get number of entries by a request from datastore.
+ * @param[in] mactable MAC address table object.
+ */
+unsigned int
+mactable_num_entries_get(struct mactable *mactable) {
+  unsigned int ret;
+  int cstate;
+
+  lagopus_rwlock_reader_enter_critical(&mactable->lock, &cstate);
+  ret = mactable->nentries;
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
+
+  return ret;
+}
+
+/**
+ * Get entries by a request from datastore.
+ * @param[in] mactable MAC address table object.
+ * @param[out] entries MAC address entries.
+ * @param[in] num Number of entries.
+ */
+lagopus_result_t
+mactable_entries_get(struct mactable *mactable,
+                     struct macentry *entries, unsigned int num) {
+  lagopus_result_t rv;
+  struct macentry_args ma;
+  int cstate;
+
+  ma.entries = entries;
+  ma.num = num;
+  ma.no = 0;
+  lagopus_rwlock_reader_enter_critical(&mactable->lock, &cstate);
+  rv = lagopus_hashmap_iterate(&mactable->entries, copy_macentry, &ma);
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
+  if (rv == LAGOPUS_RESULT_ITERATION_HALTED) {
+    /* entries is full. */
+    rv = LAGOPUS_RESULT_OK;
+  }
+
+  return rv;
+}
+
 /**
  * Get number of max entries by a request from datastore.
  * @param[in] mactable MAC address table object.
@@ -847,6 +1303,38 @@ mactable_max_entries_get(struct mactable *mactable) {
   return ret;
 }
 
+/**
+ * Get number of max entries per VLAN by a request from datastore.
+ * @param[in] mactable MAC address table object.
+ */
+uint32_t
+mactable_vlan_max_entries_get(struct mactable *mactable) {
+  uint32_t ret;
+  int cstate;
+
+  lagopus_rwlock_reader_enter_critical(&mactable->lock, &cstate);
+  ret = mactable->vlan_maxentries;
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
+
+  return ret;
+}
+
+/**
+ * Get number of detected MAC moves by a request from datastore.
+ * @param[in] mactable MAC address table object.
+ */
+uint64_t
+mactable_moves_get(struct mactable *mactable) {
+  uint64_t ret;
+  int cstate;
+
+  lagopus_rwlock_reader_enter_critical(&mactable->lock, &cstate);
+  ret = mactable->nmoves;
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
+
+  return ret;
+}
+
 /**
  * Get ageing time by a request from datastore.
  * @param[in] mactable MAC address table object.
@@ -877,6 +1365,22 @@ mactable_max_entries_set(struct mactable *mactable, uint32_t max_entries) {
   (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
 }
 
+/**
+ * Set number of max entries per VLAN by a request from datastore.
+ * Entries already learned are not removed.
+ * @param[in] mactable MAC address table object.
+ * @param[in] max_entries Number of max entries per VLAN(0 means no limit).
+ */
+void
+mactable_vlan_max_entries_set(struct mactable *mactable,
+                              uint32_t max_entries) {
+  int cstate;
+
+  lagopus_rwlock_writer_enter_critical(&mactable->lock, &cstate);
+  mactable->vlan_maxentries = max_entries;
+  (void)lagopus_rwlock_leave_critical(&mactable->lock, cstate);
+}
+
 /**
  * Set ageing time by a request from datastore.
  * @param[in] mactable MAC address table object.
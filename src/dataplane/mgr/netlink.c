@@ -46,6 +46,14 @@ const char *nlmsg_str(__u16 nlmsg_type);
 void rtattr_parse(struct rtattr **tb, int max, struct rtattr *rta, int len);
 int netlink_start(struct event_manager *em);
 
+/* Datagrams read at once, and the buffer size of each of them. */
+#ifndef NETLINK_RECV_VLEN
+#define NETLINK_RECV_VLEN 32
+#endif /* NETLINK_RECV_VLEN */
+#ifndef NETLINK_RECV_BUFSIZ
+#define NETLINK_RECV_BUFSIZ 32768
+#endif /* NETLINK_RECV_BUFSIZ */
+
 /* For missing NDA_RTA macro. */
 #ifndef NDA_RTA
 #define NDA_RTA(r)  ((struct rtattr*)(((char*)(r)) +                    \
@@ -124,149 +132,219 @@ rtattr_parse(struct rtattr **tb, int max, struct rtattr *rta, int len) {
   }
 }
 
-static int
-netlink_read(struct nlsock *nlsock,
-             int (*filter)(struct sockaddr_nl *, struct nlmsghdr *)) {
-  int rc = 0;
-  ssize_t status;
+/**
+ * Parse a datagram and call filter for each message in it.
+ * @param[in] nlsock Netlink socket the datagram is read from.
+ * @param[in] msg Received datagram.
+ * @param[in] status Length of the datagram.
+ * @param[in] filter Function called for each message.
+ * @param[in,out] rc Return value of netlink_read().
+ * @retval true Stop reading.
+ * @retval false Continue reading.
+ */
+static bool
+netlink_parse(struct nlsock *nlsock, struct msghdr *msg, ssize_t status,
+              int (*filter)(struct sockaddr_nl *, struct nlmsghdr *),
+              int *rc) {
+  struct sockaddr_nl *snl = (struct sockaddr_nl *)msg->msg_name;
+  struct nlmsghdr *h;
   int error;
 
-  while (1) {
-    char buf[8192];
-    struct iovec iov = {
-      .iov_base = buf,
-      .iov_len = sizeof buf
-    };
-    struct sockaddr_nl snl;
-    struct msghdr msg = {
-      .msg_name = (void *)&snl,
-      .msg_namelen = sizeof snl,
-      .msg_iov = &iov,
-      .msg_iovlen = 1
-    };
-    struct nlmsghdr *h;
-
-    /* Receive netlink message from kernel. */
-    status = recvmsg(nlsock->sock, &msg, 0);
+  /* End of the message. */
+  if (status == 0) {
+    lagopus_msg_error("%s EOF\n", nlsock->name);
+    *rc = -1;
+    return true;
+  }
 
-    /* In case of EINTR try again.  In case of EWOULDBLOCK or EAGAIN,
-       return to the caller and expect to be called again. */
-    if (status < 0) {
-      if (errno == EINTR) {
+  /* Name length check. */
+  if (msg->msg_namelen != sizeof *snl) {
+    lagopus_msg_error("%s sender address length error: length %d\n",
+                      nlsock->name, msg->msg_namelen);
+    *rc = -1;
+    return true;
+  }
+
+  for (h = (struct nlmsghdr *)msg->msg_iov->iov_base;
+       NLMSG_OK(h, (unsigned int)status);
+       h = NLMSG_NEXT(h, status)) {
+
+    /* Finish of reading. */
+    if (h->nlmsg_type == NLMSG_DONE) {
+      return true;
+    }
+
+    /* Error handling. */
+    if (h->nlmsg_type == NLMSG_ERROR) {
+      struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(h);
+      int errnum = err->error;
+      __u16 msg_type = err->msg.nlmsg_type;
+
+      /* If the error field is zero, then this is an ACK. */
+      if (err->error == 0) {
+        lagopus_msg_error("%s: %s ACK: %s(%u), seq=%u, pid=%u\n",
+                          __FUNCTION__, nlsock->name,
+                          nlmsg_str(err->msg.nlmsg_type),
+                          err->msg.nlmsg_type,
+                          err->msg.nlmsg_seq,
+                          err->msg.nlmsg_pid);
+
+        /* return if not a multipart message, otherwise continue */
+        if (!(h->nlmsg_flags & NLM_F_MULTI)) {
+          *rc = 0;
+          return true;
+        }
         continue;
       }
-      if (errno == EWOULDBLOCK || errno == EAGAIN) {
-        break;
+
+      if (h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+        lagopus_msg_error("%s error: message truncated\n", nlsock->name);
+        *rc = -1;
+        return true;
       }
-      lagopus_msg_error("%s recvmsg overrun: %s\n", nlsock->name,
-                        strerror(errno));
-      continue;
+
+      /* Deal with errors that occur because of races in link
+         handling. */
+      if (nlsock == &netlink_command
+          && ((msg_type == RTM_DELROUTE &&
+               (-errnum == ENODEV || -errnum == ESRCH))
+              || (msg_type == RTM_NEWROUTE && -errnum == EEXIST))) {
+        lagopus_msg_error("%s: error: %s %s(%u), seq=%u, pid=%u\n",
+                          nlsock->name, strerror(-errnum),
+                          nlmsg_str(msg_type),
+                          msg_type, err->msg.nlmsg_seq, err->msg.nlmsg_pid);
+        *rc = 0;
+        return true;
+      }
+
+      lagopus_msg_error("%s error: %s, %s(%u), seq=%u, pid=%u\n",
+                        nlsock->name, strerror(-errnum),
+                        nlmsg_str(msg_type),
+                        msg_type, err->msg.nlmsg_seq, err->msg.nlmsg_pid);
+      *rc = -1;
+      return true;
     }
 
-    /* End of the message. */
-    if (status == 0) {
-      lagopus_msg_error("%s EOF\n", nlsock->name);
-      return -1;
+    /* OK we got netlink message. */
+#ifdef NETLINK_DEBUG
+    printf("netlink_read: %s %s(%u), seq=%u, pid=%u\n",
+           nlsock->name, nlmsg_str(h->nlmsg_type), h->nlmsg_type,
+           h->nlmsg_seq, h->nlmsg_pid);
+#endif
+
+    /* Skip unsolicited messages originating from command socket
+       linux sets the originators port-id for NEWADDR or DELADDR
+       messages, so this has to be checked here. */
+    if (nlsock != &netlink_command &&
+        h->nlmsg_pid == netlink_command.snl.nl_pid &&
+        (h->nlmsg_type != RTM_NEWADDR && h->nlmsg_type != RTM_DELADDR)) {
+      lagopus_msg_error("netlink_read: %s packet comes from %s\n",
+                        netlink_command.name, nlsock->name);
+      continue;
     }
 
-    /* Name length check. */
-    if (msg.msg_namelen != sizeof snl) {
-      lagopus_msg_error("%s sender address length error: length %d\n",
-                        nlsock->name, msg.msg_namelen);
-      return -1;
+    error = (*filter)(snl, h);
+    if (error < 0) {
+      lagopus_msg_error("%s filter function error\n", nlsock->name);
+      *rc = error;
     }
+  }
 
-    for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, (unsigned int)status);
-         h = NLMSG_NEXT(h, status)) {
+  /* Message is truncated. */
+  if (msg->msg_flags & MSG_TRUNC) {
+    lagopus_msg_error("%s error: message truncated\n", nlsock->name);
+    return false;
+  }
 
-      /* Finish of reading. */
-      if (h->nlmsg_type == NLMSG_DONE) {
-        return rc;
-      }
+  /* If status is non zero, something was wrong. */
+  if (status) {
+    lagopus_msg_error("%s error: data remnant size %lu\n", nlsock->name,
+                      status);
+    *rc = -1;
+    return true;
+  }
 
-      /* Error handling. */
-      if (h->nlmsg_type == NLMSG_ERROR) {
-        struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(h);
-        int errnum = err->error;
-        __u16 msg_type = err->msg.nlmsg_type;
-
-        /* If the error field is zero, then this is an ACK. */
-        if (err->error == 0) {
-          lagopus_msg_error("%s: %s ACK: %s(%u), seq=%u, pid=%u\n",
-                            __FUNCTION__, nlsock->name,
-                            nlmsg_str(err->msg.nlmsg_type),
-                            err->msg.nlmsg_type,
-                            err->msg.nlmsg_seq,
-                            err->msg.nlmsg_pid);
-
-          /* return if not a multipart message, otherwise continue */
-          if (!(h->nlmsg_flags & NLM_F_MULTI)) {
-            return 0;
-          }
-          continue;
-        }
+  return false;
+}
 
-        if (h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
-          lagopus_msg_error("%s error: message truncated\n", nlsock->name);
-          return -1;
-        }
+/**
+ * Parse datagrams read at once.
+ * The notifications of them are applied to the rib by one update.
+ * Datagrams after the one stopping reading are parsed too, not to lose
+ * the notifications, but *rc is left as that one set.
+ * @retval true Stop reading.
+ * @retval false Continue reading.
+ */
+static bool
+netlink_read_burst(struct nlsock *nlsock, struct mmsghdr *msgs, int n,
+                   int (*filter)(struct sockaddr_nl *, struct nlmsghdr *),
+                   int *rc) {
+  bool done = false;
+  bool stop;
+  int r;
+  int i;
+
+  rib_notifier_batch_begin();
+  for (i = 0; i < n; i++) {
+    r = *rc;
+    stop = netlink_parse(nlsock, &msgs[i].msg_hdr, msgs[i].msg_len,
+                         filter, &r);
+    if (done == false) {
+      *rc = r;
+      done = stop;
+    }
+  }
+  rib_notifier_batch_end();
 
-        /* Deal with errors that occur because of races in link
-           handling. */
-        if (nlsock == &netlink_command
-            && ((msg_type == RTM_DELROUTE &&
-                 (-errnum == ENODEV || -errnum == ESRCH))
-                || (msg_type == RTM_NEWROUTE && -errnum == EEXIST))) {
-          lagopus_msg_error("%s: error: %s %s(%u), seq=%u, pid=%u\n",
-                            nlsock->name, strerror(-errnum),
-                            nlmsg_str(msg_type),
-                            msg_type, err->msg.nlmsg_seq, err->msg.nlmsg_pid);
-          return 0;
-        }
+  return done;
+}
 
-        lagopus_msg_error("%s error: %s, %s(%u), seq=%u, pid=%u\n",
-                          nlsock->name, strerror(-errnum),
-                          nlmsg_str(msg_type),
-                          msg_type, err->msg.nlmsg_seq, err->msg.nlmsg_pid);
-        return -1;
-      }
+static int
+netlink_read(struct nlsock *nlsock,
+             int (*filter)(struct sockaddr_nl *, struct nlmsghdr *)) {
+  static char bufs[NETLINK_RECV_VLEN][NETLINK_RECV_BUFSIZ];
+  static struct sockaddr_nl snls[NETLINK_RECV_VLEN];
+  static struct iovec iovs[NETLINK_RECV_VLEN];
+  static struct mmsghdr msgs[NETLINK_RECV_VLEN];
+  int rc = 0;
+  int n;
+  int i;
 
-      /* OK we got netlink message. */
-#ifdef NETLINK_DEBUG
-      printf("netlink_read: %s %s(%u), seq=%u, pid=%u\n",
-             nlsock->name, nlmsg_str(h->nlmsg_type), h->nlmsg_type,
-             h->nlmsg_seq, h->nlmsg_pid);
-#endif
+  while (1) {
+    for (i = 0; i < NETLINK_RECV_VLEN; i++) {
+      iovs[i].iov_base = bufs[i];
+      iovs[i].iov_len = sizeof bufs[i];
+      memset(&msgs[i], 0, sizeof msgs[i]);
+      msgs[i].msg_hdr.msg_name = (void *)&snls[i];
+      msgs[i].msg_hdr.msg_namelen = sizeof snls[i];
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* Receive netlink messages from kernel, as many as queued. */
+    n = recvmmsg(nlsock->sock, msgs, NETLINK_RECV_VLEN, MSG_WAITFORONE,
+                 NULL);
 
-      /* Skip unsolicited messages originating from command socket
-         linux sets the originators port-id for NEWADDR or DELADDR
-         messages, so this has to be checked here. */
-      if (nlsock != &netlink_command &&
-          h->nlmsg_pid == netlink_command.snl.nl_pid &&
-          (h->nlmsg_type != RTM_NEWADDR && h->nlmsg_type != RTM_DELADDR)) {
-        lagopus_msg_error("netlink_read: %s packet comes from %s\n",
-                          netlink_command.name, nlsock->name);
+    /* In case of EINTR try again.  In case of EWOULDBLOCK or EAGAIN,
+       return to the caller and expect to be called again. */
+    if (n < 0) {
+      if (errno == EINTR) {
         continue;
       }
-
-      error = (*filter)(&snl, h);
-      if (error < 0) {
-        lagopus_msg_error("%s filter function error\n", nlsock->name);
-        rc = error;
+      if (errno == EWOULDBLOCK || errno == EAGAIN) {
+        break;
+      }
+      lagopus_msg_error("%s recvmmsg overrun: %s\n", nlsock->name,
+                        strerror(errno));
+      if (errno == ENOBUFS) {
+        /* the kernel dropped notifications. */
+        rib_notifier_resync_request();
       }
-    }
-
-    /* Message is truncated. */
-    if (msg.msg_flags & MSG_TRUNC) {
-      lagopus_msg_error("%s error: message truncated\n", nlsock->name);
       continue;
     }
 
-    /* If status is non zero, something was wrong. */
-    if (status) {
-      lagopus_msg_error("%s error: data remnant size %lu\n", nlsock->name,
-                        status);
-      return -1;
+    if (netlink_read_burst(nlsock, msgs, n, filter, &rc) == true) {
+      break;
     }
   }
   return rc;
@@ -426,6 +504,20 @@ apply_mask_ipv4(struct in_addr *addr, int prefixlen) {
   addr->s_addr &= mask.s_addr;
 }
 
+static void
+apply_mask_ipv6(struct in6_addr *addr, int prefixlen) {
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    if (prefixlen >= 8) {
+      prefixlen -= 8;
+    } else {
+      addr->s6_addr[i] &= (uint8_t)(0xff00 >> prefixlen);
+      prefixlen = 0;
+    }
+  }
+}
+
 static int
 netlink_route(__UNUSED struct sockaddr_nl *snl, struct nlmsghdr *h) {
   long unsigned int len;
@@ -506,16 +598,18 @@ netlink_route(__UNUSED struct sockaddr_nl *snl, struct nlmsghdr *h) {
     struct in6_addr g;
 
     memcpy(&p, dest, 16);
+    apply_mask_ipv6(&p, plen);
+
     if (gate) {
       memcpy(&g, gate, 16);
+    } else {
+      memset(&g, 0, 16);
     }
 
     if (h->nlmsg_type == RTM_NEWROUTE) {
-      rib_notifier_ipv6_route_add((struct in6_addr *)dest, plen,
-                                  &g, ifindex);
+      rib_notifier_ipv6_route_add(&p, plen, &g, ifindex);
     } else {
-      rib_notifier_ipv6_route_delete((struct in6_addr *)dest, plen,
-                                  &g, ifindex);
+      rib_notifier_ipv6_route_delete(&p, plen, &g, ifindex);
     }
   }
   return 0;
@@ -694,15 +788,6 @@ netlink_fetch(struct sockaddr_nl *snl, struct nlmsghdr *h) {
   }
 }
 
-static void
-netlink_read_event(struct event *event) {
-  struct event_manager *em;
-
-  em = event_get_manager(event);
-  netlink_read(&netlink_monitor, netlink_fetch);
-  event_register_read(em, netlink_monitor.sock, netlink_read_event, NULL);
-}
-
 static int
 netlink_dump(struct nlsock *nlsock) {
   int rc = 0;
@@ -736,6 +821,20 @@ netlink_dump(struct nlsock *nlsock) {
   return rc;
 }
 
+static void
+netlink_read_event(struct event *event) {
+  struct event_manager *em;
+
+  em = event_get_manager(event);
+  netlink_read(&netlink_monitor, netlink_fetch);
+  if (rib_notifier_resync_needed() == true &&
+      netlink_command.sock >= 0) {
+    lagopus_msg_warning("netlink notifications lost, dump again\n");
+    netlink_dump(&netlink_command);
+  }
+  event_register_read(em, netlink_monitor.sock, netlink_read_event, NULL);
+}
+
 static void
 netlink_recv_bufsize_set(int sock) {
   int rc;
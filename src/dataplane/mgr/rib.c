@@ -54,61 +54,37 @@
 
 #define NR_MAX_ENTRIES 1024  /**< max number that can be registered
                                   in the bbq. */
-
-/* fib entry */
-struct fib_entry {
-  uint8_t src_mac[UPDATER_ETH_LEN];
-  uint8_t dst_mac[UPDATER_ETH_LEN];
-  uint32_t output_port;
-};
+#ifndef RIB_BATCH_PUT_TIMEOUT
+#define RIB_BATCH_PUT_TIMEOUT \
+  (2 * UPDATER_TABLE_UPDATE_TIME * 1000LL * 1000LL * 1000LL)
+                             /**< nsec to wait for the 'updater'
+                                  to drain the bbq. */
+#endif /* RIB_BATCH_PUT_TIMEOUT */
 
 /*** static functions ***/
 /**
- * Free fib entry for fib.
- * @param[in] fibentry fib entry.
+ * Free notification entry.
+ * @param[in] entry notification entry.
  */
 static void
-fib_entry_free(struct fib_entry *entry) {
+free_notification_entry(struct notification_entry *entry) {
+  if (entry->type == NOTIFICATION_TYPE_BATCH) {
+    free(entry->batch.entries);
+  }
   free(entry);
 }
 
 /**
- * Free fib entry for bbq.
- * @param[in] data fib entry.
+ * Free notification entry for bbq.
+ * @param[in] data notification entry.
  */
 static void
 free_bbq_entry(void **data) {
   if (likely(data != NULL && *data != NULL)) {
-    free(*data);
+    free_notification_entry(*data);
   }
 }
 
-/**
- * Get arp info from arp table.
- * by interface.
- */
-static lagopus_result_t
-rib_arp_get(struct rib *rib, struct in_addr *addr,
-            uint8_t *mac, int *ifindex) {
-  lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  uint32_t read_table = __sync_add_and_fetch(&rib->read_table, 0);
-  rv = arp_get(&rib->ribs[read_table].arp_table, addr, mac, ifindex);
-
-  return rv;
-}
-
-/**
- * Get nexthop info from route table.
- */
-static lagopus_result_t
-rib_route_nexthop_get(struct rib *rib, const struct in_addr *ip_dst,
-                      struct in_addr *nexthop, uint8_t *scope, uint8_t *mac) {
-  int prefixlen = 32;
-  uint32_t read_table = __sync_add_and_fetch(&rib->read_table, 0);
-  return route_entry_get(&rib->ribs[read_table].route_table,
-                         ip_dst, prefixlen, nexthop, scope, mac);
-}
-
 /* for debug */
 static const char *
 convert_action(uint8_t action) {
@@ -122,20 +98,129 @@ convert_type(uint8_t type) {
   if (type == NOTIFICATION_TYPE_IFADDR) return "IFADDR";
   else if (type == NOTIFICATION_TYPE_ARP) return "ARP";
   else if (type == NOTIFICATION_TYPE_ROUTE) return "ROUTE";
+  else if (type == NOTIFICATION_TYPE_NDP) return "NDP";
+  else if (type == NOTIFICATION_TYPE_ROUTE6) return "ROUTE6";
   else return "";
 }
 
+/**
+ * Apply a notification entry to the rib tables.
+ * The fib is updated only when fib is not NULL.
+ */
+static void
+apply_notification(struct rib_tables *tables, struct fib_table *fib,
+                   struct notification_entry *entry) {
+  uint8_t type = entry->type;
+  uint8_t action = entry->action;
+
+  if (type == NOTIFICATION_TYPE_BATCH) {
+    size_t i;
+
+    for (i = 0; i < entry->batch.num; i++) {
+      apply_notification(tables, fib, &entry->batch.entries[i]);
+    }
+  } else if (type == NOTIFICATION_TYPE_IFADDR) {
+    struct notification_ifaddr_entry *ifaddr = &(entry->ifaddr);
+    /*
+     * modified interface information,
+     * so update interface mac address in route entries.
+     */
+    if (action == NOTIFICATION_ACTION_TYPE_ADD) {
+      route_entry_modify(&tables->route_table,
+                         ifaddr->ifindex, ifaddr->mac);
+      if (fib != NULL) {
+        fib_ifaddr_update(fib, ifaddr->ifindex, ifaddr->mac);
+      }
+    }
+    /* does not do anything when the non-NOTIFICATION_ACTION_TYPE_ADD. */
+  } else if (type == NOTIFICATION_TYPE_ARP) {
+    struct notification_arp_entry *arp = &(entry->arp);
+    /* update arp information. */
+    if (action == NOTIFICATION_ACTION_TYPE_ADD) {
+      arp_entry_update(&tables->arp_table,
+                       arp->ifindex, &arp->ip, arp->mac);
+      if (fib != NULL) {
+        fib_arp_update(fib, arp->ifindex, &arp->ip, arp->mac);
+      }
+    } else if (action == NOTIFICATION_ACTION_TYPE_DEL) {
+      arp_entry_delete(&tables->arp_table,
+                       arp->ifindex, &arp->ip, arp->mac);
+      if (fib != NULL) {
+        fib_arp_delete(fib, &arp->ip);
+      }
+    }
+  } else if (type == NOTIFICATION_TYPE_ROUTE) {
+    struct notification_route_entry *route = &(entry->route);
+    /* update route information. */
+    if (action == NOTIFICATION_ACTION_TYPE_ADD) {
+      route_entry_update(&tables->route_table,
+                         &route->dest, route->prefixlen, &route->gate,
+                         route->ifindex, route->scope, route->mac);
+      if (fib != NULL) {
+        fib_route_add(fib, &route->dest, route->prefixlen,
+                      &route->gate, route->ifindex, route->scope,
+                      route->mac);
+      }
+    } else if (action == NOTIFICATION_ACTION_TYPE_DEL) {
+      route_entry_delete(&tables->route_table,
+                         &route->dest, route->prefixlen, &route->gate,
+                         route->ifindex);
+      if (fib != NULL) {
+        fib_route_delete(fib, &route->dest, route->prefixlen);
+      }
+    }
+  } else if (type == NOTIFICATION_TYPE_NDP && fib != NULL) {
+    /* ipv6 neighbors are kept in the fib only. */
+    struct notification_ndp_entry *ndp = &(entry->ndp);
+    if (action == NOTIFICATION_ACTION_TYPE_ADD) {
+      fib6_ndp_update(fib, ndp->ifindex, &ndp->ip, ndp->mac);
+    } else if (action == NOTIFICATION_ACTION_TYPE_DEL) {
+      fib6_ndp_delete(fib, ndp->ifindex, &ndp->ip);
+    }
+  } else if (type == NOTIFICATION_TYPE_ROUTE6 && fib != NULL) {
+    /* ipv6 routes are kept in the fib only. */
+    struct notification_route6_entry *route6 = &(entry->route6);
+    if (action == NOTIFICATION_ACTION_TYPE_ADD) {
+      fib6_route_add(fib, &route6->dest, route6->prefixlen,
+                     &route6->gate, route6->ifindex, route6->mac);
+    } else if (action == NOTIFICATION_ACTION_TYPE_DEL) {
+      fib6_route_delete(fib, &route6->dest, route6->prefixlen);
+    }
+  }
+}
+
+/**
+ * Free notification entries kept for replaying.
+ */
+static void
+free_replay_entries(struct rib *rib) {
+  size_t i;
+
+  for (i = 0; i < rib->replay_num; i++) {
+    free_notification_entry(rib->replay_entries[i]);
+  }
+  free(rib->replay_entries);
+  rib->replay_entries = NULL;
+  rib->replay_num = 0;
+}
+
 /**
  * Update tables, call by rib_update().
+ *
+ * The writing table lags behind the reading table by the entries
+ * applied at the last update, so replay them before applying new
+ * entries. The cost is proportional to the number of notifications,
+ * the tables are never copied.
  */
 static lagopus_result_t
 update_tables(struct rib *rib, uint32_t read_table) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
+  struct rib_tables *tables = &rib->ribs[read_table^1];
   size_t get_num;
   bool is_empty = true;
   unsigned int bbq_size = 0;
   struct notification_entry **ep = NULL;
-  int i;
+  size_t i;
 
   /* check if the queue is empty. */
   rv = lagopus_bbq_is_empty(&rib->notification_queue, &is_empty);
@@ -144,75 +229,34 @@ update_tables(struct rib *rib, uint32_t read_table) {
     return rv;
   }
 
-  /*
-   * clear writing table and
-   * copy entries from reading table to writing table.
-   */
-  /* arp table */
-  rv = arp_entries_all_copy(&rib->ribs[read_table].arp_table,
-                            &rib->ribs[read_table^1].arp_table);
-  if (rv != LAGOPUS_RESULT_OK) {
-    return rv;
-  }
-  /* route table */
-  rv = route_entries_all_copy(&rib->ribs[read_table].route_table,
-                              &rib->ribs[read_table^1].route_table);
-  if (rv != LAGOPUS_RESULT_OK) {
-    return rv;
+  /* catch up with the reading table. */
+  for (i = 0; i < rib->replay_num; i++) {
+    apply_notification(tables, NULL, rib->replay_entries[i]);
   }
+  free_replay_entries(rib);
 
   /* get entries from bbq(notification_queue). */
   get_num = 0;
   if (!is_empty) {
     bbq_size = lagopus_bbq_size(&rib->notification_queue);
     ep = calloc(1, sizeof(struct notification_entry *) * bbq_size);
+    if (ep == NULL) {
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
     lagopus_bbq_get_n(&rib->notification_queue, ep, bbq_size, 0,
                       struct notification_entry *, 0, &get_num);
   }
 
-  /* write entries to write table. */
+  /* write entries to write table and fib. */
   for (i = 0; i < get_num; i++) {
-    uint8_t type = ep[i]->type;
-    uint8_t action = ep[i]->action;
-    if (type == NOTIFICATION_TYPE_IFADDR) {
-      struct notification_ifaddr_entry *ifaddr = &(ep[i]->ifaddr);
-      /*
-       * modified interface information,
-       * so update interface mac address in route entries.
-       */
-      if (action == NOTIFICATION_ACTION_TYPE_ADD) {
-        route_entry_modify(&rib->ribs[read_table^1].route_table,
-                           ifaddr->ifindex, ifaddr->mac);
-      }
-      /* does not do anything when the non-NOTIFICATION_ACTION_TYPE_ADD. */
-    } else if (type == NOTIFICATION_TYPE_ARP) {
-      struct notification_arp_entry *arp = &(ep[i]->arp);
-      /* update arp information. */
-      if (action == NOTIFICATION_ACTION_TYPE_ADD) {
-        arp_entry_update(&rib->ribs[read_table^1].arp_table,
-                         arp->ifindex, &arp->ip, arp->mac);
-      } else if (action == NOTIFICATION_ACTION_TYPE_DEL) {
-        arp_entry_delete(&rib->ribs[read_table^1].arp_table,
-                         arp->ifindex, &arp->ip, arp->mac);
-      }
-    } else if (type == NOTIFICATION_TYPE_ROUTE) {
-      struct notification_route_entry *route = &(ep[i]->route);
-      /* update route information. */
-      if (action == NOTIFICATION_ACTION_TYPE_ADD) {
-        route_entry_update(&rib->ribs[read_table^1].route_table,
-                           &route->dest, route->prefixlen, &route->gate,
-                           route->ifindex, route->scope, route->mac);
-      } else if (action == NOTIFICATION_ACTION_TYPE_DEL) {
-        route_entry_delete(&rib->ribs[read_table^1].route_table,
-                           &route->dest, route->prefixlen, &route->gate,
-                           route->ifindex);
-      }
-    }
-    free(ep[i]);
+    apply_notification(tables, &rib->fibtable, ep[i]);
   }
 
-  /* free temporary data. */
-  if (ep) {
+  /* keep entries to replay them to the other table by next update. */
+  if (get_num > 0) {
+    rib->replay_entries = ep;
+    rib->replay_num = get_num;
+  } else {
     free(ep);
   }
 
@@ -223,7 +267,7 @@ update_tables(struct rib *rib, uint32_t read_table) {
  * Get local data.
  * @param[in] rib RIB object.
  */
-static struct local_data *
+static struct fib *
 get_fib(struct rib *rib) {
   uint32_t wid = 0;
 
@@ -258,63 +302,6 @@ check_referred(struct rib *rib, struct fib *fib) {
   }
 }
 
-/**
- * Find entry from fib.
- */
-static lagopus_result_t
-find_fib_entry(struct fib *fib, struct in_addr dst_ip,
-               struct fib_entry **entry) {
-  lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  struct fib_entry *fib_entry;
-  rv = lagopus_hashmap_find_no_lock(&fib->localcache,
-                                    (void *)(dst_ip.s_addr),
-                                    (void **)&fib_entry);
-  if (entry != NULL && rv == LAGOPUS_RESULT_OK) {
-    *entry = fib_entry;
-  }
-
-  return rv;
-}
-
-/**
- * Add entry to fib.
- */
-static lagopus_result_t
-add_fib_entry(struct fib *fib, struct in_addr dst_ip,
-              uint8_t *src_mac, uint8_t *dst_mac, uint32_t port ) {
-  lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  struct fib_entry *entry, *dentry, *find_entry;
-
-  rv = lagopus_hashmap_find_no_lock(&fib->localcache,
-                                    (void *)(dst_ip.s_addr),
-                                    (void **)&find_entry);
-  if (rv == LAGOPUS_RESULT_NOT_FOUND) {
-    /* new entry */
-    entry = calloc(1, sizeof(struct fib_entry));
-    if (entry == NULL) {
-      return LAGOPUS_RESULT_NO_MEMORY;
-    }
-
-    entry->output_port = port;
-    memcpy(entry->src_mac, src_mac, UPDATER_ETH_LEN);
-    memcpy(entry->dst_mac, dst_mac, UPDATER_ETH_LEN);
-
-    dentry = entry;
-    rv = lagopus_hashmap_add_no_lock(&fib->localcache,
-                                     (void *)dst_ip.s_addr,
-                                     (void **)&dentry, true);
-  } else if (find_entry != NULL && rv == LAGOPUS_RESULT_OK) {
-    /* update entry */
-    find_entry->output_port = port;
-    memcpy(find_entry->src_mac, src_mac, UPDATER_ETH_LEN);
-    memcpy(find_entry->dst_mac, dst_mac, UPDATER_ETH_LEN);
-  } else {
-    lagopus_msg_error("lagopus hashmap find failed\n");
-  }
-
-  return rv;
-}
-
 /**
  * Rewrite packet header.
  */
@@ -354,19 +341,21 @@ print_l3_result(const char *str, uint8_t *src, uint8_t *dst, uint32_t port) {
 lagopus_result_t
 rib_init(struct rib *rib) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  int i, j;
+  int i;
 
   /* initialize fibs */
   for (i = 0; i < UPDATER_LOCALDATA_MAX_NUM; i++) {
     struct fib *fib = &rib->fib[i];
-    /* initialize localcache */
-    lagopus_hashmap_create(&fib->localcache,
-                           LAGOPUS_HASHMAP_TYPE_ONE_WORD,
-                           fib_entry_free);
-
     __sync_lock_test_and_set(&fib->referring, 0);
     __sync_lock_release(&fib->referring);
   }
+  rv = fib_init(&rib->fibtable);
+  if (rv != LAGOPUS_RESULT_OK) {
+    lagopus_perror(rv);
+    return rv;
+  }
+  rib->replay_entries = NULL;
+  rib->replay_num = 0;
 
   /* initialize notification queue. */
   rv = lagopus_bbq_create(&rib->notification_queue,
@@ -408,11 +397,11 @@ rib_fini(struct rib *rib) {
     route_fini(&rib->ribs[i].route_table);
   }
 
-  for (i = 0; i < UPDATER_LOCALDATA_MAX_NUM; i++) {
-    struct fib *fib = &rib->fib[i];
-    /* destroy local cache. */
-    lagopus_hashmap_destroy(&fib->localcache, true);
-  }
+  /* finalize fib. */
+  fib_fini(&rib->fibtable);
+
+  /* free entries not replayed. */
+  free_replay_entries(rib);
 }
 
 /**
@@ -449,6 +438,40 @@ rib_add_notification_entry(struct rib *rib,
   return rv;
 }
 
+/**
+ * Add entries to notification queue as one entry, so that they are
+ * applied by the same update.  The entries are freed by the rib
+ * if succeeded.
+ * If the queue is full, wait up to RIB_BATCH_PUT_TIMEOUT for the
+ * 'updater' to drain it, so that the notifier is throttled rather than
+ * losing the batch.
+ */
+lagopus_result_t
+rib_add_notification_batch(struct rib *rib,
+                           struct notification_entry *entries, size_t num) {
+  struct notification_entry *entry;
+  lagopus_result_t rv;
+
+  if (rib == NULL || entries == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  entry = rib_create_notification_entry(NOTIFICATION_TYPE_BATCH,
+                                        NOTIFICATION_ACTION_TYPE_ADD);
+  if (entry == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  entry->batch.num = num;
+  entry->batch.entries = entries;
+  rv = lagopus_bbq_put(&rib->notification_queue, &entry,
+                       struct notification_entry *, RIB_BATCH_PUT_TIMEOUT);
+  if (rv != LAGOPUS_RESULT_OK) {
+    free(entry);
+  }
+
+  return rv;
+}
+
 /**
  * Update RIB by timer('updater').
  * Entry data are written to the rib(writable) by only 'updater'.
@@ -465,7 +488,43 @@ rib_update(struct rib *rib) {
 
   /*
    * check referred.
-   * see mactable_update() in mactable.c for more information.
+   *
+   * Here, let's describe how to manage double ribs.
+   *
+   * We have 2 types of threads.
+   * - Updater:
+   * The updater is a maintainer of ribs. All rib entries should be
+   * wrriten in one of ribs by the updater.
+   * Currently the updater has 2 ribs. It looks like double buffering.
+   * One of rib is only for reading, and the another is for writing new
+   * entries. At some point, the updater replaces rib, then all
+   * readers will refer latest ribs.
+   * - Worker:
+   * The worker refers one of rib to process packets. The worker needs
+   * to check which rib is currently valid before processing packets.
+   *
+   * The updater has a below value to specify which rib is valid.
+   * - read_table:
+   * The index value of rib that stores newest entries. This value
+   * is managed by the updater.
+   *
+   * Also, the worker has below values.
+   * - referred
+   * The index value of rib that the worker is curretly referring.
+   * - referring:
+   * The status value indicates whether the worker is in a critical section,
+   * or not.
+   *  0: not in critical section.
+   *  1: in critical section.
+   *
+   * If 'referred' and 'read_table' have different values, and the worker
+   * is in critical section, old table is still referred by the worker.
+   * In that case, just give up writing and replacing. The next time
+   * the updater is invoked by timer, the updater will try same things.
+   * Even if values are different, if worker 'is not' in a critical
+   * section, next time the worker will go in the critical section,
+   * reffered value will be updated to latest one. So the updater can
+   * start writing.
    */
   for (cnt = 0; cnt < UPDATER_LOCALDATA_MAX_NUM; cnt++) {
     uint32_t referred =
@@ -479,6 +538,12 @@ rib_update(struct rib *rib) {
     }
   }
 
+  /*
+   * no worker refers the fib before the last switching,
+   * so release the entries unlinked at that time.
+   */
+  fib_reclaim(&rib->fibtable);
+
   /* update route table. */
   rv = update_tables(rib, read_table);
 
@@ -488,6 +553,15 @@ rib_update(struct rib *rib) {
   return rv;
 }
 
+/**
+ * Resolve output ports of fib adjacencies by mactable.
+ * Called by 'updater' after mactable and rib were updated.
+ */
+void
+rib_adjacency_resolve(struct rib *rib, struct mactable *mactable) {
+  fib_adjacency_resolve(&rib->fibtable, mactable);
+}
+
 /**
  * for datastore api.
  */
@@ -514,8 +588,8 @@ rib_route_rule_get(const char *name,
 
 /**
  * L3 routing.
- * Check arp table / routing table , rewrite header and lookup output port.
- * For IPv4 packet only.
+ * Lookup fib, rewrite header by the adjacency and set output port.
+ * For IPv4 and IPv6 packet.
  */
 #if defined PIPELINER
 void
@@ -524,18 +598,20 @@ lagopus_result_t
 #endif
 rib_lookup(struct lagopus_packet *pkt) {
   lagopus_result_t rv = LAGOPUS_RESULT_OK;
-  int ifindex;
-  uint8_t dst_mac[UPDATER_ETH_LEN];
-  uint8_t src_mac[UPDATER_ETH_LEN];
-  uint8_t scope = 0;
-  struct in_addr nexthop, dst_addr;
+  struct in_addr dst_addr;
+  struct in6_addr dst_addr6;
   struct rib *rib = &(pkt->bridge->rib);
   struct fib *fib;
-  struct fib_entry *entry;
-  bool switched;
+  struct fib_adjacency adj;
+  uint32_t index;
+  bool ipv6 = (pkt->ether_type == ETHERTYPE_IPV6);
 
   /* get dst ip address from input packet. */
-  lagopus_get_ip(pkt, &dst_addr, AF_INET);
+  if (ipv6 == true) {
+    lagopus_get_ip(pkt, &dst_addr6, AF_INET6);
+  } else {
+    lagopus_get_ip(pkt, &dst_addr, AF_INET);
+  }
 
   /* get fib object. */
   fib = get_fib(rib);
@@ -549,63 +625,47 @@ rib_lookup(struct lagopus_packet *pkt) {
   __sync_add_and_fetch(&fib->referring, 1);
 
   /* check reference index. */
-  switched = check_referred(rib, fib);
-  if (switched) {
-    /* clear local cache. */
-    lagopus_hashmap_clear(&fib->localcache, true);
-    rv = LAGOPUS_RESULT_NOT_FOUND;
+  (void) check_referred(rib, fib);
+
+  /* get adjacency from fib. */
+  if (ipv6 == true) {
+    index = fib6_lookup(&rib->fibtable, &dst_addr6);
   } else {
-    /* check local cache. */
-    rv = find_fib_entry(fib, dst_addr, &entry);
+    index = fib_lookup(&rib->fibtable, ntohl(dst_addr.s_addr));
   }
-
-  if (rv == LAGOPUS_RESULT_OK) {
-    /*
-     * using the fib information,
-     * rewrite the pakcet header and set output port.
-     */
-    rewrite_pkt_header(pkt, entry->src_mac, entry->dst_mac);
-    pkt->output_port = entry->output_port;
-  } else if (rv == LAGOPUS_RESULT_NOT_FOUND) {
-    /* get nexthop info from routing table(lpm). */
-    rv = rib_route_nexthop_get(rib, &dst_addr, &nexthop, &scope, src_mac);
-    if (rv != LAGOPUS_RESULT_OK) {
-      lagopus_msg_info("routing entry is not found.\n");
+  if (index == FIB_LOOKUP_MISS) {
+    lagopus_msg_info("routing entry is not found.\n");
 #ifdef PIPELINER
-      pkt->pipeline_context.error = true;
+    pkt->pipeline_context.error = true;
 #else
-      lagopus_packet_free(pkt);
+    lagopus_packet_free(pkt);
 #endif
-      goto out;
-    }
-
-    /*
-     * if scope is the path of the link,
-     * to use the dst_addr as nexthop address.
-     */
-    nexthop = (scope == RT_SCOPE_LINK) ? dst_addr : nexthop;
-
-    /* get dst mac address and output port from arp table(hash table). */
-    rib_arp_get(rib, &nexthop, dst_mac, &ifindex);
-    if (ifindex == -1) {
-      /* it is no entry on the arp table, send packet to tap(kernel). */
-      lagopus_msg_info("no entry in arp table. sent to kernel.\n");
-      pkt->send_kernel = true;
-      rv = LAGOPUS_RESULT_OK;
-      goto out;
-    }
-
-    /* rewrite packet header. */
-    rv = rewrite_pkt_header(pkt, src_mac, dst_mac);
+    rv = LAGOPUS_RESULT_NOT_FOUND;
+    goto out;
+  }
+  fib_adjacency_get(&rib->fibtable, index, &adj);
+  if (adj.resolved == false) {
+    /* it is no entry on the arp/ndp table, send packet to tap(kernel). */
+    lagopus_msg_info("no entry in arp/ndp table. sent to kernel.\n");
+    pkt->send_kernel = true;
+    rv = LAGOPUS_RESULT_OK;
+    goto out;
+  }
 
-    /* lookup output port. */
-    mactable_port_lookup(pkt);
+  /* rewrite packet header. */
+  rv = rewrite_pkt_header(pkt, adj.src_mac, adj.dst_mac);
+  if (rv != LAGOPUS_RESULT_OK) {
+    goto out;
+  }
 
-    /* learning fib. */
-    add_fib_entry(fib, dst_addr,
-                  src_mac, dst_mac, pkt->output_port);
+  /*
+   * output port was resolved by 'updater' for untagged packets,
+   * otherwise lookup mactable.
+   */
+  if (adj.output_port != OFPP_ALL && pkt->oob_data.vlan_tci == 0) {
+    pkt->output_port = adj.output_port;
   } else {
-    lagopus_msg_warning("hashmap error.\n");
+    mactable_port_lookup(pkt);
   }
 
 out:
@@ -615,5 +675,3 @@ out:
   return rv;
 #endif
 }
-
-
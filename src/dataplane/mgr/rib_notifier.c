@@ -53,6 +53,29 @@ struct ifinfo_entry {
   struct rib *rib;              /* pointer to rib object in the bridge. */
 };
 
+#ifndef NOTIFIER_BATCH_MAX_RIBS
+#define NOTIFIER_BATCH_MAX_RIBS 16 /* ribs batched at once. */
+#endif /* NOTIFIER_BATCH_MAX_RIBS */
+#define NOTIFIER_BATCH_INIT_SIZE 64
+
+/**
+ * Entries notified to a rib between rib_notifier_batch_begin() and
+ * rib_notifier_batch_end(), they are added to the rib at once.
+ */
+struct notifier_batch {
+  struct rib *rib;
+  struct notification_entry *entries;
+  size_t num;
+  size_t size;
+};
+
+/* used by the netlink thread only. */
+static struct notifier_batch batches[NOTIFIER_BATCH_MAX_RIBS];
+static size_t nbatches = 0;
+static bool batching = false;
+/* notifications were lost, the kernel tables should be dumped again. */
+static bool resync = false;
+
 /*** static apis ***/
 /**
  * Free entry of hashmap.
@@ -77,7 +100,8 @@ ifinfo_rib_get(int ifindex, struct rib **rib) {
   struct ifinfo_entry *entry;
   lagopus_result_t rv;
 
-  rv = lagopus_hashmap_find(&ifinfo_hashmap, (void *)ifindex, (void **)&entry);
+  rv = lagopus_hashmap_find(&ifinfo_hashmap, (void *)(intptr_t)ifindex,
+                            (void **)&entry);
   if (rv == LAGOPUS_RESULT_OK) {
     *rib = entry->rib;
   }
@@ -85,6 +109,81 @@ ifinfo_rib_get(int ifindex, struct rib **rib) {
   return rv;
 }
 
+/**
+ * Create notification entry for the rib.
+ * In a batch, the entry is a slot of the batch of the rib.
+ * @param[in] rib RIB the entry is added to.
+ * @param[in] type Notification type.
+ * @param[in] action Notification action.
+ */
+static struct notification_entry *
+notification_entry_create(struct rib *rib, uint8_t type, uint8_t action) {
+  struct notifier_batch *batch;
+  struct notification_entry *entries, *entry;
+  size_t i, size;
+
+  if (batching == false) {
+    return rib_create_notification_entry(type, action);
+  }
+  for (i = 0; i < nbatches; i++) {
+    if (batches[i].rib == rib) {
+      break;
+    }
+  }
+  if (i == nbatches) {
+    if (nbatches == NOTIFIER_BATCH_MAX_RIBS) {
+      return rib_create_notification_entry(type, action);
+    }
+    batches[nbatches++].rib = rib;
+  }
+  batch = &batches[i];
+  if (batch->num == batch->size) {
+    size = (batch->size == 0) ? NOTIFIER_BATCH_INIT_SIZE : batch->size * 2;
+    entries = realloc(batch->entries, sizeof(*entries) * size);
+    if (entries == NULL) {
+      return NULL;
+    }
+    batch->entries = entries;
+    batch->size = size;
+  }
+  entry = &batch->entries[batch->num++];
+  memset(entry, 0, sizeof(*entry));
+  entry->type = type;
+  entry->action = action;
+
+  return entry;
+}
+
+/**
+ * Add notification entry created by notification_entry_create()
+ * to the rib.
+ * @param[in] rib RIB.
+ * @param[in] entry Notification entry.
+ */
+static lagopus_result_t
+notification_entry_add(struct rib *rib, struct notification_entry *entry) {
+  lagopus_result_t rv;
+  size_t i;
+
+  for (i = 0; i < nbatches; i++) {
+    if (entry >= batches[i].entries &&
+        entry < batches[i].entries + batches[i].num) {
+      /* added by rib_notifier_batch_end(). */
+      return LAGOPUS_RESULT_OK;
+    }
+  }
+
+  rv = rib_add_notification_entry(rib, entry);
+  if (rv != LAGOPUS_RESULT_OK) {
+    lagopus_msg_warning("add notification entry failed: %s\n",
+                        lagopus_error_get_string(rv));
+    free(entry);
+    resync = true;
+  }
+
+  return rv;
+}
+
 /**
  * Output log for ipv4 addr information that notified from netlink.
  * @param[in] type_str String of the message type.
@@ -176,25 +275,94 @@ rib_notifier_fini() {
 }
 
 /**
- * Add ipv4 addr information notified from netlink.
+ * Begin a batch of notifications.
+ * Notifications until rib_notifier_batch_end() are added to each rib
+ * as one entry, which is applied to the tables at once.
  */
 void
-rib_notifier_ipv4_addr_add(int ifindex, struct in_addr *addr, int prefixlen,
-                           struct in_addr *broad, char *label) {
+rib_notifier_batch_begin(void) {
+  batching = true;
+}
+
+/**
+ * End a batch of notifications, add the batched entries to the ribs.
+ */
+void
+rib_notifier_batch_end(void) {
+  struct notifier_batch *batch;
+  struct notification_entry *entries;
   lagopus_result_t rv;
+  size_t i;
+
+  for (i = 0; i < nbatches; i++) {
+    batch = &batches[i];
+    if (batch->num == 0) {
+      free(batch->entries);
+    } else {
+      /* shrink to fit, the entries are kept until the rib is updated. */
+      entries = realloc(batch->entries, sizeof(*entries) * batch->num);
+      if (entries != NULL) {
+        batch->entries = entries;
+      }
+      rv = rib_add_notification_batch(batch->rib,
+                                      batch->entries, batch->num);
+      if (rv != LAGOPUS_RESULT_OK) {
+        lagopus_msg_warning("add notification batch failed: %s, "
+                            "resync scheduled\n",
+                            lagopus_error_get_string(rv));
+        free(batch->entries);
+        resync = true;
+      }
+    }
+    batch->rib = NULL;
+    batch->entries = NULL;
+    batch->num = 0;
+    batch->size = 0;
+  }
+  nbatches = 0;
+  batching = false;
+}
+
+/**
+ * Request to dump the kernel tables again, since notifications were
+ * lost before reaching the ribs.
+ */
+void
+rib_notifier_resync_request(void) {
+  resync = true;
+}
+
+/**
+ * Check and clear the resync request.
+ * @retval true The kernel tables should be dumped again.
+ */
+bool
+rib_notifier_resync_needed(void) {
+  bool needed = resync;
+
+  resync = false;
+  return needed;
+}
+
+/**
+ * Register interface information, and notify its mac address.
+ * @param[in] ifindex Interface index.
+ * @param[in] label Interface name.
+ * @param[out] rib RIB of the bridge which the interface belongs to.
+ */
+static lagopus_result_t
+ifinfo_register(int ifindex, char *label, struct rib **rib) {
   struct ifinfo_entry *entry;
   struct ifinfo_entry *dentry;
   uint8_t hwaddr[UPDATER_ETH_LEN];
   struct bridge *bridge;
   struct notification_entry *nentry = NULL;
 
-  addr_ipv4_log("add", ifindex, addr, prefixlen, broad, label);
-
   /* new ifinfo entry to registered to ifinfo_hashmap. */
   entry = calloc(1, sizeof(struct ifinfo_entry));
   if (entry == NULL) {
     lagopus_msg_warning("no memory.\n");
-    return;
+    return LAGOPUS_RESULT_NO_MEMORY;
   }
   memset(entry, 0, sizeof(struct ifinfo_entry));
   memcpy(entry->ifname, label, strlen(label));
@@ -203,26 +371,61 @@ rib_notifier_ipv4_addr_add(int ifindex, struct in_addr *addr, int prefixlen,
       != LAGOPUS_RESULT_OK) {
     lagopus_msg_warning("get interface info failed.\n");
     ifinfo_entry_free(entry);
-    return;
+    return LAGOPUS_RESULT_NOT_FOUND;
   }
   memcpy(entry->hwaddr, hwaddr, UPDATER_ETH_LEN);
   entry->rib = &(bridge->rib);
   dentry = entry;
-  lagopus_hashmap_add(&ifinfo_hashmap, (void *)ifindex, (void **)&dentry, true);
+  lagopus_hashmap_add(&ifinfo_hashmap, (void *)(intptr_t)ifindex,
+                      (void **)&dentry, true);
+  *rib = &(bridge->rib);
 
   /* create and set notification entry. */
-  nentry = rib_create_notification_entry(NOTIFICATION_TYPE_IFADDR,
-                                         NOTIFICATION_ACTION_TYPE_ADD);
-  if (nentry) {
-    /* add notification entry to queue. */
-    nentry->ifaddr.ifindex = ifindex;
-    rv = rib_add_notification_entry(&bridge->rib, nentry);
-  } else {
+  nentry = notification_entry_create(&bridge->rib, NOTIFICATION_TYPE_IFADDR,
+                                     NOTIFICATION_ACTION_TYPE_ADD);
+  if (nentry == NULL) {
     lagopus_msg_warning("create notification entry failed\n");
-    ifinfo_entry_free(entry);
+    return LAGOPUS_RESULT_NO_MEMORY;
   }
+  /* add notification entry to queue. */
+  nentry->ifaddr.ifindex = ifindex;
+  memcpy(nentry->ifaddr.mac, hwaddr, UPDATER_ETH_LEN);
 
-  return;
+  return notification_entry_add(&bridge->rib, nentry);
+}
+
+/**
+ * Notify host route of the ipv6 address of the interface,
+ * packets to the address are sent to kernel.
+ */
+static void
+ipv6_self_route_notify(struct rib *rib, uint8_t action, int ifindex,
+                       struct in6_addr *addr) {
+  struct notification_entry *nentry;
+
+  nentry = notification_entry_create(rib, NOTIFICATION_TYPE_ROUTE6, action);
+  if (nentry == NULL) {
+    lagopus_msg_warning("create notification entry failed\n");
+    return;
+  }
+  nentry->route6.ifindex = ifindex;
+  nentry->route6.dest = *addr;
+  nentry->route6.gate = in6addr_any;
+  nentry->route6.prefixlen = 128;
+  (void) notification_entry_add(rib, nentry);
+}
+
+/**
+ * Add ipv4 addr information notified from netlink.
+ */
+void
+rib_notifier_ipv4_addr_add(int ifindex, struct in_addr *addr, int prefixlen,
+                           struct in_addr *broad, char *label) {
+  struct rib *rib;
+
+  addr_ipv4_log("add", ifindex, addr, prefixlen, broad, label);
+
+  (void) ifinfo_register(ifindex, label, &rib);
 }
 
 /**
@@ -238,10 +441,10 @@ rib_notifier_ipv4_addr_delete(int ifindex, struct in_addr *addr, int prefixlen,
 
   lagopus_rwlock_reader_enter_critical(&ifinfo_lock, &cstate);
   rv = lagopus_hashmap_find_no_lock(&ifinfo_hashmap,
-                            (void *)ifindex, (void **)&entry);
+                            (void *)(intptr_t)ifindex, (void **)&entry);
   if (entry != NULL || rv == LAGOPUS_RESULT_OK) {
     lagopus_hashmap_delete_no_lock(&ifinfo_hashmap,
-                           (void *)ifindex, (void **)&entry, true);
+                           (void *)(intptr_t)ifindex, (void **)&entry, true);
   }
   (void)lagopus_rwlock_leave_critical(&ifinfo_lock, cstate);
 }
@@ -256,7 +459,7 @@ rib_notifier_ipv4_addr_get(int ifindex, uint8_t *hwaddr) {
   lagopus_result_t rv;
   lagopus_rwlock_reader_enter_critical(&ifinfo_lock, &cstate);
   rv = lagopus_hashmap_find_no_lock(&ifinfo_hashmap,
-                                    (void *)ifindex, (void **)&entry);
+                                    (void *)(intptr_t)ifindex, (void **)&entry);
   if (entry != NULL || rv == LAGOPUS_RESULT_OK) {
     memcpy(hwaddr, entry->hwaddr, UPDATER_ETH_LEN);
   }
@@ -266,23 +469,35 @@ rib_notifier_ipv4_addr_get(int ifindex, uint8_t *hwaddr) {
 }
 
 /**
- * Add ipv6 addr info (not supported).
+ * Add ipv6 addr information notified from netlink.
  */
 void
 rib_notifier_ipv6_addr_add(int ifindex, struct in6_addr *addr, int prefixlen,
                            struct in6_addr *broad, char *label) {
+  struct rib *rib;
+
   addr_ipv6_log("add", ifindex, addr, prefixlen, broad, label);
+
+  if (ifinfo_register(ifindex, label, &rib) == LAGOPUS_RESULT_OK) {
+    ipv6_self_route_notify(rib, NOTIFICATION_ACTION_TYPE_ADD, ifindex, addr);
+  }
 }
 
 /**
- * Delete ipv6 addr info (not supported).
+ * Delete ipv6 addr information notified from netlink.
+ * Interface information is kept for ipv4.
  */
 void
 rib_notifier_ipv6_addr_delete(int ifindex, struct in6_addr *addr, int prefixlen,
                               struct in6_addr *broad, char *label) {
+  struct rib *rib;
+
   addr_ipv6_log("del", ifindex, addr, prefixlen, broad, label);
-}
 
+  if (ifinfo_rib_get(ifindex, &rib) == LAGOPUS_RESULT_OK && rib != NULL) {
+    ipv6_self_route_notify(rib, NOTIFICATION_ACTION_TYPE_DEL, ifindex, addr);
+  }
+}
 
 /**
  * Add arp information notified from netlink.
@@ -296,14 +511,14 @@ rib_notifier_arp_add(int ifindex, struct in_addr *dst_addr, char *ll_addr) {
   rv = ifinfo_rib_get(ifindex, &rib);
   if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
     /* create and set notification entry. */
-    entry = rib_create_notification_entry(NOTIFICATION_TYPE_ARP,
-                                          NOTIFICATION_ACTION_TYPE_ADD);
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_ARP,
+                                       NOTIFICATION_ACTION_TYPE_ADD);
     if (entry) {
       /* add notification entry to queue. */
       entry->arp.ifindex = ifindex;
       entry->arp.ip = *dst_addr;
       memcpy(entry->arp.mac, ll_addr, UPDATER_ETH_LEN);
-      rv = rib_add_notification_entry(rib, entry);
+      rv = notification_entry_add(rib, entry);
     } else {
       lagopus_msg_warning("create notification entry failed\n");
     }
@@ -323,14 +538,14 @@ rib_notifier_arp_delete(int ifindex, struct in_addr *dst_addr, char *ll_addr) {
 
   rv = ifinfo_rib_get(ifindex, &rib);
   if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
-    entry = rib_create_notification_entry(NOTIFICATION_TYPE_ARP,
-                                          NOTIFICATION_ACTION_TYPE_DEL);
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_ARP,
+                                       NOTIFICATION_ACTION_TYPE_DEL);
     if (entry) {
       /* add notification entry to queue. */
       entry->arp.ifindex = ifindex;
       entry->arp.ip = *dst_addr;
       memcpy(entry->arp.mac, ll_addr, UPDATER_ETH_LEN);
-      rv = rib_add_notification_entry(rib, entry);
+      rv = notification_entry_add(rib, entry);
     } else {
       lagopus_msg_warning("create notification entry failed\n");
     }
@@ -350,18 +565,14 @@ rib_notifier_ipv4_route_add(struct in_addr *dest, int prefixlen,
   struct notification_entry *entry = NULL;
   struct ifinfo_entry *ientry = NULL;
 
-  rv = ifinfo_rib_get(ifindex, &rib);
-  if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
-    entry = rib_create_notification_entry(NOTIFICATION_TYPE_ROUTE,
-                                          NOTIFICATION_ACTION_TYPE_ADD);
+  /* get rib and mac address of the interface. */
+  rv = lagopus_hashmap_find(&ifinfo_hashmap,
+                            (void *)(intptr_t)ifindex, (void **)&ientry);
+  if (rv == LAGOPUS_RESULT_OK && ientry != NULL && ientry->rib != NULL) {
+    rib = ientry->rib;
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_ROUTE,
+                                       NOTIFICATION_ACTION_TYPE_ADD);
     if (entry) {
-      /* get mac address of the interface. */
-      rv = lagopus_hashmap_find(&ifinfo_hashmap,
-                                (void *)ifindex, (void **)&ientry);
-      if (ientry == NULL || rv != LAGOPUS_RESULT_OK) {
-        lagopus_msg_warning("get interface info failed.\n");
-        return;
-      }
       /* set data to notification entry object. */
       entry->route.ifindex = ifindex;
       entry->route.dest = *dest;
@@ -370,7 +581,7 @@ rib_notifier_ipv4_route_add(struct in_addr *dest, int prefixlen,
       entry->route.prefixlen = prefixlen;
       memcpy(entry->route.mac, ientry->hwaddr, UPDATER_ETH_LEN);
       /* add notification entry to queue. */
-      rv = rib_add_notification_entry(rib, entry);
+      rv = notification_entry_add(rib, entry);
     } else {
       lagopus_msg_warning("create notification entry failed\n");
     }
@@ -391,8 +602,8 @@ rib_notifier_ipv4_route_delete(struct in_addr *dest, int prefixlen,
 
   rv = ifinfo_rib_get(ifindex, &rib);
   if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
-    entry = rib_create_notification_entry(NOTIFICATION_TYPE_ROUTE,
-                                          NOTIFICATION_ACTION_TYPE_DEL);
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_ROUTE,
+                                       NOTIFICATION_ACTION_TYPE_DEL);
     if (entry) {
       /* add notification entry to queue. */
       entry->route.ifindex = ifindex;
@@ -400,7 +611,7 @@ rib_notifier_ipv4_route_delete(struct in_addr *dest, int prefixlen,
       entry->route.gate = *gate;
       entry->route.scope = 0;
       entry->route.prefixlen = prefixlen;
-      rv = rib_add_notification_entry(rib, entry);
+      rv = notification_entry_add(rib, entry);
     } else {
       lagopus_msg_warning("create notification entry failed\n");
     }
@@ -415,7 +626,39 @@ rib_notifier_ipv4_route_delete(struct in_addr *dest, int prefixlen,
 void
 rib_notifier_ipv6_route_add(struct in6_addr *dest, int prefixlen,
                             struct in6_addr *gate, int ifindex) {
+  struct rib *rib;
+  lagopus_result_t rv;
+  struct notification_entry *entry = NULL;
+  struct ifinfo_entry *ientry = NULL;
+
   route_ipv6_add(dest, prefixlen, gate, ifindex);
+
+  rv = ifinfo_rib_get(ifindex, &rib);
+  if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
+    /* get mac address of the interface. */
+    rv = lagopus_hashmap_find(&ifinfo_hashmap,
+                              (void *)(intptr_t)ifindex, (void **)&ientry);
+    if (ientry == NULL || rv != LAGOPUS_RESULT_OK) {
+      lagopus_msg_warning("get interface info failed.\n");
+      return;
+    }
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_ROUTE6,
+                                       NOTIFICATION_ACTION_TYPE_ADD);
+    if (entry) {
+      /* set data to notification entry object. */
+      entry->route6.ifindex = ifindex;
+      entry->route6.dest = *dest;
+      entry->route6.gate = *gate;
+      entry->route6.prefixlen = prefixlen;
+      memcpy(entry->route6.mac, ientry->hwaddr, UPDATER_ETH_LEN);
+      /* add notification entry to queue. */
+      rv = notification_entry_add(rib, entry);
+    } else {
+      lagopus_msg_warning("create notification entry failed\n");
+    }
+  }
+
+  return;
 }
 
 /**
@@ -424,7 +667,29 @@ rib_notifier_ipv6_route_add(struct in6_addr *dest, int prefixlen,
 void
 rib_notifier_ipv6_route_delete(struct in6_addr *dest, int prefixlen,
                                struct in6_addr *gate, int ifindex) {
+  struct rib *rib;
+  lagopus_result_t rv;
+  struct notification_entry *entry = NULL;
+
   route_ipv6_delete(dest, prefixlen, gate, ifindex);
+
+  rv = ifinfo_rib_get(ifindex, &rib);
+  if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_ROUTE6,
+                                       NOTIFICATION_ACTION_TYPE_DEL);
+    if (entry) {
+      /* add notification entry to queue. */
+      entry->route6.ifindex = ifindex;
+      entry->route6.dest = *dest;
+      entry->route6.gate = *gate;
+      entry->route6.prefixlen = prefixlen;
+      rv = notification_entry_add(rib, entry);
+    } else {
+      lagopus_msg_warning("create notification entry failed\n");
+    }
+  }
+
+  return;
 }
 
 /** interface apis(not supported) **/
@@ -438,7 +703,7 @@ rib_notifier_interface_delete(int ifindex) {
   PRINTF("Interface del: ifindex %u\n", ifindex);
 }
 
-/** ndp apis(not supported) **/
+/** ndp apis **/
 static void
 rib_notifier_ndp_log(const char *type_str, int ifindex,
                      struct in6_addr *dst_addr, char *ll_addr) {
@@ -458,13 +723,46 @@ rib_notifier_ndp_log(const char *type_str, int ifindex,
   }
 }
 
+static void
+rib_notifier_ndp_notify(uint8_t action, int ifindex,
+                        struct in6_addr *dst_addr, char *ll_addr) {
+  struct rib *rib;
+  lagopus_result_t rv;
+  struct notification_entry *entry = NULL;
+
+  rv = ifinfo_rib_get(ifindex, &rib);
+  if (rv == LAGOPUS_RESULT_OK && rib != NULL) {
+    entry = notification_entry_create(rib, NOTIFICATION_TYPE_NDP, action);
+    if (entry) {
+      /* add notification entry to queue. */
+      entry->ndp.ifindex = ifindex;
+      entry->ndp.ip = *dst_addr;
+      if (ll_addr != NULL) {
+        memcpy(entry->ndp.mac, ll_addr, UPDATER_ETH_LEN);
+      }
+      rv = notification_entry_add(rib, entry);
+    } else {
+      lagopus_msg_warning("create notification entry failed\n");
+    }
+  }
+}
+
+/**
+ * Add ndp information notified from netlink.
+ */
 void
 rib_notifier_ndp_add(int ifindex, struct in6_addr *dst_addr, char *ll_addr) {
   rib_notifier_ndp_log("add", ifindex, dst_addr, ll_addr);
+  rib_notifier_ndp_notify(NOTIFICATION_ACTION_TYPE_ADD,
+                          ifindex, dst_addr, ll_addr);
 }
 
+/**
+ * Delete ndp information notified from netlink.
+ */
 void
 rib_notifier_ndp_delete(int ifindex, struct in6_addr *dst_addr, char *ll_addr) {
   rib_notifier_ndp_log("del", ifindex, dst_addr, ll_addr);
+  rib_notifier_ndp_notify(NOTIFICATION_ACTION_TYPE_DEL,
+                          ifindex, dst_addr, ll_addr);
 }
-
@@ -46,6 +46,16 @@ rib_notifier_init(void);
 void
 rib_notifier_fini(void);
 
+/* batch */
+void
+rib_notifier_batch_begin(void);
+void
+rib_notifier_batch_end(void);
+void
+rib_notifier_resync_request(void);
+bool
+rib_notifier_resync_needed(void);
+
 /* route */
 void
 rib_notifier_ipv4_route_add(struct in_addr *dest, int prefixlen,
@@ -52,6 +52,7 @@
 #include "csum.h"
 #include "thread.h"
 #include "lock.h"
+#include "bonding.h"
 #include "sock_io.h"
 
 #ifdef HAVE_DPDK
@@ -663,6 +664,20 @@ found:
   return LAGOPUS_RESULT_OK;
 }
 
+lagopus_result_t
+rawsock_get_link_status(struct interface *ifp, bool *link_up) {
+  struct ifreq ifreq;
+
+  snprintf(ifreq.ifr_name, sizeof(ifreq.ifr_name),
+           "%s", ifp->info.eth_rawsock.device);
+  if (ioctl(ifp->fd, SIOCGIFFLAGS, &ifreq) != 0) {
+    lagopus_msg_warning("%s\n", strerror(errno));
+    return LAGOPUS_RESULT_ANY_FAILURES;
+  }
+  *link_up = (ifreq.ifr_flags & (IFF_UP|IFF_RUNNING)) == (IFF_UP|IFF_RUNNING);
+  return LAGOPUS_RESULT_OK;
+}
+
 lagopus_result_t
 rawsock_clear_stats(struct interface *ifp) {
   (void) ifp;
@@ -736,6 +751,7 @@ dp_rawsock_thread_loop(__UNUSED const lagopus_thread_t *selfptr,
     if (poll(iter->pollfd, (nfds_t)iter->nfds, 100) < 0) {
       err(errno, "poll");
     }
+    dp_clock_update();
     for (i = 0; i < iter->nfds; i++) {
       struct interface *ifp;
       lagopus_result_t rv;
@@ -765,6 +781,10 @@ dp_rawsock_thread_loop(__UNUSED const lagopus_thread_t *selfptr,
         continue;
       }
       port = ifp->port;
+      if (ifp->master != NULL) {
+        /* slave receives packets as the bond port. */
+        port = ifp->master->port;
+      }
       if (port != NULL &&
 	  port->bridge != NULL &&
           (port->ofp_port.config & OFPPC_NO_RECV) == 0) {
@@ -791,6 +811,13 @@ dp_rawsock_thread_loop(__UNUSED const lagopus_thread_t *selfptr,
           }
         }
         OS_M_TRIM(PKT2MBUF(pkt), MAX_PACKET_SZ - len);
+        if (ifp->master != NULL &&
+            bonding_slave_input(ifp, OS_MTOD(PKT2MBUF(pkt), uint8_t *),
+                                (size_t)len) == true) {
+          lagopus_packet_free(pkt);
+          flowdb_rdunlock(NULL);
+          continue;
+        }
         lagopus_packet_init(pkt, PKT2MBUF(pkt), port);
         flowdb_switch_mode_get(port->bridge->flowdb, &mode);
         if (
@@ -840,6 +867,7 @@ dp_rawsock_thread_init(int argc,
 			 LAGOPUS_HASHMAP_TYPE_ONE_WORD,
 			 NULL);
   lagopus_register_action_hook = lagopus_set_action_function;
+  lagopus_register_action_list_hook = lagopus_set_action_list_function;
   lagopus_register_instruction_hook = lagopus_set_instruction_function;
   flowinfo_init();
 
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <arpa/inet.h>
+#include "unity.h"
+
+#include "lagopus_apis.h"
+#include "lagopus/flowdb.h"
+#include "lagopus/interface.h"
+#include "lagopus/dp_apis.h"
+#include "dp_timer.h"
+#include "bonding.h"
+
+#define N_SLAVES 3
+#define N_HASHES 48
+
+static struct interface *bond_ifp;
+static struct interface *slave_ifp[N_SLAVES];
+static struct bonding *bond;
+
+static void
+make_lacpdu(struct bonding_lacpdu *pdu, uint8_t system, uint16_t port,
+            uint8_t state, const struct bonding_lacp_info *partner) {
+  memset(pdu, 0, sizeof(*pdu));
+  pdu->dst[0] = 0x01;
+  pdu->dst[1] = 0x80;
+  pdu->dst[2] = 0xc2;
+  pdu->dst[5] = 0x02;
+  pdu->src[0] = 0x0a;
+  pdu->src[5] = system;
+  pdu->ether_type = htons(LACP_ETHERTYPE);
+  pdu->subtype = LACP_SUBTYPE;
+  pdu->version = LACP_VERSION;
+  pdu->actor_type = 1;
+  pdu->actor_len = 20;
+  pdu->actor.system_priority = htons(1);
+  pdu->actor.system[0] = 0x0a;
+  pdu->actor.system[5] = system;
+  pdu->actor.key = htons(10);
+  pdu->actor.port_priority = htons(1);
+  pdu->actor.port = htons(port);
+  pdu->actor.state = state;
+  pdu->partner_type = 2;
+  pdu->partner_len = 20;
+  if (partner != NULL) {
+    pdu->partner = *partner;
+  }
+  pdu->collector_type = 3;
+  pdu->collector_len = 16;
+}
+
+static void
+input_lacpdu(int i, uint8_t system, uint8_t state, bool know_us) {
+  struct bonding_lacpdu pdu;
+  bool rv;
+
+  make_lacpdu(&pdu, system, (uint16_t)(i + 1), state,
+              know_us == true ? &bond->slaves[i].actor : NULL);
+  rv = bonding_slave_input(slave_ifp[i], (uint8_t *)&pdu, sizeof(pdu));
+  TEST_ASSERT_TRUE(rv);
+}
+
+static uint32_t
+count_tx_slave(struct interface *ifp) {
+  uint32_t h, n;
+
+  n = 0;
+  for (h = 0; h < N_HASHES; h++) {
+    if (bonding_tx_slave(bond, h) == ifp) {
+      n++;
+    }
+  }
+  return n;
+}
+
+static void
+setup_bond(enum dp_bonding_mode mode) {
+  int i;
+
+  bond = bonding_alloc(bond_ifp, mode, DP_BONDING_XMIT_HASH_L34);
+  TEST_ASSERT_NOT_NULL(bond);
+  TEST_ASSERT_EQUAL_PTR(bond_ifp->bond, bond);
+  for (i = 0; i < N_SLAVES; i++) {
+    TEST_ASSERT_EQUAL(bonding_slave_add(bond, slave_ifp[i]),
+                      LAGOPUS_RESULT_OK);
+    TEST_ASSERT_EQUAL_PTR(slave_ifp[i]->master, bond_ifp);
+  }
+}
+
+void
+setUp(void) {
+  int i;
+
+  init_dp_timer();
+  bond_ifp = dp_interface_alloc();
+  TEST_ASSERT_NOT_NULL(bond_ifp);
+  for (i = 0; i < N_SLAVES; i++) {
+    slave_ifp[i] = dp_interface_alloc();
+    TEST_ASSERT_NOT_NULL(slave_ifp[i]);
+    slave_ifp[i]->hw_addr[0] = 0x02;
+    slave_ifp[i]->hw_addr[5] = (uint8_t)(i + 1);
+  }
+}
+
+void
+tearDown(void) {
+  int i;
+
+  dp_interface_free(bond_ifp);
+  for (i = 0; i < N_SLAVES; i++) {
+    TEST_ASSERT_NULL(slave_ifp[i]->master);
+    dp_interface_free(slave_ifp[i]);
+  }
+}
+
+void
+test_bonding_xor(void) {
+  uint32_t h;
+  int i;
+
+  setup_bond(DP_BONDING_MODE_BALANCE_XOR);
+  TEST_ASSERT_EQUAL_MEMORY(bond_ifp->hw_addr, slave_ifp[0]->hw_addr,
+                           ETHER_ADDR_LEN);
+  TEST_ASSERT_EQUAL(bond->tx->n, N_SLAVES);
+  for (i = 0; i < N_SLAVES; i++) {
+    TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[i]), N_HASHES / N_SLAVES);
+  }
+  for (h = 0; h < N_HASHES; h++) {
+    TEST_ASSERT_EQUAL_PTR(bonding_tx_slave(bond, h),
+                          bonding_tx_slave(bond, h + N_SLAVES));
+  }
+
+  /* failover by slave deletion. */
+  TEST_ASSERT_EQUAL(bonding_slave_delete(bond, slave_ifp[1]),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_NULL(slave_ifp[1]->master);
+  TEST_ASSERT_EQUAL(bond->tx->n, N_SLAVES - 1);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[1]), 0);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[0]), N_HASHES / 2);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[2]), N_HASHES / 2);
+  for (i = 0; i < BONDING_MAX_SLAVES; i++) {
+    TEST_ASSERT_TRUE(bond->txbuf[0].slave[i] != slave_ifp[1]);
+    TEST_ASSERT_TRUE(bond->txbuf[1].slave[i] != slave_ifp[1]);
+  }
+  TEST_ASSERT_EQUAL(bonding_slave_delete(bond, slave_ifp[1]),
+                    LAGOPUS_RESULT_NOT_FOUND);
+}
+
+void
+test_bonding_slave_add_error(void) {
+  setup_bond(DP_BONDING_MODE_BALANCE_XOR);
+  TEST_ASSERT_EQUAL(bonding_slave_add(bond, slave_ifp[0]),
+                    LAGOPUS_RESULT_BUSY);
+  TEST_ASSERT_EQUAL(bonding_slave_add(bond, bond_ifp),
+                    LAGOPUS_RESULT_BUSY);
+}
+
+void
+test_bonding_lacp(void) {
+  const uint8_t up = LACP_STATE_ACTIVITY | LACP_STATE_AGGREGATION;
+  const uint8_t dist = up | LACP_STATE_SYNC |
+                       LACP_STATE_COLLECTING | LACP_STATE_DISTRIBUTING;
+  time_t now;
+  int i;
+
+  setup_bond(DP_BONDING_MODE_8023AD);
+  TEST_ASSERT_EQUAL(bond->tx->n, 0);
+  TEST_ASSERT_NULL(bonding_tx_slave(bond, 0));
+
+  now = get_current_time().tv_sec;
+  bonding_lacp_tick(bond, now);
+  for (i = 0; i < N_SLAVES; i++) {
+    TEST_ASSERT_EQUAL(bond->slaves[i].rx_state, BONDING_RX_EXPIRED);
+  }
+
+  /* partner does not know us, attached but not distributing. */
+  input_lacpdu(0, 1, up, false);
+  TEST_ASSERT_EQUAL(bond->slaves[0].rx_state, BONDING_RX_CURRENT);
+  TEST_ASSERT_EQUAL(bond->slaves[0].mux_state, BONDING_MUX_ATTACHED);
+  TEST_ASSERT_TRUE((bond->slaves[0].actor.state & LACP_STATE_SYNC) != 0);
+  TEST_ASSERT_TRUE(bond->slaves[0].ntt);
+  TEST_ASSERT_EQUAL(bond->tx->n, 0);
+
+  /* partner is in sync, distributing. */
+  input_lacpdu(0, 1, dist, true);
+  input_lacpdu(1, 1, dist, true);
+  TEST_ASSERT_EQUAL(bond->slaves[0].mux_state,
+                    BONDING_MUX_COLLECTING_DISTRIBUTING);
+  TEST_ASSERT_TRUE((bond->slaves[0].actor.state &
+                    LACP_STATE_DISTRIBUTING) != 0);
+  TEST_ASSERT_EQUAL(bond->tx->n, 2);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[0]), N_HASHES / 2);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[1]), N_HASHES / 2);
+
+  /* another partner system is not aggregated. */
+  input_lacpdu(2, 2, dist, true);
+  TEST_ASSERT_EQUAL(bond->slaves[2].rx_state, BONDING_RX_CURRENT);
+  TEST_ASSERT_FALSE(bond->slaves[2].selected);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[2]), 0);
+
+  /* partner of slave 0 is timed out. */
+  bond->slaves[1].current_while += BONDING_LONG_TIMEOUT;
+  bond->slaves[2].current_while += BONDING_LONG_TIMEOUT;
+  now += BONDING_LONG_TIMEOUT + 1;
+  bonding_lacp_tick(bond, now);
+  TEST_ASSERT_EQUAL(bond->slaves[0].rx_state, BONDING_RX_EXPIRED);
+  TEST_ASSERT_TRUE((bond->slaves[0].actor.state & LACP_STATE_EXPIRED) != 0);
+  TEST_ASSERT_EQUAL(bond->slaves[0].mux_state, BONDING_MUX_DETACHED);
+  TEST_ASSERT_EQUAL(bond->tx->n, 1);
+  TEST_ASSERT_EQUAL(count_tx_slave(slave_ifp[1]), N_HASHES);
+
+  now += BONDING_SHORT_TIMEOUT;
+  bonding_lacp_tick(bond, now);
+  TEST_ASSERT_EQUAL(bond->slaves[0].rx_state, BONDING_RX_DEFAULTED);
+  TEST_ASSERT_TRUE((bond->slaves[0].actor.state &
+                    LACP_STATE_DEFAULTED) != 0);
+  TEST_ASSERT_EQUAL(bond->slaves[0].partner.system_priority, 0);
+
+  /* partner comes back. */
+  input_lacpdu(0, 1, dist, true);
+  TEST_ASSERT_EQUAL(bond->tx->n, 2);
+}
+
+void
+test_bonding_slave_input(void) {
+  struct bonding_lacpdu pdu;
+
+  setup_bond(DP_BONDING_MODE_8023AD);
+  make_lacpdu(&pdu, 1, 1, 0, NULL);
+
+  /* marker protocol is consumed. */
+  pdu.subtype = 2;
+  TEST_ASSERT_TRUE(bonding_slave_input(slave_ifp[0], (uint8_t *)&pdu,
+                                       sizeof(pdu)));
+  TEST_ASSERT_EQUAL(bond->slaves[0].rx_state, BONDING_RX_DISABLED);
+
+  /* not slow protocol. */
+  pdu.ether_type = htons(0x0800);
+  TEST_ASSERT_FALSE(bonding_slave_input(slave_ifp[0], (uint8_t *)&pdu,
+                                        sizeof(pdu)));
+  TEST_ASSERT_FALSE(bonding_slave_input(slave_ifp[0], (uint8_t *)&pdu, 10));
+}
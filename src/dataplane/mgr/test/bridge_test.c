@@ -50,6 +50,7 @@ setUp(void) {
 #ifdef HYBRID
   info.mactable_ageing_time = 300;
   info.mactable_max_entries = 8192;
+  info.mactable_vlan_max_entries = 16;
 #endif
   TEST_ASSERT_NULL(bridge);
   TEST_ASSERT_EQUAL(dp_api_init(), LAGOPUS_RESULT_OK);
@@ -140,6 +141,93 @@ test_dp_bridge_flow_iter(void) {
   dp_bridge_flow_iter_destroy(iter);
 }
 
+static lagopus_result_t
+count_flow(struct flow *flow, void *arg) {
+  TEST_ASSERT_NOT_NULL(flow);
+  (*(int *)arg)++;
+  return LAGOPUS_RESULT_OK;
+}
+
+static lagopus_result_t
+stop_flow(struct flow *flow, void *arg) {
+  (void) flow;
+  (void) arg;
+  return LAGOPUS_RESULT_STOP;
+}
+
+void
+test_dp_bridge_flow_iter_walk(void) {
+  dp_bridge_iter_t iter;
+  struct ofp_flow_mod flow_mod;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_error error;
+  int nflow = DP_BRIDGE_FLOW_ITER_CHUNK * 2 + 3;
+  int i, count, nwalk;
+  lagopus_result_t rv;
+
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.table_id = 0;
+  for (i = 0; i < nflow; i++) {
+    TAILQ_INIT(&match_list);
+    TAILQ_INIT(&instruction_list);
+    flow_mod.priority = (uint16_t)(i + 1);
+    TEST_ASSERT_EQUAL(flowdb_flow_add(bridge, &flow_mod, &match_list,
+                                      &instruction_list, &error),
+                      LAGOPUS_RESULT_OK);
+  }
+
+  iter = NULL;
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_create(bridge_name, 0, &iter),
+                    LAGOPUS_RESULT_OK);
+  count = 0;
+  nwalk = 0;
+  do {
+    rv = dp_bridge_flow_iter_walk(iter, count_flow, &count);
+    nwalk++;
+  } while (rv == LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_EOF);
+  TEST_ASSERT_EQUAL(count, nflow);
+  TEST_ASSERT_EQUAL(nwalk, 3);
+  dp_bridge_flow_iter_destroy(iter);
+
+  /* Flows added between the calls, each flow is passed once. */
+  iter = NULL;
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_create(bridge_name, 0, &iter),
+                    LAGOPUS_RESULT_OK);
+  count = 0;
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_walk(iter, count_flow, &count),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(count, DP_BRIDGE_FLOW_ITER_CHUNK);
+  for (i = 0; i < 2; i++) {
+    TAILQ_INIT(&match_list);
+    TAILQ_INIT(&instruction_list);
+    flow_mod.priority = (uint16_t)((i == 0) ? nflow + 1 : 0);
+    TEST_ASSERT_EQUAL(flowdb_flow_add(bridge, &flow_mod, &match_list,
+                                      &instruction_list, &error),
+                      LAGOPUS_RESULT_OK);
+  }
+  do {
+    rv = dp_bridge_flow_iter_walk(iter, count_flow, &count);
+  } while (rv == LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_EOF);
+  /* the highest priority flow is before the iterator, priority 0 after. */
+  TEST_ASSERT_EQUAL(count, nflow + 1);
+  dp_bridge_flow_iter_destroy(iter);
+
+  /* An error of the proc stops the walk. */
+  iter = NULL;
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_create(bridge_name, 0, &iter),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_walk(iter, stop_flow, NULL),
+                    LAGOPUS_RESULT_STOP);
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_walk(NULL, count_flow, &count),
+                    LAGOPUS_RESULT_INVALID_ARGS);
+  TEST_ASSERT_EQUAL(dp_bridge_flow_iter_walk(iter, NULL, NULL),
+                    LAGOPUS_RESULT_INVALID_ARGS);
+  dp_bridge_flow_iter_destroy(iter);
+}
+
 void
 test_ofp_version_bitmap(void) {
   int version;
@@ -298,3 +386,28 @@ test_dp_bridge_mactable_configs_get(void) {
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
+
+void
+test_dp_bridge_mactable_vlan_max_entries_moves_get(void) {
+#ifdef HYBRID
+  uint32_t vlan_max_entries;
+  uint64_t moves;
+  lagopus_result_t rv;
+
+  rv = dp_bridge_mactable_vlan_max_entries_get(bridge_name,
+                                               &vlan_max_entries);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(vlan_max_entries, 16);
+  rv = dp_bridge_mactable_vlan_max_entries_get("bad", &vlan_max_entries);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
+
+  rv = dp_bridge_mactable_moves_get(bridge_name, &moves);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(moves, 0);
+  rv = dp_bridge_mactable_moves_get("bad", &moves);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
+#else /* HYBRID */
+  tearDown();
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
@@ -0,0 +1,616 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+
+#ifdef HYBRID
+#include "fib.c"
+#endif /* HYBRID */
+
+#define ETH_LEN  6
+
+#ifdef HYBRID
+static struct fib_table fib;
+
+static uint32_t
+lookup_str(const char *addr) {
+  return fib_lookup(&fib, ntohl(inet_addr(addr)));
+}
+
+static uint32_t
+route_add_str(const char *dest, int prefixlen, const char *gate) {
+  struct in_addr d, g;
+  uint8_t mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+  d.s_addr = inet_addr(dest);
+  g.s_addr = inet_addr(gate);
+  TEST_ASSERT_EQUAL(fib_route_add(&fib, &d, prefixlen, &g, 1,
+                                  RT_SCOPE_UNIVERSE, mac),
+                    LAGOPUS_RESULT_OK);
+
+  return adjacency_find(&fib, &g);
+}
+
+static void
+route_delete_str(const char *dest, int prefixlen) {
+  struct in_addr d;
+
+  d.s_addr = inet_addr(dest);
+  TEST_ASSERT_EQUAL(fib_route_delete(&fib, &d, prefixlen),
+                    LAGOPUS_RESULT_OK);
+}
+
+static uint32_t
+lookup6_str(const char *addr) {
+  struct in6_addr a;
+
+  inet_pton(AF_INET6, addr, &a);
+  return fib6_lookup(&fib, &a);
+}
+
+static uint32_t
+route6_add_str(const char *dest, int prefixlen, const char *gate) {
+  struct in6_addr d, g;
+  uint8_t mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+  inet_pton(AF_INET6, dest, &d);
+  inet_pton(AF_INET6, gate, &g);
+  TEST_ASSERT_EQUAL(fib6_route_add(&fib, &d, prefixlen, &g, 1, mac),
+                    LAGOPUS_RESULT_OK);
+
+  return IN6_IS_ADDR_UNSPECIFIED(&g) ?
+         FIB_ADJACENCY_GLEAN : adjacency6_find(&fib, &g, 1);
+}
+
+static void
+route6_delete_str(const char *dest, int prefixlen) {
+  struct in6_addr d;
+
+  inet_pton(AF_INET6, dest, &d);
+  TEST_ASSERT_EQUAL(fib6_route_delete(&fib, &d, prefixlen),
+                    LAGOPUS_RESULT_OK);
+}
+#endif /* HYBRID */
+
+void
+setUp(void) {
+#ifdef HYBRID
+  TEST_ASSERT_EQUAL(fib_init(&fib), LAGOPUS_RESULT_OK);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+tearDown(void) {
+#ifdef HYBRID
+  fib_fini(&fib);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_lookup_empty(void) {
+#ifdef HYBRID
+  TEST_ASSERT_EQUAL(lookup_str("0.0.0.0"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.1"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(lookup_str("255.255.255.255"), FIB_LOOKUP_MISS);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_route_add_overlap(void) {
+#ifdef HYBRID
+  uint32_t adj8, adj16, adj24, adj28, adj32, adj0;
+
+  adj16 = route_add_str("10.1.0.0", 16, "192.168.0.16");
+  adj8 = route_add_str("10.0.0.0", 8, "192.168.0.8");
+  adj28 = route_add_str("10.1.2.16", 28, "192.168.0.28");
+  adj24 = route_add_str("10.1.2.0", 24, "192.168.0.24");
+  adj32 = route_add_str("10.1.2.20", 32, "192.168.0.32");
+  adj0 = route_add_str("0.0.0.0", 0, "192.168.0.1");
+
+  TEST_ASSERT_EQUAL(lookup_str("11.0.0.1"), adj0);
+  TEST_ASSERT_EQUAL(lookup_str("10.2.0.1"), adj8);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.3.1"), adj16);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.1"), adj24);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.255"), adj24);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.16"), adj28);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.31"), adj28);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.32"), adj24);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.20"), adj32);
+
+  /* same nexthop shares the adjacency. */
+  TEST_ASSERT_EQUAL(route_add_str("172.16.0.0", 12, "192.168.0.8"), adj8);
+  TEST_ASSERT_EQUAL(fib.adjacency[adj8].refcnt, 2);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_route_delete(void) {
+#ifdef HYBRID
+  uint32_t adj8, adj24, adj28;
+
+  adj8 = route_add_str("10.0.0.0", 8, "192.168.0.8");
+  adj24 = route_add_str("10.1.2.0", 24, "192.168.0.24");
+  adj28 = route_add_str("10.1.2.16", 28, "192.168.0.28");
+
+  /* the covering /24 replaces /28. */
+  route_delete_str("10.1.2.16", 28);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.17"), adj24);
+  TEST_ASSERT_EQUAL(fib.adjacency_npending, 1);
+  TEST_ASSERT_EQUAL(fib.tbl8_npending, 1);
+  TEST_ASSERT_EQUAL(*tbl24_entry(&fib, ntohl(inet_addr("10.1.2.0")) >> 8),
+                    make_entry(24, adj24));
+
+  /* the covering /8 replaces /24. */
+  route_delete_str("10.1.2.0", 24);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.17"), adj8);
+
+  /* no covering route. */
+  route_delete_str("10.0.0.0", 8);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.17"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.rules), 0);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.adjacency_map), 0);
+
+  /* delete unknown route. */
+  route_delete_str("10.0.0.0", 8);
+
+  /* released entries are reused after reclaim. */
+  fib_reclaim(&fib);
+  TEST_ASSERT_EQUAL(fib.adjacency_npending, 0);
+  TEST_ASSERT_EQUAL(fib.tbl8_npending, 0);
+  TEST_ASSERT_EQUAL(route_add_str("10.1.2.16", 28, "192.168.0.28"), adj28);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_route_replace(void) {
+#ifdef HYBRID
+  uint32_t adj1, adj2;
+
+  adj1 = route_add_str("10.1.2.0", 25, "192.168.0.1");
+  adj2 = route_add_str("10.1.2.0", 25, "192.168.0.2");
+  TEST_ASSERT_NOT_EQUAL(adj1, adj2);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.1"), adj2);
+  TEST_ASSERT_EQUAL(lookup_str("10.1.2.129"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(fib.adjacency_npending, 1);
+  TEST_ASSERT_EQUAL(fib.adjacency_pending[0], adj1);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_route_link(void) {
+#ifdef HYBRID
+  struct in_addr dest, gate;
+  uint8_t mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+  dest.s_addr = inet_addr("192.168.1.0");
+  gate.s_addr = 0;
+  TEST_ASSERT_EQUAL(fib_route_add(&fib, &dest, 24, &gate, 1,
+                                  RT_SCOPE_LINK, mac),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.10"), FIB_ADJACENCY_GLEAN);
+  TEST_ASSERT_FALSE(fib.adjacency[FIB_ADJACENCY_GLEAN].resolved);
+
+  TEST_ASSERT_EQUAL(fib_route_add(&fib, &dest, 33, &gate, 1,
+                                  RT_SCOPE_LINK, mac),
+                    LAGOPUS_RESULT_INVALID_ARGS);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_arp(void) {
+#ifdef HYBRID
+  struct in_addr dest, gate, host;
+  struct fib_adjacency adj;
+  uint8_t ifmac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+  uint8_t mac1[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+  uint8_t mac2[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x03};
+  uint32_t index;
+
+  /* connected route and route via gateway. */
+  dest.s_addr = inet_addr("192.168.1.0");
+  gate.s_addr = 0;
+  fib_route_add(&fib, &dest, 24, &gate, 1, RT_SCOPE_LINK, ifmac);
+  index = route_add_str("10.0.0.0", 8, "192.168.1.254");
+  fib_adjacency_get(&fib, index, &adj);
+  TEST_ASSERT_FALSE(adj.resolved);
+  TEST_ASSERT_EQUAL_MEMORY(adj.src_mac, ifmac, ETH_LEN);
+
+  /* resolving gateway updates all routes via it. */
+  gate.s_addr = inet_addr("192.168.1.254");
+  TEST_ASSERT_EQUAL(fib_arp_update(&fib, 1, &gate, mac1), LAGOPUS_RESULT_OK);
+  fib_adjacency_get(&fib, lookup_str("10.2.3.4"), &adj);
+  TEST_ASSERT_TRUE(adj.resolved);
+  TEST_ASSERT_EQUAL_MEMORY(adj.dst_mac, mac1, ETH_LEN);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.254"), index);
+
+  /* neighbor on connected route is installed as host route. */
+  host.s_addr = inet_addr("192.168.1.10");
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.10"), FIB_ADJACENCY_GLEAN);
+  TEST_ASSERT_EQUAL(fib_arp_update(&fib, 1, &host, mac2), LAGOPUS_RESULT_OK);
+  fib_adjacency_get(&fib, lookup_str("192.168.1.10"), &adj);
+  TEST_ASSERT_TRUE(adj.resolved);
+  TEST_ASSERT_EQUAL(adj.nexthop.s_addr, host.s_addr);
+  TEST_ASSERT_EQUAL_MEMORY(adj.dst_mac, mac2, ETH_LEN);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.11"), FIB_ADJACENCY_GLEAN);
+
+  /* delete arp entries. */
+  TEST_ASSERT_EQUAL(fib_arp_delete(&fib, &host), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.10"), FIB_ADJACENCY_GLEAN);
+  TEST_ASSERT_EQUAL(fib_arp_delete(&fib, &gate), LAGOPUS_RESULT_OK);
+  fib_adjacency_get(&fib, lookup_str("10.2.3.4"), &adj);
+  TEST_ASSERT_FALSE(adj.resolved);
+  TEST_ASSERT_EQUAL(lookup_str("10.2.3.4"), index);
+  TEST_ASSERT_EQUAL(fib.adjacency_npending, 1);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_arp_host_route(void) {
+#ifdef HYBRID
+  struct in_addr host;
+  uint8_t mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+  uint32_t arp_index, route_index;
+
+  host.s_addr = inet_addr("192.168.1.10");
+  fib_arp_update(&fib, 1, &host, mac);
+  arp_index = lookup_str("192.168.1.10");
+
+  /* /32 route has priority over arp entry. */
+  route_index = route_add_str("192.168.1.10", 32, "192.168.1.1");
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.10"), route_index);
+  fib_arp_update(&fib, 1, &host, mac);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.10"), route_index);
+
+  /* arp entry appears again. */
+  route_delete_str("192.168.1.10", 32);
+  TEST_ASSERT_EQUAL(lookup_str("192.168.1.10"), arp_index);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_adjacency_dirty(void) {
+#ifdef HYBRID
+  struct in_addr gate1, gate2;
+  uint8_t mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+  uint32_t index1, index2;
+
+  index1 = route_add_str("10.0.0.0", 8, "192.168.1.1");
+  index2 = route_add_str("11.0.0.0", 8, "192.168.1.2");
+  TEST_ASSERT_EQUAL(fib.adjacency_dirty, FIB_LOOKUP_MISS);
+
+  /* arp marks the adjacency, and resolving clears the mark. */
+  gate1.s_addr = inet_addr("192.168.1.1");
+  gate2.s_addr = inet_addr("192.168.1.2");
+  fib_arp_update(&fib, 1, &gate1, mac);
+  fib_arp_update(&fib, 1, &gate2, mac);
+  TEST_ASSERT_EQUAL(fib.adjacency_dirty, index2);
+  TEST_ASSERT_EQUAL(fib.adjacency[index2].dirty_next, index1);
+  fib_adjacency_resolve(&fib, NULL);
+  TEST_ASSERT_EQUAL(fib.adjacency_dirty, FIB_LOOKUP_MISS);
+  TEST_ASSERT_FALSE(fib.adjacency[index1].dirty);
+  TEST_ASSERT_EQUAL(fib.adjacency[index1].output_port, OFPP_ALL);
+
+  /* mac change marks all adjacencies of the mac once. */
+  adjacency_mac_changed(mac, &fib);
+  adjacency_mac_changed(mac, &fib);
+  TEST_ASSERT_TRUE(fib.adjacency[index1].dirty);
+  TEST_ASSERT_TRUE(fib.adjacency[index2].dirty);
+  TEST_ASSERT_EQUAL(fib.adjacency[fib.adjacency_dirty].dirty_next,
+                    fib.adjacency_dirty == index1 ? index2 : index1);
+  fib_adjacency_resolve(&fib, NULL);
+
+  /* unresolved adjacency is unlinked from the mac. */
+  fib_arp_delete(&fib, &gate2);
+  adjacency_mac_changed(mac, &fib);
+  TEST_ASSERT_EQUAL(fib.adjacency_dirty, index1);
+  TEST_ASSERT_EQUAL(fib.adjacency[index1].dirty_next, FIB_LOOKUP_MISS);
+  fib_arp_delete(&fib, &gate1);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.adjacency_mac), 0);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_ifaddr_update(void) {
+#ifdef HYBRID
+  struct fib_adjacency adj;
+  uint8_t mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x09};
+  uint32_t index;
+
+  index = route_add_str("10.0.0.0", 8, "192.168.1.254");
+  fib_ifaddr_update(&fib, 1, mac);
+  fib_adjacency_get(&fib, index, &adj);
+  TEST_ASSERT_EQUAL_MEMORY(adj.src_mac, mac, ETH_LEN);
+  TEST_ASSERT_EQUAL(adj.version % 2, 0);
+
+  /* other interface. */
+  mac[5] = 0x0a;
+  fib_ifaddr_update(&fib, 2, mac);
+  fib_adjacency_get(&fib, index, &adj);
+  TEST_ASSERT_EQUAL(adj.src_mac[5], 0x09);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_lookup_bulk(void) {
+#ifdef HYBRID
+  uint32_t addrs[64], indexes[64];
+  unsigned int i;
+
+  route_add_str("10.0.0.0", 8, "192.168.0.8");
+  route_add_str("10.1.2.0", 24, "192.168.0.24");
+  route_add_str("10.1.2.128", 26, "192.168.0.26");
+  route_add_str("10.1.2.130", 32, "192.168.0.32");
+
+  for (i = 0; i < 64; i++) {
+    addrs[i] = ntohl(inet_addr("10.1.2.0")) + i * 5;
+  }
+  addrs[63] = ntohl(inet_addr("11.0.0.1"));
+  fib_lookup_bulk(&fib, addrs, indexes, 64);
+  for (i = 0; i < 64; i++) {
+    TEST_ASSERT_EQUAL(indexes[i], fib_lookup(&fib, addrs[i]));
+  }
+  TEST_ASSERT_EQUAL(indexes[26], lookup_str("10.1.2.130"));
+  TEST_ASSERT_EQUAL(indexes[63], FIB_LOOKUP_MISS);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_tbl8_grow(void) {
+#ifdef HYBRID
+  struct in_addr dest, gate;
+  uint32_t i;
+
+  gate.s_addr = inet_addr("192.168.0.1");
+  for (i = 0; i < FIB_TBL8_CHUNK_GROUPS * 2 + 1; i++) {
+    dest.s_addr = htonl(0x0a000000 + (i << 8) + 0x80);
+    TEST_ASSERT_EQUAL(fib_route_add(&fib, &dest, 25, &gate, 1,
+                                    RT_SCOPE_UNIVERSE, NULL),
+                      LAGOPUS_RESULT_OK);
+  }
+  TEST_ASSERT_EQUAL(fib.tbl8_ngroups, FIB_TBL8_CHUNK_GROUPS * 3);
+  for (i = 0; i < FIB_TBL8_CHUNK_GROUPS * 2 + 1; i++) {
+    TEST_ASSERT_EQUAL(fib_lookup(&fib, 0x0a000000 + (i << 8) + 0x81),
+                      adjacency_find(&fib, &gate));
+    TEST_ASSERT_EQUAL(fib_lookup(&fib, 0x0a000000 + (i << 8) + 0x01),
+                      FIB_LOOKUP_MISS);
+  }
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib_tbl24_lazy(void) {
+#ifdef HYBRID
+  uint32_t i, n = 0;
+
+  /* empty fib has no tbl24 chunk. */
+  for (i = 0; i < FIB_TBL24_CHUNKS; i++) {
+    TEST_ASSERT_NULL(fib.tbl24[i]);
+  }
+
+  /* chunks are allocated for the range of the route(/8 per chunk). */
+  route_add_str("10.1.0.0", 16, "192.168.0.16");
+  route_add_str("10.2.3.128", 25, "192.168.0.25");
+  route_add_str("20.0.0.0", 7, "192.168.0.7");
+  for (i = 0; i < FIB_TBL24_CHUNKS; i++) {
+    if (fib.tbl24[i] != NULL) {
+      n++;
+    }
+  }
+  TEST_ASSERT_EQUAL(n, 1 + 2);
+  TEST_ASSERT_EQUAL(lookup_str("10.3.0.1"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(lookup_str("30.0.0.1"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(lookup_str("21.255.255.255"), lookup_str("20.0.0.1"));
+  TEST_ASSERT_NOT_EQUAL(lookup_str("10.2.3.129"), FIB_LOOKUP_MISS);
+
+  /* chunks are kept after the route was deleted. */
+  route_delete_str("20.0.0.0", 7);
+  TEST_ASSERT_NOT_NULL(fib.tbl24[21]);
+  TEST_ASSERT_EQUAL(lookup_str("21.0.0.1"), FIB_LOOKUP_MISS);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib6_route_add_overlap(void) {
+#ifdef HYBRID
+  uint32_t adj0, adj16, adj32, adj48, adj60, adj64, adj128;
+
+  adj32 = route6_add_str("2001:db8::", 32, "fe80::32");
+  adj64 = route6_add_str("2001:db8:1:2::", 64, "fe80::64");
+  adj48 = route6_add_str("2001:db8:1::", 48, "fe80::48");
+  adj128 = route6_add_str("2001:db8:1:2::10", 128, "fe80::128");
+  adj60 = route6_add_str("2001:db8:1:10::", 60, "fe80::60");
+  adj16 = route6_add_str("2001::", 16, "fe80::16");
+  adj0 = route6_add_str("::", 0, "fe80::1");
+
+  TEST_ASSERT_EQUAL(lookup6_str("2002::1"), adj0);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:1::1"), adj16);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:2::1"), adj32);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:3::1"), adj48);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:2::1"), adj64);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:2::10"), adj128);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:2::11"), adj64);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:1f::1"), adj60);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:20::1"), adj48);
+
+  /* routes are independent of IPv4. */
+  TEST_ASSERT_EQUAL(lookup_str("32.1.13.184"), FIB_LOOKUP_MISS);
+
+  /* invalid prefix length. */
+  TEST_ASSERT_EQUAL(fib6_route_add(&fib, &in6addr_any, 129, NULL, 1, NULL),
+                    LAGOPUS_RESULT_INVALID_ARGS);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib6_route_delete(void) {
+#ifdef HYBRID
+  uint32_t adj32, adj64, adj128, ngroups;
+
+  adj32 = route6_add_str("2001:db8::", 32, "fe80::32");
+  ngroups = fib.tbl8_nfree;
+  adj64 = route6_add_str("2001:db8:1:2::", 64, "fe80::64");
+  adj128 = route6_add_str("2001:db8:1:2::10", 128, "fe80::128");
+  /* /64 chains 4 groups more, and /128 8 groups more. */
+  TEST_ASSERT_EQUAL(ngroups - fib.tbl8_nfree, 4 + 8);
+
+  /* the covering /64 replaces /128, and the chain is collapsed. */
+  route6_delete_str("2001:db8:1:2::10", 128);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:2::10"), adj64);
+  TEST_ASSERT_EQUAL(fib.tbl8_npending, 8);
+  TEST_ASSERT_EQUAL(fib.adjacency_npending, 1);
+  TEST_ASSERT_EQUAL(fib.adjacency_pending[0], adj128);
+
+  /* the covering /32 replaces /64. */
+  route6_delete_str("2001:db8:1:2::", 64);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:2::10"), adj32);
+  TEST_ASSERT_EQUAL(fib.tbl8_npending, 12);
+
+  /* no covering route, all groups are released. */
+  route6_delete_str("2001:db8::", 32);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1:2::10"), FIB_LOOKUP_MISS);
+  TEST_ASSERT_EQUAL(fib.tbl8_npending, 14);
+  TEST_ASSERT_EQUAL(fib.tbl16[0x2001], 0);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.rules6), 0);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.adjacency_map6), 0);
+
+  /* delete unknown route. */
+  route6_delete_str("2001:db8::", 32);
+
+  fib_reclaim(&fib);
+  TEST_ASSERT_EQUAL(fib.tbl8_nfree, fib.tbl8_ngroups);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib6_ndp(void) {
+#ifdef HYBRID
+  struct in6_addr dest, gate, host;
+  struct fib_adjacency adj;
+  uint8_t ifmac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+  uint8_t mac1[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+  uint8_t mac2[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x03};
+  uint32_t index;
+
+  /* connected route and route via link-local gateway. */
+  inet_pton(AF_INET6, "2001:db8:1::", &dest);
+  TEST_ASSERT_EQUAL(fib6_route_add(&fib, &dest, 64, NULL, 1, ifmac),
+                    LAGOPUS_RESULT_OK);
+  index = route6_add_str("::", 0, "fe80::1");
+  fib_adjacency_get(&fib, index, &adj);
+  TEST_ASSERT_FALSE(adj.resolved);
+  TEST_ASSERT_EQUAL(adj.family, AF_INET6);
+  TEST_ASSERT_EQUAL_MEMORY(adj.src_mac, ifmac, ETH_LEN);
+
+  /* resolving link-local gateway installs no host route. */
+  inet_pton(AF_INET6, "fe80::1", &gate);
+  TEST_ASSERT_EQUAL(fib6_ndp_update(&fib, 1, &gate, mac1),
+                    LAGOPUS_RESULT_OK);
+  fib_adjacency_get(&fib, lookup6_str("2001:db8:2::1"), &adj);
+  TEST_ASSERT_TRUE(adj.resolved);
+  TEST_ASSERT_EQUAL_MEMORY(adj.dst_mac, mac1, ETH_LEN);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.rules6), 2);
+
+  /* neighbor on connected route is installed as host route. */
+  inet_pton(AF_INET6, "2001:db8:1::10", &host);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1::10"), FIB_ADJACENCY_GLEAN);
+  TEST_ASSERT_EQUAL(fib6_ndp_update(&fib, 1, &host, mac2),
+                    LAGOPUS_RESULT_OK);
+  fib_adjacency_get(&fib, lookup6_str("2001:db8:1::10"), &adj);
+  TEST_ASSERT_TRUE(adj.resolved);
+  TEST_ASSERT_EQUAL_MEMORY(&adj.nexthop6, &host, sizeof(host));
+  TEST_ASSERT_EQUAL_MEMORY(adj.dst_mac, mac2, ETH_LEN);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1::11"), FIB_ADJACENCY_GLEAN);
+
+  /* /128 route has priority over neighbor. */
+  index = route6_add_str("2001:db8:1::10", 128, "fe80::1");
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1::10"), index);
+  fib6_ndp_update(&fib, 1, &host, mac2);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1::10"), index);
+  route6_delete_str("2001:db8:1::10", 128);
+  fib_adjacency_get(&fib, lookup6_str("2001:db8:1::10"), &adj);
+  TEST_ASSERT_EQUAL_MEMORY(&adj.nexthop6, &host, sizeof(host));
+
+  /* delete neighbors. */
+  TEST_ASSERT_EQUAL(fib6_ndp_delete(&fib, 1, &host), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(lookup6_str("2001:db8:1::10"), FIB_ADJACENCY_GLEAN);
+  TEST_ASSERT_EQUAL(fib6_ndp_delete(&fib, 1, &gate), LAGOPUS_RESULT_OK);
+  fib_adjacency_get(&fib, lookup6_str("2001:db8:2::1"), &adj);
+  TEST_ASSERT_FALSE(adj.resolved);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&fib.adjacency_map6), 1);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_fib6_lookup_bulk(void) {
+#ifdef HYBRID
+  struct in6_addr addrs[64];
+  uint32_t indexes[64];
+  unsigned int i;
+
+  route6_add_str("2001:db8::", 32, "fe80::32");
+  route6_add_str("2001:db8:0:1::", 64, "fe80::64");
+  route6_add_str("2001:db8:0:1::80", 121, "fe80::121");
+
+  for (i = 0; i < 64; i++) {
+    inet_pton(AF_INET6, "2001:db8:0:1::", &addrs[i]);
+    addrs[i].s6_addr[15] = (uint8_t)(i * 4);
+  }
+  inet_pton(AF_INET6, "2002::1", &addrs[63]);
+  fib6_lookup_bulk(&fib, addrs, indexes, 64);
+  for (i = 0; i < 64; i++) {
+    TEST_ASSERT_EQUAL(indexes[i], fib6_lookup(&fib, &addrs[i]));
+  }
+  TEST_ASSERT_EQUAL(indexes[0], lookup6_str("2001:db8:0:1::1"));
+  TEST_ASSERT_EQUAL(indexes[32], lookup6_str("2001:db8:0:1::81"));
+  TEST_ASSERT_EQUAL(indexes[63], FIB_LOOKUP_MISS);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
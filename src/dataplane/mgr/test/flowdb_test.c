@@ -498,6 +498,132 @@ test_flowdb_flow_add(void) {
   FLOWDB_DUMP(flowdb, "After cleanup", stdout);
 }
 
+void
+test_flowdb_flow_add_check_overlap(void) {
+  struct table *table;
+  struct ofp_flow_mod flow_mod;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_error error;
+
+  TAILQ_INIT(&match_list);
+  TAILQ_INIT(&instruction_list);
+
+  flowinfo_init();
+
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.table_id = 0;
+  flow_mod.priority = 10;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+
+  table = flowdb_get_table(flowdb, flow_mod.table_id);
+
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             8, (OFPXMT_OFB_IPV4_DST << 1) + 1, 0x0a000000, 0xff000000);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 1);
+
+  /* identical flow is an overlap. */
+  flow_mod.flags = OFPFF_CHECK_OVERLAP;
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             8, (OFPXMT_OFB_IPV4_DST << 1) + 1, 0x0a000000, 0xff000000);
+  TEST_ASSERT_FLOW_ADD_NG(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_EQUAL(error.code, OFPFMFC_OVERLAP);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 1);
+  ofp_match_list_elem_free(&match_list);
+
+  /* different matches are not identical. */
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             8, (OFPXMT_OFB_IPV4_DST << 1) + 1, 0x0a010000, 0xffff0000);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 2);
+
+  /* different priority is not identical. */
+  flow_mod.priority = 11;
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             8, (OFPXMT_OFB_IPV4_DST << 1) + 1, 0x0a000000, 0xff000000);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 3);
+
+  /* identical regardless of the order of matches. */
+  flow_mod.flags = 0;
+  make_match(&match_list, 3,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             1, OFPXMT_OFB_IP_PROTO << 1, IPPROTO_UDP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000001);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 4);
+  make_match(&match_list, 3,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000001,
+             1, OFPXMT_OFB_IP_PROTO << 1, IPPROTO_UDP);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 4);
+  flow_mod.command = OFPFC_DELETE_STRICT;
+  make_match(&match_list, 3,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000001,
+             1, OFPXMT_OFB_IP_PROTO << 1, IPPROTO_UDP);
+  TEST_ASSERT_FLOW_DELETE_OK(bridge, &flow_mod, &match_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 3);
+}
+
+#define INSTALL_NFLOWS 200000
+
+void
+test_flowdb_flow_add_many(void) {
+  struct table *table;
+  struct ofp_flow_mod flow_mod;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_error error;
+  uint32_t i;
+
+  TAILQ_INIT(&match_list);
+  TAILQ_INIT(&instruction_list);
+
+  flowinfo_init();
+
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.table_id = 0;
+  flow_mod.priority = 1;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+
+  table = flowdb_get_table(flowdb, flow_mod.table_id);
+
+  for (i = 0; i < INSTALL_NFLOWS; i++) {
+    /* flowinfo per destination is large, vary the protocol as well. */
+    make_match(&match_list, 3,
+               2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+               4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000000 + i / 200,
+               1, OFPXMT_OFB_IP_PROTO << 1, i % 200);
+    TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                            &instruction_list, &error);
+  }
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, INSTALL_NFLOWS);
+
+  /* an identical flow replaces the installed one. */
+  make_match(&match_list, 3,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000000,
+             1, OFPXMT_OFB_IP_PROTO << 1, 0);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, INSTALL_NFLOWS);
+}
+
 /*
  * XXX these macros depend on build_metadata() and md_*.
  */
@@ -861,6 +987,167 @@ test_flowdb_flow_stats(void) {
   FLOWDB_DUMP(flowdb, "After cleanup", stdout);
 }
 
+struct flow_stats_count {
+  int nflow;
+  int ntable[256];
+  lagopus_result_t result;
+};
+
+static lagopus_result_t
+count_flow_stats(struct ofp_flow_stats *ofp,
+                 struct match_list *match_list,
+                 struct instruction_list *instruction_list,
+                 void *arg) {
+  struct flow_stats_count *count = arg;
+
+  (void) match_list;
+  (void) instruction_list;
+
+  count->nflow++;
+  count->ntable[ofp->table_id]++;
+  return count->result;
+}
+
+#define ITERATE_NFLOWS 2500
+
+void
+test_flowdb_flow_stats_iterate(void) {
+  struct table *table;
+  struct ofp_flow_mod flow_mod;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_flow_stats_request request;
+  struct flowdb_flow_stats_cursor cursor;
+  struct flow_stats_count count;
+  struct ofp_error error;
+  int i, ncall;
+
+  TAILQ_INIT(&match_list);
+  TAILQ_INIT(&instruction_list);
+
+  flowinfo_init();
+
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.table_id = 2;
+  flow_mod.priority = 1;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+  table = flowdb_get_table(flowdb, flow_mod.table_id);
+  for (i = 0; i < ITERATE_NFLOWS; i++) {
+    make_match(&match_list, 3,
+               2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+               4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000000 + i / 200,
+               1, OFPXMT_OFB_IP_PROTO << 1, i % 200);
+    TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                            &instruction_list, &error);
+  }
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, ITERATE_NFLOWS);
+  flow_mod.table_id = 5;
+  flow_mod.cookie = 1;
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+
+  /* All tables, one chunk of flows per call. */
+  memset(&request, 0, sizeof(request));
+  request.table_id = OFPTT_ALL;
+  memset(&cursor, 0, sizeof(cursor));
+  memset(&count, 0, sizeof(count));
+  count.result = LAGOPUS_RESULT_OK;
+  for (ncall = 0; cursor.done == false; ncall++) {
+    TEST_ASSERT_EQUAL(flowdb_flow_stats_iterate(flowdb, &request,
+                                                &match_list, &cursor,
+                                                count_flow_stats, &count,
+                                                &error),
+                      LAGOPUS_RESULT_OK);
+    TEST_ASSERT_TRUE(count.nflow <= (ncall + 1) * FLOWDB_FLOW_STATS_CHUNK);
+  }
+  TEST_ASSERT_EQUAL(ncall, (ITERATE_NFLOWS + 1 + FLOWDB_FLOW_STATS_CHUNK - 1) /
+                    FLOWDB_FLOW_STATS_CHUNK);
+  TEST_ASSERT_EQUAL(count.nflow, ITERATE_NFLOWS + 1);
+  TEST_ASSERT_EQUAL(count.ntable[2], ITERATE_NFLOWS);
+  TEST_ASSERT_EQUAL(count.ntable[5], 1);
+
+  /* Cookie filter. */
+  request.cookie = 1;
+  request.cookie_mask = 1;
+  memset(&cursor, 0, sizeof(cursor));
+  memset(&count, 0, sizeof(count));
+  while (cursor.done == false) {
+    TEST_ASSERT_EQUAL(flowdb_flow_stats_iterate(flowdb, &request,
+                                                &match_list, &cursor,
+                                                count_flow_stats, &count,
+                                                &error),
+                      LAGOPUS_RESULT_OK);
+  }
+  TEST_ASSERT_EQUAL(count.nflow, 1);
+  TEST_ASSERT_EQUAL(count.ntable[5], 1);
+
+  /* Single table, a missing table is not created. */
+  request.cookie_mask = 0;
+  request.table_id = 7;
+  memset(&cursor, 0, sizeof(cursor));
+  memset(&count, 0, sizeof(count));
+  TEST_ASSERT_EQUAL(flowdb_flow_stats_iterate(flowdb, &request,
+                                              &match_list, &cursor,
+                                              count_flow_stats, &count,
+                                              &error),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_TRUE(cursor.done);
+  TEST_ASSERT_EQUAL(count.nflow, 0);
+  TEST_ASSERT_NULL(table_lookup(flowdb, 7));
+
+  /* Flows changed between the calls, each flow is visited once. */
+  request.table_id = 2;
+  memset(&cursor, 0, sizeof(cursor));
+  memset(&count, 0, sizeof(count));
+  TEST_ASSERT_EQUAL(flowdb_flow_stats_iterate(flowdb, &request,
+                                              &match_list, &cursor,
+                                              count_flow_stats, &count,
+                                              &error),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(count.nflow, FLOWDB_FLOW_STATS_CHUNK);
+  flow_mod.table_id = 2;
+  flow_mod.command = OFPFC_DELETE;
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000000);
+  TEST_ASSERT_FLOW_DELETE_OK(bridge, &flow_mod, &match_list, &error);
+  ofp_match_list_elem_free(&match_list);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, ITERATE_NFLOWS - 200);
+  flow_mod.command = OFPFC_ADD;
+  make_match(&match_list, 1, 2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_ARP);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  flow_mod.priority = 2;
+  make_match(&match_list, 1, 2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_ARP);
+  TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                          &instruction_list, &error);
+  while (cursor.done == false) {
+    TEST_ASSERT_EQUAL(flowdb_flow_stats_iterate(flowdb, &request,
+                                                &match_list, &cursor,
+                                                count_flow_stats, &count,
+                                                &error),
+                      LAGOPUS_RESULT_OK);
+  }
+  /* the priority 2 flow is before the cursor, the new priority 1 after. */
+  TEST_ASSERT_EQUAL(count.nflow, ITERATE_NFLOWS + 1);
+
+  /* An error from the proc stops the walk. */
+  request.table_id = 2;
+  memset(&cursor, 0, sizeof(cursor));
+  memset(&count, 0, sizeof(count));
+  count.result = LAGOPUS_RESULT_NO_MEMORY;
+  TEST_ASSERT_EQUAL(flowdb_flow_stats_iterate(flowdb, &request,
+                                              &match_list, &cursor,
+                                              count_flow_stats, &count,
+                                              &error),
+                    LAGOPUS_RESULT_NO_MEMORY);
+  TEST_ASSERT_FALSE(cursor.done);
+  TEST_ASSERT_EQUAL(count.nflow, 1);
+
+  ofp_match_list_elem_free(&match_list);
+}
+
 void
 test_flowdb_flow_aggregate_stats(void) {
   struct table *table;
@@ -1067,3 +1354,156 @@ test_flow_dump(void) {
   flow_dump(table->flow_list->flows[0], fp);
   fclose(fp);
 }
+
+void
+test_flowdb_flow_batch_atomic(void) {
+  struct table *table;
+  struct flowdb_batch *batch;
+  struct ofp_flow_mod flow_mod;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_error error, bad_error;
+
+  TAILQ_INIT(&match_list);
+  TAILQ_INIT(&instruction_list);
+
+  flowinfo_init();
+
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.command = OFPFC_ADD;
+  flow_mod.table_id = 0;
+  flow_mod.priority = 1;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+
+  table = flowdb_get_table(flowdb, flow_mod.table_id);
+
+  /* The second entry lacks ETH_TYPE, nothing is applied. */
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_begin(bridge, &batch),
+                    LAGOPUS_RESULT_OK);
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000001);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_add(batch, &flow_mod, &match_list,
+                                          &instruction_list, &error),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_TRUE(TAILQ_EMPTY(&match_list));
+  make_match(&match_list, 1,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000002);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_add(batch, &flow_mod, &match_list,
+                                          &instruction_list, &bad_error),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_count(batch), 2);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_commit(batch, true),
+                    LAGOPUS_RESULT_OFP_ERROR);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_result_get(batch, 0),
+                    LAGOPUS_RESULT_NOT_STARTED);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_result_get(batch, 1),
+                    LAGOPUS_RESULT_OFP_ERROR);
+  TEST_ASSERT_EQUAL(bad_error.type, OFPET_BAD_MATCH);
+  TEST_ASSERT_EQUAL(bad_error.code, OFPBMC_BAD_PREREQ);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 0);
+  flowdb_flow_batch_free(batch);
+
+  /* Not atomic, only the valid entry is applied. */
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_begin(bridge, &batch),
+                    LAGOPUS_RESULT_OK);
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000001);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_add(batch, &flow_mod, &match_list,
+                                          &instruction_list, &error),
+                    LAGOPUS_RESULT_OK);
+  make_match(&match_list, 1,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000002);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_add(batch, &flow_mod, &match_list,
+                                          &instruction_list, &bad_error),
+                    LAGOPUS_RESULT_OK);
+  flow_mod.command = OFPFC_DELETE_STRICT;
+  make_match(&match_list, 2,
+             2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+             4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000001);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_add(batch, &flow_mod, &match_list,
+                                          NULL, &error),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_commit(batch, false),
+                    LAGOPUS_RESULT_OFP_ERROR);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_result_get(batch, 0),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_result_get(batch, 1),
+                    LAGOPUS_RESULT_OFP_ERROR);
+  TEST_ASSERT_EQUAL(flowdb_flow_batch_result_get(batch, 2),
+                    LAGOPUS_RESULT_OK);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, 0);
+  flowdb_flow_batch_free(batch);
+}
+
+#define BATCH_NFLOWS 100000
+
+static double
+install_flows(uint8_t table_id, bool batched) {
+  struct table *table;
+  struct flowdb_batch *batch;
+  struct ofp_flow_mod flow_mod;
+  struct match_list match_list;
+  struct instruction_list instruction_list;
+  struct ofp_error error;
+  struct timespec t0, t1;
+  uint32_t i;
+
+  TAILQ_INIT(&match_list);
+  TAILQ_INIT(&instruction_list);
+
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.command = OFPFC_ADD;
+  flow_mod.table_id = table_id;
+  flow_mod.priority = 1;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+
+  table = flowdb_get_table(flowdb, table_id);
+  batch = NULL;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (batched == true) {
+    TEST_ASSERT_EQUAL(flowdb_flow_batch_begin(bridge, &batch),
+                      LAGOPUS_RESULT_OK);
+  }
+  for (i = 0; i < BATCH_NFLOWS; i++) {
+    /* flowinfo per destination is large, vary the protocol as well. */
+    make_match(&match_list, 3,
+               2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+               4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000000 + i / 200,
+               1, OFPXMT_OFB_IP_PROTO << 1, i % 200);
+    if (batched == true) {
+      TEST_ASSERT_EQUAL(flowdb_flow_batch_add(batch, &flow_mod, &match_list,
+                                              &instruction_list, &error),
+                        LAGOPUS_RESULT_OK);
+    } else {
+      TEST_ASSERT_FLOW_ADD_OK(bridge, &flow_mod, &match_list,
+                              &instruction_list, &error);
+    }
+  }
+  if (batched == true) {
+    TEST_ASSERT_EQUAL(flowdb_flow_batch_commit(batch, true),
+                      LAGOPUS_RESULT_OK);
+    flowdb_flow_batch_free(batch);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  TEST_ASSERT_TABLE_NFLOW(&table, MISC_FLOWS, BATCH_NFLOWS);
+
+  return (double)BATCH_NFLOWS /
+         ((double)(t1.tv_sec - t0.tv_sec) +
+          (double)(t1.tv_nsec - t0.tv_nsec) / 1e9);
+}
+
+void
+test_flowdb_flow_batch_install_rate(void) {
+  double single, batched;
+
+  flowinfo_init();
+
+  single = install_flows(0, false);
+  batched = install_flows(1, true);
+  printf("install %d flows: %.0f flows/sec, batched %.0f flows/sec\n",
+         BATCH_NFLOWS, single, batched);
+}
@@ -335,7 +335,7 @@ test_interface_l2_switching(void) {
   pkt = create_l2pkt1(port);
   rv = interface_l2_switching(pkt, ifp1);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-  TEST_ASSERT_EQUAL(pkt->output_port, OFPP_ALL);
+  TEST_ASSERT_EQUAL(pkt->output_port, OFPP_FLOOD);
 
   /*
    * TEST 2
@@ -344,8 +344,7 @@ test_interface_l2_switching(void) {
    */
   mactable = &port->bridge->mactable;
   inteth = array_to_uint64(hostB_mac);
-  add_entry_write_table(mactable, &mactable->hashmap[0],
-                        inteth, 2, MACTABLE_SETTYPE_DYNAMIC, now);
+  update_entry(mactable, inteth, 0, 2, MACTABLE_SETTYPE_DYNAMIC, now);
 
   pkt = create_l2pkt1(port);
   rv = interface_l2_switching(pkt, ifp1);
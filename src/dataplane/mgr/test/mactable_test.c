@@ -97,7 +97,7 @@ test_macentry_alloc(void) {
   struct macentry *entry = NULL;
 
   /* alloc entry */
-  entry = macentry_alloc(inteth, portid, address_type);
+  entry = macentry_alloc(inteth, 0, portid, address_type);
 
   /* check entry */
   TEST_ASSERT_NOT_NULL(entry);
@@ -119,7 +119,7 @@ test_add_entry_bbq(void) {
   struct macentry *entry;
 
   /* add entry */
-  rv = add_entry_bbq(&mactable.local, inteth, portid, address_type);
+  rv = add_entry_bbq(&mactable.local[0], inteth, 0, portid, address_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
 
   /* check entry */
@@ -135,58 +135,94 @@ test_add_entry_bbq(void) {
 }
 
 void
-test_add_entry_write_table(void) {
+test_update_entry(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  lagopus_hashmap_t *write_table;
   struct macentry *entry;
   struct timespec update_time;
-  uint32_t read_table_id;
+  uint32_t port;
+  uint16_t addr_type;
 
   /* preparation */
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  write_table = &mactable.hashmap[read_table_id^1];
   update_time = get_current_time();
 
   /* add entry */
-  rv = add_entry_write_table(&mactable, write_table,
-                             inteth, portid,
-                             address_type, update_time);
+  rv = update_entry(&mactable, inteth, 0, portid, address_type, update_time);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, mactable.nentries);
 
   /* check entry */
-  rv = lagopus_hashmap_find(write_table, (void *)inteth, (void **)&entry);
+  rv = lagopus_hashmap_find(&mactable.entries,
+                            (void *)inteth, (void **)&entry);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
   TEST_ASSERT_EQUAL(inteth, entry->inteth);
   TEST_ASSERT_EQUAL(portid, entry->portid);
   TEST_ASSERT_EQUAL(address_type, entry->address_type);
+  TEST_ASSERT_EQUAL_PTR(entry,
+                        TAILQ_FIRST(&mactable.age_bucket[entry->age_bucket]));
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(portid, port);
+
+  /* move entry to other port */
+  rv = update_entry(&mactable, inteth, 0, portid2, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, mactable.nentries);
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(portid2, port);
+
+  /* change to static entry */
+  rv = update_entry(&mactable, inteth, 0, portid, address_type2, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_NULL(TAILQ_FIRST(&mactable.age_bucket[entry->age_bucket]));
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
+  TEST_ASSERT_EQUAL(portid, port);
+  TEST_ASSERT_EQUAL(address_type2, addr_type);
+
+  /* static entry is not moved by learning */
+  rv = update_entry(&mactable, inteth, 0, portid3, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
+  TEST_ASSERT_EQUAL(portid, port);
+  TEST_ASSERT_EQUAL(address_type2, addr_type);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
 
 void
-test_add_entry_write_table_bad_args(void) {
+test_update_entry_full(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  lagopus_hashmap_t *write_table;
   struct timespec update_time;
-  uint32_t read_table_id;
 
   /* preparation */
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  write_table = &mactable.hashmap[read_table_id^1];
   update_time = get_current_time();
+  mactable_max_entries_set(&mactable, 1);
 
   /* add entry */
-  rv = add_entry_write_table(NULL, write_table,
-                             inteth, portid,
-                             address_type, update_time);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_INVALID_ARGS);
+  rv = update_entry(&mactable, inteth, 0, portid, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = update_entry(&mactable, inteth2, 0, portid2, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_TOO_MANY_OBJECTS);
+  TEST_ASSERT_EQUAL(1, mactable.nentries);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_update_entry_bad_args(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
+  struct timespec update_time;
 
-  rv = add_entry_write_table(&mactable, NULL,
-                             inteth, portid,
-                             address_type, update_time);
+  /* preparation */
+  update_time = get_current_time();
+
+  /* add entry */
+  rv = update_entry(NULL, inteth, 0, portid, address_type, update_time);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_INVALID_ARGS);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
@@ -194,40 +230,197 @@ test_add_entry_write_table_bad_args(void) {
 }
 
 void
-test_add_entry_local_cache(void) {
+test_update_entry_vlan(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
   struct macentry *entry;
-  struct local_data *local;
+  struct timespec update_time;
+  uint32_t port;
+  uint16_t addr_type;
 
   /* preparation */
-  local = get_local_data(&mactable);
+  update_time = get_current_time();
 
-  /* add entry */
-  rv = add_entry_local_cache(&local->localcache,
-                             inteth, portid, address_type);
+  /* add same address to different VLANs */
+  rv = update_entry(&mactable, inteth, 10, portid, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = update_entry(&mactable, inteth, 20, portid2, address_type, update_time);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(2, mactable.nentries);
+  TEST_ASSERT_EQUAL(1, mactable.vlan_nentries[10]);
+  TEST_ASSERT_EQUAL(1, mactable.vlan_nentries[20]);
+  TEST_ASSERT_EQUAL(0, mactable.nmoves);
 
   /* check entry */
-  rv = lagopus_hashmap_find(&local->localcache,
-                            (void *)inteth, (void **)&entry);
+  rv = lagopus_hashmap_find(&mactable.entries,
+                            (void *)MACTABLE_KEY(20, inteth),
+                            (void **)&entry);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
   TEST_ASSERT_EQUAL(inteth, entry->inteth);
-  TEST_ASSERT_EQUAL(portid, entry->portid);
-  TEST_ASSERT_EQUAL(address_type, entry->address_type);
+  TEST_ASSERT_EQUAL(20, entry->vid);
+  rv = lookup(mactable.table, MACTABLE_KEY(10, inteth), &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(portid, port);
+  rv = lookup(mactable.table, MACTABLE_KEY(20, inteth), &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(portid2, port);
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
+
+  /* bad VLAN ID */
+  rv = update_entry(&mactable, inteth, MACTABLE_VLAN_MAX, portid,
+                    address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_INVALID_ARGS);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
 
 void
-test_add_entry_local_cache_bad_args(void) {
+test_update_entry_vlan_full(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
+  struct timespec update_time;
+
+  /* preparation */
+  update_time = get_current_time();
+  mactable_vlan_max_entries_set(&mactable, 1);
+  TEST_ASSERT_EQUAL(1, mactable_vlan_max_entries_get(&mactable));
 
   /* add entry */
-  rv = add_entry_local_cache(NULL, inteth, portid, address_type);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_INVALID_ARGS);
+  rv = update_entry(&mactable, inteth, 10, portid, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = update_entry(&mactable, inteth2, 10, portid2, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_TOO_MANY_OBJECTS);
+
+  /* other VLAN is not limited by VLAN 10 */
+  rv = update_entry(&mactable, inteth2, 20, portid2, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(2, mactable.nentries);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_update_entry_move(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
+  struct macentry *entry;
+  struct timespec update_time;
+  uint32_t port;
+  uint16_t addr_type;
+
+  /* preparation */
+  update_time = get_current_time();
+  update_entry(&mactable, inteth, 10, portid, address_type, update_time);
+
+  /* refresh does not move entry */
+  rv = update_entry(&mactable, inteth, 10, REFRESH_PORTID,
+                    address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(0, mactable_moves_get(&mactable));
+
+  /* learned on other port */
+  rv = update_entry(&mactable, inteth, 10, portid2, address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, mactable_moves_get(&mactable));
+  rv = lagopus_hashmap_find(&mactable.entries,
+                            (void *)MACTABLE_KEY(10, inteth),
+                            (void **)&entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, entry->moves);
+  rv = lookup(mactable.table, MACTABLE_KEY(10, inteth), &port, &addr_type);
+  TEST_ASSERT_EQUAL(portid2, port);
+
+  /* refresh of aged out entry is ignored */
+  rv = update_entry(&mactable, inteth2, 10, REFRESH_PORTID,
+                    address_type, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, mactable.nentries);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_cuckoo_insert(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
+  struct mactable_cuckoo *table;
+  uint64_t key;
+  uint32_t port;
+  uint16_t addr_type;
+  unsigned int n = 0;
+
+  /* preparation */
+  table = cuckoo_alloc(64);
+  TEST_ASSERT_NOT_NULL(table);
+
+  /* insert entries until the table is full */
+  for (key = 1; key <= (table->mask + 1) * MACTABLE_BUCKET_ENTRIES; key++) {
+    rv = cuckoo_insert(table, key, (uint32_t)key, address_type);
+    if (rv != LAGOPUS_RESULT_OK) {
+      TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NO_MEMORY);
+      break;
+    }
+    n++;
+  }
+  TEST_ASSERT_TRUE(n > 64);
+
+  /* all entries are found after displacement */
+  for (key = 1; key <= n; key++) {
+    rv = lookup(table, key, &port, &addr_type);
+    TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+    TEST_ASSERT_EQUAL((uint32_t)key, port);
+  }
+  TEST_ASSERT_EQUAL(0, table->move_version & 1);
+
+  /* delete entry */
+  cuckoo_delete(table, 1);
+  rv = lookup(table, 1, &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
+
+  /* clean up */
+  free(table);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_grow_table(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
+  struct timespec update_time;
+  struct mactable_cuckoo *old;
+  uint32_t port;
+  uint16_t addr_type;
+  uint64_t key;
+
+  /* preparation */
+  update_time = get_current_time();
+  mactable_max_entries_set(&mactable, 100000);
+  old = mactable.table;
+
+  /* add entries more than initial size */
+  for (key = 1; key <= 100000; key++) {
+    rv = update_entry(&mactable, key, 0, (uint32_t)key,
+                      address_type, update_time);
+    TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  }
+  TEST_ASSERT_TRUE(mactable.table != old);
+  TEST_ASSERT_NOT_NULL(mactable.retired);
+  for (key = 1; key <= 100000; key++) {
+    rv = lookup(mactable.table, key, &port, &addr_type);
+    TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+    TEST_ASSERT_EQUAL((uint32_t)key, port);
+  }
+
+  /* retired tables are released when no worker refers them */
+  rv = mactable_update(&mactable);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_NULL(mactable.retired);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
@@ -237,23 +430,20 @@ void
 test_lookup(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  struct local_data *local;
   uint16_t addr_type;
   uint32_t port;
 
   /* preparation */
-  local = get_local_data(&mactable);
-  add_entry_local_cache(&local->localcache,
-                        inteth, portid, address_type);
+  cuckoo_insert(mactable.table, inteth, portid, address_type);
 
   /* lookup */
-  rv = lookup(&local->localcache, inteth, &port, &addr_type);
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
   TEST_ASSERT_EQUAL(portid, port);
   TEST_ASSERT_EQUAL(address_type, addr_type);
 
   /* lookup with no match entry */
-  rv = lookup(&local->localcache, inteth2, &port, &addr_type);
+  rv = lookup(mactable.table, inteth2, &port, &addr_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
@@ -308,12 +498,13 @@ test_check_referred(void) {
 
   /* check referred */
   TEST_ASSERT_FALSE(check_referred(&mactable, local));
-  TEST_ASSERT_EQUAL(local->referred_table, 0);
+  TEST_ASSERT_EQUAL(local->referred_generation, 0);
 
-  mactable.read_table = 1;
+  mactable.generation = 1;
 
   TEST_ASSERT_TRUE(check_referred(&mactable, local));
-  TEST_ASSERT_EQUAL(local->referred_table, 1);
+  TEST_ASSERT_EQUAL(local->referred_generation, 1);
+  TEST_ASSERT_FALSE(check_referred(&mactable, local));
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
@@ -323,31 +514,26 @@ void
 test_learn_port(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  struct macentry *entry1, *entry2;
-  struct local_data *local;
-
-  /* preparation */
-  local = get_local_data(&mactable);
+  struct macentry *entry;
 
   /* learn port */
-  rv = learn_port(&mactable, portid, ethaddr, address_type);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-
-  /* check entry from local cache */
-  rv = lagopus_hashmap_find(&local->localcache, (void *)inteth, (void **)&entry1);
+  rv = learn_port(&mactable, portid, 0, ethaddr, address_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-  TEST_ASSERT_EQUAL(inteth, entry1->inteth);
-  TEST_ASSERT_EQUAL(portid, entry1->portid);
-  TEST_ASSERT_EQUAL(address_type, entry1->address_type);
 
   /* check entry from bbq */
   rv = lagopus_bbq_get(&mactable.local->bbq,
-                  &entry2,
+                  &entry,
                   struct macentry *, 0);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-  TEST_ASSERT_EQUAL(inteth, entry2->inteth);
-  TEST_ASSERT_EQUAL(portid, entry2->portid);
-  TEST_ASSERT_EQUAL(address_type, entry2->address_type);
+  TEST_ASSERT_EQUAL(inteth, entry->inteth);
+  TEST_ASSERT_EQUAL(portid, entry->portid);
+  TEST_ASSERT_EQUAL(address_type, entry->address_type);
+  free(entry);
+
+  /* same entry is thinned out */
+  rv = learn_port(&mactable, portid, 0, ethaddr, address_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(0, lagopus_bbq_size(&mactable.local->bbq));
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
@@ -359,7 +545,7 @@ test_learn_port_bad_args(void) {
   lagopus_result_t rv;
 
   /* learn port */
-  rv = learn_port(NULL, portid, ethaddr, address_type);
+  rv = learn_port(NULL, portid, 0, ethaddr, address_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_INVALID_ARGS);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
@@ -369,51 +555,56 @@ test_learn_port_bad_args(void) {
 void
 test_lookup_port(void) {
 #ifdef HYBRID
-  lagopus_hashmap_t *read_table;
-  struct local_data *local;
   struct macentry *entry;
   uint32_t port;
-  uint32_t read_table_id;
 
   /* preparation */
-  local = get_local_data(&mactable);
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  read_table = &mactable.hashmap[read_table_id];
-  add_entry_local_cache(read_table,
-                        inteth, portid, address_type);
-  add_entry_local_cache(&local->localcache,
-                        inteth2, portid2, address_type);
-
-  /* lookup from read mactable */
-  port = lookup_port(&mactable, ethaddr);
+  cuckoo_insert(mactable.table, inteth, portid, address_type);
+
+  /* lookup from mactable */
+  port = lookup_port(&mactable, 0, ethaddr);
   TEST_ASSERT_EQUAL(port, portid);
+  TEST_ASSERT_EQUAL(0, mactable.local[0].referring);
 
   /* check entry from bbq */
   lagopus_bbq_get(&mactable.local[0].bbq,
                   &entry,
                   struct macentry *, 0);
   TEST_ASSERT_EQUAL(inteth, entry->inteth);
-  TEST_ASSERT_EQUAL(portid, entry->portid);
+  TEST_ASSERT_EQUAL(REFRESH_PORTID, entry->portid);
   TEST_ASSERT_EQUAL(address_type, entry->address_type);
+  free(entry);
 
-  /* bbq clear */
-  lagopus_bbq_clear(&mactable.local->bbq, true);
+  /* lookup with no match entry */
+  port = lookup_port(&mactable, 0, ethaddr3);
+  TEST_ASSERT_EQUAL(port, OFPP_FLOOD);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
 
-  /* lookup from local cache */
-  port = lookup_port(&mactable, ethaddr2);
-  TEST_ASSERT_EQUAL(port, portid2);
+void
+test_lookup_port_vlan(void) {
+#ifdef HYBRID
+  uint32_t port;
 
-  /* check entry from bbq */
-  lagopus_bbq_get(&mactable.local[0].bbq,
-                  &entry,
-                  struct macentry *, 0);
-  TEST_ASSERT_EQUAL(inteth2, entry->inteth);
-  TEST_ASSERT_EQUAL(portid2, entry->portid);
-  TEST_ASSERT_EQUAL(address_type, entry->address_type);
+  /* preparation */
+  cuckoo_insert(mactable.table, MACTABLE_KEY(10, inteth),
+                portid, address_type);
+  cuckoo_insert(mactable.table, MACTABLE_KEY(20, inteth),
+                portid2, address_type);
 
-  /* lookup with no match entry */
-  port = lookup_port(&mactable, ethaddr3);
-  TEST_ASSERT_EQUAL(port, OFPP_ALL);
+  /* lookup from mactable */
+  port = lookup_port(&mactable, 10, ethaddr);
+  TEST_ASSERT_EQUAL(portid, port);
+  port = lookup_port(&mactable, 20, ethaddr);
+  TEST_ASSERT_EQUAL(portid2, port);
+
+  /* lookup in other VLAN */
+  port = lookup_port(&mactable, 0, ethaddr);
+  TEST_ASSERT_EQUAL(OFPP_FLOOD, port);
+  port = lookup_port(&mactable, 30, ethaddr);
+  TEST_ASSERT_EQUAL(OFPP_FLOOD, port);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
@@ -425,67 +616,96 @@ test_lookup_port_bad_args(void) {
   lagopus_result_t rv;
 
   /* lookup port */
-  rv = lookup_port(NULL, ethaddr);
-  TEST_ASSERT_EQUAL(rv, OFPP_ALL);
+  rv = lookup_port(NULL, 0, ethaddr);
+  TEST_ASSERT_EQUAL(rv, OFPP_FLOOD);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
 
 void
-test_age_out_write_table(void) {
+test_age_out_entries(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  lagopus_hashmap_t *write_table;
   struct macentry *entry;
   struct timespec update_time;
-  uint32_t read_table_id;
+  uint32_t port;
+  uint16_t addr_type;
 
   /* preparation */
   update_time = get_current_time();
   mactable_ageing_time_set(&mactable, 1);
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  write_table = &mactable.hashmap[read_table_id^1];
   /* add dynamic entry. */
-  add_entry_write_table(&mactable, write_table,
-                        inteth, portid, address_type, update_time);
+  update_entry(&mactable, inteth, 0, portid, address_type, update_time);
   /* add static entry. */
-  add_entry_write_table(&mactable, write_table,
-                        inteth2, portid2, address_type2, update_time);
+  update_entry(&mactable, inteth2, 0, portid2, address_type2, update_time);
   sleep(1);
 
   /* age out */
-  rv = age_out_write_table(&mactable, write_table);
+  rv = age_out_entries(&mactable, get_current_time());
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
 
   /* check entry */
-  rv = lagopus_hashmap_find(write_table, (void *)inteth, (void **)&entry);
+  rv = lagopus_hashmap_find(&mactable.entries, (void *)inteth, (void **)&entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
-  rv = lagopus_hashmap_find(write_table, (void *)inteth2, (void **)&entry);
+  rv = lagopus_hashmap_find(&mactable.entries, (void *)inteth2, (void **)&entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = lookup(mactable.table, inteth2, &port, &addr_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, mactable.nentries);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
 
 void
-test_age_out_write_table_bad_args(void) {
+test_age_out_entries_referred(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  lagopus_hashmap_t *write_table;
+  struct macentry *entry;
   struct timespec update_time;
-  uint32_t read_table_id;
+  uint16_t bucket;
 
   /* preparation */
   update_time = get_current_time();
-  mactable_ageing_time_set(&mactable, 1);
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  write_table = &mactable.hashmap[read_table_id^1];
-  add_entry_write_table(&mactable, write_table,
-                        inteth, portid, address_type, update_time);
-  sleep(1);
+  mactable_ageing_time_set(&mactable, 2);
+  update_entry(&mactable, inteth, 10, portid, address_type, update_time);
+  lagopus_hashmap_find(&mactable.entries, (void *)MACTABLE_KEY(10, inteth),
+                       (void **)&entry);
+  bucket = entry->age_bucket;
+
+  /* referred again before expired */
+  update_time.tv_sec += 1;
+  update_entry(&mactable, inteth, 10, REFRESH_PORTID,
+               address_type, update_time);
+
+  /* age out at the first expiry */
+  update_time.tv_sec += 1;
+  rv = age_out_entries(&mactable, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(1, mactable.nentries);
+  TEST_ASSERT_NOT_EQUAL(bucket, entry->age_bucket);
+
+  /* age out at the new expiry */
+  update_time.tv_sec += 1;
+  rv = age_out_entries(&mactable, update_time);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(0, mactable.nentries);
+  TEST_ASSERT_EQUAL(0, mactable.vlan_nentries[10]);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_age_out_entries_bad_args(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
 
   /* age out */
-  rv = age_out_write_table(&mactable, NULL);
+  rv = age_out_entries(NULL, get_current_time());
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_INVALID_ARGS);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
@@ -496,39 +716,60 @@ void
 test_mactable_update(void) {
 #ifdef HYBRID
   lagopus_result_t rv;
-  lagopus_hashmap_t *new_table, *old_table;
   struct timespec update_time;
-  struct macentry entry;
-  uint32_t read_table_id;
+  uint32_t port;
+  uint16_t addr_type;
 
   /* preparation */
   update_time = get_current_time();
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  new_table = &mactable.hashmap[read_table_id^1];
-  old_table = &mactable.hashmap[read_table_id];
-  add_entry_write_table(&mactable, new_table,
-                        inteth, portid, address_type, update_time);
-  add_entry_write_table(&mactable, old_table,
-                        inteth2, portid2, address_type, update_time);
-  add_entry_bbq(&mactable.local, inteth3, portid3, address_type);
-
-  /* check read table index */
-  TEST_ASSERT_EQUAL(mactable.read_table, 0);
+  update_entry(&mactable, inteth, 0, portid, address_type, update_time);
+  add_entry_bbq(&mactable.local[0], inteth2, 0, portid2, address_type);
+  add_entry_bbq(&mactable.local[0], inteth3, 0, portid3, address_type);
+
+  /* check generation */
+  TEST_ASSERT_EQUAL(mactable.generation, 0);
 
   /* mactable update */
   rv = mactable_update(&mactable);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
 
-  /* check read table index */
-  TEST_ASSERT_EQUAL(mactable.read_table, 1);
+  /* check generation */
+  TEST_ASSERT_EQUAL(mactable.generation, 1);
 
   /* check entry */
-  rv = lagopus_hashmap_find(new_table, (void *)inteth, (void **)&entry);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
-  rv = lagopus_hashmap_find(new_table, (void *)inteth2, (void **)&entry);
+  rv = lookup(mactable.table, inteth, &port, &addr_type);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-  rv = lagopus_hashmap_find(new_table, (void *)inteth3, (void **)&entry);
+  rv = lookup(mactable.table, inteth2, &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(portid2, port);
+  rv = lookup(mactable.table, inteth3, &port, &addr_type);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(portid3, port);
+  TEST_ASSERT_EQUAL(3, mactable_num_entries_get(&mactable));
+  TEST_ASSERT_EQUAL(0, lagopus_bbq_size(&mactable.local[0].bbq));
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
+void
+test_mactable_entries_get(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
+  struct macentry entries[2];
+  struct timespec update_time;
+
+  /* preparation */
+  update_time = get_current_time();
+  update_entry(&mactable, inteth, 0, portid, address_type, update_time);
+  update_entry(&mactable, inteth2, 0, portid2, address_type2, update_time);
+  update_entry(&mactable, inteth3, 0, portid3, address_type, update_time);
+
+  /* get entries(smaller than number of entries) */
+  rv = mactable_entries_get(&mactable, entries, 2);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_NOT_EQUAL(0, entries[0].inteth);
+  TEST_ASSERT_NOT_EQUAL(0, entries[1].inteth);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
@@ -560,9 +801,8 @@ test_mactable_port_learning(void) {
   mactable_port_learning(pkt);
 
   /* check entry */
-  rv = lagopus_hashmap_find(&pkt->in_port->bridge->mactable.local[0].localcache,
-                            (void *)inteth,
-                            (void **)&entry);
+  rv = lagopus_bbq_get(&pkt->in_port->bridge->mactable.local[0].bbq,
+                       &entry, struct macentry *, 0);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
   TEST_ASSERT_EQUAL(inteth, entry->inteth);
   TEST_ASSERT_EQUAL(portid, entry->portid);
@@ -577,12 +817,10 @@ test_mactable_port_learning(void) {
 void
 test_mactable_port_lookup(void) {
 #ifdef HYBRID
-  lagopus_hashmap_t *read_table;
   struct lagopus_packet *pkt;
   struct port port;
   char bridge_name[] = "br0";
   int i;
-  uint32_t read_table_id;
 
   /* preparation */
   pkt = alloc_lagopus_packet();
@@ -590,33 +828,22 @@ test_mactable_port_lookup(void) {
   lagopus_packet_init(pkt, NULL, &port);
   pkt->in_port->bridge = bridge_alloc(bridge_name);
 
-  read_table_id = __sync_add_and_fetch(&mactable.read_table, 0);
-  read_table = &pkt->in_port->bridge->mactable.hashmap[read_table_id];
-
-  add_entry_local_cache(read_table, inteth, portid, address_type);
-  add_entry_local_cache(&pkt->in_port->bridge->mactable.local[0].localcache,
-                        inteth2, portid2, address_type);
+  cuckoo_insert(pkt->in_port->bridge->mactable.table,
+                inteth, portid, address_type);
 
-  /* lookup from read mactable */
+  /* lookup from mactable */
   for (i = 0; i < 6; i++) {
     pkt->eth->ether_dhost[i] = ethaddr[i];
   }
   mactable_port_lookup(pkt);
   TEST_ASSERT_EQUAL(portid, pkt->output_port);
 
-  /* lookup from local cache */
-  for (i = 0; i < 6; i++) {
-    pkt->eth->ether_dhost[i] = ethaddr2[i];
-  }
-  mactable_port_lookup(pkt);
-  TEST_ASSERT_EQUAL(portid2, pkt->output_port);
-
   /* lookup with no match entry */
   for (i = 0; i < 6; i++) {
     pkt->eth->ether_dhost[i] = ethaddr3[i];
   }
   mactable_port_lookup(pkt);
-  TEST_ASSERT_EQUAL(OFPP_ALL, pkt->output_port);
+  TEST_ASSERT_EQUAL(OFPP_FLOOD, pkt->output_port);
 
   /* clean up */
   lagopus_packet_free(pkt);
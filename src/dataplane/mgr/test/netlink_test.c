@@ -368,3 +368,138 @@ test_netlink_route_type_del(void) {
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
+
+#ifdef HYBRID
+#define N_ROUTES (100 * 1000)
+#define N_ROUTE_DGRAMS (N_ROUTES / (NETLINK_RECV_BUFSIZ / 60) + 2)
+#endif /* HYBRID */
+
+void
+test_netlink_read_burst_routes(void) {
+#ifdef HYBRID
+  struct route_msg {
+    struct nlmsghdr h;
+    unsigned char kernel_msg[44];
+  };
+
+  static char bufs[N_ROUTE_DGRAMS][NETLINK_RECV_BUFSIZ];
+  static struct mmsghdr msgs[N_ROUTE_DGRAMS];
+  static struct iovec iovs[N_ROUTE_DGRAMS];
+  struct sockaddr_nl snl = { .nl_family = AF_NETLINK };
+  lagopus_result_t rv;
+  struct route_msg *m;
+  struct nlmsghdr *done;
+  struct bridge *bridge = NULL;
+  struct notification_entry *entry;
+  struct rib_tables *tables;
+  struct in_addr ifaddr, broad, dst, nexthop;
+  char *label = "test";
+  uint8_t hwaddr[6] = {0};
+  uint8_t mac[6];
+  uint8_t scope;
+  size_t nroutes, nentries;
+  int ndgrams, n, i;
+  int rc = 0;
+  bool stop = false;
+  unsigned char route_msg[44] = {0x02, 0x20, 0x00, 0x00, 0xfe, 0x02, 0xfd,
+                                 0x01, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00,
+                                 0x0f, 0x00, 0xfe, 0x00, 0x00, 0x00, 0x08,
+                                 0x00, 0x01, 0x00, 0x0a, 0x00, 0x00, 0x00,
+                                 0x08, 0x00, 0x07, 0x00, 0xc0, 0xa8, 0x01,
+                                 0x01, 0x08, 0x00, 0x04, 0x00, 0x01, 0x00,
+                                 0x00, 0x00};
+
+  ifaddr.s_addr = inet_addr("192.168.1.1");
+  broad.s_addr = inet_addr("192.168.255.255");
+  rib_notifier_ipv4_addr_add(1, &ifaddr, 32, &broad, label);
+  rv = dp_tapio_interface_info_get("test", hwaddr, &bridge);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_NOT_NULL(bridge);
+  /* drop ipv4 addr notification entry. */
+  lagopus_bbq_clear(&bridge->rib.notification_queue, true);
+
+  /* dump of the routes as kernel sends, 10.0.0.0/32 and so on. */
+  ndgrams = 0;
+  m = NULL;
+  for (i = 0; i < N_ROUTES; i++) {
+    if (m == NULL ||
+        (char *)(m + 1) + sizeof(*m) > bufs[ndgrams - 1] + sizeof(bufs[0])) {
+      if (m != NULL) {
+        msgs[ndgrams - 1].msg_len = (char *)m - bufs[ndgrams - 1];
+      }
+      m = (struct route_msg *)bufs[ndgrams++];
+    }
+    m->h.nlmsg_len = sizeof(*m);
+    m->h.nlmsg_type = RTM_NEWROUTE;
+    m->h.nlmsg_flags = NLM_F_MULTI;
+    m->h.nlmsg_seq = 1;
+    m->h.nlmsg_pid = 1000;
+    memcpy(m->kernel_msg, route_msg, sizeof(route_msg));
+    m->kernel_msg[25] = (i >> 16) & 0xff;
+    m->kernel_msg[26] = (i >> 8) & 0xff;
+    m->kernel_msg[27] = i & 0xff;
+    m++;
+  }
+  done = (struct nlmsghdr *)m;
+  done->nlmsg_len = NLMSG_LENGTH(sizeof(int));
+  done->nlmsg_type = NLMSG_DONE;
+  done->nlmsg_flags = NLM_F_MULTI;
+  msgs[ndgrams - 1].msg_len =
+    (char *)done + NLMSG_ALIGN(done->nlmsg_len) - bufs[ndgrams - 1];
+  for (i = 0; i < ndgrams; i++) {
+    iovs[i].iov_base = bufs[i];
+    iovs[i].iov_len = msgs[i].msg_len;
+    msgs[i].msg_hdr.msg_name = &snl;
+    msgs[i].msg_hdr.msg_namelen = sizeof(snl);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  /* replay it as recvmmsg() returns. */
+  for (i = 0; i < ndgrams; i += n) {
+    n = ndgrams - i;
+    if (n > NETLINK_RECV_VLEN) {
+      n = NETLINK_RECV_VLEN;
+    }
+    TEST_ASSERT_FALSE(stop);
+    stop = netlink_read_burst(&netlink_monitor, &msgs[i], n,
+                              netlink_fetch, &rc);
+  }
+  TEST_ASSERT_TRUE(stop);
+  TEST_ASSERT_EQUAL(0, rc);
+  TEST_ASSERT_FALSE(rib_notifier_resync_needed());
+
+  /* one entry for each burst. */
+  nentries = lagopus_bbq_size(&bridge->rib.notification_queue);
+  TEST_ASSERT_EQUAL((ndgrams + NETLINK_RECV_VLEN - 1) / NETLINK_RECV_VLEN,
+                    nentries);
+  nroutes = 0;
+  for (i = 0; i < (int)nentries; i++) {
+    rv = lagopus_bbq_get(&bridge->rib.notification_queue, &entry,
+                         struct notification_entry *, 0);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rv);
+    TEST_ASSERT_EQUAL(NOTIFICATION_TYPE_BATCH, entry->type);
+    nroutes += entry->batch.num;
+    rv = lagopus_bbq_put(&bridge->rib.notification_queue, &entry,
+                         struct notification_entry *, 0);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rv);
+  }
+  TEST_ASSERT_EQUAL(N_ROUTES, nroutes);
+
+  /* applied by one update. */
+  rv = rib_update(&bridge->rib);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rv);
+  TEST_ASSERT_EQUAL(0, lagopus_bbq_size(&bridge->rib.notification_queue));
+
+  tables = &bridge->rib.ribs[bridge->rib.read_table];
+  for (i = 0; i < N_ROUTES; i += 9973) {
+    dst.s_addr = htonl(0x0a000000 | (uint32_t)i);
+    rv = route_entry_get(&tables->route_table, &dst, 32,
+                         &nexthop, &scope, mac);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rv);
+    TEST_ASSERT_EQUAL_MEMORY(hwaddr, mac, ETH_LEN);
+  }
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
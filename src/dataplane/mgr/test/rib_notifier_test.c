@@ -328,3 +328,42 @@ test_rib_notifier_route_delete(void) {
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID */
 }
+
+void
+test_rib_notifier_batch_resync(void) {
+#ifdef HYBRID
+  struct in_addr addr, broad, dst;
+  struct rib *rib = NULL;
+  char hwaddr[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+  /* preparation */
+  addr.s_addr = inet_addr("192.168.1.1");
+  broad.s_addr = inet_addr("192.168.255.255");
+  dst.s_addr = inet_addr("192.168.2.2");
+  rib_notifier_ipv4_addr_add(ifindex, &addr, prefixlen, &broad, label);
+  ifinfo_rib_get(ifindex, &rib);
+  TEST_ASSERT_NOT_NULL(rib);
+  TEST_ASSERT_FALSE(rib_notifier_resync_needed());
+
+  /* batch is added. */
+  rib_notifier_batch_begin();
+  rib_notifier_arp_add(ifindex, &dst, hwaddr);
+  rib_notifier_batch_end();
+  TEST_ASSERT_EQUAL(lagopus_bbq_size(&rib->notification_queue), 2);
+  TEST_ASSERT_FALSE(rib_notifier_resync_needed());
+
+  /* batch is lost, resync is requested once. */
+  lagopus_bbq_shutdown(&rib->notification_queue, true);
+  rib_notifier_batch_begin();
+  rib_notifier_arp_add(ifindex, &dst, hwaddr);
+  rib_notifier_batch_end();
+  TEST_ASSERT_TRUE(rib_notifier_resync_needed());
+  TEST_ASSERT_FALSE(rib_notifier_resync_needed());
+
+  /* an entry out of a batch as well. */
+  rib_notifier_arp_delete(ifindex, &dst, hwaddr);
+  TEST_ASSERT_TRUE(rib_notifier_resync_needed());
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
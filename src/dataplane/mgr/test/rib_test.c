@@ -52,78 +52,17 @@ tearDown(void) {
 #endif /* HYBRID*/
 }
 
-void
-test_add_fib_entry(void) {
-#ifdef HYBRID
-  lagopus_result_t rv;
-  struct in_addr dst;
-  struct fib_entry *fib_entry;
-  uint8_t src_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
-  uint8_t dst_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
-  uint32_t port = 1;
-
-  /* preparation */
-  dst.s_addr = inet_addr("192.168.1.1");
-
-  /* add entry */
-  rv = add_fib_entry(&rib.fib[0], dst, src_mac, dst_mac, port);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-
-  /* check entry */
-  rv = lagopus_hashmap_find(&rib.fib[0].localcache,
-                            (void *)(dst.s_addr),
-                            (void **)&fib_entry);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-  TEST_ASSERT_EQUAL_MEMORY(fib_entry->src_mac, src_mac, ETH_LEN);
-  TEST_ASSERT_EQUAL_MEMORY(fib_entry->dst_mac, dst_mac, ETH_LEN);
-  TEST_ASSERT_EQUAL(fib_entry->output_port, port);
-#else /* HYBRID */
-  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
-#endif /* HYBRID*/
-}
-
-void
-test_find_fib_entry(void) {
-#ifdef HYBRID
-  lagopus_result_t rv;
-  struct in_addr dst1, dst2;
-  struct fib_entry *fib_entry;
-  uint8_t src_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
-  uint8_t dst_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
-  uint32_t port = 1;
-
-  /* preparation */
-  dst1.s_addr = inet_addr("192.168.1.1");
-  dst2.s_addr = inet_addr("192.168.2.2");
-  add_fib_entry(&rib.fib[0], dst1, src_mac, dst_mac, port);
-
-  /* find entry */
-  rv = find_fib_entry(&rib.fib[0], dst1, &fib_entry);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-
-  /* check entry */
-  TEST_ASSERT_EQUAL_MEMORY(fib_entry->src_mac, src_mac, ETH_LEN);
-  TEST_ASSERT_EQUAL_MEMORY(fib_entry->dst_mac, dst_mac, ETH_LEN);
-  TEST_ASSERT_EQUAL(fib_entry->output_port, port);
-
-  /* find entry */
-  rv = find_fib_entry(&rib.fib[0], dst2, &fib_entry);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
-#else /* HYBRID */
-  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
-#endif /* HYBRID*/
-}
-
 void
 test_rib_lookup1(void) {
 #if defined HYBRID && !defined PIPELINER
   lagopus_result_t rv;
   struct lagopus_packet *pkt;
-  struct in_addr dst1;
+  struct in_addr dst1, gate;
   struct port *port;
   uint8_t src_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
   uint8_t dst_mac1[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
   uint32_t portid = 1;
+  int ifindex = 1;
   char bridge_name1[] = "br1";
 
   /* preparation */
@@ -139,10 +78,20 @@ test_rib_lookup1(void) {
   lagopus_packet_init(pkt, NULL, port);
   pkt->ipv4->ip_dst.s_addr = inet_addr("192.168.1.1");
 
-  /* add fib entry */
-  dst1.s_addr = inet_addr("192.168.1.1");
-  add_fib_entry(&pkt->bridge->rib.fib[0], dst1,
-                src_mac, dst_mac1, portid);
+  /* add fib entry and resolve output port of the adjacency */
+  dst1.s_addr = inet_addr("192.168.1.0");
+  gate.s_addr = inet_addr("192.168.2.100");
+  rv = fib_route_add(&pkt->bridge->rib.fibtable, &dst1, 24, &gate,
+                     ifindex, RT_SCOPE_UNIVERSE, src_mac);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = fib_arp_update(&pkt->bridge->rib.fibtable, ifindex, &gate, dst_mac1);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = mactable_entry_update(&pkt->in_port->bridge->mactable,
+                             dst_mac1, portid);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = mactable_update(&pkt->in_port->bridge->mactable);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rib_adjacency_resolve(&pkt->bridge->rib, &pkt->in_port->bridge->mactable);
 
   /* lookup from fib */
   rv = rib_lookup(pkt);
@@ -153,7 +102,7 @@ test_rib_lookup1(void) {
   TEST_ASSERT_EQUAL_MEMORY(ETHER_DST(pkt->eth), dst_mac1, ETH_LEN);
   TEST_ASSERT_EQUAL_MEMORY(ETHER_SRC(pkt->eth), src_mac, ETH_LEN);
 
-  /* lookup with no arp entry */
+  /* lookup with no route entry */
   pkt->ipv4->ip_dst.s_addr = inet_addr("192.168.3.3");
   rv = rib_lookup(pkt);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
@@ -171,7 +120,7 @@ test_rib_lookup2(void) {
 #if defined HYBRID && !defined PIPELINER
   lagopus_result_t rv;
   struct macentry *macentry;
-  struct fib_entry *fib_entry;
+  struct fib_adjacency adj;
   struct lagopus_packet *pkt;
   struct port *port;
   struct in_addr dst1, gate;
@@ -206,19 +155,25 @@ test_rib_lookup2(void) {
 
   /* add route entry */
   gate.s_addr = inet_addr("192.168.2.100");
-  route_entry_add(&pkt->bridge->rib.ribs[0].route_table,
-                  &dst1, prefixlen, &gate,
-                  ifindex, scope, src_mac);
+  fib_route_add(&pkt->bridge->rib.fibtable, &dst1, prefixlen, &gate,
+                ifindex, scope, src_mac);
+
+  /* lookup with no arp entry */
+  rv = rib_lookup(pkt);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_TRUE(pkt->send_kernel);
+  pkt->send_kernel = false;
 
   /* add arp entry */
-  arp_entry_update(&pkt->bridge->rib.ribs[0].arp_table,
-                   ifindex, &gate, dst_mac1);
+  fib_arp_update(&pkt->bridge->rib.fibtable, ifindex, &gate, dst_mac1);
   /* add mac entry */
-  rv = lagopus_hashmap_add(&pkt->in_port->bridge->mactable.local[0].localcache,
-                           (void *)inteth, (void **)&macentry, true);
+  rv = mactable_entry_update(&pkt->in_port->bridge->mactable,
+                             dst_mac1, macentry->portid);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = mactable_update(&pkt->in_port->bridge->mactable);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
 
-  /* lookup from routing table */
+  /* lookup from fib, output port is not resolved in adjacency */
   rv = rib_lookup(pkt);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
 
@@ -228,10 +183,13 @@ test_rib_lookup2(void) {
   TEST_ASSERT_EQUAL_MEMORY(ETHER_SRC(pkt->eth), src_mac, 6);
 
   /* check fib entry */
-  rv = find_fib_entry(&pkt->bridge->rib.fib[0], dst1, &fib_entry);
-  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
-  TEST_ASSERT_EQUAL_MEMORY(fib_entry->src_mac, src_mac, 6);
-  TEST_ASSERT_EQUAL_MEMORY(fib_entry->dst_mac, dst_mac1, 6);
+  fib_adjacency_get(&pkt->bridge->rib.fibtable,
+                    fib_lookup(&pkt->bridge->rib.fibtable,
+                               ntohl(dst1.s_addr)), &adj);
+  TEST_ASSERT_TRUE(adj.resolved);
+  TEST_ASSERT_EQUAL(adj.nexthop.s_addr, gate.s_addr);
+  TEST_ASSERT_EQUAL_MEMORY(adj.src_mac, src_mac, 6);
+  TEST_ASSERT_EQUAL_MEMORY(adj.dst_mac, dst_mac1, 6);
 
   /* cleanup */
   bridge_free(port->bridge);
@@ -334,6 +292,12 @@ test_update_tables1(void) {
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
   TEST_ASSERT_EQUAL(arp_entry->ip.s_addr, dst2.s_addr);
   TEST_ASSERT_EQUAL_MEMORY(arp_entry->mac_addr, dst_mac2, ETH_LEN);
+
+  /* check fib */
+  TEST_ASSERT_EQUAL(fib_lookup(&rib.fibtable, ntohl(dst1.s_addr)),
+                    FIB_LOOKUP_MISS);
+  TEST_ASSERT_NOT_EQUAL(fib_lookup(&rib.fibtable, ntohl(dst2.s_addr)),
+                        FIB_LOOKUP_MISS);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID*/
@@ -346,6 +310,8 @@ test_update_tables2(void) {
   struct in_addr dst1, dst2, gate1, gate2;
   struct notification_entry *entry1, *entry2;
   struct route_entry *route_entry;
+  struct fib_adjacency adj;
+  uint32_t index;
   uint8_t dst_mac1[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
   uint8_t dst_mac2[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
   uint8_t scope = 0;
@@ -397,6 +363,15 @@ test_update_tables2(void) {
   TEST_ASSERT_EQUAL(route_entry->dest.s_addr, dst2.s_addr);
   TEST_ASSERT_EQUAL(route_entry->gate.s_addr, gate2.s_addr);
   TEST_ASSERT_EQUAL_MEMORY(route_entry->mac, dst_mac2, ETH_LEN);
+
+  /* check fib */
+  TEST_ASSERT_EQUAL(fib_lookup(&rib.fibtable, ntohl(dst1.s_addr)),
+                    FIB_LOOKUP_MISS);
+  index = fib_lookup(&rib.fibtable, ntohl(dst2.s_addr));
+  TEST_ASSERT_NOT_EQUAL(index, FIB_LOOKUP_MISS);
+  fib_adjacency_get(&rib.fibtable, index, &adj);
+  TEST_ASSERT_EQUAL(adj.nexthop.s_addr, gate2.s_addr);
+  TEST_ASSERT_FALSE(adj.resolved);
 #else /* HYBRID */
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID*/
@@ -426,9 +401,11 @@ test_update_tables3(void) {
   entry1->ifaddr.ifindex = ifindex;
   memcpy(entry1->ifaddr.mac, dst_mac2, ETH_LEN);
 
-  /* add route entry and notification entry */
+  /* add route entry to both tables and notification entry */
   rv = route_entry_add(&rib.ribs[0].route_table, &dst1, prefixlen,
                        &gate1, ifindex, scope, dst_mac1);
+  rv = route_entry_add(&rib.ribs[1].route_table, &dst1, prefixlen,
+                       &gate1, ifindex, scope, dst_mac1);
   rv = rib_add_notification_entry(&rib, entry1);
   TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
 
@@ -459,3 +436,71 @@ test_rib_update(void) {
   TEST_IGNORE_MESSAGE("HYBRID is not defined.");
 #endif /* HYBRID*/
 }
+
+void
+test_update_tables_replay(void) {
+#ifdef HYBRID
+  lagopus_result_t rv;
+  struct in_addr dst1, dst2;
+  struct notification_entry *entry;
+  struct arp_entry *arp_entry;
+  uint8_t dst_mac1[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+  uint8_t dst_mac2[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+  int ifindex = 1;
+
+  /* preparation */
+  rib.read_table = 0;
+  dst1.s_addr = inet_addr("192.168.1.101");
+  dst2.s_addr = inet_addr("192.168.2.102");
+
+  /* first update: written to table 1, and switched. */
+  entry = rib_create_notification_entry(NOTIFICATION_TYPE_ARP,
+                                        NOTIFICATION_ACTION_TYPE_ADD);
+  entry->arp.ifindex = ifindex;
+  entry->arp.ip = dst1;
+  memcpy(entry->arp.mac, dst_mac1, ETH_LEN);
+  rv = rib_add_notification_entry(&rib, entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = rib_update(&rib);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(rib.read_table, 1);
+  TEST_ASSERT_EQUAL(rib.replay_num, 1);
+  rv = lagopus_hashmap_find(&rib.ribs[0].arp_table.hashmap,
+                            (void *)(dst1.s_addr),
+                            (void **)&arp_entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_NOT_FOUND);
+
+  /* second update: table 0 catches up and gets new entry. */
+  entry = rib_create_notification_entry(NOTIFICATION_TYPE_ARP,
+                                        NOTIFICATION_ACTION_TYPE_ADD);
+  entry->arp.ifindex = ifindex;
+  entry->arp.ip = dst2;
+  memcpy(entry->arp.mac, dst_mac2, ETH_LEN);
+  rv = rib_add_notification_entry(&rib, entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = rib_update(&rib);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(rib.read_table, 0);
+  rv = lagopus_hashmap_find(&rib.ribs[0].arp_table.hashmap,
+                            (void *)(dst1.s_addr),
+                            (void **)&arp_entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  rv = lagopus_hashmap_find(&rib.ribs[0].arp_table.hashmap,
+                            (void *)(dst2.s_addr),
+                            (void **)&arp_entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+
+  /* third update without notification: both tables are same. */
+  rv = rib_update(&rib);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(rib.replay_num, 0);
+  TEST_ASSERT_EQUAL(lagopus_hashmap_size(&rib.ribs[0].arp_table.hashmap),
+                    lagopus_hashmap_size(&rib.ribs[1].arp_table.hashmap));
+  rv = lagopus_hashmap_find(&rib.ribs[1].arp_table.hashmap,
+                            (void *)(dst2.s_addr),
+                            (void **)&arp_entry);
+  TEST_ASSERT_EQUAL(rv, LAGOPUS_RESULT_OK);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID*/
+}
@@ -185,3 +185,45 @@ test_add_multiple_timer(void) {
   dp_timer = TAILQ_NEXT(dp_timer, next);
   TEST_ASSERT_NULL(dp_timer);
 }
+
+void
+test_dp_clock(void) {
+  struct timespec ts0, ts1, now;
+  struct timespec req = { 0, 20 * 1000 * 1000 };
+  int64_t diff;
+
+  TEST_ASSERT_NOT_EQUAL(dp_clock_mult, 0);
+
+  /* not updated yet, same as get_current_time(). */
+  memset(&dp_clock, 0, sizeof(dp_clock));
+  ts0 = get_current_time();
+  now = get_cached_time();
+  diff = (now.tv_sec - ts0.tv_sec) * 1000000000 + now.tv_nsec - ts0.tv_nsec;
+  TEST_ASSERT_TRUE(diff >= 0);
+
+  /* cached value does not move until updated. */
+  dp_clock_update();
+  ts0 = get_cached_time();
+  nanosleep(&req, NULL);
+  now = get_cached_time();
+  TEST_ASSERT_EQUAL(now.tv_sec, ts0.tv_sec);
+  TEST_ASSERT_EQUAL(now.tv_nsec, ts0.tv_nsec);
+
+  /* converted from cycles, within 1 msec of the clock. */
+  dp_clock_update();
+  clock_gettime(CLOCK_MONOTONIC, &ts1);
+  now = get_cached_time();
+  diff = (ts1.tv_sec - now.tv_sec) * 1000000000 + ts1.tv_nsec - now.tv_nsec;
+  TEST_ASSERT_TRUE(diff >= -1000000 && diff <= 1000000);
+  diff = (now.tv_sec - ts0.tv_sec) * 1000000000 + now.tv_nsec - ts0.tv_nsec;
+  TEST_ASSERT_TRUE(diff >= 20 * 1000 * 1000);
+  TEST_ASSERT_EQUAL(dp_clock_tsc(), dp_clock.tsc);
+
+  /* never goes backward. */
+  dp_clock.now.tv_sec += 1;
+  ts0 = dp_clock.now;
+  dp_clock_update();
+  now = get_cached_time();
+  TEST_ASSERT_EQUAL(now.tv_sec, ts0.tv_sec);
+  TEST_ASSERT_EQUAL(now.tv_nsec, ts0.tv_nsec);
+}
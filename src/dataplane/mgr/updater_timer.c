@@ -50,6 +50,9 @@ updater_timer_expire(struct dp_timer *dp_timer) {
     /* update rib. */
     rib_update(&bridge->rib);
 
+    /* resolve output ports of fib adjacencies. */
+    rib_adjacency_resolve(&bridge->rib, &bridge->mactable);
+
     /* timer reset */
     add_updater_timer(bridge, UPDATER_TABLE_UPDATE_TIME);
   }
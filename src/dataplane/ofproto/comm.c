@@ -118,7 +118,6 @@ dp_process_event_data(uint64_t dpid, struct eventq_data *data) {
           DECODE_GET(OS_MTOD(PKT2MBUF(pkt), char *), data_len);
           lagopus_packet_init(pkt, PKT2MBUF(pkt), port);
           pkt->cache = NULL;
-          pkt->hash64 = 0;
           if (lagopus_register_action_hook != NULL) {
             struct action *action;
 
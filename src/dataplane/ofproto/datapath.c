@@ -48,6 +48,7 @@
 #include "lagopus/dp_apis.h"
 #include "../agent/ofp_match.h"
 #include "callback.h"
+#include "bonding.h"
 #include "pktbuf.h"
 #include "packet.h"
 #include "csum.h"
@@ -94,6 +95,25 @@
 #define PUT_TIMEOUT 1LL * 1000LL
 #define FIELD(n) ((n) << 1)
 
+/* Time one of 2^DP_LOOKUP_SAMPLE_SHIFT flow lookups of a thread. */
+#ifndef DP_LOOKUP_SAMPLE_SHIFT
+#define DP_LOOKUP_SAMPLE_SHIFT 6
+#endif /* DP_LOOKUP_SAMPLE_SHIFT */
+
+/**
+ * Latency histograms in nsec, see lagopus_histogram_find().
+ */
+static pthread_once_t dp_hist_once = PTHREAD_ONCE_INIT;
+static lagopus_histogram_t flow_lookup_hist = NULL;
+static lagopus_histogram_t packet_in_hist = NULL;
+static __thread uint32_t flow_lookup_count = 0;
+
+static void
+dp_hist_init(void) {
+  (void)lagopus_histogram_create(&flow_lookup_hist, "dp.flow_lookup");
+  (void)lagopus_histogram_create(&packet_in_hist, "dp.packet_in_enqueue");
+}
+
 /**
  * action property for each type.  index is OFPAT_*.
  */
@@ -189,7 +209,10 @@ calc_hash(const uint8_t *buf, size_t len, uint64_t seed) {
   return hash_func((const char *)buf, len, seed);
 }
 #else
-#define calc_hash CityHash64WithSeed
+static inline uint64_t
+calc_hash(const uint8_t *buf, size_t len, uint64_t seed) {
+  return CityHash64WithSeed((const char *)buf, len, seed);
+}
 #endif /* HAVE_DPDK */
 
 static inline uint64_t
@@ -601,6 +624,8 @@ lagopus_packet_init(struct lagopus_packet *pkt, void *m, struct port *port) {
 
   pkt->flags = 0;
   pkt->nmatched = 0;
+  /* packet hash is calculated on demand. */
+  pkt->hash64 = 0;
   /* set raw packet data and port */
   pkt->in_port = port;
   pkt->bridge = port->bridge;
@@ -610,6 +635,100 @@ lagopus_packet_init(struct lagopus_packet *pkt, void *m, struct port *port) {
   classify_ether_packet(pkt);
 }
 
+/**
+ * Hash the flow for worker dispatching.
+ * RSS hash by NIC is used if available, otherwise L3/L4 5-tuple is
+ * hashed.  VLAN tags and MPLS labels are skipped to hash inner headers,
+ * and non-IP packets are hashed by the ethernet header.
+ */
+uint32_t
+lagopus_packet_flow_hash(void *mbuf, uint32_t seed) {
+  OS_MBUF *m = mbuf;
+  const uint8_t *p;
+  size_t len, off, l4;
+  uint16_t ether_type;
+  uint8_t proto;
+  uint64_t hash64;
+
+#ifdef HAVE_DPDK
+  if ((m->ol_flags & PKT_RX_RSS_HASH) != 0) {
+    return m->hash.rss;
+  }
+  len = rte_pktmbuf_data_len(m);
+#else
+  len = OS_M_PKTLEN(m);
+#endif /* HAVE_DPDK */
+  p = OS_MTOD(m, const uint8_t *);
+  if (len < sizeof(ETHER_HDR)) {
+    return seed;
+  }
+  ether_type = (uint16_t)((p[12] << 8) | p[13]);
+  off = sizeof(ETHER_HDR);
+  while ((ether_type == ETHERTYPE_VLAN || ether_type == 0x88a8) &&
+         off + 4 <= len) {
+    ether_type = (uint16_t)((p[off + 2] << 8) | p[off + 3]);
+    off += 4;
+  }
+  if (ether_type == ETHERTYPE_MPLS || ether_type == ETHERTYPE_MPLS_MCAST) {
+    /* skip label stack, and guess payload by IP version. */
+    while (off + 4 <= len) {
+      off += 4;
+      if ((p[off - 2] & 0x01) != 0) {
+        break;
+      }
+    }
+    ether_type = 0;
+    if (off < len) {
+      if ((p[off] >> 4) == 4) {
+        ether_type = ETHERTYPE_IP;
+      } else if ((p[off] >> 4) == 6) {
+        ether_type = ETHERTYPE_IPV6;
+      }
+    }
+  }
+
+  switch (ether_type) {
+    case ETHERTYPE_IP:
+      if (off + sizeof(IPV4_HDR) > len) {
+        return (uint32_t)calc_hash(p, sizeof(ETHER_HDR), seed);
+      }
+      proto = p[off + 9];
+      hash64 = calc_hash(&p[off + 12], sizeof(struct in_addr) * 2, seed);
+      /* fragments have no port numbers. */
+      if ((((p[off + 6] << 8) | p[off + 7]) & 0x3fff) != 0) {
+        proto = 0;
+      }
+      l4 = off + (size_t)((p[off] & 0x0f) << 2);
+      break;
+
+    case ETHERTYPE_IPV6:
+      if (off + sizeof(IPV6_HDR) > len) {
+        return (uint32_t)calc_hash(p, sizeof(ETHER_HDR), seed);
+      }
+      proto = p[off + 6];
+      hash64 = calc_hash(&p[off + 8], sizeof(struct in6_addr) * 2, seed);
+      l4 = off + sizeof(IPV6_HDR);
+      break;
+
+    default:
+      return (uint32_t)calc_hash(p, sizeof(ETHER_HDR), seed);
+  }
+  switch (proto) {
+    case IPPROTO_TCP:
+    case IPPROTO_UDP:
+    case IPPROTO_SCTP:
+      if (l4 + sizeof(uint16_t) * 2 <= len) {
+        hash64 = calc_hash(&p[l4], sizeof(uint16_t) * 2, hash64);
+      }
+      break;
+    default:
+      break;
+  }
+  hash64 = calc_hash(&proto, sizeof(proto), hash64);
+
+  return (uint32_t)(hash64 ^ (hash64 >> 32));
+}
+
 /**
  * Classify ethernet packet.
  */
@@ -638,22 +757,27 @@ calc_packet_hash(struct lagopus_packet *pkt) {
   uint64_t hash64;
 
   hash64 = calc_l2_hash(pkt, pkt->in_port->ifindex);
+  pkt->hash_l2 = (uint32_t)(hash64 ^ (hash64 >> 32));
   switch (pkt->ether_type) {
     case ETHERTYPE_IP:
       hash64 = calc_ipv4_hash(pkt, hash64);
+      pkt->hash_l3 = (uint32_t)(hash64 ^ (hash64 >> 32));
       hash64 = calc_l4_hash(pkt, hash64);
       break;
 
     case ETHERTYPE_IPV6:
       hash64 = calc_ipv6_hash(pkt, hash64);
+      pkt->hash_l3 = (uint32_t)(hash64 ^ (hash64 >> 32));
       hash64 = calc_l4_hash(pkt, hash64);
       break;
 
     case ETHERTYPE_ARP:
       hash64 = calc_arp_hash(pkt, hash64);
+      pkt->hash_l3 = (uint32_t)(hash64 ^ (hash64 >> 32));
       break;
 
     default:
+      pkt->hash_l3 = pkt->hash_l2;
       break;
   }
   pkt->hash64 = hash64;
@@ -683,6 +807,9 @@ copy_packet(struct lagopus_packet *src_pkt) {
   pkt->in_port = src_pkt->in_port;
   pkt->bridge = src_pkt->bridge;
   pkt->ether_type = src_pkt->ether_type;
+  pkt->hash64 = src_pkt->hash64;
+  pkt->hash_l2 = src_pkt->hash_l2;
+  pkt->hash_l3 = src_pkt->hash_l3;
   pkt->l3_hdr = src_pkt->l3_hdr + (dstm - srcm);
   pkt->l4_hdr = src_pkt->l4_hdr + (dstm - srcm);
   pkt->flags = src_pkt->flags | PKT_FLAG_CACHED_FLOW;
@@ -1554,12 +1681,41 @@ packet_in_free(struct eventq_data *data) {
   }
 }
 
+/**
+ * Hash of the packet for bonding, by transmit hash policy.
+ * Intermediate values of the hash for flowcache are reused.
+ */
+static inline uint32_t
+bonding_packet_hash(struct lagopus_packet *pkt,
+                    enum dp_bonding_xmit_hash xmit_hash) {
+  if (pkt->hash64 == 0) {
+    calc_packet_hash(pkt);
+  }
+  switch (xmit_hash) {
+    case DP_BONDING_XMIT_HASH_L2:
+      return pkt->hash_l2;
+    case DP_BONDING_XMIT_HASH_L3:
+      return pkt->hash_l3;
+    case DP_BONDING_XMIT_HASH_L34:
+    default:
+      return pkt->hash32_h ^ pkt->hash32_l;
+  }
+}
+
 int
 lagopus_send_packet_physical(struct lagopus_packet *pkt,
                              struct interface *ifp) {
   if (ifp == NULL) {
     return LAGOPUS_RESULT_OK;
   }
+  if (unlikely(ifp->bond != NULL)) {
+    ifp = bonding_tx_slave(ifp->bond,
+                           bonding_packet_hash(pkt, ifp->bond->xmit_hash));
+    if (ifp == NULL) {
+      lagopus_packet_free(pkt);
+      return LAGOPUS_RESULT_OK;
+    }
+  }
   switch (ifp->info.type) {
     case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_PHY:
     case DATASTORE_INTERFACE_TYPE_ETHERNET_DPDK_VDEV:
@@ -1596,6 +1752,7 @@ send_packet_in(struct lagopus_packet *pkt,
   struct match *port_match, *metadata_match;
   struct pbuf *pbuf;
   uint32_t port_no;
+  lagopus_chrono_t start, end;
   lagopus_result_t rv;
 
   DP_PRINT("%s\n", __func__);
@@ -1677,8 +1834,12 @@ send_packet_in(struct lagopus_packet *pkt,
   /* TUNNEL_ID for physical port is omitted. */
 
   DP_PRINT("%s: put packet to dataq\n", __func__);
+  (void)pthread_once(&dp_hist_once, dp_hist_init);
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(start);
   rv = dp_dataq_data_put(pkt->bridge->dpid,
                          &data, PUT_TIMEOUT);
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(end);
+  (void)lagopus_histogram_record(&packet_in_hist, (int64_t)(end - start));
   if (rv != LAGOPUS_RESULT_OK) {
     DP_PRINT("%s: %s\n", __func__, lagopus_error_get_string(rv));
     data->free(data);
@@ -1749,8 +1910,7 @@ dp_interface_tx_packet(struct lagopus_packet *pkt,
 
     case OFPP_FLOOD:
       /* optional */
-      /* XXX not implemented yet */
-      /* if no mac address learning, OFPP_FLOOD is identical to OFPP_ALL. */
+      /* all ports except in_port and OFPPC_NO_FWD ports, same as OFPP_ALL. */
       DP_PRINT("OFPP_FLOOD as ");
       /*FALLTHROUGH*/
 
@@ -2206,6 +2366,374 @@ execute_action_encap(struct lagopus_packet *pkt,
   return LAGOPUS_RESULT_OK;
 }
 
+/*
+ * Encap header template.
+ *
+ * A run of ENCAP actions in an apply-actions list, and of SET_FIELD
+ * actions writing the headers pushed by the run, is executed once on
+ * a scratch packet when the flow is installed.  The pushed headers are
+ * kept as a template, and a packet gets them by one prepend and copy.
+ * Only the length fields and the UDP source port depend on the packet
+ * and are patched.  Checksums are left to PKT_FLAG_RECALC_* as the
+ * encap action does.
+ */
+#ifndef ENCAP_TEMPLATE_MAX_LEN
+#define ENCAP_TEMPLATE_MAX_LEN 96
+#endif /* ENCAP_TEMPLATE_MAX_LEN */
+#define ENCAP_TEMPLATE_MAX_PATCH 8
+#define ENCAP_TEMPLATE_INNER_LEN 64
+#define ENCAP_TEMPLATE_HASH_LEN sizeof(ETHER_HDR)
+
+enum {
+  ENCAP_PATCH_LEN16,            /* 16bit length field */
+  ENCAP_PATCH_GRE_KEY           /* length in upper 16bit of GRE key */
+};
+
+struct encap_patch {
+  uint16_t off;
+  uint16_t kind;
+  int32_t adj;                  /* value is packet length + adj */
+};
+
+struct encap_template {
+  uint32_t entry_type;          /* packet_type the run is built for */
+  uint32_t packet_type;         /* packet_type after the run */
+  uint32_t flags;               /* packet flags set by the run */
+  uint16_t ether_type;          /* ether_type set by the run, or 0 */
+  uint16_t len;
+  int nactions;                 /* number of actions in the run */
+  int npatch;
+  struct encap_patch patch[ENCAP_TEMPLATE_MAX_PATCH];
+  int sport_off;                /* hashed UDP source port, or -1 */
+  uint16_t hash_off;            /* hashed bytes in the template */
+  uint16_t hash_nhdr;
+  uint8_t hash_hdr[ENCAP_TEMPLATE_HASH_LEN];
+  int nbase;
+  uint8_t base_idx[MAX_BASE];   /* pkt->base[] set by the run */
+  uint16_t base_off[MAX_BASE];
+  uint8_t hdr[ENCAP_TEMPLATE_MAX_LEN];
+};
+
+static size_t
+encap_header_size(uint32_t packet_type) {
+  switch (packet_type) {
+    case (OFPHTN_ETHERTYPE << 16) | ETHERTYPE_MPLS:
+    case (OFPHTN_ETHERTYPE << 16) | ETHERTYPE_MPLS_MCAST:
+      return sizeof(MPLS_HDR);
+    case (OFPHTN_IP_PROTO << 16) | IPPROTO_GRE:
+      return sizeof(GRE_HDR);
+    case (OFPHTN_UDP_TCP_PORT << 16) | VXLAN_PORT:
+      return sizeof(VXLAN_HDR);
+    case (OFPHTN_UDP_TCP_PORT << 16) | GTPU_PORT:
+      return sizeof(struct gtpu_hdr);
+    case (OFPHTN_IP_PROTO << 16) | IPPROTO_UDP:
+      return sizeof(uint16_t) * 4;
+    case (OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP:
+      return sizeof(IPV4_HDR);
+    case (OFPHTN_ONF << 16) | OFPHTO_ETHERNET:
+      return sizeof(ETHER_HDR);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Header written by the set-field action, or NULL if it may not be
+ * part of a template.
+ */
+static uint8_t *
+encap_set_field_header(struct lagopus_packet *pkt,
+                       const struct action *action) {
+  const struct ofp_action_set_field *set_field;
+  bool hasmask;
+
+  set_field = (const struct ofp_action_set_field *)&action->ofpat;
+  hasmask = ((set_field->field[2] & 1) != 0);
+  switch (GET_OXM_FIELD(&action->ofpat)) {
+    case OFPXMT_OFB_ETH_DST:
+    case OFPXMT_OFB_ETH_SRC:
+      return pkt->l2_hdr;
+    case OFPXMT_OFB_IP_DSCP:
+    case OFPXMT_OFB_IP_ECN:
+    case OFPXMT_OFB_IPV4_SRC:
+    case OFPXMT_OFB_IPV4_DST:
+      return (pkt->ether_type == ETHERTYPE_IP) ? pkt->l3_hdr : NULL;
+    case OFPXMT_OFB_UDP_SRC:
+    case OFPXMT_OFB_UDP_DST:
+    case OFPXMT_OFB_GRE_FLAGS:
+    case OFPXMT_OFB_GRE_VER:
+    case OFPXMT_OFB_GRE_PROTOCOL:
+      return pkt->l4_hdr;
+    case OFPXMT_OFB_GRE_KEY:
+      /* masked key keeps the length. */
+      return (hasmask == false) ? pkt->l4_hdr : NULL;
+    case OFPXMT_OFB_MPLS_LABEL:
+    case OFPXMT_OFB_MPLS_TC:
+    case OFPXMT_OFB_MPLS_BOS:
+      return (uint8_t *)pkt->mpls;
+    case OFPXMT_OFB_VXLAN_FLAGS:
+    case OFPXMT_OFB_VXLAN_VNI:
+    case OFPXMT_OFB_GTPU_FLAGS:
+    case OFPXMT_OFB_GTPU_VER:
+    case OFPXMT_OFB_GTPU_MSGTYPE:
+    case OFPXMT_OFB_GTPU_TEID:
+      return pkt->l4_payload;
+    default:
+      return NULL;
+  }
+}
+
+/**
+ * Run the actions from head on the scratch packet and build the
+ * template of the longest run which can be one.
+ */
+static struct encap_template *
+encap_template_build(struct lagopus_packet *pkt, struct action *head) {
+  struct encap_template t, *tmpl;
+  uint8_t *patch_p[ENCAP_TEMPLATE_MAX_PATCH];
+  uint8_t *sport_p, *hash_p, *inner, *data, *p;
+  struct ofp_action_encap *encap;
+  struct action *action;
+  uint16_t val16;
+  uint32_t val32;
+  size_t size;
+  bool hashed;
+  int i;
+
+  memset(&t, 0, sizeof(t));
+  t.entry_type = (OFPHTN_ONF << 16) | OFPHTO_ETHERNET;
+  t.sport_off = -1;
+  sport_p = NULL;
+  hash_p = NULL;
+
+  inner = OS_M_APPEND(PKT2MBUF(pkt), ENCAP_TEMPLATE_INNER_LEN);
+  memset(inner - ENCAP_TEMPLATE_MAX_LEN, 0,
+         ENCAP_TEMPLATE_MAX_LEN + ENCAP_TEMPLATE_INNER_LEN);
+  memset(pkt->base, 0, sizeof(pkt->base));
+  pkt->ether_type = 0;
+  pkt->flags = 0;
+  pkt->oob_data.packet_type = t.entry_type;
+
+  for (action = head; action != NULL; action = TAILQ_NEXT(action, entry)) {
+    data = OS_MTOD(PKT2MBUF(pkt), uint8_t *);
+    if (action->ofpat.type == OFPAT_ENCAP) {
+      encap = (struct ofp_action_encap *)&action->ofpat;
+      size = encap_header_size(encap->packet_type);
+      if (size == 0 ||
+          (size_t)(inner - data) + size > ENCAP_TEMPLATE_MAX_LEN ||
+          t.npatch == ENCAP_TEMPLATE_MAX_PATCH) {
+        break;
+      }
+      hashed = false;
+      if (encap->packet_type == ((OFPHTN_IP_PROTO << 16) | IPPROTO_UDP) &&
+          (pkt->oob_data.packet_type >> 16) == OFPHTN_UDP_TCP_PORT) {
+        /* one hashed source port in a template. */
+        if (pkt->l4_payload < data || pkt->l4_payload >= inner ||
+            sport_p != NULL) {
+          break;
+        }
+        t.hash_nhdr = (uint16_t)(inner - pkt->l4_payload);
+        if (t.hash_nhdr > ENCAP_TEMPLATE_HASH_LEN) {
+          t.hash_nhdr = ENCAP_TEMPLATE_HASH_LEN;
+        }
+        memcpy(t.hash_hdr, pkt->l4_payload, t.hash_nhdr);
+        hash_p = pkt->l4_payload;
+        hashed = true;
+      }
+      if (execute_action_encap(pkt, action) != LAGOPUS_RESULT_OK) {
+        break;
+      }
+      switch (encap->packet_type) {
+        case (OFPHTN_IP_PROTO << 16) | IPPROTO_GRE:
+          t.patch[t.npatch].kind = ENCAP_PATCH_GRE_KEY;
+          patch_p[t.npatch++] = (uint8_t *)&pkt->gre->key;
+          break;
+        case (OFPHTN_UDP_TCP_PORT << 16) | GTPU_PORT:
+          t.patch[t.npatch].kind = ENCAP_PATCH_LEN16;
+          patch_p[t.npatch++] = (uint8_t *)&pkt->gtpu->length;
+          break;
+        case (OFPHTN_IP_PROTO << 16) | IPPROTO_UDP:
+          t.patch[t.npatch].kind = ENCAP_PATCH_LEN16;
+          patch_p[t.npatch++] = (uint8_t *)&UDP_LEN(pkt->udp);
+          if (hashed == true) {
+            sport_p = (uint8_t *)&UDP_SPORT(pkt->udp);
+          }
+          break;
+        case (OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP:
+          t.patch[t.npatch].kind = ENCAP_PATCH_LEN16;
+          patch_p[t.npatch++] = (uint8_t *)&pkt->ipv4->ip_len;
+          break;
+        default:
+          break;
+      }
+    } else if (action->ofpat.type == OFPAT_SET_FIELD) {
+      p = encap_set_field_header(pkt, action);
+      if (p == NULL || p < data || p >= inner) {
+        break;
+      }
+      switch (GET_OXM_FIELD(&action->ofpat)) {
+        case OFPXMT_OFB_UDP_SRC:
+          if (sport_p == (uint8_t *)&UDP_SPORT(pkt->udp)) {
+            sport_p = NULL;
+          }
+          break;
+        case OFPXMT_OFB_GRE_KEY:
+          for (i = 0; i < t.npatch; i++) {
+            if (patch_p[i] == (uint8_t *)&pkt->gre->key) {
+              patch_p[i] = patch_p[--t.npatch];
+              t.patch[i] = t.patch[t.npatch];
+              break;
+            }
+          }
+          break;
+        default:
+          break;
+      }
+      execute_action_set_field(pkt, action);
+    } else {
+      break;
+    }
+    t.nactions++;
+  }
+  if (t.nactions == 0) {
+    return NULL;
+  }
+
+  data = OS_MTOD(PKT2MBUF(pkt), uint8_t *);
+  t.len = (uint16_t)(inner - data);
+  memcpy(t.hdr, data, t.len);
+  for (i = 0; i < MAX_BASE; i++) {
+    if (pkt->base[i] == NULL) {
+      continue;
+    }
+    if (pkt->base[i] < data || pkt->base[i] >= inner) {
+      return NULL;
+    }
+    t.base_idx[t.nbase] = (uint8_t)i;
+    t.base_off[t.nbase++] = (uint16_t)(pkt->base[i] - data);
+  }
+  for (i = 0; i < t.npatch; i++) {
+    t.patch[i].off = (uint16_t)(patch_p[i] - data);
+    if (t.patch[i].kind == ENCAP_PATCH_GRE_KEY) {
+      memcpy(&val32, patch_p[i], sizeof(val32));
+      t.patch[i].adj = (int32_t)(OS_NTOHL(val32) >> 16);
+    } else {
+      memcpy(&val16, patch_p[i], sizeof(val16));
+      t.patch[i].adj = (int32_t)OS_NTOHS(val16);
+    }
+    t.patch[i].adj -= ENCAP_TEMPLATE_INNER_LEN;
+  }
+  if (sport_p != NULL) {
+    t.sport_off = (int)(sport_p - data);
+    t.hash_off = (uint16_t)(hash_p - data);
+  }
+  t.ether_type = pkt->ether_type;
+  t.flags = pkt->flags;
+  t.packet_type = pkt->oob_data.packet_type;
+
+  tmpl = malloc(sizeof(*tmpl));
+  if (tmpl != NULL) {
+    *tmpl = t;
+  }
+  return tmpl;
+}
+
+/**
+ * Execute the run as separate actions, for a packet the template
+ * is not built for.
+ */
+static lagopus_result_t
+execute_action_encap_run(struct lagopus_packet *pkt,
+                         struct action *action,
+                         int nactions) {
+  lagopus_result_t rv;
+  int i;
+
+  rv = LAGOPUS_RESULT_OK;
+  for (i = 0; i < nactions && action != NULL; i++) {
+    if (action->ofpat.type == OFPAT_ENCAP) {
+      rv = execute_action_encap(pkt, action);
+    } else {
+      rv = execute_action_set_field(pkt, action);
+    }
+    if (rv != LAGOPUS_RESULT_OK) {
+      break;
+    }
+    action = TAILQ_NEXT(action, entry);
+  }
+  return rv;
+}
+
+static lagopus_result_t
+execute_action_encap_template(struct lagopus_packet *pkt,
+                              struct action *action) {
+  const struct encap_template *t = action->encap_template;
+  uint8_t buf[ENCAP_TEMPLATE_HASH_LEN];
+  uint32_t len, val32;
+  uint16_t val16;
+  uint8_t *p;
+  OS_MBUF *m;
+  int i;
+
+  m = PKT2MBUF(pkt);
+  if (unlikely(t == NULL)) {
+    return execute_action_encap(pkt, action);
+  }
+  len = (uint32_t)OS_M_PKTLEN(m);
+  if (unlikely(pkt->oob_data.packet_type != t->entry_type ||
+               len < ENCAP_TEMPLATE_HASH_LEN)) {
+    return execute_action_encap_run(pkt, action, t->nactions);
+  }
+  p = (uint8_t *)OS_M_PREPEND(m, t->len);
+  if (unlikely(p == NULL)) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  OS_MEMCPY(p, t->hdr, t->len);
+  for (i = 0; i < t->npatch; i++) {
+    if (t->patch[i].kind == ENCAP_PATCH_GRE_KEY) {
+      val32 = OS_HTONL((len + (uint32_t)t->patch[i].adj) << 16);
+      memcpy(p + t->patch[i].off, &val32, sizeof(val32));
+    } else {
+      val16 = OS_HTONS((uint16_t)(len + (uint32_t)t->patch[i].adj));
+      memcpy(p + t->patch[i].off, &val16, sizeof(val16));
+    }
+  }
+  if (t->sport_off >= 0) {
+    /* bytes as they were when the UDP header is pushed. */
+    memcpy(buf, t->hash_hdr, t->hash_nhdr);
+    memcpy(buf + t->hash_nhdr, p + t->len,
+           ENCAP_TEMPLATE_HASH_LEN - t->hash_nhdr);
+    for (i = 0; i < t->npatch; i++) {
+      if (t->patch[i].kind == ENCAP_PATCH_LEN16 &&
+          t->patch[i].off >= t->hash_off &&
+          t->patch[i].off + sizeof(val16) <=
+          (size_t)t->hash_off + t->hash_nhdr) {
+        memcpy(buf + t->patch[i].off - t->hash_off, p + t->patch[i].off,
+               sizeof(val16));
+      }
+    }
+    val16 = (uint16_t)CityHash64WithSeed((const char *)buf, sizeof(buf), 0);
+    val16 = OS_HTONS(val16 | 0xc000);
+    memcpy(p + t->sport_off, &val16, sizeof(val16));
+  }
+  for (i = 0; i < t->nbase; i++) {
+    pkt->base[t->base_idx[i]] = p + t->base_off[i];
+  }
+  if (t->ether_type != 0) {
+    pkt->ether_type = t->ether_type;
+  }
+  pkt->flags |= t->flags;
+  pkt->oob_data.packet_type = t->packet_type;
+  return LAGOPUS_RESULT_OK;
+}
+
+/* The rest of a run is done by its first action. */
+static lagopus_result_t
+execute_action_encap_template_rest(__UNUSED struct lagopus_packet *pkt,
+                                   __UNUSED struct action *action) {
+  return LAGOPUS_RESULT_OK;
+}
+
 static lagopus_result_t
 execute_action_push_vlan(struct lagopus_packet *pkt,
                          struct action *action) {
@@ -2601,6 +3129,47 @@ lagopus_set_action_function(struct action *action) {
   }
 }
 
+void
+lagopus_set_action_list_function(struct action_list *action_list) {
+  struct lagopus_packet *pkt;
+  struct encap_template *tmpl;
+  struct action *action;
+  int i;
+
+  TAILQ_FOREACH(action, action_list, entry) {
+    if (action->exec == execute_action_encap_template ||
+        action->exec == execute_action_encap_template_rest) {
+      lagopus_set_action_function(action);
+    }
+    free(action->encap_template);
+    action->encap_template = NULL;
+  }
+  action = TAILQ_FIRST(action_list);
+  while (action != NULL) {
+    if (action->ofpat.type != OFPAT_ENCAP) {
+      action = TAILQ_NEXT(action, entry);
+      continue;
+    }
+    pkt = alloc_lagopus_packet();
+    if (pkt == NULL) {
+      break;
+    }
+    tmpl = encap_template_build(pkt, action);
+    lagopus_packet_free(pkt);
+    if (tmpl == NULL) {
+      action = TAILQ_NEXT(action, entry);
+      continue;
+    }
+    action->encap_template = tmpl;
+    action->exec = execute_action_encap_template;
+    action = TAILQ_NEXT(action, entry);
+    for (i = 1; i < tmpl->nactions; i++) {
+      action->exec = execute_action_encap_template_rest;
+      action = TAILQ_NEXT(action, entry);
+    }
+  }
+}
+
 #define LAGOPUS_RESULT_CONTINUE 1
 
 lagopus_result_t
@@ -2759,7 +3328,7 @@ dp_openflow_do_cached_action(struct lagopus_packet *pkt) {
       flow->packet_count++;
       flow->byte_count += OS_M_PKTLEN(PKT2MBUF(pkt));
       if (flow->idle_timeout != 0 || flow->hard_timeout != 0) {
-        flow->update_time = get_current_time();
+        flow->update_time = get_cached_time();
       }
       pkt->flow = flow;
       pkt->table_id = flow->table_id;
@@ -2786,6 +3355,15 @@ dp_openflow_do_cached_action(struct lagopus_packet *pkt) {
   return rv;
 }
 
+static inline struct flow *
+dp_find_flow(struct lagopus_packet *pkt, struct table *table) {
+#ifdef USE_MBTREE
+  return find_mbtree(pkt, table->flow_list);
+#else
+  return lagopus_find_flow(pkt, table);
+#endif
+}
+
 /**
  * match packet (no cache)
  */
@@ -2806,11 +3384,18 @@ dp_openflow_match(struct lagopus_packet *pkt) {
   }
 
   table->lookup_count++;
-#ifdef USE_MBTREE
-  flow = find_mbtree(pkt, table->flow_list);
-#else
-  flow = lagopus_find_flow(pkt, table);
-#endif
+  if (unlikely((++flow_lookup_count &
+                ((1U << DP_LOOKUP_SAMPLE_SHIFT) - 1)) == 0)) {
+    lagopus_chrono_t start, end;
+
+    (void)pthread_once(&dp_hist_once, dp_hist_init);
+    WHAT_TIME_IS_IT_NOW_IN_NSEC(start);
+    flow = dp_find_flow(pkt, table);
+    WHAT_TIME_IS_IT_NOW_IN_NSEC(end);
+    (void)lagopus_histogram_record(&flow_lookup_hist, (int64_t)(end - start));
+  } else {
+    flow = dp_find_flow(pkt, table);
+  }
   if (likely(flow != NULL && pkt->nmatched < LAGOPUS_DP_PIPELINE_MAX)) {
     DP_PRINT("MATCHED\n");
     /* execute_instruction is able to call this function recursively. */
@@ -2981,7 +3566,10 @@ lagopus_get_ip(struct lagopus_packet *pkt, void *dst, const int family) {
       return LAGOPUS_RESULT_OK;
     }
   } else if (family == AF_INET6) {
-    /* TODO: */
+    if (pkt && (pkt->ipv6)) {
+      *((struct in6_addr*)dst) = pkt->ipv6->ip6_dst;
+      return LAGOPUS_RESULT_OK;
+    }
   }
   return LAGOPUS_RESULT_INVALID_ARGS;
 }
@@ -20,6 +20,7 @@
  */
 
 #include <stdlib.h>
+#include <arpa/inet.h>
 
 #include "openflow.h"
 #include "lagopus_apis.h"
@@ -79,16 +80,334 @@ get_match_ipv4_dst(const struct match_list *match_list,
   return LAGOPUS_RESULT_OK;
 }
 
+/*
+ * Contiguous masks are kept in a multibit trie, every node covers
+ * IPV4_DST_TRIE_STRIDE bits of the address.  A prefix of length
+ * depth + len (0 <= len < STRIDE) is held by the node at depth,
+ * indexed by (1 << len) - 1 + (bits >> (STRIDE - len)).
+ * Lookup walks down the trie and visits all matching prefixes from
+ * the shortest.  Non-contiguous masks are kept in next[] per mask.
+ */
+#define IPV4_DST_TRIE_STRIDE 4
+#define IPV4_DST_TRIE_FANOUT (1 << IPV4_DST_TRIE_STRIDE)
+#define IPV4_DST_TRIE_LEVELS (IPV4_DST_BITLEN / IPV4_DST_TRIE_STRIDE + 1)
+
+#define TRIE_ROOT(self) ((struct ipv4_dst_node *)(uintptr_t)(self)->userdata)
+
+/**
+ * Prefix entry of the trie.
+ */
+struct ipv4_dst_prefix {
+  struct flowinfo *flowinfo;    /** flows match the prefix. */
+  int32_t max_pri;              /** upper bound of priority of the flows. */
+};
+
+/**
+ * Multibit trie node.
+ */
+struct ipv4_dst_node {
+  int32_t max_pri;              /** upper bound of priority in subtree. */
+  unsigned int nentry;          /** number of prefixes and children. */
+  struct ipv4_dst_prefix *prefix[IPV4_DST_TRIE_FANOUT - 1];
+  struct ipv4_dst_node *child[IPV4_DST_TRIE_FANOUT];
+};
+
+static inline unsigned int
+trie_bits(uint32_t addr, unsigned int depth) {
+  if (depth >= IPV4_DST_BITLEN) {
+    return 0;
+  }
+  return (addr >> (IPV4_DST_BITLEN - IPV4_DST_TRIE_STRIDE - depth)) &
+         (IPV4_DST_TRIE_FANOUT - 1);
+}
+
+static inline unsigned int
+trie_index(unsigned int bits, unsigned int len) {
+  return (1U << len) - 1 + (bits >> (IPV4_DST_TRIE_STRIDE - len));
+}
+
+/**
+ * Get prefix length of the mask.
+ *
+ * @param[in]   mask    Mask in network byte order.
+ *
+ * @retval      >=0     Prefix length.
+ * @retval      -1      Mask is not contiguous.
+ */
+static int
+get_prefixlen(uint32_t mask) {
+  uint32_t inv;
+
+  inv = ~ntohl(mask);
+  if ((inv & (inv + 1)) != 0) {
+    return -1;
+  }
+  return IPV4_DST_BITLEN - __builtin_popcount(inv);
+}
+
+static struct ipv4_dst_node *
+new_trie_node(void) {
+  struct ipv4_dst_node *node;
+
+  node = calloc(1, sizeof(struct ipv4_dst_node));
+  if (node != NULL) {
+    node->max_pri = -1;
+  }
+  return node;
+}
+
+static void
+destroy_trie_node(struct ipv4_dst_node *node) {
+  struct flowinfo *flowinfo;
+  unsigned int i;
+
+  for (i = 0; i < IPV4_DST_TRIE_FANOUT - 1; i++) {
+    if (node->prefix[i] != NULL) {
+      flowinfo = node->prefix[i]->flowinfo;
+      flowinfo->destroy_func(flowinfo);
+      free(node->prefix[i]);
+    }
+  }
+  for (i = 0; i < IPV4_DST_TRIE_FANOUT; i++) {
+    if (node->child[i] != NULL) {
+      destroy_trie_node(node->child[i]);
+    }
+  }
+  free(node);
+}
+
+/**
+ * Recalculate priority bound of the nodes in the path from bottom,
+ * and release empty nodes except root.
+ */
+static void
+trie_update_path(struct ipv4_dst_node *path[], unsigned int level,
+                 uint32_t addr) {
+  struct ipv4_dst_node *node, *parent;
+  unsigned int i, j;
+  int32_t max_pri;
+
+  for (i = level + 1; i-- > 0;) {
+    node = path[i];
+    if (node->nentry == 0 && i > 0) {
+      parent = path[i - 1];
+      parent->child[trie_bits(addr, (i - 1) * IPV4_DST_TRIE_STRIDE)] = NULL;
+      parent->nentry--;
+      free(node);
+      continue;
+    }
+    max_pri = -1;
+    for (j = 0; j < IPV4_DST_TRIE_FANOUT - 1; j++) {
+      if (node->prefix[j] != NULL && node->prefix[j]->max_pri > max_pri) {
+        max_pri = node->prefix[j]->max_pri;
+      }
+    }
+    for (j = 0; j < IPV4_DST_TRIE_FANOUT; j++) {
+      if (node->child[j] != NULL && node->child[j]->max_pri > max_pri) {
+        max_pri = node->child[j]->max_pri;
+      }
+    }
+    node->max_pri = max_pri;
+  }
+}
+
+/**
+ * Lookup node holds the prefix.
+ *
+ * @param[in]   root    Root node.
+ * @param[in]   addr    Masked address in host byte order.
+ * @param[in]   plen    Prefix length.
+ * @param[in]   create  Create nodes if not exist.
+ * @param[out]  path    Nodes from root to the node.
+ *
+ * @retval      >=0     Level of the node, path[level] is the node.
+ * @retval      -1      Node is not found or no memory.
+ */
+static int
+trie_lookup_node(struct ipv4_dst_node *root, uint32_t addr, unsigned int plen,
+                 bool create, struct ipv4_dst_node *path[]) {
+  struct ipv4_dst_node *node, **nodep;
+  unsigned int depth, level;
+
+  node = root;
+  level = 0;
+  for (depth = 0; depth + IPV4_DST_TRIE_STRIDE <= plen;
+       depth += IPV4_DST_TRIE_STRIDE) {
+    path[level] = node;
+    nodep = &node->child[trie_bits(addr, depth)];
+    if (*nodep == NULL) {
+      if (create == false) {
+        return -1;
+      }
+      *nodep = new_trie_node();
+      if (*nodep == NULL) {
+        trie_update_path(path, level, addr);
+        return -1;
+      }
+      node->nentry++;
+    }
+    node = *nodep;
+    level++;
+  }
+  path[level] = node;
+  return (int)level;
+}
+
+static lagopus_result_t
+add_flow_ipv4_dst_trie(struct flowinfo *self, uint32_t addr,
+                       unsigned int plen, struct flow *flow) {
+  struct ipv4_dst_node *path[IPV4_DST_TRIE_LEVELS], *node;
+  struct ipv4_dst_prefix **prefixp;
+  lagopus_result_t rv;
+  unsigned int depth, i;
+  int level;
+
+  level = trie_lookup_node(TRIE_ROOT(self), addr, plen, true, path);
+  if (level < 0) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  node = path[level];
+  depth = (unsigned int)level * IPV4_DST_TRIE_STRIDE;
+  prefixp = &node->prefix[trie_index(trie_bits(addr, depth), plen - depth)];
+  if (*prefixp == NULL) {
+    *prefixp = calloc(1, sizeof(struct ipv4_dst_prefix));
+    if (*prefixp != NULL) {
+      (*prefixp)->flowinfo = new_flowinfo_ipv4();
+      if ((*prefixp)->flowinfo == NULL) {
+        free(*prefixp);
+        *prefixp = NULL;
+      }
+    }
+    if (*prefixp == NULL) {
+      trie_update_path(path, (unsigned int)level, addr);
+      return LAGOPUS_RESULT_NO_MEMORY;
+    }
+    (*prefixp)->max_pri = -1;
+    node->nentry++;
+  }
+  rv = (*prefixp)->flowinfo->add_func((*prefixp)->flowinfo, flow);
+  if (rv == LAGOPUS_RESULT_OK) {
+    if ((*prefixp)->max_pri < flow->priority) {
+      (*prefixp)->max_pri = flow->priority;
+    }
+    for (i = 0; i <= (unsigned int)level; i++) {
+      if (path[i]->max_pri < flow->priority) {
+        path[i]->max_pri = flow->priority;
+      }
+    }
+  } else if ((*prefixp)->flowinfo->nflow == 0) {
+    (*prefixp)->flowinfo->destroy_func((*prefixp)->flowinfo);
+    free(*prefixp);
+    *prefixp = NULL;
+    node->nentry--;
+    trie_update_path(path, (unsigned int)level, addr);
+  }
+  return rv;
+}
+
+static lagopus_result_t
+del_flow_ipv4_dst_trie(struct flowinfo *self, uint32_t addr,
+                       unsigned int plen, struct flow *flow) {
+  struct ipv4_dst_node *path[IPV4_DST_TRIE_LEVELS], *node;
+  struct ipv4_dst_prefix **prefixp;
+  lagopus_result_t rv;
+  unsigned int depth;
+  int level;
+
+  level = trie_lookup_node(TRIE_ROOT(self), addr, plen, false, path);
+  if (level < 0) {
+    return LAGOPUS_RESULT_NOT_FOUND;
+  }
+  node = path[level];
+  depth = (unsigned int)level * IPV4_DST_TRIE_STRIDE;
+  prefixp = &node->prefix[trie_index(trie_bits(addr, depth), plen - depth)];
+  if (*prefixp == NULL) {
+    return LAGOPUS_RESULT_NOT_FOUND;
+  }
+  rv = (*prefixp)->flowinfo->del_func((*prefixp)->flowinfo, flow);
+  if ((*prefixp)->flowinfo->nflow == 0) {
+    (*prefixp)->flowinfo->destroy_func((*prefixp)->flowinfo);
+    free(*prefixp);
+    *prefixp = NULL;
+    node->nentry--;
+    trie_update_path(path, (unsigned int)level, addr);
+  }
+  return rv;
+}
+
+static struct flow *
+find_flow_ipv4_dst_trie(struct flowinfo *self, uint32_t addr,
+                        unsigned int plen, struct flow *flow) {
+  struct ipv4_dst_node *path[IPV4_DST_TRIE_LEVELS];
+  struct ipv4_dst_prefix *prefix;
+  unsigned int depth;
+  int level;
+
+  level = trie_lookup_node(TRIE_ROOT(self), addr, plen, false, path);
+  if (level < 0) {
+    return NULL;
+  }
+  depth = (unsigned int)level * IPV4_DST_TRIE_STRIDE;
+  prefix = path[level]->prefix[trie_index(trie_bits(addr, depth),
+                                          plen - depth)];
+  if (prefix == NULL) {
+    return NULL;
+  }
+  return prefix->flowinfo->find_func(prefix->flowinfo, flow);
+}
+
+/**
+ * Match all prefixes of the address from the shortest.
+ * Subtree is skipped if no flow in it can beat the current priority.
+ */
+static struct flow *
+match_flow_ipv4_dst_trie(struct flowinfo *self, struct lagopus_packet *pkt,
+                         int32_t *pri) {
+  struct ipv4_dst_node *node;
+  struct ipv4_dst_prefix *prefix;
+  struct flow *flow, *matched;
+  unsigned int depth, len, bits;
+  uint32_t addr;
+
+  matched = NULL;
+  addr = ntohl(pkt->ipv4->ip_dst.s_addr);
+  node = TRIE_ROOT(self);
+  for (depth = 0; node != NULL && node->max_pri > *pri;
+       depth += IPV4_DST_TRIE_STRIDE) {
+    bits = trie_bits(addr, depth);
+    for (len = 0;
+         len < IPV4_DST_TRIE_STRIDE && depth + len <= IPV4_DST_BITLEN;
+         len++) {
+      prefix = node->prefix[trie_index(bits, len)];
+      if (prefix != NULL && prefix->max_pri > *pri) {
+        flow = prefix->flowinfo->match_func(prefix->flowinfo, pkt, pri);
+        if (flow != NULL) {
+          matched = flow;
+        }
+      }
+    }
+    node = node->child[bits];
+  }
+  return matched;
+}
+
 struct flowinfo *
 new_flowinfo_ipv4_dst_mask(void) {
   struct flowinfo *self;
+  struct ipv4_dst_node *root;
 
   self = calloc(1, sizeof(struct flowinfo));
   if (self != NULL) {
+    root = new_trie_node();
+    if (root == NULL) {
+      free(self);
+      return NULL;
+    }
     self->nflow = 0;
     self->nnext = 0;
     self->next = malloc(1);
     self->misc = new_flowinfo_ipv4_src_mask();
+    self->userdata = (uint64_t)(uintptr_t)root;
     self->add_func = add_flow_ipv4_dst_mask;
     self->del_func = del_flow_ipv4_dst_mask;
     self->match_func = match_flow_ipv4_dst_mask;
@@ -103,6 +422,7 @@ destroy_flowinfo_ipv4_dst_mask(struct flowinfo *self) {
   struct flowinfo *flowinfo;
   unsigned int i;
 
+  destroy_trie_node(TRIE_ROOT(self));
   for (i = 0; i < self->nnext; i++) {
     flowinfo = self->next[i];
     flowinfo->destroy_func(flowinfo);
@@ -149,9 +469,19 @@ add_flow_ipv4_dst_mask(struct flowinfo *self, struct flow *flow) {
   uint32_t ipv4_dst, mask;
   lagopus_result_t rv;
   unsigned int i;
+  int plen;
 
   rv = get_match_ipv4_dst(&flow->match_list, &ipv4_dst, &mask);
   if (rv == LAGOPUS_RESULT_OK) {
+    plen = get_prefixlen(mask);
+    if (plen >= 0) {
+      rv = add_flow_ipv4_dst_trie(self, ntohl(ipv4_dst & mask),
+                                  (unsigned int)plen, flow);
+      if (rv == LAGOPUS_RESULT_OK) {
+        self->nflow++;
+      }
+      return rv;
+    }
     rv = LAGOPUS_RESULT_NOT_FOUND;
     for (i = 0; i < self->nnext; i++) {
       if (self->next[i]->userdata == mask) {
@@ -186,9 +516,19 @@ del_flow_ipv4_dst_mask(struct flowinfo *self, struct flow *flow) {
   uint32_t ipv4_dst, mask;
   lagopus_result_t rv;
   unsigned int i;
+  int plen;
 
   rv = get_match_ipv4_dst(&flow->match_list, &ipv4_dst, &mask);
   if (rv == LAGOPUS_RESULT_OK) {
+    plen = get_prefixlen(mask);
+    if (plen >= 0) {
+      rv = del_flow_ipv4_dst_trie(self, ntohl(ipv4_dst & mask),
+                                  (unsigned int)plen, flow);
+      if (rv == LAGOPUS_RESULT_OK) {
+        self->nflow--;
+      }
+      return rv;
+    }
     rv = LAGOPUS_RESULT_NOT_FOUND;
     for (i = 0; i < self->nnext; i++) {
       if (self->next[i]->userdata == mask) {
@@ -219,35 +559,24 @@ static struct flow *
 match_flow_ipv4_dst_mask(struct flowinfo *self, struct lagopus_packet *pkt,
                          int32_t *pri) {
   struct flowinfo *flowinfo;
-  struct flow *flow[self->nnext], *matched, *alt_flow;
-  struct flow mismatched = {
-    .priority = 0,
-    .flags = 0,
-    .idle_timeout = 0,
-    .hard_timeout = 0,
-    .match_list = {NULL, NULL},
-    .instruction_list = {NULL, NULL},
-    .field_bits = 0
-  };
+  struct flow *flow, *matched;
   unsigned int i;
 
-  matched = &mismatched;
-  //#pragma omp parallel for
+  /*
+   * every child returns a flow only if it has higher priority than
+   * *pri, so the last matched flow is the best one.
+   */
+  matched = match_flow_ipv4_dst_trie(self, pkt, pri);
   for (i = 0; i < self->nnext; i++) {
     flowinfo = self->next[i];
-    flow[i] = flowinfo->match_func(flowinfo, pkt, pri);
-  }
-  for (i = 0; i < self->nnext; i++) {
-    if (flow[i] != NULL && flow[i]->priority > matched->priority) {
-      matched = flow[i];
+    flow = flowinfo->match_func(flowinfo, pkt, pri);
+    if (flow != NULL) {
+      matched = flow;
     }
   }
-  alt_flow = self->misc->match_func(self->misc, pkt, pri);
-  if (alt_flow != NULL) {
-    matched = alt_flow;
-  }
-  if (matched == &mismatched) {
-    matched = NULL;
+  flow = self->misc->match_func(self->misc, pkt, pri);
+  if (flow != NULL) {
+    matched = flow;
   }
   return matched;
 }
@@ -258,9 +587,15 @@ find_flow_ipv4_dst_mask(struct flowinfo *self, struct flow *flow) {
   uint32_t ipv4_dst, mask;
   lagopus_result_t rv;
   unsigned int i;
+  int plen;
 
   rv = get_match_ipv4_dst(&flow->match_list, &ipv4_dst, &mask);
   if (rv == LAGOPUS_RESULT_OK) {
+    plen = get_prefixlen(mask);
+    if (plen >= 0) {
+      return find_flow_ipv4_dst_trie(self, ntohl(ipv4_dst & mask),
+                                     (unsigned int)plen, flow);
+    }
     rv = LAGOPUS_RESULT_NOT_FOUND;
     for (i = 0; i < self->nnext; i++) {
       if (self->next[i]->userdata == mask) {
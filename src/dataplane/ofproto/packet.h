@@ -236,6 +236,8 @@ struct lagopus_packet {
       uint32_t hash32_l;
     };
   };
+  uint32_t hash_l2;             /**< L2 part of hash64, for bonding. */
+  uint32_t hash_l3;             /**< L2 and L3 part of hash64, for bonding. */
 
   /*
    * flowcache information.
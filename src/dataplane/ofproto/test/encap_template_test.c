@@ -0,0 +1,325 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <time.h>
+
+#include "unity.h"
+
+#include "lagopus/flowdb.h"
+#include "lagopus/port.h"
+#include "lagopus/dataplane.h"
+#include "pktbuf.h"
+#include "packet.h"
+#include "datapath_test_misc.h"
+
+#define OUTPUT stdout
+#define N_BENCH (1000 * 1000)
+
+/* VXLAN, UDP, IPv4 and Ethernet. */
+#define VXLAN_ENCAP_LEN (8 + 8 + 20 + 14)
+
+static struct port port;
+static struct action_list slow_list;
+static struct action_list tmpl_list;
+
+
+
+
+
+void
+setUp(void) {
+  TAILQ_INIT(&slow_list);
+  TAILQ_INIT(&tmpl_list);
+}
+
+void
+tearDown(void) {
+  struct action *action;
+
+  while ((action = TAILQ_FIRST(&slow_list)) != NULL) {
+    TAILQ_REMOVE(&slow_list, action, entry);
+    free(action);
+  }
+  while ((action = TAILQ_FIRST(&tmpl_list)) != NULL) {
+    TAILQ_REMOVE(&tmpl_list, action, entry);
+    free(action->encap_template);
+    free(action);
+  }
+}
+
+static void
+add_encap(uint32_t packet_type) {
+  struct ofp_action_encap *encap;
+  struct action *action;
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    action = calloc(1, sizeof(*action) + 64);
+    TEST_ASSERT_NOT_NULL(action);
+    encap = (struct ofp_action_encap *)&action->ofpat;
+    encap->type = OFPAT_ENCAP;
+    encap->len = sizeof(*encap);
+    encap->packet_type = packet_type;
+    lagopus_set_action_function(action);
+    TAILQ_INSERT_TAIL((i == 0) ? &slow_list : &tmpl_list, action, entry);
+  }
+}
+
+/* Add the same set-field action to both lists, see set_match(). */
+#define add_set_field(...) do {                                         \
+    struct ofp_action_set_field *action_set;                            \
+    struct action *action;                                              \
+    int i;                                                              \
+    for (i = 0; i < 2; i++) {                                           \
+      action = calloc(1, sizeof(*action) + 64);                         \
+      TEST_ASSERT_NOT_NULL(action);                                     \
+      action_set = (struct ofp_action_set_field *)&action->ofpat;       \
+      action_set->type = OFPAT_SET_FIELD;                               \
+      lagopus_set_action_function(action);                              \
+      set_match(action_set->field, __VA_ARGS__);                        \
+      TAILQ_INSERT_TAIL((i == 0) ? &slow_list : &tmpl_list,             \
+                        action, entry);                                 \
+    }                                                                   \
+  } while (0)
+
+static void
+add_vxlan_actions(void) {
+  add_encap((OFPHTN_UDP_TCP_PORT << 16) | VXLAN_PORT);
+  add_set_field(3, OFPXMT_OFB_VXLAN_VNI << 1, 0x12, 0x34, 0x56);
+  add_encap((OFPHTN_IP_PROTO << 16) | IPPROTO_UDP);
+  add_encap((OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP);
+  add_set_field(4, OFPXMT_OFB_IPV4_SRC << 1, 192, 168, 0, 1);
+  add_set_field(4, OFPXMT_OFB_IPV4_DST << 1, 192, 168, 0, 2);
+  add_encap((OFPHTN_ONF << 16) | OFPHTO_ETHERNET);
+  add_set_field(6, OFPXMT_OFB_ETH_DST << 1,
+                0x23, 0x45, 0x67, 0x89, 0xab, 0xcd);
+  add_set_field(6, OFPXMT_OFB_ETH_SRC << 1,
+                0x22, 0x44, 0x66, 0x88, 0xaa, 0xcc);
+}
+
+static struct lagopus_packet *
+make_packet(size_t len, uint8_t seed) {
+  struct lagopus_packet *pkt;
+  OS_MBUF *m;
+  uint8_t *p;
+  size_t i;
+
+  pkt = alloc_lagopus_packet();
+  TEST_ASSERT_NOT_NULL_MESSAGE(pkt, "lagopus_alloc_packet error.");
+  m = PKT2MBUF(pkt);
+  p = OS_M_APPEND(m, len);
+  for (i = 0; i < len; i++) {
+    p[i] = (uint8_t)(i * 7 + seed);
+  }
+  p[12] = 0x08;
+  p[13] = 0x00;
+  p[14] = 0x45;
+  p[23] = IPPROTO_UDP;
+  lagopus_packet_init(pkt, m, &port);
+
+  return pkt;
+}
+
+/*
+ * Run the actions with and without the template on the same packet
+ * and compare the results.
+ */
+static void
+check_same(size_t len, uint8_t seed, uint32_t packet_type) {
+  struct lagopus_packet *pkt[2];
+  struct action_list *list[2] = { &slow_list, &tmpl_list };
+  uint8_t *data[2];
+  OS_MBUF *m[2];
+  int i;
+
+  for (i = 0; i < 2; i++) {
+    pkt[i] = make_packet(len, seed);
+    if (packet_type != 0) {
+      pkt[i]->oob_data.packet_type = packet_type;
+    }
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, execute_action(pkt[i], list[i]));
+    m[i] = PKT2MBUF(pkt[i]);
+    data[i] = OS_MTOD(m[i], uint8_t *);
+  }
+  TEST_ASSERT_EQUAL(OS_M_PKTLEN(m[0]), OS_M_PKTLEN(m[1]));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data[0], data[1], OS_M_PKTLEN(m[0]));
+  TEST_ASSERT_EQUAL_HEX32(pkt[0]->oob_data.packet_type,
+                          pkt[1]->oob_data.packet_type);
+  TEST_ASSERT_EQUAL_HEX32(pkt[0]->flags, pkt[1]->flags);
+  TEST_ASSERT_EQUAL_HEX16(pkt[0]->ether_type, pkt[1]->ether_type);
+  for (i = 0; i < MAX_BASE; i++) {
+    if (pkt[0]->base[i] == NULL || pkt[1]->base[i] == NULL) {
+      TEST_ASSERT_TRUE(pkt[0]->base[i] == pkt[1]->base[i]);
+    } else {
+      TEST_ASSERT_EQUAL(pkt[0]->base[i] - data[0],
+                        pkt[1]->base[i] - data[1]);
+    }
+  }
+  lagopus_packet_free(pkt[0]);
+  lagopus_packet_free(pkt[1]);
+}
+
+void
+test_encap_template_vxlan(void) {
+  add_vxlan_actions();
+  lagopus_set_action_list_function(&tmpl_list);
+  TEST_ASSERT_NOT_NULL(TAILQ_FIRST(&tmpl_list)->encap_template);
+
+  check_same(64, 0, 0);
+  check_same(64, 1, 0);
+  check_same(1000, 3, 0);
+}
+
+void
+test_encap_template_gtpu(void) {
+  add_encap((OFPHTN_UDP_TCP_PORT << 16) | GTPU_PORT);
+  add_set_field(4, OFPXMT_OFB_GTPU_TEID << 1, 0x01, 0x02, 0x03, 0x04);
+  add_encap((OFPHTN_IP_PROTO << 16) | IPPROTO_UDP);
+  add_set_field(2, OFPXMT_OFB_UDP_DST << 1, 0x08, 0x68);
+  add_encap((OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP);
+  add_set_field(1, OFPXMT_OFB_IP_DSCP << 1, 0x2e);
+  add_encap((OFPHTN_ONF << 16) | OFPHTO_ETHERNET);
+  lagopus_set_action_list_function(&tmpl_list);
+  TEST_ASSERT_NOT_NULL(TAILQ_FIRST(&tmpl_list)->encap_template);
+
+  check_same(64, 0, 0);
+  check_same(300, 5, 0);
+}
+
+void
+test_encap_template_gre(void) {
+  add_encap((OFPHTN_IP_PROTO << 16) | IPPROTO_GRE);
+  add_encap((OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP);
+  add_set_field(4, OFPXMT_OFB_IPV4_DST << 1, 10, 0, 0, 1);
+  add_encap((OFPHTN_ONF << 16) | OFPHTO_ETHERNET);
+  lagopus_set_action_list_function(&tmpl_list);
+  TEST_ASSERT_NOT_NULL(TAILQ_FIRST(&tmpl_list)->encap_template);
+
+  check_same(64, 0, 0);
+  check_same(1500, 9, 0);
+}
+
+void
+test_encap_template_gre_key(void) {
+  add_encap((OFPHTN_IP_PROTO << 16) | IPPROTO_GRE);
+  add_set_field(4, OFPXMT_OFB_GRE_KEY << 1, 0xde, 0xad, 0xbe, 0xef);
+  add_encap((OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP);
+  lagopus_set_action_list_function(&tmpl_list);
+  TEST_ASSERT_NOT_NULL(TAILQ_FIRST(&tmpl_list)->encap_template);
+
+  check_same(64, 0, 0);
+  check_same(200, 2, 0);
+}
+
+void
+test_encap_template_other_packet_type(void) {
+  add_vxlan_actions();
+  lagopus_set_action_list_function(&tmpl_list);
+
+  /* not built for the packet, done action by action. */
+  check_same(64, 0, (OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP);
+}
+
+void
+test_encap_template_split_run(void) {
+  struct action *action;
+
+  add_encap((OFPHTN_UDP_TCP_PORT << 16) | VXLAN_PORT);
+  add_encap((OFPHTN_IP_PROTO << 16) | IPPROTO_UDP);
+  add_set_field(8, OFPXMT_OFB_METADATA << 1,
+                0, 0, 0, 0, 0, 0, 0, 1);
+  add_encap((OFPHTN_ETHERTYPE << 16) | ETHERTYPE_IP);
+  add_encap((OFPHTN_ONF << 16) | OFPHTO_ETHERNET);
+  lagopus_set_action_list_function(&tmpl_list);
+
+  action = TAILQ_FIRST(&tmpl_list);
+  TEST_ASSERT_NOT_NULL(action->encap_template);
+  action = TAILQ_NEXT(action, entry);
+  TEST_ASSERT_NULL(action->encap_template);
+  action = TAILQ_NEXT(action, entry);
+  TEST_ASSERT_NULL(action->encap_template);
+  action = TAILQ_NEXT(action, entry);
+  TEST_ASSERT_NOT_NULL(action->encap_template);
+
+  check_same(64, 0, 0);
+  check_same(128, 4, 0);
+}
+
+void
+test_encap_template_rebuild(void) {
+  struct action *action;
+
+  add_vxlan_actions();
+  lagopus_set_action_list_function(&tmpl_list);
+  /* as the flow is examined again on modify. */
+  TAILQ_FOREACH(action, &tmpl_list, entry) {
+    lagopus_set_action_function(action);
+  }
+  lagopus_set_action_list_function(&tmpl_list);
+  TEST_ASSERT_NOT_NULL(TAILQ_FIRST(&tmpl_list)->encap_template);
+
+  check_same(64, 0, 0);
+}
+
+static inline uint64_t
+get_cycles(void) {
+#ifdef __x86_64__
+  uint32_t lo, hi;
+
+  __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t)hi << 32) | lo;
+#else
+  return 0;
+#endif /* __x86_64__ */
+}
+
+static void
+bench(const char *name, struct action_list *list) {
+  struct lagopus_packet *pkt;
+  struct timespec start, end;
+  uint64_t c0, c1;
+  double nsec;
+  OS_MBUF *m;
+  int i;
+
+  pkt = make_packet(64, 0);
+  m = PKT2MBUF(pkt);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  c0 = get_cycles();
+  for (i = 0; i < N_BENCH; i++) {
+    pkt->oob_data.packet_type = (OFPHTN_ONF << 16) | OFPHTO_ETHERNET;
+    (void)execute_action(pkt, list);
+    OS_M_ADJ(m, VXLAN_ENCAP_LEN);
+  }
+  c1 = get_cycles();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  TEST_ASSERT_EQUAL(64, OS_M_PKTLEN(m));
+  lagopus_packet_free(pkt);
+
+  nsec = (double)(end.tv_sec - start.tv_sec) * 1000000000 +
+         (double)(end.tv_nsec - start.tv_nsec);
+  fprintf(OUTPUT, "vxlan encap %-8s %8.1f nsec/pkt, %8.1f cycles/pkt\n",
+          name, nsec / N_BENCH, (double)(c1 - c0) / N_BENCH);
+}
+
+void
+test_encap_template_vxlan_bench(void) {
+  add_vxlan_actions();
+  lagopus_set_action_list_function(&tmpl_list);
+
+  bench("actions", &slow_list);
+  bench("template", &tmpl_list);
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+
+#include "lagopus/flowdb.h"
+#include "lagopus/port.h"
+#include "lagopus/dataplane.h"
+#include "pktbuf.h"
+#include "packet.h"
+#include "datapath_test_misc.h"
+#include "datapath_test_misc_macros.h"
+
+#define N_WORKERS 4
+#define N_FLOWS   64
+
+static struct lagopus_packet *pkt;
+static OS_MBUF *m;
+
+/*
+ * Make TCP packet between same routers, encapsulated by
+ * nvlan VLAN tags and nmpls MPLS labels.
+ */
+static void
+make_packet(int nvlan, int nmpls, int ipv6, uint32_t flow) {
+  uint8_t *p;
+  int off, i;
+
+  OS_M_TRIM(m, OS_M_PKTLEN(m));
+  p = (uint8_t *)OS_M_APPEND(m, 128);
+  memset(p, 0, 128);
+  for (i = 0; i < 6; i++) {
+    p[i] = 0x02;
+    p[6 + i] = 0x04;
+  }
+  off = 12;
+  for (i = 0; i < nvlan; i++) {
+    p[off] = 0x81;
+    p[off + 1] = 0x00;
+    p[off + 3] = 10;
+    off += 4;
+  }
+  if (nmpls > 0) {
+    p[off] = 0x88;
+    p[off + 1] = 0x47;
+    off += 2;
+    for (i = 0; i < nmpls; i++) {
+      p[off + 1] = (uint8_t)(i + 1);
+      p[off + 2] = (i == nmpls - 1) ? 0x01 : 0x00;
+      p[off + 3] = 64;
+      off += 4;
+    }
+  } else {
+    p[off] = ipv6 ? 0x86 : 0x08;
+    p[off + 1] = ipv6 ? 0xdd : 0x00;
+    off += 2;
+  }
+  if (ipv6) {
+    p[off] = 0x60;
+    p[off + 6] = IPPROTO_TCP;
+    p[off + 7] = 64;
+    p[off + 8] = 0x20;
+    p[off + 9] = 0x01;
+    p[off + 23] = (uint8_t)(flow >> 2);
+    p[off + 24] = 0x20;
+    p[off + 25] = 0x01;
+    p[off + 39] = 1;
+    off += 40;
+  } else {
+    p[off] = 0x45;
+    p[off + 8] = 64;
+    p[off + 9] = IPPROTO_TCP;
+    p[off + 12] = 10;
+    p[off + 15] = (uint8_t)(flow >> 2);
+    p[off + 16] = 10;
+    p[off + 19] = 1;
+    off += 20;
+  }
+  /* source port */
+  p[off] = 0x80;
+  p[off + 1] = (uint8_t)(flow & 0x3);
+  /* destination port */
+  p[off + 3] = 80;
+}
+
+static void
+check_spread(int nvlan, int nmpls, int ipv6) {
+  uint32_t workers[N_FLOWS];
+  int count[N_WORKERS];
+  uint32_t i;
+
+  memset(count, 0, sizeof(count));
+  for (i = 0; i < N_FLOWS; i++) {
+    make_packet(nvlan, nmpls, ipv6, i);
+    workers[i] = lagopus_packet_flow_hash(m, 1) % N_WORKERS;
+    count[workers[i]]++;
+  }
+  for (i = 0; i < N_WORKERS; i++) {
+    TEST_ASSERT_NOT_EQUAL_MESSAGE(count[i], 0, "worker is idle.");
+    TEST_ASSERT_TRUE_MESSAGE(count[i] < N_FLOWS / 2, "worker is overloaded.");
+  }
+
+  /* packets of same flow go to same worker. */
+  for (i = 0; i < N_FLOWS; i++) {
+    make_packet(nvlan, nmpls, ipv6, i);
+    TEST_ASSERT_EQUAL(lagopus_packet_flow_hash(m, 1) % N_WORKERS,
+                      workers[i]);
+  }
+}
+
+void
+setUp(void) {
+  pkt = alloc_lagopus_packet();
+  TEST_ASSERT_NOT_NULL_MESSAGE(pkt, "lagopus_alloc_packet error.");
+  m = PKT2MBUF(pkt);
+}
+
+void
+tearDown(void) {
+  lagopus_packet_free(pkt);
+}
+
+void
+test_flow_hash_ipv4(void) {
+  check_spread(0, 0, 0);
+}
+
+void
+test_flow_hash_ipv6(void) {
+  check_spread(0, 0, 1);
+}
+
+void
+test_flow_hash_vlan(void) {
+  check_spread(1, 0, 0);
+  check_spread(2, 0, 1);
+}
+
+void
+test_flow_hash_mpls(void) {
+  check_spread(0, 1, 0);
+  check_spread(0, 3, 1);
+  check_spread(1, 2, 0);
+}
+
+void
+test_flow_hash_ports(void) {
+  uint32_t hash;
+
+  /* port numbers are hashed. */
+  make_packet(0, 0, 0, 0);
+  hash = lagopus_packet_flow_hash(m, 1);
+  make_packet(0, 0, 0, 1);
+  TEST_ASSERT_NOT_EQUAL(lagopus_packet_flow_hash(m, 1), hash);
+
+  /* fragments are hashed by addresses only. */
+  make_packet(0, 0, 0, 0);
+  OS_MTOD(m, uint8_t *)[20] = 0x20; /* MF */
+  hash = lagopus_packet_flow_hash(m, 1);
+  make_packet(0, 0, 0, 1);
+  OS_MTOD(m, uint8_t *)[20] = 0x20;
+  TEST_ASSERT_EQUAL(lagopus_packet_flow_hash(m, 1), hash);
+}
+
+void
+test_flow_hash_non_ip(void) {
+  uint32_t hash;
+
+  /* ARP is hashed by ethernet header. */
+  make_packet(0, 0, 0, 0);
+  OS_MTOD(m, uint8_t *)[13] = 0x06;
+  hash = lagopus_packet_flow_hash(m, 1);
+  make_packet(0, 0, 0, 5);
+  OS_MTOD(m, uint8_t *)[13] = 0x06;
+  TEST_ASSERT_EQUAL(lagopus_packet_flow_hash(m, 1), hash);
+
+  /* truncated packet. */
+  OS_M_TRIM(m, OS_M_PKTLEN(m) - 10);
+  TEST_ASSERT_EQUAL(lagopus_packet_flow_hash(m, 1), 1);
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+
+#include "lagopus_apis.h"
+#include "lagopus/flowdb.h"
+#include "lagopus/port.h"
+#include "pktbuf.h"
+#include "packet.h"
+#include "lagopus/dataplane.h"
+#include "lagopus/flowinfo.h"
+#include "datapath_test_misc.h"
+
+#define IPADDR(a,b,c,d) (((a)<<24)|((b)<<16)|((c)<<8)|(d))
+#define NFLOWS 8
+
+static struct flowinfo *flowinfo;
+static struct flow *flows[NFLOWS];
+static struct lagopus_packet *pkt;
+static struct port port;
+
+static struct flow *
+ipv4_dst_flow(int i, uint16_t priority, uint32_t dst, uint32_t mask) {
+  struct flow *flow;
+
+  flow = calloc(1, sizeof(struct flow) + 10 * sizeof(struct match));
+  TEST_ASSERT_NOT_NULL(flow);
+  TAILQ_INIT(&flow->match_list);
+  flow->priority = priority;
+  add_match(&flow->match_list, 2, OFPXMT_OFB_ETH_TYPE << 1, 0x08, 0x00);
+  add_match(&flow->match_list, 8, (OFPXMT_OFB_IPV4_DST << 1) + 1,
+            (dst >> 24) & 0xff, (dst >> 16) & 0xff,
+            (dst >> 8) & 0xff, dst & 0xff,
+            (mask >> 24) & 0xff, (mask >> 16) & 0xff,
+            (mask >> 8) & 0xff, mask & 0xff);
+  refresh_match(flow);
+  TEST_ASSERT_EQUAL(flowinfo->add_func(flowinfo, flow), LAGOPUS_RESULT_OK);
+  flows[i] = flow;
+  return flow;
+}
+
+static struct flow *
+match_dst(uint32_t dst) {
+  uint8_t *p;
+  int32_t pri;
+
+  p = OS_MTOD(PKT2MBUF(pkt), uint8_t *);
+  p[30] = (dst >> 24) & 0xff;
+  p[31] = (dst >> 16) & 0xff;
+  p[32] = (dst >> 8) & 0xff;
+  p[33] = dst & 0xff;
+  lagopus_packet_init(pkt, PKT2MBUF(pkt), &port);
+  pri = -1;
+  return flowinfo->match_func(flowinfo, pkt, &pri);
+}
+
+void
+setUp(void) {
+  uint8_t *p;
+
+  flowinfo = new_flowinfo_ipv4_dst_mask();
+  TEST_ASSERT_NOT_NULL(flowinfo);
+  pkt = alloc_lagopus_packet();
+  TEST_ASSERT_NOT_NULL(pkt);
+  OS_M_APPEND(PKT2MBUF(pkt), 64);
+  p = OS_MTOD(PKT2MBUF(pkt), uint8_t *);
+  p[12] = 0x08;
+  p[13] = 0x00;
+  p[14] = 0x45;
+}
+
+void
+tearDown(void) {
+  int i;
+
+  flowinfo->destroy_func(flowinfo);
+  flowinfo = NULL;
+  for (i = 0; i < NFLOWS; i++) {
+    free(flows[i]);
+    flows[i] = NULL;
+  }
+  lagopus_packet_free(pkt);
+}
+
+void
+test_flowinfo_ipv4_dst_prefix_match(void) {
+  struct flow *f0, *f8, *f16, *f24, *f32;
+
+  f0 = ipv4_dst_flow(0, 1, 0, 0);
+  f8 = ipv4_dst_flow(1, 10, IPADDR(10,0,0,0), IPADDR(255,0,0,0));
+  f16 = ipv4_dst_flow(2, 20, IPADDR(10,1,0,0), IPADDR(255,255,0,0));
+  f24 = ipv4_dst_flow(3, 5, IPADDR(10,1,2,0), IPADDR(255,255,255,0));
+  f32 = ipv4_dst_flow(4, 30, IPADDR(10,1,2,3), IPADDR(255,255,255,255));
+  TEST_ASSERT_EQUAL(flowinfo->nflow, 5);
+
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,3)), f32);
+  /* higher priority wins over longer prefix. */
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,4)), f16);
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,2,0,1)), f8);
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(11,0,0,1)), f0);
+
+  TEST_ASSERT_EQUAL_PTR(flowinfo->find_func(flowinfo, f24), f24);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f32), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_NULL(flowinfo->find_func(flowinfo, f32));
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,3)), f16);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f16), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,3)), f8);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f8), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,3)), f24);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f16),
+                    LAGOPUS_RESULT_NOT_FOUND);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f24), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f0), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(flowinfo->nflow, 0);
+  TEST_ASSERT_NULL(match_dst(IPADDR(10,1,2,3)));
+}
+
+void
+test_flowinfo_ipv4_dst_noncontiguous_match(void) {
+  struct flow *f8, *fnc;
+
+  f8 = ipv4_dst_flow(0, 10, IPADDR(10,0,0,0), IPADDR(255,0,0,0));
+  fnc = ipv4_dst_flow(1, 20, IPADDR(10,0,0,1), IPADDR(255,0,0,255));
+  TEST_ASSERT_EQUAL(flowinfo->nnext, 1);
+
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,1)), fnc);
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,2)), f8);
+  TEST_ASSERT_EQUAL_PTR(flowinfo->find_func(flowinfo, fnc), fnc);
+
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, fnc), LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(flowinfo->nnext, 0);
+  TEST_ASSERT_EQUAL_PTR(match_dst(IPADDR(10,1,2,1)), f8);
+  TEST_ASSERT_EQUAL(flowinfo->del_func(flowinfo, f8), LAGOPUS_RESULT_OK);
+}
@@ -53,6 +53,9 @@
 #define MINIMUM_MACTABLE_MAX_ENTRIES 10      /* TODO: */
 #define MAXIMUM_MACTABLE_MAX_ENTRIES 65535   /* TODO: */
 #define DEFAULT_MACTABLE_MAX_ENTRIES 8192
+
+#define MAXIMUM_MACTABLE_VLAN_MAX_ENTRIES MAXIMUM_MACTABLE_MAX_ENTRIES
+#define DEFAULT_MACTABLE_VLAN_MAX_ENTRIES 0  /* no limit. */
 #endif /* HYBRID */
 
 /* bridge attributes. */
@@ -87,6 +90,7 @@ typedef struct bridge_attr {
   bool l2_bridge;
   uint32_t mactable_ageing_time;
   uint32_t mactable_max_entries;
+  uint32_t mactable_vlan_max_entries;
   bridge_mactable_info_t *mactable_entries;
 #endif /* HYBRID */
 } bridge_attr_t;
@@ -526,6 +530,7 @@ bridge_attr_create(bridge_attr_t **attr) {
   (*attr)->l2_bridge = false;
   (*attr)->mactable_ageing_time = DEFAULT_MACTABLE_AGEING_TIME;
   (*attr)->mactable_max_entries = DEFAULT_MACTABLE_MAX_ENTRIES;
+  (*attr)->mactable_vlan_max_entries = DEFAULT_MACTABLE_VLAN_MAX_ENTRIES;
 #endif /* HYBRID */
 
   return LAGOPUS_RESULT_OK;
@@ -617,6 +622,8 @@ bridge_attr_duplicate(const bridge_attr_t *src_attr,
   (*dst_attr)->l2_bridge = src_attr->l2_bridge;
   (*dst_attr)->mactable_ageing_time = src_attr->mactable_ageing_time;
   (*dst_attr)->mactable_max_entries = src_attr->mactable_max_entries;
+  (*dst_attr)->mactable_vlan_max_entries =
+    src_attr->mactable_vlan_max_entries;
 #endif /* HYBRID */
 
   return LAGOPUS_RESULT_OK;
@@ -686,6 +693,8 @@ bridge_attr_equals(bridge_attr_t *attr0, bridge_attr_t *attr1) {
                               attr1->mactable_entries) == true) &&
       (attr0->mactable_ageing_time == attr1->mactable_ageing_time) &&
       (attr0->mactable_max_entries == attr1->mactable_max_entries) &&
+      (attr0->mactable_vlan_max_entries ==
+       attr1->mactable_vlan_max_entries) &&
 #endif /* HYBRID */
       (attr0->up_streamq_size == attr1->up_streamq_size) &&
       (attr0->up_streamq_max_batches == attr1->up_streamq_max_batches) &&
@@ -733,6 +742,8 @@ bridge_attr_equals_without_names(bridge_attr_t *attr0, bridge_attr_t *attr1) {
                               attr1->mactable_entries) == true) &&
       (attr0->mactable_ageing_time == attr1->mactable_ageing_time) &&
       (attr0->mactable_max_entries == attr1->mactable_max_entries) &&
+      (attr0->mactable_vlan_max_entries ==
+       attr1->mactable_vlan_max_entries) &&
 #endif /* HYBRID */
       (attr0->up_streamq_size == attr1->up_streamq_size) &&
       (attr0->up_streamq_max_batches == attr1->up_streamq_max_batches) &&
@@ -780,6 +791,8 @@ bridge_attr_equals_without_qmax_batches(bridge_attr_t *attr0, bridge_attr_t *att
                               attr1->mactable_entries) == true) &&
       (attr0->mactable_ageing_time == attr1->mactable_ageing_time) &&
       (attr0->mactable_max_entries == attr1->mactable_max_entries) &&
+      (attr0->mactable_vlan_max_entries ==
+       attr1->mactable_vlan_max_entries) &&
 #endif /* HYBRID */
       (attr0->up_streamq_size == attr1->up_streamq_size) &&
       (attr0->down_streamq_size == attr1->down_streamq_size)
@@ -1640,6 +1653,19 @@ bridge_get_mactable_max_entries(const bridge_attr_t *attr,
   return LAGOPUS_RESULT_INVALID_ARGS;
 }
 
+/**
+ * Get number of max entries per VLAN of mac table.
+ */
+static inline lagopus_result_t
+bridge_get_mactable_vlan_max_entries(const bridge_attr_t *attr,
+                     uint32_t *mactable_vlan_max_entries) {
+  if (attr != NULL && mactable_vlan_max_entries != NULL) {
+    *mactable_vlan_max_entries = attr->mactable_vlan_max_entries;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
 /**
  * Set l2-bridge flag.
  */
@@ -1699,6 +1725,23 @@ bridge_set_mactable_max_entries(bridge_attr_t *attr,
   return LAGOPUS_RESULT_INVALID_ARGS;
 }
 
+/**
+ * Set number of max entries per VLAN of mac table (0 means no limit).
+ */
+static inline lagopus_result_t
+bridge_set_mactable_vlan_max_entries(bridge_attr_t *attr,
+                     const uint64_t mactable_vlan_max_entries) {
+  if (attr != NULL) {
+    if (mactable_vlan_max_entries <= MAXIMUM_MACTABLE_VLAN_MAX_ENTRIES) {
+      attr->mactable_vlan_max_entries = (uint32_t) mactable_vlan_max_entries;
+      return LAGOPUS_RESULT_OK;
+    } else {
+      return LAGOPUS_RESULT_TOO_LONG;
+    }
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
 /**
  * Get ageing time of mac table.
  */
@@ -1738,6 +1781,27 @@ datastore_bridge_get_mactable_max_entries(const char *name, bool current,
   }
   return rc;
 }
+
+/**
+ * Get number of max entries per VLAN of mac table.
+ */
+lagopus_result_t
+datastore_bridge_get_mactable_vlan_max_entries(const char *name, bool current,
+                               uint32_t *mactable_vlan_max_entries) {
+  lagopus_result_t rc;
+  bridge_attr_t *attr = NULL;
+
+  if (IS_VALID_STRING(name) == true && mactable_vlan_max_entries != NULL) {
+    rc = bridge_get_attr(name, current, &attr);
+    if (rc == LAGOPUS_RESULT_OK) {
+      rc = bridge_get_mactable_vlan_max_entries(attr,
+                                                mactable_vlan_max_entries);
+    }
+  } else {
+    rc = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return rc;
+}
 #endif /* HYBRID */
 
 
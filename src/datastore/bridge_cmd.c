@@ -92,6 +92,7 @@ enum bridge_opts {
   OPT_L2_BRIDGE,
   OPT_MACTABLE_AGEING_TIME,
   OPT_MACTABLE_MAX_ENTRIES,
+  OPT_MACTABLE_VLAN_MAX_ENTRIES,
   OPT_MACTABLE_ENTRY,
 
   OPT_MAX,
@@ -167,6 +168,7 @@ static const char *const opt_strs[OPT_MAX] = {
   "-l2-bridge",                /* OPT_L2_BRIDGE*/
   "-mactable-ageing-time",     /* OPT_MACTABLE_AGEING_TIME */
   "-mactable-max-entries",     /* OPT_MACTABLE_MAX_ENTRIES*/
+  "-mactable-vlan-max-entries", /* OPT_MACTABLE_VLAN_MAX_ENTRIES */
   "-mactable-entry",           /* OPT_MACTABLE_ENTRY */
 #endif /* HYBRID */
 };
@@ -484,6 +486,7 @@ bri_bridge_create(const char *name,
   bool l2_bridge;
   uint32_t mactable_ageing_time;
   uint32_t mactable_max_entries;
+  uint32_t mactable_vlan_max_entries;
 #endif /* HYBRID */
   /* get items. */
   if (((ret = bridge_get_dpid(attr, &dpid)) ==
@@ -555,6 +558,9 @@ bri_bridge_create(const char *name,
       ((ret = bridge_get_mactable_max_entries(attr,
                                               &mactable_max_entries)) ==
        LAGOPUS_RESULT_OK) &&
+      ((ret = bridge_get_mactable_vlan_max_entries(
+          attr, &mactable_vlan_max_entries)) ==
+       LAGOPUS_RESULT_OK) &&
 #endif /* HYBRID */
       ((ret = bridge_get_up_streamq_size(attr,
                                          &up_streamq_size)) ==
@@ -592,6 +598,7 @@ bri_bridge_create(const char *name,
     info.l2_bridge = l2_bridge;
     info.mactable_ageing_time = mactable_ageing_time;
     info.mactable_max_entries = mactable_max_entries;
+    info.mactable_vlan_max_entries = mactable_vlan_max_entries;
 #endif /* HYBRID */
 
     q_info.packet_inq_size = packet_inq_size;
@@ -3935,6 +3942,22 @@ mactable_max_entries_opt_parse(const char *const *argv[],
                         result);
 }
 
+/**
+ * Parse vlan-max-entries option.
+ */
+static lagopus_result_t
+mactable_vlan_max_entries_opt_parse(const char *const *argv[],
+                    void *c, void *out_configs,
+                    lagopus_dstring_t *result) {
+  return uint_opt_parse(argv,
+                        (bridge_conf_t *)c,
+                        (configs_t *) out_configs,
+                        &bridge_set_mactable_vlan_max_entries,
+                        OPT_MACTABLE_VLAN_MAX_ENTRIES,
+                        CMD_UINT64,
+                        result);
+}
+
 /**
  * Parse mac entry options.
  */
@@ -5070,6 +5093,7 @@ bridge_cmd_json_create(lagopus_dstring_t *ds,
   bool l2_bridge;
   uint32_t mactable_ageing_time;
   uint32_t mactable_max_entries;
+  uint32_t mactable_vlan_max_entries;
 #endif /* HYBRID */
   uint16_t packet_inq_size;
   uint16_t packet_inq_max_batches;
@@ -5478,6 +5502,29 @@ bridge_cmd_json_create(lagopus_dstring_t *ds,
               goto done;
             }
           }
+
+          /* mactable-vlan-max-entries opt */
+          if (IS_BIT_SET(configs->flags,
+                         OPT_BIT_GET(OPT_MACTABLE_VLAN_MAX_ENTRIES)) == true) {
+            if ((ret =
+                   bridge_get_mactable_vlan_max_entries(
+                     attr, &mactable_vlan_max_entries)) ==
+                 LAGOPUS_RESULT_OK) {
+              if ((ret = datastore_json_uint64_append(
+                           ds,
+                           ATTR_NAME_GET(opt_strs,
+                                         OPT_MACTABLE_VLAN_MAX_ENTRIES),
+                           mactable_vlan_max_entries,
+                           true)) !=
+                  LAGOPUS_RESULT_OK) {
+                lagopus_perror(ret);
+                goto done;
+              }
+            } else {
+              lagopus_perror(ret);
+              goto done;
+            }
+          }
 #endif /* HYBRID */
 
           /* packet-inq size */
@@ -6248,6 +6295,7 @@ bridge_cmd_serialize(datastore_interp_t *iptr,
   bool l2_bridge = false;
   uint32_t mactable_ageing_time = 0; /* mactable ageing time. */
   uint32_t mactable_max_entries = 0; /* mactable max entries. */
+  uint32_t mactable_vlan_max_entries = 0; /* mactable max entries per VLAN. */
   bridge_mactable_info_t *mactable_entries = NULL;
   struct mactable_entry_head *me_head = NULL;
   struct bridge_mactable_entry *me_entry = NULL;
@@ -6794,6 +6842,28 @@ bridge_cmd_serialize(datastore_interp_t *iptr,
       goto done;
     }
 
+    /* mactable-vlan-max-entries opt */
+    if ((ret = bridge_get_mactable_vlan_max_entries(
+           conf->current_attr, &mactable_vlan_max_entries)) ==
+         LAGOPUS_RESULT_OK) {
+      if ((ret = lagopus_dstring_appendf(
+             result, " %s", opt_strs[OPT_MACTABLE_VLAN_MAX_ENTRIES]))
+          == LAGOPUS_RESULT_OK) {
+        if ((ret = lagopus_dstring_appendf(result, " %"PRIu32,
+                                           mactable_vlan_max_entries)) !=
+            LAGOPUS_RESULT_OK) {
+          lagopus_perror(ret);
+          goto done;
+        }
+      } else {
+        lagopus_perror(ret);
+        goto done;
+      }
+    } else {
+      lagopus_perror(ret);
+      goto done;
+    }
+
     /* mactable-entry opt */
     if ((ret = bridge_get_mactable_entry(conf->current_attr,
                                          &mactable_entries)) ==
@@ -7368,6 +7438,10 @@ initialize_internal(void) {
                       mactable_max_entries_opt_parse,
                       &opt_table)) !=
        LAGOPUS_RESULT_OK) ||
+      ((ret = opt_add(opt_strs[OPT_MACTABLE_VLAN_MAX_ENTRIES],
+                      mactable_vlan_max_entries_opt_parse,
+                      &opt_table)) !=
+       LAGOPUS_RESULT_OK) ||
       ((ret = opt_add(opt_strs[OPT_MACTABLE_ENTRY],
                       mactable_entry_opt_parse,
                       &opt_table)) !=
@@ -2804,15 +2804,52 @@ done:
   return ret;
 }
 
+typedef struct dump_flow_arg {
+  bool is_with_stats;
+  bool *is_flow_first;
+  lagopus_dstring_t *result;
+} dump_flow_arg_t;
+
+static lagopus_result_t
+dump_flow_proc(struct flow *flow, void *arg) {
+  dump_flow_arg_t *da = (dump_flow_arg_t *) arg;
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if ((ret = dump_flow(flow, da->is_with_stats,
+                       da->is_flow_first, da->result)) ==
+      LAGOPUS_RESULT_OK) {
+    *da->is_flow_first = false;
+  }
+
+  return ret;
+}
+
+/* Write out the result and start over, if fp is given. */
+static inline lagopus_result_t
+dump_flush(FILE *fp, lagopus_dstring_t *result) {
+  lagopus_result_t ret = LAGOPUS_RESULT_OK;
+
+  if (fp != NULL) {
+    if ((ret = cmd_dump_file_write(fp, result)) ==
+        LAGOPUS_RESULT_OK) {
+      (void) lagopus_dstring_clear(result);
+    }
+  }
+
+  return ret;
+}
+
 static inline lagopus_result_t
 dump_flow_list(const char *name,
                uint8_t table_id,
                bool is_with_stats,
                bool *is_flow_first,
+               FILE *fp,
                lagopus_dstring_t *result) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  lagopus_result_t walk_ret;
   dp_bridge_iter_t iter = NULL;
-  struct flow *flow = NULL;;
+  dump_flow_arg_t da;
 
   if ((ret = dp_bridge_flow_iter_create(name,
                                         table_id,
@@ -2822,30 +2859,24 @@ dump_flow_list(const char *name,
     goto done;
   }
 
-  for (;;) {
-    if ((ret = dp_bridge_flow_iter_get(iter, &flow)) !=
-        LAGOPUS_RESULT_OK) {
-      if (ret == LAGOPUS_RESULT_EOF) {
-        /* ignore eof. */
-        ret = LAGOPUS_RESULT_OK;
-        break;
-      } else {
-        lagopus_perror(ret);
-        goto done;
-      }
-    }
+  da.is_with_stats = is_with_stats;
+  da.is_flow_first = is_flow_first;
+  da.result = result;
 
-    if ((ret = dump_flow(flow, is_with_stats,
-                         is_flow_first, result)) !=
-        LAGOPUS_RESULT_OK) {
+  /* Format a chunk under the flowdb lock, write it after the lock. */
+  do {
+    walk_ret = dp_bridge_flow_iter_walk(iter, dump_flow_proc, &da);
+    if (walk_ret != LAGOPUS_RESULT_OK &&
+        walk_ret != LAGOPUS_RESULT_EOF) {
+      ret = walk_ret;
       lagopus_perror(ret);
       goto done;
     }
-    if (*is_flow_first == true) {
-      *is_flow_first = false;
+    if ((ret = dump_flush(fp, result)) != LAGOPUS_RESULT_OK) {
+      lagopus_perror(ret);
+      goto done;
     }
-    flow = NULL;
-  }
+  } while (walk_ret == LAGOPUS_RESULT_OK);
 
 done:
   if (iter != NULL) {
@@ -2860,6 +2891,7 @@ dump_table_flows(const char *name,
                  uint8_t table_id,
                  bool is_with_stats,
                  bool is_table_first,
+                 FILE *fp,
                  lagopus_dstring_t *result) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
   bool is_flow_first = true;
@@ -2889,7 +2921,8 @@ dump_table_flows(const char *name,
   }
 
   if ((ret = dump_flow_list(name, table_id,
-                            is_with_stats, &is_flow_first, result)) !=
+                            is_with_stats, &is_flow_first,
+                            fp, result)) !=
       LAGOPUS_RESULT_OK) {
     lagopus_perror(ret);
     goto done;
@@ -2918,6 +2951,7 @@ dump_bridge_domains_flow(const char *name,
                          uint8_t table_id,
                          bool is_with_stats,
                          bool is_bridge_first,
+                         FILE *fp,
                          lagopus_dstring_t *result) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
   uint8_t tid;
@@ -2970,7 +3004,7 @@ dump_bridge_domains_flow(const char *name,
       }
 
       if ((ret = dump_table_flows(name, tid, is_with_stats,
-                                  is_table_first, result)) !=
+                                  is_table_first, fp, result)) !=
           LAGOPUS_RESULT_OK) {
         lagopus_perror(ret);
         goto done;
@@ -2982,7 +3016,7 @@ dump_bridge_domains_flow(const char *name,
   } else {
     /* dump a table. */
     if ((ret = dump_table_flows(name, table_id, is_with_stats,
-                                is_table_first, result)) !=
+                                is_table_first, fp, result)) !=
         LAGOPUS_RESULT_OK) {
       lagopus_perror(ret);
       goto done;
@@ -3055,7 +3089,7 @@ flow_cmd_dump(datastore_interp_t *iptr,
                                             conf->table_id,
                                             is_with_stats,
                                             is_bridge_first,
-                                            result)) !=
+                                            fp, result)) !=
             LAGOPUS_RESULT_OK) {
           ret = datastore_json_result_string_setf(
               result, ret,
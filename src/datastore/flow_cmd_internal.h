@@ -57,6 +57,8 @@ flow_cmd_parse(datastore_interp_t *iptr,
  *     @paran[in]	table_id	Table id.
  *     @param[in]	is_with_stats	Dump with stats.
  *     @param[in]	is_bridge_first	A first element flag for bridges.
+ *     @param[in]	fp	A file the result is written to chunk by chunk,
+ *     			or NULL to keep all of it in result.
  *     @param[out]	result	A result/output string (NULL allowed).
  *
  *     @retval	LAGOPUS_RESULT_OK	Succeeded.
@@ -69,6 +71,7 @@ dump_bridge_domains_flow(const char *name,
                          uint8_t table_id,
                          bool is_with_stats,
                          bool is_bridge_first,
+                         FILE *fp,
                          lagopus_dstring_t *result);
 
 #endif /* __FLOW_CMD_INTERNAL_H__ */
@@ -48,6 +48,10 @@ typedef struct interface_attr {
   mac_address_t src_hw_addr;
   uint16_t mtu;
   lagopus_ip_address_t *ip_addr;
+  datastore_interface_bonding_mode_t bonding_mode;
+  datastore_interface_xmit_hash_policy_t xmit_hash_policy;
+  datastore_interface_lacp_rate_t lacp_rate;
+  datastore_name_info_t *slave_names;
 } interface_attr_t;
 
 typedef struct interface_conf {
@@ -74,7 +78,39 @@ static const interface_type_t types[] = {
   {DATASTORE_INTERFACE_TYPE_GRE, "gre"},
   {DATASTORE_INTERFACE_TYPE_NVGRE, "nvgre"},
   {DATASTORE_INTERFACE_TYPE_VXLAN, "vxlan"},
-  {DATASTORE_INTERFACE_TYPE_VHOST_USER, "vhost-user"}
+  {DATASTORE_INTERFACE_TYPE_VHOST_USER, "vhost-user"},
+  {DATASTORE_INTERFACE_TYPE_BONDING, "bonding"}
+};
+
+typedef struct interface_bonding_mode {
+  const datastore_interface_bonding_mode_t mode;
+  const char *mode_str;
+} interface_bonding_mode_t;
+
+static const interface_bonding_mode_t bonding_modes[] = {
+  {DATASTORE_INTERFACE_BONDING_MODE_BALANCE_XOR, "balance-xor"},
+  {DATASTORE_INTERFACE_BONDING_MODE_8023AD, "802.3ad"}
+};
+
+typedef struct interface_xmit_hash_policy {
+  const datastore_interface_xmit_hash_policy_t policy;
+  const char *policy_str;
+} interface_xmit_hash_policy_t;
+
+static const interface_xmit_hash_policy_t xmit_hash_policies[] = {
+  {DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER2, "layer2"},
+  {DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER3, "layer3"},
+  {DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER34, "layer3+4"}
+};
+
+typedef struct interface_lacp_rate {
+  const datastore_interface_lacp_rate_t rate;
+  const char *rate_str;
+} interface_lacp_rate_t;
+
+static const interface_lacp_rate_t lacp_rates[] = {
+  {DATASTORE_INTERFACE_LACP_RATE_SLOW, "slow"},
+  {DATASTORE_INTERFACE_LACP_RATE_FAST, "fast"}
 };
 
 static lagopus_hashmap_t interface_table = NULL;
@@ -86,6 +122,7 @@ interface_attr_destroy(interface_attr_t *attr) {
     lagopus_ip_address_destroy(attr->mcast_group);
     lagopus_ip_address_destroy(attr->src_addr);
     lagopus_ip_address_destroy(attr->ip_addr);
+    datastore_names_destroy(attr->slave_names);
     free((void *) attr);
   }
 }
@@ -154,6 +191,14 @@ interface_attr_create(interface_attr_t **attr) {
     goto error;
   }
   (*attr)->ip_addr = ip_addr;
+  (*attr)->bonding_mode = DATASTORE_INTERFACE_BONDING_MODE_BALANCE_XOR;
+  (*attr)->xmit_hash_policy = DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER2;
+  (*attr)->lacp_rate = DATASTORE_INTERFACE_LACP_RATE_SLOW;
+  (*attr)->slave_names = NULL;
+  rc = datastore_names_create(&((*attr)->slave_names));
+  if (rc != LAGOPUS_RESULT_OK) {
+    goto error;
+  }
 
   return LAGOPUS_RESULT_OK;
 
@@ -236,6 +281,14 @@ interface_attr_duplicate(const interface_attr_t *src_attr,
   if (rc != LAGOPUS_RESULT_OK) {
     goto error;
   }
+  (*dst_attr)->bonding_mode = src_attr->bonding_mode;
+  (*dst_attr)->xmit_hash_policy = src_attr->xmit_hash_policy;
+  (*dst_attr)->lacp_rate = src_attr->lacp_rate;
+  rc = datastore_names_duplicate(src_attr->slave_names,
+                                 &((*dst_attr)->slave_names), namespace);
+  if (rc != LAGOPUS_RESULT_OK) {
+    goto error;
+  }
 
   return LAGOPUS_RESULT_OK;
 
@@ -271,7 +324,12 @@ interface_attr_equals(const interface_attr_t *attr0,
       (equals_mac_address(attr0->src_hw_addr, attr1->src_hw_addr) == true) &&
       (attr0->mtu == attr1->mtu) &&
       (lagopus_ip_address_equals(attr0->ip_addr,
-                                 attr1->ip_addr) == true)) {
+                                 attr1->ip_addr) == true) &&
+      (attr0->bonding_mode == attr1->bonding_mode) &&
+      (attr0->xmit_hash_policy == attr1->xmit_hash_policy) &&
+      (attr0->lacp_rate == attr1->lacp_rate) &&
+      (datastore_names_equals(attr0->slave_names,
+                              attr1->slave_names) == true)) {
     return true;
   }
 
@@ -640,6 +698,107 @@ interface_type_to_enum(const char *type_str,
   return LAGOPUS_RESULT_INVALID_ARGS;
 }
 
+static inline lagopus_result_t
+interface_bonding_mode_to_str(const datastore_interface_bonding_mode_t mode,
+                              const char **mode_str) {
+  if (mode_str == NULL ||
+      (int) mode < DATASTORE_INTERFACE_BONDING_MODE_MIN ||
+      (int) mode > DATASTORE_INTERFACE_BONDING_MODE_MAX) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  *mode_str = bonding_modes[mode].mode_str;
+  return LAGOPUS_RESULT_OK;
+}
+
+static inline lagopus_result_t
+interface_bonding_mode_to_enum(const char *mode_str,
+                               datastore_interface_bonding_mode_t *mode) {
+  size_t i = 0;
+
+  if (IS_VALID_STRING(mode_str) != true || mode == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  for (i = DATASTORE_INTERFACE_BONDING_MODE_MIN;
+       i <= DATASTORE_INTERFACE_BONDING_MODE_MAX; i++) {
+    if (strcmp(mode_str, bonding_modes[i].mode_str) == 0) {
+      *mode = bonding_modes[i].mode;
+      return LAGOPUS_RESULT_OK;
+    }
+  }
+
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_xmit_hash_policy_to_str(
+    const datastore_interface_xmit_hash_policy_t policy,
+    const char **policy_str) {
+  if (policy_str == NULL ||
+      (int) policy < DATASTORE_INTERFACE_XMIT_HASH_POLICY_MIN ||
+      (int) policy > DATASTORE_INTERFACE_XMIT_HASH_POLICY_MAX) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  *policy_str = xmit_hash_policies[policy].policy_str;
+  return LAGOPUS_RESULT_OK;
+}
+
+static inline lagopus_result_t
+interface_xmit_hash_policy_to_enum(
+    const char *policy_str,
+    datastore_interface_xmit_hash_policy_t *policy) {
+  size_t i = 0;
+
+  if (IS_VALID_STRING(policy_str) != true || policy == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  for (i = DATASTORE_INTERFACE_XMIT_HASH_POLICY_MIN;
+       i <= DATASTORE_INTERFACE_XMIT_HASH_POLICY_MAX; i++) {
+    if (strcmp(policy_str, xmit_hash_policies[i].policy_str) == 0) {
+      *policy = xmit_hash_policies[i].policy;
+      return LAGOPUS_RESULT_OK;
+    }
+  }
+
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_lacp_rate_to_str(const datastore_interface_lacp_rate_t lacp_rate,
+                           const char **lacp_rate_str) {
+  if (lacp_rate_str == NULL ||
+      (int) lacp_rate < DATASTORE_INTERFACE_LACP_RATE_MIN ||
+      (int) lacp_rate > DATASTORE_INTERFACE_LACP_RATE_MAX) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  *lacp_rate_str = lacp_rates[lacp_rate].rate_str;
+  return LAGOPUS_RESULT_OK;
+}
+
+static inline lagopus_result_t
+interface_lacp_rate_to_enum(const char *lacp_rate_str,
+                            datastore_interface_lacp_rate_t *lacp_rate) {
+  size_t i = 0;
+
+  if (IS_VALID_STRING(lacp_rate_str) != true || lacp_rate == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  for (i = DATASTORE_INTERFACE_LACP_RATE_MIN;
+       i <= DATASTORE_INTERFACE_LACP_RATE_MAX; i++) {
+    if (strcmp(lacp_rate_str, lacp_rates[i].rate_str) == 0) {
+      *lacp_rate = lacp_rates[i].rate;
+      return LAGOPUS_RESULT_OK;
+    }
+  }
+
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
 static inline lagopus_result_t
 interface_find(const char *name, interface_conf_t **conf) {
   if (interface_table == NULL) {
@@ -890,6 +1049,46 @@ interface_get_ip_addr_str(const interface_attr_t *attr, char **ip_addr) {
   return ret;
 }
 
+static inline lagopus_result_t
+interface_get_bonding_mode(const interface_attr_t *attr,
+                           datastore_interface_bonding_mode_t *mode) {
+  if (attr != NULL && mode != NULL) {
+    *mode = attr->bonding_mode;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_get_xmit_hash_policy(const interface_attr_t *attr,
+                               datastore_interface_xmit_hash_policy_t *policy) {
+  if (attr != NULL && policy != NULL) {
+    *policy = attr->xmit_hash_policy;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_get_lacp_rate(const interface_attr_t *attr,
+                        datastore_interface_lacp_rate_t *lacp_rate) {
+  if (attr != NULL && lacp_rate != NULL) {
+    *lacp_rate = attr->lacp_rate;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_get_slave_names(const interface_attr_t *attr,
+                          datastore_name_info_t **slave_names) {
+  if (attr != NULL && slave_names != NULL) {
+    return datastore_names_duplicate(attr->slave_names,
+                                     slave_names, NULL);
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
 static inline lagopus_result_t
 interface_set_port_number(interface_attr_t *attr, const uint64_t port_number) {
   if (attr != NULL) {
@@ -1140,6 +1339,64 @@ interface_set_ip_addr_str(interface_attr_t *attr,
   return LAGOPUS_RESULT_INVALID_ARGS;
 }
 
+static inline lagopus_result_t
+interface_set_bonding_mode(interface_attr_t *attr,
+                           const datastore_interface_bonding_mode_t mode) {
+  if (attr != NULL) {
+    attr->bonding_mode = mode;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_set_xmit_hash_policy(
+    interface_attr_t *attr,
+    const datastore_interface_xmit_hash_policy_t policy) {
+  if (attr != NULL) {
+    attr->xmit_hash_policy = policy;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline lagopus_result_t
+interface_set_lacp_rate(interface_attr_t *attr,
+                        const datastore_interface_lacp_rate_t lacp_rate) {
+  if (attr != NULL) {
+    attr->lacp_rate = lacp_rate;
+    return LAGOPUS_RESULT_OK;
+  }
+  return LAGOPUS_RESULT_INVALID_ARGS;
+}
+
+static inline bool
+interface_attr_slave_name_exists(const interface_attr_t *attr,
+                                 const char *name) {
+  if (attr == NULL || name == NULL) {
+    return false;
+  }
+  return datastore_name_exists(attr->slave_names, name);
+}
+
+static inline lagopus_result_t
+interface_attr_add_slave_name(const interface_attr_t *attr,
+                              const char *name) {
+  if (attr == NULL || name == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return datastore_add_names(attr->slave_names, name);
+}
+
+static inline lagopus_result_t
+interface_attr_remove_slave_name(const interface_attr_t *attr,
+                                 const char *name) {
+  if (attr == NULL || name == NULL) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return datastore_remove_names(attr->slave_names, name);
+}
+
 static void
 interface_conf_freeup(void *conf) {
   interface_conf_destroy((interface_conf_t *) conf);
@@ -1559,3 +1816,73 @@ datastore_interface_get_ip_addr_str(const char *name, bool current,
   }
   return rc;
 }
+
+lagopus_result_t
+datastore_interface_get_bonding_mode(
+    const char *name, bool current,
+    datastore_interface_bonding_mode_t *bonding_mode) {
+  lagopus_result_t rc;
+  interface_attr_t *attr = NULL;
+
+  if (IS_VALID_STRING(name) == true && bonding_mode != NULL) {
+    rc = interface_get_attr(name, current, &attr);
+    if (rc == LAGOPUS_RESULT_OK) {
+      rc = interface_get_bonding_mode(attr, bonding_mode);
+    }
+  } else {
+    rc = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return rc;
+}
+
+lagopus_result_t
+datastore_interface_get_xmit_hash_policy(
+    const char *name, bool current,
+    datastore_interface_xmit_hash_policy_t *xmit_hash_policy) {
+  lagopus_result_t rc;
+  interface_attr_t *attr = NULL;
+
+  if (IS_VALID_STRING(name) == true && xmit_hash_policy != NULL) {
+    rc = interface_get_attr(name, current, &attr);
+    if (rc == LAGOPUS_RESULT_OK) {
+      rc = interface_get_xmit_hash_policy(attr, xmit_hash_policy);
+    }
+  } else {
+    rc = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return rc;
+}
+
+lagopus_result_t
+datastore_interface_get_lacp_rate(const char *name, bool current,
+                                  datastore_interface_lacp_rate_t *lacp_rate) {
+  lagopus_result_t rc;
+  interface_attr_t *attr = NULL;
+
+  if (IS_VALID_STRING(name) == true && lacp_rate != NULL) {
+    rc = interface_get_attr(name, current, &attr);
+    if (rc == LAGOPUS_RESULT_OK) {
+      rc = interface_get_lacp_rate(attr, lacp_rate);
+    }
+  } else {
+    rc = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return rc;
+}
+
+lagopus_result_t
+datastore_interface_get_slave_names(const char *name, bool current,
+                                    datastore_name_info_t **slave_names) {
+  lagopus_result_t rc;
+  interface_attr_t *attr = NULL;
+
+  if (IS_VALID_STRING(name) == true && slave_names != NULL) {
+    rc = interface_get_attr(name, current, &attr);
+    if (rc == LAGOPUS_RESULT_OK) {
+      rc = interface_get_slave_names(attr, slave_names);
+    }
+  } else {
+    rc = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  return rc;
+}
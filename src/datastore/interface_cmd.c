@@ -45,6 +45,11 @@ enum interface_opts {
   OPT_SRC_HW_ADDR,
   OPT_MTU,
   OPT_IP_ADDR,
+  OPT_BONDING_MODE,
+  OPT_XMIT_HASH_POLICY,
+  OPT_LACP_RATE,
+  OPT_SLAVES,
+  OPT_SLAVE,
   OPT_CLEAR,
   OPT_IS_USED,
   OPT_IS_ENABLED,
@@ -107,6 +112,11 @@ enum interface_stats {
                            OPT_BIT_GET(OPT_SRC_HW_ADDR) |           \
                            OPT_BIT_GET(OPT_MTU) |                   \
                            OPT_BIT_GET(OPT_IP_ADDR))
+#define OPT_BONDING  (OPT_COMMON |                           \
+                      OPT_BIT_GET(OPT_BONDING_MODE) |         \
+                      OPT_BIT_GET(OPT_XMIT_HASH_POLICY) |     \
+                      OPT_BIT_GET(OPT_LACP_RATE) |            \
+                      OPT_BIT_GET(OPT_SLAVES))
 #define OPT_UNKNOWN  (OPT_COMMON)
 
 /* option name. */
@@ -126,6 +136,11 @@ static const char *const opt_strs[OPT_MAX] = {
   "-src-hw-addr",        /* OPT_SRC_HW_ADDR */
   "-mtu",                /* OPT_MTU */
   "-ip-addr",            /* OPT_IP_ADDR */
+  "-bonding-mode",       /* OPT_BONDING_MODE */
+  "-xmit-hash-policy",   /* OPT_XMIT_HASH_POLICY */
+  "-lacp-rate",          /* OPT_LACP_RATE */
+  "*slaves",             /* OPT_SLAVES (not option) */
+  "-slave",              /* OPT_SLAVE */
   "-clear",              /* OPT_CLEAR (stats option)*/
   "*is-used",            /* OPT_IS_USED (not option) */
   "*is-enabled",         /* OPT_IS_ENABLED (not option) */
@@ -174,6 +189,7 @@ static lagopus_hashmap_t gre_opt_table = NULL;
 static lagopus_hashmap_t nvgre_opt_table = NULL;
 static lagopus_hashmap_t vxlan_opt_table = NULL;
 static lagopus_hashmap_t vhost_user_opt_table = NULL;
+static lagopus_hashmap_t bonding_opt_table = NULL;
 static lagopus_hashmap_t stats_opt_table = NULL;
 
 static inline lagopus_result_t
@@ -292,6 +308,158 @@ ethernet_port_destroy(const char *name,
   return ret;
 }
 
+static inline lagopus_result_t
+bonding_slaves_used_set(interface_attr_t *attr, bool b) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_name_info_t *slave_names = NULL;
+  struct datastore_name_entry *slave = NULL;
+
+  if ((ret = interface_get_slave_names(attr, &slave_names)) ==
+      LAGOPUS_RESULT_OK) {
+    TAILQ_FOREACH(slave, &slave_names->head, name_entries) {
+      ret = interface_set_used(slave->str, b);
+      /* ignore : LAGOPUS_RESULT_NOT_FOUND */
+      if (ret != LAGOPUS_RESULT_OK && ret != LAGOPUS_RESULT_NOT_FOUND) {
+        break;
+      }
+      ret = LAGOPUS_RESULT_OK;
+    }
+  }
+
+  datastore_names_destroy(slave_names);
+
+  return ret;
+}
+
+static inline lagopus_result_t
+bonding_port_create(const char *name,
+                    interface_attr_t *attr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_interface_bonding_mode_t bonding_mode;
+  datastore_interface_xmit_hash_policy_t xmit_hash_policy;
+  datastore_interface_lacp_rate_t lacp_rate;
+  datastore_name_info_t *slave_names = NULL;
+  struct datastore_name_entry *slave = NULL;
+  enum dp_bonding_mode mode;
+  enum dp_bonding_xmit_hash xmit_hash;
+
+  if (((ret = interface_get_bonding_mode(attr, &bonding_mode)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = interface_get_xmit_hash_policy(attr, &xmit_hash_policy)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = interface_get_lacp_rate(attr, &lacp_rate)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = interface_get_slave_names(attr, &slave_names)) !=
+       LAGOPUS_RESULT_OK)) {
+    goto done;
+  }
+
+  switch (bonding_mode) {
+    case DATASTORE_INTERFACE_BONDING_MODE_BALANCE_XOR:
+      mode = DP_BONDING_MODE_BALANCE_XOR;
+      break;
+    case DATASTORE_INTERFACE_BONDING_MODE_8023AD:
+      mode = DP_BONDING_MODE_8023AD;
+      break;
+    default:
+      ret = LAGOPUS_RESULT_OUT_OF_RANGE;
+      goto done;
+  }
+  switch (xmit_hash_policy) {
+    case DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER2:
+      xmit_hash = DP_BONDING_XMIT_HASH_L2;
+      break;
+    case DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER3:
+      xmit_hash = DP_BONDING_XMIT_HASH_L3;
+      break;
+    case DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER34:
+      xmit_hash = DP_BONDING_XMIT_HASH_L34;
+      break;
+    default:
+      ret = LAGOPUS_RESULT_OUT_OF_RANGE;
+      goto done;
+  }
+
+  lagopus_msg_info("create bonding interface. name = %s.\n", name);
+  if ((ret = dp_interface_create(name)) != LAGOPUS_RESULT_OK) {
+    goto done;
+  }
+  if (((ret = dp_bonding_create(name, mode, xmit_hash)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = dp_bonding_lacp_rate_set(
+                name, lacp_rate == DATASTORE_INTERFACE_LACP_RATE_FAST)) !=
+       LAGOPUS_RESULT_OK)) {
+    goto destroy;
+  }
+  TAILQ_FOREACH(slave, &slave_names->head, name_entries) {
+    if ((ret = dp_bonding_slave_add(name, slave->str)) !=
+        LAGOPUS_RESULT_OK) {
+      lagopus_msg_warning("Can't add slave %s to %s.\n",
+                          slave->str, name);
+      goto destroy;
+    }
+  }
+  ret = bonding_slaves_used_set(attr, true);
+  goto done;
+
+destroy:
+  /* releases the slaves added so far with the bond. */
+  (void) dp_interface_destroy(name);
+
+done:
+  datastore_names_destroy(slave_names);
+
+  return ret;
+}
+
+static inline lagopus_result_t
+bonding_port_destroy(const char *name,
+                     interface_attr_t *attr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  lagopus_msg_info("destroy bonding interface. name = %s.\n", name);
+  if ((ret = bonding_slaves_used_set(attr, false)) ==
+      LAGOPUS_RESULT_OK) {
+    ret = dp_interface_destroy(name);
+  }
+
+  return ret;
+}
+
+static inline lagopus_result_t
+bonding_slaves_enable(datastore_interp_t *iptr,
+                      datastore_interp_state_t state,
+                      interface_attr_t *attr,
+                      bool enabled,
+                      lagopus_dstring_t *result) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_name_info_t *slave_names = NULL;
+  struct datastore_name_entry *slave = NULL;
+
+  if ((ret = interface_get_slave_names(attr, &slave_names)) ==
+      LAGOPUS_RESULT_OK) {
+    TAILQ_FOREACH(slave, &slave_names->head, name_entries) {
+      if (enabled == true) {
+        ret = interface_cmd_enable_propagation(iptr, state,
+                                               slave->str, result);
+      } else {
+        ret = interface_cmd_disable_propagation(iptr, state,
+                                                slave->str, result);
+      }
+      if (ret != LAGOPUS_RESULT_OK) {
+        ret = datastore_json_result_string_setf(result, ret,
+                                                "slave name = %s.",
+                                                slave->str);
+        break;
+      }
+    }
+  }
+
+  datastore_names_destroy(slave_names);
+
+  return ret;
+}
+
 static inline lagopus_result_t
 interface_port_create(const char *name,
                       interface_attr_t *attr) {
@@ -318,6 +486,9 @@ interface_port_create(const char *name,
         /* TODO: */
         ret = LAGOPUS_RESULT_OK;
         break;
+      case DATASTORE_INTERFACE_TYPE_BONDING:
+        ret = bonding_port_create(name, attr);
+        break;
       case DATASTORE_INTERFACE_TYPE_UNKNOWN:
         ret = LAGOPUS_RESULT_OK;
         break;
@@ -356,6 +527,9 @@ interface_port_destroy(const char *name,
         /* TODO: */
         ret = LAGOPUS_RESULT_OK;
         break;
+      case DATASTORE_INTERFACE_TYPE_BONDING:
+        ret = bonding_port_destroy(name, attr);
+        break;
       case DATASTORE_INTERFACE_TYPE_UNKNOWN:
         ret = LAGOPUS_RESULT_OK;
         break;
@@ -452,6 +626,15 @@ interface_cmd_do_destroy(interface_conf_t *conf,
     }
   } else if (conf->is_destroying == true ||
              state == DATASTORE_INTERP_STATE_AUTO_COMMIT) {
+    if (conf->current_attr != NULL) {
+      /* unset is_used for bonding slaves. */
+      ret = bonding_slaves_used_set(conf->current_attr, false);
+      if (ret != LAGOPUS_RESULT_OK) {
+        /* ignore error. */
+        lagopus_msg_warning("ret = %s\n", lagopus_error_get_string(ret));
+      }
+    }
+
     ret = dp_interface_destroy(conf->name);
     if (ret != LAGOPUS_RESULT_OK) {
       /* ignore error. */
@@ -521,7 +704,11 @@ interface_cmd_do_update(datastore_interp_t *iptr,
           lagopus_msg_info("start interface. name = %s.\n",
                            conf->name);
           ret = dp_interface_start(conf->name);
-          if (ret != LAGOPUS_RESULT_OK) {
+          if (ret == LAGOPUS_RESULT_OK) {
+            /* start bonding slaves. */
+            ret = bonding_slaves_enable(iptr, state, conf->modified_attr,
+                                        true, result);
+          } else {
             ret = datastore_json_result_string_setf(
                     result, ret,
                     "Can't start interface(port).");
@@ -548,7 +735,11 @@ interface_cmd_do_update(datastore_interp_t *iptr,
           lagopus_msg_info("start interface. name = %s.\n",
                            conf->name);
           ret = dp_interface_start(conf->name);
-          if (ret != LAGOPUS_RESULT_OK) {
+          if (ret == LAGOPUS_RESULT_OK) {
+            /* start bonding slaves. */
+            ret = bonding_slaves_enable(iptr, state, conf->current_attr,
+                                        true, result);
+          } else {
             ret = datastore_json_result_string_setf(
                     result, ret,
                     "Can't start interface(port).");
@@ -558,7 +749,11 @@ interface_cmd_do_update(datastore_interp_t *iptr,
           lagopus_msg_info("stop interface. name = %s.\n",
                            conf->name);
           ret = dp_interface_stop(conf->name);
-          if (ret != LAGOPUS_RESULT_OK) {
+          if (ret == LAGOPUS_RESULT_OK) {
+            /* stop bonding slaves. */
+            ret = bonding_slaves_enable(iptr, state, conf->current_attr,
+                                        false, result);
+          } else {
             ret = datastore_json_result_string_setf(
                     result, ret,
                     "Can't stop interface(port).");
@@ -1049,6 +1244,323 @@ device_opt_parse(const char *const *argv[],
   return ret;
 }
 
+static lagopus_result_t
+bonding_mode_opt_parse(const char *const *argv[],
+                       void *c, void *out_configs,
+                       lagopus_dstring_t *result) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  interface_conf_t *conf = NULL;
+  configs_t *configs = NULL;
+  datastore_interface_bonding_mode_t mode;
+
+  if (argv != NULL && c != NULL &&
+      out_configs != NULL && result != NULL) {
+    conf = (interface_conf_t *) c;
+    configs = (configs_t *) out_configs;
+
+    if (*(*argv + 1) != NULL) {
+      (*argv)++;
+      if (IS_VALID_STRING(*(*argv)) == true) {
+        if ((ret = interface_bonding_mode_to_enum(*(*argv), &mode)) ==
+            LAGOPUS_RESULT_OK) {
+          ret = interface_set_bonding_mode(conf->modified_attr, mode);
+          if (ret != LAGOPUS_RESULT_OK) {
+            ret = datastore_json_result_string_setf(result, ret,
+                                                    "Can't add bonding mode.");
+          }
+        } else {
+          ret = datastore_json_result_string_setf(result, ret,
+                                                  "Bad opt value = %s.",
+                                                  *(*argv));
+        }
+      } else {
+        if (*(*argv) == NULL) {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value.");
+        } else {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value = %s.",
+                                                  *(*argv));
+        }
+      }
+    } else if (configs->is_config == true) {
+      configs->flags = OPT_BIT_GET(OPT_BONDING_MODE);
+      ret = LAGOPUS_RESULT_OK;
+    } else {
+      ret = datastore_json_result_string_setf(result,
+                                              LAGOPUS_RESULT_INVALID_ARGS,
+                                              "Bad opt value.");
+    }
+  } else {
+    ret = datastore_json_result_set(result,
+                                    LAGOPUS_RESULT_INVALID_ARGS,
+                                    NULL);
+  }
+
+  return ret;
+}
+
+static lagopus_result_t
+xmit_hash_policy_opt_parse(const char *const *argv[],
+                           void *c, void *out_configs,
+                           lagopus_dstring_t *result) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  interface_conf_t *conf = NULL;
+  configs_t *configs = NULL;
+  datastore_interface_xmit_hash_policy_t policy;
+
+  if (argv != NULL && c != NULL &&
+      out_configs != NULL && result != NULL) {
+    conf = (interface_conf_t *) c;
+    configs = (configs_t *) out_configs;
+
+    if (*(*argv + 1) != NULL) {
+      (*argv)++;
+      if (IS_VALID_STRING(*(*argv)) == true) {
+        if ((ret = interface_xmit_hash_policy_to_enum(*(*argv), &policy)) ==
+            LAGOPUS_RESULT_OK) {
+          ret = interface_set_xmit_hash_policy(conf->modified_attr, policy);
+          if (ret != LAGOPUS_RESULT_OK) {
+            ret = datastore_json_result_string_setf(
+                    result, ret, "Can't add xmit hash policy.");
+          }
+        } else {
+          ret = datastore_json_result_string_setf(result, ret,
+                                                  "Bad opt value = %s.",
+                                                  *(*argv));
+        }
+      } else {
+        if (*(*argv) == NULL) {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value.");
+        } else {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value = %s.",
+                                                  *(*argv));
+        }
+      }
+    } else if (configs->is_config == true) {
+      configs->flags = OPT_BIT_GET(OPT_XMIT_HASH_POLICY);
+      ret = LAGOPUS_RESULT_OK;
+    } else {
+      ret = datastore_json_result_string_setf(result,
+                                              LAGOPUS_RESULT_INVALID_ARGS,
+                                              "Bad opt value.");
+    }
+  } else {
+    ret = datastore_json_result_set(result,
+                                    LAGOPUS_RESULT_INVALID_ARGS,
+                                    NULL);
+  }
+
+  return ret;
+}
+
+static lagopus_result_t
+lacp_rate_opt_parse(const char *const *argv[],
+                    void *c, void *out_configs,
+                    lagopus_dstring_t *result) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  interface_conf_t *conf = NULL;
+  configs_t *configs = NULL;
+  datastore_interface_lacp_rate_t lacp_rate;
+
+  if (argv != NULL && c != NULL &&
+      out_configs != NULL && result != NULL) {
+    conf = (interface_conf_t *) c;
+    configs = (configs_t *) out_configs;
+
+    if (*(*argv + 1) != NULL) {
+      (*argv)++;
+      if (IS_VALID_STRING(*(*argv)) == true) {
+        if ((ret = interface_lacp_rate_to_enum(*(*argv), &lacp_rate)) ==
+            LAGOPUS_RESULT_OK) {
+          ret = interface_set_lacp_rate(conf->modified_attr, lacp_rate);
+          if (ret != LAGOPUS_RESULT_OK) {
+            ret = datastore_json_result_string_setf(result, ret,
+                                                    "Can't add lacp rate.");
+          }
+        } else {
+          ret = datastore_json_result_string_setf(result, ret,
+                                                  "Bad opt value = %s.",
+                                                  *(*argv));
+        }
+      } else {
+        if (*(*argv) == NULL) {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value.");
+        } else {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value = %s.",
+                                                  *(*argv));
+        }
+      }
+    } else if (configs->is_config == true) {
+      configs->flags = OPT_BIT_GET(OPT_LACP_RATE);
+      ret = LAGOPUS_RESULT_OK;
+    } else {
+      ret = datastore_json_result_string_setf(result,
+                                              LAGOPUS_RESULT_INVALID_ARGS,
+                                              "Bad opt value.");
+    }
+  } else {
+    ret = datastore_json_result_set(result,
+                                    LAGOPUS_RESULT_INVALID_ARGS,
+                                    NULL);
+  }
+
+  return ret;
+}
+
+static lagopus_result_t
+slave_opt_parse(const char *const *argv[],
+                void *c, void *out_configs,
+                lagopus_dstring_t *result) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  interface_conf_t *conf = NULL;
+  configs_t *configs = NULL;
+  char *name = NULL;
+  char *name_str = NULL;
+  char *fullname = NULL;
+  bool is_added = false;
+  bool is_exists = false;
+  bool is_used = false;
+
+  if (argv != NULL && c != NULL &&
+      out_configs != NULL && result != NULL) {
+    conf = (interface_conf_t *) c;
+    configs = (configs_t *) out_configs;
+
+    if (*(*argv + 1) != NULL) {
+      (*argv)++;
+      if (IS_VALID_STRING(*(*argv)) == true) {
+        if ((ret = lagopus_str_unescape(*(*argv), "\"'", &name_str)) >= 0) {
+          if ((ret = cmd_opt_name_get(name_str, &name, &is_added)) ==
+              LAGOPUS_RESULT_OK) {
+            if ((ret = namespace_get_fullname(name, &fullname))
+                == LAGOPUS_RESULT_OK) {
+              is_exists =
+                interface_attr_slave_name_exists(conf->modified_attr,
+                                                 fullname);
+            } else {
+              ret = datastore_json_result_string_setf(result,
+                                                      ret,
+                                                      "Can't get fullname %s.",
+                                                      name);
+              goto done;
+            }
+          } else {
+            ret = datastore_json_result_string_setf(result, ret,
+                                                    "Can't get slave_name.");
+            goto done;
+          }
+        } else {
+          ret = datastore_json_result_string_setf(result, ret,
+                                                  "slave name = %s.",
+                                                  *(*argv));
+          goto done;
+        }
+
+        if (is_added == true) {
+          /* add. */
+          /* check exists. */
+          if (is_exists == true) {
+            ret = datastore_json_result_string_setf(
+                result,
+                LAGOPUS_RESULT_ALREADY_EXISTS,
+                "slave name = %s.", fullname);
+            goto done;
+          }
+
+          if (strcmp(fullname, conf->name) == 0 ||
+              interface_exists(fullname) == false) {
+            ret = datastore_json_result_string_setf(
+                result,
+                LAGOPUS_RESULT_NOT_FOUND,
+                "slave name = %s.", fullname);
+            goto done;
+          }
+
+          /* check is_used. */
+          if ((ret =
+               datastore_interface_is_used(fullname, &is_used)) ==
+              LAGOPUS_RESULT_OK) {
+            if (is_used == false) {
+              ret = interface_attr_add_slave_name(conf->modified_attr,
+                                                  fullname);
+              if (ret != LAGOPUS_RESULT_OK) {
+                ret = datastore_json_result_string_setf(
+                    result, ret,
+                    "slave name = %s.", fullname);
+              }
+            } else {
+              ret = datastore_json_result_string_setf(
+                  result,
+                  LAGOPUS_RESULT_NOT_OPERATIONAL,
+                  "slave name = %s.", fullname);
+            }
+          } else {
+            ret = datastore_json_result_string_setf(
+                result, ret,
+                "slave name = %s.", fullname);
+          }
+        } else {
+          /* delete. */
+          if (is_exists == false) {
+            ret = datastore_json_result_string_setf(
+                result, LAGOPUS_RESULT_NOT_FOUND,
+                "slave name = %s.", fullname);
+            goto done;
+          }
+
+          ret = interface_attr_remove_slave_name(conf->modified_attr,
+                                                 fullname);
+          if (ret != LAGOPUS_RESULT_OK) {
+            ret = datastore_json_result_string_setf(
+                result, ret,
+                "slave name = %s.", fullname);
+          }
+        }
+      } else {
+        if (*(*argv) == NULL) {
+          ret = datastore_json_result_string_setf(result,
+                                                  LAGOPUS_RESULT_INVALID_ARGS,
+                                                  "Bad opt value.");
+        } else {
+          ret = datastore_json_result_string_setf(
+                  result,
+                  LAGOPUS_RESULT_INVALID_ARGS,
+                  "Bad opt value = %s.", *(*argv));
+        }
+      }
+    } else if (configs->is_config == true) {
+      configs->flags = OPT_BIT_GET(OPT_SLAVES);
+      ret = LAGOPUS_RESULT_OK;
+    } else {
+      ret = datastore_json_result_string_setf(result,
+                                              LAGOPUS_RESULT_INVALID_ARGS,
+                                              "Bad opt value.");
+    }
+  } else {
+    ret = datastore_json_result_set(result,
+                                    LAGOPUS_RESULT_INVALID_ARGS,
+                                    NULL);
+  }
+
+done:
+  free(name);
+  free(name_str);
+  free(fullname);
+
+  return ret;
+}
+
 static lagopus_result_t
 clear_opt_parse(const char *const *argv[],
                 void *c, void *out_configs,
@@ -1165,6 +1677,9 @@ opt_parse(const char *const argv[],
               case DATASTORE_INTERFACE_TYPE_VHOST_USER:
                 table = vhost_user_opt_table;
                 break;
+              case DATASTORE_INTERFACE_TYPE_BONDING:
+                table = bonding_opt_table;
+                break;
               default:
                 ret = datastore_json_result_string_setf(result, ret,
                                                         "Bad opt value = %s.",
@@ -2025,6 +2540,23 @@ interface_cmd_serialize(datastore_interp_t *iptr,
   char *ip_addr_str = NULL;
   char *escaped_ip_addr_str = NULL;
 
+  /* bonding-mode */
+  datastore_interface_bonding_mode_t bonding_mode;
+  const char *bonding_mode_str = NULL;
+
+  /* xmit-hash-policy */
+  datastore_interface_xmit_hash_policy_t xmit_hash_policy;
+  const char *xmit_hash_policy_str = NULL;
+
+  /* lacp-rate */
+  datastore_interface_lacp_rate_t lacp_rate;
+  const char *lacp_rate_str = NULL;
+
+  /* slave */
+  datastore_name_info_t *slave_names = NULL;
+  struct datastore_name_entry *slave = NULL;
+  char *escaped_slave_str = NULL;
+
 
   (void) state;
 
@@ -2128,6 +2660,9 @@ interface_cmd_serialize(datastore_interp_t *iptr,
       case DATASTORE_INTERFACE_TYPE_VHOST_USER:
         flags &= OPT_VHOST_USER;
         break;
+      case DATASTORE_INTERFACE_TYPE_BONDING:
+        flags &= OPT_BONDING;
+        break;
       case DATASTORE_INTERFACE_TYPE_UNKNOWN:
         flags &= OPT_UNKNOWN;
         break;
@@ -2549,6 +3084,96 @@ interface_cmd_serialize(datastore_interp_t *iptr,
       }
     }
 
+    /* bonding-mode opt. */
+    if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_BONDING_MODE)) == true) {
+      if (((ret = interface_get_bonding_mode(conf->current_attr,
+                                             &bonding_mode)) !=
+           LAGOPUS_RESULT_OK) ||
+          ((ret = interface_bonding_mode_to_str(bonding_mode,
+                                                &bonding_mode_str)) !=
+           LAGOPUS_RESULT_OK) ||
+          ((ret = lagopus_dstring_appendf(result, " %s %s",
+                                          opt_strs[OPT_BONDING_MODE],
+                                          bonding_mode_str)) !=
+           LAGOPUS_RESULT_OK)) {
+        lagopus_perror(ret);
+        goto done;
+      }
+    }
+
+    /* xmit-hash-policy opt. */
+    if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_XMIT_HASH_POLICY)) == true) {
+      if (((ret = interface_get_xmit_hash_policy(conf->current_attr,
+                                                 &xmit_hash_policy)) !=
+           LAGOPUS_RESULT_OK) ||
+          ((ret = interface_xmit_hash_policy_to_str(
+                    xmit_hash_policy, &xmit_hash_policy_str)) !=
+           LAGOPUS_RESULT_OK) ||
+          ((ret = lagopus_dstring_appendf(result, " %s %s",
+                                          opt_strs[OPT_XMIT_HASH_POLICY],
+                                          xmit_hash_policy_str)) !=
+           LAGOPUS_RESULT_OK)) {
+        lagopus_perror(ret);
+        goto done;
+      }
+    }
+
+    /* lacp-rate opt. */
+    if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_LACP_RATE)) == true) {
+      if (((ret = interface_get_lacp_rate(conf->current_attr,
+                                          &lacp_rate)) !=
+           LAGOPUS_RESULT_OK) ||
+          ((ret = interface_lacp_rate_to_str(lacp_rate,
+                                             &lacp_rate_str)) !=
+           LAGOPUS_RESULT_OK) ||
+          ((ret = lagopus_dstring_appendf(result, " %s %s",
+                                          opt_strs[OPT_LACP_RATE],
+                                          lacp_rate_str)) !=
+           LAGOPUS_RESULT_OK)) {
+        lagopus_perror(ret);
+        goto done;
+      }
+    }
+
+    /* slave opt. */
+    if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_SLAVES)) == true) {
+      if ((ret = interface_get_slave_names(conf->current_attr,
+                                           &slave_names)) ==
+          LAGOPUS_RESULT_OK) {
+        TAILQ_FOREACH(slave, &slave_names->head, name_entries) {
+          if ((ret = lagopus_dstring_appendf(result, " %s",
+                                             opt_strs[OPT_SLAVE])) ==
+              LAGOPUS_RESULT_OK) {
+            if ((ret = lagopus_str_escape(slave->str, "\"",
+                                          &is_escaped,
+                                          &escaped_slave_str)) ==
+                LAGOPUS_RESULT_OK) {
+              if ((ret = lagopus_dstring_appendf(
+                           result,
+                           ESCAPE_NAME_FMT(is_escaped, escaped_slave_str),
+                           escaped_slave_str)) !=
+                  LAGOPUS_RESULT_OK) {
+                lagopus_perror(ret);
+                goto done;
+              }
+            } else {
+              lagopus_perror(ret);
+              goto done;
+            }
+
+            free((void *) escaped_slave_str);
+            escaped_slave_str = NULL;
+          } else {
+            lagopus_perror(ret);
+            goto done;
+          }
+        }
+      } else {
+        lagopus_perror(ret);
+        goto done;
+      }
+    }
+
     /* Add newline. */
     if ((ret = lagopus_dstring_appendf(result, "\n")) !=
         LAGOPUS_RESULT_OK) {
@@ -2573,6 +3198,8 @@ interface_cmd_serialize(datastore_interp_t *iptr,
     free((void *) ip_addr);
     free((void *) ip_addr_str);
     free((void *) escaped_ip_addr_str);
+    free((void *) escaped_slave_str);
+    datastore_names_destroy(slave_names);
   } else {
     ret = LAGOPUS_RESULT_INVALID_ARGS;
   }
@@ -2711,6 +3338,14 @@ initialize_internal(void) {
     goto done;
   }
 
+  /* create hashmap for bonding opt. */
+  if ((ret = lagopus_hashmap_create(&bonding_opt_table,
+                                    LAGOPUS_HASHMAP_TYPE_STRING,
+                                    NULL)) != LAGOPUS_RESULT_OK) {
+    lagopus_perror(ret);
+    goto done;
+  }
+
   /* create hashmap for stats opt. */
   if ((ret = lagopus_hashmap_create(&stats_opt_table,
                                     LAGOPUS_HASHMAP_TYPE_STRING,
@@ -2826,6 +3461,23 @@ initialize_internal(void) {
     goto done;
   }
 
+  /* add opts for bonding opt. */
+  if (((ret = opt_add(opt_strs[OPT_BONDING_MODE], bonding_mode_opt_parse,
+                      &bonding_opt_table)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = opt_add(opt_strs[OPT_XMIT_HASH_POLICY],
+                      xmit_hash_policy_opt_parse,
+                      &bonding_opt_table)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = opt_add(opt_strs[OPT_LACP_RATE], lacp_rate_opt_parse,
+                      &bonding_opt_table)) !=
+       LAGOPUS_RESULT_OK) ||
+      ((ret = opt_add(opt_strs[OPT_SLAVE], slave_opt_parse,
+                      &bonding_opt_table)) !=
+       LAGOPUS_RESULT_OK)) {
+    goto done;
+  }
+
   /* add opts for stats opt. */
   if (((ret = opt_add(opt_strs[OPT_CLEAR], clear_opt_parse,
                       &stats_opt_table)) !=
@@ -2893,6 +3545,47 @@ done:
   return ret;
 }
 
+static inline lagopus_result_t
+names_show(lagopus_dstring_t *ds,
+           const char *key,
+           datastore_name_info_t *names,
+           bool delimiter) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  struct datastore_name_entry *name = NULL;
+  char *name_str = NULL;
+  size_t i = 0;
+
+  if (key != NULL) {
+    ret = DSTRING_CHECK_APPENDF(ds, delimiter, KEY_FMT"[", key);
+    if (ret == LAGOPUS_RESULT_OK) {
+      TAILQ_FOREACH(name, &names->head, name_entries) {
+        ret = datastore_json_string_escape(name->str, &name_str);
+        if (ret == LAGOPUS_RESULT_OK) {
+          ret = lagopus_dstring_appendf(ds, DS_JSON_LIST_ITEM_FMT(i),
+                                        name_str);
+          if (ret == LAGOPUS_RESULT_OK) {
+            i++;
+          } else {
+            goto done;
+          }
+        }
+        free(name_str);
+        name_str = NULL;
+      }
+    } else {
+      goto done;
+    }
+    ret = lagopus_dstring_appendf(ds, "]");
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+done:
+  free(name_str);
+
+  return ret;
+}
+
 static lagopus_result_t
 interface_cmd_json_create(lagopus_dstring_t *ds,
                           configs_t *configs,
@@ -2906,6 +3599,11 @@ interface_cmd_json_create(lagopus_dstring_t *ds,
   char *ip_addr = NULL;
   char *mcast_group = NULL;
   char *device = NULL;
+  datastore_interface_bonding_mode_t bonding_mode;
+  datastore_interface_xmit_hash_policy_t xmit_hash_policy;
+  datastore_interface_lacp_rate_t lacp_rate;
+  const char *str = NULL;
+  datastore_name_info_t *slave_names = NULL;
   mac_address_t addr;
   uint32_t port_no;
   uint32_t ni;
@@ -2995,6 +3693,9 @@ interface_cmd_json_create(lagopus_dstring_t *ds,
               case DATASTORE_INTERFACE_TYPE_VHOST_USER:
                 flags &= OPT_VHOST_USER;
                 break;
+              case DATASTORE_INTERFACE_TYPE_BONDING:
+                flags &= OPT_BONDING;
+                break;
               case DATASTORE_INTERFACE_TYPE_UNKNOWN:
                 flags &= OPT_UNKNOWN;
                 break;
@@ -3265,6 +3966,73 @@ interface_cmd_json_create(lagopus_dstring_t *ds,
             }
           }
 
+          /* bonding mode */
+          if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_BONDING_MODE)) == true) {
+            if (((ret = interface_get_bonding_mode(attr,
+                                                   &bonding_mode)) !=
+                 LAGOPUS_RESULT_OK) ||
+                ((ret = interface_bonding_mode_to_str(bonding_mode,
+                                                      &str)) !=
+                 LAGOPUS_RESULT_OK) ||
+                ((ret = datastore_json_string_append(
+                          ds, ATTR_NAME_GET(opt_strs, OPT_BONDING_MODE),
+                          str, true)) !=
+                 LAGOPUS_RESULT_OK)) {
+              lagopus_perror(ret);
+              goto done;
+            }
+          }
+
+          /* xmit hash policy */
+          if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_XMIT_HASH_POLICY)) == true) {
+            if (((ret = interface_get_xmit_hash_policy(attr,
+                                                       &xmit_hash_policy)) !=
+                 LAGOPUS_RESULT_OK) ||
+                ((ret = interface_xmit_hash_policy_to_str(xmit_hash_policy,
+                                                          &str)) !=
+                 LAGOPUS_RESULT_OK) ||
+                ((ret = datastore_json_string_append(
+                          ds, ATTR_NAME_GET(opt_strs, OPT_XMIT_HASH_POLICY),
+                          str, true)) !=
+                 LAGOPUS_RESULT_OK)) {
+              lagopus_perror(ret);
+              goto done;
+            }
+          }
+
+          /* lacp rate */
+          if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_LACP_RATE)) == true) {
+            if (((ret = interface_get_lacp_rate(attr, &lacp_rate)) !=
+                 LAGOPUS_RESULT_OK) ||
+                ((ret = interface_lacp_rate_to_str(lacp_rate, &str)) !=
+                 LAGOPUS_RESULT_OK) ||
+                ((ret = datastore_json_string_append(
+                          ds, ATTR_NAME_GET(opt_strs, OPT_LACP_RATE),
+                          str, true)) !=
+                 LAGOPUS_RESULT_OK)) {
+              lagopus_perror(ret);
+              goto done;
+            }
+          }
+
+          /* slaves */
+          if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_SLAVES)) == true) {
+            if ((ret = interface_get_slave_names(attr,
+                                                 &slave_names)) ==
+                LAGOPUS_RESULT_OK) {
+              if ((ret = names_show(ds,
+                                    ATTR_NAME_GET(opt_strs, OPT_SLAVES),
+                                    slave_names, true)) !=
+                  LAGOPUS_RESULT_OK) {
+                lagopus_perror(ret);
+                goto done;
+              }
+            } else {
+              lagopus_perror(ret);
+              goto done;
+            }
+          }
+
           /* used */
           if (IS_BIT_SET(flags, OPT_BIT_GET(OPT_IS_USED)) == true) {
             if ((ret = datastore_json_bool_append(
@@ -3306,6 +4074,8 @@ interface_cmd_json_create(lagopus_dstring_t *ds,
       mcast_group = NULL;
       free(device);
       device = NULL;
+      datastore_names_destroy(slave_names);
+      slave_names = NULL;
 
       if (ret != LAGOPUS_RESULT_OK) {
         break;
@@ -3653,6 +4423,8 @@ interface_cmd_finalize(void) {
   vxlan_opt_table = NULL;
   lagopus_hashmap_destroy(&vhost_user_opt_table, true);
   vhost_user_opt_table = NULL;
+  lagopus_hashmap_destroy(&bonding_opt_table, true);
+  bonding_opt_table = NULL;
   lagopus_hashmap_destroy(&stats_opt_table, true);
   stats_opt_table = NULL;
 
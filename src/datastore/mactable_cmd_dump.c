@@ -135,7 +135,8 @@ dump_table_macentries(const char *name,
                  lagopus_dstring_t *result) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
   unsigned int num_entries;
-  uint32_t ageing_time, max_entries;
+  uint32_t ageing_time, max_entries, vlan_max_entries;
+  uint64_t moves;
 
   if ((ret = lagopus_dstring_appendf(result, "{")) != LAGOPUS_RESULT_OK) {
     lagopus_perror(ret);
@@ -176,6 +177,31 @@ dump_table_macentries(const char *name,
     goto done;
   }
 
+  /* get "vlan_max_entries" and "moves" from mactable. */
+  if ((ret = dp_bridge_mactable_vlan_max_entries_get(name,
+                                                     &vlan_max_entries)) !=
+       LAGOPUS_RESULT_OK) {
+    lagopus_perror(ret);
+    goto done;
+  }
+  if ((ret = datastore_json_uint32_append( result, "vlan_max_entries",
+             vlan_max_entries, true)) !=
+       LAGOPUS_RESULT_OK) {
+    lagopus_perror(ret);
+    goto done;
+  }
+  if ((ret = dp_bridge_mactable_moves_get(name, &moves)) !=
+       LAGOPUS_RESULT_OK) {
+    lagopus_perror(ret);
+    goto done;
+  }
+  if ((ret = datastore_json_uint64_append( result, "moves",
+             moves, true)) !=
+       LAGOPUS_RESULT_OK) {
+    lagopus_perror(ret);
+    goto done;
+  }
+
   /* start "entries". */
   if ((ret = lagopus_dstring_appendf(
                result, DELIMITER_INSTERN(KEY_FMT "["),
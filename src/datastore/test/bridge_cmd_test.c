@@ -461,6 +461,7 @@ test_bridge_cmd_parse_create_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -500,6 +501,7 @@ test_bridge_cmd_parse_create_01_hybrid(void) {
     "\"l2-bridge\":true,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -541,6 +543,7 @@ test_bridge_cmd_parse_create_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -1935,6 +1938,7 @@ test_bridge_cmd_parse_config_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -1983,6 +1987,7 @@ test_bridge_cmd_parse_config_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -2416,6 +2421,7 @@ test_bridge_cmd_parse_config_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -2485,6 +2491,7 @@ test_bridge_cmd_parse_config_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -2825,6 +2832,7 @@ test_bridge_cmd_parse_config_delete_port_ctrler_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -2896,6 +2904,7 @@ test_bridge_cmd_parse_config_delete_port_ctrler_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -3161,6 +3170,7 @@ test_bridge_cmd_parse_config_show_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -3427,6 +3437,7 @@ test_bridge_cmd_show_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -3743,6 +3754,7 @@ test_bridge_cmd_parse_config_port_number_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -3790,6 +3802,7 @@ test_bridge_cmd_parse_config_port_number_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -4107,6 +4120,7 @@ test_bridge_cmd_parse_config_port_number_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -4440,6 +4454,7 @@ test_bridge_cmd_parse_config_controller_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -4631,6 +4646,7 @@ test_bridge_cmd_serialize_default_opt_hybrid(void) {
                                 "-l2-bridge false "
                                 "-mactable-ageing-time 300 "
                                 "-mactable-max-entries 8192 "
+                                "-mactable-vlan-max-entries 0 "
                                 "-packet-inq-size 1000 "
                                 "-packet-inq-max-batches 1000 "
                                 "-up-streamq-size 1000 "
@@ -4754,6 +4770,7 @@ test_bridge_cmd_serialize_default_opt_escape_hybrid(void) {
                                 "-l2-bridge false "
                                 "-mactable-ageing-time 300 "
                                 "-mactable-max-entries 8192 "
+                                "-mactable-vlan-max-entries 0 "
                                 "-packet-inq-size 1000 "
                                 "-packet-inq-max-batches 1000 "
                                 "-up-streamq-size 1000 "
@@ -4877,6 +4894,7 @@ test_bridge_cmd_serialize_default_opt_escape_white_space_hybrid(void) {
                                 "-l2-bridge false "
                                 "-mactable-ageing-time 300 "
                                 "-mactable-max-entries 8192 "
+                                "-mactable-vlan-max-entries 0 "
                                 "-packet-inq-size 1000 "
                                 "-packet-inq-max-batches 1000 "
                                 "-up-streamq-size 1000 "
@@ -5084,6 +5102,7 @@ test_bridge_cmd_serialize_all_opt_hybrid(void) {
                                 "-l2-bridge true "
                                 "-mactable-ageing-time 300 "
                                 "-mactable-max-entries 8192 "
+                                "-mactable-vlan-max-entries 0 "
                                 "-mactable-entry 00:11:22:33:44:55 1 "
                                 "-packet-inq-size 128 "
                                 "-packet-inq-max-batches 128 "
@@ -5528,6 +5547,7 @@ test_bridge_cmd_parse_atomic_commit_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -5580,6 +5600,7 @@ test_bridge_cmd_parse_atomic_commit_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -5622,6 +5643,7 @@ test_bridge_cmd_parse_atomic_commit_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -6015,6 +6037,7 @@ test_bridge_cmd_parse_atomic_rollback_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -6067,6 +6090,7 @@ test_bridge_cmd_parse_atomic_rollback_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -6485,6 +6509,7 @@ test_bridge_cmd_parse_atomic_delay_enable_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -6530,6 +6555,7 @@ test_bridge_cmd_parse_atomic_delay_enable_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -6571,6 +6597,7 @@ test_bridge_cmd_parse_atomic_delay_enable_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -6979,6 +7006,7 @@ test_bridge_cmd_parse_atomic_delay_disable_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -7020,6 +7048,7 @@ test_bridge_cmd_parse_atomic_delay_disable_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -7061,6 +7090,7 @@ test_bridge_cmd_parse_atomic_delay_disable_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -7619,6 +7649,7 @@ test_bridge_cmd_parse_atomic_abort_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -7671,6 +7702,7 @@ test_bridge_cmd_parse_atomic_abort_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -7717,6 +7749,7 @@ test_bridge_cmd_parse_atomic_abort_01_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -8276,6 +8309,7 @@ test_bridge_cmd_parse_atomic_abort_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -8327,6 +8361,7 @@ test_bridge_cmd_parse_atomic_abort_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -8369,6 +8404,7 @@ test_bridge_cmd_parse_atomic_abort_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -8410,6 +8446,7 @@ test_bridge_cmd_parse_atomic_abort_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -8452,6 +8489,7 @@ test_bridge_cmd_parse_atomic_abort_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -8493,6 +8531,7 @@ test_bridge_cmd_parse_atomic_abort_02_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -9002,6 +9041,7 @@ test_bridge_cmd_parse_atomic_destroy_create_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -9044,6 +9084,7 @@ test_bridge_cmd_parse_atomic_destroy_create_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -9086,6 +9127,7 @@ test_bridge_cmd_parse_atomic_destroy_create_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -9473,6 +9515,7 @@ test_bridge_cmd_parse_create_action_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -9519,6 +9562,7 @@ test_bridge_cmd_parse_create_action_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -9754,6 +9798,7 @@ test_bridge_cmd_parse_create_instruction_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -9800,6 +9845,7 @@ test_bridge_cmd_parse_create_instruction_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -10035,6 +10081,7 @@ test_bridge_cmd_parse_create_reserved_port_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -10081,6 +10128,7 @@ test_bridge_cmd_parse_create_reserved_port_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -10316,6 +10364,7 @@ test_bridge_cmd_parse_create_group_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -10362,6 +10411,7 @@ test_bridge_cmd_parse_create_group_type_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -10597,6 +10647,7 @@ test_bridge_cmd_parse_create_group_capability_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -10643,6 +10694,7 @@ test_bridge_cmd_parse_create_group_capability_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":1000,\n"
     "\"packet-inq-max-batches\":1000,\n"
     "\"up-streamq-size\":1000,\n"
@@ -11456,6 +11508,7 @@ test_bridge_cmd_parse_dryrun_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -11509,6 +11562,7 @@ test_bridge_cmd_parse_dryrun_hybrid(void) {
     "\"l2-bridge\":false,\n"
     "\"mactable-ageing-time\":300,\n"
     "\"mactable-max-entries\":8192,\n"
+    "\"mactable-vlan-max-entries\":0,\n"
     "\"packet-inq-size\":65535,\n"
     "\"packet-inq-max-batches\":65535,\n"
     "\"up-streamq-size\":65535,\n"
@@ -11760,6 +11814,62 @@ test_bridge_cmd_parse_create_clear_queue_bad_opt(void) {
                  &tbl, bridge_cmd_update, &ds, str, test_str3);
 }
 
+void
+test_bridge_cmd_parse_create_mactable_vlan_max_entries(void) {
+#ifdef HYBRID
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_interp_state_t state = DATASTORE_INTERP_STATE_AUTO_COMMIT;
+  char *str = NULL;
+  const char *argv1[] = {"bridge", "test_name90", "create",
+                         "-mactable-vlan-max-entries", "100",
+                         NULL
+                        };
+  const char test_str1[] = "{\"ret\":\"OK\"}";
+  const char *argv2[] = {"bridge", "test_name90", "config",
+                         "-mactable-vlan-max-entries",
+                         NULL
+                        };
+  const char test_str2[] =
+    "{\"ret\":\"OK\",\n"
+    "\"data\":[{\"name\":\""DATASTORE_NAMESPACE_DELIMITER"test_name90\",\n"
+    "\"mactable-vlan-max-entries\":100}]}";
+  const char *argv3[] = {"bridge", "test_name90", "config",
+                         "-mactable-vlan-max-entries", "65536",
+                         NULL
+                        };
+  const char test_str3[] =
+    "{\"ret\":\"TOO_LONG\",\n"
+    "\"data\":\"Can't add mactable-vlan-max-entries.\"}";
+  const char *argv4[] = {"bridge", "test_name90", "destroy",
+                         NULL
+                        };
+  const char test_str4[] = "{\"ret\":\"OK\"}";
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, bridge_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv1), argv1,
+                 &tbl, bridge_cmd_update, &ds, str, test_str1);
+
+  /* config cmd (show). */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, bridge_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv2), argv2,
+                 &tbl, bridge_cmd_update, &ds, str, test_str2);
+
+  /* config cmd (over). */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_DATASTORE_INTERP_ERROR,
+                 bridge_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv3), argv3,
+                 &tbl, bridge_cmd_update, &ds, str, test_str3);
+
+  /* destroy cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, bridge_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv4), argv4,
+                 &tbl, bridge_cmd_update, &ds, str, test_str4);
+#else /* HYBRID */
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif /* HYBRID */
+}
+
 void
 test_destroy(void) {
   destroy = true;
@@ -4009,6 +4009,70 @@ test_bridge_attr_private_mactable_max_entries(void) {
 #endif // HYBRID
 }
 
+void
+test_bridge_attr_private_mactable_vlan_max_entries(void) {
+#ifdef HYBRID
+  lagopus_result_t rc;
+  bridge_attr_t *attr = NULL;
+  uint32_t actual_mactable_vlan_max_entries = 1;
+
+  bridge_initialize();
+
+  rc = bridge_attr_create(&attr);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rc);
+  TEST_ASSERT_NOT_NULL_MESSAGE(attr, "attr_create() will create new bridge");
+
+  // Normal case of getter
+  {
+    rc = bridge_get_mactable_vlan_max_entries(attr,
+         &actual_mactable_vlan_max_entries);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rc);
+    TEST_ASSERT_EQUAL_UINT32(DEFAULT_MACTABLE_VLAN_MAX_ENTRIES,
+                             actual_mactable_vlan_max_entries);
+  }
+
+  // Abnormal case of getter
+  {
+    rc = bridge_get_mactable_vlan_max_entries(NULL,
+         &actual_mactable_vlan_max_entries);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS, rc);
+    rc = bridge_get_mactable_vlan_max_entries(attr, NULL);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS, rc);
+  }
+
+  // Normal case of setter
+  {
+    rc = bridge_set_mactable_vlan_max_entries(attr,
+         MAXIMUM_MACTABLE_VLAN_MAX_ENTRIES);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rc);
+    rc = bridge_get_mactable_vlan_max_entries(attr,
+         &actual_mactable_vlan_max_entries);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rc);
+    TEST_ASSERT_EQUAL_UINT32(MAXIMUM_MACTABLE_VLAN_MAX_ENTRIES,
+                             actual_mactable_vlan_max_entries);
+
+    rc = bridge_set_mactable_vlan_max_entries(attr, 0);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rc);
+    rc = bridge_get_mactable_vlan_max_entries(attr,
+         &actual_mactable_vlan_max_entries);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, rc);
+    TEST_ASSERT_EQUAL_UINT32(0, actual_mactable_vlan_max_entries);
+  }
+
+  // Abnormal case of setter
+  {
+    rc = bridge_set_mactable_vlan_max_entries(NULL, 0);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS, rc);
+
+    rc = bridge_set_mactable_vlan_max_entries(attr,
+         (MAXIMUM_MACTABLE_VLAN_MAX_ENTRIES + 1));
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_TOO_LONG, rc);
+  }
+#else // HYBRID
+  TEST_IGNORE_MESSAGE("HYBRID is not defined.");
+#endif // HYBRID
+}
+
 void
 test_bridge_attr_public_mactable_max_entries(void) {
 #ifdef HYBRID
@@ -212,7 +212,7 @@
     lagopus_dstring_clear(_ds);                                         \
     _ret = dump_bridge_domains_flow(DATASTORE_NAMESPACE_DELIMITER       \
                                     _bri_name, _table_id, false,        \
-                                    true, _ds);                         \
+                                    true, NULL, _ds);                   \
     TEST_ASSERT_EQUAL_MESSAGE(_cmp_ret, _ret,                           \
                               "flow_cmd_dump error.");                  \
     TEST_DSTRING(_ret, _ds, _str, _test_str, true);                     \
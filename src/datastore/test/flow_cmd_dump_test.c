@@ -23,6 +23,7 @@
 #include "../datastore_internal.h"
 #include "../flow_cmd.h"
 #include "../flow_cmd_internal.h"
+#include "../cmd_dump.h"
 #include "../agent/ofp_match.h"
 #include "../agent/ofp_instruction.h"
 #include "../agent/ofp_action.h"
@@ -255,7 +256,7 @@ test_flow_cmd_dump_01(void) {
 
   (void) lagopus_dstring_clear(&ds);
   ret = dump_bridge_domains_flow(bridge_name, OFPTT_ALL,
-                                 false, true, &ds);
+                                 false, true, NULL, &ds);
   TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, ret,
                             "flow_cmd_dump error.");
   TEST_DSTRING(ret, &ds, str, test_str1, true);
@@ -349,7 +350,7 @@ test_flow_cmd_dump_with_stats(void) {
 
   (void) lagopus_dstring_clear(&ds);
   ret = dump_bridge_domains_flow(bridge_name, OFPTT_ALL,
-                                 true, true, &ds);
+                                 true, true, NULL, &ds);
   TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, ret,
                             "flow_cmd_dump error.");
   TEST_DSTRING(ret, &ds, str, test_str1, true);
@@ -360,6 +361,89 @@ test_flow_cmd_dump_with_stats(void) {
   TEST_ASSERT_GROUP_DEL(ret, dpid, &group_mod, &error);
 }
 
+void
+test_flow_cmd_dump_file(void) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  struct instruction_list instruction_list;
+  struct match_list match_list;
+  struct ofp_flow_mod flow_mod;
+  struct ofp_error error;
+  lagopus_dstring_t expected = NULL;
+  char *expected_str = NULL;
+  char *str = NULL;
+  char buf[256];
+  size_t len;
+  FILE *fp;
+  int nflow = DP_BRIDGE_FLOW_ITER_CHUNK + 10;
+  int i;
+
+  /* more flows than a chunk, the dump is written to the file by chunk. */
+  memset(&flow_mod, 0, sizeof(flow_mod));
+  flow_mod.table_id = 0;
+  flow_mod.out_port = OFPP_ANY;
+  flow_mod.out_group = OFPG_ANY;
+  for (i = 0; i < nflow; i++) {
+    TAILQ_INIT(&match_list);
+    TAILQ_INIT(&instruction_list);
+    flow_mod.priority = (uint16_t) i;
+    TEST_ASSERT_FLOW_ADD(ret, dpid, &flow_mod, &match_list,
+                         &instruction_list, &error);
+  }
+
+  /* flows are dumped in descending order of priority. */
+  ret = lagopus_dstring_create(&expected);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+  ret = lagopus_dstring_appendf(
+      &expected,
+      "{\"name\":\""DATASTORE_NAMESPACE_DELIMITER"test_bridge01\",\n"
+      "\"tables\":[{\"table\":0,\n"
+      "\"flows\":[");
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+  for (i = nflow - 1; i >= 0; i--) {
+    ret = lagopus_dstring_appendf(
+        &expected,
+        "%s{\"priority\":%d,\n"
+        "\"idle_timeout\":0,\n"
+        "\"hard_timeout\":0,\n"
+        "\"cookie\":0,\n"
+        "\"actions\":[]}",
+        (i == nflow - 1) ? "" : ",\n", i);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+  }
+  ret = lagopus_dstring_appendf(&expected, "]}]}");
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+  ret = lagopus_dstring_str_get(&expected, &expected_str);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+
+  fp = tmpfile();
+  TEST_ASSERT_NOT_NULL(fp);
+  (void) lagopus_dstring_clear(&ds);
+  ret = dump_bridge_domains_flow(bridge_name, 0,
+                                 false, true, fp, &ds);
+  TEST_ASSERT_EQUAL_MESSAGE(LAGOPUS_RESULT_OK, ret,
+                            "flow_cmd_dump error.");
+  /* the rest after the last chunk. */
+  ret = cmd_dump_file_write(fp, &ds);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+
+  (void) lagopus_dstring_clear(&ds);
+  rewind(fp);
+  while ((len = fread(buf, 1, sizeof(buf) - 1, fp)) > 0) {
+    buf[len] = '\0';
+    ret = lagopus_dstring_appendf(&ds, "%s", buf);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+  }
+  fclose(fp);
+  TEST_DSTRING(ret, &ds, str, expected_str, true);
+
+  free(expected_str);
+  lagopus_dstring_destroy(&expected);
+
+  TAILQ_INIT(&match_list);
+  TEST_ASSERT_FLOW_DEL(ret, dpid, &flow_mod, &match_list,
+                       &error);
+}
+
 void
 test_destroy(void) {
   destroy = true;
@@ -1082,6 +1082,168 @@ test_interface_cmd_parse_create_vhost_user_over_port(void) {
                  &ds, str, test_str1);
 }
 
+void
+test_interface_cmd_parse_create_bonding_01(void) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_interp_state_t state = DATASTORE_INTERP_STATE_AUTO_COMMIT;
+  char *str = NULL;
+  const char *argv1[] = {"interface", "test_name50", "create",
+                         "-type", "vxlan",
+                         NULL
+                        };
+  const char test_str1[] = "{\"ret\":\"OK\"}";
+  const char *argv2[] = {"interface", "test_name51", "create",
+                         "-type", "vxlan",
+                         NULL
+                        };
+  const char test_str2[] = "{\"ret\":\"OK\"}";
+  const char *argv3[] = {"interface", "test_name52", "create",
+                         "-type", "bonding",
+                         "-bonding-mode", "802.3ad",
+                         "-xmit-hash-policy", "layer3+4",
+                         "-lacp-rate", "fast",
+                         "-slave", "test_name50",
+                         "-slave", "test_name51",
+                         NULL
+                        };
+  const char test_str3[] = "{\"ret\":\"OK\"}";
+  const char *argv4[] = {"interface", "test_name52", NULL};
+  const char test_str4[] =
+    "{\"ret\":\"OK\",\n"
+    "\"data\":[{\"name\":\""DATASTORE_NAMESPACE_DELIMITER"test_name52\",\n"
+    "\"type\":\"bonding\",\n"
+    "\"bonding-mode\":\"802.3ad\",\n"
+    "\"xmit-hash-policy\":\"layer3+4\",\n"
+    "\"lacp-rate\":\"fast\",\n"
+    "\"slaves\":[\""DATASTORE_NAMESPACE_DELIMITER"test_name50\","
+    "\""DATASTORE_NAMESPACE_DELIMITER"test_name51\"],\n"
+    "\"is-used\":false,\n"
+    "\"is-enabled\":false}]}";
+  const char *argv5[] = {"interface", "test_name50", "destroy",
+                         NULL
+                        };
+  const char test_str5[] = {"{\"ret\":\"NOT_OPERATIONAL\",\n"
+                            "\"data\":\"name = "DATASTORE_NAMESPACE_DELIMITER"test_name50: is used.\"}"
+                           };
+  const char *argv6[] = {"interface", "test_name52", "config",
+                         "-slave", "~test_name51",
+                         NULL
+                        };
+  const char test_str6[] = "{\"ret\":\"OK\"}";
+  const char *argv7[] = {"interface", "test_name52", "config",
+                         "-slave",
+                         NULL
+                        };
+  const char test_str7[] =
+    "{\"ret\":\"OK\",\n"
+    "\"data\":[{\"name\":\""DATASTORE_NAMESPACE_DELIMITER"test_name52\",\n"
+    "\"slaves\":[\""DATASTORE_NAMESPACE_DELIMITER"test_name50\"]}]}";
+  const char *argv8[] = {"interface", "test_name51", "destroy",
+                         NULL
+                        };
+  const char test_str8[] = "{\"ret\":\"OK\"}";
+  const char *argv9[] = {"interface", "test_name52", "destroy",
+                         NULL
+                        };
+  const char test_str9[] = "{\"ret\":\"OK\"}";
+  const char *argv10[] = {"interface", "test_name50", "destroy",
+                          NULL
+                         };
+  const char test_str10[] = "{\"ret\":\"OK\"}";
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv1), argv1, &tbl, interface_cmd_update,
+                 &ds, str, test_str1);
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv2), argv2, &tbl, interface_cmd_update,
+                 &ds, str, test_str2);
+
+  /* create bonding cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv3), argv3, &tbl, interface_cmd_update,
+                 &ds, str, test_str3);
+
+  /* show cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv4), argv4, &tbl, interface_cmd_update,
+                 &ds, str, test_str4);
+
+  /* destroy slave cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_DATASTORE_INTERP_ERROR, interface_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv5), argv5, &tbl,
+                 interface_cmd_update, &ds, str, test_str5);
+
+  /* delete slave cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv6), argv6, &tbl, interface_cmd_update,
+                 &ds, str, test_str6);
+
+  /* config cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv7), argv7, &tbl, interface_cmd_update,
+                 &ds, str, test_str7);
+
+  /* destroy released slave cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv8), argv8, &tbl, interface_cmd_update,
+                 &ds, str, test_str8);
+
+  /* destroy bonding cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv9), argv9, &tbl, interface_cmd_update,
+                 &ds, str, test_str9);
+
+  /* destroy slave cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv10), argv10, &tbl, interface_cmd_update,
+                 &ds, str, test_str10);
+}
+
+void
+test_interface_cmd_parse_create_bonding_bad_slave(void) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_interp_state_t state = DATASTORE_INTERP_STATE_AUTO_COMMIT;
+  char *str = NULL;
+  const char *argv1[] = {"interface", "test_name53", "create",
+                         "-type", "bonding",
+                         "-slave", "test_name54",
+                         NULL
+                        };
+  const char test_str1[] = {"{\"ret\":\"NOT_FOUND\",\n"
+                            "\"data\":\"slave name = "DATASTORE_NAMESPACE_DELIMITER"test_name54.\"}"
+                           };
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_DATASTORE_INTERP_ERROR, interface_cmd_parse,
+                 &interp, state,
+                 ARGV_SIZE(argv1), argv1, &tbl, interface_cmd_update,
+                 &ds, str, test_str1);
+}
+
+void
+test_interface_cmd_parse_create_bonding_bad_mode(void) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_interp_state_t state = DATASTORE_INTERP_STATE_AUTO_COMMIT;
+  char *str = NULL;
+  const char *argv1[] = {"interface", "test_name55", "create",
+                         "-type", "bonding",
+                         "-bonding-mode", "active-backup",
+                         NULL
+                        };
+  const char test_str1[] = {"{\"ret\":\"INVALID_ARGS\",\n"
+                            "\"data\":\"Bad opt value = active-backup.\"}"
+                           };
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_DATASTORE_INTERP_ERROR, interface_cmd_parse,
+                 &interp, state,
+                 ARGV_SIZE(argv1), argv1, &tbl, interface_cmd_update,
+                 &ds, str, test_str1);
+}
+
 void
 test_interface_cmd_serialize_default_opt(void) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
@@ -1337,6 +1499,72 @@ test_interface_cmd_serialize_type_ethernet_escape_white_space(void) {
                  interface_cmd_update, &ds, str, test_str2);
 }
 
+void
+test_interface_cmd_serialize_type_bonding(void) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  datastore_interp_state_t state = DATASTORE_INTERP_STATE_AUTO_COMMIT;
+  char *str = NULL;
+  void *conf = NULL;
+
+  /* interface create cmd str. */
+  const char *argv1[] = {"interface", "test_name56", "create",
+                         "-type", "vxlan",
+                         NULL
+                        };
+  const char test_str1[] = "{\"ret\":\"OK\"}";
+  const char *argv2[] = {"interface", "test_name57", "create",
+                         "-type", "bonding",
+                         "-xmit-hash-policy", "layer3",
+                         "-slave", "test_name56",
+                         NULL
+                        };
+  const char test_str2[] = "{\"ret\":\"OK\"}";
+
+  /* interface destroy cmd str. */
+  const char *argv3[] = {"interface", "test_name57", "destroy",
+                         NULL
+                        };
+  const char test_str3[] = "{\"ret\":\"OK\"}";
+  const char *argv4[] = {"interface", "test_name56", "destroy",
+                         NULL
+                        };
+  const char test_str4[] = "{\"ret\":\"OK\"}";
+
+  /* serialize result str. */
+  const char serialize_str1[] = "interface "
+                                DATASTORE_NAMESPACE_DELIMITER"test_name57 create "
+                                "-type bonding "
+                                "-bonding-mode balance-xor "
+                                "-xmit-hash-policy layer3 "
+                                "-lacp-rate slow "
+                                "-slave "DATASTORE_NAMESPACE_DELIMITER"test_name56\n";
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv1), argv1, &tbl, interface_cmd_update,
+                 &ds, str, test_str1);
+
+  /* create cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse, &interp, state,
+                 ARGV_SIZE(argv2), argv2, &tbl, interface_cmd_update,
+                 &ds, str, test_str2);
+
+  /* TEST : serialize. */
+  TEST_CMD_PROC(ret, LAGOPUS_RESULT_OK, interface_cmd_serialize, &interp, state,
+                &tbl,
+                DATASTORE_NAMESPACE_DELIMITER"test_name57", conf, &ds, str, serialize_str1);
+
+  /* destroy cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv3), argv3, &tbl,
+                 interface_cmd_update, &ds, str, test_str3);
+
+  /* destroy cmd. */
+  TEST_CMD_PARSE(ret, LAGOPUS_RESULT_OK, interface_cmd_parse,
+                 &interp, state, ARGV_SIZE(argv4), argv4, &tbl,
+                 interface_cmd_update, &ds, str, test_str4);
+}
+
 void
 test_interface_cmd_parse_stats_01(void) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
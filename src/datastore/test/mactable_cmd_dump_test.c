@@ -95,6 +95,8 @@ test_mactable_cmd_dump_01(void) {
     "\"mactable\":[{\"num_entries\":1,\n"
     "\"max_entries\":8192,\n"
     "\"ageing_time\":300,\n"
+    "\"vlan_max_entries\":0,\n"
+    "\"moves\":0,\n"
     "\"entries\":[{\"mac_addr\":\"aa:bb:cc:dd:ee:ff\",\n"
     "\"port_no\":1,\n"
     "\"update_time\":%ld,\n"
@@ -141,6 +143,8 @@ test_mactable_cmd_dump_02(void) {
     "\"mactable\":[{\"num_entries\":2,\n"
     "\"max_entries\":8192,\n"
     "\"ageing_time\":300,\n"
+    "\"vlan_max_entries\":0,\n"
+    "\"moves\":0,\n"
     "\"entries\":[{\"mac_addr\":\"1a:2b:3c:4d:5e:6f\",\n"
     "\"port_no\":2,\n"
     "\"update_time\":%ld,\n"
@@ -201,6 +205,8 @@ test_mactable_cmd_dump_no_entry(void) {
     "\"mactable\":[{\"num_entries\":0,\n"
     "\"max_entries\":8192,\n"
     "\"ageing_time\":300,\n"
+    "\"vlan_max_entries\":0,\n"
+    "\"moves\":0,\n"
     "\"entries\":[";
   char test_str[1000];
 
@@ -56,6 +56,18 @@ enum fail_mode {
 struct dp_bridge_iter;
 typedef struct dp_bridge_iter *dp_bridge_iter_t;
 
+/* Max number of flows per dp_bridge_flow_iter_walk() call. */
+#ifndef DP_BRIDGE_FLOW_ITER_CHUNK
+#define DP_BRIDGE_FLOW_ITER_CHUNK 256
+#endif /* DP_BRIDGE_FLOW_ITER_CHUNK */
+
+/**
+ * Called for each flow with the flowdb read-locked.
+ * The flow must not be modified or kept.
+ */
+typedef lagopus_result_t
+(*dp_bridge_flow_proc_t)(struct flow *flow, void *arg);
+
 /**
  * @brief Bridge internal object.
  */
@@ -138,6 +150,16 @@ bridge_mactable_ageing_time_set(struct bridge *bridge, uint32_t ageing_time);
 lagopus_result_t
 bridge_mactable_max_entries_set(struct bridge *bridge, uint16_t max_entries);
 
+/**
+ * Set number of max entries per VLAN of MAC address table.
+ * @param[in]  bridge       Bridge.
+ * @param[in]  max_entries  Number of max entries per VLAN(0 means no limit).
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ */
+lagopus_result_t
+bridge_mactable_vlan_max_entries_set(struct bridge *bridge,
+                                     uint32_t max_entries);
+
 /**
  * Set the MAC address entry to MAC address table.
  * @param[in]  bridge   Bridge.
@@ -197,6 +219,25 @@ bridge_mactable_ageing_time_get(struct bridge *bridge, uint32_t *ageing_time);
 lagopus_result_t
 bridge_mactable_max_entries_get(struct bridge *bridge, uint32_t *max_entries);
 
+/**
+ * Get max entries per VLAN in MAC address table.
+ * @param[in]  bridge   Bridge.
+ * @param[out] max_entries max entries per VLAN(0 means no limit).
+ * @retval     LAGOPUS_RESULT_OK               Succeeded.
+ */
+lagopus_result_t
+bridge_mactable_vlan_max_entries_get(struct bridge *bridge,
+                                     uint32_t *max_entries);
+
+/**
+ * Get number of MAC moves detected in MAC address table.
+ * @param[in]  bridge   Bridge.
+ * @param[out] moves    Number of MAC moves.
+ * @retval     LAGOPUS_RESULT_OK               Succeeded.
+ */
+lagopus_result_t
+bridge_mactable_moves_get(struct bridge *bridge, uint64_t *moves);
+
 /**
  * Get number of MAC addres table entries.
  * @param[in]  bridge   Bridge.
@@ -231,6 +272,28 @@ dp_bridge_flow_iter_create(const char *name, uint8_t table_id,
                            dp_bridge_iter_t *iterp);
 lagopus_result_t
 dp_bridge_flow_iter_get(dp_bridge_iter_t iter, struct flow **flowp);
+
+/**
+ * Walk the next chunk of flows of the iterator.
+ *
+ * At most DP_BRIDGE_FLOW_ITER_CHUNK flows are passed to proc, all
+ * under one hold of the flowdb read lock.  The iterator keeps the
+ * priority and seq of the last flow accepted by proc, so flows added or
+ * removed between calls neither shift the walk nor are passed twice,
+ * and a flow failed in proc is passed again on the next call.
+ *
+ * @param[in]   iter    Iterator from dp_bridge_flow_iter_create().
+ * @param[in]   proc    Function called for each flow.
+ * @param[in]   arg     Argument for proc.
+ *
+ * @retval LAGOPUS_RESULT_OK            Succeeded, more flows may follow.
+ * @retval LAGOPUS_RESULT_EOF           Succeeded, no more flows.
+ * @retval LAGOPUS_RESULT_INVALID_ARGS  Failed, invalid argument(s).
+ * @retval others                       Failed, returned from proc.
+ */
+lagopus_result_t
+dp_bridge_flow_iter_walk(dp_bridge_iter_t iter,
+                         dp_bridge_flow_proc_t proc, void *arg);
 void
 dp_bridge_flow_iter_destroy(dp_bridge_iter_t iter);
 
@@ -214,6 +214,16 @@ void lagopus_packet_free(struct lagopus_packet *);
  */
 void lagopus_packet_init(struct lagopus_packet *, void *, struct port *);
 
+/**
+ * Get hash of the flow to dispatch received packet to the worker.
+ *
+ * @param[in]   m       pointer to data of the packet.
+ * @param[in]   seed    hash seed, such as input port number.
+ *
+ * @retval      hash value, same for the packets of the flow.
+ */
+uint32_t lagopus_packet_flow_hash(void *, uint32_t);
+
 /**
  * Send packet to specified OpenFlow port.
  *
@@ -641,6 +651,12 @@ void dp_legacy_sw_thread_fini(void);
  */
 void lagopus_set_action_function(struct action *);
 
+/**
+ * Precompile runs of encap actions in the apply-actions list
+ * into header templates.
+ */
+void lagopus_set_action_list_function(struct action_list *);
+
 /**
  */
 void lagopus_set_instruction_function(struct instruction *);
@@ -221,6 +221,7 @@ typedef struct datastore_bridge_info {
   bool l2_bridge;
   uint32_t mactable_ageing_time;
   uint32_t mactable_max_entries;
+  uint32_t mactable_vlan_max_entries;
 #endif /* HYBRID */
   uint64_t capabilities;          /* flags (DATASTORE_BRIDGE_CAPABILITY_TYPE_*) */
   uint64_t action_types;          /* flags (DATASTORE_BRIDGE_ACTION_TYPE_*) */
@@ -644,6 +645,25 @@ datastore_bridge_get_down_streamq_max_batches(
     const char *name, bool current,
     uint16_t *down_streamq_max_batches);
 
+#ifdef HYBRID
+/**
+ * Get the value to attribute 'mactable_vlan_max_entries' of the bridge
+ * table record'
+ *
+ *  @param[in] name
+ *  @param[in] current
+ *  @param[out] mactable_vlan_max_entries the value of attribute
+ *  'mactable_vlan_max_entries' (0 means no limit)
+ *
+ *  @retval == LAGOPUS_RESULT_OK the attribute 'mactable_vlan_max_entries'
+ *  getted sucessfully.
+ */
+lagopus_result_t
+datastore_bridge_get_mactable_vlan_max_entries(
+    const char *name, bool current,
+    uint32_t *mactable_vlan_max_entries);
+#endif /* HYBRID */
+
 
 /**
  * Get bridge name by dpid.
@@ -18,6 +18,7 @@
 #define __LAGOPUS_DATASTORE_INTERFACE_H__
 
 #include "lagopus_ip_addr.h"
+#include "lagopus/datastore/common.h"
 
 typedef enum datastore_interface_type {
   DATASTORE_INTERFACE_TYPE_UNKNOWN = 0,
@@ -28,10 +29,37 @@ typedef enum datastore_interface_type {
   DATASTORE_INTERFACE_TYPE_NVGRE,
   DATASTORE_INTERFACE_TYPE_VXLAN,
   DATASTORE_INTERFACE_TYPE_VHOST_USER,
+  DATASTORE_INTERFACE_TYPE_BONDING,
   DATASTORE_INTERFACE_TYPE_MIN = DATASTORE_INTERFACE_TYPE_UNKNOWN,
-  DATASTORE_INTERFACE_TYPE_MAX = DATASTORE_INTERFACE_TYPE_VHOST_USER,
+  DATASTORE_INTERFACE_TYPE_MAX = DATASTORE_INTERFACE_TYPE_BONDING,
 } datastore_interface_type_t;
 
+typedef enum datastore_interface_bonding_mode {
+  DATASTORE_INTERFACE_BONDING_MODE_BALANCE_XOR = 0,
+  DATASTORE_INTERFACE_BONDING_MODE_8023AD,
+  DATASTORE_INTERFACE_BONDING_MODE_MIN =
+  DATASTORE_INTERFACE_BONDING_MODE_BALANCE_XOR,
+  DATASTORE_INTERFACE_BONDING_MODE_MAX =
+  DATASTORE_INTERFACE_BONDING_MODE_8023AD,
+} datastore_interface_bonding_mode_t;
+
+typedef enum datastore_interface_xmit_hash_policy {
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER2 = 0,
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER3,
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER34,
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_MIN =
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER2,
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_MAX =
+  DATASTORE_INTERFACE_XMIT_HASH_POLICY_LAYER34,
+} datastore_interface_xmit_hash_policy_t;
+
+typedef enum datastore_interface_lacp_rate {
+  DATASTORE_INTERFACE_LACP_RATE_SLOW = 0,
+  DATASTORE_INTERFACE_LACP_RATE_FAST,
+  DATASTORE_INTERFACE_LACP_RATE_MIN = DATASTORE_INTERFACE_LACP_RATE_SLOW,
+  DATASTORE_INTERFACE_LACP_RATE_MAX = DATASTORE_INTERFACE_LACP_RATE_FAST,
+} datastore_interface_lacp_rate_t;
+
 /**
  * @brief	datastore_interface_eth_dpdk_phy
  */
@@ -355,5 +383,59 @@ lagopus_result_t
 datastore_interface_get_ip_addr_str(const char *name, bool current,
                                     char **ip_addr);
 
+/**
+ * Get the value to attribute 'bonding_mode' of the interface table record'
+ *
+ *  @param[in] name
+ *  @param[in] current
+ *  @param[out] bonding_mode the value of attribute 'bonding_mode'
+ *
+ *  @retval == LAGOPUS_RESULT_OK the attribute 'bonding_mode' getted sucessfully.
+ */
+lagopus_result_t
+datastore_interface_get_bonding_mode(
+    const char *name, bool current,
+    datastore_interface_bonding_mode_t *bonding_mode);
+
+/**
+ * Get the value to attribute 'xmit_hash_policy' of the interface table record'
+ *
+ *  @param[in] name
+ *  @param[in] current
+ *  @param[out] xmit_hash_policy the value of attribute 'xmit_hash_policy'
+ *
+ *  @retval == LAGOPUS_RESULT_OK the attribute 'xmit_hash_policy' getted sucessfully.
+ */
+lagopus_result_t
+datastore_interface_get_xmit_hash_policy(
+    const char *name, bool current,
+    datastore_interface_xmit_hash_policy_t *xmit_hash_policy);
+
+/**
+ * Get the value to attribute 'lacp_rate' of the interface table record'
+ *
+ *  @param[in] name
+ *  @param[in] current
+ *  @param[out] lacp_rate the value of attribute 'lacp_rate'
+ *
+ *  @retval == LAGOPUS_RESULT_OK the attribute 'lacp_rate' getted sucessfully.
+ */
+lagopus_result_t
+datastore_interface_get_lacp_rate(const char *name, bool current,
+                                  datastore_interface_lacp_rate_t *lacp_rate);
+
+/**
+ * Get the value to attribute 'slave_names' of the interface table record'
+ *
+ *  @param[in] name
+ *  @param[in] current
+ *  @param[out] slave_names the value of attribute 'slave_names'
+ *
+ *  @retval == LAGOPUS_RESULT_OK the attribute 'slave_names' getted sucessfully.
+ */
+lagopus_result_t
+datastore_interface_get_slave_names(const char *name, bool current,
+                                    datastore_name_info_t **slave_names);
+
 #endif /* ! __LAGOPUS_DATASTORE_INTERFACE_H__ */
 
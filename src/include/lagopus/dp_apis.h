@@ -146,6 +146,102 @@ dp_interface_stats_get(const char *name,
 lagopus_result_t
 dp_interface_stats_clear(const char *name);
 
+/*
+ * bonding API
+ */
+
+/**
+ * Bonding mode.
+ */
+enum dp_bonding_mode {
+  DP_BONDING_MODE_BALANCE_XOR,  /**< static aggregation of link up slaves. */
+  DP_BONDING_MODE_8023AD,       /**< dynamic aggregation by LACP. */
+};
+
+/**
+ * Transmit hash policy of bonding.
+ */
+enum dp_bonding_xmit_hash {
+  DP_BONDING_XMIT_HASH_L2,      /**< ethernet header. */
+  DP_BONDING_XMIT_HASH_L3,      /**< ethernet and IP headers. */
+  DP_BONDING_XMIT_HASH_L34,     /**< ethernet, IP and L4 headers. */
+};
+
+/**
+ * Make interface a bond.
+ *
+ * @param[in]   name            Name of interface.
+ * @param[in]   mode            Bonding mode.
+ * @param[in]   xmit_hash       Transmit hash policy.
+ *
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Interface is not exist.
+ * @retval      LAGOPUS_RESULT_ALREADY_EXISTS   Interface is already bond.
+ * @retval      LAGOPUS_RESULT_BUSY             Interface is slave.
+ * @retval      LAGOPUS_RESULT_NO_MEMORY        Memory exhausted.
+ *
+ * Interface should be created by dp_interface_create and not
+ * configured by dp_interface_info_set.  Output to the port associated
+ * with the bond is distributed to active slaves.
+ */
+lagopus_result_t
+dp_bonding_create(const char *name,
+                  enum dp_bonding_mode mode,
+                  enum dp_bonding_xmit_hash xmit_hash);
+
+/**
+ * Release all slaves and make bond normal interface.
+ *
+ * @param[in]   name            Name of interface.
+ *
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Interface is not exist.
+ * @retval      LAGOPUS_RESULT_INVALID_OBJECT   Interface is not bond.
+ */
+lagopus_result_t
+dp_bonding_destroy(const char *name);
+
+/**
+ * Add slave interface to bond.
+ *
+ * @param[in]   name            Name of bond interface.
+ * @param[in]   slave           Name of slave interface.
+ *
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Interface is not exist.
+ * @retval      LAGOPUS_RESULT_INVALID_OBJECT   Interface is not bond.
+ * @retval      LAGOPUS_RESULT_BUSY             Slave is used by others.
+ * @retval      LAGOPUS_RESULT_TOO_MANY_OBJECTS Too many slaves.
+ */
+lagopus_result_t
+dp_bonding_slave_add(const char *name, const char *slave);
+
+/**
+ * Delete slave interface from bond.
+ *
+ * @param[in]   name            Name of bond interface.
+ * @param[in]   slave           Name of slave interface.
+ *
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Interface is not exist.
+ * @retval      LAGOPUS_RESULT_INVALID_OBJECT   Interface is not bond.
+ */
+lagopus_result_t
+dp_bonding_slave_delete(const char *name, const char *slave);
+
+/**
+ * Set LACP rate requested to partner.
+ *
+ * @param[in]   name            Name of bond interface.
+ * @param[in]   fast            true for every second, false for 30 seconds.
+ *
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Interface is not exist.
+ * @retval      LAGOPUS_RESULT_INVALID_OBJECT   Interface is not bond.
+ */
+lagopus_result_t
+dp_bonding_lacp_rate_set(const char *name, bool fast);
+
 /*
  * port API
  */
@@ -556,6 +652,27 @@ dp_bridge_mactable_num_entries_get(const char *name, unsigned int *num);
  */
 lagopus_result_t
 dp_bridge_mactable_configs_get(const char *name, uint32_t *ageing_time, uint32_t *max_entries);
+
+/**
+ * Get number of max entries per VLAN of MAC address table.
+ * @param[in]   name         Name of bridge.
+ * @param[out]  max_entries  Number of max entries per VLAN(0 means no limit).
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Bridge is not found.
+ */
+lagopus_result_t
+dp_bridge_mactable_vlan_max_entries_get(const char *name,
+                                        uint32_t *max_entries);
+
+/**
+ * Get number of MAC moves detected in MAC address table.
+ * @param[in]   name         Name of bridge.
+ * @param[out]  moves        Number of MAC moves.
+ * @retval      LAGOPUS_RESULT_OK               Succeeded.
+ * @retval      LAGOPUS_RESULT_NOT_FOUND        Bridge is not found.
+ */
+lagopus_result_t
+dp_bridge_mactable_moves_get(const char *name, uint64_t *moves);
 #endif /* HYBRID */
 
 /*
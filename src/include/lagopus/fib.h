@@ -0,0 +1,217 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ *      @file   fib.h
+ *      @brief  Forwarding Information Base(DIR-24-8) for IPv4 and IPv6.
+ */
+
+#ifndef SRC_INCLUDE_LAGOPUS_FIB_H_
+#define SRC_INCLUDE_LAGOPUS_FIB_H_
+
+#include <netinet/in.h>
+
+#include "lagopus_apis.h"
+#include "lagopus/updater.h"
+
+struct mactable;
+
+#define FIB_TBL24_NUM         (1 << 24) /**< number of tbl24 entries. */
+#define FIB_TBL24_CHUNK_NUM   (1 << 16) /**< tbl24 entries per allocation. */
+#define FIB_TBL24_CHUNKS      (FIB_TBL24_NUM / FIB_TBL24_CHUNK_NUM)
+#define FIB_TBL16_NUM         (1 << 16) /**< number of IPv6 tbl16 entries. */
+#define FIB_TBL8_GROUP_NUM    256       /**< entries in a tbl8 group. */
+#define FIB_TBL8_CHUNK_GROUPS 256       /**< tbl8 groups per allocation. */
+#define FIB_TBL8_MAX_CHUNKS   1024      /**< max tbl8 chunks(262144 groups). */
+#define FIB_ADJACENCY_MAX     65536     /**< max number of adjacencies. */
+
+#define FIB_ADJACENCY_GLEAN   0         /**< adjacency of connected routes. */
+#define FIB_LOOKUP_MISS       UINT32_MAX
+
+/* tbl24/tbl8 entry format. */
+#define FIB_ENTRY_VALID       0x80000000U
+#define FIB_ENTRY_EXT         0x40000000U  /**< index points to tbl8 group. */
+#define FIB_ENTRY_DEPTH_SHIFT 22
+#define FIB_ENTRY_DEPTH_MASK  0x3fc00000U
+#define FIB_ENTRY_INDEX_MASK  0x003fffffU
+
+/**
+ * Adjacency, result of the FIB lookup.
+ * Routes via same nexthop share one adjacency, so that ARP changes
+ * are reflected to all of them at once.
+ */
+struct fib_adjacency {
+  uint32_t version;         /**< sequence counter for lock-free read. */
+  uint32_t refcnt;          /**< number of rules referring this. */
+  int family;               /**< AF_INET or AF_INET6. */
+  struct in_addr nexthop;   /**< nexthop address. */
+  struct in6_addr nexthop6; /**< nexthop address(IPv6). */
+  int ifindex;              /**< i/f index of nexthop. */
+  uint32_t output_port;     /**< output port (OFPP_ALL if unknown). */
+  bool resolved;            /**< dst_mac was resolved by arp. */
+  uint8_t src_mac[UPDATER_ETH_LEN]; /**< mac address of output i/f. */
+  uint8_t dst_mac[UPDATER_ETH_LEN]; /**< mac address of nexthop. */
+  /* followings are used by 'updater' only. */
+  uint32_t mac_next;        /**< next adjacency of same dst_mac. */
+  uint32_t dirty_next;      /**< next adjacency to be resolved. */
+  bool dirty;               /**< linked to the dirty list. */
+};
+
+/**
+ * DIR-24-8 table for IPv4, and tbl16 followed by chain of tbl8 for IPv6.
+ * Written by 'updater' only, and read by workers without lock.
+ */
+struct fib_table {
+  uint32_t *tbl24[FIB_TBL24_CHUNKS];       /**< first level table. */
+  uint32_t *tbl16;                         /**< first level table(IPv6). */
+  uint32_t *tbl8[FIB_TBL8_MAX_CHUNKS];     /**< second level groups. */
+  uint32_t tbl8_ngroups;                   /**< allocated tbl8 groups. */
+  uint32_t *tbl8_free;                     /**< free tbl8 groups. */
+  uint32_t tbl8_nfree;
+  uint32_t *tbl8_pending;                  /**< groups waiting release. */
+  uint32_t tbl8_npending;
+
+  lagopus_hashmap_t rules;                 /**< installed prefixes. */
+  lagopus_hashmap_t rules6;                /**< installed prefixes(IPv6). */
+  lagopus_hashmap_t adjacency_map;         /**< nexthop to adjacency. */
+  lagopus_hashmap_t adjacency_map6;        /**< neighbor to adjacency. */
+  lagopus_hashmap_t ifmac;                 /**< ifindex to mac address. */
+  lagopus_hashmap_t adjacency_mac;         /**< dst_mac to adjacency. */
+
+  struct fib_adjacency *adjacency;         /**< adjacency array. */
+  uint32_t *adjacency_free;                /**< free adjacencies. */
+  uint32_t adjacency_nfree;
+  uint32_t *adjacency_pending;             /**< adjacencies waiting release. */
+  uint32_t adjacency_npending;
+  uint32_t adjacency_dirty;                /**< head of the dirty list. */
+};
+
+/**
+ * Lookup the FIB.
+ * @param[in] fib FIB.
+ * @param[in] addr Destination address in host byte order.
+ * @retval adjacency index or FIB_LOOKUP_MISS.
+ */
+static inline uint32_t
+fib_lookup(const struct fib_table *fib, uint32_t addr) {
+  const uint32_t *chunk;
+  uint32_t entry, index;
+
+  chunk = __atomic_load_n(&fib->tbl24[(addr >> 8) / FIB_TBL24_CHUNK_NUM],
+                          __ATOMIC_ACQUIRE);
+  if (chunk == NULL) {
+    return FIB_LOOKUP_MISS;
+  }
+  entry = __atomic_load_n(&chunk[(addr >> 8) % FIB_TBL24_CHUNK_NUM],
+                          __ATOMIC_ACQUIRE);
+  if ((entry & FIB_ENTRY_EXT) != 0) {
+    index = entry & FIB_ENTRY_INDEX_MASK;
+    entry = __atomic_load_n(&fib->tbl8[index / FIB_TBL8_CHUNK_GROUPS]
+                            [(index % FIB_TBL8_CHUNK_GROUPS) *
+                             FIB_TBL8_GROUP_NUM + (addr & 0xff)],
+                            __ATOMIC_ACQUIRE);
+  }
+  if ((entry & FIB_ENTRY_VALID) == 0) {
+    return FIB_LOOKUP_MISS;
+  }
+  return entry & FIB_ENTRY_INDEX_MASK;
+}
+
+/**
+ * Lookup the FIB for IPv6.
+ * The first 16 bits index tbl16, and each following byte indexes
+ * a tbl8 group while the entry points to the next group.
+ * @param[in] fib FIB.
+ * @param[in] addr Destination address.
+ * @retval adjacency index or FIB_LOOKUP_MISS.
+ */
+static inline uint32_t
+fib6_lookup(const struct fib_table *fib, const struct in6_addr *addr) {
+  const uint8_t *a = addr->s6_addr;
+  uint32_t entry, index;
+  int i = 2;
+
+  entry = __atomic_load_n(&fib->tbl16[(a[0] << 8) | a[1]], __ATOMIC_ACQUIRE);
+  while ((entry & FIB_ENTRY_EXT) != 0) {
+    index = entry & FIB_ENTRY_INDEX_MASK;
+    entry = __atomic_load_n(&fib->tbl8[index / FIB_TBL8_CHUNK_GROUPS]
+                            [(index % FIB_TBL8_CHUNK_GROUPS) *
+                             FIB_TBL8_GROUP_NUM + a[i++]],
+                            __ATOMIC_ACQUIRE);
+  }
+  if ((entry & FIB_ENTRY_VALID) == 0) {
+    return FIB_LOOKUP_MISS;
+  }
+  return entry & FIB_ENTRY_INDEX_MASK;
+}
+
+lagopus_result_t
+fib_init(struct fib_table *fib);
+
+void
+fib_fini(struct fib_table *fib);
+
+lagopus_result_t
+fib_route_add(struct fib_table *fib, struct in_addr *dest, int prefixlen,
+              struct in_addr *gate, int ifindex, uint8_t scope, uint8_t *mac);
+
+lagopus_result_t
+fib_route_delete(struct fib_table *fib, struct in_addr *dest, int prefixlen);
+
+lagopus_result_t
+fib_arp_update(struct fib_table *fib, int ifindex,
+               struct in_addr *ip, uint8_t *mac);
+
+lagopus_result_t
+fib_arp_delete(struct fib_table *fib, struct in_addr *ip);
+
+void
+fib_ifaddr_update(struct fib_table *fib, int ifindex, uint8_t *mac);
+
+void
+fib_lookup_bulk(const struct fib_table *fib, const uint32_t *addrs,
+                uint32_t *indexes, unsigned int n);
+
+lagopus_result_t
+fib6_route_add(struct fib_table *fib, struct in6_addr *dest, int prefixlen,
+               struct in6_addr *gate, int ifindex, uint8_t *mac);
+
+lagopus_result_t
+fib6_route_delete(struct fib_table *fib, struct in6_addr *dest,
+                  int prefixlen);
+
+lagopus_result_t
+fib6_ndp_update(struct fib_table *fib, int ifindex,
+                struct in6_addr *ip, uint8_t *mac);
+
+lagopus_result_t
+fib6_ndp_delete(struct fib_table *fib, int ifindex, struct in6_addr *ip);
+
+void
+fib6_lookup_bulk(const struct fib_table *fib, const struct in6_addr *addrs,
+                 uint32_t *indexes, unsigned int n);
+
+void
+fib_adjacency_get(const struct fib_table *fib, uint32_t index,
+                  struct fib_adjacency *adj);
+
+void
+fib_adjacency_resolve(struct fib_table *fib, struct mactable *mactable);
+
+void
+fib_reclaim(struct fib_table *fib);
+
+#endif /* SRC_INCLUDE_LAGOPUS_FIB_H_ */
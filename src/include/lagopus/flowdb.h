@@ -26,6 +26,11 @@
 #include "openflow.h"
 #include "ofcache.h"
 
+#ifdef HAVE_DPDK
+#include "rte_config.h"
+#include "rte_cycles.h"
+#endif /* HAVE_DPDK */
+
 struct channel;
 struct bridge;
 struct lagopus_packet;
@@ -33,6 +38,7 @@ struct flow_stats_list;
 struct table_stats_list;
 struct table_features_list;
 struct group_table;
+struct encap_template;
 
 /**
  * @brief Match structure.
@@ -71,6 +77,7 @@ struct action {
   uint64_t cookie;              /** cookie for packet_in */
   int flags;
   struct ed_prop_list ed_prop_list;
+  struct encap_template *encap_template; /** prebuilt encap headers */
   struct ofp_action_header ofpat;
 };
 
@@ -185,6 +192,8 @@ struct flow {
   struct timespec update_time;                  /** Last updated time. */
   struct flow **flow_timer;                     /** Back reference to entry
                                                  ** of the flow timer. */
+  uint64_t seq;                                 /** Order added to the
+                                                 ** table. */
 
 };
 
@@ -198,6 +207,7 @@ enum action_flag {
 
 struct flowinfo;
 struct thtable;
+struct flow_index;
 
 /**
  * @brief List of flow entries.
@@ -256,6 +266,8 @@ struct table {
                                                                 ** type. */
   struct ofp_table_features features;   /** Features. */
   void *userdata;               /** userdata used in dataplane */
+  struct flow_index *flow_index;        /** Index for flow-mod. */
+  uint64_t flow_seq;            /** Last seq given to a flow. */
 };
 
 
@@ -268,8 +280,40 @@ enum switch_mode {
 };
 
 struct flowdb;
+struct flowdb_batch;
+
+#ifndef FLOWDB_FLOW_STATS_CHUNK
+#define FLOWDB_FLOW_STATS_CHUNK 1000
+#endif /* FLOWDB_FLOW_STATS_CHUNK */
+
+/**
+ * @brief Position of a chunked flow stats walk.
+ *
+ * Zero-initialize before the first call of flowdb_flow_stats_iterate().
+ * The walk resumes after the last visited flow by its priority and
+ * order of addition, so flows added or deleted between the calls
+ * neither shift the walk nor are reported twice.
+ */
+struct flowdb_flow_stats_cursor {
+  int table_id;                 /** Table being visited. */
+  int32_t priority;             /** Priority of the last visited flow. */
+  uint64_t seq;                 /** seq of the last visited flow,
+                                 ** 0 if none in the table. */
+  bool done;                    /** All tables have been visited. */
+};
+
+/**
+ * Called for each matched flow with the flowdb read-locked.
+ * The lists belong to the flow and must not be modified or kept.
+ */
+typedef lagopus_result_t
+(*flowdb_flow_stats_proc_t)(struct ofp_flow_stats *ofp,
+                            struct match_list *match_list,
+                            struct instruction_list *instruction_list,
+                            void *arg);
 
 void (*lagopus_register_action_hook)(struct action *);
+void (*lagopus_register_action_list_hook)(struct action_list *);
 void (*lagopus_register_instruction_hook)(struct instruction *);
 void (*lagopus_add_flow_hook)(struct flow *, struct table *);
 void (*lagopus_del_flow_hook)(struct flow *, struct table *);
@@ -377,6 +421,92 @@ flowdb_flow_delete(struct bridge *bridge,
                    struct match_list *match_list,
                    struct ofp_error *error);
 
+/**
+ * Begin batch of flow mods for the bridge.
+ *
+ * @param[in]   bridge  Bridge.
+ * @param[out]  batchp  Allocated batch.
+ *
+ * @retval LAGOPUS_RESULT_OK            Succeeded.
+ * @retval LAGOPUS_RESULT_INVALID_ARGS  Failed, invalid argument(s).
+ * @retval LAGOPUS_RESULT_NO_MEMORY     Failed, no memory.
+ */
+lagopus_result_t
+flowdb_flow_batch_begin(struct bridge *bridge, struct flowdb_batch **batchp);
+
+/**
+ * Queue flow mod (add, modify or delete) to the batch.
+ * Entries of match_list and instruction_list are moved to the batch.
+ * error is set by flowdb_flow_batch_commit(), so it must be valid
+ * until the batch is committed.
+ *
+ * @param[in]   batch   Batch.
+ * @param[in]   flow_mod        ofp_flow_mod structure of the flow.
+ * @param[in]   match_list      list of match structures.
+ * @param[in]   instruction_list        list of instruction structures,
+ *                                      NULL for delete.
+ * @param[out]  error   OFP_ERROR value.
+ *
+ * @retval LAGOPUS_RESULT_OK            Succeeded.
+ * @retval LAGOPUS_RESULT_INVALID_ARGS  Failed, invalid argument(s).
+ * @retval LAGOPUS_RESULT_NO_MEMORY     Failed, no memory.
+ */
+lagopus_result_t
+flowdb_flow_batch_add(struct flowdb_batch *batch,
+                      struct ofp_flow_mod *flow_mod,
+                      struct match_list *match_list,
+                      struct instruction_list *instruction_list,
+                      struct ofp_error *error);
+
+/**
+ * Commit the batch.
+ * All entries are examined first, then applied in order under
+ * a single write lock of the flowdb, followed by a single flow cache
+ * flush.  If atomic is true, nothing is applied when any entry fails
+ * the examination, and applying stops at the first failed entry.
+ * Entries already applied are not rolled back.
+ *
+ * @param[in]   batch   Batch.
+ * @param[in]   atomic  Stop at the first failure.
+ *
+ * @retval LAGOPUS_RESULT_OK            All entries succeeded.
+ * @retval LAGOPUS_RESULT_INVALID_ARGS  Failed, invalid argument(s).
+ * @retval LAGOPUS_RESULT_OFP_ERROR     Failed with OFP error message,
+ *                                      see flowdb_flow_batch_result_get().
+ */
+lagopus_result_t
+flowdb_flow_batch_commit(struct flowdb_batch *batch, bool atomic);
+
+/**
+ * Get number of entries in the batch.
+ *
+ * @param[in]   batch   Batch.
+ */
+size_t
+flowdb_flow_batch_count(struct flowdb_batch *batch);
+
+/**
+ * Get result of the n-th entry of the committed batch.
+ *
+ * @param[in]   batch   Batch.
+ * @param[in]   n       Index of the entry in queued order.
+ *
+ * @retval LAGOPUS_RESULT_OK            Applied.
+ * @retval LAGOPUS_RESULT_NOT_STARTED   Not applied by atomic commit.
+ * @retval LAGOPUS_RESULT_INVALID_ARGS  Failed, invalid argument(s).
+ * @retval LAGOPUS_RESULT_OFP_ERROR     Failed with OFP error message.
+ */
+lagopus_result_t
+flowdb_flow_batch_result_get(struct flowdb_batch *batch, size_t n);
+
+/**
+ * Free the batch.
+ *
+ * @param[in]   batch   Batch.
+ */
+void
+flowdb_flow_batch_free(struct flowdb_batch *batch);
+
 /**
  * Get stats of flows from the flow database.
  *
@@ -398,6 +528,36 @@ flowdb_flow_stats(struct flowdb *flowdb,
                   struct flow_stats_list *flow_stats_list,
                   struct ofp_error *error);
 
+/**
+ * Walk stats of flows in the flow database, one chunk per call.
+ *
+ * At most FLOWDB_FLOW_STATS_CHUNK flows are examined per call, all
+ * under one hold of the read lock.  Call repeatedly until
+ * cursor->done is set.  Flows added or removed between calls neither
+ * shift the walk nor are reported twice, see
+ * struct flowdb_flow_stats_cursor.
+ *
+ * @param[in]   flowdb  Flow database.
+ * @param[in]   request ofp_flow_stats_request structure of the flow.
+ * @param[in]   match_list list of match structures.
+ * @param[in,out] cursor Walk position.
+ * @param[in]   proc    Function called for each matched flow.
+ * @param[in]   arg     Argument for proc.
+ * @param[out]  error   OFP_ERROR value.
+ *
+ * @retval LAGOPUS_RESULT_OK            Succeeded.
+ * @retval LAGOPUS_RESULT_INVALID_ARGS  Failed, invalid argument(s).
+ * @retval others                       Failed, returned from proc.
+ */
+lagopus_result_t
+flowdb_flow_stats_iterate(struct flowdb *flowdb,
+                          struct ofp_flow_stats_request *request,
+                          struct match_list *match_list,
+                          struct flowdb_flow_stats_cursor *cursor,
+                          flowdb_flow_stats_proc_t proc,
+                          void *arg,
+                          struct ofp_error *error);
+
 /**
  * Get aggregated stats of flows from the flow database.
  *
@@ -440,6 +600,22 @@ flowdb_get_table_features(struct flowdb *,
 lagopus_result_t
 flow_add_sub(struct flow *flow, struct flow_list *flows);
 
+/**
+ * Position of the first flow after the given one in flow list.
+ *
+ * A walk keeping priority and seq of the last visited flow resumes
+ * there, even if flows were added or removed in the meantime.
+ *
+ * @param[in]   flow_list       Flow list.
+ * @param[in]   priority        Priority of the last visited flow.
+ * @param[in]   seq             seq of the last visited flow, 0 if none.
+ *
+ * @retval      Index of the next flow, flow_list->nflow if no more.
+ */
+int
+flow_list_resume_position(struct flow_list *flow_list,
+                          int32_t priority, uint64_t seq);
+
 /**
  * Dump flow as human readable.
  *
@@ -516,6 +692,99 @@ get_current_time(void) {
   return ts;
 }
 
+/**
+ * Per-thread coarse clock for per-packet bookkeeping.
+ * Datapath threads refresh it by dp_clock_update() once per received
+ * burst, and read it instead of clock_gettime() or TSC per packet.
+ */
+struct dp_clock {
+  uint64_t tsc;                 /** cycle counter at the last update. */
+  uint64_t base_tsc;            /** cycle counter at base. */
+  struct timespec base;         /** CLOCK_MONOTONIC at base_tsc. */
+  struct timespec now;          /** time at the last update. */
+};
+
+extern __thread struct dp_clock dp_clock;
+extern uint64_t dp_clock_hz;    /** cycles per second, 0 if unknown. */
+extern uint64_t dp_clock_mult;  /** nsec per cycle, 32.32 fixed point. */
+
+/**
+ * Read cycle counter.
+ */
+static inline uint64_t
+dp_clock_cycles(void) {
+#ifdef HAVE_DPDK
+  return rte_rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif /* HAVE_DPDK */
+}
+
+/**
+ * Measure frequency of the cycle counter.
+ */
+void dp_clock_calibrate(void);
+
+/**
+ * Refresh cached clock of the current thread.
+ * Cycles are converted by the calibrated multiplier, and rebased to
+ * CLOCK_MONOTONIC every second to bound the error.
+ * The cached time never goes backward, neither across a rebase nor
+ * between two rebases.
+ */
+static inline void
+dp_clock_update(void) {
+  struct timespec ts;
+  uint64_t tsc, delta, nsec;
+
+  tsc = dp_clock_cycles();
+  delta = tsc - dp_clock.base_tsc;
+  if (unlikely(dp_clock.base_tsc == 0 || delta >= dp_clock_hz)) {
+    clock_gettime(CLOCK_MONOTONIC, &dp_clock.base);
+    dp_clock.base_tsc = tsc;
+    ts = dp_clock.base;
+  } else {
+    nsec = (uint64_t)dp_clock.base.tv_nsec + ((delta * dp_clock_mult) >> 32);
+    ts.tv_sec = dp_clock.base.tv_sec + (time_t)(nsec / 1000000000);
+    ts.tv_nsec = (long)(nsec % 1000000000);
+  }
+  /* keep the later of the cached and the new time. */
+  if (ts.tv_sec > dp_clock.now.tv_sec ||
+      (ts.tv_sec == dp_clock.now.tv_sec &&
+       ts.tv_nsec > dp_clock.now.tv_nsec)) {
+    dp_clock.now = ts;
+  }
+  dp_clock.tsc = tsc;
+}
+
+/**
+ * Get time cached by dp_clock_update().
+ * Same as get_current_time() if the thread never updated the clock.
+ */
+static inline struct timespec
+get_cached_time(void) {
+  if (unlikely(dp_clock.base_tsc == 0)) {
+    return get_current_time();
+  }
+  return dp_clock.now;
+}
+
+/**
+ * Get cycle counter cached by dp_clock_update().
+ */
+static inline uint64_t
+dp_clock_tsc(void) {
+  if (unlikely(dp_clock.base_tsc == 0)) {
+    return dp_clock_cycles();
+  }
+  return dp_clock.tsc;
+}
+
 /**
  * initialize flow timer related structure.
  */
@@ -44,6 +44,7 @@
 struct port;
 struct dp_tap_interface;
 struct lagopus_packet;
+struct bonding;
 
 typedef datastore_queue_info_t dp_queue_info_t;
 
@@ -96,6 +97,8 @@ struct interface {
   struct ip_address_info addr_info; /* ip address informations. */
   lagopus_hashmap_t queueid_hashmap;
   struct interface **link_timer;
+  struct bonding *bond;             /* non-NULL if bond interface. */
+  struct interface *master;         /* bond interface if enslaved. */
 };
 
 struct interface *dp_interface_alloc(void);
@@ -138,6 +141,8 @@ dp_interface_stats_get_internal(struct interface *ifp,
                                 datastore_interface_stats_t *stats);
 lagopus_result_t
 dp_interface_stats_clear_internal(struct interface *ifp);
+lagopus_result_t
+dp_interface_link_status_get_internal(struct interface *ifp, bool *link_up);
 
 lagopus_result_t dp_interface_queue_configure(struct interface *ifp);
 lagopus_result_t
@@ -150,6 +155,7 @@ lagopus_result_t dpdk_unconfigure_interface(struct interface *ifp);
 lagopus_result_t dpdk_start_interface(uint8_t portid);
 lagopus_result_t dpdk_stop_interface(uint8_t portid);
 lagopus_result_t dpdk_get_hwaddr(uint8_t portid, uint8_t hw_addr[]);
+lagopus_result_t dpdk_get_link_status(uint8_t portid, bool *link_up);
 lagopus_result_t
 dpdk_get_stats(uint8_t portid, datastore_interface_stats_t *stats);
 lagopus_result_t dpdk_clear_stats(uint8_t portid);
@@ -169,6 +175,8 @@ lagopus_result_t rawsock_start_interface(struct interface *ifp);
 lagopus_result_t rawsock_stop_interface(struct interface *ifp);
 lagopus_result_t rawsock_get_hwaddr(struct interface *ifp, uint8_t hw_addr[]);
 lagopus_result_t
+rawsock_get_link_status(struct interface *ifp, bool *link_up);
+lagopus_result_t
 rawsock_get_stats(struct interface *ifp, datastore_interface_stats_t *stats);
 lagopus_result_t rawsock_clear_stats(struct interface *ifp);
 lagopus_result_t
@@ -28,6 +28,27 @@
 /* ether addr history size */
 #define MACTABLE_HISTORY_MAX_NUM (10)
 
+/* number of entries in a bucket of the lookup table. */
+#define MACTABLE_BUCKET_ENTRIES (4)
+
+/* max length of a cuckoo displacement path. */
+#define MACTABLE_CUCKOO_MAX_DEPTH (128)
+
+/* number of VLAN IDs. */
+#define MACTABLE_VLAN_MAX (4096)
+
+/* number of ageing buckets(1 second per bucket). */
+#define MACTABLE_AGE_BUCKETS (256)
+
+/* untagged addresses recorded as changed, more changes mean all changed. */
+#ifndef MACTABLE_CHANGED_MAX
+#define MACTABLE_CHANGED_MAX (256)
+#endif /* MACTABLE_CHANGED_MAX */
+
+/* key of the lookup table, VLAN ID and MAC address. */
+#define MACTABLE_KEY(vid, inteth) \
+  (((uint64_t)((vid) & (MACTABLE_VLAN_MAX - 1)) << 48) | (inteth))
+
 /**
  * Address type.
  */
@@ -40,26 +61,58 @@ enum address_type {
  * Local data for each worker.
  */
 struct local_data {
-  lagopus_hashmap_t localcache;
   lagopus_bbq_t bbq;
   uint64_t eth_history[MACTABLE_HISTORY_MAX_NUM];
   uint16_t history_index;
-  uint32_t referred_table;
+  uint32_t referred_generation;
   uint16_t referring;
 } __attribute__ ((aligned(128)));
 
 /**
  * MAC address entry.
+ * Owned by the 'updater', used for ageing and datastore queries.
  */
 struct macentry {
   TAILQ_ENTRY(macentry) next;
   uint64_t inteth; /**< Ethernet address.*/
+  uint16_t vid; /**< VLAN ID(0 means untagged). */
   uint32_t portid; /**< Port number(ofp port no). */
   struct timespec update_time; /**< Referring to the time this entry to the last. */
   uint16_t address_type; /**< Setting address type. */
+  uint16_t age_bucket; /**< Index of ageing bucket. */
+  uint32_t moves; /**< Number of detected MAC moves. */
   lagopus_rwlock_t lock; /**< Read-write lock for mactable entry. */
 };
 
+/**
+ * Entry of the lookup table read by workers.
+ */
+struct macslot {
+  uint64_t key;          /**< VLAN ID and Ethernet address(0 means empty). */
+  uint32_t portid;       /**< Port number(ofp port no). */
+  uint16_t address_type; /**< Setting address type. */
+};
+
+/**
+ * Bucket of the lookup table.
+ * version is odd while the 'updater' is writing to the bucket.
+ */
+struct macbucket {
+  uint32_t version;
+  struct macslot slot[MACTABLE_BUCKET_ENTRIES];
+};
+
+/**
+ * Cuckoo hash table for MAC address lookup.
+ * Only 'updater' writes, workers read without any lock.
+ */
+struct mactable_cuckoo {
+  uint32_t mask;                    /**< Number of buckets - 1. */
+  uint32_t move_version;            /**< Odd while displacing entries. */
+  struct mactable_cuckoo *retired;  /**< Next retired table. */
+  struct macbucket bucket[0];
+};
+
 /**
  * MAC address table.
  */
@@ -70,10 +123,22 @@ struct mactable {
   uint32_t ageing_time;         /**< Aging time(default 300sec). */
   unsigned int nentries;        /**< Current number of entries in this table. */
 
-  lagopus_hashmap_t hashmap[2]; /**< Hashmap for MAC address table. */
-  uint32_t read_table;          /**< Current read table index. */
+  struct mactable_cuckoo *table;   /**< Lookup table for workers. */
+  struct mactable_cuckoo *retired; /**< Tables waiting for release. */
+  uint32_t generation;          /**< Incremented at each update. */
+
+  lagopus_hashmap_t entries;    /**< MAC address entries(for 'updater'). */
+  /** Dynamic entries bucketed by the second of expiry. */
+  TAILQ_HEAD(macentry_list, macentry) age_bucket[MACTABLE_AGE_BUCKETS];
+  time_t age_scanned;           /**< Last second scanned for ageing. */
+  uint32_t age_time;            /**< Ageing time used for age_bucket. */
 
-  TAILQ_HEAD(macentry_list, macentry) macentry_list; /**< MAC address entry list. */
+  uint32_t vlan_maxentries;     /**< Max number of entries per VLAN(0: no limit). */
+  uint32_t vlan_nentries[MACTABLE_VLAN_MAX]; /**< Number of entries per VLAN. */
+  uint64_t nmoves;              /**< Number of detected MAC moves. */
+  /** Untagged addresses whose port was changed, for FIB adjacencies. */
+  uint64_t changed[MACTABLE_CHANGED_MAX];
+  uint32_t nchanged;            /**< > MACTABLE_CHANGED_MAX: overflowed. */
 
   struct local_data local[UPDATER_LOCALDATA_MAX_NUM];
 };
@@ -100,8 +165,8 @@ mactable_fini(struct mactable *mactable);
 
 /**
  * Update mac address table by timer('updater').
- * Entry data are written to the writing mac table by only 'updater'.
- * They are merged read mac table and bbq.
+ * Entries queued in bbq by workers are applied to the lookup table
+ * by only 'updater', then expired entries are removed.
  * @param[in] mactable MAC address table object.
  */
 lagopus_result_t
@@ -109,6 +174,7 @@ mactable_update(struct mactable *mactable);
 
 /**
  * Learning mac address and input port number when packet handling.
+ * Addresses are learned per VLAN ID of the packet.
  * This function is called from l3 routing function in interface.c.
  * @param[in] pkt Packet data.
  */
@@ -119,12 +185,40 @@ mactable_port_learning(struct lagopus_packet *pkt);
  * Look up output port in mac address table when packet handling.
  * This function is called from l3 routing function in interface.c.
  * @param[in] pkt Packet data.
- * @retval    !=OFPP_ALL  Output port number.
- * @retval    ==OFPP_ALL  No corresponding data, packet will be flooding.
+ * @retval    !=OFPP_FLOOD  Output port number.
+ * @retval    ==OFPP_FLOOD  No corresponding data, packet will be flooding.
  */
 void
 mactable_port_lookup(struct lagopus_packet *pkt);
 
+/**
+ * Get output port of the mac address without refreshing the entry.
+ * This function is called from 'updater' to resolve FIB adjacencies.
+ * @param[in] mactable MAC address table object.
+ * @param[in] vid VLAN ID.
+ * @param[in] ethaddr MAC address.
+ * @retval    !=OFPP_ALL  Output port number.
+ * @retval    ==OFPP_ALL  No corresponding data.
+ */
+uint32_t
+mactable_port_get(struct mactable *mactable,
+                  uint16_t vid,
+                  const uint8_t ethaddr[]);
+
+/**
+ * Call proc for untagged mac addresses whose output port was changed
+ * since the last call, and forget them('updater' only).
+ * @param[in] mactable MAC address table object.
+ * @param[in] proc Function called with the mac address.
+ * @param[in] arg Argument of proc.
+ * @retval    true   proc was called for all changed addresses.
+ * @retval    false  Too many changes, any address may have changed.
+ */
+bool
+mactable_changed_iterate(struct mactable *mactable,
+                         void (*proc)(const uint8_t *ethaddr, void *arg),
+                         void *arg);
+
 /**
  * Clear all entries in mactable.
  * @param[in] mactable MAC address table.
@@ -144,6 +238,7 @@ mactable_entry_delete(struct mactable *mactable, const uint8_t ethaddr[]);
 
 /**
  * Update entry informations.
+ * Static entry is registered to untagged(VLAN ID 0) table.
  * @param[in] mactable MAC address table.
  * @param[in] ethaddr MAC address.
  * @param[in] portid Port number that corresponding to MAC address.
@@ -152,6 +247,25 @@ mactable_entry_delete(struct mactable *mactable, const uint8_t ethaddr[]);
 lagopus_result_t
 mactable_entry_update(struct mactable *mactable, const uint8_t ethaddr[], uint32_t portid);
 
+/**
+ * Get number of entries.
+ * @param[in] mactable MAC address table.
+ * @retval    Number of entries.
+ */
+unsigned int
+mactable_num_entries_get(struct mactable *mactable);
+
+/**
+ * Get entries.
+ * @param[in] mactable MAC address table.
+ * @param[out] entries MAC address entries.
+ * @param[in] num Number of entries.
+ * @retval    LAGOPUS_RESULT_OK               Succeeded.
+ */
+lagopus_result_t
+mactable_entries_get(struct mactable *mactable,
+                     struct macentry *entries, unsigned int num);
+
 /**
  * Get number of max entries.
  * @param[in] mactable MAC address table.
@@ -160,6 +274,22 @@ mactable_entry_update(struct mactable *mactable, const uint8_t ethaddr[], uint32
 uint32_t
 mactable_max_entries_get(struct mactable *mactable);
 
+/**
+ * Get number of max entries per VLAN.
+ * @param[in] mactable MAC address table.
+ * @retval    Number of max entries per VLAN(0 means no limit).
+ */
+uint32_t
+mactable_vlan_max_entries_get(struct mactable *mactable);
+
+/**
+ * Get number of detected MAC moves.
+ * @param[in] mactable MAC address table.
+ * @retval    Number of MAC moves.
+ */
+uint64_t
+mactable_moves_get(struct mactable *mactable);
+
 /**
  * Get ageing time.
  * @param[in] mactable MAC address table.
@@ -179,6 +309,14 @@ mactable_ageing_time_get(struct mactable *mactable);
 void
 mactable_max_entries_set(struct mactable *mactable, uint32_t max_entries);
 
+/**
+ * Set num of max entries per VLAN.
+ * @param[in] mactable MAC address table.
+ * @param[in] max_entries Number of max entries per VLAN(0 means no limit).
+ */
+void
+mactable_vlan_max_entries_set(struct mactable *mactable, uint32_t max_entries);
+
 /**
  * Set ageing time.
  * @param[in] mactable MAC address table.
@@ -133,6 +133,15 @@ lagopus_result_t
 ofp_bridgeq_mgr_bridge_lookup(uint64_t dpid,
                               struct ofp_bridgeq **bridgeq);
 
+/**
+ * Get generation of bridgeqs, it is changed whenever
+ * bridges are registered or unregistered.
+ *
+ *     @retval	generation
+ */
+uint64_t
+ofp_bridgeq_mgr_generation_get(void);
+
 /**
  * Get array of bridgeqs.
  *
@@ -99,6 +99,22 @@ ofp_flow_mod_delete(uint64_t dpid,
                     struct ofp_flow_mod *flow_mod,
                     struct match_list *match_list,
                     struct ofp_error *error);
+
+/**
+ * Begin batch of \b OFPT_FLOW_MOD for the datapath.
+ *
+ *     @param[in]	dpid	Datapath id.
+ *     @param[out]	batchp	A pointer to allocated batch.
+ *
+ *     @retval	LAGOPUS_RESULT_OK	Succeeded.
+ *     @retval	LAGOPUS_RESULT_ANY_FAILURES	Failed.
+ *
+ *     @details	Queue flow mods by \e flowdb_flow_batch_add(), apply
+ *     them by \e flowdb_flow_batch_commit(), then release by
+ *     \e flowdb_flow_batch_free().
+ */
+lagopus_result_t
+ofp_flow_mod_batch_begin(uint64_t dpid, struct flowdb_batch **batchp);
 /* FlowMod END */
 
 #endif /* __LAGOPUS_OFP_FLOW_MOD_APIS_H__ */
@@ -65,6 +65,13 @@ ofp_handler_finalize(void);
 lagopus_result_t
 ofp_handler_get_channelq(lagopus_bbq_t **retptr);
 
+/**
+ * get channelq of the thread serving the bridge from ofp-handler
+ */
+lagopus_result_t
+ofp_handler_get_channelq_by_dpid(uint64_t dpid,
+                                 lagopus_bbq_t **retptr);
+
 /**
  * put eventq_data for event_dataq
  */
@@ -157,6 +164,37 @@ ofp_handler_channelq_size_set(uint16_t val);
 void
 ofp_handler_channelq_max_batches_set(uint16_t val);
 
+/* max ofp_handler threads. */
+#ifndef OFPH_MAX_WORKERS
+#define OFPH_MAX_WORKERS 16
+#endif /* OFPH_MAX_WORKERS */
+
+/* default ofp_handler threads. */
+#ifndef OFPH_DEFAULT_WORKERS
+#define OFPH_DEFAULT_WORKERS 1
+#endif /* OFPH_DEFAULT_WORKERS */
+
+/**
+ * Set number of ofp_handler threads, bridges are assigned to them
+ * by dpid. It takes effect at the next ofp_handler_start().
+ * Set by the --ofp-handler-workers option of lagopus, the default is
+ * OFPH_DEFAULT_WORKERS.
+ *
+ *     @param[in]	val	val
+ *
+ *     @retval	void
+ */
+void
+ofp_handler_workers_set(uint16_t val);
+
+/**
+ * Get number of ofp_handler threads.
+ *
+ *     @retval	workers
+ */
+uint16_t
+ofp_handler_workers_get(void);
+
 /**
  * Get channelq_size.
  *
@@ -68,6 +68,35 @@ ofp_flow_stats_get(uint64_t dpid,
                    struct match_list *match_list,
                    struct flow_stats_list *flow_stats_list,
                    struct ofp_error *error);
+
+/**
+ * Walk flow statistics for \b OFPMP_FLOW, one chunk per call.
+ *
+ *     @param[in]	dpid	Datapath id.
+ *     @param[in]	flow_stats_request	A pointer to \e ofp_flow_stats_request
+ *     structure.
+ *     @param[in]       match_list      A pointer to list of match.
+ *     @param[in,out]	cursor	A pointer to zero-initialized walk position.
+ *     @param[in]	proc	Function called for each matched flow.
+ *     @param[in]	arg	Argument for \e proc.
+ *     @param[out]	error	A pointer to \e ofp_error structure.
+ *     If errors occur, set filed values.
+ *
+ *     @retval	LAGOPUS_RESULT_OK	Succeeded.
+ *     @retval	LAGOPUS_RESULT_NOT_FOUND	Failed, bridge not found.
+ *     @retval	LAGOPUS_RESULT_ANY_FAILURES	Failed.
+ *
+ *     @details	Nothing is copied, \e proc encodes the flow while the
+ *     flow database is read-locked.  Repeat until \e cursor->done is set.
+ */
+lagopus_result_t
+ofp_flow_stats_iterate(uint64_t dpid,
+                       struct ofp_flow_stats_request *flow_stats_request,
+                       struct match_list *match_list,
+                       struct flowdb_flow_stats_cursor *cursor,
+                       flowdb_flow_stats_proc_t proc,
+                       void *arg,
+                       struct ofp_error *error);
 /* Multipart - Flow Stats END */
 
 /* Multipart - Queue stats */
@@ -31,6 +31,16 @@
 /* pbuf unused buffer try get count. */
 #define PBUF_TRY_COUNT     5
 
+/* Max # of the free buffers per size class a thread keeps. */
+#ifndef PBUF_CACHE_DEPTH
+#define PBUF_CACHE_DEPTH        8
+#endif /* PBUF_CACHE_DEPTH */
+
+/* Max # of the free buffers per size class shared by the threads. */
+#ifndef PBUF_DEPOT_DEPTH
+#define PBUF_DEPOT_DEPTH        32
+#endif /* PBUF_DEPOT_DEPTH */
+
 struct pbuf {
   /* Linked list entry. */
   TAILQ_ENTRY(pbuf) entry;
@@ -55,6 +65,18 @@ struct pbuf {
   uint8_t data[];
 };
 
+/* pbuf cache statistics. */
+struct pbuf_cache_stats {
+  /* Allocations served from the caches. */
+  uint64_t hits;
+
+  /* Allocations that went to malloc. */
+  uint64_t misses;
+
+  /* Buffers in the depot. */
+  uint64_t depot;
+};
+
 /* for save pbuf info. */
 typedef struct pbuf pbuf_info_t;
 
@@ -179,6 +201,12 @@ pbuf_free(struct pbuf *pbuf);
 void
 pbuf_reset(struct pbuf *pbuf);
 
+void
+pbuf_cache_stats_get(struct pbuf_cache_stats *stats);
+
+void
+pbuf_cache_purge(void);
+
 ssize_t
 pbuf_read(struct pbuf *pbuf, int sock);
 
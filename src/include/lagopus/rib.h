@@ -26,13 +26,17 @@
 
 #include "lagopus/route.h"
 #include "lagopus/arp.h"
+#include "lagopus/fib.h"
 #include "lagopus/updater.h"
 
 /* for queue entry(netlink notification) */
 enum msg_type {
   NOTIFICATION_TYPE_IFADDR = 0,
   NOTIFICATION_TYPE_ARP,
-  NOTIFICATION_TYPE_ROUTE
+  NOTIFICATION_TYPE_ROUTE,
+  NOTIFICATION_TYPE_NDP,
+  NOTIFICATION_TYPE_ROUTE6,
+  NOTIFICATION_TYPE_BATCH
 };
 
 enum action_type {
@@ -61,10 +65,32 @@ struct notification_route_entry {
   struct in_addr gate;      /* Nexthop address. */
   int ifindex;              /* Nexthop interface index. */
   uint8_t scope;            /* Scope of interface. */
-  uint32_t prefixlen;       /* Prefix length. */
+  int prefixlen;            /* Prefix length. */
   uint8_t mac[UPDATER_ETH_LEN]; /* mac address for i/f with ifindex. */
 } __attribute__ ((aligned(128)));
 
+/* ndp entry for queue */
+struct notification_ndp_entry {
+  int ifindex;              /* i/f index. */
+  struct in6_addr ip;       /* ipv6 address of neighbor. */
+  uint8_t mac[UPDATER_ETH_LEN]; /* mac address for ip. */
+} __attribute__ ((aligned(128)));
+
+/* ipv6 route entry for queue */
+struct notification_route6_entry {
+  struct in6_addr dest;     /* Destination address. */
+  struct in6_addr gate;     /* Nexthop address. */
+  int ifindex;              /* Nexthop interface index. */
+  int prefixlen;            /* Prefix length. */
+  uint8_t mac[UPDATER_ETH_LEN]; /* mac address for i/f with ifindex. */
+} __attribute__ ((aligned(128)));
+
+/* batch of entries for queue, applied in one update */
+struct notification_batch_entry {
+  size_t num;                        /* number of entries. */
+  struct notification_entry *entries; /* array of entries. */
+};
+
 /* queue entry */
 struct notification_entry {
   uint8_t type;
@@ -73,6 +99,9 @@ struct notification_entry {
     struct notification_arp_entry arp;
     struct notification_route_entry route;
     struct notification_ifaddr_entry ifaddr;
+    struct notification_ndp_entry ndp;
+    struct notification_route6_entry route6;
+    struct notification_batch_entry batch;
   };
 };
 
@@ -80,8 +109,6 @@ struct notification_entry {
  * Local data for each worker.
  */
 struct fib {
-  lagopus_hashmap_t localcache; /**< local cache for each worker. */
-
   uint32_t referred_table; /**< index of referencing rib. */
   uint16_t referring;      /**< whether it refers to the rib(reading). */
 } __attribute__ ((aligned(128)));
@@ -105,7 +132,13 @@ struct rib {
   struct rib_tables ribs[2]; /**< RIBs(writing and reading). */
   uint32_t read_table;       /**< Current read table index. */
 
-  struct fib fib[UPDATER_LOCALDATA_MAX_NUM]; /**< local cache for each workers. */
+  struct fib_table fibtable; /**< FIB compiled from ribs. */
+
+  struct notification_entry **replay_entries; /**< entries applied to
+                                                   the reading rib only. */
+  size_t replay_num;         /**< number of replay_entries. */
+
+  struct fib fib[UPDATER_LOCALDATA_MAX_NUM]; /**< local data for each workers. */
 };
 
 /* apis */
@@ -118,6 +151,9 @@ rib_fini(struct rib *);
 lagopus_result_t
 rib_update(struct rib *rib);
 
+void
+rib_adjacency_resolve(struct rib *rib, struct mactable *mactable);
+
 /* for rib_notifier */
 lagopus_result_t
 rib_arp_add(struct rib *rib, int ifindex,
@@ -156,6 +192,10 @@ rib_lookup(struct lagopus_packet *pkt);
 lagopus_result_t
 rib_add_notification_entry(struct rib *rib, struct notification_entry *entry);
 
+lagopus_result_t
+rib_add_notification_batch(struct rib *rib,
+                           struct notification_entry *entries, size_t num);
+
 struct notification_entry *
 rib_create_notification_entry(uint8_t type, uint8_t action);
 
@@ -65,6 +65,27 @@ typedef lagopus_cbuffer_t lagopus_bbq_t;
   lagopus_cbuffer_create((bbqptr), type, (length), (proc))
 
 
+/**
+ * Create a bounded blocking queue with a synchronization mode.
+ *
+ *     @param[out] bbqptr         A pointer to a queue to be created.
+ *     @param[in]  type           A type of a value of the queue.
+ *     @param[in]  maxelem        A maximum # of the value the queue holds.
+ *     @param[in]  proc           A value free up function (\b NULL allowed).
+ *     @param[in]  mode           A \b lagopus_cbuffer_mode_t.
+ *
+ *     @retval LAGOPUS_RESULT_OK               Succeeded.
+ *     @retval LAGOPUS_RESULT_NO_MEMORY        Failed, no memory.
+ *     @retval LAGOPUS_RESULT_INVALID_ARGS     Failed, invalid argument(s).
+ *     @retval LAGOPUS_RESULT_ANY_FAILURES     Failed.
+ *
+ *     @details \b LAGOPUS_CBUFFER_MODE_SPSC and \b
+ *     LAGOPUS_CBUFFER_MODE_MPSC queues must have a single getter.
+ */
+#define lagopus_bbq_create_with_mode(bbqptr, type, length, proc, mode)  \
+  lagopus_cbuffer_create_with_mode((bbqptr), type, (length), (proc), (mode))
+
+
 /**
  * Shutdown a bounded blocking queue.
  *
@@ -465,6 +486,17 @@ lagopus_cbuffer_peek_n((cbptr), (void **)(valptr),                    \
   lagopus_cbuffer_is_operational((bbqptr), (retptr))
 
 
+/**
+ * Get a # of the wakeups of sleeping putters/getters.
+ *	@param[in]   bbqptr    A pointer to a queue.
+ *
+ *	@retval	>=0	A # of the wakeups since the creation.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid argument(s).
+ */
+#define lagopus_bbq_n_wakeups(bbqptr)           \
+  lagopus_cbuffer_n_wakeups((bbqptr))
+
+
 /**
  * Cleanup an internal state of a circular buffer after thread
  * cancellation.
@@ -41,6 +41,8 @@
 typedef struct lagopus_callout_task_record {
   lagopus_runnable_record m_runnable;
   TAILQ_ENTRY(lagopus_callout_task_record) m_entry;
+  struct chrono_task_queue_t *m_timed_q;	/** The timing wheel slot
+                                                    the task is in. */
 
   lagopus_mutex_t m_lock;	/** A recursive lock. */
   lagopus_cond_t m_cond;	/** A cond, mainly for cancel sync. */
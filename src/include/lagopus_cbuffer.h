@@ -41,6 +41,26 @@ typedef struct lagopus_cbuffer_record 	*lagopus_cbuffer_t;
 typedef void	(*lagopus_cbuffer_value_freeup_proc_t)(void **valptr);
 
 
+/**
+ * @details Synchronization of a circular buffer, chosen at creation.
+ *
+ * @details \b LAGOPUS_CBUFFER_MODE_LOCKED: any # of putters and
+ * getters, every operation takes a mutex.
+ *
+ * @details \b LAGOPUS_CBUFFER_MODE_SPSC and \b
+ * LAGOPUS_CBUFFER_MODE_MPSC: a lock-free ring for one putter (SPSC)
+ * or any # of putters (MPSC) and a single getter. The mutex is taken
+ * only to sleep on an empty/full buffer and to wake a sleeper. Get,
+ * peek, clear and shutdown with \b free_values are operations of the
+ * getter, they must not run concurrently with each other.
+ */
+typedef enum {
+  LAGOPUS_CBUFFER_MODE_LOCKED = 0,
+  LAGOPUS_CBUFFER_MODE_SPSC,
+  LAGOPUS_CBUFFER_MODE_MPSC
+} lagopus_cbuffer_mode_t;
+
+
 
 
 
@@ -65,6 +85,32 @@ lagopus_cbuffer_create_with_size(lagopus_cbuffer_t *cbptr,
   lagopus_cbuffer_create_with_size((cbptr), sizeof(type), (maxelems), (proc))
 
 
+lagopus_result_t
+lagopus_cbuffer_create_with_size_and_mode(
+  lagopus_cbuffer_t *cbptr,
+  size_t elemsize,
+  int64_t maxelems,
+  lagopus_cbuffer_value_freeup_proc_t proc,
+  lagopus_cbuffer_mode_t mode);
+/**
+ * Create a circular buffer with a synchronization mode.
+ *
+ *     @param[in,out]	cbptr	A pointer to a circular buffer to be created.
+ *     @param[in]	type	Type of the element.
+ *     @param[in]	maxelems	# of maximum elements.
+ *     @param[in]	proc	A value free up function (\b NULL allowed).
+ *     @param[in]	mode	A synchronization mode.
+ *
+ *     @retval LAGOPUS_RESULT_OK               Succeeded.
+ *     @retval LAGOPUS_RESULT_NO_MEMORY        Failed, no memory.
+ *     @retval LAGOPUS_RESULT_INVALID_ARGS     Failed, invalid argument(s).
+ *     @retval LAGOPUS_RESULT_ANY_FAILURES     Failed.
+ */
+#define lagopus_cbuffer_create_with_mode(cbptr, type, maxelems, proc, mode) \
+  lagopus_cbuffer_create_with_size_and_mode((cbptr), sizeof(type),        \
+      (maxelems), (proc), (mode))
+
+
 /**
  * Shutdown a circular buffer.
  *
@@ -513,6 +559,17 @@ lagopus_result_t
 lagopus_cbuffer_is_operational(lagopus_cbuffer_t *cbptr, bool *retptr);
 
 
+/**
+ * Get a # of the wakeups of sleeping putters/getters.
+ *	@param[in]   cbptr    A pointer to a circular buffer
+ *
+ *	@retval	>=0	A # of the wakeups since the creation.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid argument(s).
+ */
+lagopus_result_t
+lagopus_cbuffer_n_wakeups(lagopus_cbuffer_t *cbptr);
+
+
 /**
  * Cleanup an internal state of a circular buffer after thread
  * cancellation.
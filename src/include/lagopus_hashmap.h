@@ -33,6 +33,13 @@
 #define LAGOPUS_HASHMAP_TYPE_ONE_WORD \
   MACRO_CONSTANTIFY_UNSIGNED(SIZEOF_VOID_P)
 
+/**
+ * OR'ed to \b LAGOPUS_HASHMAP_TYPE_STRING or
+ * \b LAGOPUS_HASHMAP_TYPE_ONE_WORD for a read-mostly hash map whose
+ * lagopus_hashmap_find() takes no lock.
+ */
+#define LAGOPUS_HASHMAP_TYPE_CONCURRENT	0x80000000U
+
 
 
 
@@ -104,6 +111,12 @@ lagopus_hashmap_set_value(lagopus_hashentry_t he,
  *	@details So if you want to use 64 bits key on 32 bits
  *	architecture, you must pass the \b t as
  *	\b (lagopus_hashmap_type_t)(sizeof(int64_t) / sizeof(int))
+ *
+ *	@details With \b LAGOPUS_HASHMAP_TYPE_CONCURRENT, lookups take
+ *	no lock and do no atomic read-modify-write, while writers are
+ *	serialized by a mutex.  Removed entries are freed once no reader
+ *	can see them, but a found value is only as safe to use as with
+ *	the locked hash map.  Only string and one word keys are allowed.
  */
 lagopus_result_t
 lagopus_hashmap_create(lagopus_hashmap_t *retptr,
@@ -212,6 +212,46 @@ lagopus_log_destination_t
 lagopus_log_get_destination(const char **arg);
 
 
+/**
+ * Emit the log asynchronously or not.
+ *
+ *	@param[in]	async	Use \b true to emit asynchronously.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Succeeded.
+ *	@retval	LAGOPUS_RESULT_POSIX_API_ERROR	Failed, posix API error.
+ *
+ *	@details In the asynchronous mode each thread formats messages
+ *	into its own ring buffer and a writer thread emits them in
+ *	batches. A message not fitting in a full ring is dropped and
+ *	counted. Errors and fatals are still emitted synchronously,
+ *	after the messages pending in the rings.
+ */
+lagopus_result_t
+lagopus_log_set_async(bool async);
+
+
+/**
+ * Check the logger is in the asynchronous mode.
+ *
+ *	@returns	\b true if asynchronous.
+ */
+bool	lagopus_log_is_async(void);
+
+
+/**
+ * Emit all the messages pending in the asynchronous mode.
+ */
+void	lagopus_log_flush(void);
+
+
+/**
+ * Get a # of the messages dropped in the asynchronous mode.
+ *
+ *	@returns	A # of the dropped messages.
+ */
+uint64_t	lagopus_log_get_n_dropped(void);
+
+
 /**
  * The main logging workhorse: not intended for direct use.
  */
@@ -16,6 +16,27 @@
 typedef struct lagopus_statistic_struct	*lagopus_statistic_t;
 
 
+/**
+ * A histogram. Each thread records into its own copy of the
+ * log-linear buckets without any atomic operation or lock, readers
+ * merge the copies. A percentile is the upper bound of its bucket,
+ * at most 1/32 above the exact value.
+ */
+typedef struct lagopus_histogram_struct	*lagopus_histogram_t;
+
+
+/**
+ * Percentiles of a histogram.
+ */
+typedef struct {
+  uint64_t m_n;		/** # of the sample. */
+  int64_t m_p50;
+  int64_t m_p99;
+  int64_t m_p999;
+  int64_t m_max;
+} lagopus_histogram_summary_t;
+
+
 
 
 
@@ -165,6 +186,116 @@ lagopus_result_t
 lagopus_statistic_sd(lagopus_statistic_t *sptr, double *valptr, bool is_ssd);
 
 
+
+
+
+/**
+ * Create a histogram.
+ *
+ *	@param[in,out]	hptr	A pointer to a histogram.
+ *	@param[in]	name	Name of the histogram.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Suceeded.
+ *	@retval LAGOPUS_RESULT_NO_MEMORY	Failed, no memory.
+ *	@retval LAGOPUS_RESULT_TOO_MANY_OBJECTS	Failed, too many histograms.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ *	@retval LAGOPUS_RESULT_ANY_FAILURES	Failed.
+ */
+lagopus_result_t
+lagopus_histogram_create(lagopus_histogram_t *hptr, const char *name);
+
+
+/**
+ * Find a histogram by name.
+ *
+ *	@param[out]	hptr	A pointer to a histogram.
+ *	@param[in]	name	Name of the histogram.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Suceeded.
+ *	@retval LAGOPUS_RESULT_NOT_FOUND	Failed, not found.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ *	@retval LAGOPUS_RESULT_ANY_FAILURES	Failed.
+ */
+lagopus_result_t
+lagopus_histogram_find(lagopus_histogram_t *hptr, const char *name);
+
+
+/**
+ * Destroy a histogram. No thread may record into it at the same time.
+ *
+ *	@param[in]	hptr	A pointer to a histogram.
+ */
+void
+lagopus_histogram_destroy(lagopus_histogram_t *hptr);
+
+
+/**
+ * Record a value to a histogram. Negative values are counted as 0.
+ *
+ *	@param[in]	hptr	A pointer to a histogram.
+ *	@param[in]	val	A value.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Suceeded.
+ *	@retval LAGOPUS_RESULT_NO_MEMORY	Failed, no memory.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ */
+lagopus_result_t
+lagopus_histogram_record(lagopus_histogram_t *hptr, int64_t val);
+
+
+/**
+ * Reset a histogram. Samples recorded meanwhile may survive.
+ *
+ *	@param[in]	hptr	A pointer to a histogram.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Suceeded.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ */
+lagopus_result_t
+lagopus_histogram_reset(lagopus_histogram_t *hptr);
+
+
+/**
+ * Acquire # of the sample from a histogram.
+ *
+ *	@param[in]	hptr	A pointer to a histogram.
+ *
+ *	@retval	>=0				# of the sample.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ */
+lagopus_result_t
+lagopus_histogram_sample_n(lagopus_histogram_t *hptr);
+
+
+/**
+ * Acquire the value at a percentile from a histogram, 0 if empty.
+ *
+ *	@param[in]	hptr	A pointer to a histogram.
+ *	@param[in]	pct	A percentile (0.0 - 100.0).
+ *	@param[out]	valptr	A pointer to a value.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Suceeded.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ */
+lagopus_result_t
+lagopus_histogram_percentile(lagopus_histogram_t *hptr, double pct,
+                             int64_t *valptr);
+
+
+/**
+ * Acquire p50/p99/p99.9/max of a histogram with a single merge.
+ *
+ *	@param[in]	hptr	A pointer to a histogram.
+ *	@param[out]	sumptr	A pointer to a summary.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Suceeded.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS	Failed, invalid args.
+ */
+lagopus_result_t
+lagopus_histogram_summary(lagopus_histogram_t *hptr,
+                          lagopus_histogram_summary_t *sumptr);
+
+
 
 
 
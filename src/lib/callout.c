@@ -29,6 +29,17 @@
 
 #define CALLOUT_TASK_SCHED_JITTER	1000LL	/* 1 usec. */
 
+/*
+ * The timing wheel of the timed tasks: a level 0 slot spans a tick,
+ * a level n slot spans CALLOUT_WHEEL_SLOTS^n ticks.
+ */
+#ifndef CALLOUT_WHEEL_TICK_SHIFT
+#define CALLOUT_WHEEL_TICK_SHIFT	20	/* 2^20 nsec, about 1 msec. */
+#endif /* CALLOUT_WHEEL_TICK_SHIFT */
+#define CALLOUT_WHEEL_BITS	6
+#define CALLOUT_WHEEL_SLOTS	(1 << CALLOUT_WHEEL_BITS)
+#define CALLOUT_WHEEL_LEVELS	6
+
 #define CALLOUT_TASK_SCHED_DELAY_COMPENSATION	50LL * 1000LL	/* 50 usec. */
 
 #define CALLOUT_TASK_MIN_INTERVAL	10LL * 1000LL /* 10 usec. */
@@ -74,7 +85,11 @@ static lagopus_mutex_t s_lck = NULL;		/* The global lock. */
 static lagopus_hashmap_t s_tsk_tbl = NULL;	/* The valid tasks table. */
 
 static lagopus_bbq_t s_urgent_tsk_q = NULL;	/* The urgent tasks Q. */
-static chrono_task_queue_t s_chrono_tsk_q;	/* The timed tasks Q. */
+static chrono_task_queue_t
+s_wheel[CALLOUT_WHEEL_LEVELS][CALLOUT_WHEEL_SLOTS];	/* The timed tasks. */
+static uint64_t s_wheel_map[CALLOUT_WHEEL_LEVELS];	/* Non-empty slots. */
+static uint64_t s_wheel_tick = 0;		/* The current tick. */
+static size_t s_wheel_n = 0;			/* # of the timed tasks. */
 static lagopus_mutex_t s_q_lck;			/* The timed task Q lock. */
 static lagopus_bbq_t s_idle_tsk_q = NULL;	/* The Idle taskss Q. */
 
@@ -197,6 +212,7 @@ s_task_freeup(void **valptr) {
 static void
 s_once_proc(void) {
   lagopus_result_t r;
+  size_t i, j;
 
   if ((r = lagopus_mutex_create(&s_sched_lck)) != LAGOPUS_RESULT_OK) {
     lagopus_perror(r);
@@ -239,7 +255,11 @@ s_once_proc(void) {
     lagopus_exit_fatal("can't initialize the callout task queue mutex.\n");
   }
 
-  TAILQ_INIT(&s_chrono_tsk_q);
+  for (i = 0; i < CALLOUT_WHEEL_LEVELS; i++) {
+    for (j = 0; j < CALLOUT_WHEEL_SLOTS; j++) {
+      TAILQ_INIT(&s_wheel[i][j]);
+    }
+  }
 }
 
 
@@ -51,11 +51,212 @@ s_unlock_task_q(void) {
 
 
 
+/*
+ * The timing wheel primitives. All of them must be called with the
+ * timed task queue lock held.
+ */
+
+
+static inline uint64_t
+s_wheel_tick_of(lagopus_chrono_t abstime) {
+  return (abstime > 0LL) ?
+      ((uint64_t)abstime >> CALLOUT_WHEEL_TICK_SHIFT) : 0LLU;
+}
+
+
+static inline int
+s_wheel_find_slot(size_t lv, size_t from, size_t n_span) {
+  /*
+   * Returns the offset (< n_span) from the slot "from" of the first
+   * non-empty slot in the level, circularly, or -1.
+   */
+  uint64_t map = s_wheel_map[lv];
+
+  if (map != 0LLU) {
+    if (from != 0) {
+      map = (map >> from) | (map << (CALLOUT_WHEEL_SLOTS - from));
+    }
+    if (map != 0LLU && (size_t)__builtin_ctzll(map) < n_span) {
+      return __builtin_ctzll(map);
+    }
+  }
+
+  return -1;
+}
+
+
+static inline void
+s_wheel_add(lagopus_callout_task_t t) {
+  uint64_t tick = s_wheel_tick_of(t->m_next_abstime);
+  uint64_t delta;
+  size_t lv;
+  size_t idx;
+
+  if (tick < s_wheel_tick) {
+    tick = s_wheel_tick;
+  }
+  delta = tick - s_wheel_tick;
+
+  for (lv = 0; lv < CALLOUT_WHEEL_LEVELS - 1; lv++) {
+    if (delta < (1LLU << (CALLOUT_WHEEL_BITS * (lv + 1)))) {
+      break;
+    }
+  }
+  if (lv == CALLOUT_WHEEL_LEVELS - 1 &&
+      delta >= (1LLU << (CALLOUT_WHEEL_BITS * CALLOUT_WHEEL_LEVELS))) {
+    /*
+     * Too far. Park it at the farthest slot, it is re-placed by the
+     * cascading.
+     */
+    tick = s_wheel_tick +
+           (1LLU << (CALLOUT_WHEEL_BITS * CALLOUT_WHEEL_LEVELS)) - 1;
+  }
+  idx = (size_t)((tick >> (CALLOUT_WHEEL_BITS * lv)) &
+                 (CALLOUT_WHEEL_SLOTS - 1));
+
+  TAILQ_INSERT_TAIL(&s_wheel[lv][idx], t, m_entry);
+  s_wheel_map[lv] |= 1LLU << idx;
+  t->m_timed_q = &s_wheel[lv][idx];
+  s_wheel_n++;
+}
+
+
+static inline void
+s_wheel_remove(lagopus_callout_task_t t) {
+  chrono_task_queue_t *q = t->m_timed_q;
+  size_t off;
+
+  if (likely(q != NULL)) {
+    TAILQ_REMOVE(q, t, m_entry);
+    if (TAILQ_EMPTY(q)) {
+      off = (size_t)(q - &s_wheel[0][0]);
+      s_wheel_map[off / CALLOUT_WHEEL_SLOTS] &=
+          ~(1LLU << (off % CALLOUT_WHEEL_SLOTS));
+    }
+    t->m_timed_q = NULL;
+    s_wheel_n--;
+  }
+}
+
+
+static inline void
+s_wheel_cascade(void) {
+  size_t lv;
+  size_t idx;
+  chrono_task_queue_t *q;
+  lagopus_callout_task_t e;
+
+  /*
+   * When the current tick crosses a boundary of a level, move the
+   * tasks in the level's slot down to the lower levels.
+   */
+  for (lv = 1; lv < CALLOUT_WHEEL_LEVELS; lv++) {
+    if ((s_wheel_tick &
+         ((1LLU << (CALLOUT_WHEEL_BITS * lv)) - 1)) != 0LLU) {
+      break;
+    }
+    idx = (size_t)((s_wheel_tick >> (CALLOUT_WHEEL_BITS * lv)) &
+                   (CALLOUT_WHEEL_SLOTS - 1));
+    q = &s_wheel[lv][idx];
+    while ((e = TAILQ_FIRST(q)) != NULL) {
+      s_wheel_remove(e);
+      s_wheel_add(e);
+    }
+  }
+}
+
+
+static inline void
+s_wheel_advance(uint64_t target) {
+  size_t lv;
+  uint64_t span;
+  uint64_t next;
+
+  /*
+   * Step the current tick by one, or skip to the next boundary of
+   * the lowest non-empty level if the levels under it are empty.
+   */
+  if (s_wheel_map[0] != 0LLU) {
+    s_wheel_tick++;
+  } else {
+    for (lv = 1; lv < CALLOUT_WHEEL_LEVELS - 1; lv++) {
+      if (s_wheel_map[lv] != 0LLU) {
+        break;
+      }
+    }
+    span = 1LLU << (CALLOUT_WHEEL_BITS * lv);
+    next = (s_wheel_tick | (span - 1)) + 1;
+    if (next > target) {
+      /*
+       * No boundary to cross, no need to cascade.
+       */
+      s_wheel_tick = target;
+      return;
+    }
+    s_wheel_tick = next;
+  }
+
+  s_wheel_cascade();
+}
+
+
+static inline lagopus_chrono_t
+s_wheel_next_abstime(void) {
+  lagopus_chrono_t ret = -1LL;
+  lagopus_chrono_t t;
+  lagopus_callout_task_t e;
+  size_t lv;
+  size_t cur;
+  int off;
+
+  if (s_wheel_n == 0) {
+    return -1LL;
+  }
+
+  /*
+   * The earliest task in the first non-empty level 0 slot, then the
+   * start time of the first non-empty slot of each upper level,
+   * which is never later than the tasks in it.
+   */
+  cur = (size_t)(s_wheel_tick & (CALLOUT_WHEEL_SLOTS - 1));
+  off = s_wheel_find_slot(0, cur, CALLOUT_WHEEL_SLOTS);
+  if (off >= 0) {
+    TAILQ_FOREACH(e, &s_wheel[0][(cur + (size_t)off) &
+                                 (CALLOUT_WHEEL_SLOTS - 1)], m_entry) {
+      if (ret < 0LL || e->m_next_abstime < ret) {
+        ret = e->m_next_abstime;
+      }
+    }
+  }
+
+  for (lv = 1; lv < CALLOUT_WHEEL_LEVELS; lv++) {
+    cur = (size_t)((s_wheel_tick >> (CALLOUT_WHEEL_BITS * lv)) &
+                   (CALLOUT_WHEEL_SLOTS - 1));
+    off = s_wheel_find_slot(lv, (cur + 1) & (CALLOUT_WHEEL_SLOTS - 1),
+                            CALLOUT_WHEEL_SLOTS);
+    if (off >= 0) {
+      t = (lagopus_chrono_t)
+          ((((s_wheel_tick >> (CALLOUT_WHEEL_BITS * lv)) +
+             (uint64_t)off + 1) << (CALLOUT_WHEEL_BITS * lv)) <<
+           CALLOUT_WHEEL_TICK_SHIFT);
+      if (ret < 0LL || t < ret) {
+        ret = t;
+      }
+    }
+  }
+
+  return ret;
+}
+
+
+
+
+
 static inline lagopus_chrono_t
 s_do_sched(lagopus_callout_task_t t) {
   lagopus_result_t ret = -1LL;
   lagopus_result_t r;
-  lagopus_callout_task_t e;
+  lagopus_chrono_t now;
 
   s_lock_task_q();
   {
@@ -76,27 +277,16 @@ s_do_sched(lagopus_callout_task_t t) {
         }
 
         /*
-         * Then insert the task into the Q.
+         * Then put the task into the wheel. If the wheel is empty the
+         * current tick could be stale, catch it up first.
          */
-        e = TAILQ_FIRST(&s_chrono_tsk_q);
-        if (e != NULL) {
-          if (e->m_next_abstime > t->m_next_abstime) {
-            TAILQ_INSERT_HEAD(&s_chrono_tsk_q, t, m_entry);
-          } else {
-            for (;
-                 e != NULL && e->m_next_abstime <= t->m_next_abstime;
-                 e = TAILQ_NEXT(e, m_entry)) {
-              ;
-            }
-            if (e != NULL) {
-              TAILQ_INSERT_BEFORE(e, t, m_entry);
-            } else {
-              TAILQ_INSERT_TAIL(&s_chrono_tsk_q, t, m_entry);
-            }
+        if (s_wheel_n == 0) {
+          WHAT_TIME_IS_IT_NOW_IN_NSEC(now);
+          if (s_wheel_tick_of(now) > s_wheel_tick) {
+            s_wheel_tick = s_wheel_tick_of(now);
           }
-        } else {
-          TAILQ_INSERT_TAIL(&s_chrono_tsk_q, t, m_entry);
         }
+        s_wheel_add(t);
 
         (void)s_set_task_state_in_table(t, TASK_STATE_ENQUEUED);
         t->m_status = TASK_STATE_ENQUEUED;
@@ -177,7 +367,7 @@ s_do_unsched(lagopus_callout_task_t t) {
     {
       if (likely(t->m_is_in_timed_q == true)) {
 
-        TAILQ_REMOVE(&s_chrono_tsk_q, t, m_entry);
+        s_wheel_remove(t);
 
         if (t->m_status == TASK_STATE_ENQUEUED) {
             (void)s_set_task_state_in_table(t, TASK_STATE_DEQUEUED);
@@ -220,37 +410,13 @@ s_unschedule_timed_task(lagopus_callout_task_t t) {
 
 
 
-static inline lagopus_callout_task_t
-s_peek_timed_task(void) {
-  lagopus_callout_task_t ret = NULL;
-
-  s_lock_task_q();
-  {
-    ret = TAILQ_FIRST(&s_chrono_tsk_q);
-  }
-  s_unlock_task_q();
-
-  return ret;
-}
-
-
 static inline lagopus_chrono_t
 s_peek_current_wakeup_time(void) {
   lagopus_chrono_t ret = -1LL;
-  lagopus_callout_task_t t;
 
   s_lock_task_q();
   {
-    t = TAILQ_FIRST(&s_chrono_tsk_q);
-    if (t != NULL) {
-
-      s_lock_task(t);
-      {
-        ret = t->m_next_abstime;
-      }
-      s_unlock_task(t);
-
-    }
+    ret = s_wheel_next_abstime();
   }
   s_unlock_task_q();
 
@@ -258,22 +424,29 @@ s_peek_current_wakeup_time(void) {
 }
 
 
-
+
 
 
 static inline lagopus_callout_task_t
 s_get(void) {
   lagopus_callout_task_t ret = NULL;
+  size_t lv;
+  int off;
 
   s_lock_task_q();
   {
-    ret = TAILQ_FIRST(&s_chrono_tsk_q);
+    for (lv = 0; lv < CALLOUT_WHEEL_LEVELS && ret == NULL; lv++) {
+      off = s_wheel_find_slot(lv, 0, CALLOUT_WHEEL_SLOTS);
+      if (off >= 0) {
+        ret = TAILQ_FIRST(&s_wheel[lv][off]);
+      }
+    }
 
     if (likely(ret != NULL)) {
 
       s_lock_task(ret);
       {
-        TAILQ_REMOVE(&s_chrono_tsk_q, ret, m_entry);
+        s_wheel_remove(ret);
         (void)s_set_task_state_in_table(ret, TASK_STATE_DEQUEUED);
         ret->m_status = TASK_STATE_DEQUEUED;
         ret->m_is_in_timed_q = false;
@@ -316,46 +489,69 @@ s_get_runnables(lagopus_chrono_t base_abstime,
                 lagopus_callout_task_t *tasks, size_t n,
                 lagopus_chrono_t *next_wakeup) {
   size_t n_ret = 0LL;
+  size_t i, j;
   lagopus_callout_task_t e;
+  lagopus_callout_task_t nxt;
+  chrono_task_queue_t *q;
   lagopus_chrono_t the_abstime = base_abstime + CALLOUT_TASK_SCHED_JITTER;
+  uint64_t target = s_wheel_tick_of(the_abstime);
 
   s_lock_task_q();
   {
 
-    e = TAILQ_FIRST(&s_chrono_tsk_q);
+    if (s_wheel_n == 0) {
+      if (target > s_wheel_tick) {
+        s_wheel_tick = target;
+      }
+    }
 
-    while (n_ret < n && e != NULL) {
-      e = TAILQ_FIRST(&s_chrono_tsk_q);
-      if (likely(e != NULL &&
-                 e->m_next_abstime <= the_abstime)) {
-        TAILQ_REMOVE(&s_chrono_tsk_q, e, m_entry);
+    /*
+     * Drain the current level 0 slot and turn the wheel, up to the
+     * tick of the_abstime.
+     */
+    while (n_ret < n && s_wheel_n > 0) {
+      q = &s_wheel[0][s_wheel_tick & (CALLOUT_WHEEL_SLOTS - 1)];
+      for (e = TAILQ_FIRST(q); e != NULL && n_ret < n; e = nxt) {
+        nxt = TAILQ_NEXT(e, m_entry);
+        if (e->m_next_abstime <= the_abstime) {
+          s_lock_task(e);
+          {
+            s_wheel_remove(e);
+            (void)s_set_task_state_in_table(e, TASK_STATE_DEQUEUED);
+            e->m_status = TASK_STATE_DEQUEUED;
+            e->m_is_in_timed_q = false;
+          }
+          s_unlock_task(e);
 
-        s_lock_task(e);
-        {
-          (void)s_set_task_state_in_table(e, TASK_STATE_DEQUEUED);
-          e->m_status = TASK_STATE_DEQUEUED;
-          e->m_is_in_timed_q = false;
+          tasks[n_ret++] = e;
         }
-        s_unlock_task(e);
+      }
 
-        tasks[n_ret++] = e;
-      } else {
+      if (n_ret >= n || s_wheel_tick >= target) {
         break;
       }
+      s_wheel_advance(target);
     }
 
     if (likely(next_wakeup != NULL)) {
-      e = TAILQ_FIRST(&s_chrono_tsk_q);
-      if (e != NULL) {
-        *next_wakeup = e->m_next_abstime;
-      } else {
-        *next_wakeup = -1LL;
-      }
+      *next_wakeup = s_wheel_next_abstime();
     }
 
   }
   s_unlock_task_q();
 
+  /*
+   * A slot is not sorted, keep the execution time order.
+   */
+  for (i = 1; i < n_ret; i++) {
+    e = tasks[i];
+    for (j = i; j > 0 && tasks[j - 1]->m_next_abstime > e->m_next_abstime;
+         j--) {
+      tasks[j] = tasks[j - 1];
+    }
+    tasks[j] = e;
+  }
+
   return (lagopus_result_t)n_ret;
 }
 
@@ -206,6 +206,7 @@ s_create_task(lagopus_callout_task_t *tptr,
       (*tptr)->m_do_repeat = false;
       (*tptr)->m_is_first = true;
       (*tptr)->m_is_in_timed_q = false;
+      (*tptr)->m_timed_q = NULL;
       (*tptr)->m_initial_delay_time = -1LL;
       (*tptr)->m_interval_time = -1LL;
       (*tptr)->m_last_abstime = 0;
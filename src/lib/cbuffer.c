@@ -8,6 +8,15 @@
 #define N_EMPTY_ROOM	1LL
 
 
+#define LF_GET	0
+#define LF_PUT	1
+
+
+#ifndef CBUFFER_CACHELINE_SIZE
+#define CBUFFER_CACHELINE_SIZE	64
+#endif /* ! CBUFFER_CACHELINE_SIZE */
+
+
 
 
 
@@ -17,10 +26,21 @@ typedef struct lagopus_cbuffer_record {
   lagopus_cond_t m_cond_get;
   lagopus_cond_t m_cond_awakened;
 
-  volatile int64_t m_r_idx;
-  volatile int64_t m_w_idx;
-  volatile int64_t m_n_elements;
+  /*
+   * The consumer and the producer(s) of a lock-free buffer touch
+   * only one of these, keep them off each other's cache line.
+   */
+  volatile int64_t m_r_idx __attribute__((aligned(CBUFFER_CACHELINE_SIZE)));
+  volatile int64_t m_w_idx __attribute__((aligned(CBUFFER_CACHELINE_SIZE)));
+  volatile int64_t m_n_elements
+  __attribute__((aligned(CBUFFER_CACHELINE_SIZE)));
   volatile size_t m_n_waiters;
+  volatile uint64_t m_n_wakeups;
+
+  lagopus_cbuffer_mode_t m_mode;
+  volatile int64_t *m_seq;	/* MPSC: index + 1 once a slot is filled. */
+  volatile size_t m_n_lf_waiters[2];	/* Getters and putters asleep. */
+  volatile bool m_lf_notified[2];	/* Woken, not yet run. */
 
   volatile bool m_is_operational;
   volatile bool m_is_awakened;
@@ -91,6 +111,242 @@ s_data_addr(lagopus_cbuffer_t cb, int64_t idx) {
 }
 
 
+static inline void
+s_data_copyin(lagopus_cbuffer_t cb, int64_t w_idx, void *buf, int64_t n) {
+  int64_t idx = w_idx % cb->m_n_max_allocd_elements;
+  char *dst = cb->m_data + (size_t)idx * cb->m_element_size;
+
+  if ((idx + n) <= cb->m_n_max_allocd_elements) {
+    (void)memcpy((void *)dst, buf, (size_t)n * cb->m_element_size);
+  } else {
+    int64_t n_0 = cb->m_n_max_allocd_elements - idx;
+    size_t n_0_sz = (size_t)n_0 * cb->m_element_size;
+    char *src1 = (char *)buf + n_0_sz;
+    int64_t n_1 = n - n_0;
+
+    (void)memcpy((void *)dst, buf, n_0_sz);
+    (void)memcpy((void *)(cb->m_data), (void *)src1,
+                 (size_t)n_1 * cb->m_element_size);
+  }
+}
+
+
+static inline void
+s_data_copyout(lagopus_cbuffer_t cb, int64_t r_idx, void *buf, int64_t n) {
+  int64_t idx = r_idx % cb->m_n_max_allocd_elements;
+  char *src = cb->m_data + (size_t)idx * cb->m_element_size;
+
+  if ((idx + n) <= cb->m_n_max_allocd_elements) {
+    (void)memcpy(buf, (void *)src, (size_t)n * cb->m_element_size);
+  } else {
+    int64_t n_0 = cb->m_n_max_allocd_elements - idx;
+    size_t n_0_sz = (size_t)n_0 * cb->m_element_size;
+    char *dst1 = (char *)buf + n_0_sz;
+    int64_t n_1 = n - n_0;
+
+    (void)memcpy(buf, (void *)src, n_0_sz);
+    (void)memcpy((void *)dst1, (void *)(cb->m_data),
+                 (size_t)n_1 * cb->m_element_size);
+  }
+}
+
+
+
+
+
+/*
+ * Lock-free modes. The producer(s) own m_w_idx, the single consumer
+ * owns m_r_idx, and m_n_elements is not used. m_lock and the
+ * condition variables are only touched to sleep on an empty/full
+ * buffer and to wake such a sleeper up.
+ */
+
+
+static inline bool
+s_is_lockfree(lagopus_cbuffer_t cb) {
+  return (cb->m_mode != LAGOPUS_CBUFFER_MODE_LOCKED) ? true : false;
+}
+
+
+static inline int64_t
+s_lf_n_elements(lagopus_cbuffer_t cb) {
+  /*
+   * Load the read index first, it never passes the write index.
+   */
+  int64_t r_idx = __atomic_load_n(&(cb->m_r_idx), __ATOMIC_ACQUIRE);
+  int64_t w_idx = __atomic_load_n(&(cb->m_w_idx), __ATOMIC_ACQUIRE);
+
+  return w_idx - r_idx;
+}
+
+
+static inline int64_t
+s_n_elements(lagopus_cbuffer_t cb) {
+  return (s_is_lockfree(cb) == true) ?
+         s_lf_n_elements(cb) : cb->m_n_elements;
+}
+
+
+/*
+ * A # of elements the consumer can take from the head, up to n.
+ */
+static inline int64_t
+s_lf_n_gettable(lagopus_cbuffer_t cb, int64_t n) {
+  int64_t r_idx = cb->m_r_idx;
+  int64_t ret = 0;
+
+  if (cb->m_mode == LAGOPUS_CBUFFER_MODE_SPSC) {
+    ret = __atomic_load_n(&(cb->m_w_idx), __ATOMIC_ACQUIRE) - r_idx;
+    ret = (ret < n) ? ret : n;
+  } else {
+    /*
+     * MPSC: slots are reserved in order but filled in any order,
+     * stop at the first one not filled yet.
+     */
+    while (ret < n &&
+           __atomic_load_n(&(cb->m_seq[(r_idx + ret) %
+                                       cb->m_n_max_allocd_elements]),
+                           __ATOMIC_ACQUIRE) == r_idx + ret + 1) {
+      ret++;
+    }
+  }
+
+  return ret;
+}
+
+
+static inline bool
+s_lf_is_ready(lagopus_cbuffer_t cb, int side) {
+  if (cb->m_is_operational == false) {
+    return true;
+  } else if (side == LF_GET) {
+    return (s_lf_n_gettable(cb, 1LL) > 0) ? true : false;
+  } else {
+    return (s_lf_n_elements(cb) < cb->m_n_max_elements) ? true : false;
+  }
+}
+
+
+/*
+ * Wake the other side up only if someone sleeps or polls. The fence
+ * pairs with the atomic increment in s_lf_wait_locked(): either the
+ * sleeper sees the new index or we see the sleeper. A sleeper already
+ * notified but not run yet is not notified again.
+ */
+static inline void
+s_lf_notify(lagopus_cbuffer_t cb, int side) {
+  lagopus_cond_t *cptr = (side == LF_GET) ?
+                         &(cb->m_cond_get) : &(cb->m_cond_put);
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if ((cb->m_n_lf_waiters[side] > 0 && cb->m_lf_notified[side] == false) ||
+      cb->m_qmuxer != NULL) {
+    s_lock(cb);
+    {
+      if (cb->m_qmuxer != NULL &&
+          ((side == LF_GET && NEED_WAIT_READABLE(cb->m_type) == true) ||
+           (side == LF_PUT && NEED_WAIT_WRITABLE(cb->m_type) == true))) {
+        qmuxer_notify(cb->m_qmuxer);
+      }
+      if (cb->m_n_lf_waiters[side] > 0 && cb->m_lf_notified[side] == false) {
+        cb->m_lf_notified[side] = true;
+        cb->m_n_wakeups++;
+        (void)lagopus_cond_notify(cptr, true);
+      }
+    }
+    s_unlock(cb);
+  }
+}
+
+
+static inline int64_t
+s_lf_copyin(lagopus_cbuffer_t cb, void *buf, size_t n) {
+  int64_t r_idx;
+  int64_t w_idx;
+  int64_t max_n;
+  int64_t i;
+
+  if (cb->m_mode == LAGOPUS_CBUFFER_MODE_SPSC) {
+    w_idx = cb->m_w_idx;
+    r_idx = __atomic_load_n(&(cb->m_r_idx), __ATOMIC_ACQUIRE);
+    max_n = cb->m_n_max_elements - (w_idx - r_idx);
+    max_n = (max_n < (int64_t)n) ? max_n : (int64_t)n;
+    if (max_n <= 0) {
+      return 0;
+    }
+  } else {
+    /*
+     * MPSC: reserve [w_idx, w_idx + max_n) first. The read index
+     * loaded can only be stale-low, which only shrinks the room.
+     */
+    w_idx = __atomic_load_n(&(cb->m_w_idx), __ATOMIC_RELAXED);
+    do {
+      r_idx = __atomic_load_n(&(cb->m_r_idx), __ATOMIC_ACQUIRE);
+      max_n = cb->m_n_max_elements - (w_idx - r_idx);
+      max_n = (max_n < (int64_t)n) ? max_n : (int64_t)n;
+      if (max_n <= 0) {
+        return 0;
+      }
+    } while (__atomic_compare_exchange_n(&(cb->m_w_idx), &w_idx,
+                                         w_idx + max_n, false,
+                                         __ATOMIC_RELAXED,
+                                         __ATOMIC_RELAXED) == false);
+  }
+
+  s_data_copyin(cb, w_idx, buf, max_n);
+
+  if (cb->m_mode == LAGOPUS_CBUFFER_MODE_SPSC) {
+    __atomic_store_n(&(cb->m_w_idx), w_idx + max_n, __ATOMIC_RELEASE);
+  } else {
+    for (i = w_idx; i < w_idx + max_n; i++) {
+      __atomic_store_n(&(cb->m_seq[i % cb->m_n_max_allocd_elements]),
+                       i + 1, __ATOMIC_RELEASE);
+    }
+  }
+
+  s_lf_notify(cb, LF_GET);
+
+  return max_n;
+}
+
+
+static inline int64_t
+s_lf_copyout(lagopus_cbuffer_t cb, void *buf, size_t n, bool do_incr) {
+  int64_t r_idx = cb->m_r_idx;
+  int64_t max_n = s_lf_n_gettable(cb, (int64_t)n);
+
+  if (max_n > 0) {
+    s_data_copyout(cb, r_idx, buf, max_n);
+
+    if (do_incr == true) {
+      __atomic_store_n(&(cb->m_r_idx), r_idx + max_n, __ATOMIC_RELEASE);
+      s_lf_notify(cb, LF_PUT);
+    }
+  }
+
+  return max_n;
+}
+
+
+/*
+ * Drop all the gettable elements as the consumer does.
+ */
+static inline void
+s_lf_clean(lagopus_cbuffer_t cb, bool free_values) {
+  int64_t r_idx = cb->m_r_idx;
+  int64_t n = s_lf_n_gettable(cb, cb->m_n_max_elements);
+  int64_t i;
+
+  if (free_values == true && cb->m_del_proc != NULL) {
+    for (i = r_idx; i < r_idx + n; i++) {
+      cb->m_del_proc((void **)s_data_addr(cb, i));
+    }
+  }
+  __atomic_store_n(&(cb->m_r_idx), r_idx + n, __ATOMIC_RELEASE);
+}
+
+
 static inline void
 s_freeup_all_values(lagopus_cbuffer_t cb) {
   if (cb != NULL) {
@@ -114,7 +370,9 @@ s_freeup_all_values(lagopus_cbuffer_t cb) {
 
 static inline void
 s_clean(lagopus_cbuffer_t cb, bool free_values) {
-  if (cb != NULL) {
+  if (cb != NULL && s_is_lockfree(cb) == true) {
+    s_lf_clean(cb, free_values);
+  } else if (cb != NULL) {
     if (free_values == true) {
       s_freeup_all_values(cb);
     }
@@ -152,22 +410,7 @@ s_copyin(lagopus_cbuffer_t cb, void *buf, size_t n) {
   s_adjust_indices(cb);
 
   if (max_n > 0) {
-    int64_t idx = cb->m_w_idx % cb->m_n_max_allocd_elements;
-    char *dst = cb->m_data + (size_t)idx * cb->m_element_size;
-
-    if ((idx + max_n) <= cb->m_n_max_allocd_elements) {
-      (void)memcpy((void *)dst, buf,
-                   (size_t)max_n * cb->m_element_size);
-    } else {
-      int64_t max_n_0 = cb->m_n_max_allocd_elements - idx;
-      size_t max_n_0_sz = (size_t)max_n_0 * cb->m_element_size;
-      char *src1 = (char *)buf + max_n_0_sz;
-      int64_t max_n_1 = max_n - max_n_0;
-
-      (void)memcpy((void *)dst, buf, max_n_0_sz);
-      (void)memcpy((void *)(cb->m_data), (void *)src1,
-                   (size_t)max_n_1 * cb->m_element_size);
-    }
+    s_data_copyin(cb, cb->m_w_idx, buf, max_n);
 
     cb->m_n_elements += max_n;
     cb->m_w_idx += max_n;
@@ -181,6 +424,9 @@ s_copyin(lagopus_cbuffer_t cb, void *buf, size_t n) {
     /*
      * And wake all the getters.
      */
+    if (cb->m_n_waiters > 0) {
+      cb->m_n_wakeups++;
+    }
     (void)lagopus_cond_notify(&(cb->m_cond_get), true);
   }
 
@@ -196,21 +442,7 @@ s_copyout(lagopus_cbuffer_t cb, void *buf, size_t n, bool do_incr) {
   s_adjust_indices(cb);
 
   if (max_n > 0) {
-    int64_t idx = cb->m_r_idx % cb->m_n_max_allocd_elements;
-    char *src = cb->m_data + (size_t)idx * cb->m_element_size;
-
-    if ((idx + max_n) <= cb->m_n_max_allocd_elements) {
-      (void)memcpy(buf, (void *)src, (size_t)max_n * cb->m_element_size);
-    } else {
-      int64_t max_n_0 = cb->m_n_max_allocd_elements - idx;
-      size_t max_n_0_sz = (size_t)max_n_0 * cb->m_element_size;
-      char *dst1 = (char *)buf + max_n_0_sz;
-      int64_t max_n_1 = max_n - max_n_0;
-
-      (void)memcpy(buf, (void *)src, max_n_0_sz);
-      (void)memcpy((void *)dst1, (void *)(cb->m_data),
-                   (size_t)max_n_1 * cb->m_element_size);
-    }
+    s_data_copyout(cb, cb->m_r_idx, buf, max_n);
 
     if (do_incr == true) {
       cb->m_n_elements -= max_n;
@@ -225,6 +457,9 @@ s_copyout(lagopus_cbuffer_t cb, void *buf, size_t n, bool do_incr) {
       /*
        * And wake all the putters.
        */
+      if (cb->m_n_waiters > 0) {
+        cb->m_n_wakeups++;
+      }
       (void)lagopus_cond_notify(&(cb->m_cond_put), true);
     }
   }
@@ -296,15 +531,165 @@ s_wait_io_ready(lagopus_cbuffer_t cb,
 }
 
 
+/*
+ * Sleep on a lock-free buffer, with the lock held. Recheck after
+ * being counted as a sleeper, the other side may have moved in
+ * between and not seen us.
+ */
+static inline lagopus_result_t
+s_lf_wait_locked(lagopus_cbuffer_t cb, int side, lagopus_chrono_t nsec) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  lagopus_cond_t *cptr = (side == LF_GET) ?
+                         &(cb->m_cond_get) : &(cb->m_cond_put);
+
+  (void)__sync_fetch_and_add(&(cb->m_n_lf_waiters[side]), 1);
+  if (nsec == 0LL || s_lf_is_ready(cb, side) == true) {
+    ret = LAGOPUS_RESULT_OK;
+  } else {
+    ret = s_wait_io_ready(cb, cptr, nsec);
+  }
+  if (__sync_sub_and_fetch(&(cb->m_n_lf_waiters[side]), 1) > 0 &&
+      cb->m_lf_notified[side] == true &&
+      ret != LAGOPUS_RESULT_OK) {
+    /*
+     * Leaving without acting on the notification, pass it on to
+     * the sleepers it may have been skipped for.
+     */
+    (void)lagopus_cond_notify(cptr, true);
+  }
+  cb->m_lf_notified[side] = false;
+
+  return ret;
+}
+
+
 static inline lagopus_result_t
 s_wait_puttable(lagopus_cbuffer_t cb, lagopus_chrono_t nsec) {
-  return s_wait_io_ready(cb, &(cb->m_cond_put), nsec);
+  if (s_is_lockfree(cb) == true) {
+    return s_lf_wait_locked(cb, LF_PUT, nsec);
+  } else {
+    return s_wait_io_ready(cb, &(cb->m_cond_put), nsec);
+  }
 }
 
 
 static inline lagopus_result_t
 s_wait_gettable(lagopus_cbuffer_t cb, lagopus_chrono_t nsec) {
-  return s_wait_io_ready(cb, &(cb->m_cond_get), nsec);
+  if (s_is_lockfree(cb) == true) {
+    return s_lf_wait_locked(cb, LF_GET, nsec);
+  } else {
+    return s_wait_io_ready(cb, &(cb->m_cond_get), nsec);
+  }
+}
+
+
+/*
+ * put/get for the lock-free modes. Same semantics of nsec as the
+ * locked ones, but the lock is taken only to sleep.
+ */
+static inline lagopus_result_t
+s_lf_put_n(lagopus_cbuffer_t cb,
+           void *valptr,
+           size_t n_vals,
+           size_t valsz,
+           lagopus_chrono_t nsec,
+           int64_t *n_copyin) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  lagopus_chrono_t copy_start = 0;
+  lagopus_chrono_t wait_end;
+  lagopus_chrono_t to = nsec;
+
+  while (true) {
+    mbar();
+    if (cb->m_is_operational == false) {
+      ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
+      break;
+    }
+    if (nsec > 0LL) {
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(copy_start);
+    }
+    *n_copyin += s_lf_copyin(cb,
+                             (void *)((char *)valptr +
+                                      ((size_t)*n_copyin * valsz)),
+                             n_vals - (size_t)*n_copyin);
+    if ((size_t)*n_copyin == n_vals || nsec == 0LL) {
+      ret = *n_copyin;
+      break;
+    }
+    s_lock(cb);
+    {
+      ret = s_wait_puttable(cb, to);
+    }
+    s_unlock(cb);
+    if (ret != LAGOPUS_RESULT_OK) {
+      break;
+    }
+    if (nsec > 0LL) {
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(wait_end);
+      to -= (wait_end - copy_start);
+      if (to <= 0LL) {
+        ret = LAGOPUS_RESULT_TIMEDOUT;
+        break;
+      }
+    }
+  }
+
+  return ret;
+}
+
+
+static inline lagopus_result_t
+s_lf_get_n(lagopus_cbuffer_t cb,
+           void *valptr,
+           size_t n_vals_max,
+           size_t n_at_least,
+           size_t valsz,
+           lagopus_chrono_t nsec,
+           int64_t *n_copyout,
+           bool do_incr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  lagopus_chrono_t copy_start = 0;
+  lagopus_chrono_t wait_end;
+  lagopus_chrono_t to = nsec;
+  size_t n_needed = (nsec < 0LL) ? n_vals_max : n_at_least;
+
+  while (true) {
+    mbar();
+    if (cb->m_is_operational == false) {
+      ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
+      break;
+    }
+    if (nsec > 0LL) {
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(copy_start);
+    }
+    *n_copyout += s_lf_copyout(cb,
+                               (void *)((char *)valptr +
+                                        ((size_t)*n_copyout * valsz)),
+                               n_vals_max - (size_t)*n_copyout,
+                               do_incr);
+    if ((size_t)*n_copyout >= n_needed || nsec == 0LL) {
+      ret = *n_copyout;
+      break;
+    }
+    s_lock(cb);
+    {
+      ret = s_wait_gettable(cb, to);
+    }
+    s_unlock(cb);
+    if (ret != LAGOPUS_RESULT_OK) {
+      break;
+    }
+    if (nsec > 0LL) {
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(wait_end);
+      to -= (wait_end - copy_start);
+      if (to <= 0LL) {
+        ret = LAGOPUS_RESULT_TIMEDOUT;
+        break;
+      }
+    }
+  }
+
+  return ret;
 }
 
 
@@ -326,7 +711,11 @@ s_put_n(lagopus_cbuffer_t *cbptr,
 
       int64_t n_copyin = 0LL;
 
-      if (nsec == 0LL) {
+      if (s_is_lockfree(cb) == true) {
+
+        ret = s_lf_put_n(cb, valptr, n_vals, valsz, nsec, &n_copyin);
+
+      } else if (nsec == 0LL) {
 
         s_lock(cb);
         {
@@ -506,7 +895,12 @@ s_get_n(lagopus_cbuffer_t *cbptr,
 
       int64_t n_copyout = 0LL;
 
-      if (nsec == 0LL) {
+      if (s_is_lockfree(cb) == true) {
+
+        ret = s_lf_get_n(cb, valptr, n_vals_max, n_at_least, valsz, nsec,
+                         &n_copyout, do_incr);
+
+      } else if (nsec == 0LL) {
 
         s_lock(cb);
         {
@@ -676,16 +1070,41 @@ lagopus_cbuffer_create_with_size(lagopus_cbuffer_t *cbptr,
                                  size_t elemsize,
                                  int64_t maxelems,
                                  lagopus_cbuffer_value_freeup_proc_t proc) {
+  return lagopus_cbuffer_create_with_size_and_mode(
+           cbptr, elemsize, maxelems, proc, LAGOPUS_CBUFFER_MODE_LOCKED);
+}
+
+
+lagopus_result_t
+lagopus_cbuffer_create_with_size_and_mode(
+  lagopus_cbuffer_t *cbptr,
+  size_t elemsize,
+  int64_t maxelems,
+  lagopus_cbuffer_value_freeup_proc_t proc,
+  lagopus_cbuffer_mode_t mode) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
 
   if (cbptr != NULL &&
       elemsize > 0 &&
-      maxelems > 0) {
+      maxelems > 0 &&
+      (mode == LAGOPUS_CBUFFER_MODE_LOCKED ||
+       mode == LAGOPUS_CBUFFER_MODE_SPSC ||
+       mode == LAGOPUS_CBUFFER_MODE_MPSC)) {
     lagopus_cbuffer_t cb = (lagopus_cbuffer_t)malloc(
                              sizeof(*cb) + elemsize * (size_t)(maxelems + N_EMPTY_ROOM));
+    volatile int64_t *seq = NULL;
 
     *cbptr = NULL;
 
+    if (cb != NULL && mode == LAGOPUS_CBUFFER_MODE_MPSC) {
+      seq = (volatile int64_t *)calloc((size_t)(maxelems + N_EMPTY_ROOM),
+                                       sizeof(int64_t));
+      if (seq == NULL) {
+        free((void *)cb);
+        cb = NULL;
+      }
+    }
+
     if (cb != NULL) {
       if (((ret = lagopus_mutex_create(&(cb->m_lock))) ==
            LAGOPUS_RESULT_OK) &&
@@ -699,6 +1118,13 @@ lagopus_cbuffer_create_with_size(lagopus_cbuffer_t *cbptr,
         cb->m_w_idx = 0;
         cb->m_n_elements = 0;
         cb->m_n_waiters = 0;
+        cb->m_n_wakeups = 0;
+        cb->m_mode = mode;
+        cb->m_seq = seq;
+        cb->m_n_lf_waiters[LF_GET] = 0;
+        cb->m_n_lf_waiters[LF_PUT] = 0;
+        cb->m_lf_notified[LF_GET] = false;
+        cb->m_lf_notified[LF_PUT] = false;
         cb->m_n_max_elements = maxelems;
         cb->m_n_max_allocd_elements = maxelems + N_EMPTY_ROOM;
         cb->m_element_size = elemsize;
@@ -713,6 +1139,7 @@ lagopus_cbuffer_create_with_size(lagopus_cbuffer_t *cbptr,
         ret = LAGOPUS_RESULT_OK;
 
       } else {
+        free((void *)seq);
         free((void *)cb);
       }
     } else {
@@ -759,6 +1186,7 @@ lagopus_cbuffer_destroy(lagopus_cbuffer_t *cbptr,
 
     lagopus_mutex_destroy(&((*cbptr)->m_lock));
 
+    free((void *)(*cbptr)->m_seq);
     free((void *)*cbptr);
     *cbptr = NULL;
   }
@@ -874,12 +1302,12 @@ lagopus_cbuffer_wait_gettable(lagopus_cbuffer_t *cbptr,
 
     s_lock(*cbptr);
     {
-      if ((*cbptr)->m_n_elements > 0) {
-        ret = (*cbptr)->m_n_elements;
+      if (s_n_elements(*cbptr) > 0) {
+        ret = s_n_elements(*cbptr);
       } else {
         ret = s_wait_gettable(*cbptr, nsec);
         if (ret == LAGOPUS_RESULT_OK) {
-          ret = (*cbptr)->m_n_elements;
+          ret = s_n_elements(*cbptr);
         }
       }
     }
@@ -903,13 +1331,13 @@ lagopus_cbuffer_wait_puttable(lagopus_cbuffer_t *cbptr,
 
     s_lock(*cbptr);
     {
-      remains = (*cbptr)->m_n_max_elements - (*cbptr)->m_n_elements;
+      remains = (*cbptr)->m_n_max_elements - s_n_elements(*cbptr);
       if (remains > 0) {
         ret = (lagopus_result_t)remains;
       } else {
         ret = s_wait_puttable(*cbptr, nsec);
         if (ret == LAGOPUS_RESULT_OK) {
-          ret = (*cbptr)->m_n_max_elements - (*cbptr)->m_n_elements;
+          ret = (*cbptr)->m_n_max_elements - s_n_elements(*cbptr);
         }
       }
     }
@@ -1008,7 +1436,7 @@ lagopus_cbuffer_size(lagopus_cbuffer_t *cbptr) {
     s_lock(*cbptr);
     {
       if ((*cbptr)->m_is_operational == true) {
-        ret = (*cbptr)->m_n_elements;
+        ret = s_n_elements(*cbptr);
       } else {
         ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
       }
@@ -1033,7 +1461,7 @@ lagopus_cbuffer_remaining_capacity(lagopus_cbuffer_t *cbptr) {
     s_lock(*cbptr);
     {
       if ((*cbptr)->m_is_operational == true) {
-        ret = (*cbptr)->m_n_max_elements - (*cbptr)->m_n_elements;
+        ret = (*cbptr)->m_n_max_elements - s_n_elements(*cbptr);
       } else {
         ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
       }
@@ -1085,7 +1513,7 @@ lagopus_cbuffer_is_full(lagopus_cbuffer_t *cbptr, bool *retptr) {
     s_lock(*cbptr);
     {
       if ((*cbptr)->m_is_operational == true) {
-        *retptr = ((*cbptr)->m_n_elements >= (*cbptr)->m_n_max_elements) ?
+        *retptr = (s_n_elements(*cbptr) >= (*cbptr)->m_n_max_elements) ?
                   true : false;
         ret = LAGOPUS_RESULT_OK;
       } else {
@@ -1114,7 +1542,7 @@ lagopus_cbuffer_is_empty(lagopus_cbuffer_t *cbptr, bool *retptr) {
     s_lock(*cbptr);
     {
       if ((*cbptr)->m_is_operational == true) {
-        *retptr = ((*cbptr)->m_n_elements == 0) ? true : false;
+        *retptr = (s_n_elements(*cbptr) == 0) ? true : false;
         ret = LAGOPUS_RESULT_OK;
       } else {
         ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
@@ -1154,6 +1582,22 @@ lagopus_cbuffer_is_operational(lagopus_cbuffer_t *cbptr, bool *retptr) {
 }
 
 
+lagopus_result_t
+lagopus_cbuffer_n_wakeups(lagopus_cbuffer_t *cbptr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (cbptr != NULL &&
+      *cbptr != NULL) {
+    ret = (lagopus_result_t)__atomic_load_n(&((*cbptr)->m_n_wakeups),
+                                            __ATOMIC_RELAXED);
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
 void
 lagopus_cbuffer_cancel_janitor(lagopus_cbuffer_t *cbptr) {
   if (cbptr != NULL &&
@@ -1180,8 +1624,8 @@ cbuffer_setup_for_qmuxer(lagopus_cbuffer_t cb,
     s_lock(cb);
     {
       if (cb->m_is_operational == true) {
-        *szptr = cb->m_n_elements;
-        *remptr = cb->m_n_max_elements - cb->m_n_elements;
+        *szptr = s_n_elements(cb);
+        *remptr = cb->m_n_max_elements - *szptr;
 
         ret = 0;
         /*
@@ -1204,6 +1648,23 @@ cbuffer_setup_for_qmuxer(lagopus_cbuffer_t cb,
         if (is_pre == true && ret > 0) {
           cb->m_qmuxer = qmx;
           cb->m_type = ret;
+          if (s_is_lockfree(cb) == true) {
+            /*
+             * Producer/consumer don't take the lock to check
+             * m_qmuxer, recheck after publishing it.
+             */
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            *szptr = s_n_elements(cb);
+            *remptr = cb->m_n_max_elements - *szptr;
+            if ((ret == (lagopus_result_t)LAGOPUS_QMUXER_POLL_READABLE &&
+                 s_lf_n_gettable(cb, 1LL) > 0) ||
+                (ret == (lagopus_result_t)LAGOPUS_QMUXER_POLL_WRITABLE &&
+                 *remptr > 0)) {
+              cb->m_qmuxer = NULL;
+              cb->m_type = 0;
+              ret = 0;
+            }
+          }
         } else {
           /*
            * We need this since the qmx could be not available when the
@@ -0,0 +1,475 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Included from hashmap.c, after hash.c.
+ */
+
+static CHashNode s_chash_tombstone;
+#define CHASH_TOMBSTONE	(&s_chash_tombstone)
+
+/*
+ * Epoch domain shared by all the concurrent hash tables.  Anything
+ * retired at epoch e is freed once the global epoch reaches e + 2.
+ */
+static uint64_t s_chash_epoch = 1;
+static CHashReader *s_chash_readers = NULL;
+static pthread_mutex_t s_chash_readers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t s_chash_once = PTHREAD_ONCE_INIT;
+static pthread_key_t s_chash_key;
+static bool s_chash_key_is_valid = false;
+static __thread CHashReader *s_chash_self = NULL;
+
+
+
+
+
+static void
+s_chash_reader_release(void *arg) {
+  CHashReader *r = (CHashReader *)arg;
+
+  __atomic_store_n(&(r->epoch), 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&(r->inUse), false, __ATOMIC_RELEASE);
+}
+
+
+static void
+s_chash_once_proc(void) {
+  if (pthread_key_create(&s_chash_key, s_chash_reader_release) == 0) {
+    s_chash_key_is_valid = true;
+  }
+}
+
+
+static CHashReader *
+s_chash_reader_register(void) {
+  CHashReader *r;
+
+  (void)pthread_once(&s_chash_once, s_chash_once_proc);
+
+  (void)pthread_mutex_lock(&s_chash_readers_lock);
+  {
+    for (r = s_chash_readers; r != NULL; r = r->nextPtr) {
+      if (__atomic_load_n(&(r->inUse), __ATOMIC_ACQUIRE) == false) {
+        break;
+      }
+    }
+    if (r == NULL) {
+      r = (CHashReader *)calloc(1, sizeof(*r));
+      if (r != NULL) {
+        r->nextPtr = s_chash_readers;
+        __atomic_store_n(&s_chash_readers, r, __ATOMIC_RELEASE);
+      }
+    }
+    if (r != NULL) {
+      r->depth = 0;
+      __atomic_store_n(&(r->epoch), 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&(r->inUse), true, __ATOMIC_RELEASE);
+      if (s_chash_key_is_valid == true) {
+        (void)pthread_setspecific(s_chash_key, (void *)r);
+      }
+      s_chash_self = r;
+    }
+  }
+  (void)pthread_mutex_unlock(&s_chash_readers_lock);
+
+  return r;
+}
+
+
+/*
+ * Announce the current epoch.  A plain store and a fence, no RMW.
+ */
+static inline CHashReader *
+s_chash_read_enter(void) {
+  CHashReader *r = s_chash_self;
+
+  if (r == NULL && (r = s_chash_reader_register()) == NULL) {
+    return NULL;
+  }
+  if (r->depth++ == 0) {
+    __atomic_store_n(&(r->epoch),
+                     (__atomic_load_n(&s_chash_epoch, __ATOMIC_ACQUIRE) << 1) |
+                     1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  }
+
+  return r;
+}
+
+
+static inline void
+s_chash_read_leave(CHashReader *r) {
+  if (--r->depth == 0) {
+    __atomic_store_n(&(r->epoch), 0, __ATOMIC_RELEASE);
+  }
+}
+
+
+static void
+s_chash_epoch_advance(void) {
+  uint64_t e = __atomic_load_n(&s_chash_epoch, __ATOMIC_SEQ_CST);
+  uint64_t v;
+  CHashReader *r;
+
+  for (r = __atomic_load_n(&s_chash_readers, __ATOMIC_ACQUIRE);
+       r != NULL;
+       r = r->nextPtr) {
+    v = __atomic_load_n(&(r->epoch), __ATOMIC_SEQ_CST);
+    if ((v & 1) != 0 && (v >> 1) != e) {
+      return;
+    }
+  }
+  (void)__atomic_compare_exchange_n(&s_chash_epoch, &e, e + 1, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+
+static inline void
+s_chash_retire(CHashTable *tablePtr, CHashRetire *p) {
+  /* The unlink must be visible before the epoch is sampled. */
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  p->nextPtr = NULL;
+  p->epoch = __atomic_load_n(&s_chash_epoch, __ATOMIC_SEQ_CST);
+  if (tablePtr->retiredTail != NULL) {
+    tablePtr->retiredTail->nextPtr = p;
+  } else {
+    tablePtr->retiredHead = p;
+  }
+  tablePtr->retiredTail = p;
+}
+
+
+static void
+s_chash_reclaim(CHashTable *tablePtr) {
+  CHashRetire *p;
+  uint64_t e;
+
+  if (tablePtr->retiredHead == NULL) {
+    return;
+  }
+  s_chash_epoch_advance();
+  e = __atomic_load_n(&s_chash_epoch, __ATOMIC_SEQ_CST);
+  while ((p = tablePtr->retiredHead) != NULL && p->epoch + 2 <= e) {
+    tablePtr->retiredHead = p->nextPtr;
+    free((void *)p);
+  }
+  if (tablePtr->retiredHead == NULL) {
+    tablePtr->retiredTail = NULL;
+  }
+}
+
+
+
+
+
+static inline unsigned int
+s_chash_hash(const CHashTable *tablePtr, const void *key) {
+  if (tablePtr->keyType == HASH_STRING_KEYS) {
+    return HashString((const char *)key);
+  } else {
+    uint64_t h = (uint64_t)(uintptr_t)key * 0x9e3779b97f4a7c15ULL;
+    return (unsigned int)(h >> 32);
+  }
+}
+
+
+static inline bool
+s_chash_key_equal(const CHashTable *tablePtr, const CHashNode *nodePtr,
+                  unsigned int hash, const void *key) {
+  if (nodePtr->hash != hash) {
+    return false;
+  }
+  if (tablePtr->keyType == HASH_STRING_KEYS) {
+    return (strcmp((const char *)nodePtr->key, (const char *)key) == 0);
+  } else {
+    return (nodePtr->key == key);
+  }
+}
+
+
+static CHashArray *
+s_chash_array_alloc(size_t size) {
+  CHashArray *arrayPtr;
+
+  arrayPtr = (CHashArray *)calloc(1, sizeof(CHashArray) +
+                                  size * sizeof(CHashNode *));
+  if (arrayPtr != NULL) {
+    arrayPtr->size = size;
+  }
+
+  return arrayPtr;
+}
+
+
+static inline lagopus_result_t
+s_chash_init(CHashTable *tablePtr, unsigned int keyType) {
+  (void)memset(tablePtr, 0, sizeof(*tablePtr));
+  tablePtr->keyType = keyType;
+  tablePtr->arrayPtr = s_chash_array_alloc(CHASH_INITIAL_SIZE);
+
+  return (tablePtr->arrayPtr != NULL) ?
+         LAGOPUS_RESULT_OK : LAGOPUS_RESULT_NO_MEMORY;
+}
+
+
+/*
+ * No reader may be left, everything is freed right away.
+ */
+static void
+s_chash_destroy(CHashTable *tablePtr) {
+  CHashArray *arrayPtr = tablePtr->arrayPtr;
+  CHashRetire *p;
+  size_t i;
+
+  if (arrayPtr != NULL) {
+    for (i = 0; i < arrayPtr->size; i++) {
+      if (arrayPtr->slots[i] != NULL &&
+          arrayPtr->slots[i] != CHASH_TOMBSTONE) {
+        free((void *)arrayPtr->slots[i]);
+      }
+    }
+    free((void *)arrayPtr);
+    tablePtr->arrayPtr = NULL;
+  }
+  while ((p = tablePtr->retiredHead) != NULL) {
+    tablePtr->retiredHead = p->nextPtr;
+    free((void *)p);
+  }
+  tablePtr->retiredTail = NULL;
+}
+
+
+
+
+
+/*
+ * Reader side, call between s_chash_read_enter() and
+ * s_chash_read_leave() or with the writer lock held.
+ */
+static inline CHashNode *
+s_chash_find(const CHashTable *tablePtr, const void *key) {
+  CHashArray *arrayPtr = __atomic_load_n(&(tablePtr->arrayPtr),
+                                         __ATOMIC_ACQUIRE);
+  CHashNode *nodePtr;
+  unsigned int hash = s_chash_hash(tablePtr, key);
+  size_t mask = arrayPtr->size - 1;
+  size_t i, n;
+
+  for (i = hash & mask, n = 0; n < arrayPtr->size; i = (i + 1) & mask, n++) {
+    nodePtr = __atomic_load_n(&(arrayPtr->slots[i]), __ATOMIC_ACQUIRE);
+    if (nodePtr == NULL) {
+      break;
+    }
+    if (nodePtr != CHASH_TOMBSTONE &&
+        s_chash_key_equal(tablePtr, nodePtr, hash, key) == true) {
+      return nodePtr;
+    }
+  }
+
+  return NULL;
+}
+
+
+static inline void
+s_chash_array_put(CHashArray *arrayPtr, CHashNode *nodePtr) {
+  size_t mask = arrayPtr->size - 1;
+  size_t i;
+
+  for (i = nodePtr->hash & mask; ; i = (i + 1) & mask) {
+    if (arrayPtr->slots[i] == NULL ||
+        arrayPtr->slots[i] == CHASH_TOMBSTONE) {
+      if (arrayPtr->slots[i] == NULL) {
+        arrayPtr->numUsed++;
+      }
+      __atomic_store_n(&(arrayPtr->slots[i]), nodePtr, __ATOMIC_RELEASE);
+      return;
+    }
+  }
+}
+
+
+/*
+ * Copy the live nodes into a new array sized for them and publish it,
+ * which also drops all the tombstones.
+ */
+static lagopus_result_t
+s_chash_rebuild(CHashTable *tablePtr, size_t numEntries) {
+  CHashArray *oldPtr = tablePtr->arrayPtr;
+  CHashArray *newPtr;
+  size_t size = CHASH_INITIAL_SIZE;
+  size_t i;
+
+  while (size < (numEntries + 1) * 2) {
+    size <<= 1;
+  }
+  if ((newPtr = s_chash_array_alloc(size)) == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  for (i = 0; i < oldPtr->size; i++) {
+    if (oldPtr->slots[i] != NULL && oldPtr->slots[i] != CHASH_TOMBSTONE) {
+      s_chash_array_put(newPtr, oldPtr->slots[i]);
+    }
+  }
+  __atomic_store_n(&(tablePtr->arrayPtr), newPtr, __ATOMIC_RELEASE);
+  s_chash_retire(tablePtr, &(oldPtr->retire));
+
+  return LAGOPUS_RESULT_OK;
+}
+
+
+/*
+ * Writer side, the caller holds the writer lock.
+ */
+static lagopus_result_t
+s_chash_add(CHashTable *tablePtr, const void *key, void *val,
+            size_t numEntries) {
+  lagopus_result_t ret;
+  CHashNode *nodePtr;
+  size_t len = 0;
+
+  /* Keep the load, tombstones included, under 3/4. */
+  if ((tablePtr->arrayPtr->numUsed + 1) * 4 > tablePtr->arrayPtr->size * 3) {
+    if ((ret = s_chash_rebuild(tablePtr, numEntries + 1)) !=
+        LAGOPUS_RESULT_OK) {
+      return ret;
+    }
+  }
+
+  if (tablePtr->keyType == HASH_STRING_KEYS) {
+    len = strlen((const char *)key) + 1;
+  }
+  if ((nodePtr = (CHashNode *)malloc(sizeof(CHashNode) + len)) == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  nodePtr->hash = s_chash_hash(tablePtr, key);
+  if (tablePtr->keyType == HASH_STRING_KEYS) {
+    (void)memcpy(nodePtr->string, key, len);
+    nodePtr->key = nodePtr->string;
+  } else {
+    nodePtr->key = key;
+  }
+  nodePtr->value = val;
+  s_chash_array_put(tablePtr->arrayPtr, nodePtr);
+  s_chash_reclaim(tablePtr);
+
+  return LAGOPUS_RESULT_OK;
+}
+
+
+static inline void
+s_chash_set_value(CHashNode *nodePtr, void *val) {
+  __atomic_store_n(&(nodePtr->value), val, __ATOMIC_RELEASE);
+}
+
+
+static inline void *
+s_chash_get_value(CHashNode *nodePtr) {
+  return __atomic_load_n(&(nodePtr->value), __ATOMIC_ACQUIRE);
+}
+
+
+static void
+s_chash_delete(CHashTable *tablePtr, CHashNode *nodePtr) {
+  CHashArray *arrayPtr = tablePtr->arrayPtr;
+  size_t mask = arrayPtr->size - 1;
+  size_t i;
+
+  for (i = nodePtr->hash & mask; ; i = (i + 1) & mask) {
+    if (arrayPtr->slots[i] == nodePtr) {
+      __atomic_store_n(&(arrayPtr->slots[i]), CHASH_TOMBSTONE,
+                       __ATOMIC_RELEASE);
+      break;
+    }
+  }
+  s_chash_retire(tablePtr, &(nodePtr->retire));
+  s_chash_reclaim(tablePtr);
+}
+
+
+static lagopus_result_t
+s_chash_clear(CHashTable *tablePtr) {
+  CHashArray *oldPtr = tablePtr->arrayPtr;
+  CHashArray *newPtr;
+  size_t i;
+
+  if ((newPtr = s_chash_array_alloc(CHASH_INITIAL_SIZE)) == NULL) {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+  __atomic_store_n(&(tablePtr->arrayPtr), newPtr, __ATOMIC_RELEASE);
+  for (i = 0; i < oldPtr->size; i++) {
+    if (oldPtr->slots[i] != NULL && oldPtr->slots[i] != CHASH_TOMBSTONE) {
+      s_chash_retire(tablePtr, &(oldPtr->slots[i]->retire));
+    }
+  }
+  s_chash_retire(tablePtr, &(oldPtr->retire));
+  s_chash_reclaim(tablePtr);
+
+  return LAGOPUS_RESULT_OK;
+}
+
+
+/*
+ * The proc gets a HashEntry holding the value so that
+ * lagopus_hashmap_set_value() works as for the other tables.
+ */
+static bool
+s_chash_iterate(CHashTable *tablePtr,
+                lagopus_hashmap_iteration_proc_t proc, void *arg) {
+  CHashArray *arrayPtr = tablePtr->arrayPtr;
+  CHashNode *nodePtr;
+  HashEntry entry;
+  void *val;
+  size_t i;
+  bool ret = true;
+
+  for (i = 0; i < arrayPtr->size && ret == true; i++) {
+    nodePtr = arrayPtr->slots[i];
+    if (nodePtr != NULL && nodePtr != CHASH_TOMBSTONE) {
+      val = s_chash_get_value(nodePtr);
+      (void)memset(&entry, 0, sizeof(entry));
+      SetHashValue(&entry, val);
+      ret = proc((void *)nodePtr->key, val, &entry, arg);
+      if (GetHashValue(&entry) != val) {
+        s_chash_set_value(nodePtr, GetHashValue(&entry));
+      }
+    }
+  }
+
+  return ret;
+}
+
+
+static char *
+s_chash_stats(const CHashTable *tablePtr, size_t numEntries) {
+  const CHashArray *arrayPtr = tablePtr->arrayPtr;
+  char *buf;
+  size_t len = 128;
+
+  if ((buf = (char *)malloc(len)) != NULL) {
+    snprintf(buf, len,
+             "%zu entries in table, %zu slots, %zu tombstones\n",
+             numEntries, arrayPtr->size, arrayPtr->numUsed - numEntries);
+  }
+
+  return buf;
+}
+
+
+static void
+s_chash_atfork_child(void) {
+  (void)pthread_mutex_init(&s_chash_readers_lock, NULL);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file	chash.h
+ * @brief	Read-mostly hash table for LAGOPUS_HASHMAP_TYPE_CONCURRENT.
+ *
+ * Open addressing with linear probing over an array of node
+ * pointers.  Readers take no lock and do no atomic read-modify-write,
+ * they announce themselves in a per-thread epoch record instead.
+ * Writers are serialized by the caller, publish with release stores
+ * and retire unlinked nodes and tables until no reader can see them.
+ */
+
+#ifndef __CHASH_H__
+#define __CHASH_H__
+
+#ifndef CHASH_INITIAL_SIZE
+#define CHASH_INITIAL_SIZE	16
+#endif /* CHASH_INITIAL_SIZE */
+
+/**
+ * Link for deferred free, first member of nodes and tables.
+ */
+typedef struct CHashRetire {
+  struct CHashRetire *nextPtr;
+  uint64_t epoch;			/* Global epoch when retired. */
+} CHashRetire;
+
+typedef struct CHashNode {
+  CHashRetire retire;
+  unsigned int hash;
+  const void *key;			/* The key, or points to string. */
+  void *value;
+  char string[0];			/* Copy of a string key. */
+} CHashNode;
+
+typedef struct CHashArray {
+  CHashRetire retire;
+  size_t size;				/* Number of slots, power of 2. */
+  size_t numUsed;			/* Live nodes and tombstones. */
+  CHashNode *slots[0];
+} CHashArray;
+
+/**
+ * Per-thread reader record, never freed, reused after thread exit.
+ */
+typedef struct CHashReader {
+  struct CHashReader *nextPtr;
+  uint64_t epoch;			/* epoch << 1 | 1 while reading. */
+  unsigned int depth;			/* Nesting, owner thread only. */
+  bool inUse;
+} CHashReader;
+
+typedef struct CHashTable {
+  CHashArray *arrayPtr;			/* Published slot array. */
+  unsigned int keyType;			/* String or one word keys. */
+  CHashRetire *retiredHead;		/* Waiting for readers to leave. */
+  CHashRetire *retiredTail;
+} CHashTable;
+
+#endif /* ! __CHASH_H__ */
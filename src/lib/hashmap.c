@@ -22,6 +22,8 @@
 
 #include "hash.h"
 #include "hash.c"
+#include "chash.h"
+#include "chash.c"
 
 
 
@@ -31,6 +33,9 @@ typedef struct lagopus_hashmap_record {
   lagopus_hashmap_type_t m_type;
   lagopus_rwlock_t m_lock;
   HashTable m_hashtable;
+  bool m_is_concurrent;
+  lagopus_mutex_t m_wlock;
+  CHashTable m_chashtable;
   lagopus_hashmap_value_freeup_proc_t m_del_proc;
   ssize_t m_n_entries;
   bool m_is_operational;
@@ -40,18 +45,33 @@ typedef struct lagopus_hashmap_record {
 
 
 
+/*
+ * Readers of a concurrent hash map take no lock, see s_find().
+ */
 static inline void
 s_read_lock(lagopus_hashmap_t hm, int *ostateptr) {
-  if (hm != NULL && ostateptr != NULL) {
+  if (hm != NULL && ostateptr != NULL && hm->m_is_concurrent == false) {
     (void)lagopus_rwlock_reader_enter_critical(&(hm->m_lock), ostateptr);
   }
 }
 
 
+static inline void
+s_read_unlock(lagopus_hashmap_t hm, int ostate) {
+  if (hm != NULL && hm->m_is_concurrent == false) {
+    (void)lagopus_rwlock_leave_critical(&(hm->m_lock), ostate);
+  }
+}
+
+
 static inline void
 s_write_lock(lagopus_hashmap_t hm, int *ostateptr) {
   if (hm != NULL && ostateptr != NULL) {
-    (void)lagopus_rwlock_writer_enter_critical(&(hm->m_lock), ostateptr);
+    if (hm->m_is_concurrent == true) {
+      (void)lagopus_mutex_enter_critical(&(hm->m_wlock), ostateptr);
+    } else {
+      (void)lagopus_rwlock_writer_enter_critical(&(hm->m_lock), ostateptr);
+    }
   }
 }
 
@@ -59,16 +79,39 @@ s_write_lock(lagopus_hashmap_t hm, int *ostateptr) {
 static inline void
 s_unlock(lagopus_hashmap_t hm, int ostate) {
   if (hm != NULL) {
-    (void)lagopus_rwlock_leave_critical(&(hm->m_lock), ostate);
+    if (hm->m_is_concurrent == true) {
+      (void)lagopus_mutex_leave_critical(&(hm->m_wlock), ostate);
+    } else {
+      (void)lagopus_rwlock_leave_critical(&(hm->m_lock), ostate);
+    }
   }
 }
 
 
+static inline ssize_t
+s_n_entries(lagopus_hashmap_t hm) {
+  return __atomic_load_n(&(hm->m_n_entries), __ATOMIC_RELAXED);
+}
+
+
+static inline void
+s_n_entries_set(lagopus_hashmap_t hm, ssize_t n) {
+  __atomic_store_n(&(hm->m_n_entries), n, __ATOMIC_RELAXED);
+}
+
+
 static inline bool
 s_do_iterate(lagopus_hashmap_t hm,
              lagopus_hashmap_iteration_proc_t proc, void *arg) {
   bool ret = false;
-  if (hm != NULL && proc != NULL) {
+  if (hm != NULL && proc != NULL && hm->m_is_concurrent == true) {
+    /* Keep the arrays alive if the proc modifies the hash map. */
+    CHashReader *r = s_chash_read_enter();
+    if (r != NULL) {
+      ret = s_chash_iterate(&(hm->m_chashtable), proc, arg);
+      s_chash_read_leave(r);
+    }
+  } else if (hm != NULL && proc != NULL) {
     HashSearch s;
     lagopus_hashentry_t he;
 
@@ -143,6 +186,12 @@ s_clean(lagopus_hashmap_t hm, bool free_values) {
   if (free_values == true) {
     s_freeup_all_values(hm);
   }
+  if (hm->m_is_concurrent == true) {
+    /* Readers may still walk the old array, retire it. */
+    (void)s_chash_clear(&(hm->m_chashtable));
+    s_n_entries_set(hm, 0);
+    return;
+  }
   DeleteHashTable(&(hm->m_hashtable));
   (void)memset(&(hm->m_hashtable), 0, sizeof(HashTable));
   hm->m_n_entries = 0;
@@ -152,7 +201,9 @@ s_clean(lagopus_hashmap_t hm, bool free_values) {
 static inline void
 s_reinit(lagopus_hashmap_t hm, bool free_values) {
   s_clean(hm, free_values);
-  InitHashTable(&(hm->m_hashtable), (unsigned int)hm->m_type);
+  if (hm->m_is_concurrent == false) {
+    InitHashTable(&(hm->m_hashtable), (unsigned int)hm->m_type);
+  }
 }
 
 
@@ -174,7 +225,37 @@ lagopus_hashmap_create(lagopus_hashmap_t *retptr,
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
   lagopus_hashmap_t hm;
 
-  if (retptr != NULL) {
+  if (retptr != NULL &&
+      (t & LAGOPUS_HASHMAP_TYPE_CONCURRENT) != 0) {
+    *retptr = NULL;
+    t &= ~LAGOPUS_HASHMAP_TYPE_CONCURRENT;
+    if (t != LAGOPUS_HASHMAP_TYPE_STRING &&
+        t != LAGOPUS_HASHMAP_TYPE_ONE_WORD) {
+      return LAGOPUS_RESULT_INVALID_ARGS;
+    }
+    hm = (lagopus_hashmap_t)calloc(1, sizeof(*hm));
+    if (hm != NULL) {
+      if ((ret = lagopus_mutex_create(&(hm->m_wlock))) ==
+          LAGOPUS_RESULT_OK) {
+        if ((ret = s_chash_init(&(hm->m_chashtable), (unsigned int)t)) ==
+            LAGOPUS_RESULT_OK) {
+          hm->m_type = t;
+          hm->m_is_concurrent = true;
+          hm->m_del_proc = proc;
+          hm->m_n_entries = 0;
+          hm->m_is_operational = true;
+          *retptr = hm;
+        } else {
+          lagopus_mutex_destroy(&(hm->m_wlock));
+          free((void *)hm);
+        }
+      } else {
+        free((void *)hm);
+      }
+    } else {
+      ret = LAGOPUS_RESULT_NO_MEMORY;
+    }
+  } else if (retptr != NULL) {
     *retptr = NULL;
     hm = (lagopus_hashmap_t)malloc(sizeof(*hm));
     if (hm != NULL) {
@@ -182,6 +263,7 @@ lagopus_hashmap_create(lagopus_hashmap_t *retptr,
           LAGOPUS_RESULT_OK) {
         hm->m_type = t;
         InitHashTable(&(hm->m_hashtable), (unsigned int)t);
+        hm->m_is_concurrent = false;
         hm->m_del_proc = proc;
         hm->m_n_entries = 0;
         hm->m_is_operational = true;
@@ -235,7 +317,12 @@ lagopus_hashmap_destroy(lagopus_hashmap_t *hmptr, bool free_values) {
     }
     s_unlock(*hmptr, cstate);
 
-    lagopus_rwlock_destroy(&((*hmptr)->m_lock));
+    if ((*hmptr)->m_is_concurrent == true) {
+      s_chash_destroy(&((*hmptr)->m_chashtable));
+      lagopus_mutex_destroy(&((*hmptr)->m_wlock));
+    } else {
+      lagopus_rwlock_destroy(&((*hmptr)->m_lock));
+    }
     free((void *)*hmptr);
     *hmptr = NULL;
   }
@@ -302,6 +389,32 @@ lagopus_hashmap_clear_no_lock(lagopus_hashmap_t *hmptr, bool free_values) {
 
 
 
+static inline lagopus_result_t
+s_find_concurrent(lagopus_hashmap_t hm, void *key, void **valptr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  CHashReader *r;
+  CHashNode *node;
+
+  if (__atomic_load_n(&(hm->m_is_operational), __ATOMIC_ACQUIRE) == true) {
+    if ((r = s_chash_read_enter()) != NULL) {
+      if ((node = s_chash_find(&(hm->m_chashtable), key)) != NULL) {
+        *valptr = s_chash_get_value(node);
+        ret = LAGOPUS_RESULT_OK;
+      } else {
+        ret = LAGOPUS_RESULT_NOT_FOUND;
+      }
+      s_chash_read_leave(r);
+    } else {
+      ret = LAGOPUS_RESULT_NO_MEMORY;
+    }
+  } else {
+    ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
+  }
+
+  return ret;
+}
+
+
 static inline lagopus_result_t
 s_find(lagopus_hashmap_t *hmptr,
        void *key, void **valptr) {
@@ -310,6 +423,10 @@ s_find(lagopus_hashmap_t *hmptr,
 
   *valptr = NULL;
 
+  if ((*hmptr)->m_is_concurrent == true) {
+    return s_find_concurrent(*hmptr, key, valptr);
+  }
+
   if ((*hmptr)->m_is_operational == true) {
     if ((he = s_find_entry(*hmptr, key)) != NULL) {
       *valptr = GetHashValue(he);
@@ -357,7 +474,7 @@ lagopus_hashmap_find(lagopus_hashmap_t *hmptr, void *key, void **valptr) {
     {
       ret = s_find(hmptr, key, valptr);
     }
-    s_unlock(*hmptr, cstate);
+    s_read_unlock(*hmptr, cstate);
 
   } else {
     ret = LAGOPUS_RESULT_INVALID_ARGS;
@@ -370,6 +487,35 @@ lagopus_hashmap_find(lagopus_hashmap_t *hmptr, void *key, void **valptr) {
 
 
 
+static inline lagopus_result_t
+s_add_concurrent(lagopus_hashmap_t hm,
+                 void *key, void **valptr,
+                 bool allow_overwrite) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  void *oldval = NULL;
+  CHashNode *node;
+
+  if ((node = s_chash_find(&(hm->m_chashtable), key)) != NULL) {
+    oldval = s_chash_get_value(node);
+    if (allow_overwrite == true) {
+      s_chash_set_value(node, *valptr);
+      ret = LAGOPUS_RESULT_OK;
+    } else {
+      ret = LAGOPUS_RESULT_ALREADY_EXISTS;
+    }
+  } else {
+    ret = s_chash_add(&(hm->m_chashtable), key, *valptr,
+                      (size_t)hm->m_n_entries);
+    if (ret == LAGOPUS_RESULT_OK) {
+      s_n_entries_set(hm, hm->m_n_entries + 1);
+    }
+  }
+  *valptr = oldval;
+
+  return ret;
+}
+
+
 static inline lagopus_result_t
 s_add(lagopus_hashmap_t *hmptr,
       void *key, void **valptr,
@@ -378,7 +524,10 @@ s_add(lagopus_hashmap_t *hmptr,
   void *oldval = NULL;
   lagopus_hashentry_t he;
 
-  if ((*hmptr)->m_is_operational == true) {
+  if ((*hmptr)->m_is_operational == true &&
+      (*hmptr)->m_is_concurrent == true) {
+    ret = s_add_concurrent(*hmptr, key, valptr, allow_overwrite);
+  } else if ((*hmptr)->m_is_operational == true) {
     if ((he = s_find_entry(*hmptr, key)) != NULL) {
       oldval = GetHashValue(he);
       if (allow_overwrite == true) {
@@ -461,8 +610,22 @@ s_delete(lagopus_hashmap_t *hmptr,
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
   void *val = NULL;
   lagopus_hashentry_t he;
-
-  if ((*hmptr)->m_is_operational == true) {
+  CHashNode *node;
+
+  if ((*hmptr)->m_is_operational == true &&
+      (*hmptr)->m_is_concurrent == true) {
+    if ((node = s_chash_find(&((*hmptr)->m_chashtable), key)) != NULL) {
+      val = s_chash_get_value(node);
+      s_chash_delete(&((*hmptr)->m_chashtable), node);
+      s_n_entries_set(*hmptr, (*hmptr)->m_n_entries - 1);
+      if (val != NULL &&
+          free_value == true &&
+          (*hmptr)->m_del_proc != NULL) {
+        (*hmptr)->m_del_proc(val);
+      }
+    }
+    ret = LAGOPUS_RESULT_OK;
+  } else if ((*hmptr)->m_is_operational == true) {
     if ((he = s_find_entry(*hmptr, key)) != NULL) {
       val = GetHashValue(he);
       if (val != NULL &&
@@ -614,12 +777,12 @@ lagopus_hashmap_size(lagopus_hashmap_t *hmptr) {
     s_read_lock(*hmptr, &cstate);
     {
       if ((*hmptr)->m_is_operational == true) {
-        ret = (*hmptr)->m_n_entries;
+        ret = s_n_entries(*hmptr);
       } else {
         ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
       }
     }
-    s_unlock(*hmptr, cstate);
+    s_read_unlock(*hmptr, cstate);
 
   } else {
     ret = LAGOPUS_RESULT_INVALID_ARGS;
@@ -637,7 +800,7 @@ lagopus_hashmap_size_no_lock(lagopus_hashmap_t *hmptr) {
       *hmptr != NULL) {
 
     if ((*hmptr)->m_is_operational == true) {
-      ret = (*hmptr)->m_n_entries;
+      ret = s_n_entries(*hmptr);
     } else {
       ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
     }
@@ -661,6 +824,22 @@ lagopus_hashmap_statistics(lagopus_hashmap_t *hmptr, const char **msgptr) {
 
     *msgptr = NULL;
 
+    if ((*hmptr)->m_is_concurrent == true) {
+      s_write_lock(*hmptr, &cstate);
+      {
+        if ((*hmptr)->m_is_operational == true) {
+          *msgptr = (const char *)s_chash_stats(&((*hmptr)->m_chashtable),
+                                                (size_t)(*hmptr)->m_n_entries);
+          ret = (*msgptr != NULL) ?
+                LAGOPUS_RESULT_OK : LAGOPUS_RESULT_NO_MEMORY;
+        } else {
+          ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
+        }
+      }
+      s_unlock(*hmptr, cstate);
+      return ret;
+    }
+
     s_read_lock(*hmptr, &cstate);
     {
       if ((*hmptr)->m_is_operational == true) {
@@ -674,7 +853,7 @@ lagopus_hashmap_statistics(lagopus_hashmap_t *hmptr, const char **msgptr) {
         ret = LAGOPUS_RESULT_NOT_OPERATIONAL;
       }
     }
-    s_unlock(*hmptr, cstate);
+    s_read_unlock(*hmptr, cstate);
 
   } else {
     ret = LAGOPUS_RESULT_INVALID_ARGS;
@@ -688,6 +867,11 @@ void
 lagopus_hashmap_atfork_child(lagopus_hashmap_t *hmptr) {
   if (hmptr != NULL &&
       *hmptr != NULL) {
-    lagopus_rwlock_reinitialize(&((*hmptr)->m_lock));
+    if ((*hmptr)->m_is_concurrent == true) {
+      lagopus_mutex_reinitialize(&((*hmptr)->m_wlock));
+      s_chash_atfork_child();
+    } else {
+      lagopus_rwlock_reinitialize(&((*hmptr)->m_lock));
+    }
   }
 }
@@ -15,6 +15,7 @@
  */
 
 #include "lagopus_apis.h"
+#include <sys/uio.h>
 
 
 
@@ -35,6 +36,53 @@ static char s_exefile[PATH_MAX];
 #endif /* HAVE_PROCFS_SELF_EXE */
 
 
+/*
+ * Asynchronous mode: each thread appends formatted messages to its
+ * own ring and a writer thread drains all the rings with writev(2).
+ */
+
+#ifndef LAGOPUS_LOG_RING_SIZE
+#define LAGOPUS_LOG_RING_SIZE	(64 * 1024)
+#endif /* ! LAGOPUS_LOG_RING_SIZE */
+
+#ifndef LAGOPUS_LOG_WRITER_INTERVAL
+#define LAGOPUS_LOG_WRITER_INTERVAL	(10LL * 1000LL * 1000LL)	/* nsec. */
+#endif /* ! LAGOPUS_LOG_WRITER_INTERVAL */
+
+#define LOG_IOV_MAX	64
+#define LOG_REC_SKIP	UINT32_MAX	/* Padding up to the ring end. */
+#define LOG_REC_SIZE(len)                                       \
+  ((sizeof(log_rec_hdr_t) + (uint64_t)(len) + 1 + 7) & ~(uint64_t)7)
+
+typedef struct {
+  uint32_t m_len;		/* Message length without '\0'. */
+  uint32_t m_level;
+} log_rec_hdr_t;
+
+typedef struct log_ring {
+  struct log_ring *m_next;
+  volatile uint64_t m_head;	/* Advanced by the writer. */
+  volatile uint64_t m_tail;	/* Advanced by the owner thread. */
+  volatile uint64_t m_n_dropped;
+  volatile bool m_in_use;
+  char m_buf[LAGOPUS_LOG_RING_SIZE];
+} log_ring_t;
+
+static volatile bool s_log_async = false;
+static log_ring_t *volatile s_log_rings = NULL;
+static pthread_mutex_t s_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t s_ring_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t s_ring_key;
+static bool s_ring_key_ok = false;
+static __thread log_ring_t *s_my_ring = NULL;
+static uint64_t s_n_dropped_reported = 0;
+
+static pthread_mutex_t s_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_writer_tid;
+static bool s_writer_running = false;
+
+
 static const char *const s_log_level_strs[] = {
   "",
   "[DEBUG]",
@@ -98,7 +146,21 @@ static size_t s_n_trace_strs = sizeof(s_trace_strs) / sizeof(char *);
 
 static void
 s_child_at_fork(void) {
+  log_ring_t *r;
+
   (void)pthread_mutex_init(&s_log_lock, NULL);
+
+  /*
+   * No writer in the child, and the parent emits what is pending.
+   */
+  (void)pthread_mutex_init(&s_rings_lock, NULL);
+  (void)pthread_mutex_init(&s_writer_lock, NULL);
+  (void)pthread_cond_init(&s_writer_cond, NULL);
+  s_writer_running = false;
+  s_log_async = false;
+  for (r = s_log_rings; r != NULL; r = r->m_next) {
+    r->m_head = r->m_tail;
+  }
 }
 
 
@@ -336,6 +398,121 @@ done:
 }
 
 
+static inline void
+s_writev_all(int fd, struct iovec *iov, int n_iov) {
+  ssize_t n;
+
+  while (n_iov > 0) {
+    if ((n = writev(fd, iov, n_iov)) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    while (n_iov > 0 && (size_t)n >= iov->iov_len) {
+      n -= (ssize_t)iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (n_iov > 0) {
+      iov->iov_base = (char *)iov->iov_base + n;
+      iov->iov_len -= (size_t)n;
+    }
+  }
+}
+
+
+static inline void
+s_emit_raw(int fd, lagopus_log_level_t l, const char *msg, size_t len) {
+  if (s_log_dst == LAGOPUS_LOG_EMIT_TO_SYSLOG) {
+    syslog(s_get_syslog_priority(l), "%s", msg);
+  } else {
+    struct iovec iov;
+
+    iov.iov_base = (void *)msg;
+    iov.iov_len = len;
+    s_writev_all(fd, &iov, 1);
+  }
+}
+
+
+/*
+ * Emit all the messages in the rings, with the log lock held. Returns
+ * a # of the messages emitted.
+ */
+static inline size_t
+s_drain_rings(void) {
+  struct iovec iov[LOG_IOV_MAX];
+  int n_iov = 0;
+  size_t n_msgs = 0;
+  uint64_t n_dropped = 0;
+  int fd = STDERR_FILENO;
+  log_ring_t *r;
+  log_rec_hdr_t *hdr;
+  uint64_t head;
+  uint64_t tail;
+  size_t off;
+
+  if (s_log_dst != LAGOPUS_LOG_EMIT_TO_SYSLOG) {
+    if (s_log_fd != NULL) {
+      (void)fflush(s_log_fd);
+      fd = fileno(s_log_fd);
+    }
+  }
+
+  for (r = __atomic_load_n(&s_log_rings, __ATOMIC_ACQUIRE);
+       r != NULL;
+       r = r->m_next) {
+    head = r->m_head;
+    tail = __atomic_load_n(&(r->m_tail), __ATOMIC_ACQUIRE);
+
+    while (head < tail) {
+      off = (size_t)(head % LAGOPUS_LOG_RING_SIZE);
+      hdr = (log_rec_hdr_t *)(r->m_buf + off);
+      if (hdr->m_len == LOG_REC_SKIP) {
+        head += LAGOPUS_LOG_RING_SIZE - off;
+        continue;
+      }
+      if (s_log_dst == LAGOPUS_LOG_EMIT_TO_SYSLOG) {
+        syslog(s_get_syslog_priority((lagopus_log_level_t)hdr->m_level),
+               "%s", (char *)(hdr + 1));
+      } else {
+        iov[n_iov].iov_base = (void *)(hdr + 1);
+        iov[n_iov].iov_len = hdr->m_len;
+        if (++n_iov == LOG_IOV_MAX) {
+          s_writev_all(fd, iov, n_iov);
+          n_iov = 0;
+        }
+      }
+      head += LOG_REC_SIZE(hdr->m_len);
+      n_msgs++;
+    }
+
+    if (n_iov > 0) {
+      s_writev_all(fd, iov, n_iov);
+      n_iov = 0;
+    }
+    __atomic_store_n(&(r->m_head), head, __ATOMIC_RELEASE);
+    n_dropped += __atomic_load_n(&(r->m_n_dropped), __ATOMIC_RELAXED);
+  }
+
+  if (n_dropped > s_n_dropped_reported) {
+    char buf[128];
+    int len = snprintf(buf, sizeof(buf),
+                       "%slogger: " PF64(u) " messages dropped.\n",
+                       s_get_level_str(LAGOPUS_LOG_LEVEL_WARNING),
+                       n_dropped - s_n_dropped_reported);
+    if (len > 0) {
+      s_emit_raw(fd, LAGOPUS_LOG_LEVEL_WARNING, buf,
+                 ((size_t)len < sizeof(buf)) ? (size_t)len : sizeof(buf) - 1);
+    }
+    s_n_dropped_reported = n_dropped;
+  }
+
+  return n_msgs;
+}
+
+
 static inline void
 s_do_log(lagopus_log_level_t l, const char *msg) {
   FILE *fd;
@@ -345,6 +522,13 @@ s_do_log(lagopus_log_level_t l, const char *msg) {
 
   s_lock();
 
+  if (s_log_rings != NULL) {
+    /*
+     * Keep the order against the messages still in the rings.
+     */
+    (void)s_drain_rings();
+  }
+
   switch (s_log_dst) {
     case LAGOPUS_LOG_EMIT_TO_FILE:
     case LAGOPUS_LOG_EMIT_TO_UNKNOWN: {
@@ -365,6 +549,175 @@ s_do_log(lagopus_log_level_t l, const char *msg) {
 }
 
 
+static void
+s_ring_release(void *arg) {
+  log_ring_t *r = (log_ring_t *)arg;
+
+  if (r != NULL) {
+    __atomic_store_n(&(r->m_in_use), false, __ATOMIC_RELEASE);
+  }
+}
+
+
+static void
+s_ring_key_create(void) {
+  s_ring_key_ok =
+    (pthread_key_create(&s_ring_key, s_ring_release) == 0) ? true : false;
+}
+
+
+/*
+ * The ring of the calling thread. A ring is not freed when its owner
+ * exits but taken over by the next new thread.
+ */
+static inline log_ring_t *
+s_get_ring(void) {
+  log_ring_t *r = s_my_ring;
+
+  if (likely(r != NULL)) {
+    return r;
+  }
+
+  (void)pthread_once(&s_ring_key_once, s_ring_key_create);
+  if (s_ring_key_ok == false) {
+    return NULL;
+  }
+
+  (void)pthread_mutex_lock(&s_rings_lock);
+  {
+    for (r = s_log_rings; r != NULL; r = r->m_next) {
+      if (r->m_in_use == false) {
+        r->m_in_use = true;
+        break;
+      }
+    }
+    if (r == NULL && (r = (log_ring_t *)malloc(sizeof(*r))) != NULL) {
+      r->m_head = 0;
+      r->m_tail = 0;
+      r->m_n_dropped = 0;
+      r->m_in_use = true;
+      r->m_next = s_log_rings;
+      __atomic_store_n(&s_log_rings, r, __ATOMIC_RELEASE);
+    }
+  }
+  (void)pthread_mutex_unlock(&s_rings_lock);
+
+  if (r != NULL) {
+    (void)pthread_setspecific(s_ring_key, (void *)r);
+    s_my_ring = r;
+  }
+
+  return r;
+}
+
+
+/*
+ * Append a message to the ring of the calling thread, or count it as
+ * dropped if the ring is full.
+ */
+static inline bool
+s_ring_put(lagopus_log_level_t l, const char *msg) {
+  log_ring_t *r = s_get_ring();
+  size_t len;
+  uint64_t need;
+  uint64_t pad = 0;
+  uint64_t tail;
+  uint64_t head;
+  size_t off;
+  log_rec_hdr_t *hdr;
+
+  if (r == NULL) {
+    return false;
+  }
+
+  len = strlen(msg);
+  need = LOG_REC_SIZE(len);
+  tail = r->m_tail;
+  off = (size_t)(tail % LAGOPUS_LOG_RING_SIZE);
+  if (off + need > LAGOPUS_LOG_RING_SIZE) {
+    pad = LAGOPUS_LOG_RING_SIZE - off;
+  }
+  head = __atomic_load_n(&(r->m_head), __ATOMIC_ACQUIRE);
+
+  if (tail + pad + need - head > LAGOPUS_LOG_RING_SIZE) {
+    __atomic_add_fetch(&(r->m_n_dropped), 1, __ATOMIC_RELAXED);
+    return true;
+  }
+
+  if (pad > 0) {
+    ((log_rec_hdr_t *)(r->m_buf + off))->m_len = LOG_REC_SKIP;
+    off = 0;
+  }
+  hdr = (log_rec_hdr_t *)(r->m_buf + off);
+  hdr->m_len = (uint32_t)len;
+  hdr->m_level = (uint32_t)l;
+  (void)memcpy((void *)(hdr + 1), msg, len + 1);
+
+  __atomic_store_n(&(r->m_tail), tail + pad + need, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+
+static void *
+s_writer_main(void *arg) {
+  int o_cancel_state;
+  size_t n;
+  struct timespec ts;
+  (void)arg;
+
+  (void)pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &o_cancel_state);
+#ifdef HAVE_PTHREAD_SETNAME_NP
+  (void)pthread_setname_np(pthread_self(), "log_writer");
+#endif /* HAVE_PTHREAD_SETNAME_NP */
+
+  (void)pthread_mutex_lock(&s_writer_lock);
+  while (s_writer_running == true) {
+    (void)pthread_mutex_unlock(&s_writer_lock);
+
+    s_lock();
+    n = s_drain_rings();
+    s_unlock();
+
+    (void)pthread_mutex_lock(&s_writer_lock);
+    if (n == 0 && s_writer_running == true) {
+      (void)clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_nsec += LAGOPUS_LOG_WRITER_INTERVAL;
+      ts.tv_sec += ts.tv_nsec / 1000000000;
+      ts.tv_nsec %= 1000000000;
+      (void)pthread_cond_timedwait(&s_writer_cond, &s_writer_lock, &ts);
+    }
+  }
+  (void)pthread_mutex_unlock(&s_writer_lock);
+
+  s_lock();
+  (void)s_drain_rings();
+  s_unlock();
+
+  return NULL;
+}
+
+
+static inline void
+s_writer_stop(void) {
+  bool do_join = false;
+
+  s_log_async = false;
+
+  (void)pthread_mutex_lock(&s_writer_lock);
+  if (s_writer_running == true) {
+    s_writer_running = false;
+    (void)pthread_cond_signal(&s_writer_cond);
+    do_join = true;
+  }
+  (void)pthread_mutex_unlock(&s_writer_lock);
+
+  if (do_join == true) {
+    (void)pthread_join(s_writer_tid, NULL);
+  }
+}
+
+
 
 
 
@@ -466,7 +819,16 @@ lagopus_log_emit(lagopus_log_level_t lv,
       (void)vsnprintf(msg + hdr_len, left_len -1, fmt, args);
     }
 
-    s_do_log(lv, msg);
+    /*
+     * Errors and fatals are emitted right now, the caller may be
+     * about to exit.
+     */
+    if (s_log_async == false ||
+        lv == LAGOPUS_LOG_LEVEL_ERROR ||
+        lv == LAGOPUS_LOG_LEVEL_FATAL ||
+        s_ring_put(lv, msg) == false) {
+      s_do_log(lv, msg);
+    }
 
     errno = s_errno;
   }
@@ -518,6 +880,8 @@ lagopus_log_finalize(void) {
 
   lagopus_msg_debug(10, "Finalize the logger.\n");
 
+  s_writer_stop();
+
   (void)pthread_mutex_lock(&s_log_lock);
   s_log_final();
   (void)pthread_mutex_unlock(&s_log_lock);
@@ -589,6 +953,70 @@ lagopus_log_check_trace_flags(uint64_t flags) {
 }
 
 
+lagopus_result_t
+lagopus_log_set_async(bool async) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  int st;
+
+  if (async == true) {
+    (void)pthread_mutex_lock(&s_writer_lock);
+    if (s_writer_running == false) {
+      s_writer_running = true;
+      if ((st = pthread_create(&s_writer_tid, NULL,
+                               s_writer_main, NULL)) == 0) {
+        s_log_async = true;
+        ret = LAGOPUS_RESULT_OK;
+      } else {
+        s_writer_running = false;
+        errno = st;
+        ret = LAGOPUS_RESULT_POSIX_API_ERROR;
+      }
+    } else {
+      ret = LAGOPUS_RESULT_OK;
+    }
+    (void)pthread_mutex_unlock(&s_writer_lock);
+  } else {
+    s_writer_stop();
+    ret = LAGOPUS_RESULT_OK;
+  }
+
+  return ret;
+}
+
+
+bool
+lagopus_log_is_async(void) {
+  return s_log_async;
+}
+
+
+void
+lagopus_log_flush(void) {
+  int o_cancel_state;
+
+  (void)pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &o_cancel_state);
+  s_lock();
+  (void)s_drain_rings();
+  s_unlock();
+  (void)pthread_setcancelstate(o_cancel_state, NULL);
+}
+
+
+uint64_t
+lagopus_log_get_n_dropped(void) {
+  uint64_t ret = 0;
+  log_ring_t *r;
+
+  for (r = __atomic_load_n(&s_log_rings, __ATOMIC_ACQUIRE);
+       r != NULL;
+       r = r->m_next) {
+    ret += __atomic_load_n(&(r->m_n_dropped), __ATOMIC_RELAXED);
+  }
+
+  return ret;
+}
+
+
 lagopus_log_destination_t
 lagopus_log_get_destination(const char **arg) {
   lagopus_log_destination_t ret = LAGOPUS_LOG_EMIT_TO_UNKNOWN;
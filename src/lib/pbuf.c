@@ -27,21 +27,232 @@ pbuf_reset(struct pbuf *pbuf) {
   pbuf->plen = 0;
 }
 
+/*
+ * The buffers up to the largest size class are recycled through a
+ * per-thread cache and a bounded depot shared by the threads. A size
+ * class n holds PBUF_MIN_SIZE << (2 * n) bytes. The cache records are
+ * not freed when the owner exits but taken over by the next new
+ * thread, like the histogram counts in statistic.c.
+ */
+#define PBUF_CLASS_NUM          4
+#define PBUF_CLASS_SIZE(c)      ((size_t)PBUF_MIN_SIZE << (2 * (c)))
+
+struct pbuf_cache {
+  struct pbuf_cache *next;
+  bool in_use;
+  uint64_t hits;
+  uint64_t misses;
+  size_t n[PBUF_CLASS_NUM];
+  struct pbuf *bufs[PBUF_CLASS_NUM][PBUF_CACHE_DEPTH];
+};
+
+static pthread_once_t s_cache_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t s_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t s_cache_key;
+static bool s_cache_key_ok = false;
+static struct pbuf_cache *s_caches = NULL;
+static __thread struct pbuf_cache *s_my_cache = NULL;
+static size_t s_depot_n[PBUF_CLASS_NUM];
+static struct pbuf *s_depot[PBUF_CLASS_NUM][PBUF_DEPOT_DEPTH];
+
+/* Size class of a buffer, or -1 if it is not cached. */
+static inline int
+pbuf_class(size_t size) {
+  int c;
+
+  for (c = 0; c < PBUF_CLASS_NUM; c++) {
+    if (size <= PBUF_CLASS_SIZE(c)) {
+      return c;
+    }
+  }
+  return -1;
+}
+
+/* Move the buffers of a class above keep to the depot, must be locked. */
+static void
+pbuf_cache_spill(struct pbuf_cache *cache, int c, size_t keep) {
+  struct pbuf *pbuf;
+
+  while (cache->n[c] > keep) {
+    pbuf = cache->bufs[c][--cache->n[c]];
+    if (s_depot_n[c] < PBUF_DEPOT_DEPTH) {
+      s_depot[c][s_depot_n[c]++] = pbuf;
+    } else {
+      free(pbuf);
+    }
+  }
+}
+
+/* Release the cache of an exiting thread. */
+static void
+pbuf_cache_release(void *arg) {
+  struct pbuf_cache *cache = (struct pbuf_cache *)arg;
+  int c;
+
+  if (cache != NULL) {
+    (void)pthread_mutex_lock(&s_cache_lock);
+    for (c = 0; c < PBUF_CLASS_NUM; c++) {
+      pbuf_cache_spill(cache, c, 0);
+    }
+    cache->in_use = false;
+    (void)pthread_mutex_unlock(&s_cache_lock);
+  }
+  s_my_cache = NULL;
+}
+
+static void
+pbuf_cache_once(void) {
+  s_cache_key_ok =
+    (pthread_key_create(&s_cache_key, pbuf_cache_release) == 0) ?
+    true : false;
+}
+
+/* Get the cache of the calling thread. */
+static struct pbuf_cache *
+pbuf_cache_self(void) {
+  struct pbuf_cache *cache = s_my_cache;
+
+  if (likely(cache != NULL)) {
+    return cache;
+  }
+
+  (void)pthread_once(&s_cache_once, pbuf_cache_once);
+  if (unlikely(s_cache_key_ok == false)) {
+    return NULL;
+  }
+
+  (void)pthread_mutex_lock(&s_cache_lock);
+  for (cache = s_caches; cache != NULL; cache = cache->next) {
+    if (cache->in_use == false) {
+      break;
+    }
+  }
+  if (cache == NULL &&
+      (cache = (struct pbuf_cache *)calloc(1, sizeof(*cache))) != NULL) {
+    cache->next = s_caches;
+    s_caches = cache;
+  }
+  if (cache != NULL) {
+    cache->in_use = true;
+    (void)pthread_setspecific(s_cache_key, (void *)cache);
+    s_my_cache = cache;
+  }
+  (void)pthread_mutex_unlock(&s_cache_lock);
+
+  return cache;
+}
+
+/* Get a buffer of a class from the caches. */
+static struct pbuf *
+pbuf_cache_get(int c) {
+  struct pbuf_cache *cache = pbuf_cache_self();
+
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  if (c >= 0) {
+    if (cache->n[c] == 0 && s_depot_n[c] > 0) {
+      /* Refill the half of the cache from the depot. */
+      (void)pthread_mutex_lock(&s_cache_lock);
+      while (cache->n[c] < (PBUF_CACHE_DEPTH + 1) / 2 && s_depot_n[c] > 0) {
+        cache->bufs[c][cache->n[c]++] = s_depot[c][--s_depot_n[c]];
+      }
+      (void)pthread_mutex_unlock(&s_cache_lock);
+    }
+    if (cache->n[c] > 0) {
+      cache->hits++;
+      return cache->bufs[c][--cache->n[c]];
+    }
+  }
+  cache->misses++;
+
+  return NULL;
+}
+
+/* Put a buffer of a class back to the caches. */
+static bool
+pbuf_cache_put(int c, struct pbuf *pbuf) {
+  struct pbuf_cache *cache = pbuf_cache_self();
+
+  if (cache == NULL) {
+    return false;
+  }
+
+  if (cache->n[c] == PBUF_CACHE_DEPTH) {
+    /* Spill the half of the cache to the depot. */
+    (void)pthread_mutex_lock(&s_cache_lock);
+    pbuf_cache_spill(cache, c, PBUF_CACHE_DEPTH / 2);
+    (void)pthread_mutex_unlock(&s_cache_lock);
+  }
+  cache->bufs[c][cache->n[c]++] = pbuf;
+
+  return true;
+}
+
+/* Get the pbuf cache statistics. */
+void
+pbuf_cache_stats_get(struct pbuf_cache_stats *stats) {
+  struct pbuf_cache *cache;
+  int c;
+
+  if (stats == NULL) {
+    return;
+  }
+
+  memset(stats, 0, sizeof(*stats));
+  (void)pthread_mutex_lock(&s_cache_lock);
+  for (cache = s_caches; cache != NULL; cache = cache->next) {
+    stats->hits += cache->hits;
+    stats->misses += cache->misses;
+  }
+  for (c = 0; c < PBUF_CLASS_NUM; c++) {
+    stats->depot += s_depot_n[c];
+  }
+  (void)pthread_mutex_unlock(&s_cache_lock);
+}
+
+/* Free the cached buffers of the calling thread and the depot. */
+void
+pbuf_cache_purge(void) {
+  struct pbuf_cache *cache = s_my_cache;
+  int c;
+
+  (void)pthread_mutex_lock(&s_cache_lock);
+  for (c = 0; c < PBUF_CLASS_NUM; c++) {
+    if (cache != NULL) {
+      pbuf_cache_spill(cache, c, 0);
+    }
+    while (s_depot_n[c] > 0) {
+      free(s_depot[c][--s_depot_n[c]]);
+    }
+  }
+  (void)pthread_mutex_unlock(&s_cache_lock);
+}
+
 /* Allocate a pbuf. */
 struct pbuf *
 pbuf_alloc(size_t size) {
   struct pbuf *pbuf;
+  int c;
 
   /* Adjust size to minimum buffer size. */
   if (size < PBUF_MIN_SIZE) {
     size = PBUF_MIN_SIZE;
   }
 
-  pbuf = (struct pbuf *)calloc(1, sizeof(struct pbuf) + size);
+  c = pbuf_class(size);
+  pbuf = pbuf_cache_get(c);
   if (pbuf == NULL) {
-    return NULL;
+    pbuf = (struct pbuf *)malloc(sizeof(struct pbuf) +
+                                 ((c >= 0) ? PBUF_CLASS_SIZE(c) : size));
+    if (pbuf == NULL) {
+      return NULL;
+    }
   }
 
+  /* The data is always written before read, clear the header only. */
+  memset(pbuf, 0, sizeof(struct pbuf));
   pbuf->size = size;
   pbuf->refs = 1;
   pbuf_reset(pbuf);
@@ -65,13 +276,18 @@ pbuf_put(struct pbuf *pbuf) {
 /* Free pbuf. */
 void
 pbuf_free(struct pbuf *pbuf) {
+  int c;
+
   if (pbuf == NULL) {
     return;
   }
   assert(pbuf->refs != 0);
   pbuf->refs--;
   if (pbuf->refs == 0) {
-    free(pbuf);
+    c = pbuf_class(pbuf->size);
+    if (c < 0 || pbuf_cache_put(c, pbuf) == false) {
+      free(pbuf);
+    }
   }
 }
 
@@ -33,6 +33,46 @@ typedef struct lagopus_statistic_struct {
 } lagopus_statistic_struct;
 
 
+/*
+ * Histograms: log-linear buckets in the HDR histogram manner. Values
+ * below 2^HIST_SUB_BITS have a bucket each, above that every power of
+ * two range is split into HIST_SUB_N buckets, so a bucket is at most
+ * 1/HIST_SUB_N of its value wide.
+ */
+#ifndef LAGOPUS_HISTOGRAM_SUB_BITS
+#define LAGOPUS_HISTOGRAM_SUB_BITS	5
+#endif /* ! LAGOPUS_HISTOGRAM_SUB_BITS */
+
+#ifndef LAGOPUS_HISTOGRAM_MAX
+#define LAGOPUS_HISTOGRAM_MAX	64
+#endif /* ! LAGOPUS_HISTOGRAM_MAX */
+
+#define HIST_SUB_BITS	LAGOPUS_HISTOGRAM_SUB_BITS
+#define HIST_SUB_N	(1ULL << HIST_SUB_BITS)
+#define HIST_N_BUCKETS	((size_t)(64 - HIST_SUB_BITS) * HIST_SUB_N)
+
+typedef struct lagopus_histogram_struct {
+  const char *m_name;
+  size_t m_id;			/* Index of the per-thread counts. */
+} lagopus_histogram_struct;
+
+typedef struct hist_counts {
+  int64_t m_max;
+  uint64_t m_counts[HIST_N_BUCKETS];
+} hist_counts_t;
+
+/*
+ * Counts of a thread for all the histograms. Written by the owner
+ * thread only, not freed when the owner exits but taken over by the
+ * next new thread so that the samples of exited threads are kept.
+ */
+typedef struct hist_thread {
+  struct hist_thread *m_next;
+  bool m_in_use;
+  hist_counts_t *m_hists[LAGOPUS_HISTOGRAM_MAX];
+} hist_thread_t;
+
+
 
 
 
@@ -40,6 +80,14 @@ static pthread_once_t s_once = PTHREAD_ONCE_INIT;
 
 static lagopus_hashmap_t s_stat_tbl;
 
+static lagopus_hashmap_t s_hist_tbl;
+static pthread_mutex_t s_hist_lock = PTHREAD_MUTEX_INITIALIZER;
+static hist_thread_t *s_hist_threads = NULL;
+static lagopus_histogram_t s_hist_ids[LAGOPUS_HISTOGRAM_MAX];
+static pthread_key_t s_hist_key;
+static bool s_hist_key_ok = false;
+static __thread hist_thread_t *s_my_hist_thread = NULL;
+
 
 
 
@@ -49,6 +97,9 @@ static void s_dtors(void) __attr_destructor__(112);
 
 static void s_destroy_stat(lagopus_statistic_t s, bool delhash);
 static void s_stat_freeup(void *arg);
+static void s_destroy_hist(lagopus_histogram_t h, bool delhash);
+static void s_hist_freeup(void *arg);
+static void s_hist_thread_release(void *arg);
 
 static lagopus_result_t s_reset_stat(lagopus_statistic_t s);
 
@@ -66,6 +117,15 @@ s_once_proc(void) {
     lagopus_perror(r);
     lagopus_exit_fatal("can't initialize the stattistics table.\n");
   }
+  if ((r = lagopus_hashmap_create(&s_hist_tbl,
+                                  LAGOPUS_HASHMAP_TYPE_STRING,
+                                  s_hist_freeup)) != LAGOPUS_RESULT_OK) {
+    lagopus_perror(r);
+    lagopus_exit_fatal("can't initialize the histogram table.\n");
+  }
+  s_hist_key_ok =
+    (pthread_key_create(&s_hist_key, s_hist_thread_release) == 0) ?
+    true : false;
 }
 
 
@@ -86,6 +146,7 @@ s_ctors(void) {
 static inline void
 s_final(void) {
   lagopus_hashmap_destroy(&s_stat_tbl, true);
+  lagopus_hashmap_destroy(&s_hist_tbl, true);
 }
 
 
@@ -115,6 +176,27 @@ s_stat_freeup(void *arg) {
 }
 
 
+static void
+s_hist_freeup(void *arg) {
+  if (likely(arg != NULL)) {
+    lagopus_histogram_t h = (lagopus_histogram_t)arg;
+    s_destroy_hist(h, false);
+  }
+}
+
+
+static void
+s_hist_thread_release(void *arg) {
+  hist_thread_t *t = (hist_thread_t *)arg;
+
+  if (t != NULL) {
+    (void)pthread_mutex_lock(&s_hist_lock);
+    t->m_in_use = false;
+    (void)pthread_mutex_unlock(&s_hist_lock);
+  }
+}
+
+
 
 
 
@@ -330,6 +412,302 @@ s_get_sd_stat(lagopus_statistic_t s, double *valptr, bool is_ssd) {
 
 
 
+static inline lagopus_result_t
+s_create_hist(lagopus_histogram_t *hptr, const char *name) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL &&
+             IS_VALID_STRING(name) == true)) {
+    lagopus_histogram_t h = (lagopus_histogram_t)malloc(sizeof(*h));
+    const char *m_name = strdup(name);
+    size_t id = LAGOPUS_HISTOGRAM_MAX;
+    *hptr = NULL;
+
+    if (likely(h != NULL && IS_VALID_STRING(m_name) == true)) {
+      void *val = (void *)h;
+
+      (void)pthread_mutex_lock(&s_hist_lock);
+      for (id = 0; id < LAGOPUS_HISTOGRAM_MAX; id++) {
+        if (s_hist_ids[id] == NULL) {
+          s_hist_ids[id] = h;
+          break;
+        }
+      }
+      (void)pthread_mutex_unlock(&s_hist_lock);
+
+      if (likely(id < LAGOPUS_HISTOGRAM_MAX)) {
+        h->m_name = m_name;
+        h->m_id = id;
+        ret = lagopus_hashmap_add(&s_hist_tbl, (void *)m_name, &val, false);
+        if (likely(ret == LAGOPUS_RESULT_OK)) {
+          *hptr = h;
+        }
+      } else {
+        ret = LAGOPUS_RESULT_TOO_MANY_OBJECTS;
+      }
+    } else {
+      ret = LAGOPUS_RESULT_NO_MEMORY;
+    }
+
+    if (unlikely(ret != LAGOPUS_RESULT_OK)) {
+      if (id < LAGOPUS_HISTOGRAM_MAX) {
+        (void)pthread_mutex_lock(&s_hist_lock);
+        s_hist_ids[id] = NULL;
+        (void)pthread_mutex_unlock(&s_hist_lock);
+      }
+      free((void *)h);
+      free((void *)m_name);
+    }
+
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
+static void
+s_destroy_hist(lagopus_histogram_t h, bool delhash) {
+  if (likely(h != NULL)) {
+    hist_thread_t *t;
+
+    if (delhash == true) {
+      (void)lagopus_hashmap_delete(&s_hist_tbl,
+                                   (void *)h->m_name, NULL, false);
+    }
+
+    (void)pthread_mutex_lock(&s_hist_lock);
+    for (t = s_hist_threads; t != NULL; t = t->m_next) {
+      free((void *)t->m_hists[h->m_id]);
+      t->m_hists[h->m_id] = NULL;
+    }
+    s_hist_ids[h->m_id] = NULL;
+    (void)pthread_mutex_unlock(&s_hist_lock);
+
+    if (h->m_name != NULL) {
+      free((void *)h->m_name);
+    }
+    free((void *)h);
+  }
+}
+
+
+static inline lagopus_result_t
+s_find_hist(lagopus_histogram_t *hptr, const char *name) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL &&
+             IS_VALID_STRING(name) == true)) {
+    void *val = NULL;
+
+    *hptr = NULL;
+
+    ret = lagopus_hashmap_find(&s_hist_tbl, (void *)name, &val);
+    if (likely(ret == LAGOPUS_RESULT_OK)) {
+      *hptr = (lagopus_histogram_t)val;
+    }
+
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
+static inline size_t
+s_hist_bucket(int64_t val) {
+  uint64_t v = (val > 0) ? (uint64_t)val : 0;
+
+  if (v < HIST_SUB_N) {
+    return (size_t)v;
+  } else {
+    unsigned int shift =
+      (unsigned int)(63 - __builtin_clzll(v)) - HIST_SUB_BITS;
+
+    return ((size_t)(shift + 1) << HIST_SUB_BITS) +
+           (size_t)((v >> shift) - HIST_SUB_N);
+  }
+}
+
+
+/*
+ * The largest value which falls into the bucket.
+ */
+static inline int64_t
+s_hist_bucket_value(size_t idx) {
+  size_t e = idx >> HIST_SUB_BITS;
+  uint64_t sub = (uint64_t)(idx & (HIST_SUB_N - 1));
+
+  if (e == 0) {
+    return (int64_t)sub;
+  } else {
+    return (int64_t)((((HIST_SUB_N + sub) << (e - 1)) +
+                      (1ULL << (e - 1))) - 1);
+  }
+}
+
+
+/*
+ * The counts of the calling thread for a histogram, allocated at the
+ * first record.
+ */
+static hist_counts_t *
+s_hist_counts_get(lagopus_histogram_t h) {
+  hist_thread_t *t = s_my_hist_thread;
+  hist_counts_t *c = NULL;
+
+  if (unlikely(s_hist_key_ok == false)) {
+    return NULL;
+  }
+
+  (void)pthread_mutex_lock(&s_hist_lock);
+  {
+    if (t == NULL) {
+      for (t = s_hist_threads; t != NULL; t = t->m_next) {
+        if (t->m_in_use == false) {
+          t->m_in_use = true;
+          break;
+        }
+      }
+      if (t == NULL &&
+          (t = (hist_thread_t *)calloc(1, sizeof(*t))) != NULL) {
+        t->m_in_use = true;
+        t->m_next = s_hist_threads;
+        s_hist_threads = t;
+      }
+      if (t != NULL) {
+        (void)pthread_setspecific(s_hist_key, (void *)t);
+        s_my_hist_thread = t;
+      }
+    }
+
+    if (t != NULL) {
+      if ((c = t->m_hists[h->m_id]) == NULL &&
+          (c = (hist_counts_t *)calloc(1, sizeof(*c))) != NULL) {
+        c->m_max = LLONG_MIN;
+        t->m_hists[h->m_id] = c;
+      }
+    }
+  }
+  (void)pthread_mutex_unlock(&s_hist_lock);
+
+  return c;
+}
+
+
+static inline lagopus_result_t
+s_record_hist(lagopus_histogram_t h, int64_t val) {
+  hist_thread_t *t = s_my_hist_thread;
+  hist_counts_t *c;
+
+  if (likely(t != NULL && (c = t->m_hists[h->m_id]) != NULL) ||
+      (c = s_hist_counts_get(h)) != NULL) {
+    /*
+     * Only the owner thread writes the counts, readers tolerate a
+     * torn view of a sample in flight.
+     */
+    c->m_counts[s_hist_bucket(val)]++;
+    if (unlikely(val > c->m_max)) {
+      c->m_max = val;
+    }
+    return LAGOPUS_RESULT_OK;
+  } else {
+    return LAGOPUS_RESULT_NO_MEMORY;
+  }
+}
+
+
+static inline lagopus_result_t
+s_reset_hist(lagopus_histogram_t h) {
+  hist_thread_t *t;
+  hist_counts_t *c;
+
+  (void)pthread_mutex_lock(&s_hist_lock);
+  for (t = s_hist_threads; t != NULL; t = t->m_next) {
+    if ((c = t->m_hists[h->m_id]) != NULL) {
+      (void)memset((void *)c->m_counts, 0, sizeof(c->m_counts));
+      c->m_max = LLONG_MIN;
+    }
+  }
+  (void)pthread_mutex_unlock(&s_hist_lock);
+
+  return LAGOPUS_RESULT_OK;
+}
+
+
+/*
+ * Merge the counts of all the threads and pick the values at the
+ * percentiles, which are in ascending order.
+ */
+static void
+s_merge_hist(lagopus_histogram_t h,
+             const double *pcts, int64_t *vals, size_t n_pcts,
+             uint64_t *nptr, int64_t *maxptr) {
+  hist_thread_t *t;
+  hist_counts_t *c;
+  uint64_t n = 0;
+  uint64_t cum = 0;
+  uint64_t rank = 0;
+  int64_t max = LLONG_MIN;
+  size_t i;
+  size_t p = 0;
+
+  (void)pthread_mutex_lock(&s_hist_lock);
+
+  for (t = s_hist_threads; t != NULL; t = t->m_next) {
+    if ((c = t->m_hists[h->m_id]) != NULL) {
+      int64_t m = __atomic_load_n(&(c->m_max), __ATOMIC_RELAXED);
+      for (i = 0; i < HIST_N_BUCKETS; i++) {
+        n += __atomic_load_n(&(c->m_counts[i]), __ATOMIC_RELAXED);
+      }
+      if (m > max) {
+        max = m;
+      }
+    }
+  }
+
+  for (i = 0; i < HIST_N_BUCKETS && p < n_pcts && n > 0; i++) {
+    for (t = s_hist_threads; t != NULL; t = t->m_next) {
+      if ((c = t->m_hists[h->m_id]) != NULL) {
+        cum += __atomic_load_n(&(c->m_counts[i]), __ATOMIC_RELAXED);
+      }
+    }
+    while (p < n_pcts) {
+      rank = (uint64_t)ceil(pcts[p] * (double)n / 100.0);
+      if (rank == 0) {
+        rank = 1;
+      }
+      if (cum < rank) {
+        break;
+      }
+      vals[p] = s_hist_bucket_value(i);
+      if (vals[p] > max) {
+        vals[p] = max;
+      }
+      p++;
+    }
+  }
+
+  (void)pthread_mutex_unlock(&s_hist_lock);
+
+  /* Not reached when empty, or the counts changed under the walk. */
+  for (; p < n_pcts; p++) {
+    vals[p] = (n > 0) ? max : 0;
+  }
+  if (nptr != NULL) {
+    *nptr = n;
+  }
+  if (maxptr != NULL) {
+    *maxptr = (n > 0) ? max : 0;
+  }
+}
+
+
+
+
+
 /*
  * Exported APIs
  */
@@ -463,3 +841,106 @@ lagopus_statistic_sd(lagopus_statistic_t *sptr, double *valptr, bool is_ssd) {
 
   return ret;
 }
+
+
+lagopus_result_t
+lagopus_histogram_create(lagopus_histogram_t *hptr, const char *name) {
+  return s_create_hist(hptr, name);
+}
+
+
+lagopus_result_t
+lagopus_histogram_find(lagopus_histogram_t *hptr, const char *name) {
+  return s_find_hist(hptr, name);
+}
+
+
+void
+lagopus_histogram_destroy(lagopus_histogram_t *hptr) {
+  if (likely(hptr != NULL && *hptr != NULL)) {
+    s_destroy_hist(*hptr, true);
+  }
+}
+
+
+lagopus_result_t
+lagopus_histogram_record(lagopus_histogram_t *hptr, int64_t val) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL && *hptr != NULL)) {
+    ret = s_record_hist(*hptr, val);
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
+lagopus_result_t
+lagopus_histogram_reset(lagopus_histogram_t *hptr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL && *hptr != NULL)) {
+    ret = s_reset_hist(*hptr);
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
+lagopus_result_t
+lagopus_histogram_sample_n(lagopus_histogram_t *hptr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL && *hptr != NULL)) {
+    uint64_t n;
+    s_merge_hist(*hptr, NULL, NULL, 0, &n, NULL);
+    ret = (lagopus_result_t)n;
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
+lagopus_result_t
+lagopus_histogram_percentile(lagopus_histogram_t *hptr, double pct,
+                             int64_t *valptr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL && *hptr != NULL && valptr != NULL &&
+             pct >= 0.0 && pct <= 100.0)) {
+    s_merge_hist(*hptr, &pct, valptr, 1, NULL, NULL);
+    ret = LAGOPUS_RESULT_OK;
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
+
+
+lagopus_result_t
+lagopus_histogram_summary(lagopus_histogram_t *hptr,
+                          lagopus_histogram_summary_t *sumptr) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+
+  if (likely(hptr != NULL && *hptr != NULL && sumptr != NULL)) {
+    static const double pcts[] = { 50.0, 99.0, 99.9 };
+    int64_t vals[3];
+
+    s_merge_hist(*hptr, pcts, vals, 3, &(sumptr->m_n), &(sumptr->m_max));
+    sumptr->m_p50 = vals[0];
+    sumptr->m_p99 = vals[1];
+    sumptr->m_p999 = vals[2];
+    ret = LAGOPUS_RESULT_OK;
+  } else {
+    ret = LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  return ret;
+}
@@ -0,0 +1,378 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+#include "lagopus_apis.h"
+
+#define N_ENTRY 16
+#define TIMED_WAIT 10000000LL
+#define N_PRODUCERS 4
+#define N_VALUES 100000
+#define BATCH 7
+
+typedef LAGOPUS_BOUND_BLOCK_Q_DECL(uint64_bbq, uint64_t) uint64_bbq;
+
+static int free_cnt = 0;
+
+
+static void
+s_freeup(void **arg) {
+  if (arg != NULL) {
+    free(*arg);
+    free_cnt++;
+  }
+}
+
+
+void
+setUp(void) {
+  free_cnt = 0;
+}
+
+void
+tearDown(void) {
+}
+
+
+void
+test_bbq_lockfree_creation(void) {
+  uint64_bbq q = NULL;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        LAGOPUS_CBUFFER_MODE_SPSC));
+  lagopus_bbq_destroy(&q, false);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        LAGOPUS_CBUFFER_MODE_MPSC));
+  lagopus_bbq_destroy(&q, false);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        (lagopus_cbuffer_mode_t)100));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, 0, NULL,
+                        LAGOPUS_CBUFFER_MODE_SPSC));
+}
+
+
+static void
+s_put_get_n(lagopus_cbuffer_mode_t mode) {
+  uint64_bbq q = NULL;
+  uint64_t vals[N_ENTRY * 2];
+  uint64_t got[N_ENTRY * 2];
+  size_t n;
+  bool b;
+  int i, round;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        mode));
+  for (i = 0; i < N_ENTRY * 2; i++) {
+    vals[i] = (uint64_t)i;
+  }
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_bbq_is_empty(&q, &b));
+  TEST_ASSERT_TRUE(b);
+
+  /* Go around the ring a few times with odd sized batches. */
+  for (round = 0; round < 10; round++) {
+    TEST_ASSERT_EQUAL(BATCH,
+                      lagopus_bbq_put_n(&q, vals + round, BATCH, uint64_t,
+                                        0LL, &n));
+    TEST_ASSERT_EQUAL(BATCH, n);
+    TEST_ASSERT_EQUAL(BATCH, lagopus_bbq_size(&q));
+    TEST_ASSERT_EQUAL(N_ENTRY - BATCH, lagopus_bbq_remaining_capacity(&q));
+    TEST_ASSERT_EQUAL(BATCH,
+                      lagopus_bbq_get_n(&q, got, N_ENTRY, 0, uint64_t,
+                                        0LL, &n));
+    for (i = 0; i < BATCH; i++) {
+      TEST_ASSERT_EQUAL(vals[round + i], got[i]);
+    }
+  }
+
+  /* Only the rooms available are put with no wait. */
+  TEST_ASSERT_EQUAL(N_ENTRY,
+                    lagopus_bbq_put_n(&q, vals, N_ENTRY * 2, uint64_t,
+                                      0LL, &n));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_bbq_is_full(&q, &b));
+  TEST_ASSERT_TRUE(b);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_TIMEDOUT,
+                    lagopus_bbq_put(&q, &vals[0], uint64_t, TIMED_WAIT));
+  TEST_ASSERT_EQUAL(N_ENTRY, lagopus_bbq_wait_gettable(&q, TIMED_WAIT));
+
+  /* Peek doesn't consume. */
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_peek(&q, &got[0], uint64_t, 0LL));
+  TEST_ASSERT_EQUAL(0, got[0]);
+  TEST_ASSERT_EQUAL(N_ENTRY, lagopus_bbq_size(&q));
+
+  TEST_ASSERT_EQUAL(N_ENTRY,
+                    lagopus_bbq_get_n(&q, got, N_ENTRY * 2, 1, uint64_t,
+                                      TIMED_WAIT, &n));
+  for (i = 0; i < N_ENTRY; i++) {
+    TEST_ASSERT_EQUAL(vals[i], got[i]);
+  }
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_TIMEDOUT,
+                    lagopus_bbq_get(&q, &got[0], uint64_t, TIMED_WAIT));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_TIMEDOUT,
+                    lagopus_bbq_get_n(&q, got, 2, 1, uint64_t,
+                                      TIMED_WAIT, &n));
+  TEST_ASSERT_EQUAL(0, n);
+
+  lagopus_bbq_shutdown(&q, false);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_NOT_OPERATIONAL,
+                    lagopus_bbq_put(&q, &vals[0], uint64_t, 0LL));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_NOT_OPERATIONAL,
+                    lagopus_bbq_get(&q, &got[0], uint64_t, 0LL));
+  lagopus_bbq_destroy(&q, false);
+}
+
+
+void
+test_bbq_lockfree_spsc_put_get_n(void) {
+  s_put_get_n(LAGOPUS_CBUFFER_MODE_SPSC);
+}
+
+
+void
+test_bbq_lockfree_mpsc_put_get_n(void) {
+  s_put_get_n(LAGOPUS_CBUFFER_MODE_MPSC);
+}
+
+
+static void
+s_clear_freeup(lagopus_cbuffer_mode_t mode) {
+  lagopus_bbq_t q = NULL;
+  void *p;
+  int i;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, void *, N_ENTRY,
+                        s_freeup, mode));
+  for (i = 0; i < 5; i++) {
+    p = malloc(8);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_bbq_put(&q, &p, void *, 0LL));
+  }
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_bbq_clear(&q, true));
+  TEST_ASSERT_EQUAL(5, free_cnt);
+  TEST_ASSERT_EQUAL(0, lagopus_bbq_size(&q));
+  TEST_ASSERT_EQUAL(N_ENTRY, lagopus_bbq_remaining_capacity(&q));
+
+  for (i = 0; i < 3; i++) {
+    p = malloc(8);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_bbq_put(&q, &p, void *, 0LL));
+  }
+  lagopus_bbq_shutdown(&q, true);
+  TEST_ASSERT_EQUAL(8, free_cnt);
+  lagopus_bbq_destroy(&q, true);
+  TEST_ASSERT_EQUAL(8, free_cnt);
+}
+
+
+void
+test_bbq_lockfree_clear_freeup(void) {
+  s_clear_freeup(LAGOPUS_CBUFFER_MODE_SPSC);
+  free_cnt = 0;
+  s_clear_freeup(LAGOPUS_CBUFFER_MODE_MPSC);
+}
+
+
+
+
+
+struct producer_arg {
+  uint64_bbq *qptr;
+  uint64_t id;
+};
+
+
+static void *
+s_producer(void *arg) {
+  struct producer_arg *pa = (struct producer_arg *)arg;
+  uint64_t vals[BATCH];
+  uint64_t i = 0;
+  size_t j, n;
+
+  while (i < N_VALUES) {
+    for (j = 0; j < BATCH; j++) {
+      vals[j] = (pa->id << 32) | (i + j);
+    }
+    n = (N_VALUES - i < BATCH) ? (size_t)(N_VALUES - i) : BATCH;
+    if (lagopus_bbq_put_n(pa->qptr, vals, n, uint64_t, -1LL, NULL) !=
+        (lagopus_result_t)n) {
+      break;
+    }
+    i += n;
+  }
+
+  return NULL;
+}
+
+
+static void
+s_threaded(lagopus_cbuffer_mode_t mode, uint64_t n_producers) {
+  uint64_bbq q = NULL;
+  pthread_t tids[N_PRODUCERS];
+  struct producer_arg pas[N_PRODUCERS];
+  uint64_t next[N_PRODUCERS];
+  uint64_t got[BATCH * 2];
+  uint64_t total = 0;
+  lagopus_result_t r;
+  uint64_t i, id;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        mode));
+  for (i = 0; i < n_producers; i++) {
+    pas[i].qptr = &q;
+    pas[i].id = i;
+    next[i] = 0;
+    TEST_ASSERT_EQUAL(0, pthread_create(&tids[i], NULL, s_producer,
+                                        &pas[i]));
+  }
+
+  while (total < N_VALUES * n_producers) {
+    r = lagopus_bbq_get_n(&q, got, BATCH * 2, 1, uint64_t, 1000000000LL,
+                          NULL);
+    TEST_ASSERT_TRUE(r > 0);
+    for (i = 0; i < (uint64_t)r; i++) {
+      /* Each producer's values arrive in order. */
+      id = got[i] >> 32;
+      TEST_ASSERT_TRUE(id < n_producers);
+      TEST_ASSERT_EQUAL(next[id], got[i] & 0xffffffffULL);
+      next[id]++;
+    }
+    total += (uint64_t)r;
+  }
+
+  for (i = 0; i < n_producers; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_join(tids[i], NULL));
+    TEST_ASSERT_EQUAL(N_VALUES, next[i]);
+  }
+  TEST_ASSERT_EQUAL(0, lagopus_bbq_size(&q));
+  TEST_ASSERT_TRUE(lagopus_bbq_n_wakeups(&q) >= 0);
+  lagopus_bbq_destroy(&q, false);
+}
+
+
+void
+test_bbq_lockfree_spsc_threaded(void) {
+  s_threaded(LAGOPUS_CBUFFER_MODE_SPSC, 1);
+}
+
+
+void
+test_bbq_lockfree_mpsc_threaded(void) {
+  s_threaded(LAGOPUS_CBUFFER_MODE_MPSC, N_PRODUCERS);
+}
+
+
+
+
+
+static volatile bool s_getter_done = false;
+
+
+static void *
+s_blocked_getter(void *arg) {
+  uint64_bbq *qptr = (uint64_bbq *)arg;
+  uint64_t v;
+  lagopus_result_t r;
+
+  r = lagopus_bbq_get(qptr, &v, uint64_t, -1LL);
+  s_getter_done = true;
+
+  return (void *)(intptr_t)r;
+}
+
+
+void
+test_bbq_lockfree_wakeup_shutdown(void) {
+  uint64_bbq q = NULL;
+  pthread_t tid;
+  void *r;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        LAGOPUS_CBUFFER_MODE_SPSC));
+
+  s_getter_done = false;
+  TEST_ASSERT_EQUAL(0, pthread_create(&tid, NULL, s_blocked_getter, &q));
+  while (s_getter_done == false) {
+    /* No effect until the getter sleeps. */
+    usleep(10000);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_bbq_wakeup(&q, 1000000000LL));
+  }
+  TEST_ASSERT_EQUAL(0, pthread_join(tid, &r));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_WAKEUP_REQUESTED, (intptr_t)r);
+
+  TEST_ASSERT_EQUAL(0, pthread_create(&tid, NULL, s_blocked_getter, &q));
+  usleep(100000);
+  lagopus_bbq_shutdown(&q, false);
+  TEST_ASSERT_EQUAL(0, pthread_join(tid, &r));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_NOT_OPERATIONAL, (intptr_t)r);
+
+  lagopus_bbq_destroy(&q, false);
+}
+
+
+static void *
+s_late_producer(void *arg) {
+  uint64_bbq *qptr = (uint64_bbq *)arg;
+  uint64_t v = 1;
+
+  usleep(100000);
+  (void)lagopus_bbq_put(qptr, &v, uint64_t, -1LL);
+
+  return NULL;
+}
+
+
+void
+test_bbq_lockfree_qmuxer(void) {
+  uint64_bbq q = NULL;
+  lagopus_qmuxer_t qmx = NULL;
+  lagopus_qmuxer_poll_t poll = NULL;
+  pthread_t tid;
+  uint64_t v;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create_with_mode(&q, uint64_t, N_ENTRY, NULL,
+                        LAGOPUS_CBUFFER_MODE_MPSC));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_qmuxer_create(&qmx));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_qmuxer_poll_create(&poll, q,
+                        LAGOPUS_QMUXER_POLL_READABLE));
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_TIMEDOUT,
+                    lagopus_qmuxer_poll(&qmx, &poll, 1, 10000000LL));
+
+  /* The putter doesn't take the lock, the poller still wakes up. */
+  TEST_ASSERT_EQUAL(0, pthread_create(&tid, NULL, s_late_producer, &q));
+  TEST_ASSERT_EQUAL(1, lagopus_qmuxer_poll(&qmx, &poll, 1,
+                    5000000000LL));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_get(&q, &v, uint64_t, 0LL));
+  TEST_ASSERT_EQUAL(1, v);
+  TEST_ASSERT_EQUAL(0, pthread_join(tid, NULL));
+
+  lagopus_qmuxer_poll_destroy(&poll);
+  lagopus_qmuxer_destroy(&qmx);
+  lagopus_bbq_destroy(&q, false);
+}
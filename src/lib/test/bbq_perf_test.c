@@ -322,3 +322,89 @@ test_bbq_multithread_10000(void) {
   s_gen_test(100, 10000, 10000, 100, 10000, 10000);
 }
 */
+
+
+
+
+
+#define MODE_N_MSGS	1000000
+#define MODE_QLEN	1024
+#define MODE_MAX_BATCH	64
+
+struct mode_producer_arg {
+  lagopus_bbq_t *bbqptr;
+  size_t batch;
+};
+
+static void *
+s_mode_producer(void *arg) {
+  struct mode_producer_arg *pa = (struct mode_producer_arg *)arg;
+  void *vals[MODE_MAX_BATCH];
+  size_t i;
+
+  (void)memset(vals, 0, sizeof(vals));
+  for (i = 0; i < MODE_N_MSGS; i += pa->batch) {
+    if (lagopus_bbq_put_n(pa->bbqptr, vals, pa->batch, void *, -1LL,
+                          NULL) != (lagopus_result_t)pa->batch) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+static void
+s_mode_run(const char *name, lagopus_cbuffer_mode_t mode,
+           size_t n_producers, size_t batch) {
+  lagopus_bbq_t q = NULL;
+  pthread_t tids[4];
+  struct mode_producer_arg pa;
+  void *vals[MODE_MAX_BATCH];
+  size_t total = 0;
+  lagopus_result_t ret;
+  struct timespec start, end;
+  double sec;
+  size_t i;
+
+  ret = lagopus_bbq_create_with_mode(&q, void *, MODE_QLEN, NULL, mode);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, ret);
+  pa.bbqptr = &q;
+  pa.batch = batch;
+
+  get_time_stamp(&start);
+  for (i = 0; i < n_producers; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&tids[i], NULL, s_mode_producer,
+                                        &pa));
+  }
+  while (total < MODE_N_MSGS * n_producers) {
+    ret = lagopus_bbq_get_n(&q, vals, MODE_MAX_BATCH, 1, void *,
+                            1LL * SEC, NULL);
+    TEST_ASSERT_TRUE(ret > 0);
+    total += (size_t)ret;
+  }
+  for (i = 0; i < n_producers; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_join(tids[i], NULL));
+  }
+  get_time_stamp(&end);
+
+  sec = (double)(end.tv_sec - start.tv_sec)
+        + (double)(end.tv_nsec - start.tv_nsec) / 1000000000;
+  fprintf(OUTPUT, "%-6s %zu putter(s) batch %2zu: %12.0f msgs/sec, "
+          "%8" PRId64 " wakeups\n",
+          name, n_producers, batch, (double)total / sec,
+          (int64_t)lagopus_bbq_n_wakeups(&q));
+
+  lagopus_bbq_destroy(&q, false);
+}
+
+void
+test_bbq_mode_throughput(void) {
+  size_t batch;
+
+  for (batch = 1; batch <= 32; batch *= 32) {
+    s_mode_run("locked", LAGOPUS_CBUFFER_MODE_LOCKED, 1, batch);
+    s_mode_run("spsc", LAGOPUS_CBUFFER_MODE_SPSC, 1, batch);
+    s_mode_run("locked", LAGOPUS_CBUFFER_MODE_LOCKED, 4, batch);
+    s_mode_run("mpsc", LAGOPUS_CBUFFER_MODE_MPSC, 4, batch);
+  }
+}
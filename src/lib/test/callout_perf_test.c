@@ -0,0 +1,125 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lagopus_apis.h"
+#include "unity.h"
+
+#define OUTPUT stdout
+#define get_time_stamp(tp) clock_gettime(CLOCK_MONOTONIC, (tp))
+
+#define N_CALLOUT_WORKERS	0
+#define N_TASKS		(100 * 1000)
+
+/*
+ * The tasks are spread over 1 sec. to about 100 sec. from now so that
+ * none of them fires while measuring.
+ */
+#define BASE_DELAY	(1000LL * 1000LL * 1000LL)
+#define DELAY_STEP	(1000LL * 1000LL)
+
+
+
+
+
+static lagopus_callout_task_t s_tasks[N_TASKS];
+
+
+void
+setUp(void) {
+}
+
+
+void
+tearDown(void) {
+}
+
+
+static lagopus_result_t
+s_task_proc(void *arg) {
+  (void)arg;
+  return LAGOPUS_RESULT_OK;
+}
+
+
+static double
+s_elapsed(const struct timespec *start, const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) +
+         (double)(end->tv_nsec - start->tv_nsec) / 1000000000;
+}
+
+
+
+
+
+void
+test_prologue(void) {
+  lagopus_result_t r;
+  const char *argv0 =
+      ((IS_VALID_STRING(lagopus_get_command_name()) == true) ?
+       lagopus_get_command_name() : "callout_perf_test");
+  const char * const argv[] = {
+    argv0, NULL
+  };
+
+  (void)lagopus_mainloop_set_callout_workers_number(N_CALLOUT_WORKERS);
+  r = lagopus_mainloop_with_callout(1, argv, NULL, NULL,
+                                    false, false, true);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+}
+
+
+void
+test_timed_schedule_cancel(void) {
+  struct timespec start, end;
+  size_t i;
+
+  for (i = 0; i < N_TASKS; i++) {
+    s_tasks[i] = NULL;
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_callout_create_task(&s_tasks[i], 0, __func__,
+                                                  s_task_proc, NULL, NULL));
+  }
+
+  get_time_stamp(&start);
+  for (i = 0; i < N_TASKS; i++) {
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_callout_submit_task(
+                        &s_tasks[i],
+                        BASE_DELAY +
+                        (lagopus_chrono_t)((i * 7919) % N_TASKS) *
+                        DELAY_STEP,
+                        0LL));
+  }
+  get_time_stamp(&end);
+  fprintf(OUTPUT, "schedule %d timed tasks: %12.0f tasks/sec\n",
+          N_TASKS, (double)N_TASKS / s_elapsed(&start, &end));
+
+  get_time_stamp(&start);
+  for (i = 0; i < N_TASKS; i++) {
+    lagopus_callout_cancel_task(&s_tasks[i]);
+  }
+  get_time_stamp(&end);
+  fprintf(OUTPUT, "cancel   %d timed tasks: %12.0f tasks/sec\n",
+          N_TASKS, (double)N_TASKS / s_elapsed(&start, &end));
+}
+
+
+void
+test_epilogue(void) {
+  lagopus_result_t r = global_state_request_shutdown(SHUTDOWN_GRACEFULLY);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  lagopus_mainloop_wait_thread();
+}
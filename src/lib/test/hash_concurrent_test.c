@@ -0,0 +1,217 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lagopus_apis.h"
+#include "unity.h"
+
+#define TEST_ASSERT_EQUAL_LAGOPUS_STATUS(expected, result)\
+  TEST_ASSERT_EQUAL_INT((expected), (result))
+
+#define TEST_ASSERT_EQUAL_LAGOPUS_STATUS_MESSAGE(expected, result, message)\
+  TEST_ASSERT_EQUAL_INT_MESSAGE((expected), (result), (message))
+
+#define TEST_ASSERT_NOT_EQUAL_LAGOPUS_STATUS_MESSAGE(expected, result, message)\
+  TEST_ASSERT_NOT_EQUAL_INT_MESSAGE((expected), (result), (message))
+
+#define HASH_TYPE \
+  (LAGOPUS_HASHMAP_TYPE_ONE_WORD | LAGOPUS_HASHMAP_TYPE_CONCURRENT)
+
+typedef struct {
+  uint64_t content;
+} entry;
+
+static void
+delete_entry(void *p) {
+  if (p != NULL) {
+    entry *e = (entry *)p;
+    free(e);
+  }
+}
+
+static inline entry *
+new_entry(uint64_t content) {
+  entry *ret = (entry *)malloc(sizeof(entry));
+  if (ret != NULL) {
+    ret->content = content;
+  }
+  return ret;
+}
+
+#define N_ENTRY 100
+
+void
+setUp(void) {
+}
+
+void
+tearDown(void) {
+}
+
+void
+test_hash_table_string_key(void) {
+  lagopus_result_t rc;
+  lagopus_hashmap_t sht = NULL;
+  char key[32];
+  entry *e;
+  size_t i;
+
+  rc = lagopus_hashmap_create(&sht,
+                              LAGOPUS_HASHMAP_TYPE_STRING |
+                              LAGOPUS_HASHMAP_TYPE_CONCURRENT,
+                              delete_entry);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+
+  for (i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    e = new_entry(i);
+    rc = lagopus_hashmap_add(&sht, (void *)key, (void **)&e, false);
+    TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  }
+  /* The key is copied. */
+  (void)memset(key, 0, sizeof(key));
+  for (i = 0; i < 1000; i++) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    rc = lagopus_hashmap_find(&sht, (void *)key, (void **)&e);
+    TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+    TEST_ASSERT_EQUAL_UINT64(i, e->content);
+  }
+  for (i = 0; i < 1000; i += 2) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    rc = lagopus_hashmap_delete(&sht, (void *)key, NULL, true);
+    TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  }
+  TEST_ASSERT_EQUAL(500, lagopus_hashmap_size(&sht));
+  rc = lagopus_hashmap_find(&sht, (void *)"key2", (void **)&e);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_NOT_FOUND, rc);
+  rc = lagopus_hashmap_find(&sht, (void *)"key3", (void **)&e);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+
+  lagopus_hashmap_destroy(&sht, true);
+
+  /* Multi word keys are not supported. */
+  rc = lagopus_hashmap_create(&sht, 2 | LAGOPUS_HASHMAP_TYPE_CONCURRENT, NULL);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_INVALID_ARGS, rc);
+}
+
+static bool
+increment_proc(void *key, void *val, lagopus_hashentry_t he, void *arg) {
+  size_t *np = (size_t *)arg;
+
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)(uintptr_t)key, (uint64_t)(uintptr_t)val);
+  lagopus_hashmap_set_value(he, (void *)((uintptr_t)val + 1));
+  (*np)++;
+  return true;
+}
+
+void
+test_hash_table_iterate(void) {
+  lagopus_result_t rc;
+  lagopus_hashmap_t iht = NULL;
+  void *val;
+  size_t i, n = 0;
+
+  rc = lagopus_hashmap_create(&iht, HASH_TYPE, NULL);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  for (i = 0; i < N_ENTRY; i++) {
+    val = (void *)i;
+    rc = lagopus_hashmap_add(&iht, (void *)i, &val, false);
+    TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  }
+  rc = lagopus_hashmap_iterate(&iht, increment_proc, &n);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  TEST_ASSERT_EQUAL(N_ENTRY, n);
+  for (i = 0; i < N_ENTRY; i++) {
+    rc = lagopus_hashmap_find(&iht, (void *)i, &val);
+    TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+    TEST_ASSERT_EQUAL_UINT64(i + 1, (uint64_t)(uintptr_t)val);
+  }
+  lagopus_hashmap_destroy(&iht, false);
+}
+
+#define N_READERS 4
+#define N_KEYS 1024
+
+static volatile bool s_stop;
+
+static void *
+reader_main(void *arg) {
+  lagopus_hashmap_t *hmptr = (lagopus_hashmap_t *)arg;
+  lagopus_result_t rc;
+  uintptr_t i = 0;
+  void *val;
+  size_t n_error = 0;
+
+  while (s_stop == false) {
+    i = (i + 1) % N_KEYS;
+    rc = lagopus_hashmap_find(hmptr, (void *)i, &val);
+    if (rc == LAGOPUS_RESULT_OK) {
+      if ((uintptr_t)val != i * 2 + 1) {
+        n_error++;
+      }
+    } else if (rc != LAGOPUS_RESULT_NOT_FOUND || i % 2 == 0) {
+      /* Even keys are never deleted. */
+      n_error++;
+    }
+  }
+
+  return (void *)n_error;
+}
+
+void
+test_hash_table_concurrent_readers(void) {
+  lagopus_result_t rc;
+  lagopus_hashmap_t cht = NULL;
+  pthread_t tids[N_READERS];
+  void *val, *ret;
+  uintptr_t i;
+  size_t round, n_error = 0;
+
+  rc = lagopus_hashmap_create(&cht, HASH_TYPE, NULL);
+  TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  for (i = 0; i < N_KEYS; i++) {
+    val = (void *)(i * 2 + 1);
+    rc = lagopus_hashmap_add(&cht, (void *)i, &val, false);
+    TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+  }
+
+  s_stop = false;
+  for (i = 0; i < N_READERS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&tids[i], NULL, reader_main, &cht));
+  }
+
+  /* Churn the odd keys, growing and rebuilding the array. */
+  for (round = 0; round < 200; round++) {
+    for (i = 1; i < N_KEYS; i += 2) {
+      rc = lagopus_hashmap_delete(&cht, (void *)i, NULL, false);
+      TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+    }
+    for (i = 1; i < N_KEYS; i += 2) {
+      val = (void *)(i * 2 + 1);
+      rc = lagopus_hashmap_add(&cht, (void *)i, &val, true);
+      TEST_ASSERT_EQUAL_LAGOPUS_STATUS(LAGOPUS_RESULT_OK, rc);
+    }
+  }
+
+  s_stop = true;
+  for (i = 0; i < N_READERS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_join(tids[i], &ret));
+    n_error += (size_t)ret;
+  }
+  TEST_ASSERT_EQUAL(0, n_error);
+  TEST_ASSERT_EQUAL(N_KEYS, lagopus_hashmap_size(&cht));
+
+  lagopus_hashmap_destroy(&cht, false);
+}
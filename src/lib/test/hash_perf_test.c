@@ -0,0 +1,124 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+#include "lagopus_apis.h"
+
+#define OUTPUT stdout
+#define get_time_stamp(tp) clock_gettime(CLOCK_MONOTONIC, (tp))
+
+#define MAX_READERS	8
+#define N_KEYS		4096
+#define N_LOOKUPS	(1000 * 1000)
+
+
+
+
+
+/* thread value */
+struct thread_value {
+  lagopus_hashmap_t *hmptr;
+  pthread_barrier_t *barrier;
+  size_t n_found;
+};
+
+
+void
+setUp(void) {
+}
+
+void
+tearDown(void) {
+}
+
+
+static void *
+s_reader(void *arg) {
+  struct thread_value *tv = (struct thread_value *)arg;
+  uintptr_t i;
+  void *val;
+
+  (void)pthread_barrier_wait(tv->barrier);
+  for (i = 0; i < N_LOOKUPS; i++) {
+    if (lagopus_hashmap_find(tv->hmptr, (void *)(i % N_KEYS), &val) ==
+        LAGOPUS_RESULT_OK) {
+      tv->n_found++;
+    }
+  }
+
+  return NULL;
+}
+
+
+/* Total lookups per second with n readers. */
+static double
+s_measure(lagopus_hashmap_t *hmptr, size_t n) {
+  pthread_t tids[MAX_READERS];
+  struct thread_value tvs[MAX_READERS];
+  pthread_barrier_t barrier;
+  struct timespec start, end;
+  size_t i;
+
+  TEST_ASSERT_EQUAL(0, pthread_barrier_init(&barrier, NULL,
+                    (unsigned int)n + 1));
+  for (i = 0; i < n; i++) {
+    tvs[i].hmptr = hmptr;
+    tvs[i].barrier = &barrier;
+    tvs[i].n_found = 0;
+    TEST_ASSERT_EQUAL(0, pthread_create(&tids[i], NULL, s_reader, &tvs[i]));
+  }
+  get_time_stamp(&start);
+  (void)pthread_barrier_wait(&barrier);
+  for (i = 0; i < n; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_join(tids[i], NULL));
+    TEST_ASSERT_EQUAL(N_LOOKUPS, tvs[i].n_found);
+  }
+  get_time_stamp(&end);
+  (void)pthread_barrier_destroy(&barrier);
+
+  return (double)(n * N_LOOKUPS) /
+         ((double)(end.tv_sec - start.tv_sec) +
+          (double)(end.tv_nsec - start.tv_nsec) / 1000000000);
+}
+
+
+static void
+s_run(const char *name, lagopus_hashmap_type_t t) {
+  lagopus_hashmap_t hm = NULL;
+  uintptr_t i;
+  size_t n;
+  void *val;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_hashmap_create(&hm, t, NULL));
+  for (i = 0; i < N_KEYS; i++) {
+    val = (void *)i;
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_hashmap_add(&hm, (void *)i, &val, false));
+  }
+  for (n = 1; n <= MAX_READERS; n *= 2) {
+    fprintf(OUTPUT, "%-10s %zu reader(s): %12.0f lookups/sec\n",
+            name, n, s_measure(&hm, n));
+  }
+  lagopus_hashmap_destroy(&hm, false);
+}
+
+
+void
+test_hashmap_readers_scalability(void) {
+  s_run("rwlock", LAGOPUS_HASHMAP_TYPE_ONE_WORD);
+  s_run("concurrent",
+        LAGOPUS_HASHMAP_TYPE_ONE_WORD | LAGOPUS_HASHMAP_TYPE_CONCURRENT);
+}
@@ -26,6 +26,11 @@
 #define TEST_ASSERT_NOT_EQUAL_LAGOPUS_STATUS_MESSAGE(expected, result, message)\
   TEST_ASSERT_NOT_EQUAL_INT_MESSAGE((expected), (result), (message))
 
+/* built a second time with -DHASH_TYPE for the concurrent hashmap. */
+#ifndef HASH_TYPE
+#define HASH_TYPE LAGOPUS_HASHMAP_TYPE_ONE_WORD
+#endif /* HASH_TYPE */
+
 typedef struct {
   uint64_t content;
 } entry;
@@ -61,7 +66,7 @@ setUp(void) {
     exit(1);
   }
   if ((rc = lagopus_hashmap_create(&ht,
-                                   LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                                   HASH_TYPE,
                                    delete_entry)) != LAGOPUS_RESULT_OK) {
     lagopus_perror(rc);
     exit(1);
@@ -82,7 +87,7 @@ test_hash_table_creation(void) {
   lagopus_hashmap_t myht = NULL;
 
   if ((rc = lagopus_hashmap_create(&myht,
-                                   LAGOPUS_HASHMAP_TYPE_ONE_WORD,
+                                   HASH_TYPE,
                                    delete_entry)) != LAGOPUS_RESULT_OK) {
     TEST_FAIL_MESSAGE("creation failed");
     goto done;
@@ -114,7 +119,7 @@ test_invalid_arguments(void) {
   lagopus_result_t rc;
   entry *e;
   size_t i = 0;
-  rc = lagopus_hashmap_create(NULL, LAGOPUS_HASHMAP_TYPE_ONE_WORD, NULL);
+  rc = lagopus_hashmap_create(NULL, HASH_TYPE, NULL);
   TEST_ASSERT_EQUAL_LAGOPUS_STATUS_MESSAGE(LAGOPUS_RESULT_INVALID_ARGS, rc,
       "lagopus_hashmap_create(hmptr=NULL, ...) is invalid argument");
 
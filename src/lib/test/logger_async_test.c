@@ -0,0 +1,193 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+#include "lagopus_apis.h"
+
+#define OUTPUT stdout
+#define LOG_FILE "./logger_async_test.log"
+#define N_THREADS 4
+#define N_MSGS 20000
+
+struct thread_arg {
+  int id;
+  pthread_barrier_t *barrier;
+  lagopus_chrono_t *lat;	/* Per message latency in nsec. */
+};
+
+
+void
+setUp(void) {
+  (void)unlink(LOG_FILE);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_log_initialize(LAGOPUS_LOG_EMIT_TO_FILE, LOG_FILE,
+                                           false, false, 0));
+}
+
+void
+tearDown(void) {
+  (void)lagopus_log_set_async(false);
+  lagopus_log_finalize();
+  (void)unlink(LOG_FILE);
+}
+
+
+static void *
+s_logger(void *arg) {
+  struct thread_arg *ta = (struct thread_arg *)arg;
+  lagopus_chrono_t start, end;
+  int i;
+
+  (void)pthread_barrier_wait(ta->barrier);
+  for (i = 0; i < N_MSGS; i++) {
+    WHAT_TIME_IS_IT_NOW_IN_NSEC(start);
+    lagopus_msg_info("thread %d message %d\n", ta->id, i);
+    WHAT_TIME_IS_IT_NOW_IN_NSEC(end);
+    if (ta->lat != NULL) {
+      ta->lat[i] = end - start;
+    }
+  }
+
+  return NULL;
+}
+
+
+/* Total messages per second. */
+static double
+s_run(lagopus_chrono_t *lat) {
+  pthread_t tids[N_THREADS];
+  struct thread_arg tas[N_THREADS];
+  pthread_barrier_t barrier;
+  lagopus_chrono_t start, end;
+  int i;
+
+  TEST_ASSERT_EQUAL(0, pthread_barrier_init(&barrier, NULL, N_THREADS + 1));
+  for (i = 0; i < N_THREADS; i++) {
+    tas[i].id = i;
+    tas[i].barrier = &barrier;
+    tas[i].lat = (lat != NULL) ? lat + i * N_MSGS : NULL;
+    TEST_ASSERT_EQUAL(0, pthread_create(&tids[i], NULL, s_logger, &tas[i]));
+  }
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(start);
+  (void)pthread_barrier_wait(&barrier);
+  for (i = 0; i < N_THREADS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_join(tids[i], NULL));
+  }
+  lagopus_log_flush();
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(end);
+  (void)pthread_barrier_destroy(&barrier);
+
+  return (double)(N_THREADS * N_MSGS) * 1000000000.0 / (double)(end - start);
+}
+
+
+static int
+s_chrono_cmp(const void *a, const void *b) {
+  lagopus_chrono_t x = *(const lagopus_chrono_t *)a;
+  lagopus_chrono_t y = *(const lagopus_chrono_t *)b;
+
+  return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+
+void
+test_logger_async_all_emitted(void) {
+  FILE *fp;
+  char line[4096];
+  int next[N_THREADS] = { 0 };
+  int id, n;
+  uint64_t n_lines = 0;
+  uint64_t dropped;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_log_set_async(true));
+  TEST_ASSERT_TRUE(lagopus_log_is_async());
+  dropped = lagopus_log_get_n_dropped();
+  (void)s_run(NULL);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_log_set_async(false));
+  TEST_ASSERT_FALSE(lagopus_log_is_async());
+  dropped = lagopus_log_get_n_dropped() - dropped;
+
+  TEST_ASSERT_NOT_NULL(fp = fopen(LOG_FILE, "r"));
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    char *p = strstr(line, "thread ");
+    if (p == NULL) {
+      continue;
+    }
+    TEST_ASSERT_EQUAL(2, sscanf(p, "thread %d message %d", &id, &n));
+    TEST_ASSERT_TRUE(id >= 0 && id < N_THREADS);
+    /* A thread's messages keep their order, possibly with drops. */
+    TEST_ASSERT_TRUE(n >= next[id]);
+    next[id] = n + 1;
+    n_lines++;
+  }
+  (void)fclose(fp);
+
+  TEST_ASSERT_EQUAL_UINT64((uint64_t)(N_THREADS * N_MSGS),
+                           n_lines + dropped);
+}
+
+
+void
+test_logger_async_error_is_synchronous(void) {
+  FILE *fp;
+  char line[4096];
+  int n_found = 0;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK, lagopus_log_set_async(true));
+  lagopus_msg_info("before the error\n");
+  lagopus_msg_error("the error\n");
+
+  /* Both are in the file without a flush, in order. */
+  TEST_ASSERT_NOT_NULL(fp = fopen(LOG_FILE, "r"));
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (strstr(line, "before the error") != NULL) {
+      TEST_ASSERT_EQUAL(0, n_found);
+      n_found++;
+    } else if (strstr(line, "the error") != NULL) {
+      TEST_ASSERT_EQUAL(1, n_found);
+      n_found++;
+    }
+  }
+  (void)fclose(fp);
+  TEST_ASSERT_EQUAL(2, n_found);
+}
+
+
+void
+test_logger_async_benchmark(void) {
+  size_t n = N_THREADS * N_MSGS;
+  lagopus_chrono_t *lat =
+    (lagopus_chrono_t *)malloc(sizeof(lagopus_chrono_t) * n);
+  double mps;
+  uint64_t dropped;
+  int async;
+
+  TEST_ASSERT_NOT_NULL(lat);
+  for (async = 0; async < 2; async++) {
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_log_set_async((async == 1) ? true : false));
+    dropped = lagopus_log_get_n_dropped();
+    mps = s_run(lat);
+    dropped = lagopus_log_get_n_dropped() - dropped;
+    qsort(lat, n, sizeof(*lat), s_chrono_cmp);
+    fprintf(OUTPUT, "%-5s %d threads: %10.0f msgs/sec (" PF64(u)
+            " dropped), latency nsec p50 " PF64(d) " p99 " PF64(d)
+            " p99.9 " PF64(d) " max " PF64(d) "\n",
+            (async == 1) ? "async" : "sync", N_THREADS, mps, dropped,
+            lat[n / 2], lat[n * 99 / 100], lat[n * 999 / 1000], lat[n - 1]);
+  }
+  free((void *)lat);
+}
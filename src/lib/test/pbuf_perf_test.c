@@ -0,0 +1,200 @@
+/*
+ * Copyright 2014-2017 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/queue.h>
+#include "unity.h"
+#include "lagopus_apis.h"
+#include "lagopus/pbuf.h"
+#include "openflow.h"
+
+#define OUTPUT stdout
+#define get_time_stamp(tp) clock_gettime(CLOCK_MONOTONIC, (tp))
+
+/*
+ * Like the agent, a receiver thread reads each message into a fresh
+ * 64 KB pbuf and passes it to a handler thread which frees it. The
+ * queue is shorter than the thread cache and the depot together so
+ * that a burst of it is recycled.
+ */
+#define RECV_PBUF_SIZE	(64 * 1024)
+#define N_MSGS		(200 * 1000)
+#define N_WARMUP	(10 * 1000)
+#define Q_LEN		32
+
+/* Max RSS growth after the warm up. */
+#define RSS_SLACK	(8 * 1024 * 1024)
+
+#define FLOW_MOD_LEN	(sizeof(struct ofp_flow_mod) + 24)
+
+
+
+
+
+typedef LAGOPUS_BOUND_BLOCK_Q_DECL(msg_bbq, struct pbuf *) msg_bbq;
+
+static msg_bbq s_q;
+static bool s_use_pbuf;
+
+
+void
+setUp(void) {
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_create(&s_q, struct pbuf *, Q_LEN, NULL));
+}
+
+
+void
+tearDown(void) {
+  lagopus_bbq_shutdown(&s_q, true);
+  lagopus_bbq_destroy(&s_q, true);
+}
+
+
+static size_t
+s_rss(void) {
+  FILE *fp;
+  unsigned long size = 0, rss = 0;
+
+  if ((fp = fopen("/proc/self/statm", "r")) != NULL) {
+    if (fscanf(fp, "%lu %lu", &size, &rss) != 2) {
+      rss = 0;
+    }
+    fclose(fp);
+  }
+
+  return (size_t)rss * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+
+static struct pbuf *
+s_recv(size_t i) {
+  struct ofp_header hdr;
+  struct pbuf *pbuf;
+  size_t len;
+
+  if (s_use_pbuf == true) {
+    pbuf = pbuf_alloc(RECV_PBUF_SIZE);
+  } else {
+    /* What pbuf_alloc() used to do. */
+    pbuf = (struct pbuf *)calloc(1, sizeof(struct pbuf) + RECV_PBUF_SIZE);
+    if (pbuf != NULL) {
+      pbuf->size = RECV_PBUF_SIZE;
+      pbuf->refs = 1;
+      pbuf_reset(pbuf);
+    }
+  }
+  TEST_ASSERT_NOT_NULL(pbuf);
+
+  /* Flow-mods and echo requests, half and half. */
+  len = ((i & 1) == 0) ? FLOW_MOD_LEN : sizeof(struct ofp_header);
+  hdr.version = OPENFLOW_VERSION_1_3;
+  hdr.type = ((i & 1) == 0) ? OFPT_FLOW_MOD : OFPT_ECHO_REQUEST;
+  hdr.length = htons((uint16_t)len);
+  hdr.xid = htonl((uint32_t)i);
+  memcpy(pbuf->putp, &hdr, sizeof(hdr));
+  memset(pbuf->putp + sizeof(hdr), 0, len - sizeof(hdr));
+  pbuf->putp += len;
+  pbuf->plen = len;
+
+  return pbuf;
+}
+
+
+static void *
+s_handler(void *arg) {
+  struct pbuf *pbuf;
+
+  (void)arg;
+  while (lagopus_bbq_get(&s_q, &pbuf, struct pbuf *, -1LL) ==
+         LAGOPUS_RESULT_OK && pbuf != NULL) {
+    if (s_use_pbuf == true) {
+      pbuf_free(pbuf);
+    } else {
+      free(pbuf);
+    }
+  }
+
+  return NULL;
+}
+
+
+static void
+s_flood(const char *name, bool use_pbuf) {
+  struct timespec start, end;
+  pthread_t tid;
+  struct pbuf *pbuf;
+  size_t rss_warm, rss_end;
+  double sec;
+  size_t i;
+
+  s_use_pbuf = use_pbuf;
+  TEST_ASSERT_EQUAL(0, pthread_create(&tid, NULL, s_handler, NULL));
+
+  for (i = 0; i < N_WARMUP; i++) {
+    pbuf = s_recv(i);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_bbq_put(&s_q, &pbuf, struct pbuf *, -1LL));
+  }
+  rss_warm = s_rss();
+
+  get_time_stamp(&start);
+  for (i = 0; i < N_MSGS; i++) {
+    pbuf = s_recv(i);
+    TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                      lagopus_bbq_put(&s_q, &pbuf, struct pbuf *, -1LL));
+  }
+  pbuf = NULL;
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    lagopus_bbq_put(&s_q, &pbuf, struct pbuf *, -1LL));
+  TEST_ASSERT_EQUAL(0, pthread_join(tid, NULL));
+  get_time_stamp(&end);
+  rss_end = s_rss();
+
+  sec = (double)(end.tv_sec - start.tv_sec) +
+        (double)(end.tv_nsec - start.tv_nsec) / 1000000000;
+  fprintf(OUTPUT, "%-6s %d msgs: %8.1f nsec/msg, RSS %zu KB -> %zu KB\n",
+          name, N_MSGS, sec * 1000000000 / N_MSGS,
+          rss_warm / 1024, rss_end / 1024);
+
+  TEST_ASSERT_TRUE(rss_end <= rss_warm + RSS_SLACK);
+}
+
+
+void
+test_pbuf_flood_calloc(void) {
+  s_flood("calloc", false);
+}
+
+
+void
+test_pbuf_flood_cached(void) {
+  struct pbuf_cache_stats before, after;
+
+  pbuf_cache_stats_get(&before);
+  s_flood("cached", true);
+  pbuf_cache_stats_get(&after);
+
+  fprintf(OUTPUT, "cached hits " PF64(u) ", misses " PF64(u)
+          ", depot " PF64(u) "\n",
+          after.hits - before.hits, after.misses - before.misses,
+          after.depot);
+
+  /* Most of the buffers are recycled. */
+  TEST_ASSERT_TRUE((after.misses - before.misses) * 20 <
+                   N_WARMUP + N_MSGS);
+
+  pbuf_cache_purge();
+}
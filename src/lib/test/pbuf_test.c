@@ -18,6 +18,7 @@
 #include "unity.h"
 #include "lagopus_apis.h"
 #include "lagopus/pbuf.h"
+#include "openflow.h"
 
 void
 setUp(void) {
@@ -201,3 +202,127 @@ test_pbuf_info_store_load_normal(void) {
   /* after. */
   pbuf_free(pbuf);
 }
+
+void
+test_pbuf_cache_reuse(void) {
+  struct pbuf_cache_stats before, after;
+  struct pbuf *pbuf;
+  struct pbuf *reused;
+
+  pbuf_cache_purge();
+  pbuf = pbuf_alloc(OFP_PACKET_MAX_SIZE);
+  TEST_ASSERT_NOT_NULL(pbuf);
+  pbuf_free(pbuf);
+
+  pbuf_cache_stats_get(&before);
+  reused = pbuf_alloc(OFP_PACKET_MAX_SIZE - 100);
+  pbuf_cache_stats_get(&after);
+
+  /* the freed buffer of the same size class is handed out again. */
+  TEST_ASSERT_EQUAL_PTR(pbuf, reused);
+  TEST_ASSERT_EQUAL(before.hits + 1, after.hits);
+  TEST_ASSERT_EQUAL(before.misses, after.misses);
+  TEST_ASSERT_EQUAL(OFP_PACKET_MAX_SIZE - 100, reused->size);
+  TEST_ASSERT_EQUAL(1, reused->refs);
+  TEST_ASSERT_EQUAL(0, reused->plen);
+  TEST_ASSERT_EQUAL_PTR(reused->data, reused->getp);
+  TEST_ASSERT_EQUAL_PTR(reused->data, reused->putp);
+  TEST_ASSERT_EQUAL(OFP_PACKET_MAX_SIZE - 100, pbuf_writable_size(reused));
+
+  pbuf_free(reused);
+  pbuf_cache_purge();
+}
+
+void
+test_pbuf_cache_refs(void) {
+  struct pbuf_cache_stats before, after;
+  struct pbuf *pbuf;
+  struct pbuf *other;
+
+  pbuf_cache_purge();
+  pbuf = pbuf_alloc(PBUF_LENGTH);
+  pbuf_cache_stats_get(&before);
+  pbuf_get(pbuf);
+  pbuf_free(pbuf);
+  /* still referenced, not recycled. */
+  other = pbuf_alloc(PBUF_LENGTH);
+  TEST_ASSERT_TRUE(other != pbuf);
+  pbuf_cache_stats_get(&after);
+  TEST_ASSERT_EQUAL(before.misses + 1, after.misses);
+  pbuf_free(other);
+  pbuf_free(pbuf);
+
+  pbuf_cache_purge();
+}
+
+void
+test_pbuf_cache_large(void) {
+  struct pbuf_cache_stats before, after;
+  struct pbuf *pbuf;
+
+  /* larger than the size classes, not cached. */
+  pbuf_cache_purge();
+  pbuf_cache_stats_get(&before);
+  pbuf = pbuf_alloc(1024 * 1024);
+  TEST_ASSERT_NOT_NULL(pbuf);
+  TEST_ASSERT_EQUAL(1024 * 1024, pbuf_writable_size(pbuf));
+  pbuf_free(pbuf);
+  pbuf = pbuf_alloc(1024 * 1024);
+  pbuf_free(pbuf);
+  pbuf_cache_stats_get(&after);
+
+  TEST_ASSERT_EQUAL(before.hits, after.hits);
+  TEST_ASSERT_EQUAL(before.misses + 2, after.misses);
+  TEST_ASSERT_EQUAL(0, after.depot);
+}
+
+void
+test_pbuf_cache_depot_bound(void) {
+  struct pbuf *pbufs[PBUF_CACHE_DEPTH + PBUF_DEPOT_DEPTH + 16];
+  struct pbuf_cache_stats stats;
+  size_t n = sizeof(pbufs) / sizeof(pbufs[0]);
+  size_t i;
+
+  pbuf_cache_purge();
+  for (i = 0; i < n; i++) {
+    pbufs[i] = pbuf_alloc(OFP_PACKET_MAX_SIZE);
+    TEST_ASSERT_NOT_NULL(pbufs[i]);
+  }
+  for (i = 0; i < n; i++) {
+    pbuf_free(pbufs[i]);
+  }
+
+  pbuf_cache_stats_get(&stats);
+  TEST_ASSERT_TRUE(stats.depot > 0);
+  TEST_ASSERT_TRUE(stats.depot <= PBUF_DEPOT_DEPTH);
+
+  pbuf_cache_purge();
+  pbuf_cache_stats_get(&stats);
+  TEST_ASSERT_EQUAL(0, stats.depot);
+}
+
+static void *
+s_pbuf_thread(void *arg) {
+  struct pbuf *pbuf = pbuf_alloc(OFP_PACKET_MAX_SIZE);
+
+  (void)arg;
+  pbuf_free(pbuf);
+
+  return NULL;
+}
+
+void
+test_pbuf_cache_thread_exit(void) {
+  struct pbuf_cache_stats stats;
+  pthread_t tid;
+
+  /* the cache of an exited thread goes to the depot. */
+  pbuf_cache_purge();
+  TEST_ASSERT_EQUAL(0, pthread_create(&tid, NULL, s_pbuf_thread, NULL));
+  TEST_ASSERT_EQUAL(0, pthread_join(tid, NULL));
+
+  pbuf_cache_stats_get(&stats);
+  TEST_ASSERT_EQUAL(1, stats.depot);
+
+  pbuf_cache_purge();
+}
@@ -205,3 +205,176 @@ test_invalid_args(void) {
   TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_NOT_FOUND);
   TEST_ASSERT_EQUAL(s, NULL);
 }
+
+
+
+
+
+void
+test_histogram_normal(void) {
+  lagopus_result_t r;
+  lagopus_histogram_t h = NULL;
+  lagopus_histogram_t h_check = NULL;
+  lagopus_histogram_summary_t sum;
+  int64_t val;
+  int64_t i;
+
+  r = lagopus_histogram_create(&h, "hist");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+
+  r = lagopus_histogram_create(&h_check, "hist");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_ALREADY_EXISTS);
+
+  r = lagopus_histogram_find(&h_check, "hist");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(h, h_check);
+
+  r = lagopus_histogram_sample_n(&h);
+  TEST_ASSERT_EQUAL(r, 0);
+  r = lagopus_histogram_summary(&h, &sum);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(sum.m_p50, 0);
+  TEST_ASSERT_EQUAL(sum.m_max, 0);
+
+  /* Small values are exact. */
+  for (i = 1; i <= 10; i++) {
+    r = lagopus_histogram_record(&h, i);
+    TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  }
+  r = lagopus_histogram_percentile(&h, 50.0, &val);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(val, 5);
+  r = lagopus_histogram_percentile(&h, 100.0, &val);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(val, 10);
+
+  r = lagopus_histogram_reset(&h);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  r = lagopus_histogram_sample_n(&h);
+  TEST_ASSERT_EQUAL(r, 0);
+
+  /* Large values within the bucket width. */
+  for (i = 1; i <= 100000; i++) {
+    r = lagopus_histogram_record(&h, i * 1000);
+    TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  }
+  r = lagopus_histogram_record(&h, -1);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  r = lagopus_histogram_record(&h, LLONG_MAX);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+
+  r = lagopus_histogram_summary(&h, &sum);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(sum.m_n, 100002);
+  TEST_ASSERT_TRUE(sum.m_p50 >= 50000000LL &&
+                   sum.m_p50 <= 50000000LL + 50000000LL / 32);
+  TEST_ASSERT_TRUE(sum.m_p99 >= 99000000LL &&
+                   sum.m_p99 <= 99000000LL + 99000000LL / 32);
+  TEST_ASSERT_TRUE(sum.m_p999 >= 99900000LL &&
+                   sum.m_p999 <= 99900000LL + 99900000LL / 32);
+  TEST_ASSERT_EQUAL(sum.m_max, LLONG_MAX);
+
+  r = lagopus_histogram_percentile(&h, 0.0, &val);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(val, 0);
+
+  lagopus_histogram_destroy(&h);
+  h = NULL;
+
+  r = lagopus_histogram_find(&h, "hist");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_NOT_FOUND);
+  TEST_ASSERT_EQUAL(h, NULL);
+}
+
+
+#define HIST_N_THREADS	4
+#define HIST_N_RECORDS	100000
+
+static void *
+s_hist_recorder(void *arg) {
+  lagopus_histogram_t *hptr = (lagopus_histogram_t *)arg;
+  int64_t i;
+
+  for (i = 0; i < HIST_N_RECORDS; i++) {
+    if (lagopus_histogram_record(hptr, i) != LAGOPUS_RESULT_OK) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+
+void
+test_histogram_threads(void) {
+  lagopus_result_t r;
+  lagopus_histogram_t h = NULL;
+  pthread_t tids[HIST_N_THREADS];
+  int64_t val;
+  size_t i;
+
+  r = lagopus_histogram_create(&h, "hist_threads");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+
+  /* The samples of the exited threads are kept. */
+  for (i = 0; i < HIST_N_THREADS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_create(&tids[i], NULL,
+                                        s_hist_recorder, (void *)&h));
+  }
+  for (i = 0; i < HIST_N_THREADS; i++) {
+    TEST_ASSERT_EQUAL(0, pthread_join(tids[i], NULL));
+  }
+  r = lagopus_histogram_sample_n(&h);
+  TEST_ASSERT_EQUAL(r, HIST_N_THREADS * HIST_N_RECORDS);
+
+  /* And the threads taking over the copies add to them. */
+  TEST_ASSERT_EQUAL(0, pthread_create(&tids[0], NULL,
+                                      s_hist_recorder, (void *)&h));
+  TEST_ASSERT_EQUAL(0, pthread_join(tids[0], NULL));
+  r = lagopus_histogram_sample_n(&h);
+  TEST_ASSERT_EQUAL(r, (HIST_N_THREADS + 1) * HIST_N_RECORDS);
+
+  r = lagopus_histogram_percentile(&h, 100.0, &val);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+  TEST_ASSERT_EQUAL(val, HIST_N_RECORDS - 1);
+
+  lagopus_histogram_destroy(&h);
+}
+
+
+void
+test_histogram_invalid_args(void) {
+  lagopus_result_t r;
+  lagopus_histogram_t h = NULL;
+  lagopus_histogram_summary_t sum;
+  int64_t val;
+
+  r = lagopus_histogram_create(NULL, NULL);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_create(&h, "");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_find(&h, NULL);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+
+  r = lagopus_histogram_create(&h, "hist2");
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_OK);
+
+  r = lagopus_histogram_record(NULL, 0);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_reset(NULL);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_sample_n(NULL);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_percentile(&h, 50.0, NULL);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_percentile(&h, 100.1, &val);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_percentile(NULL, 50.0, &val);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_summary(&h, NULL);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+  r = lagopus_histogram_summary(NULL, &sum);
+  TEST_ASSERT_EQUAL(r, LAGOPUS_RESULT_INVALID_ARGS);
+
+  lagopus_histogram_destroy(&h);
+}
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -36,6 +37,11 @@
 #define TO_COUNTER32(x) ((uint32_t)((x) - (((x) / UINT32_MAX) * UINT32_MAX)))
 #define TO_GAUGE32(x) (((x) > UINT32_MAX)?UINT32_MAX:((uint32_t)(x)))
 
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct dataplane_interface_snapshot
+  *snapshots[DATAPLANE_INTERFACE_SOURCE_MAX];
+static lagopus_chrono_t snapshot_ttl = DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC;
+
 static int32_t
 ifType_mapping(sa_family_t raw_device_type) {
   int32_t ret;
@@ -733,7 +739,7 @@ dataplane_interface_get_MtuExceededDiscards(
   uint32_t *value) {
   if (port_stat != NULL && value != NULL) {
     lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
-    uint32_t mtuExceededDiscards;
+    uint64_t mtuExceededDiscards;
     ret = port_stat_get_mtu_exceeded_discards(
             port_stat, index,
             &mtuExceededDiscards);
@@ -747,3 +753,223 @@ dataplane_interface_get_MtuExceededDiscards(
     return LAGOPUS_RESULT_INVALID_ARGS;
   }
 }
+
+static lagopus_result_t
+snapshot_port_stat_get(enum dataplane_interface_source source,
+                       struct port_stat **port_stat) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  struct bridge_stat *bridge_stat = NULL;
+
+  if (source == DATAPLANE_INTERFACE_PORTS) {
+    return dp_get_port_stat(port_stat);
+  }
+  if ((ret = dp_get_bridge_stat(&bridge_stat)) == LAGOPUS_RESULT_OK) {
+    ret = bridge_stat_get_port_stat(bridge_stat, 0, port_stat);
+    bridge_stat_release(bridge_stat);
+    free(bridge_stat);
+  }
+  return ret;
+}
+
+#define SNAPSHOT_COLUMN(row, column, call)      \
+  do {                                          \
+    if ((call) == LAGOPUS_RESULT_OK) {          \
+      (row)->valid |= IFCOL_ ## column;         \
+    }                                           \
+  } while (0)
+
+static void
+snapshot_row_fill(struct port_stat *port_stat, size_t index,
+                  struct dataplane_interface_row *row) {
+  struct ifTable_entry *entry = &row->entry;
+  size_t ifindex;
+
+  entry->ifIndex = (int32_t)(index + 1);
+  entry->ifDescr_len = IFNAMSIZ + 1;
+  SNAPSHOT_COLUMN(row, ifDescr,
+                  dataplane_interface_get_ifDescr(
+                    port_stat, index,
+                    entry->ifDescr, &entry->ifDescr_len));
+  SNAPSHOT_COLUMN(row, ifType,
+                  dataplane_interface_get_ifType(
+                    port_stat, index, &entry->ifType));
+  SNAPSHOT_COLUMN(row, ifMtu,
+                  dataplane_interface_get_ifMtu(
+                    port_stat, index, &entry->ifMtu));
+  SNAPSHOT_COLUMN(row, ifSpeed,
+                  dataplane_interface_get_ifSpeed(
+                    port_stat, index, &entry->ifSpeed));
+  SNAPSHOT_COLUMN(row, ifPhysAddress,
+                  dataplane_interface_get_ifPhysAddress(
+                    port_stat, index,
+                    entry->ifPhysAddress, &entry->ifPhysAddress_len));
+  SNAPSHOT_COLUMN(row, ifAdminStatus,
+                  dataplane_interface_get_ifAdminStatus(
+                    port_stat, index, &entry->ifAdminStatus));
+  SNAPSHOT_COLUMN(row, ifOperStatus,
+                  dataplane_interface_get_ifOperStatus(
+                    port_stat, index, &entry->ifOperStatus));
+  SNAPSHOT_COLUMN(row, ifLastChange,
+                  dataplane_interface_get_ifLastChange(
+                    port_stat, index, &entry->ifLastChange));
+  SNAPSHOT_COLUMN(row, ifInOctets,
+                  dataplane_interface_get_ifInOctets(
+                    port_stat, index, &entry->ifInOctets));
+  SNAPSHOT_COLUMN(row, ifInUcastPkts,
+                  dataplane_interface_get_ifInUcastPkts(
+                    port_stat, index, &entry->ifInUcastPkts));
+  SNAPSHOT_COLUMN(row, ifInDiscards,
+                  dataplane_interface_get_ifInDiscards(
+                    port_stat, index, &entry->ifInDiscards));
+  SNAPSHOT_COLUMN(row, ifInErrors,
+                  dataplane_interface_get_ifInErrors(
+                    port_stat, index, &entry->ifInErrors));
+  SNAPSHOT_COLUMN(row, ifOutOctets,
+                  dataplane_interface_get_ifOutOctets(
+                    port_stat, index, &entry->ifOutOctets));
+  SNAPSHOT_COLUMN(row, ifOutUcastPkts,
+                  dataplane_interface_get_ifOutUcastPkts(
+                    port_stat, index, &entry->ifOutUcastPkts));
+  SNAPSHOT_COLUMN(row, ifOutDiscards,
+                  dataplane_interface_get_ifOutDiscards(
+                    port_stat, index, &entry->ifOutDiscards));
+  SNAPSHOT_COLUMN(row, ifOutErrors,
+                  dataplane_interface_get_ifOutErrors(
+                    port_stat, index, &entry->ifOutErrors));
+  if (dataplane_bridge_stat_get_port_ifIndex(
+        port_stat, index, &ifindex) == LAGOPUS_RESULT_OK) {
+    entry->dot1dBasePortIfIndex = (int32_t)(ifindex + 1);
+    row->valid |= IFCOL_dot1dBasePortIfIndex;
+  }
+  SNAPSHOT_COLUMN(row, dot1dBasePortDelayExceededDiscards,
+                  dataplane_interface_get_DelayExceededDiscards(
+                    port_stat, index,
+                    &entry->dot1dBasePortDelayExceededDiscards));
+  SNAPSHOT_COLUMN(row, dot1dBasePortMtuExceededDiscards,
+                  dataplane_interface_get_MtuExceededDiscards(
+                    port_stat, index,
+                    &entry->dot1dBasePortMtuExceededDiscards));
+}
+
+#undef SNAPSHOT_COLUMN
+
+/* Take a snapshot, holding the port_stat only once. */
+static lagopus_result_t
+snapshot_take(enum dataplane_interface_source source,
+              struct dataplane_interface_snapshot **snapshot) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  struct dataplane_interface_snapshot *snap;
+  struct port_stat *port_stat = NULL;
+  size_t num, index;
+
+  if ((ret = snapshot_port_stat_get(source, &port_stat))
+      != LAGOPUS_RESULT_OK) {
+    lagopus_msg_error("failed to get port_stat: %s\n",
+                      lagopus_error_get_string(ret));
+    return ret;
+  }
+  if ((ret = port_stat_count(port_stat, &num)) == LAGOPUS_RESULT_OK) {
+    snap = (struct dataplane_interface_snapshot *)
+           calloc(1, sizeof(*snap) + num * sizeof(snap->rows[0]));
+    if (snap != NULL) {
+      snap->refcnt = 1;
+      snap->num = num;
+      WHAT_TIME_IS_IT_NOW_IN_NSEC(snap->taken);
+      for (index = 0; index < num; index++) {
+        snapshot_row_fill(port_stat, index, &snap->rows[index]);
+      }
+      *snapshot = snap;
+    } else {
+      ret = LAGOPUS_RESULT_NO_MEMORY;
+    }
+  } else {
+    lagopus_msg_warning("cannot count ports: %s\n",
+                        lagopus_error_get_string(ret));
+  }
+  port_stat_release(port_stat);
+  free(port_stat);
+  return ret;
+}
+
+static void
+snapshot_unref(struct dataplane_interface_snapshot *snapshot) {
+  if (snapshot != NULL && --snapshot->refcnt == 0) {
+    free(snapshot);
+  }
+}
+
+lagopus_result_t
+dataplane_interface_snapshot_get(
+  enum dataplane_interface_source source,
+  struct dataplane_interface_snapshot **snapshot) {
+  lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
+  struct dataplane_interface_snapshot *snap;
+  lagopus_chrono_t now;
+
+  if (snapshot == NULL || source < DATAPLANE_INTERFACE_PORTS ||
+      source >= DATAPLANE_INTERFACE_SOURCE_MAX) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+
+  WHAT_TIME_IS_IT_NOW_IN_NSEC(now);
+  (void)pthread_mutex_lock(&snapshot_lock);
+  snap = snapshots[source];
+  if (snap != NULL &&
+      (now < snap->taken || now - snap->taken >= snapshot_ttl)) {
+    snapshots[source] = NULL;
+    snapshot_unref(snap);
+    snap = NULL;
+  }
+  if (snap == NULL) {
+    if ((ret = snapshot_take(source, &snap)) == LAGOPUS_RESULT_OK &&
+        snapshot_ttl > 0) {
+      /* held by the cache as well. */
+      snap->refcnt++;
+      snapshots[source] = snap;
+    }
+  } else {
+    snap->refcnt++;
+    ret = LAGOPUS_RESULT_OK;
+  }
+  (void)pthread_mutex_unlock(&snapshot_lock);
+
+  if (ret == LAGOPUS_RESULT_OK) {
+    *snapshot = snap;
+  }
+  return ret;
+}
+
+void
+dataplane_interface_snapshot_release(
+  struct dataplane_interface_snapshot *snapshot) {
+  (void)pthread_mutex_lock(&snapshot_lock);
+  snapshot_unref(snapshot);
+  (void)pthread_mutex_unlock(&snapshot_lock);
+}
+
+lagopus_result_t
+dataplane_interface_snapshot_ttl_set(lagopus_chrono_t ttl) {
+  size_t i;
+
+  if (ttl < 0) {
+    return LAGOPUS_RESULT_INVALID_ARGS;
+  }
+  (void)pthread_mutex_lock(&snapshot_lock);
+  snapshot_ttl = ttl;
+  for (i = 0; i < DATAPLANE_INTERFACE_SOURCE_MAX; i++) {
+    snapshot_unref(snapshots[i]);
+    snapshots[i] = NULL;
+  }
+  (void)pthread_mutex_unlock(&snapshot_lock);
+  return LAGOPUS_RESULT_OK;
+}
+
+lagopus_chrono_t
+dataplane_interface_snapshot_ttl_get(void) {
+  lagopus_chrono_t ttl;
+
+  (void)pthread_mutex_lock(&snapshot_lock);
+  ttl = snapshot_ttl;
+  (void)pthread_mutex_unlock(&snapshot_lock);
+  return ttl;
+}
@@ -19,6 +19,113 @@
 
 #include "lagopus_apis.h"
 #include "dataplane_apis.h"
+#include "ifTable_type.h"
+
+/*
+ * Lifetime of the interface snapshot, 1 sec by default.
+ * The subagent has no runtime option for it, build with
+ * -DDATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC=<nsec> to change it,
+ * 0 to fetch the counters at every walk.
+ */
+#ifndef DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC
+#define DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC 1000000000LL
+#endif /* DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC */
+
+/* Columns successfully fetched into the snapshot. */
+enum dataplane_interface_column {
+  IFCOL_ifDescr = 1 << 0,
+  IFCOL_ifType = 1 << 1,
+  IFCOL_ifMtu = 1 << 2,
+  IFCOL_ifSpeed = 1 << 3,
+  IFCOL_ifPhysAddress = 1 << 4,
+  IFCOL_ifAdminStatus = 1 << 5,
+  IFCOL_ifOperStatus = 1 << 6,
+  IFCOL_ifLastChange = 1 << 7,
+  IFCOL_ifInOctets = 1 << 8,
+  IFCOL_ifInUcastPkts = 1 << 9,
+  IFCOL_ifInDiscards = 1 << 10,
+  IFCOL_ifInErrors = 1 << 11,
+  IFCOL_ifOutOctets = 1 << 12,
+  IFCOL_ifOutUcastPkts = 1 << 13,
+  IFCOL_ifOutDiscards = 1 << 14,
+  IFCOL_ifOutErrors = 1 << 15,
+  IFCOL_dot1dBasePortIfIndex = 1 << 16,
+  IFCOL_dot1dBasePortDelayExceededDiscards = 1 << 17,
+  IFCOL_dot1dBasePortMtuExceededDiscards = 1 << 18,
+};
+
+/* Ports the snapshot is taken from. */
+enum dataplane_interface_source {
+  DATAPLANE_INTERFACE_PORTS = 0,        /* dp_get_port_stat() */
+  DATAPLANE_INTERFACE_BRIDGE_PORTS,     /* ports of the bridge */
+  DATAPLANE_INTERFACE_SOURCE_MAX,
+};
+
+/**
+ * Row of the interface snapshot.
+ */
+struct dataplane_interface_row {
+  uint32_t valid;               /** IFCOL_* of the fetched columns. */
+  struct ifTable_entry entry;   /** Column values. */
+};
+
+/**
+ * Attributes and counters of all interfaces taken at once.
+ */
+struct dataplane_interface_snapshot {
+  uint32_t refcnt;              /** Holders, including the cache. */
+  lagopus_chrono_t taken;       /** Time the snapshot was taken. */
+  size_t num;                   /** Number of rows. */
+  struct dataplane_interface_row rows[];
+};
+
+/**
+ * Get and hold the snapshot of all interfaces.
+ *
+ * The port statistics are fetched from the dataplane only when the
+ * cached snapshot is older than the TTL, so a walk of the tables
+ * costs one round-trip to the dataplane.
+ *
+ *	@param[in]	source	The ports to take.
+ *	@param[out]	snapshot	The snapshot.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Succeeded.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS		If some arguments are invalid.
+ *	@retval LAGOPUS_RESULT_NO_MEMORY		Failed, no memory.
+ *	@retval	LAGOPUS_RESULT_ANY_FAILURES		Failed.
+ *
+ *	@details Call dataplane_interface_snapshot_release() when done.
+ */
+lagopus_result_t dataplane_interface_snapshot_get(
+  enum dataplane_interface_source source,
+  struct dataplane_interface_snapshot **snapshot);
+
+/**
+ * Release the snapshot held by dataplane_interface_snapshot_get().
+ *
+ *	@param[in]	snapshot	The snapshot.
+ */
+void dataplane_interface_snapshot_release(
+  struct dataplane_interface_snapshot *snapshot);
+
+/**
+ * Set the lifetime of the snapshots, 0 to fetch at every walk.
+ * The cached snapshots are dropped.
+ * Not called by the subagent itself, which keeps
+ * DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC; for tests and embedders.
+ *
+ *	@param[in]	ttl	The lifetime in nsec.
+ *
+ *	@retval	LAGOPUS_RESULT_OK		Succeeded.
+ *	@retval LAGOPUS_RESULT_INVALID_ARGS		If ttl is negative.
+ */
+lagopus_result_t dataplane_interface_snapshot_ttl_set(
+  lagopus_chrono_t ttl);
+
+/**
+ * Get the lifetime of the snapshots in nsec.
+ */
+lagopus_chrono_t dataplane_interface_snapshot_ttl_get(void);
 
 void dataplane_count_ifNumber(struct port_stat *port_stat,
                               size_t *interface_number);
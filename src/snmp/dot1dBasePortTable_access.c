@@ -60,27 +60,21 @@ dot1dBasePortTable_get_first_data_point(void **my_loop_context,
                                         netsnmp_iterator_info *mydata) {
   lagopus_result_t ret = LAGOPUS_RESULT_ANY_FAILURES;
   struct port_table_loop_context *lctx;
-  struct bridge_stat *bridge_stat;
   if (my_loop_context != NULL && my_data_context != NULL &&
       put_index_data != NULL) {
     if ((lctx = (struct port_table_loop_context *) malloc (sizeof(
                   *lctx))) != NULL) {
-      if ((ret = dp_get_bridge_stat(&bridge_stat)) == LAGOPUS_RESULT_OK) {
-        if ((ret = bridge_stat_get_port_stat(bridge_stat, 0,
-                                             &lctx->port_stat)) == LAGOPUS_RESULT_OK) {
-          lctx->refcnt = 1;
-          lctx->ifIndex = 0;
-          lctx->index = 0;
-          *my_loop_context = lctx;
-          bridge_stat_release(bridge_stat);
-          free(bridge_stat);
-          return dot1dBasePortTable_get_next_data_point(my_loop_context, my_data_context,
-                 put_index_data, mydata);
-        }
-        bridge_stat_release(bridge_stat);
-        free(bridge_stat);
+      if ((ret = dataplane_interface_snapshot_get(
+                   DATAPLANE_INTERFACE_BRIDGE_PORTS, &lctx->snapshot))
+          == LAGOPUS_RESULT_OK) {
+        lctx->refcnt = 1;
+        lctx->ifIndex = 0;
+        lctx->index = 0;
+        *my_loop_context = lctx;
+        return dot1dBasePortTable_get_next_data_point(my_loop_context, my_data_context,
+               put_index_data, mydata);
       } else {
-        lagopus_msg_error("failed to get port_stat: %s\n",
+        lagopus_msg_error("failed to get interfaces: %s\n",
                           lagopus_error_get_string(ret));
       }
       free(lctx);
@@ -175,16 +169,10 @@ get_dot1dBasePortIfIndex(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
-    size_t index;
     *ret_len = 0;
-    if (dataplane_bridge_stat_get_port_ifIndex(
-          lctx->port_stat,
-          dctx->index,
-          &index) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_dot1dBasePortIfIndex) != 0) {
       *ret_len = sizeof(entry->dot1dBasePortIfIndex);
-      entry->dot1dBasePortIfIndex = (int32_t)(index + 1);
       return &entry->dot1dBasePortIfIndex;
     }
   }
@@ -211,13 +199,9 @@ get_dot1dBasePortDelayExceededDiscards(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_DelayExceededDiscards(
-          lctx->port_stat,
-          lctx->index,
-          &entry->dot1dBasePortDelayExceededDiscards) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_dot1dBasePortDelayExceededDiscards) != 0) {
       *ret_len = sizeof(entry->dot1dBasePortDelayExceededDiscards);
       return &entry->dot1dBasePortDelayExceededDiscards;
     }
@@ -231,13 +215,9 @@ get_dot1dBasePortMtuExceededDiscards(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_MtuExceededDiscards(
-          lctx->port_stat,
-          lctx->index,
-          &entry->dot1dBasePortMtuExceededDiscards) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_dot1dBasePortMtuExceededDiscards) != 0) {
       *ret_len = sizeof(entry->dot1dBasePortMtuExceededDiscards);
       return &entry->dot1dBasePortMtuExceededDiscards;
     }
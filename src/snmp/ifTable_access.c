@@ -44,7 +44,9 @@ ifTable_get_first_data_point(void **my_loop_context, void **my_data_context,
       put_index_data != NULL) {
     if ((lctx = (struct port_table_loop_context *) malloc (sizeof(
                   *lctx))) != NULL) {
-      if ((ret = dp_get_port_stat(&lctx->port_stat)) == LAGOPUS_RESULT_OK) {
+      if ((ret = dataplane_interface_snapshot_get(
+                   DATAPLANE_INTERFACE_PORTS, &lctx->snapshot))
+          == LAGOPUS_RESULT_OK) {
         lctx->refcnt = 1;
         lctx->ifIndex = 0;
         lctx->index = 0;
@@ -52,7 +54,7 @@ ifTable_get_first_data_point(void **my_loop_context, void **my_data_context,
         return ifTable_get_next_data_point(my_loop_context, my_data_context,
                                            put_index_data, mydata);
       } else {
-        lagopus_msg_error("failed to get port_stat: %s\n",
+        lagopus_msg_error("failed to get interfaces: %s\n",
                           lagopus_error_get_string(ret));
       }
       free(lctx);
@@ -91,11 +93,13 @@ ifTable_get_next_data_point(void **my_loop_context,
 
   lagopus_msg_debug(25, "ifIndex is %d\n", lctx->ifIndex);
 
-  if (dataplane_interface_exist(lctx->port_stat, lctx->index) == true) {
+  if (lctx->index < lctx->snapshot->num) {
     netsnmp_variable_list *vptr;
     struct port_table_data_context *dctx = NULL;
     if ((dctx = (struct port_table_data_context *)
                 malloc (sizeof(*dctx))) != NULL) {
+      dctx->entry = lctx->snapshot->rows[lctx->index].entry;
+      dctx->valid = lctx->snapshot->rows[lctx->index].valid;
       dctx->lctx = lctx;
       lctx->refcnt++;
       dctx->index = lctx->index;
@@ -124,8 +128,7 @@ ifTable_data_free(void *data_context,
     struct port_table_loop_context *lctx = dctx->lctx;
     lctx->refcnt--;
     if (lctx->refcnt == 0) {
-      port_stat_release(lctx->port_stat);
-      free(lctx->port_stat);
+      dataplane_interface_snapshot_release(lctx->snapshot);
       free(lctx);
     }
 
@@ -144,8 +147,7 @@ ifTable_loop_free(void *loop_context,
     lctx = (struct port_table_loop_context *) loop_context;
     lctx->refcnt--;
     if (lctx->refcnt == 0) {
-      port_stat_release(lctx->port_stat);
-      free(lctx->port_stat);
+      dataplane_interface_snapshot_release(lctx->snapshot);
       free(lctx);
     }
   }
@@ -172,15 +174,10 @@ get_ifDescr(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
-    size_t len = IFNAMSIZ + 1;
     *ret_len = 0;
-    if (dataplane_interface_get_ifDescr(
-          lctx->port_stat,
-          dctx->index,
-          entry->ifDescr, &len) == LAGOPUS_RESULT_OK) {
-      *ret_len = len;
+    if ((dctx->valid & IFCOL_ifDescr) != 0) {
+      *ret_len = entry->ifDescr_len;
       return entry->ifDescr;
     }
   }
@@ -193,13 +190,9 @@ get_ifType(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifType(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifType) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifType) != 0) {
       *ret_len = sizeof(entry->ifType);
       return &entry->ifType;
     }
@@ -213,13 +206,9 @@ get_ifMtu(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifMtu(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifMtu) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifMtu) != 0) {
       *ret_len = sizeof(entry->ifMtu);
       return &entry->ifMtu;
     }
@@ -235,14 +224,9 @@ get_ifSpeed(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    /* TODO implement this */
-    if (dataplane_interface_get_ifSpeed(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifSpeed) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifSpeed) != 0) {
       *ret_len = sizeof(entry->ifSpeed);
       return &entry->ifSpeed;
     }
@@ -256,16 +240,10 @@ get_ifPhysAddress(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
-    size_t len;
     *ret_len = 0;
-    if (dataplane_interface_get_ifPhysAddress(
-          lctx->port_stat,
-          dctx->index,
-          entry->ifPhysAddress,
-          &len) == LAGOPUS_RESULT_OK) {
-      *ret_len = len;
+    if ((dctx->valid & IFCOL_ifPhysAddress) != 0) {
+      *ret_len = entry->ifPhysAddress_len;
       return entry->ifPhysAddress;
     }
   }
@@ -278,13 +256,9 @@ get_ifAdminStatus(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifAdminStatus(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifAdminStatus) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifAdminStatus) != 0) {
       *ret_len = sizeof(entry->ifAdminStatus);
       return &entry->ifAdminStatus;
     }
@@ -298,13 +272,9 @@ get_ifOperStatus(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifOperStatus(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifOperStatus) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifOperStatus) != 0) {
       *ret_len = sizeof(entry->ifOperStatus);
       return &entry->ifOperStatus;
     }
@@ -318,13 +288,9 @@ get_ifLastChange(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifLastChange(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifLastChange) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifLastChange) != 0) {
       *ret_len = sizeof(entry->ifLastChange);
       return &entry->ifLastChange;
     }
@@ -338,13 +304,9 @@ get_ifInOctets(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifInOctets(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifInOctets) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifInOctets) != 0) {
       *ret_len = sizeof(entry->ifInOctets);
       return &entry->ifInOctets;
     }
@@ -358,13 +320,9 @@ get_ifInUcastPkts(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifInUcastPkts(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifInUcastPkts) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifInUcastPkts) != 0) {
       *ret_len = sizeof(entry->ifInUcastPkts);
       return &entry->ifInUcastPkts;
     }
@@ -389,13 +347,9 @@ get_ifInDiscards(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifInDiscards(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifInDiscards) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifInDiscards) != 0) {
       *ret_len = sizeof(entry->ifInDiscards);
       return &entry->ifInDiscards;
     }
@@ -409,13 +363,9 @@ get_ifInErrors(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifInErrors(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifInErrors) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifInErrors) != 0) {
       *ret_len = sizeof(entry->ifInErrors);
       return &entry->ifInErrors;
     }
@@ -438,13 +388,9 @@ get_ifOutOctets(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifOutOctets(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifOutOctets) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifOutOctets) != 0) {
       *ret_len = sizeof(entry->ifOutOctets);
       return &entry->ifOutOctets;
     }
@@ -458,13 +404,9 @@ get_ifOutUcastPkts(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifOutUcastPkts(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifOutUcastPkts) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifOutUcastPkts) != 0) {
       *ret_len = sizeof(entry->ifOutUcastPkts);
       return &entry->ifOutUcastPkts;
     }
@@ -489,13 +431,9 @@ get_ifOutDiscards(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifOutDiscards(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifOutDiscards) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifOutDiscards) != 0) {
       *ret_len = sizeof(entry->ifOutDiscards);
       return &entry->ifOutDiscards;
     }
@@ -509,13 +447,9 @@ get_ifOutErrors(void *data_context, size_t *ret_len) {
   if (data_context != NULL && ret_len != NULL) {
     struct port_table_data_context *dctx = (struct port_table_data_context *)
                                            data_context;
-    struct port_table_loop_context *lctx = dctx->lctx;
     struct ifTable_entry *entry = &dctx->entry;
     *ret_len = 0;
-    if (dataplane_interface_get_ifOutErrors(
-          lctx->port_stat,
-          dctx->index,
-          &entry->ifOutErrors) == LAGOPUS_RESULT_OK) {
+    if ((dctx->valid & IFCOL_ifOutErrors) != 0) {
       *ret_len = sizeof(entry->ifOutErrors);
       return &entry->ifOutErrors;
     }
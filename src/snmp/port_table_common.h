@@ -18,16 +18,18 @@
 #define PORT_TABLE_COMMON_H
 
 #include "ifTable_type.h"
+#include "dataplane_interface.h"
 
 struct port_table_loop_context {
   uint32_t refcnt;
   size_t index;
   int32_t ifIndex;              /* 1 origin */
-  struct port_stat *port_stat;  /* port statistics */
+  struct dataplane_interface_snapshot *snapshot;  /* ports of the walk */
 };
 
 struct port_table_data_context {
-  struct ifTable_entry entry;   /* for temporary data storage */
+  struct ifTable_entry entry;   /* row copied from the snapshot */
+  uint32_t valid;               /* IFCOL_* of the row */
   size_t index;
   int32_t ifIndex;              /* 1 origin */
   struct port_table_loop_context *lctx;  /* port statistics */
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2014-2016 Nippon Telegraph and Telephone Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "unity.h"
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+#include "ifTable_access.h"
+#include "ifTable_enums.h"
+#include "dataplane_interface.h"
+
+#include "lagopus_apis.h"
+
+#include "stub_values.h"
+
+void
+setUp(void) {
+}
+
+void
+tearDown(void) {
+  (void)dataplane_interface_snapshot_ttl_set(
+    DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC);
+}
+
+void
+test_IfTable_snapshot(void) {
+  struct dataplane_interface_snapshot *snap1 = NULL;
+  struct dataplane_interface_snapshot *snap2 = NULL;
+  struct ifTable_entry *entry;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    dataplane_interface_snapshot_get(
+                      DATAPLANE_INTERFACE_PORTS, &snap1));
+  TEST_ASSERT_EQUAL_UINT64(2, snap1->num);
+
+  entry = &snap1->rows[0].entry;
+  TEST_ASSERT_EQUAL_INT(VALUE_ifIndex_1, entry->ifIndex);
+  TEST_ASSERT_EQUAL_UINT64(VALUE_ifDescr_len_1, entry->ifDescr_len);
+  TEST_ASSERT_EQUAL_MEMORY(VALUE_ifDescr_1, entry->ifDescr,
+                           VALUE_ifDescr_len_1);
+  TEST_ASSERT_EQUAL_INT(VALUE_ifMtu_1, entry->ifMtu);
+  TEST_ASSERT_EQUAL_UINT32(VALUE_ifInOctets_1, entry->ifInOctets);
+  TEST_ASSERT_EQUAL_UINT32(VALUE_ifOutErrors_1, entry->ifOutErrors);
+  TEST_ASSERT_TRUE((snap1->rows[0].valid & IFCOL_ifMtu) != 0);
+
+  entry = &snap1->rows[1].entry;
+  TEST_ASSERT_EQUAL_INT(VALUE_ifIndex_2, entry->ifIndex);
+  TEST_ASSERT_EQUAL_INT(VALUE_ifMtu_2, entry->ifMtu);
+  TEST_ASSERT_EQUAL_UINT32(VALUE_ifSpeed_2, entry->ifSpeed);
+  TEST_ASSERT_EQUAL_UINT32(VALUE_ifInDiscards_2, entry->ifInDiscards);
+
+  /* cached until the TTL expires. */
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    dataplane_interface_snapshot_get(
+                      DATAPLANE_INTERFACE_PORTS, &snap2));
+  TEST_ASSERT_EQUAL_PTR(snap1, snap2);
+  dataplane_interface_snapshot_release(snap2);
+
+  /* another source has its own snapshot. */
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    dataplane_interface_snapshot_get(
+                      DATAPLANE_INTERFACE_BRIDGE_PORTS, &snap2));
+  TEST_ASSERT_TRUE(snap1 != snap2);
+  TEST_ASSERT_EQUAL_UINT64(2, snap2->num);
+  dataplane_interface_snapshot_release(snap2);
+
+  /* holders keep the snapshot dropped from the cache. */
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    dataplane_interface_snapshot_ttl_set(0));
+  TEST_ASSERT_EQUAL(0, dataplane_interface_snapshot_ttl_get());
+  TEST_ASSERT_EQUAL_INT(VALUE_ifMtu_2, snap1->rows[1].entry.ifMtu);
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_OK,
+                    dataplane_interface_snapshot_get(
+                      DATAPLANE_INTERFACE_PORTS, &snap2));
+  TEST_ASSERT_TRUE(snap1 != snap2);
+  dataplane_interface_snapshot_release(snap2);
+  dataplane_interface_snapshot_release(snap1);
+}
+
+void
+test_IfTable_snapshot_invalid_args(void) {
+  struct dataplane_interface_snapshot *snap = NULL;
+
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS,
+                    dataplane_interface_snapshot_get(
+                      DATAPLANE_INTERFACE_PORTS, NULL));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS,
+                    dataplane_interface_snapshot_get(
+                      DATAPLANE_INTERFACE_SOURCE_MAX, &snap));
+  TEST_ASSERT_EQUAL(LAGOPUS_RESULT_INVALID_ARGS,
+                    dataplane_interface_snapshot_ttl_set(-1));
+  TEST_ASSERT_EQUAL(DATAPLANE_INTERFACE_SNAPSHOT_TTL_NSEC,
+                    dataplane_interface_snapshot_ttl_get());
+}
@@ -18,6 +18,7 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <sys/time.h>
 #include <sys/queue.h>
 
@@ -38,6 +39,8 @@
 
 static struct bridge *bridge;
 static struct flowcache *flowcache;
+static uint16_t flow_priority = 1;
+static uint16_t flow_idle_timeout = 0;
 bool loop;
 
 enum {
@@ -194,12 +197,12 @@ flow_add(struct match_list *match_list) {
   TAILQ_INIT(&instruction_list);
 
   flow_mod.table_id = 0;
-  flow_mod.priority = 1;
+  flow_mod.priority = flow_priority;
   flow_mod.flags = 0;
   flow_mod.cookie = 0;
   flow_mod.out_port = OFPP_ANY;
   flow_mod.out_group = OFPG_ANY;
-  flow_mod.idle_timeout = 0;
+  flow_mod.idle_timeout = flow_idle_timeout;
   flow_mod.hard_timeout = 0;
 
   rv = flowdb_flow_add(bridge, &flow_mod, match_list, &instruction_list,
@@ -779,3 +782,128 @@ test_mixed_entries_1M_flow_benchmark(void) {
     flow_all_delete();
   }
 }
+
+/*
+ * Routing-style table, prefixes of all lengths and priority is
+ * the prefix length.
+ */
+void
+IPV4_DST_100K_prefixes_flow_benchmark(size_t n) {
+  struct lagopus_packet *pkt[n];
+  uint32_t ip, mask;
+  size_t i;
+  int prefix;
+
+  srandom(1);
+  for (i = 0; i < 100 * 1000; i++) {
+    prefix = (int)(i % 32) + 1;
+    mask = ~((uint32_t)((1ULL << (32 - prefix)) - 1));
+    ip = (uint32_t)random() & mask;
+    flow_priority = (uint16_t)prefix;
+    if (prefix == 32) {
+      any_flow_add(3,
+                   4, OFPXMT_OFB_IN_PORT << 1, 1,
+                   2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+                   4, OFPXMT_OFB_IPV4_DST << 1, ip);
+    } else {
+      any_flow_add(3,
+                   4, OFPXMT_OFB_IN_PORT << 1, 1,
+                   2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+                   8, (OFPXMT_OFB_IPV4_DST << 1) + 1, ip, mask);
+    }
+  }
+  flow_priority = 1;
+  for (i = 0; i < n; i++) {
+    pkt[i] = build_ip_packet(1, IPADDR(192,168,1,2), (uint32_t)random(), 0);
+  }
+  flow_benchmark(TYPE_FLOWINFO, pkt, n, 3);
+  for (i = 0; i < n; i++) {
+    destroy_packet(pkt[i]);
+  }
+  flow_all_delete();
+}
+
+void
+test_IPV4_DST_100K_prefixes_1_flow_benchmark(void) {
+  printf("***** 100K prefix, 1 flow, IPv4dst match ***************\n");
+  IPV4_DST_100K_prefixes_flow_benchmark(1);
+}
+
+void
+test_IPV4_DST_100K_prefixes_256_flow_benchmark(void) {
+  printf("***** 100K prefix, 256 flow, IPv4dst match *************\n");
+  IPV4_DST_100K_prefixes_flow_benchmark(256);
+}
+
+#define BURST_SIZE 32
+
+/*
+ * Per-packet cycles of the cached flow path, the clock is refreshed
+ * once per burst.
+ */
+void
+flow_timeout_benchmark(uint16_t idle_timeout) {
+  struct lagopus_packet *pkt[BURST_SIZE];
+  uint64_t start, cycles;
+  const size_t nbursts = 100 * 1000;
+  size_t b, i;
+
+  flow_idle_timeout = idle_timeout;
+  in_port_flow_add(1, 1);
+  flow_idle_timeout = 0;
+  cycles = 0;
+  for (b = 0; b < nbursts; b++) {
+    for (i = 0; i < BURST_SIZE; i++) {
+      pkt[i] = build_packet(1, 64);
+      cache_enable(pkt[i]);
+    }
+    start = dp_clock_cycles();
+    dp_clock_update();
+    for (i = 0; i < BURST_SIZE; i++) {
+      (void)lagopus_match_and_action(pkt[i]);
+    }
+    cycles += dp_clock_cycles() - start;
+  }
+  printf("*** idle_timeout %u: %3.2f cycles/packet\n", idle_timeout,
+         (double)cycles / (double)(nbursts * BURST_SIZE));
+  flow_all_delete();
+}
+
+void
+test_flow_timeout_cycles_benchmark(void) {
+  printf("***** 1 entry, port match, cycles with/without timeout ****\n");
+  flow_timeout_benchmark(0);
+  flow_timeout_benchmark(60);
+}
+
+#define INSTALL_NFLOWS 200000
+
+/*
+ * Flow-mod install rate, the later half of the flows should be
+ * installed at about the same rate as the first half.
+ */
+void
+test_flow_install_benchmark(void) {
+  struct timespec t0, t1;
+  double elapsed;
+  uint32_t i;
+  int half;
+
+  printf("***** 200K entry, install rate, IPv4dst/proto match *******\n");
+  for (half = 0; half < 2; half++) {
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = (uint32_t)half * INSTALL_NFLOWS / 2;
+         i < (uint32_t)(half + 1) * INSTALL_NFLOWS / 2; i++) {
+      any_flow_add(3,
+                   2, OFPXMT_OFB_ETH_TYPE << 1, ETHERTYPE_IP,
+                   4, OFPXMT_OFB_IPV4_DST << 1, 0x0a000000 + i / 200,
+                   1, OFPXMT_OFB_IP_PROTO << 1, i % 200);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    elapsed = (double)(t1.tv_sec - t0.tv_sec) +
+              (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("*** half %d: %3.2fK flows/sec\n", half,
+           (double)(INSTALL_NFLOWS / 2) / elapsed / 1000.0);
+  }
+  flow_all_delete();
+}